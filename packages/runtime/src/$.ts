@@ -1,4 +1,5 @@
 import type { PromiseState } from '@nx.js/inspect';
+import type { AudioRenderStats } from './audio/base-audio-context';
 import type { CanvasRenderingContext2D } from './canvas/canvas-rendering-context-2d';
 import type { ImageBitmap } from './canvas/image-bitmap';
 import type { WebGL2RenderingContext } from './canvas/webgl2-rendering-context';
@@ -21,12 +22,13 @@ import type { Gamepad, GamepadButton } from './navigator/gamepad';
 import type { VirtualKeyboard } from './navigator/virtual-keyboard';
 import type { Touch } from './polyfills/event';
 import type { URL, URLSearchParams } from './polyfills/url';
-import type { Screen } from './screen';
+import type { Screen, ScreenPresentStats } from './screen';
 import type {
 	Album,
 	AlbumFile,
 	Application,
 	FileSystem,
+	FrameEncoder,
 	IRSensor,
 	MemoryUsage,
 	NetworkInfo,
@@ -51,6 +53,8 @@ type ClassOf<T> = {
 
 export type AudioContextHandle = Opaque<'AudioContextHandle'>;
 export type AudioNodeHandle = Opaque<'AudioNodeHandle'>;
+export type PeriodicWaveHandle = Opaque<'PeriodicWaveHandle'>;
+export type AudioStreamHandle = Opaque<'AudioStreamHandle'>;
 
 export interface BtleScanResult {
 	address: string;
@@ -98,6 +102,28 @@ export type BtleEvent =
 			data: ArrayBuffer;
 	  };
 
+export type AnimatedImageHandle = Opaque<'AnimatedImageHandle'>;
+
+export interface AnimatedImageMetadata {
+	width: number;
+	height: number;
+	frameCount: number;
+	/** Total plays; `0` = forever. */
+	loopCount: number;
+	/** Per-frame display durations (ms), after the <=10ms -> 100ms clamp. */
+	durations: number[];
+}
+
+export interface AnimatedImageState {
+	frameIndex: number;
+	presentedFrames: number;
+	/** Frames skipped because a newer frame was already due. */
+	droppedFrames: number;
+	/** Decoded frames waiting in the ring. */
+	bufferedFrames: number;
+	ended: boolean;
+}
+
 export type VideoHandle = Opaque<'VideoHandle'>;
 
 export interface VideoMetadata {
@@ -126,6 +152,11 @@ type CanvasGradientOpaque = Opaque<'CanvasGradientOpaque'>;
 type CompressHandle = Opaque<'CompressHandle'>;
 type DecompressHandle = Opaque<'DecompressHandle'>;
 type DecompressFileHandle = Opaque<'DecompressFileHandle'>;
+export type ZstdDictHandle = Opaque<'ZstdDictHandle'>;
+type ZstdSeekableWriterHandle = Opaque<'ZstdSeekableWriterHandle'>;
+export type ZstdSeekableHandle = Opaque<'ZstdSeekableHandle'>;
+export type ArchiveHandle = Opaque<'ArchiveHandle'>;
+export type CipherHandle = Opaque<'CipherHandle'>;
 type SaveDataIterator = Opaque<'SaveDataIterator'>;
 type URLSearchParamsIterator = Opaque<'URLSearchParamsIterator'>;
 export type USBNativeDevice = Opaque<'USBNativeDevice'>;
@@ -189,6 +220,16 @@ export interface NxConfig {
 	heapLimit: number;
 	/** Requested renderer mode. */
 	renderer: 'auto' | 'cpu' | 'gpu';
+	/**
+	 * Threads used to rasterize the screen canvas in deferred mode (`[renderer]
+	 * raster_threads`); 0 means draws rasterize immediately on the JS thread.
+	 */
+	rasterThreads: number;
+	/**
+	 * Frame threads per video decoder (`[video] decode_threads`); 0 means the
+	 * default (2).
+	 */
+	videoDecodeThreads: number;
 	/** App-provided V8 flag string applied after the runtime defaults (empty if none). */
 	v8Flags: string;
 	/** Effective libnx socket configuration. */
@@ -222,6 +263,27 @@ export interface Init {
 	appletGetOperationMode(): number;
 	appletSetMediaPlaybackState(state: boolean): void;
 
+	// archive.cc — ZIP / tar reader (Switch.Archive)
+	archiveOpen(path: string): Promise<[ArchiveHandle, 'zip' | 'tar']>;
+	archiveNames(handle: ArchiveHandle): string[];
+	/** `[size, compressedSize, lastModified]`, or `null` if not found. */
+	archiveEntry(
+		handle: ArchiveHandle,
+		name: string,
+	): [number, number, number] | null;
+	archiveRead(handle: ArchiveHandle, name: string): Promise<ArrayBuffer | null>;
+	archiveReadSync(handle: ArchiveHandle, name: string): ArrayBuffer | null;
+	/**
+	 * Where the entry's data lies in the archive file: `[start, end, format]`,
+	 * where `format` is the `DecompressionStream` format (`''` when stored).
+	 */
+	archiveLocate(
+		handle: ArchiveHandle,
+		name: string,
+	): Promise<[number, number, string] | null>;
+	archiveMount(handle: ArchiveHandle, name: string): void;
+	archiveUnmount(handle: ArchiveHandle): void;
+
 	// battery.c
 	batteryInit(): void;
 	batteryInitClass(c: ClassOf<BatteryManager>): void;
@@ -233,8 +295,23 @@ export interface Init {
 		canvas: Screen | OffscreenCanvas,
 		type?: string,
 		quality?: number,
+		compressionLevel?: number,
+		effort?: number,
 	): Promise<ArrayBuffer>;
 	canvasInitClass(c: ClassOf<Screen | OffscreenCanvas>): void;
+	canvasPresentStats(c: Screen): ScreenPresentStats;
+	canvasSetRasterThreads(c: Screen | OffscreenCanvas, threads: number): void;
+	frameEncoderNew(
+		type?: string,
+		quality?: number,
+		compressionLevel?: number,
+		effort?: number,
+		frames?: number,
+	): FrameEncoder;
+	frameEncoderEncode(
+		e: FrameEncoder,
+		c: Screen | OffscreenCanvas,
+	): Promise<ArrayBuffer> | null;
 	canvasContext2dNew(c: Screen): CanvasRenderingContext2D;
 	canvasContext2dNew(c: OffscreenCanvas): OffscreenCanvasRenderingContext2D;
 	canvasContext2dInitClass(
@@ -313,13 +390,29 @@ export interface Init {
 	): void;
 
 	// compression.c
-	compressNew(format: string): CompressHandle;
+	/**
+	 * Options are positional, `undefined` meaning the format's default.
+	 * Strategies are numeric (zlib's `Z_*` / zstd's `ZSTD_strategy`).
+	 */
+	compressNew(
+		format: string,
+		level?: number,
+		windowLog?: number,
+		strategy?: number,
+		longDistanceMatching?: boolean,
+		workers?: number,
+		dictionary?: ZstdDictHandle,
+	): CompressHandle;
 	compressWrite(
 		handle: CompressHandle,
 		buf: BufferSource,
 	): Promise<ArrayBuffer>;
 	compressFlush(handle: CompressHandle): Promise<ArrayBuffer | null>;
-	decompressNew(format: string): DecompressHandle;
+	decompressNew(
+		format: string,
+		windowLog?: number,
+		dictionary?: ZstdDictHandle,
+	): DecompressHandle;
 	decompressWrite(
 		handle: DecompressHandle,
 		buf: BufferSource,
@@ -339,11 +432,77 @@ export interface Init {
 		/** Per-pull output capacity in bytes (clamped 256 KiB..8 MiB). Larger
 		 * means fewer thread-pool dispatches per MB of output. */
 		outCap?: number,
+		windowLog?: number,
+		dictionary?: ZstdDictHandle,
 	): DecompressFileHandle;
 	/** Pull the next decompressed chunk, or `null` at end of stream. */
 	decompressFilePull(
 		handle: DecompressFileHandle,
 	): Promise<ArrayBuffer | null>;
+	/** Decompress the next chunk into `view`: the bytes written, or `null`
+	 * at end of stream. */
+	decompressFilePull(
+		handle: DecompressFileHandle,
+		view: ArrayBufferView,
+	): Promise<number | null>;
+	/** Returns the dictionary's handle and its ID (`0` for raw content). */
+	zstdDictNew(data: BufferSource): [ZstdDictHandle, number];
+	compress(
+		data: BufferSource,
+		format: string,
+		level?: number,
+		windowLog?: number,
+		strategy?: number,
+		longDistanceMatching?: boolean,
+		workers?: number,
+		dictionary?: ZstdDictHandle,
+	): Promise<ArrayBuffer>;
+	compressSync(
+		data: BufferSource,
+		format: string,
+		level?: number,
+		windowLog?: number,
+		strategy?: number,
+		longDistanceMatching?: boolean,
+		workers?: number,
+		dictionary?: ZstdDictHandle,
+	): ArrayBuffer;
+	decompress(
+		data: BufferSource,
+		format: string,
+		windowLog?: number,
+		dictionary?: ZstdDictHandle,
+		maxOutputSize?: number,
+	): Promise<ArrayBuffer>;
+	decompressSync(
+		data: BufferSource,
+		format: string,
+		windowLog?: number,
+		dictionary?: ZstdDictHandle,
+		maxOutputSize?: number,
+	): ArrayBuffer;
+	/** Seekable zstd: independent frames of `frameSize` bytes + a seek table. */
+	zstdSeekableWriterNew(
+		level?: number,
+		frameSize?: number,
+	): ZstdSeekableWriterHandle;
+	/** Resolves to the frames completed by `data`. */
+	zstdSeekableWriterWrite(
+		handle: ZstdSeekableWriterHandle,
+		data: BufferSource,
+	): Promise<ArrayBuffer>;
+	/** Resolves to the last frame and the seek table. */
+	zstdSeekableWriterEnd(handle: ZstdSeekableWriterHandle): Promise<ArrayBuffer>;
+	/** Resolves to the handle, the decompressed size and the frame count. */
+	zstdSeekableOpen(
+		path: string,
+		cacheSize: number,
+	): Promise<[ZstdSeekableHandle, number, number]>;
+	zstdSeekableRead(
+		handle: ZstdSeekableHandle,
+		offset: number,
+		length: number,
+	): Promise<ArrayBuffer>;
 
 	// crypto.c
 	cryptoKeyNew(
@@ -375,6 +534,12 @@ export interface Init {
 		signature: BufferSource,
 		data: BufferSource,
 	): Promise<boolean>;
+	cryptoVerifyBatch(
+		algorithm: Algorithm,
+		key: CryptoKey<any> | CryptoKey<any>[],
+		signatures: BufferSource[],
+		data: BufferSource[],
+	): Promise<boolean[]>;
 	cryptoExportKey(format: string, key: CryptoKey<any>): ArrayBuffer;
 	cryptoGenerateKeyEc(namedCurve: string): [ArrayBuffer, ArrayBuffer];
 	cryptoKeyNewEcPrivate(
@@ -390,6 +555,10 @@ export interface Init {
 		length: number,
 	): Promise<ArrayBuffer>;
 	cryptoDigest(algorithm: string, buf: BufferSource): Promise<ArrayBuffer>;
+	cryptoDigestBatch(
+		algorithm: string,
+		bufs: BufferSource[],
+	): Promise<ArrayBuffer[]>;
 	cryptoGenerateKeyRsa(
 		modulusLength: number,
 		publicExponent: number,
@@ -418,6 +587,22 @@ export interface Init {
 		usages: string[],
 	): CryptoKey<any>;
 	cryptoEcExportPublicRaw(key: CryptoKey<any>): ArrayBuffer;
+	cryptoCipherNew(
+		encrypt: boolean,
+		algorithm: Algorithm,
+		key: CryptoKey<any>,
+	): CipherHandle;
+	cryptoCipherUpdate(
+		handle: CipherHandle,
+		data: BufferSource,
+		output?: BufferSource,
+	): Promise<ArrayBuffer | number>;
+	cryptoCipherFinal(handle: CipherHandle): ArrayBuffer;
+	cryptoCipherFile(
+		handle: CipherHandle,
+		source: string,
+		destination: string,
+	): Promise<number>;
 	sha256Hex(str: string): string;
 
 	// dommatrix.c
@@ -429,6 +614,8 @@ export interface Init {
 
 	// dns.c
 	dnsResolve(hostname: string): Promise<string[]>;
+	dnsSetServers(servers: string[]): void;
+	dnsClearCache(): void;
 
 	// error.c
 	onError(fn: (err: any) => number): void;
@@ -628,16 +815,15 @@ export interface Init {
 		onRecv: (
 			err: Error | null,
 			data?: ArrayBuffer,
-			remoteIp?: string,
-			remotePort?: number,
+			info?: Uint32Array,
+			count?: number,
 		) => void,
 	): DatagramSocket;
 	udpSend(
 		cb: Callback<number>,
-		fd: number,
-		data: ArrayBuffer,
-		ip: string,
-		port: number,
+		socket: DatagramSocket,
+		data: BufferSource,
+		info: Uint32Array,
 	): void;
 
 	// tls.c
@@ -677,7 +863,12 @@ export interface Init {
 	audioContextResume(ctx: AudioContextHandle): void;
 	audioContextCurrentTime(ctx: AudioContextHandle): number;
 	audioContextDestination(ctx: AudioContextHandle): AudioNodeHandle;
-	audioNodeNew(ctx: AudioContextHandle, type: number): AudioNodeHandle;
+	audioContextRenderStats(ctx: AudioContextHandle): AudioRenderStats;
+	audioNodeNew(
+		ctx: AudioContextHandle,
+		type: number,
+		maxDelayTime?: number,
+	): AudioNodeHandle;
 	audioNodeConnect(src: AudioNodeHandle, dst: AudioNodeHandle): void;
 	audioNodeDisconnect(src: AudioNodeHandle, dst?: AudioNodeHandle): void;
 	audioParamValue(node: AudioNodeHandle, index: number): number;
@@ -700,7 +891,7 @@ export interface Init {
 	audioParamCancel(node: AudioNodeHandle, index: number, time: number): void;
 	audioSourceSetBuffer(
 		node: AudioNodeHandle,
-		channels: Float32Array[],
+		channels: Float32Array[] | Int16Array[],
 		length: number,
 		sampleRate: number,
 	): void;
@@ -718,7 +909,77 @@ export interface Init {
 		loopEnd: number,
 	): void;
 	audioSourceState(node: AudioNodeHandle): number;
-	audioDecode(buffer: ArrayBuffer): Promise<{
+	audioPeriodicWaveNew(
+		real: Float32Array,
+		imag: Float32Array,
+		disableNormalization: boolean,
+	): PeriodicWaveHandle;
+	audioOscillatorSetType(node: AudioNodeHandle, type: number): void;
+	audioOscillatorSetPeriodicWave(
+		node: AudioNodeHandle,
+		wave: PeriodicWaveHandle,
+	): void;
+	audioBiquadSetType(node: AudioNodeHandle, type: number): void;
+	audioBiquadGetFrequencyResponse(
+		node: AudioNodeHandle,
+		type: number,
+		frequencyHz: Float32Array,
+		magResponse: Float32Array,
+		phaseResponse: Float32Array,
+	): void;
+	audioAnalyserGetFloatTimeDomainData(
+		node: AudioNodeHandle,
+		fftSize: number,
+		array: Float32Array,
+	): void;
+	audioAnalyserGetByteTimeDomainData(
+		node: AudioNodeHandle,
+		fftSize: number,
+		array: Uint8Array,
+	): void;
+	audioAnalyserGetFloatFrequencyData(
+		node: AudioNodeHandle,
+		fftSize: number,
+		smoothingTimeConstant: number,
+		array: Float32Array,
+	): void;
+	audioAnalyserGetByteFrequencyData(
+		node: AudioNodeHandle,
+		fftSize: number,
+		smoothingTimeConstant: number,
+		minDecibels: number,
+		maxDecibels: number,
+		array: Uint8Array,
+	): void;
+	audioConvolverSetBuffer(
+		node: AudioNodeHandle,
+		channels: Float32Array[] | null,
+		length: number,
+		sampleRate: number,
+		normalize: boolean,
+	): void;
+	audioCompressorReduction(node: AudioNodeHandle): number;
+	audioStreamSourceNew(
+		ctx: AudioContextHandle,
+		data: ArrayBuffer | ArrayBufferView,
+		loop: boolean,
+		loopStart: number,
+		loopEnd: number,
+	): [AudioNodeHandle, AudioStreamHandle];
+	audioStreamSeek(stream: AudioStreamHandle, seconds: number): void;
+	audioStreamSetLoop(
+		stream: AudioStreamHandle,
+		loop: boolean,
+		loopStart: number,
+		loopEnd: number,
+	): void;
+	audioStreamDuration(stream: AudioStreamHandle): number;
+	audioStreamError(stream: AudioStreamHandle): string | null;
+	/** With `s16`, the channel data holds Int16Array samples. */
+	audioDecode(
+		buffer: ArrayBuffer,
+		s16: boolean,
+	): Promise<{
 		channelData: ArrayBuffer[];
 		length: number;
 		sampleRate: number;
@@ -727,6 +988,7 @@ export interface Init {
 		ctx: AudioContextHandle,
 		numberOfChannels: number,
 		length: number,
+		threads: number,
 	): Promise<ArrayBuffer[]>;
 
 	// bluetooth.cc — Web Bluetooth (BLE GATT client over btm.u + bt)
@@ -844,6 +1106,18 @@ export interface Init {
 	): ArrayBuffer;
 	usbResetDevice(device: USBNativeDevice): void;
 
+	// animated-image.cc — GIF / APNG / animated WebP frame ring
+	animImageNew(): AnimatedImageHandle;
+	animImageLoad(
+		anim: AnimatedImageHandle,
+		buffer: ArrayBuffer,
+		frames?: number,
+	): Promise<AnimatedImageMetadata>;
+	animImageTick(anim: AnimatedImageHandle, now: number): boolean;
+	animImageReset(anim: AnimatedImageHandle): void;
+	animImageState(anim: AnimatedImageHandle): AnimatedImageState;
+	animImageClose(anim: AnimatedImageHandle): void;
+
 	// video.cc — Video element (ffmpeg media pipeline)
 	videoNew(): VideoHandle;
 	videoLoad(
@@ -222,11 +222,13 @@ export class Audio extends EventTarget {
 				}
 				return res.arrayBuffer();
 			})
-			.then((buf) => $.audioDecode(buf))
+			// 16-bit storage: the buffer never leaves this element, so
+			// nothing ever needs its float data.
+			.then((buf) => $.audioDecode(buf, true))
 			.then(
 				({ channelData, sampleRate }) => {
 					this.#buffer = createAudioBuffer(
-						channelData.map((ab) => new Float32Array(ab)),
+						channelData.map((ab) => new Int16Array(ab)),
 						sampleRate,
 					);
 					this.#readyState = HAVE_METADATA;
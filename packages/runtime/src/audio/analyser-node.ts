@@ -0,0 +1,249 @@
+import { $ } from '../$';
+import { DOMException } from '../dom-exception';
+import { INTERNAL_SYMBOL } from '../internal';
+import { createInternal, def } from '../utils';
+import { AudioNode, type AudioNodeOptions } from './audio-node';
+import { ctxInternal, NODE_TYPE_ANALYSER, nodeInternal } from './internal';
+import type { BaseAudioContext } from './base-audio-context';
+
+export interface AnalyserOptions extends AudioNodeOptions {
+	fftSize?: number;
+	maxDecibels?: number;
+	minDecibels?: number;
+	smoothingTimeConstant?: number;
+}
+
+interface AnalyserNodeInternal {
+	fftSize: number;
+	minDecibels: number;
+	maxDecibels: number;
+	smoothingTimeConstant: number;
+}
+
+const _ = createInternal<AnalyserNode, AnalyserNodeInternal>();
+
+function checkFftSize(iface: string, value: number): void {
+	if (value < 32 || value > 32768) {
+		throw new DOMException(
+			`Failed to ${iface}: The value provided (${value}) is outside the range [32, 32768].`,
+			'IndexSizeError',
+		);
+	}
+	if (!Number.isInteger(value) || (value & (value - 1)) !== 0) {
+		throw new DOMException(
+			`Failed to ${iface}: The value provided (${value}) is not a power of two.`,
+			'IndexSizeError',
+		);
+	}
+}
+
+function checkDecibels(iface: string, min: number, max: number): void {
+	if (!(min < max)) {
+		throw new DOMException(
+			`Failed to ${iface}: The minDecibels value (${min}) must be less than the maxDecibels value (${max}).`,
+			'IndexSizeError',
+		);
+	}
+}
+
+function checkSmoothing(iface: string, value: number): void {
+	if (!(value >= 0 && value <= 1)) {
+		throw new DOMException(
+			`Failed to ${iface}: The smoothing value provided (${value}) is outside the range [0, 1].`,
+			'IndexSizeError',
+		);
+	}
+}
+
+/**
+ * An {@link AudioNode} which passes its input through unchanged, while
+ * exposing its recent time-domain and frequency-domain data — the building
+ * block of audio visualizers.
+ *
+ * The render thread only records the input; the FFT (with the Blackman
+ * window and `smoothingTimeConstant` applied) runs natively when one of the
+ * `get*FrequencyData()` methods is called, and never blocks audio rendering.
+ *
+ * An `AnalyserNode` is processed even if its output is not connected, so
+ * `source.connect(analyser)` alone is enough to analyse a source.
+ *
+ * @see https://developer.mozilla.org/docs/Web/API/AnalyserNode
+ */
+export class AnalyserNode extends AudioNode implements globalThis.AnalyserNode {
+	/**
+	 * @see https://developer.mozilla.org/docs/Web/API/AnalyserNode/AnalyserNode
+	 */
+	constructor(context: BaseAudioContext, options: AnalyserOptions = {}) {
+		const iface = "construct 'AnalyserNode'";
+		const fftSize = options.fftSize ?? 2048;
+		const minDecibels = options.minDecibels ?? -100;
+		const maxDecibels = options.maxDecibels ?? -30;
+		const smoothingTimeConstant = options.smoothingTimeConstant ?? 0.8;
+		checkFftSize(iface, fftSize);
+		checkDecibels(iface, minDecibels, maxDecibels);
+		checkSmoothing(iface, smoothingTimeConstant);
+		const handle = $.audioNodeNew(
+			ctxInternal(context).handle,
+			NODE_TYPE_ANALYSER,
+		);
+		// @ts-expect-error internal constructor
+		super(INTERNAL_SYMBOL, {
+			context,
+			handle,
+			numberOfInputs: 1,
+			numberOfOutputs: 1,
+			channelCount: options.channelCount ?? 2,
+			channelCountMode: options.channelCountMode ?? 'max',
+			channelInterpretation: options.channelInterpretation ?? 'speakers',
+		});
+		_.set(this, { fftSize, minDecibels, maxDecibels, smoothingTimeConstant });
+	}
+
+	/**
+	 * The size of the FFT used for frequency-domain analysis (and the number
+	 * of samples of time-domain data). A power of two between `32` and
+	 * `32768`; defaults to `2048`.
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/AnalyserNode/fftSize
+	 */
+	get fftSize(): number {
+		return _(this).fftSize;
+	}
+
+	set fftSize(value: number) {
+		checkFftSize("set the 'fftSize' property on 'AnalyserNode'", value);
+		_(this).fftSize = value;
+	}
+
+	/**
+	 * Half of {@link AnalyserNode.fftSize | `fftSize`}: the number of values
+	 * produced by the frequency-domain methods.
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/AnalyserNode/frequencyBinCount
+	 */
+	get frequencyBinCount(): number {
+		return _(this).fftSize / 2;
+	}
+
+	/**
+	 * The power (in dB) mapped to `0` by
+	 * {@link AnalyserNode.getByteFrequencyData | `getByteFrequencyData()`}.
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/AnalyserNode/minDecibels
+	 */
+	get minDecibels(): number {
+		return _(this).minDecibels;
+	}
+
+	set minDecibels(value: number) {
+		const i = _(this);
+		checkDecibels(
+			"set the 'minDecibels' property on 'AnalyserNode'",
+			value,
+			i.maxDecibels,
+		);
+		i.minDecibels = value;
+	}
+
+	/**
+	 * The power (in dB) mapped to `255` by
+	 * {@link AnalyserNode.getByteFrequencyData | `getByteFrequencyData()`}.
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/AnalyserNode/maxDecibels
+	 */
+	get maxDecibels(): number {
+		return _(this).maxDecibels;
+	}
+
+	set maxDecibels(value: number) {
+		const i = _(this);
+		checkDecibels(
+			"set the 'maxDecibels' property on 'AnalyserNode'",
+			i.minDecibels,
+			value,
+		);
+		i.maxDecibels = value;
+	}
+
+	/**
+	 * How much each frequency-domain readout is averaged with the previous
+	 * one, between `0` (no averaging) and `1`; defaults to `0.8`.
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/AnalyserNode/smoothingTimeConstant
+	 */
+	get smoothingTimeConstant(): number {
+		return _(this).smoothingTimeConstant;
+	}
+
+	set smoothingTimeConstant(value: number) {
+		checkSmoothing(
+			"set the 'smoothingTimeConstant' property on 'AnalyserNode'",
+			value,
+		);
+		_(this).smoothingTimeConstant = value;
+	}
+
+	/**
+	 * Copies the current frequency data (in dB) into `array`, which receives
+	 * up to {@link AnalyserNode.frequencyBinCount | `frequencyBinCount`}
+	 * values.
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/AnalyserNode/getFloatFrequencyData
+	 */
+	getFloatFrequencyData(array: Float32Array): void {
+		const i = _(this);
+		$.audioAnalyserGetFloatFrequencyData(
+			nodeInternal(this).handle,
+			i.fftSize,
+			i.smoothingTimeConstant,
+			array,
+		);
+	}
+
+	/**
+	 * Copies the current frequency data into `array`, scaled so that
+	 * `minDecibels` maps to `0` and `maxDecibels` maps to `255`.
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/AnalyserNode/getByteFrequencyData
+	 */
+	getByteFrequencyData(array: Uint8Array): void {
+		const i = _(this);
+		$.audioAnalyserGetByteFrequencyData(
+			nodeInternal(this).handle,
+			i.fftSize,
+			i.smoothingTimeConstant,
+			i.minDecibels,
+			i.maxDecibels,
+			array,
+		);
+	}
+
+	/**
+	 * Copies the most recent {@link AnalyserNode.fftSize | `fftSize`} input
+	 * samples (downmixed to mono) into `array`.
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/AnalyserNode/getFloatTimeDomainData
+	 */
+	getFloatTimeDomainData(array: Float32Array): void {
+		$.audioAnalyserGetFloatTimeDomainData(
+			nodeInternal(this).handle,
+			_(this).fftSize,
+			array,
+		);
+	}
+
+	/**
+	 * Copies the most recent input samples into `array`, with `[-1, 1]`
+	 * mapped to `[0, 255]`.
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/AnalyserNode/getByteTimeDomainData
+	 */
+	getByteTimeDomainData(array: Uint8Array): void {
+		$.audioAnalyserGetByteTimeDomainData(
+			nodeInternal(this).handle,
+			_(this).fftSize,
+			array,
+		);
+	}
+}
+def(AnalyserNode);
@@ -6,6 +6,7 @@ import type { AudioBuffer } from './audio-buffer';
 import { createAudioParam } from './audio-param';
 import {
 	AudioScheduledSourceNode,
+	checkScheduleArg,
 	trackActiveSource,
 } from './audio-scheduled-source-node';
 import {
@@ -38,19 +39,6 @@ interface AudioBufferSourceNodeInternal {
 
 const _ = createInternal<AudioBufferSourceNode, AudioBufferSourceNodeInternal>();
 
-function checkScheduleArg(name: string, paramName: string, v: number) {
-	if (!Number.isFinite(v)) {
-		throw new TypeError(
-			`Failed to execute '${name}' on 'AudioBufferSourceNode': The provided ${paramName} is non-finite.`,
-		);
-	}
-	if (v < 0) {
-		throw new RangeError(
-			`Failed to execute '${name}' on 'AudioBufferSourceNode': The ${paramName} provided (${v}) cannot be negative.`,
-		);
-	}
-}
-
 function syncLoop(node: AudioBufferSourceNode) {
 	const i = _(node);
 	$.audioSourceSetLoop(
@@ -216,10 +204,15 @@ export class AudioBufferSourceNode
 	 * @see https://developer.mozilla.org/docs/Web/API/AudioBufferSourceNode/start
 	 */
 	start(when = 0, offset = 0, duration?: number): void {
-		checkScheduleArg('start', 'start time', when);
-		checkScheduleArg('start', 'offset', offset);
+		checkScheduleArg('AudioBufferSourceNode', 'start', 'start time', when);
+		checkScheduleArg('AudioBufferSourceNode', 'start', 'offset', offset);
 		if (typeof duration === 'number') {
-			checkScheduleArg('start', 'duration', duration);
+			checkScheduleArg(
+				'AudioBufferSourceNode',
+				'start',
+				'duration',
+				duration,
+			);
 		}
 		const i = _(this);
 		if (i.started) {
@@ -246,7 +239,7 @@ export class AudioBufferSourceNode
 	 * @see https://developer.mozilla.org/docs/Web/API/AudioBufferSourceNode/stop
 	 */
 	stop(when = 0): void {
-		checkScheduleArg('stop', 'stop time', when);
+		checkScheduleArg('AudioBufferSourceNode', 'stop', 'stop time', when);
 		const i = _(this);
 		if (!i.started) {
 			throw new DOMException(
@@ -2,6 +2,12 @@ import { DOMException } from '../dom-exception';
 import { def } from '../utils';
 import { bufferInternal as _ } from './internal';
 
+/**
+ * How an {@link AudioBuffer} stores its samples: `"f32"` (32-bit float, the
+ * Web Audio default) or `"s16"` (signed 16-bit, half the memory).
+ */
+export type AudioBufferFormat = 'f32' | 's16';
+
 export interface AudioBufferOptions {
 	/** The size of the buffer in sample-frames. */
 	length: number;
@@ -9,6 +15,14 @@ export interface AudioBufferOptions {
 	numberOfChannels?: number;
 	/** The sample rate in Hz for the buffer. */
 	sampleRate: number;
+	/**
+	 * The sample storage format (defaults to `"f32"`). See
+	 * {@link AudioBuffer.format}.
+	 *
+	 * > [!NOTE]
+	 * > This option is specific to nx.js.
+	 */
+	format?: AudioBufferFormat;
 }
 
 /**
@@ -18,7 +32,7 @@ export interface AudioBufferOptions {
  * @internal
  */
 export function createAudioBuffer(
-	channels: Float32Array[],
+	channels: Float32Array[] | Int16Array[],
 	sampleRate: number,
 ): AudioBuffer {
 	const buffer = Object.create(AudioBuffer.prototype) as AudioBuffer;
@@ -30,6 +44,25 @@ export function createAudioBuffer(
 	return buffer;
 }
 
+/**
+ * The buffer's channels as float data, converting `s16` storage (which is
+ * then released) first.
+ *
+ * @internal
+ */
+export function floatChannels(buffer: AudioBuffer): Float32Array[] {
+	const i = _(buffer);
+	const { channels } = i;
+	if (channels[0] instanceof Int16Array) {
+		i.channels = (channels as Int16Array[]).map((s16) => {
+			const f32 = new Float32Array(s16.length);
+			for (let k = 0; k < s16.length; k++) f32[k] = s16[k] / 32768;
+			return f32;
+		});
+	}
+	return i.channels as Float32Array[];
+}
+
 /**
  * A short audio asset residing in memory, created from an audio file using
  * {@link BaseAudioContext.decodeAudioData | `decodeAudioData()`}, or from raw
@@ -73,10 +106,22 @@ export class AudioBuffer implements globalThis.AudioBuffer {
 				'NotSupportedError',
 			);
 		}
-		const channels: Float32Array[] = [];
-		for (let i = 0; i < numberOfChannels; i++) {
-			channels.push(new Float32Array(length));
+		const format = options.format ?? 'f32';
+		if (format !== 'f32' && format !== 's16') {
+			throw new TypeError(
+				`Failed to construct 'AudioBuffer': The provided value '${format}' is not a valid enum value of type AudioBufferFormat.`,
+			);
 		}
+		const channels =
+			format === 's16'
+				? Array.from(
+						{ length: numberOfChannels },
+						() => new Int16Array(length),
+					)
+				: Array.from(
+						{ length: numberOfChannels },
+						() => new Float32Array(length),
+					);
 		_.set(this, { channels, sampleRate, length });
 	}
 
@@ -117,6 +162,27 @@ export class AudioBuffer implements globalThis.AudioBuffer {
 		return _(this).sampleRate;
 	}
 
+	/**
+	 * How the samples are stored. An `"s16"` buffer (from the `format`
+	 * option, or `decodeAudioData(data, { format: "s16" })`) takes half the
+	 * memory of an `"f32"` one, and is converted to float by the audio render
+	 * thread as it plays.
+	 *
+	 * Requesting float data with
+	 * {@link AudioBuffer.getChannelData | `getChannelData()`} or
+	 * {@link AudioBuffer.copyToChannel | `copyToChannel()`} converts the
+	 * buffer to `"f32"` for good (sources that were already playing keep
+	 * playing the 16-bit data), while
+	 * {@link AudioBuffer.copyFromChannel | `copyFromChannel()`} converts only
+	 * the samples it copies.
+	 *
+	 * > [!NOTE]
+	 * > This property is specific to nx.js.
+	 */
+	get format(): AudioBufferFormat {
+		return _(this).channels[0] instanceof Int16Array ? 's16' : 'f32';
+	}
+
 	/**
 	 * Returns the `Float32Array` containing the PCM data for the requested
 	 * channel.
@@ -124,21 +190,15 @@ export class AudioBuffer implements globalThis.AudioBuffer {
 	 * > [!NOTE]
 	 * > In nx.js, the returned array is a live view of the data the audio
 	 * > render thread reads — mutations are heard, even during playback.
+	 * > For an `"s16"` buffer, the data is converted to float first (see
+	 * > {@link AudioBuffer.format}).
 	 *
 	 * @param channel An index representing the channel to get data for (`0` is the first channel).
 	 * @see https://developer.mozilla.org/docs/Web/API/AudioBuffer/getChannelData
 	 */
 	getChannelData(channel: number): Float32Array {
-		const i = _(this);
-		if (channel < 0 || channel >= i.channels.length) {
-			throw new DOMException(
-				`The channel index provided (${channel}) is outside the range [0, ${
-					i.channels.length - 1
-				}]`,
-				'IndexSizeError',
-			);
-		}
-		return i.channels[channel];
+		checkChannel(this, channel);
+		return floatChannels(this)[channel];
 	}
 
 	/**
@@ -151,10 +211,17 @@ export class AudioBuffer implements globalThis.AudioBuffer {
 		channelNumber: number,
 		bufferOffset = 0,
 	): void {
-		const data = this.getChannelData(channelNumber);
+		checkChannel(this, channelNumber);
+		const data = _(this).channels[channelNumber];
 		if (bufferOffset >= data.length) return;
 		const count = Math.min(data.length - bufferOffset, destination.length);
-		destination.set(data.subarray(bufferOffset, bufferOffset + count));
+		if (data instanceof Float32Array) {
+			destination.set(data.subarray(bufferOffset, bufferOffset + count));
+			return;
+		}
+		for (let k = 0; k < count; k++) {
+			destination[k] = data[bufferOffset + k] / 32768;
+		}
 	}
 
 	/**
@@ -174,3 +241,15 @@ export class AudioBuffer implements globalThis.AudioBuffer {
 	}
 }
 def(AudioBuffer);
+
+function checkChannel(buffer: AudioBuffer, channel: number) {
+	const n = _(buffer).channels.length;
+	if (channel < 0 || channel >= n) {
+		throw new DOMException(
+			`The channel index provided (${channel}) is outside the range [0, ${
+				n - 1
+			}]`,
+			'IndexSizeError',
+		);
+	}
+}
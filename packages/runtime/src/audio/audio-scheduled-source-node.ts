@@ -37,6 +37,29 @@ export function trackActiveSource(node: AudioScheduledSourceNode) {
 	}
 }
 
+/**
+ * Validates a `start()` / `stop()` time argument.
+ *
+ * @internal
+ */
+export function checkScheduleArg(
+	iface: string,
+	name: string,
+	paramName: string,
+	v: number,
+) {
+	if (!Number.isFinite(v)) {
+		throw new TypeError(
+			`Failed to execute '${name}' on '${iface}': The provided ${paramName} is non-finite.`,
+		);
+	}
+	if (v < 0) {
+		throw new RangeError(
+			`Failed to execute '${name}' on '${iface}': The ${paramName} provided (${v}) cannot be negative.`,
+		);
+	}
+}
+
 /**
  * Parent interface for several types of audio source node. Provides the
  * `start()` / `stop()` scheduling methods and the `ended` event.
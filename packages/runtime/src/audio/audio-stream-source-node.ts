@@ -0,0 +1,219 @@
+import { $, type AudioStreamHandle } from '../$';
+import { DOMException } from '../dom-exception';
+import { INTERNAL_SYMBOL } from '../internal';
+import { createInternal, def } from '../utils';
+import {
+	AudioScheduledSourceNode,
+	checkScheduleArg,
+	trackActiveSource,
+} from './audio-scheduled-source-node';
+import { ctxInternal, nodeInternal } from './internal';
+import type { BaseAudioContext } from './base-audio-context';
+
+export interface AudioStreamSourceOptions {
+	/**
+	 * The encoded audio file (any format supported by
+	 * {@link BaseAudioContext.decodeAudioData | `decodeAudioData()`}).
+	 */
+	data: ArrayBuffer | ArrayBufferView;
+	loop?: boolean;
+	loopEnd?: number;
+	loopStart?: number;
+}
+
+interface AudioStreamSourceNodeInternal {
+	stream: AudioStreamHandle;
+	started: boolean;
+	loop: boolean;
+	loopStart: number;
+	loopEnd: number;
+}
+
+const _ = createInternal<AudioStreamSourceNode, AudioStreamSourceNodeInternal>();
+
+function syncLoop(node: AudioStreamSourceNode) {
+	const i = _(node);
+	$.audioStreamSetLoop(i.stream, i.loop, i.loopStart, i.loopEnd);
+}
+
+/**
+ * An audio source which plays an encoded audio file (e.g. a music track)
+ * by decoding it on the fly, rather than up front like
+ * {@link BaseAudioContext.decodeAudioData | `decodeAudioData()`}.
+ *
+ * Only the encoded bytes are kept in memory: a background thread decodes
+ * about one second ahead of playback. A five minute stereo track at 48 kHz
+ * takes about 110 MiB as an {@link AudioBuffer}, but only its file size
+ * (plus a 375 KiB ring) when streamed. Playback is scheduled with `start()` /
+ * `stop()`, sample-accurately, like an {@link AudioBufferSourceNode}, and
+ * loops gaplessly.
+ *
+ * In an {@link OfflineAudioContext}, rendering waits for the decoder, so the
+ * result is the same as with a decoded buffer.
+ *
+ * > [!NOTE]
+ * > This node is specific to nx.js.
+ *
+ * @example
+ *
+ * ```typescript
+ * const ctx = new AudioContext();
+ * const res = await fetch('romfs:/music.ogg');
+ * const music = new AudioStreamSourceNode(ctx, {
+ *   data: await res.arrayBuffer(),
+ *   loop: true,
+ * });
+ * music.connect(ctx.destination);
+ * music.start();
+ * ```
+ */
+export class AudioStreamSourceNode extends AudioScheduledSourceNode {
+	constructor(context: BaseAudioContext, options: AudioStreamSourceOptions) {
+		const data = options?.data;
+		if (!(data instanceof ArrayBuffer || ArrayBuffer.isView(data))) {
+			throw new TypeError(
+				"Failed to construct 'AudioStreamSourceNode': The provided value for 'data' is not of type '(ArrayBuffer or ArrayBufferView)'.",
+			);
+		}
+		const loop = options.loop ?? false;
+		const loopStart = options.loopStart ?? 0;
+		const loopEnd = options.loopEnd ?? 0;
+		const [handle, stream] = $.audioStreamSourceNew(
+			ctxInternal(context).handle,
+			data,
+			loop,
+			loopStart,
+			loopEnd,
+		);
+		// @ts-expect-error internal constructor
+		super(INTERNAL_SYMBOL, {
+			context,
+			handle,
+			numberOfInputs: 0,
+			numberOfOutputs: 1,
+			channelCount: 2,
+			channelCountMode: 'max',
+			channelInterpretation: 'speakers',
+		});
+		_.set(this, { stream, started: false, loop, loopStart, loopEnd });
+	}
+
+	/**
+	 * Duration of the audio file in seconds, or `NaN` until the file has
+	 * been parsed by the background thread (or if it cannot be determined).
+	 */
+	get duration(): number {
+		return $.audioStreamDuration(_(this).stream);
+	}
+
+	/**
+	 * The error which stopped decoding (an `EncodingError`), or `null`. A
+	 * stream which fails to decode plays silence, and then ends.
+	 */
+	get error(): DOMException | null {
+		const message = $.audioStreamError(_(this).stream);
+		if (message === null) return null;
+		return new DOMException(message, 'EncodingError');
+	}
+
+	/**
+	 * Whether playback loops between
+	 * {@link AudioStreamSourceNode.loopStart | `loopStart`} and
+	 * {@link AudioStreamSourceNode.loopEnd | `loopEnd`} when it reaches
+	 * the end.
+	 *
+	 * Changes apply to audio which has not been decoded yet, so they take
+	 * effect up to one second late.
+	 */
+	get loop(): boolean {
+		return _(this).loop;
+	}
+
+	set loop(v: boolean) {
+		_(this).loop = v;
+		syncLoop(this);
+	}
+
+	/**
+	 * Where looping restarts, in seconds.
+	 */
+	get loopStart(): number {
+		return _(this).loopStart;
+	}
+
+	set loopStart(v: number) {
+		_(this).loopStart = v;
+		syncLoop(this);
+	}
+
+	/**
+	 * Where looping wraps, in seconds (`0` = the end of the file).
+	 */
+	get loopEnd(): number {
+		return _(this).loopEnd;
+	}
+
+	set loopEnd(v: number) {
+		_(this).loopEnd = v;
+		syncLoop(this);
+	}
+
+	/**
+	 * Schedules playback to begin.
+	 *
+	 * The first second of audio is decoded as soon as the node is created;
+	 * starting at a non-zero `offset` restarts decoding there, so in a
+	 * real-time context, schedule such a start slightly ahead (e.g.
+	 * `ctx.currentTime + 0.1`) to keep it sample-accurate.
+	 *
+	 * @param when Time (in context seconds) the playback should begin. Values in the past begin immediately.
+	 * @param offset Offset (in seconds) into the file where playback should begin.
+	 * @param duration Duration (in seconds) of audio to play.
+	 */
+	start(when = 0, offset = 0, duration?: number): void {
+		checkScheduleArg('AudioStreamSourceNode', 'start', 'start time', when);
+		checkScheduleArg('AudioStreamSourceNode', 'start', 'offset', offset);
+		if (typeof duration === 'number') {
+			checkScheduleArg(
+				'AudioStreamSourceNode',
+				'start',
+				'duration',
+				duration,
+			);
+		}
+		const i = _(this);
+		if (i.started) {
+			throw new DOMException(
+				"Failed to execute 'start' on 'AudioStreamSourceNode': cannot call start more than once.",
+				'InvalidStateError',
+			);
+		}
+		i.started = true;
+		if (offset > 0) $.audioStreamSeek(i.stream, offset);
+		$.audioSourceStart(
+			nodeInternal(this).handle,
+			when,
+			offset,
+			typeof duration === 'number' ? duration : -1,
+		);
+		trackActiveSource(this);
+	}
+
+	/**
+	 * Schedules playback to stop.
+	 *
+	 * @param when Time (in context seconds) the playback should stop. Values in the past stop immediately.
+	 */
+	stop(when = 0): void {
+		checkScheduleArg('AudioStreamSourceNode', 'stop', 'stop time', when);
+		const i = _(this);
+		if (!i.started) {
+			throw new DOMException(
+				"Failed to execute 'stop' on 'AudioStreamSourceNode': cannot call stop without calling start first.",
+				'InvalidStateError',
+			);
+		}
+		$.audioSourceStop(nodeInternal(this).handle, when);
+	}
+}
+def(AudioStreamSourceNode);
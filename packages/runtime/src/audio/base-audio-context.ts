@@ -3,14 +3,58 @@ import { DOMException } from '../dom-exception';
 import { Event } from '../polyfills/event';
 import { EventTarget } from '../polyfills/event-target';
 import { assertInternalConstructor, def } from '../utils';
-import { AudioBuffer, createAudioBuffer } from './audio-buffer';
+import { AnalyserNode } from './analyser-node';
+import {
+	AudioBuffer,
+	type AudioBufferFormat,
+	createAudioBuffer,
+} from './audio-buffer';
 import { AudioBufferSourceNode } from './audio-buffer-source-node';
 import { AudioDestinationNode } from './audio-destination-node';
+import { BiquadFilterNode } from './biquad-filter-node';
+import { ConvolverNode } from './convolver-node';
+import { DelayNode } from './delay-node';
+import { DynamicsCompressorNode } from './dynamics-compressor-node';
 import { GainNode } from './gain-node';
+import { OscillatorNode } from './oscillator-node';
+import { PeriodicWave, type PeriodicWaveConstraints } from './periodic-wave';
 import { StereoPannerNode } from './stereo-panner-node';
 import { ctxInternal as _, type BaseAudioContextInternal } from './internal';
 import { INTERNAL_SYMBOL } from '../internal';
 
+/**
+ * Render-thread statistics of an audio context, as returned by
+ * {@link BaseAudioContext.getRenderStats | `getRenderStats()`}.
+ */
+export interface AudioRenderStats {
+	/** Number of 128-frame render quanta processed. */
+	quanta: number;
+	/**
+	 * Number of real-time renders that took longer than the audio they
+	 * produced (audible as a dropout). Always `0` for an `OfflineAudioContext`.
+	 */
+	glitches: number;
+	/** Number of compiled render plans adopted (one per topology change). */
+	planSwaps: number;
+	/** Number of control commands (param automation, start / stop, …) applied. */
+	commands: number;
+	/** Average time spent rendering one quantum, in milliseconds. */
+	renderTimeAverage: number;
+	/** Longest single render call, in milliseconds. */
+	renderTimeMax: number;
+}
+
+/**
+ * Options for {@link BaseAudioContext.decodeAudioData | `decodeAudioData()`}.
+ *
+ * > [!NOTE]
+ * > Passing options to `decodeAudioData()` is specific to nx.js.
+ */
+export interface DecodeAudioDataOptions {
+	/** The storage format of the decoded buffer (defaults to `"f32"`). */
+	format?: AudioBufferFormat;
+}
+
 /**
  * Transition the context state and fire `statechange` if it changed.
  *
@@ -104,6 +148,22 @@ export class BaseAudioContext
 		return _(this).state;
 	}
 
+	/**
+	 * Returns statistics about the context's audio render thread, for
+	 * diagnosing dropouts and the cost of the audio graph.
+	 *
+	 * @example
+	 *
+	 * ```typescript
+	 * const { glitches, renderTimeAverage } = ctx.getRenderStats();
+	 * ```
+	 *
+	 * @note This is an nx.js extension.
+	 */
+	getRenderStats(): AudioRenderStats {
+		return $.audioContextRenderStats(_(this).handle);
+	}
+
 	get audioWorklet(): AudioWorklet {
 		throw new Error('Method not implemented.');
 	}
@@ -154,6 +214,92 @@ export class BaseAudioContext
 		return new StereoPannerNode(this);
 	}
 
+	/**
+	 * Creates an {@link OscillatorNode}, a source generating a periodic
+	 * waveform.
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/BaseAudioContext/createOscillator
+	 */
+	createOscillator(): OscillatorNode {
+		return new OscillatorNode(this);
+	}
+
+	/**
+	 * Creates a {@link PeriodicWave} from Fourier coefficients, for use with
+	 * {@link OscillatorNode.setPeriodicWave | `setPeriodicWave()`}.
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/BaseAudioContext/createPeriodicWave
+	 */
+	createPeriodicWave(
+		real: number[] | Float32Array | Iterable<number>,
+		imag: number[] | Float32Array | Iterable<number>,
+		constraints?: PeriodicWaveConstraints,
+	): PeriodicWave {
+		const r = Float32Array.from(real);
+		const i = Float32Array.from(imag);
+		if (r.length !== i.length) {
+			throw new DOMException(
+				`Failed to execute 'createPeriodicWave' on 'BaseAudioContext': length of real array (${r.length}) and length of imaginary array (${i.length}) must match.`,
+				'IndexSizeError',
+			);
+		}
+		return new PeriodicWave(this, {
+			real: r,
+			imag: i,
+			disableNormalization: constraints?.disableNormalization,
+		});
+	}
+
+	/**
+	 * Creates a {@link BiquadFilterNode}, a second-order filter.
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/BaseAudioContext/createBiquadFilter
+	 */
+	createBiquadFilter(): BiquadFilterNode {
+		return new BiquadFilterNode(this);
+	}
+
+	/**
+	 * Creates a {@link DelayNode}, which delays its input by up to
+	 * `maxDelayTime` seconds.
+	 *
+	 * @param maxDelayTime The maximum delay time, in seconds (defaults to `1`, must be less than `180`).
+	 * @see https://developer.mozilla.org/docs/Web/API/BaseAudioContext/createDelay
+	 */
+	createDelay(maxDelayTime = 1): DelayNode {
+		return new DelayNode(this, { maxDelayTime });
+	}
+
+	/**
+	 * Creates an {@link AnalyserNode}, which exposes time-domain and
+	 * frequency-domain data of its input (e.g. for visualizations).
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/BaseAudioContext/createAnalyser
+	 */
+	createAnalyser(): AnalyserNode {
+		return new AnalyserNode(this);
+	}
+
+	/**
+	 * Creates a {@link ConvolverNode}, which convolves its input with an
+	 * impulse response (e.g. for reverb).
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/BaseAudioContext/createConvolver
+	 */
+	createConvolver(): ConvolverNode {
+		return new ConvolverNode(this);
+	}
+
+	/**
+	 * Creates a {@link DynamicsCompressorNode}, which lowers the volume of the
+	 * loudest parts of its input.
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/BaseAudioContext/createDynamicsCompressor
+	 */
+	createDynamicsCompressor(): DynamicsCompressorNode {
+		return new DynamicsCompressorNode(this);
+	}
+
 	/**
 	 * Asynchronously decodes audio file data contained in an `ArrayBuffer`
 	 * into an {@link AudioBuffer}.
@@ -168,13 +314,40 @@ export class BaseAudioContext
 	 * > context's sample rate — the returned buffer keeps the file's native
 	 * > rate (resampling happens at playback time).
 	 *
+	 * ### 16-bit storage
+	 *
+	 * Passing `{ format: 's16' }` as the second argument decodes into an
+	 * {@link AudioBuffer} with signed 16-bit storage, which takes half the
+	 * memory of the default float storage (see {@link AudioBuffer.format}).
+	 * For long music tracks, an {@link AudioStreamSourceNode} avoids holding
+	 * the decoded audio in memory at all.
+	 *
 	 * @see https://developer.mozilla.org/docs/Web/API/BaseAudioContext/decodeAudioData
 	 */
+	decodeAudioData(
+		audioData: ArrayBuffer,
+		options?: DecodeAudioDataOptions,
+	): Promise<AudioBuffer>;
 	decodeAudioData(
 		audioData: ArrayBuffer,
 		successCallback?: DecodeSuccessCallback | null,
 		errorCallback?: DecodeErrorCallback | null,
+	): Promise<AudioBuffer>;
+	decodeAudioData(
+		audioData: ArrayBuffer,
+		successCallbackOrOptions?:
+			| DecodeSuccessCallback
+			| DecodeAudioDataOptions
+			| null,
+		errorCallback?: DecodeErrorCallback | null,
 	): Promise<AudioBuffer> {
+		let successCallback: DecodeSuccessCallback | null | undefined;
+		let format: AudioBufferFormat = 'f32';
+		if (typeof successCallbackOrOptions === 'function') {
+			successCallback = successCallbackOrOptions;
+		} else if (successCallbackOrOptions) {
+			format = successCallbackOrOptions.format ?? 'f32';
+		}
 		if (!(audioData instanceof ArrayBuffer)) {
 			throw new TypeError(
 				"Failed to execute 'decodeAudioData' on 'BaseAudioContext': parameter 1 is not of type 'ArrayBuffer'",
@@ -184,10 +357,13 @@ export class BaseAudioContext
 		const transfer = (audioData as any).transfer;
 		const data: ArrayBuffer =
 			typeof transfer === 'function' ? transfer.call(audioData) : audioData;
-		const promise = $.audioDecode(data).then(
+		const s16 = format === 's16';
+		const promise = $.audioDecode(data, s16).then(
 			({ channelData, sampleRate }) => {
 				const buffer = createAudioBuffer(
-					channelData.map((ab) => new Float32Array(ab)),
+					s16
+						? channelData.map((ab) => new Int16Array(ab))
+						: channelData.map((ab) => new Float32Array(ab)),
 					sampleRate,
 				);
 				successCallback?.(buffer);
@@ -207,12 +383,6 @@ export class BaseAudioContext
 		return promise;
 	}
 
-	createAnalyser(): AnalyserNode {
-		throw new Error('Method not implemented.');
-	}
-	createBiquadFilter(): BiquadFilterNode {
-		throw new Error('Method not implemented.');
-	}
 	createChannelMerger(numberOfInputs?: number): ChannelMergerNode {
 		throw new Error('Method not implemented.');
 	}
@@ -222,34 +392,15 @@ export class BaseAudioContext
 	createConstantSource(): ConstantSourceNode {
 		throw new Error('Method not implemented.');
 	}
-	createConvolver(): ConvolverNode {
-		throw new Error('Method not implemented.');
-	}
-	createDelay(maxDelayTime?: number): DelayNode {
-		throw new Error('Method not implemented.');
-	}
-	createDynamicsCompressor(): DynamicsCompressorNode {
-		throw new Error('Method not implemented.');
-	}
 	createIIRFilter(
 		feedforward: number[] | Iterable<number>,
 		feedback: number[] | Iterable<number>,
 	): IIRFilterNode {
 		throw new Error('Method not implemented.');
 	}
-	createOscillator(): OscillatorNode {
-		throw new Error('Method not implemented.');
-	}
 	createPanner(): PannerNode {
 		throw new Error('Method not implemented.');
 	}
-	createPeriodicWave(
-		real: number[] | Float32Array | Iterable<number>,
-		imag: number[] | Float32Array | Iterable<number>,
-		constraints?: PeriodicWaveConstraints,
-	): PeriodicWave {
-		throw new Error('Method not implemented.');
-	}
 	createScriptProcessor(
 		bufferSize?: number,
 		numberOfInputChannels?: number,
@@ -0,0 +1,177 @@
+import { $ } from '../$';
+import { DOMException } from '../dom-exception';
+import { INTERNAL_SYMBOL } from '../internal';
+import { createInternal, def } from '../utils';
+import { AudioNode, type AudioNodeOptions } from './audio-node';
+import { createAudioParam } from './audio-param';
+import {
+	BIQUAD_FILTER_TYPES,
+	ctxInternal,
+	MOST_POSITIVE_SINGLE,
+	NODE_TYPE_BIQUAD_FILTER,
+	nodeInternal,
+} from './internal';
+import type { AudioParam } from './audio-param';
+import type { BaseAudioContext } from './base-audio-context';
+
+export interface BiquadFilterOptions extends AudioNodeOptions {
+	Q?: number;
+	detune?: number;
+	frequency?: number;
+	gain?: number;
+	type?: BiquadFilterType;
+}
+
+interface BiquadFilterNodeInternal {
+	type: BiquadFilterType;
+	frequency: AudioParam;
+	detune: AudioParam;
+	Q: AudioParam;
+	gain: AudioParam;
+}
+
+const _ = createInternal<BiquadFilterNode, BiquadFilterNodeInternal>();
+
+// 1200 * log2(FLT_MAX) cents, and 40 * log10(FLT_MAX) dB.
+const MAX_DETUNE = 153600;
+const MAX_GAIN = 1541.273681640625;
+
+/**
+ * A simple second-order filter (tone control, graphic equalizer band, etc.),
+ * processed natively on the audio render thread. All of its parameters are
+ * a-rate, so they can be automated with sample accuracy.
+ *
+ * @see https://developer.mozilla.org/docs/Web/API/BiquadFilterNode
+ */
+export class BiquadFilterNode
+	extends AudioNode
+	implements globalThis.BiquadFilterNode
+{
+	/**
+	 * @see https://developer.mozilla.org/docs/Web/API/BiquadFilterNode/BiquadFilterNode
+	 */
+	constructor(context: BaseAudioContext, options: BiquadFilterOptions = {}) {
+		const handle = $.audioNodeNew(
+			ctxInternal(context).handle,
+			NODE_TYPE_BIQUAD_FILTER,
+		);
+		// @ts-expect-error internal constructor
+		super(INTERNAL_SYMBOL, {
+			context,
+			handle,
+			numberOfInputs: 1,
+			numberOfOutputs: 1,
+			channelCount: options.channelCount ?? 2,
+			channelCountMode: options.channelCountMode ?? 'max',
+			channelInterpretation: options.channelInterpretation ?? 'speakers',
+		});
+		_.set(this, {
+			type: 'lowpass',
+			frequency: createAudioParam(this, handle, 0, {
+				defaultValue: 350,
+				minValue: 0,
+				maxValue: context.sampleRate / 2,
+			}),
+			detune: createAudioParam(this, handle, 1, {
+				defaultValue: 0,
+				minValue: -MAX_DETUNE,
+				maxValue: MAX_DETUNE,
+			}),
+			Q: createAudioParam(this, handle, 2, { defaultValue: 1 }),
+			gain: createAudioParam(this, handle, 3, {
+				defaultValue: 0,
+				minValue: -MOST_POSITIVE_SINGLE,
+				maxValue: MAX_GAIN,
+			}),
+		});
+		const i = _(this);
+		for (const name of ['frequency', 'detune', 'Q', 'gain'] as const) {
+			const v = options[name];
+			if (typeof v === 'number') i[name].value = v;
+		}
+		if (options.type) this.type = options.type;
+	}
+
+	/**
+	 * The kind of filtering algorithm the node implements.
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/BiquadFilterNode/type
+	 */
+	get type(): BiquadFilterType {
+		return _(this).type;
+	}
+
+	set type(type: BiquadFilterType) {
+		const index = BIQUAD_FILTER_TYPES.indexOf(type);
+		if (index === -1) return; // invalid enum values are ignored
+		_(this).type = type;
+		$.audioBiquadSetType(nodeInternal(this).handle, index);
+	}
+
+	/**
+	 * The frequency in the current filtering algorithm, in hertz.
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/BiquadFilterNode/frequency
+	 */
+	get frequency(): AudioParam {
+		return _(this).frequency;
+	}
+
+	/**
+	 * Detuning of the frequency, in cents.
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/BiquadFilterNode/detune
+	 */
+	get detune(): AudioParam {
+		return _(this).detune;
+	}
+
+	/**
+	 * The Q factor (quality factor) of the filter.
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/BiquadFilterNode/Q
+	 */
+	get Q(): AudioParam {
+		return _(this).Q;
+	}
+
+	/**
+	 * The gain (in dB) used by the shelf and peaking filters.
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/BiquadFilterNode/gain
+	 */
+	get gain(): AudioParam {
+		return _(this).gain;
+	}
+
+	/**
+	 * Computes the filter's magnitude and phase response, from the current
+	 * values of its parameters, at each of the given frequencies (in hertz).
+	 * Frequencies outside of `[0, sampleRate / 2]` produce `NaN`.
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/BiquadFilterNode/getFrequencyResponse
+	 */
+	getFrequencyResponse(
+		frequencyHz: Float32Array,
+		magResponse: Float32Array,
+		phaseResponse: Float32Array,
+	): void {
+		if (
+			magResponse.length !== frequencyHz.length ||
+			phaseResponse.length !== frequencyHz.length
+		) {
+			throw new DOMException(
+				`Failed to execute 'getFrequencyResponse' on 'BiquadFilterNode': The length of magResponse (${magResponse.length}) and phaseResponse (${phaseResponse.length}) must match the length of frequencyHz (${frequencyHz.length}).`,
+				'InvalidAccessError',
+			);
+		}
+		$.audioBiquadGetFrequencyResponse(
+			nodeInternal(this).handle,
+			BIQUAD_FILTER_TYPES.indexOf(_(this).type),
+			frequencyHz,
+			magResponse,
+			phaseResponse,
+		);
+	}
+}
+def(BiquadFilterNode);
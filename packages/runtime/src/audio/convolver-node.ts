@@ -0,0 +1,150 @@
+import { $ } from '../$';
+import { DOMException } from '../dom-exception';
+import { INTERNAL_SYMBOL } from '../internal';
+import { createInternal, def } from '../utils';
+import { floatChannels } from './audio-buffer';
+import { AudioNode, type AudioNodeOptions } from './audio-node';
+import {
+	bufferInternal,
+	ctxInternal,
+	NODE_TYPE_CONVOLVER,
+	nodeInternal,
+} from './internal';
+import type { AudioBuffer } from './audio-buffer';
+import type { BaseAudioContext } from './base-audio-context';
+
+export interface ConvolverOptions extends AudioNodeOptions {
+	buffer?: AudioBuffer | null;
+	disableNormalization?: boolean;
+}
+
+interface ConvolverNodeInternal {
+	buffer: AudioBuffer | null;
+	normalize: boolean;
+}
+
+const _ = createInternal<ConvolverNode, ConvolverNodeInternal>();
+
+/**
+ * An {@link AudioNode} which performs a linear convolution of its input with
+ * an impulse response (given as an {@link AudioBuffer}), typically to add
+ * reverberation.
+ *
+ * The convolution runs natively on the audio render thread, as a uniformly
+ * partitioned FFT overlap-add: its cost grows with the length of the impulse
+ * response, but it adds no latency. Mono, stereo and 4-channel ("true
+ * stereo") impulse responses are supported.
+ *
+ * @see https://developer.mozilla.org/docs/Web/API/ConvolverNode
+ */
+export class ConvolverNode
+	extends AudioNode
+	implements globalThis.ConvolverNode
+{
+	/**
+	 * @see https://developer.mozilla.org/docs/Web/API/ConvolverNode/ConvolverNode
+	 */
+	constructor(context: BaseAudioContext, options: ConvolverOptions = {}) {
+		const channelCount = options.channelCount ?? 2;
+		const channelCountMode = options.channelCountMode ?? 'clamped-max';
+		if (channelCount > 2) {
+			throw new DOMException(
+				"Failed to construct 'ConvolverNode': ConvolverNode: channelCount cannot be greater than 2",
+				'NotSupportedError',
+			);
+		}
+		if (channelCountMode === 'max') {
+			throw new DOMException(
+				"Failed to construct 'ConvolverNode': ConvolverNode: channelCountMode cannot be set to 'max'",
+				'NotSupportedError',
+			);
+		}
+		const handle = $.audioNodeNew(
+			ctxInternal(context).handle,
+			NODE_TYPE_CONVOLVER,
+		);
+		// @ts-expect-error internal constructor
+		super(INTERNAL_SYMBOL, {
+			context,
+			handle,
+			numberOfInputs: 1,
+			numberOfOutputs: 1,
+			channelCount,
+			channelCountMode,
+			channelInterpretation: options.channelInterpretation ?? 'speakers',
+		});
+		_.set(this, {
+			buffer: null,
+			normalize: !options.disableNormalization,
+		});
+		if (options.buffer) this.buffer = options.buffer;
+	}
+
+	/**
+	 * The impulse response. Must have 1, 2 or 4 channels, and the same sample
+	 * rate as the context.
+	 *
+	 * The impulse response is transformed when it is assigned: changing its
+	 * channel data afterwards has no effect, unless it is assigned again.
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/ConvolverNode/buffer
+	 */
+	get buffer(): AudioBuffer | null {
+		return _(this).buffer;
+	}
+
+	set buffer(buffer: AudioBuffer | null) {
+		const i = _(this);
+		if (buffer) {
+			const { numberOfChannels, sampleRate } = buffer;
+			if (
+				numberOfChannels !== 1 &&
+				numberOfChannels !== 2 &&
+				numberOfChannels !== 4
+			) {
+				throw new DOMException(
+					`Failed to set the 'buffer' property on 'ConvolverNode': The buffer must have 1, 2, or 4 channels, not ${numberOfChannels}`,
+					'NotSupportedError',
+				);
+			}
+			if (sampleRate !== this.context.sampleRate) {
+				throw new DOMException(
+					`Failed to set the 'buffer' property on 'ConvolverNode': The buffer sample rate (${sampleRate}) does not match the context rate (${this.context.sampleRate})`,
+					'NotSupportedError',
+				);
+			}
+			const b = bufferInternal(buffer);
+			$.audioConvolverSetBuffer(
+				nodeInternal(this).handle,
+				floatChannels(buffer),
+				b.length,
+				b.sampleRate,
+				i.normalize,
+			);
+		} else {
+			$.audioConvolverSetBuffer(
+				nodeInternal(this).handle,
+				null,
+				0,
+				0,
+				false,
+			);
+		}
+		i.buffer = buffer;
+	}
+
+	/**
+	 * Whether the impulse response is scaled by an equal-power normalization
+	 * when {@link ConvolverNode.buffer | `buffer`} is set; defaults to `true`.
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/ConvolverNode/normalize
+	 */
+	get normalize(): boolean {
+		return _(this).normalize;
+	}
+
+	set normalize(value: boolean) {
+		_(this).normalize = Boolean(value);
+	}
+}
+def(ConvolverNode);
@@ -0,0 +1,76 @@
+import { $ } from '../$';
+import { DOMException } from '../dom-exception';
+import { INTERNAL_SYMBOL } from '../internal';
+import { createInternal, def } from '../utils';
+import { AudioNode, type AudioNodeOptions } from './audio-node';
+import { createAudioParam } from './audio-param';
+import { ctxInternal, NODE_TYPE_DELAY } from './internal';
+import type { AudioParam } from './audio-param';
+import type { BaseAudioContext } from './base-audio-context';
+
+export interface DelayOptions extends AudioNodeOptions {
+	delayTime?: number;
+	maxDelayTime?: number;
+}
+
+const _ = createInternal<DelayNode, { delayTime: AudioParam }>();
+
+/**
+ * An {@link AudioNode} which delays its input by a (possibly automated)
+ * amount of time.
+ *
+ * A `DelayNode` is also what makes a cycle in the audio graph legal (e.g. a
+ * feedback echo). Inside a cycle, the delay is at least one render quantum
+ * (128 frames).
+ *
+ * @see https://developer.mozilla.org/docs/Web/API/DelayNode
+ */
+export class DelayNode extends AudioNode implements globalThis.DelayNode {
+	/**
+	 * @see https://developer.mozilla.org/docs/Web/API/DelayNode/DelayNode
+	 */
+	constructor(context: BaseAudioContext, options: DelayOptions = {}) {
+		const maxDelayTime = options.maxDelayTime ?? 1;
+		if (!(maxDelayTime > 0 && maxDelayTime < 180)) {
+			throw new DOMException(
+				`Failed to construct 'DelayNode': The max delay time provided (${maxDelayTime}) is outside the range (0, 180).`,
+				'NotSupportedError',
+			);
+		}
+		const handle = $.audioNodeNew(
+			ctxInternal(context).handle,
+			NODE_TYPE_DELAY,
+			maxDelayTime,
+		);
+		// @ts-expect-error internal constructor
+		super(INTERNAL_SYMBOL, {
+			context,
+			handle,
+			numberOfInputs: 1,
+			numberOfOutputs: 1,
+			channelCount: options.channelCount ?? 2,
+			channelCountMode: options.channelCountMode ?? 'max',
+			channelInterpretation: options.channelInterpretation ?? 'speakers',
+		});
+		const delayTime = createAudioParam(this, handle, 0, {
+			defaultValue: 0,
+			minValue: 0,
+			maxValue: maxDelayTime,
+		});
+		if (typeof options.delayTime === 'number') {
+			delayTime.value = options.delayTime;
+		}
+		_.set(this, { delayTime });
+	}
+
+	/**
+	 * The amount of delay to apply, in seconds (an a-rate
+	 * {@link AudioParam}).
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/DelayNode/delayTime
+	 */
+	get delayTime(): AudioParam {
+		return _(this).delayTime;
+	}
+}
+def(DelayNode);
@@ -0,0 +1,189 @@
+import { $ } from '../$';
+import { DOMException } from '../dom-exception';
+import { INTERNAL_SYMBOL } from '../internal';
+import { createInternal, def } from '../utils';
+import { AudioNode, type AudioNodeOptions } from './audio-node';
+import { createAudioParam } from './audio-param';
+import {
+	ctxInternal,
+	NODE_TYPE_DYNAMICS_COMPRESSOR,
+	nodeInternal,
+} from './internal';
+import type { AudioParam } from './audio-param';
+import type { BaseAudioContext } from './base-audio-context';
+
+export interface DynamicsCompressorOptions extends AudioNodeOptions {
+	attack?: number;
+	knee?: number;
+	ratio?: number;
+	release?: number;
+	threshold?: number;
+}
+
+interface DynamicsCompressorNodeInternal {
+	threshold: AudioParam;
+	knee: AudioParam;
+	ratio: AudioParam;
+	attack: AudioParam;
+	release: AudioParam;
+}
+
+const _ = createInternal<
+	DynamicsCompressorNode,
+	DynamicsCompressorNodeInternal
+>();
+
+/**
+ * An {@link AudioNode} which lowers the volume of the loudest parts of its
+ * input, to prevent clipping and distortion when many sounds are mixed
+ * together.
+ *
+ * The compressor runs natively on the audio render thread, with a fixed
+ * 6 ms look-ahead: its output is delayed by that much, so that gain reduction
+ * is already in place when a transient reaches the output. All of its
+ * parameters are k-rate.
+ *
+ * @see https://developer.mozilla.org/docs/Web/API/DynamicsCompressorNode
+ */
+export class DynamicsCompressorNode
+	extends AudioNode
+	implements globalThis.DynamicsCompressorNode
+{
+	/**
+	 * @see https://developer.mozilla.org/docs/Web/API/DynamicsCompressorNode/DynamicsCompressorNode
+	 */
+	constructor(
+		context: BaseAudioContext,
+		options: DynamicsCompressorOptions = {},
+	) {
+		const channelCount = options.channelCount ?? 2;
+		const channelCountMode = options.channelCountMode ?? 'clamped-max';
+		if (channelCount > 2) {
+			throw new DOMException(
+				"Failed to construct 'DynamicsCompressorNode': DynamicsCompressorNode: channelCount cannot be greater than 2",
+				'NotSupportedError',
+			);
+		}
+		if (channelCountMode === 'max') {
+			throw new DOMException(
+				"Failed to construct 'DynamicsCompressorNode': DynamicsCompressorNode: channelCountMode cannot be set to 'max'",
+				'NotSupportedError',
+			);
+		}
+		const handle = $.audioNodeNew(
+			ctxInternal(context).handle,
+			NODE_TYPE_DYNAMICS_COMPRESSOR,
+		);
+		// @ts-expect-error internal constructor
+		super(INTERNAL_SYMBOL, {
+			context,
+			handle,
+			numberOfInputs: 1,
+			numberOfOutputs: 1,
+			channelCount,
+			channelCountMode,
+			channelInterpretation: options.channelInterpretation ?? 'speakers',
+		});
+		_.set(this, {
+			threshold: createAudioParam(this, handle, 0, {
+				defaultValue: -24,
+				minValue: -100,
+				maxValue: 0,
+				automationRate: 'k-rate',
+			}),
+			knee: createAudioParam(this, handle, 1, {
+				defaultValue: 30,
+				minValue: 0,
+				maxValue: 40,
+				automationRate: 'k-rate',
+			}),
+			ratio: createAudioParam(this, handle, 2, {
+				defaultValue: 12,
+				minValue: 1,
+				maxValue: 20,
+				automationRate: 'k-rate',
+			}),
+			attack: createAudioParam(this, handle, 3, {
+				defaultValue: 0.003,
+				minValue: 0,
+				maxValue: 1,
+				automationRate: 'k-rate',
+			}),
+			release: createAudioParam(this, handle, 4, {
+				defaultValue: 0.25,
+				minValue: 0,
+				maxValue: 1,
+				automationRate: 'k-rate',
+			}),
+		});
+		const i = _(this);
+		for (const name of [
+			'threshold',
+			'knee',
+			'ratio',
+			'attack',
+			'release',
+		] as const) {
+			const v = options[name];
+			if (typeof v === 'number') i[name].value = v;
+		}
+	}
+
+	/**
+	 * The level (in dB) above which compression starts.
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/DynamicsCompressorNode/threshold
+	 */
+	get threshold(): AudioParam {
+		return _(this).threshold;
+	}
+
+	/**
+	 * The range (in dB) above the threshold over which the curve smoothly
+	 * transitions to the compressed portion.
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/DynamicsCompressorNode/knee
+	 */
+	get knee(): AudioParam {
+		return _(this).knee;
+	}
+
+	/**
+	 * The amount of input change (in dB) needed for a 1 dB change in the
+	 * output, above the knee.
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/DynamicsCompressorNode/ratio
+	 */
+	get ratio(): AudioParam {
+		return _(this).ratio;
+	}
+
+	/**
+	 * The time (in seconds) it takes to reduce the gain by 10 dB.
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/DynamicsCompressorNode/attack
+	 */
+	get attack(): AudioParam {
+		return _(this).attack;
+	}
+
+	/**
+	 * The time (in seconds) it takes to increase the gain by 10 dB.
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/DynamicsCompressorNode/release
+	 */
+	get release(): AudioParam {
+		return _(this).release;
+	}
+
+	/**
+	 * The amount of gain reduction (in dB, `<= 0`) currently applied by the
+	 * compressor.
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/DynamicsCompressorNode/reduction
+	 */
+	get reduction(): number {
+		return $.audioCompressorReduction(nodeInternal(this).handle);
+	}
+}
+def(DynamicsCompressorNode);
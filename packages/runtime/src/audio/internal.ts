@@ -3,13 +3,18 @@
 // subclasses) can access each other's internals without import cycles — all
 // cross-module imports of this file are value imports, while the class types
 // are imported `type`-only.
-import type { AudioContextHandle, AudioNodeHandle } from '../$';
+import type {
+	AudioContextHandle,
+	AudioNodeHandle,
+	PeriodicWaveHandle,
+} from '../$';
 import { createInternal } from '../utils';
 import type { AudioBuffer } from './audio-buffer';
 import type { AudioDestinationNode } from './audio-destination-node';
 import type { AudioNode } from './audio-node';
 import type { AudioParam } from './audio-param';
 import type { BaseAudioContext } from './base-audio-context';
+import type { PeriodicWave } from './periodic-wave';
 
 export interface BaseAudioContextInternal {
 	handle: AudioContextHandle;
@@ -52,18 +57,54 @@ export interface AudioParamInternal {
 export const paramInternal = createInternal<AudioParam, AudioParamInternal>();
 
 export interface AudioBufferInternal {
-	channels: Float32Array[];
+	/**
+	 * Float samples, or signed 16-bit ones for an AudioBuffer with `s16`
+	 * storage — until float data is requested (see `floatChannels()`).
+	 */
+	channels: Float32Array[] | Int16Array[];
 	sampleRate: number;
 	length: number;
 }
 
 export const bufferInternal = createInternal<AudioBuffer, AudioBufferInternal>();
 
+export const waveInternal = createInternal<
+	PeriodicWave,
+	{ handle: PeriodicWaveHandle }
+>();
+
 // Native node type discriminators — must match `nx_audio_node_type` in
 // `source/audio-graph.h`.
 export const NODE_TYPE_GAIN = 1;
 export const NODE_TYPE_STEREO_PANNER = 2;
 export const NODE_TYPE_BUFFER_SOURCE = 3;
+export const NODE_TYPE_OSCILLATOR = 5;
+export const NODE_TYPE_BIQUAD_FILTER = 6;
+export const NODE_TYPE_DELAY = 7;
+export const NODE_TYPE_ANALYSER = 8;
+export const NODE_TYPE_CONVOLVER = 9;
+export const NODE_TYPE_DYNAMICS_COMPRESSOR = 10;
+
+// Index = `nx_audio_oscillator_type` in `source/audio-dsp.h`.
+export const OSCILLATOR_TYPES: readonly OscillatorType[] = [
+	'sine',
+	'square',
+	'sawtooth',
+	'triangle',
+	'custom',
+];
+
+// Index = `nx_audio_biquad_type` in `source/audio-dsp.h`.
+export const BIQUAD_FILTER_TYPES: readonly BiquadFilterType[] = [
+	'lowpass',
+	'highpass',
+	'bandpass',
+	'lowshelf',
+	'highshelf',
+	'peaking',
+	'notch',
+	'allpass',
+];
 
 // AudioParam automation event types — must match `nx_audio_param_event_type`
 // in `source/audio-graph.h`.
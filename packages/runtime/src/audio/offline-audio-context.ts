@@ -15,11 +15,20 @@ export interface OfflineAudioContextOptions {
 	length: number;
 	/** The sample rate of the rendering, in Hz. */
 	sampleRate: number;
+	/**
+	 * The number of threads to render with (nx.js extension). Branches of the
+	 * graph that only meet at the destination (for example sources feeding
+	 * separate gain chains) are rendered concurrently; the result is
+	 * bit-identical to rendering on one thread. Defaults to `3` (the CPU cores
+	 * available to an application); `1` disables parallel rendering.
+	 */
+	renderThreads?: number;
 }
 
 interface OfflineAudioContextInternal {
 	length: number;
 	numberOfChannels: number;
+	renderThreads: number;
 	started: boolean;
 }
 
@@ -53,10 +62,12 @@ export class OfflineAudioContext
 		let numberOfChannels: number;
 		let length: number;
 		let sampleRate: number;
+		let renderThreads = 0;
 		if (typeof arg0 === 'object' && arg0 !== null) {
 			numberOfChannels = arg0.numberOfChannels ?? 1;
 			length = arg0.length;
 			sampleRate = arg0.sampleRate;
+			renderThreads = arg0.renderThreads ?? 0;
 		} else {
 			numberOfChannels = arg0;
 			length = lengthArg!;
@@ -92,7 +103,12 @@ export class OfflineAudioContext
 			sampleRate,
 		});
 		this.oncomplete = null;
-		_.set(this, { length, numberOfChannels, started: false });
+		_.set(this, {
+			length,
+			numberOfChannels,
+			renderThreads,
+			started: false,
+		});
 	}
 
 	/**
@@ -124,6 +140,7 @@ export class OfflineAudioContext
 			ctxInternal(this).handle,
 			i.numberOfChannels,
 			i.length,
+			i.renderThreads,
 		);
 		const buffer = createAudioBuffer(
 			channelData.map((ab) => new Float32Array(ab)),
@@ -0,0 +1,203 @@
+import { $ } from '../$';
+import { DOMException } from '../dom-exception';
+import { INTERNAL_SYMBOL } from '../internal';
+import { createInternal, def } from '../utils';
+import type { AudioNodeOptions } from './audio-node';
+import { createAudioParam } from './audio-param';
+import {
+	AudioScheduledSourceNode,
+	checkScheduleArg,
+	trackActiveSource,
+} from './audio-scheduled-source-node';
+import {
+	ctxInternal,
+	NODE_TYPE_OSCILLATOR,
+	nodeInternal,
+	OSCILLATOR_TYPES,
+	waveInternal,
+} from './internal';
+import type { AudioParam } from './audio-param';
+import type { BaseAudioContext } from './base-audio-context';
+import type { PeriodicWave } from './periodic-wave';
+
+export interface OscillatorOptions extends AudioNodeOptions {
+	detune?: number;
+	frequency?: number;
+	periodicWave?: PeriodicWave;
+	type?: OscillatorType;
+}
+
+interface OscillatorNodeInternal {
+	type: OscillatorType;
+	started: boolean;
+	frequency: AudioParam;
+	detune: AudioParam;
+}
+
+const _ = createInternal<OscillatorNode, OscillatorNodeInternal>();
+
+// 1200 * log2(FLT_MAX): the detune range for which 2^(detune / 1200) is finite.
+const MAX_DETUNE = 153600;
+
+/**
+ * An audio source that generates a periodic waveform, such as a sine wave,
+ * natively on the audio render thread.
+ *
+ * All waveforms (including custom ones from a {@link PeriodicWave}) are
+ * played from band-limited wave tables, so they do not alias at high
+ * frequencies.
+ *
+ * @see https://developer.mozilla.org/docs/Web/API/OscillatorNode
+ */
+export class OscillatorNode
+	extends AudioScheduledSourceNode
+	implements globalThis.OscillatorNode
+{
+	/**
+	 * @see https://developer.mozilla.org/docs/Web/API/OscillatorNode/OscillatorNode
+	 */
+	constructor(context: BaseAudioContext, options: OscillatorOptions = {}) {
+		const type = options.type ?? 'sine';
+		if (type === 'custom' && !options.periodicWave) {
+			throw new DOMException(
+				"Failed to construct 'OscillatorNode': A PeriodicWave must be specified if the type is set to \"custom\"",
+				'InvalidStateError',
+			);
+		}
+		const handle = $.audioNodeNew(
+			ctxInternal(context).handle,
+			NODE_TYPE_OSCILLATOR,
+		);
+		// @ts-expect-error internal constructor
+		super(INTERNAL_SYMBOL, {
+			context,
+			handle,
+			numberOfInputs: 0,
+			numberOfOutputs: 1,
+			channelCount: options.channelCount ?? 2,
+			channelCountMode: options.channelCountMode ?? 'max',
+			channelInterpretation: options.channelInterpretation ?? 'speakers',
+		});
+		const nyquist = context.sampleRate / 2;
+		_.set(this, {
+			type: 'sine',
+			started: false,
+			frequency: createAudioParam(this, handle, 0, {
+				defaultValue: 440,
+				minValue: -nyquist,
+				maxValue: nyquist,
+			}),
+			detune: createAudioParam(this, handle, 1, {
+				defaultValue: 0,
+				minValue: -MAX_DETUNE,
+				maxValue: MAX_DETUNE,
+			}),
+		});
+		const i = _(this);
+		if (typeof options.frequency === 'number') {
+			i.frequency.value = options.frequency;
+		}
+		if (typeof options.detune === 'number') {
+			i.detune.value = options.detune;
+		}
+		if (options.periodicWave) {
+			this.setPeriodicWave(options.periodicWave);
+		} else if (type !== 'sine') {
+			this.type = type;
+		}
+	}
+
+	/**
+	 * The frequency of oscillation in hertz (an a-rate {@link AudioParam}).
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/OscillatorNode/frequency
+	 */
+	get frequency(): AudioParam {
+		return _(this).frequency;
+	}
+
+	/**
+	 * Detuning of the oscillation, in cents (an a-rate {@link AudioParam}).
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/OscillatorNode/detune
+	 */
+	get detune(): AudioParam {
+		return _(this).detune;
+	}
+
+	/**
+	 * The shape of the waveform: `"sine"`, `"square"`, `"sawtooth"`,
+	 * `"triangle"`, or `"custom"` (set via
+	 * {@link OscillatorNode.setPeriodicWave | `setPeriodicWave()`}).
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/OscillatorNode/type
+	 */
+	get type(): OscillatorType {
+		return _(this).type;
+	}
+
+	set type(type: OscillatorType) {
+		if (type === 'custom') {
+			throw new DOMException(
+				"Failed to set the 'type' property on 'OscillatorNode': 'type' cannot be set directly to 'custom'.  Use setPeriodicWave() to create a custom Oscillator type.",
+				'InvalidStateError',
+			);
+		}
+		const index = OSCILLATOR_TYPES.indexOf(type);
+		if (index === -1) return; // invalid enum values are ignored
+		_(this).type = type;
+		$.audioOscillatorSetType(nodeInternal(this).handle, index);
+	}
+
+	/**
+	 * Sets a {@link PeriodicWave} which describes a custom waveform, and
+	 * changes `type` to `"custom"`.
+	 *
+	 * @see https://developer.mozilla.org/docs/Web/API/OscillatorNode/setPeriodicWave
+	 */
+	setPeriodicWave(periodicWave: PeriodicWave): void {
+		$.audioOscillatorSetPeriodicWave(
+			nodeInternal(this).handle,
+			waveInternal(periodicWave).handle,
+		);
+		_(this).type = 'custom';
+	}
+
+	/**
+	 * Schedules the oscillator to begin playback.
+	 *
+	 * @param when Time (in context seconds) the playback should begin. Values in the past begin immediately.
+	 * @see https://developer.mozilla.org/docs/Web/API/AudioScheduledSourceNode/start
+	 */
+	start(when = 0): void {
+		checkScheduleArg('OscillatorNode', 'start', 'start time', when);
+		const i = _(this);
+		if (i.started) {
+			throw new DOMException(
+				"Failed to execute 'start' on 'OscillatorNode': cannot call start more than once.",
+				'InvalidStateError',
+			);
+		}
+		i.started = true;
+		$.audioSourceStart(nodeInternal(this).handle, when, 0, -1);
+		trackActiveSource(this);
+	}
+
+	/**
+	 * Schedules the playback to stop.
+	 *
+	 * @param when Time (in context seconds) the playback should stop. Values in the past stop immediately.
+	 * @see https://developer.mozilla.org/docs/Web/API/AudioScheduledSourceNode/stop
+	 */
+	stop(when = 0): void {
+		checkScheduleArg('OscillatorNode', 'stop', 'stop time', when);
+		if (!_(this).started) {
+			throw new DOMException(
+				"Failed to execute 'stop' on 'OscillatorNode': cannot call stop without calling start first.",
+				'InvalidStateError',
+			);
+		}
+		$.audioSourceStop(nodeInternal(this).handle, when);
+	}
+}
+def(OscillatorNode);
@@ -0,0 +1,58 @@
+import { $ } from '../$';
+import { DOMException } from '../dom-exception';
+import { def } from '../utils';
+import type { BaseAudioContext } from './base-audio-context';
+import { waveInternal as _ } from './internal';
+
+export interface PeriodicWaveConstraints {
+	disableNormalization?: boolean;
+}
+
+export interface PeriodicWaveOptions extends PeriodicWaveConstraints {
+	imag?: number[] | Float32Array;
+	real?: number[] | Float32Array;
+}
+
+/**
+ * A periodic waveform, described by its Fourier coefficients, that can be
+ * used to shape the output of an {@link OscillatorNode}.
+ *
+ * The waveform is rendered into band-limited wave tables once, when the
+ * `PeriodicWave` is created, and can be shared by any number of oscillators.
+ *
+ * @see https://developer.mozilla.org/docs/Web/API/PeriodicWave
+ */
+export class PeriodicWave implements globalThis.PeriodicWave {
+	/**
+	 * @see https://developer.mozilla.org/docs/Web/API/PeriodicWave/PeriodicWave
+	 */
+	constructor(context: BaseAudioContext, options: PeriodicWaveOptions = {}) {
+		let { real, imag } = options;
+		if (!real && !imag) {
+			real = [0, 0];
+			imag = [0, 1];
+		}
+		const length = (real ?? imag)!.length;
+		const r = real ? new Float32Array(real) : new Float32Array(length);
+		const i = imag ? new Float32Array(imag) : new Float32Array(length);
+		if (r.length !== i.length) {
+			throw new DOMException(
+				`Failed to construct 'PeriodicWave': length of real array (${r.length}) and length of imaginary array (${i.length}) must match.`,
+				'IndexSizeError',
+			);
+		}
+		if (r.length < 2) {
+			throw new DOMException(
+				`Failed to construct 'PeriodicWave': length of the arrays (${r.length}) must be at least 2.`,
+				'IndexSizeError',
+			);
+		}
+		const handle = $.audioPeriodicWaveNew(
+			r,
+			i,
+			options.disableNormalization ?? false,
+		);
+		_.set(this, { handle });
+	}
+}
+def(PeriodicWave);
@@ -799,6 +799,37 @@ export class OffscreenCanvasRenderingContext2D {
 		stub();
 	}
 
+	/**
+	 * Draws many sprites from a single `image` (a sprite atlas) in one
+	 * native call. This is an nx.js extension, intended for games that would
+	 * otherwise issue thousands of {@link drawImage} calls per frame.
+	 *
+	 * `sprites` contains 9 floats per sprite:
+	 *
+	 * ```
+	 * [sx, sy, sw, sh, scos, ssin, tx, ty, alpha]
+	 * ```
+	 *
+	 * `sx`/`sy`/`sw`/`sh` is the source rectangle within `image`. The sprite
+	 * is then transformed by the matrix `[scos, ssin, -ssin, scos, tx, ty]`
+	 * (a rotation and uniform scale, followed by a translation) on top of the
+	 * current transform. `alpha` is multiplied with
+	 * {@link globalAlpha | `globalAlpha`}.
+	 *
+	 * @param image The sprite atlas to draw from.
+	 * @param sprites Sprite records, 9 floats per sprite.
+	 * @param colors Optional per-sprite `0xAARRGGBB` colors, multiplied into each sprite.
+	 * @param count Number of sprites to draw. Defaults to all records in `sprites`.
+	 */
+	drawAtlas(
+		image: CanvasImageSource,
+		sprites: Float32Array,
+		colors?: Uint32Array | null,
+		count?: number,
+	): void {
+		stub();
+	}
+
 	lineTo(x: number, y: number): void {
 		stub();
 	}
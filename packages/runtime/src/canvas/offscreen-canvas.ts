@@ -2,7 +2,10 @@ import { $ } from '../$';
 import { INTERNAL_SYMBOL } from '../internal';
 import { Blob as NxBlob } from '../polyfills/blob';
 import { EventTarget } from '../polyfills/event-target';
-import type { ImageEncodeOptions } from '../types';
+import type {
+	CanvasRenderingContext2DSettings,
+	ImageEncodeOptions,
+} from '../types';
 import { createInternal, def, normalizeImageMime, proto } from '../utils';
 import { OffscreenCanvasRenderingContext2D } from './offscreen-canvas-rendering-context-2d';
 
@@ -47,13 +50,19 @@ export class OffscreenCanvas
 	async convertToBlob(options?: ImageEncodeOptions | undefined): Promise<Blob> {
 		const type = options?.type;
 		const quality = options?.quality ?? 0.92;
-		const buf = await $.canvasToBuffer(this, type, quality);
+		const buf = await $.canvasToBuffer(
+			this,
+			type,
+			quality,
+			options?.compressionLevel,
+			options?.effort,
+		);
 		return new NxBlob([buf], { type: normalizeImageMime(type) }) as Blob;
 	}
 
 	getContext(
 		contextId: '2d',
-		options?: any,
+		options?: CanvasRenderingContext2DSettings,
 	): OffscreenCanvasRenderingContext2D {
 		if (contextId !== '2d') {
 			throw new TypeError(
@@ -67,6 +76,10 @@ export class OffscreenCanvas
 				INTERNAL_SYMBOL,
 				this,
 			);
+			const threads = options?.rasterThreads;
+			if (typeof threads === 'number' && threads > 0) {
+				$.canvasSetRasterThreads(this, threads);
+			}
 		}
 		return i.context2d;
 	}
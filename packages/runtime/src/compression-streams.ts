@@ -1,15 +1,200 @@
-import { $ } from './$';
+import { $, type ZstdDictHandle } from './$';
 import { def } from './utils';
 import {
 	kNativeDecompressSetup,
 	type NativeFileSource,
 } from './polyfills/streams';
+import {
+	type CompressionDictionary,
+	dictionaryHandle,
+} from './switch/compression-dictionary';
 
 /**
  * Compression formats supported by {@link CompressionStream | `CompressionStream`} and {@link DecompressionStream | `DecompressionStream`}.
  */
 export type CompressionFormat = 'deflate' | 'deflate-raw' | 'gzip' | 'zstd';
 
+/**
+ * Match finding strategy: `'default'`, `'filtered'`, `'huffman-only'`,
+ * `'rle'` and `'fixed'` for the zlib formats (see zlib's `deflateInit2()`),
+ * `'fast'` through `'btultra2'` (fastest to strongest) for `'zstd'`.
+ */
+export type CompressionStrategy =
+	| 'default'
+	| 'filtered'
+	| 'huffman-only'
+	| 'rle'
+	| 'fixed'
+	| 'fast'
+	| 'dfast'
+	| 'greedy'
+	| 'lazy'
+	| 'lazy2'
+	| 'btlazy2'
+	| 'btopt'
+	| 'btultra'
+	| 'btultra2';
+
+/**
+ * Options for {@link CompressionStream | `CompressionStream`}. Omitted
+ * options keep the format's defaults, so the output of a stream without
+ * options does not change.
+ *
+ * > [!NOTE]
+ * > These options are specific to nx.js.
+ */
+export interface CompressionOptions {
+	/**
+	 * Compression level: `0` (store) to `9` for the zlib formats (default
+	 * `8`), `-131072` (fastest) to `22` for `'zstd'` (default `3`; levels
+	 * above `19` need a lot of memory).
+	 */
+	level?: number;
+	/**
+	 * Base 2 logarithm of the match window: `9` to `15` for the zlib formats
+	 * (default `15`), `10` to `31` for `'zstd'` (by default derived from the
+	 * level). A larger window finds matches further back, and needs as much
+	 * memory to decompress (see {@link DecompressionOptions.windowLog}).
+	 */
+	windowLog?: number;
+	/**
+	 * Match finding strategy (by default derived from the level for
+	 * `'zstd'`).
+	 */
+	strategy?: CompressionStrategy;
+	/**
+	 * `'zstd'` only: enables long distance matching, which finds repeats
+	 * far apart in large inputs (e.g. game assets), with a larger window.
+	 */
+	longDistanceMatching?: boolean;
+	/**
+	 * `'zstd'` only: number of worker threads which compress in parallel,
+	 * for large inputs (each worker handles jobs of several MiB). `0`, the
+	 * default, compresses on the thread pool thread of each write. Ignored
+	 * when zstd was built without multithreading.
+	 */
+	workers?: number;
+	/**
+	 * `'zstd'` only: a dictionary to compress with (which decompression
+	 * must use too). A dictionary determines the window and strategy for
+	 * its compression level, so `windowLog` and `strategy` are ignored.
+	 */
+	dictionary?: CompressionDictionary;
+}
+
+/**
+ * Options for {@link DecompressionStream | `DecompressionStream`}.
+ *
+ * > [!NOTE]
+ * > These options are specific to nx.js.
+ */
+export interface DecompressionOptions {
+	/**
+	 * Base 2 logarithm of the largest window to accept, which bounds the
+	 * memory used: `9` to `15` for the zlib formats (default `15`), `10` to
+	 * `31` for `'zstd'` (default `27`, 128 MiB). Data compressed with a
+	 * larger window fails to decompress.
+	 */
+	windowLog?: number;
+	/**
+	 * `'zstd'` only: the dictionary the data was compressed with.
+	 */
+	dictionary?: CompressionDictionary;
+}
+
+// In the order of zlib's Z_DEFAULT_STRATEGY (0) .. Z_FIXED (4).
+const ZLIB_STRATEGIES = ['default', 'filtered', 'huffman-only', 'rle', 'fixed'];
+// In the order of ZSTD_fast (1) .. ZSTD_btultra2 (9).
+const ZSTD_STRATEGIES = [
+	'fast',
+	'dfast',
+	'greedy',
+	'lazy',
+	'lazy2',
+	'btlazy2',
+	'btopt',
+	'btultra',
+	'btultra2',
+];
+
+function zstdOnly(
+	prefix: string,
+	format: CompressionFormat,
+	option: keyof CompressionOptions,
+) {
+	if (format !== 'zstd') {
+		throw new TypeError(
+			`${prefix}: The '${option}' option is only supported by the 'zstd' format.`,
+		);
+	}
+}
+
+function dictionaryOption(
+	prefix: string,
+	format: CompressionFormat,
+	dictionary?: CompressionDictionary,
+): ZstdDictHandle | undefined {
+	if (dictionary === undefined) return undefined;
+	zstdOnly(prefix, format, 'dictionary');
+	return dictionaryHandle(dictionary);
+}
+
+/**
+ * The native compression option arguments (following the format) for
+ * `options`. `prefix` starts error messages.
+ */
+export function compressArgs(
+	prefix: string,
+	format: CompressionFormat,
+	opts?: CompressionOptions,
+): [
+	level?: number,
+	windowLog?: number,
+	strategy?: number,
+	longDistanceMatching?: boolean,
+	workers?: number,
+	dictionary?: ZstdDictHandle,
+] {
+	if (!opts) return [];
+	let strategy: number | undefined;
+	if (opts.strategy !== undefined) {
+		const zstd = format === 'zstd';
+		strategy = (zstd ? ZSTD_STRATEGIES : ZLIB_STRATEGIES).indexOf(
+			opts.strategy,
+		);
+		if (strategy < 0) {
+			throw new TypeError(
+				`${prefix}: '${opts.strategy}' is not a valid strategy for the '${format}' format.`,
+			);
+		}
+		if (zstd) strategy++;
+	}
+	if (opts.longDistanceMatching !== undefined) {
+		zstdOnly(prefix, format, 'longDistanceMatching');
+	}
+	if (opts.workers !== undefined) zstdOnly(prefix, format, 'workers');
+	return [
+		opts.level,
+		opts.windowLog,
+		strategy,
+		opts.longDistanceMatching,
+		opts.workers,
+		dictionaryOption(prefix, format, opts.dictionary),
+	];
+}
+
+/**
+ * The native decompression option arguments (following the format).
+ */
+export function decompressArgs(
+	prefix: string,
+	format: CompressionFormat,
+	opts?: DecompressionOptions,
+): [windowLog: number | undefined, dictionary: ZstdDictHandle | undefined] {
+	if (!opts) return [undefined, undefined];
+	return [opts.windowLog, dictionaryOption(prefix, format, opts.dictionary)];
+}
+
 /**
  * @see https://developer.mozilla.org/docs/Web/API/CompressionStream
  */
@@ -17,8 +202,19 @@ export class CompressionStream
 	extends TransformStream<Uint8Array, Uint8Array>
 	implements globalThis.CompressionStream
 {
-	constructor(format: CompressionFormat) {
-		const h = $.compressNew(format);
+	/**
+	 * @param format The compression format.
+	 * @param options Compression settings (nx.js extension).
+	 */
+	constructor(format: CompressionFormat, options?: CompressionOptions) {
+		const h = $.compressNew(
+			format,
+			...compressArgs(
+				"Failed to construct 'CompressionStream'",
+				format,
+				options,
+			),
+		);
 		super({
 			async transform(chunk, controller) {
 				const b = await $.compressWrite(h, chunk);
@@ -42,8 +238,17 @@ export class DecompressionStream
 	extends TransformStream<Uint8Array, Uint8Array>
 	implements globalThis.DecompressionStream
 {
-	constructor(format: CompressionFormat) {
-		const h = $.decompressNew(format);
+	/**
+	 * @param format The compression format.
+	 * @param options Decompression settings (nx.js extension).
+	 */
+	constructor(format: CompressionFormat, options?: DecompressionOptions) {
+		const [windowLog, dictionary] = decompressArgs(
+			"Failed to construct 'DecompressionStream'",
+			format,
+			options,
+		);
+		const h = $.decompressNew(format, windowLog, dictionary);
 		super({
 			async transform(chunk, controller) {
 				const b = await $.decompressWrite(h, chunk);
@@ -81,7 +286,26 @@ export class DecompressionStream
 								src.start,
 								src.end,
 								outCap,
+								windowLog,
+								dictionary,
+							);
+						}
+						// A BYOB reader's view is decompressed into directly,
+						// so reading into the same buffer over and over
+						// allocates nothing per chunk.
+						const req = controller.byobRequest;
+						if (req?.view) {
+							const n = await $.decompressFilePull(
+								handle,
+								req.view,
 							);
+							if (n === null) {
+								controller.close();
+								req.respond(0);
+							} else {
+								req.respond(n);
+							}
+							return;
 						}
 						const b = await $.decompressFilePull(handle);
 						if (b === null) {
@@ -22,7 +22,11 @@ const _ = createInternal<Image, ImageInternal>();
  *
  *  - `jpg` - JPEG image data using [libjpeg-turbo](https://github.com/libjpeg-turbo/libjpeg-turbo)
  *  - `png` - PNG image data using [libpng](http://www.libpng.org/pub/png/libpng.html)
- *  - `webp` - WebP image data using [libpng](https://github.com/webmproject/libwebp)
+ *  - `webp` - WebP image data using [libwebp](https://github.com/webmproject/libwebp)
+ *  - `gif` - GIF image data
+ *
+ * Animated GIF, PNG (APNG) and WebP images draw their first frame. Use
+ * {@link Switch.AnimatedImage | `Switch.AnimatedImage`} to play the animation.
  *
  * @example
  *
@@ -199,12 +199,34 @@ export type * from './audio/audio-scheduled-source-node';
 import './audio/audio-buffer-source-node';
 export type * from './audio/audio-buffer-source-node';
 
+import './audio/audio-stream-source-node';
+export type * from './audio/audio-stream-source-node';
+
 import './audio/gain-node';
 export type * from './audio/gain-node';
 
 import './audio/stereo-panner-node';
 export type * from './audio/stereo-panner-node';
 
+import './audio/periodic-wave';
+export type * from './audio/periodic-wave';
+
+import './audio/oscillator-node';
+export type * from './audio/oscillator-node';
+
+import './audio/biquad-filter-node';
+export type * from './audio/biquad-filter-node';
+
+import './audio/delay-node';
+export type * from './audio/delay-node';
+
+import './audio/analyser-node';
+export type * from './audio/analyser-node';
+import './audio/convolver-node';
+export type * from './audio/convolver-node';
+import './audio/dynamics-compressor-node';
+export type * from './audio/dynamics-compressor-node';
+
 import './audio/audio-destination-node';
 export type * from './audio/audio-destination-node';
 
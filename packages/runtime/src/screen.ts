@@ -23,6 +23,23 @@ import {
 	registerConsoleScreen,
 } from './console-screen';
 
+/**
+ * Raster present statistics for the {@link Screen}, as returned by
+ * {@link Screen.getPresentStats | `screen.getPresentStats()`}.
+ */
+export interface ScreenPresentStats {
+	/** Number of frames presented since startup, including idle frames. */
+	frames: number;
+	/** Number of frames where nothing was drawn, so the present was skipped. */
+	idleFrames: number;
+	/** Total number of pixels copied to the framebuffer since startup. */
+	totalPixels: number;
+	/** Number of damaged rectangles copied in the most recent frame. */
+	lastRects: number;
+	/** Number of pixels copied in the most recent frame. */
+	lastPixels: number;
+}
+
 interface ScreenInternal {
 	context2d?: CanvasRenderingContext2D;
 	contextWebGL2?: WebGL2RenderingContext;
@@ -172,6 +189,24 @@ export class Screen extends EventTarget implements globalThis.Screen {
 		super.addEventListener(type, callback, options);
 	}
 
+	/**
+	 * Returns statistics about how the screen has been presented. When the
+	 * screen is rendered on the CPU (raster mode), only the regions that were
+	 * drawn to since the previous frame are copied to the display, and frames
+	 * where nothing was drawn skip the present entirely.
+	 *
+	 * The counters stay at zero when the screen is GPU-rendered.
+	 *
+	 * @example
+	 *
+	 * ```typescript
+	 * const { lastPixels, idleFrames } = screen.getPresentStats();
+	 * ```
+	 */
+	getPresentStats(): ScreenPresentStats {
+		return $.canvasPresentStats(this);
+	}
+
 	/**
 	 * Creates a {@link Blob} object representing the image contained on the screen.
 	 *
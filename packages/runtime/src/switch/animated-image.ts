@@ -0,0 +1,202 @@
+import {
+	$,
+	type AnimatedImageHandle,
+	type AnimatedImageMetadata,
+} from '../$';
+import { INTERNAL_SYMBOL } from '../internal';
+import { URL } from '../polyfills/url';
+import {
+	assertInternalConstructor,
+	bufferSourceToArrayBuffer,
+	createInternal,
+	proto,
+} from '../utils';
+
+export interface AnimatedImageInit {
+	/**
+	 * Number of decoded frames buffered ahead of presentation, `1` to `8`.
+	 * Each buffered frame costs `width * height * 4` bytes, independent of
+	 * how many frames the image contains.
+	 *
+	 * @default 3
+	 */
+	frames?: number;
+}
+
+interface AnimatedImageInternal {
+	metadata: AnimatedImageMetadata;
+}
+
+const _ = createInternal<AnimatedImage, AnimatedImageInternal>();
+
+function handleOf(a: AnimatedImage): AnimatedImageHandle {
+	return a as unknown as AnimatedImageHandle;
+}
+
+/**
+ * Plays an animated GIF, APNG or animated WebP image. Frames are decoded on
+ * demand in the background into a small ring of reusable buffers, so memory
+ * usage stays constant regardless of the number of frames. Disposal and
+ * blending are handled natively; each presented frame is complete.
+ *
+ * Call {@link AnimatedImage.update | `update()`} once per rendered frame to
+ * advance the animation according to the image's frame durations, then draw
+ * the `AnimatedImage` with {@link CanvasRenderingContext2D.drawImage | `ctx.drawImage()`}.
+ *
+ * (An animated image loaded with {@link Image | `Image`} draws only its first
+ * frame, as in web browsers.)
+ *
+ * @example
+ *
+ * ```typescript
+ * const ctx = screen.getContext('2d');
+ * const anim = await Switch.AnimatedImage.from('romfs:/cat.gif');
+ *
+ * requestAnimationFrame(function draw() {
+ * 	if (anim.update()) {
+ * 		ctx.clearRect(0, 0, screen.width, screen.height);
+ * 		ctx.drawImage(anim, 0, 0);
+ * 	}
+ * 	requestAnimationFrame(draw);
+ * });
+ * ```
+ */
+export class AnimatedImage {
+	/**
+	 * Loads and begins decoding an animated image.
+	 *
+	 * @param source URL / path of the image (fetched with `fetch()`), or its encoded bytes.
+	 * @param init Decoding options.
+	 */
+	static async from(
+		source: string | URL | Blob | BufferSource,
+		init: AnimatedImageInit = {},
+	): Promise<AnimatedImage> {
+		let data: ArrayBuffer;
+		if (typeof source === 'string' || source instanceof URL) {
+			const url = new URL(source, $.entrypoint);
+			const res = await globalThis.fetch(url);
+			if (!res.ok) {
+				throw new Error(`Failed to load image: ${res.status}`);
+			}
+			data = await res.arrayBuffer();
+		} else if (source instanceof Blob) {
+			data = await source.arrayBuffer();
+		} else {
+			data = bufferSourceToArrayBuffer(source);
+		}
+		// @ts-expect-error Internal constructor
+		const self = new AnimatedImage(INTERNAL_SYMBOL);
+		const metadata = await $.animImageLoad(
+			handleOf(self),
+			data,
+			init.frames,
+		);
+		_.set(self, { metadata });
+		return self;
+	}
+
+	/**
+	 * @private
+	 */
+	constructor() {
+		assertInternalConstructor(arguments);
+		return proto($.animImageNew(), AnimatedImage);
+	}
+
+	/**
+	 * Width of the image (the animation canvas), in pixels.
+	 */
+	get width(): number {
+		return _(this).metadata.width;
+	}
+
+	/**
+	 * Height of the image (the animation canvas), in pixels.
+	 */
+	get height(): number {
+		return _(this).metadata.height;
+	}
+
+	/**
+	 * Number of frames in one play of the animation.
+	 */
+	get frameCount(): number {
+		return _(this).metadata.frameCount;
+	}
+
+	/**
+	 * Number of times the animation plays before stopping on its last frame,
+	 * or `0` if it loops forever.
+	 */
+	get loopCount(): number {
+		return _(this).metadata.loopCount;
+	}
+
+	/**
+	 * Display duration of each frame, in milliseconds. As in web browsers,
+	 * durations of 10ms or less are played as 100ms.
+	 */
+	get durations(): readonly number[] {
+		return _(this).metadata.durations;
+	}
+
+	/**
+	 * Index of the frame currently presented.
+	 */
+	get frameIndex(): number {
+		return $.animImageState(handleOf(this)).frameIndex;
+	}
+
+	/**
+	 * Number of frames presented so far.
+	 */
+	get presentedFrames(): number {
+		return $.animImageState(handleOf(this)).presentedFrames;
+	}
+
+	/**
+	 * Number of frames skipped because `update()` was not called often
+	 * enough to present them.
+	 */
+	get droppedFrames(): number {
+		return $.animImageState(handleOf(this)).droppedFrames;
+	}
+
+	/**
+	 * `true` once the final frame of the final play has been presented.
+	 * Always `false` for an animation that loops forever.
+	 */
+	get ended(): boolean {
+		return $.animImageState(handleOf(this)).ended;
+	}
+
+	/**
+	 * Advances the animation to the frame due at `now`, and schedules
+	 * background decoding of the frames that follow.
+	 *
+	 * The first call presents frame `0`, and starts the animation clock.
+	 *
+	 * @param now Timestamp in milliseconds, on the same timeline as previous calls.
+	 * @returns `true` if a new frame was presented (i.e. the image should be redrawn).
+	 */
+	update(now = performance.now()): boolean {
+		return $.animImageTick(handleOf(this), now);
+	}
+
+	/**
+	 * Restarts the animation from its first frame on the next
+	 * {@link AnimatedImage.update | `update()`}.
+	 */
+	reset(): void {
+		$.animImageReset(handleOf(this));
+	}
+
+	/**
+	 * Releases the decoder and frame buffers. The image can no longer be
+	 * updated or drawn.
+	 */
+	close(): void {
+		$.animImageClose(handleOf(this));
+	}
+}
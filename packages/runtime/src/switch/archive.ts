@@ -0,0 +1,237 @@
+import { $, type ArchiveHandle } from '../$';
+import {
+	type CompressionFormat,
+	DecompressionStream,
+} from '../compression-streams';
+import { crypto } from '../crypto';
+import { file } from '../fs';
+import { INTERNAL_SYMBOL } from '../internal';
+import { URL } from '../polyfills/url';
+import {
+	assertInternalConstructor,
+	createInternal,
+	pathToString,
+} from '../utils';
+import type { PathLike } from '../switch';
+
+const genName = () => `a${crypto.randomUUID().replace(/-/g, '').slice(0, 16)}`;
+
+/**
+ * Information about a file within an {@link Archive | `Switch.Archive`}.
+ */
+export interface ArchiveEntry {
+	/** Path of the file within the archive (e.g. `"textures/grass.png"`). */
+	name: string;
+	/** Size of the file in bytes. */
+	size: number;
+	/** Size of the file as stored in the archive, in bytes. */
+	compressedSize: number;
+	/** Modification time of the file, in milliseconds since the epoch. */
+	lastModified: number;
+}
+
+interface ArchiveInternal {
+	handle: ArchiveHandle;
+	path: string;
+	type: 'zip' | 'tar';
+}
+
+const _ = createInternal<Archive, ArchiveInternal>();
+
+/**
+ * A ZIP or tar archive, read in place without extracting it.
+ *
+ * Opening an archive reads its index once (the ZIP central directory, or
+ * the tar headers) on the thread pool. From then on, files are found by name
+ * in constant time, and read from a single open file handle: for an asset
+ * pack of thousands of small files, that is much faster than loose files on
+ * the SD card, where every open is a path lookup. Compressed files (ZIP
+ * "deflate", or "zstd") are decompressed natively.
+ *
+ * An archive can also be {@link Archive.mount | mounted}, after which
+ * {@link readFile | `Switch.readFile()`} and `import()` can read its files by
+ * URL.
+ *
+ * > [!NOTE]
+ * > This class is specific to nx.js.
+ *
+ * @example
+ *
+ * ```typescript
+ * const pack = await Switch.Archive.open('sdmc:/switch/awesome-app/assets.zip');
+ * const data = await pack.read('levels/level1.json');
+ * const level = JSON.parse(new TextDecoder().decode(data));
+ * ```
+ */
+export class Archive {
+	/**
+	 * The URL of the archive's mount, or `null` when not mounted.
+	 */
+	declare url: URL | null;
+
+	/**
+	 * @private
+	 */
+	constructor() {
+		assertInternalConstructor(arguments);
+		this.url = null;
+	}
+
+	/**
+	 * Opens the ZIP or tar archive at `path`, and reads its index.
+	 *
+	 * Rejects with a `TypeError` if the file is not a ZIP or tar archive.
+	 *
+	 * @param path Path of the archive file.
+	 */
+	static async open(path: PathLike): Promise<Archive> {
+		const p = pathToString(path);
+		const [handle, type] = await $.archiveOpen(p);
+		// @ts-expect-error internal constructor
+		const archive = new Archive(INTERNAL_SYMBOL);
+		_.set(archive, { handle, path: p, type });
+		return archive;
+	}
+
+	/**
+	 * Path of the archive file.
+	 */
+	get path(): string {
+		return _(this).path;
+	}
+
+	/**
+	 * The archive format: `"zip"` or `"tar"`.
+	 */
+	get type(): 'zip' | 'tar' {
+		return _(this).type;
+	}
+
+	/**
+	 * Returns the path of every file in the archive, in the order they are
+	 * stored. Directories are not included.
+	 */
+	names(): string[] {
+		return $.archiveNames(_(this).handle);
+	}
+
+	/**
+	 * Returns information about the file `name`, or `null` if the archive has
+	 * no such file.
+	 *
+	 * @param name Path of the file within the archive.
+	 */
+	get(name: string): ArchiveEntry | null {
+		const e = $.archiveEntry(_(this).handle, name);
+		if (!e) return null;
+		return { name, size: e[0], compressedSize: e[1], lastModified: e[2] };
+	}
+
+	/**
+	 * Returns a Promise which resolves to an `ArrayBuffer` containing the
+	 * contents of the file `name`, or `null` if the archive has no such file.
+	 *
+	 * The file is read and decompressed on the thread pool, and checked
+	 * against the CRC-32 recorded in ZIP archives. Files which are corrupt,
+	 * encrypted, or compressed with another method than "deflate" or "zstd"
+	 * reject with a `TypeError`.
+	 *
+	 * @param name Path of the file within the archive.
+	 */
+	read(name: string): Promise<ArrayBuffer | null> {
+		return $.archiveRead(_(this).handle, name);
+	}
+
+	/**
+	 * Synchronously returns an `ArrayBuffer` containing the contents of the
+	 * file `name`, or `null` if the archive has no such file.
+	 *
+	 * @param name Path of the file within the archive.
+	 */
+	readSync(name: string): ArrayBuffer | null {
+		return $.archiveReadSync(_(this).handle, name);
+	}
+
+	/**
+	 * Returns a `ReadableStream` of the contents of the file `name`, for files
+	 * too large to read in one piece. Compressed files are decompressed as
+	 * they are read, by a single native operation per chunk (as with a
+	 * {@link FsFile | `Switch.FsFile`} stream piped through a
+	 * `DecompressionStream`). Unlike {@link Archive.read | `read()`}, streamed
+	 * files are not checked against their CRC-32.
+	 *
+	 * The stream errors with a `TypeError` if the archive has no such file.
+	 *
+	 * @param name Path of the file within the archive.
+	 */
+	stream(name: string): ReadableStream<Uint8Array> {
+		const { handle, path } = _(this);
+		let reader: ReadableStreamDefaultReader<Uint8Array>;
+		return new ReadableStream<Uint8Array>({
+			async start() {
+				const location = await $.archiveLocate(handle, name);
+				if (!location) {
+					throw new TypeError(
+						`Failed to execute 'stream' on 'Archive': No file named "${name}"`,
+					);
+				}
+				const [start, end, format] = location;
+				let source = file(path).slice(start, end).stream();
+				if (format) {
+					source = source.pipeThrough(
+						new DecompressionStream(format as CompressionFormat),
+					);
+				}
+				reader = source.getReader();
+			},
+			async pull(controller) {
+				const { done, value } = await reader.read();
+				if (done) {
+					controller.close();
+				} else {
+					controller.enqueue(value);
+				}
+			},
+			cancel(reason) {
+				return reader?.cancel(reason);
+			},
+		});
+	}
+
+	/**
+	 * Mounts the archive as a read-only file system, so that its files can be
+	 * read by URL: with {@link readFile | `Switch.readFile()`} /
+	 * {@link readFileSync | `Switch.readFileSync()`}, and by the module
+	 * loader, for `import` of scripts stored in the archive.
+	 * Other file system functions, such as {@link stat | `Switch.stat()`} and
+	 * {@link readDir | `Switch.readDir()`}, do not see mounted archives.
+	 *
+	 * The mount stays in place until {@link Archive.unmount | `unmount()`} is
+	 * called, even if the `Archive` object itself is no longer referenced.
+	 * Mounting again replaces the previous mount.
+	 *
+	 * @example
+	 *
+	 * ```typescript
+	 * const mod = await Switch.Archive.open('sdmc:/switch/awesome-app/mod.zip');
+	 * const url = mod.mount('mod');
+	 * const { init } = await import(new URL('main.js', url).href);
+	 * const icon = await Switch.readFile('mod:/icon.png');
+	 * ```
+	 *
+	 * @param name The name of the mount for file paths. By default, a random name is generated. Should not exceed 31 characters, and should not have a trailing colon. Like URL schemes, names are case-insensitive, and the returned URL uses the lowercase name. Names the runtime already uses (`sdmc`, `romfs`, `nxjs`, `file`, and mounted save data) are rejected.
+	 */
+	mount(name = genName()): URL {
+		$.archiveMount(_(this).handle, name);
+		this.url = new URL(`${name}:/`);
+		return this.url;
+	}
+
+	/**
+	 * Removes the archive's mount, if any.
+	 */
+	unmount(): void {
+		$.archiveUnmount(_(this).handle);
+		this.url = null;
+	}
+}
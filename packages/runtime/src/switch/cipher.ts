@@ -0,0 +1,151 @@
+import { $, type CipherHandle } from '../$';
+import type { CryptoKey } from '../crypto';
+import { DOMException } from '../dom-exception';
+import type {
+	AesCbcParams,
+	AesCtrParams,
+	AesGcmParams,
+	BufferSource,
+} from '../types';
+import { createInternal, pathToString } from '../utils';
+import type { PathLike } from '../switch';
+
+/**
+ * Parameters of a {@link Cipher | `Switch.Cipher`}: the same as for
+ * `crypto.subtle.encrypt()` / `decrypt()` with an AES-CBC, AES-CTR or AES-GCM
+ * key.
+ */
+export type CipherAlgorithm = AesCbcParams | AesCtrParams | AesGcmParams;
+
+const _ = createInternal<Cipher, CipherHandle>();
+
+/**
+ * Encrypts or decrypts data with AES (CBC, CTR or GCM mode) one chunk at a
+ * time, producing the same output as `crypto.subtle.encrypt()` /
+ * `decrypt()` does for the whole data: for files and streams too large to
+ * hold in memory at once.
+ *
+ * The cipher sets up its AES context once, and keeps its state from one
+ * {@link Cipher.update | `update()`} to the next. Each chunk is processed on
+ * the thread pool, into a new `ArrayBuffer` or directly into a buffer
+ * supplied by the caller (which may be the input itself, to encrypt in
+ * place). {@link Cipher.final | `final()`} then returns the last bytes:
+ * the padding for AES-CBC, and the authentication tag for AES-GCM.
+ *
+ * For AES-CBC and AES-GCM, `update()` returns whole 16-byte blocks only, and
+ * when decrypting it holds back the last block (AES-CBC) or the tag
+ * (AES-GCM) until `final()`, which checks them. A decrypting AES-GCM cipher
+ * therefore returns plaintext before it has been authenticated: it must not
+ * be used until `final()` has succeeded.
+ *
+ * Each call must complete before the next one is made on the same cipher,
+ * and a cipher cannot be used again after `final()`.
+ *
+ * > [!NOTE]
+ * > This class is specific to nx.js.
+ *
+ * @example
+ *
+ * ```typescript
+ * const cipher = new Switch.Cipher('encrypt', { name: 'AES-GCM', iv }, key);
+ * for await (const chunk of stream) {
+ * 	await writer.write(new Uint8Array(await cipher.update(chunk)));
+ * }
+ * await writer.write(new Uint8Array(cipher.final()));
+ * ```
+ */
+export class Cipher {
+	/**
+	 * @param mode Whether to encrypt or decrypt.
+	 * @param algorithm The AES mode and its parameters (`iv`, or `counter`), as for `crypto.subtle.encrypt()`.
+	 * @param key An AES-CBC, AES-CTR or AES-GCM key, with the `"encrypt"` or `"decrypt"` usage.
+	 */
+	constructor(
+		mode: 'encrypt' | 'decrypt',
+		algorithm: CipherAlgorithm,
+		key: CryptoKey<any>,
+	) {
+		const name = String(algorithm.name).toUpperCase();
+		if (name !== key.algorithm.name) {
+			throw new DOMException(
+				`The key is not an ${name} key`,
+				'InvalidAccessError',
+			);
+		}
+		_.set(this, $.cryptoCipherNew(mode === 'encrypt', algorithm, key));
+	}
+
+	/**
+	 * Processes the next chunk of data, and returns a Promise which resolves
+	 * to the output it completes, in a new `ArrayBuffer`.
+	 *
+	 * @param data The next chunk of plaintext (or ciphertext, when decrypting).
+	 */
+	update(data: BufferSource): Promise<ArrayBuffer>;
+	/**
+	 * Processes the next chunk of data, writing the output it completes into
+	 * `output`, and returns a Promise which resolves to the number of bytes
+	 * written.
+	 *
+	 * The output of a chunk is at most 15 bytes longer than the chunk itself
+	 * (and exactly as long, for AES-CTR). `output` may be `data` itself, or
+	 * overlap it, to encrypt or decrypt in place. Rejects with a `RangeError`
+	 * if `output` is too small.
+	 *
+	 * @param data The next chunk of plaintext (or ciphertext, when decrypting).
+	 * @param output The buffer to write the output to.
+	 */
+	update(data: BufferSource, output: BufferSource): Promise<number>;
+	update(
+		data: BufferSource,
+		output?: BufferSource,
+	): Promise<ArrayBuffer | number> {
+		return $.cryptoCipherUpdate(_(this), data, output);
+	}
+
+	/**
+	 * Processes the data held back by previous calls to
+	 * {@link Cipher.update | `update()`}, and returns the rest of the output:
+	 *
+	 * - AES-CBC: the last block, padded (encrypt), or the last block without
+	 *   its padding (decrypt).
+	 * - AES-GCM: the last partial block, followed by the authentication tag
+	 *   (encrypt), or the last partial block (decrypt).
+	 * - AES-CTR: an empty `ArrayBuffer`.
+	 *
+	 * When decrypting, throws an `Error` if the data is truncated, incorrectly
+	 * padded, or does not match its authentication tag.
+	 */
+	final(): ArrayBuffer {
+		return $.cryptoCipherFinal(_(this));
+	}
+
+	/**
+	 * Encrypts or decrypts the whole file `source` into the file
+	 * `destination` (created, or truncated), including the
+	 * {@link Cipher.final | `final()`} step, and returns a Promise which
+	 * resolves to the number of bytes written.
+	 *
+	 * The file is read, processed and written in 1 MiB chunks within a single
+	 * thread pool operation, so memory use does not depend on its size. If
+	 * it fails (including a failed AES-GCM authentication), `destination` is
+	 * removed, leaving no partial or unauthenticated output behind.
+	 *
+	 * @example
+	 *
+	 * ```typescript
+	 * const cipher = new Switch.Cipher('decrypt', { name: 'AES-CTR', counter, length: 64 }, key);
+	 * await cipher.pipeFile('sdmc:/switch/awesome-app/assets.enc', 'sdmc:/switch/awesome-app/assets.zip');
+	 * ```
+	 *
+	 * @param source Path of the file to read.
+	 * @param destination Path of the file to write.
+	 */
+	pipeFile(source: PathLike, destination: PathLike): Promise<number> {
+		return $.cryptoCipherFile(
+			_(this),
+			pathToString(source),
+			pathToString(destination),
+		);
+	}
+}
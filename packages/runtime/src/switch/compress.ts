@@ -0,0 +1,159 @@
+import { $ } from '../$';
+import {
+	type CompressionFormat,
+	type CompressionOptions,
+	type DecompressionOptions,
+	compressArgs,
+	decompressArgs,
+} from '../compression-streams';
+
+export interface DecompressOptions extends DecompressionOptions {
+	/**
+	 * Largest decompressed size accepted, in bytes: larger output rejects
+	 * with a `RangeError` (guarding against "decompression bombs"). Unlimited
+	 * by default.
+	 */
+	maxOutputSize?: number;
+}
+
+/**
+ * Inputs smaller than this (in bytes) are processed synchronously by
+ * {@link compress | `compress()`} and {@link decompress | `decompress()`}:
+ * for them, a thread pool round trip costs more than the work itself.
+ */
+const SYNC_THRESHOLD = 4 * 1024;
+
+/**
+ * Compresses `data` in one call, and returns a Promise which resolves to an
+ * `ArrayBuffer` of the compressed data.
+ *
+ * Unlike piping through a {@link CompressionStream | `CompressionStream`},
+ * the whole input is compressed in a single pass on one thread pool worker,
+ * into an output buffer allocated once (inputs under 4 KiB are compressed
+ * right away, without the thread pool). A zstd result records its size, so
+ * that {@link decompress | `decompress()`} can allocate its output exactly.
+ *
+ * @example
+ *
+ * ```typescript
+ * const state = new TextEncoder().encode(JSON.stringify(gameState));
+ * const compressed = await Switch.compress(state, 'zstd', { level: 9 });
+ * Switch.writeFileSync('sdmc:/switch/awesome-app/state.zst', compressed);
+ * ```
+ *
+ * @param data The data to compress.
+ * @param format The compression format.
+ * @param options Compression settings.
+ */
+export function compress(
+	data: BufferSource,
+	format: CompressionFormat,
+	options?: CompressionOptions,
+): Promise<ArrayBuffer> {
+	try {
+		const args = compressArgs(
+			"Failed to execute 'compress'",
+			format,
+			options,
+		);
+		if (data.byteLength < SYNC_THRESHOLD) {
+			return Promise.resolve($.compressSync(data, format, ...args));
+		}
+		return $.compress(data, format, ...args);
+	} catch (err) {
+		return Promise.reject(err);
+	}
+}
+
+/**
+ * Synchronously compresses `data`, and returns an `ArrayBuffer` of the
+ * compressed data. Compressing blocks the main thread, so prefer
+ * {@link compress | `compress()`} for anything but small inputs.
+ *
+ * @param data The data to compress.
+ * @param format The compression format.
+ * @param options Compression settings.
+ */
+export function compressSync(
+	data: BufferSource,
+	format: CompressionFormat,
+	options?: CompressionOptions,
+): ArrayBuffer {
+	return $.compressSync(
+		data,
+		format,
+		...compressArgs("Failed to execute 'compressSync'", format, options),
+	);
+}
+
+/**
+ * Decompresses `data` (complete compressed data, such as the contents of a
+ * `.gz` or `.zst` file) in one call, and returns a Promise which resolves to
+ * an `ArrayBuffer` of the decompressed data.
+ *
+ * Unlike piping through a {@link DecompressionStream | `DecompressionStream`},
+ * this takes a single thread pool dispatch (none for inputs under 4 KiB).
+ * zstd data whose frames record their size (as those written by
+ * {@link compress | `compress()`} or the `zstd` command do) is decompressed
+ * in one pass, straight into an exactly sized buffer.
+ *
+ * Truncated or corrupt data, or trailing bytes after the compressed data,
+ * reject with a `TypeError`.
+ *
+ * @example
+ *
+ * ```typescript
+ * const data = await Switch.readFile('romfs:/level1.json.zst');
+ * const level = JSON.parse(
+ * 	new TextDecoder().decode(await Switch.decompress(data, 'zstd')),
+ * );
+ * ```
+ *
+ * @param data The data to decompress.
+ * @param format The compression format.
+ * @param options Decompression settings.
+ */
+export function decompress(
+	data: BufferSource,
+	format: CompressionFormat,
+	options?: DecompressOptions,
+): Promise<ArrayBuffer> {
+	try {
+		const args = decompressArgs(
+			"Failed to execute 'decompress'",
+			format,
+			options,
+		);
+		const max = options?.maxOutputSize;
+		if (data.byteLength < SYNC_THRESHOLD) {
+			return Promise.resolve(
+				$.decompressSync(data, format, ...args, max),
+			);
+		}
+		return $.decompress(data, format, ...args, max);
+	} catch (err) {
+		return Promise.reject(err);
+	}
+}
+
+/**
+ * Synchronously decompresses `data`, and returns an `ArrayBuffer` of the
+ * decompressed data. Decompressing blocks the main thread, so prefer
+ * {@link decompress | `decompress()`} for anything but small inputs.
+ *
+ * @param data The data to decompress.
+ * @param format The compression format.
+ * @param options Decompression settings.
+ */
+export function decompressSync(
+	data: BufferSource,
+	format: CompressionFormat,
+	options?: DecompressOptions,
+): ArrayBuffer {
+	const args = decompressArgs(
+		"Failed to execute 'decompressSync'",
+		format,
+		options,
+	);
+	return $.decompressSync(data, format, ...args, options?.maxOutputSize);
+}
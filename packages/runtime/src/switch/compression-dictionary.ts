@@ -0,0 +1,76 @@
+import { $, type ZstdDictHandle } from '../$';
+import { createInternal } from '../utils';
+
+interface CompressionDictionaryInternal {
+	handle: ZstdDictHandle;
+	id: number;
+	byteLength: number;
+}
+
+const _ = createInternal<
+	CompressionDictionary,
+	CompressionDictionaryInternal
+>();
+
+// Not re-exported from the `Switch` namespace.
+export function dictionaryHandle(dict: CompressionDictionary): ZstdDictHandle {
+	return _(dict).handle;
+}
+
+/**
+ * A zstd dictionary, for the `dictionary` option of
+ * {@link CompressionStream | `CompressionStream`} and
+ * {@link DecompressionStream | `DecompressionStream`}.
+ *
+ * Small payloads (JSON messages, save records, network packets) compress
+ * poorly on their own, since each one starts with no history to match
+ * against. A dictionary trained on typical samples (e.g. with
+ * `zstd --train`) supplies that history, and can also be raw content (any
+ * bytes which the data is likely to repeat). Data must be decompressed with
+ * the same dictionary it was compressed with.
+ *
+ * The dictionary is loaded once, and shared by every stream which uses it:
+ * its prepared form is built the first time it is used at each compression
+ * level, and reused from then on.
+ *
+ * > [!NOTE]
+ * > This class is specific to nx.js.
+ *
+ * @example
+ *
+ * ```typescript
+ * const data = Switch.readFileSync('romfs:/messages.dict');
+ * const dictionary = new Switch.CompressionDictionary(data);
+ *
+ * const compressed = new Response(
+ * 	new Blob([message]).stream().pipeThrough(
+ * 		new CompressionStream('zstd', { level: 19, dictionary }),
+ * 	),
+ * );
+ * ```
+ */
+export class CompressionDictionary {
+	/**
+	 * @param data The dictionary (it is copied).
+	 */
+	constructor(data: BufferSource) {
+		const [handle, id] = $.zstdDictNew(data);
+		_.set(this, { handle, id, byteLength: data.byteLength });
+	}
+
+	/**
+	 * The dictionary ID stored in trained dictionaries, which zstd also
+	 * records in each frame compressed with it. `0` for a raw content
+	 * dictionary.
+	 */
+	get id(): number {
+		return _(this).id;
+	}
+
+	/**
+	 * Size of the dictionary in bytes.
+	 */
+	get byteLength(): number {
+		return _(this).byteLength;
+	}
+}
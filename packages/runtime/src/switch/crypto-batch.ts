@@ -0,0 +1,85 @@
+import { $ } from '../$';
+import type { CryptoKey } from '../crypto';
+import type { AlgorithmIdentifier, BufferSource, EcdsaParams } from '../types';
+
+/**
+ * Verifies many signatures at once, and returns a Promise which resolves to
+ * an Array of the results: `true` for each signature which is valid for its
+ * data, in the order given.
+ *
+ * The result of each item is the same as that of
+ * `crypto.subtle.verify(algorithm, key, signature, data)`, but the whole batch
+ * is one operation: the items are spread across every thread pool worker,
+ * and settle a single Promise. Verifying a few hundred signatures (e.g. the
+ * blocks of a downloaded update) this way avoids a Promise and a thread pool
+ * round trip per signature.
+ *
+ * Rejects if any item cannot be verified at all (as opposed to having an
+ * invalid signature), for example because a key does not have the
+ * `"verify"` usage.
+ *
+ * > [!NOTE]
+ * > This function is specific to nx.js.
+ *
+ * @example
+ *
+ * ```typescript
+ * const results = await Switch.verifyBatch(
+ * 	{ name: 'ECDSA', hash: 'SHA-256' },
+ * 	publicKey,
+ * 	blocks.map((b) => b.signature),
+ * 	blocks.map((b) => b.data),
+ * );
+ * if (results.includes(false)) {
+ * 	throw new Error('Corrupt update');
+ * }
+ * ```
+ *
+ * @param algorithm The signature algorithm and its parameters, as for `crypto.subtle.verify()`.
+ * @param key The key to verify every item with, or an Array of one key per item.
+ * @param signatures The signature of each item.
+ * @param data The data of each item.
+ */
+export async function verifyBatch(
+	algorithm: AlgorithmIdentifier | RsaPssParams | EcdsaParams,
+	key: CryptoKey<any> | CryptoKey<any>[],
+	signatures: BufferSource[],
+	data: BufferSource[],
+): Promise<boolean[]> {
+	return $.cryptoVerifyBatch(
+		typeof algorithm === 'string' ? { name: algorithm } : algorithm,
+		key,
+		signatures,
+		data,
+	);
+}
+
+/**
+ * Computes the digest of each of many buffers at once, and returns a Promise
+ * which resolves to an Array of the digests, in the order given.
+ *
+ * Each digest is the same as that of `crypto.subtle.digest(algorithm, data)`,
+ * but the whole batch is one operation: the buffers are spread across every
+ * thread pool worker, and settle a single Promise.
+ *
+ * > [!NOTE]
+ * > This function is specific to nx.js.
+ *
+ * @example
+ *
+ * ```typescript
+ * const hashes = await Switch.digestBatch('SHA-256', chunks);
+ * ```
+ *
+ * @param algorithm The hash function: `"SHA-1"`, `"SHA-256"`, `"SHA-384"` or `"SHA-512"`.
+ * @param data The buffers to digest.
+ */
+export async function digestBatch(
+	algorithm: AlgorithmIdentifier,
+	data: BufferSource[],
+): Promise<ArrayBuffer[]> {
+	return $.cryptoDigestBatch(
+		typeof algorithm === 'string' ? algorithm : algorithm.name,
+		data,
+	);
+}
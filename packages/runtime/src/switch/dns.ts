@@ -3,12 +3,59 @@ import { $ } from '../$';
 /**
  * Performs a DNS lookup to resolve a hostname to an array of IP addresses.
  *
+ * Results are cached: for the TTL of the records when looked up with the
+ * servers set by {@link setDnsServers | `Switch.setDnsServers()`}, or for one
+ * minute with the system resolver. A name which does not exist is cached as
+ * such for a short time (the TTL given by its domain's server, or 10
+ * seconds). Concurrent lookups of the same name share a single query, and
+ * an IP address resolves to itself without any lookup.
+ *
  * @example
  *
  * ```typescript
  * const ipAddresses = await Switch.resolveDns('example.com');
  * ```
  */
-export function resolveDns(hostname: string) {
+export function resolveDns(hostname: string): Promise<string[]> {
 	return $.dnsResolve(hostname);
 }
+
+/**
+ * Sets the DNS servers which {@link resolveDns | `Switch.resolveDns()`} (and
+ * so `fetch()`, `WebSocket` and `Switch.connect()`) send
+ * queries to, and clears the DNS cache.
+ *
+ * With servers set, each lookup sends its A and AAAA queries at once, over
+ * UDP, from the event loop: no thread pool worker is occupied while waiting
+ * for the answers. The servers are tried in order, each for up to 2
+ * seconds; if none answers (or an answer is too large for UDP), the lookup
+ * falls back to the system resolver. An empty array (the default) uses the
+ * system resolver for every lookup.
+ *
+ * > [!NOTE]
+ * > This function is specific to nx.js.
+ *
+ * @example
+ *
+ * ```typescript
+ * // The DNS servers of the current network connection
+ * const { primaryDnsServer, secondaryDnsServer } = Switch.networkInfo();
+ * Switch.setDnsServers([primaryDnsServer, secondaryDnsServer]);
+ * ```
+ *
+ * @param servers Up to 4 IPv4 addresses, each optionally followed by `:port` (default `53`).
+ */
+export function setDnsServers(servers: string[]): void {
+	$.dnsSetServers(servers);
+}
+
+/**
+ * Clears the DNS cache of {@link resolveDns | `Switch.resolveDns()`}, for
+ * example after the network connection has changed.
+ *
+ * > [!NOTE]
+ * > This function is specific to nx.js.
+ */
+export function clearDnsCache(): void {
+	$.dnsClearCache();
+}
@@ -0,0 +1,118 @@
+import { $ } from '../$';
+import type { OffscreenCanvas } from '../canvas/offscreen-canvas';
+import type { Screen } from '../screen';
+import type { ImageEncodeOptions } from '../types';
+import { createInternal, normalizeImageMime, proto } from '../utils';
+
+export interface FrameEncoderInit extends ImageEncodeOptions {
+	/**
+	 * Number of frames that may be in flight (and alive) at once, `1` to `8`.
+	 * A frame returned by {@link FrameEncoder.encode | `encode()`} stays valid
+	 * until this many further frames have been encoded.
+	 *
+	 * @default 2
+	 */
+	frames?: number;
+}
+
+interface FrameEncoderInternal {
+	canvas: Screen | OffscreenCanvas;
+	type: string;
+	encoded: number;
+	dropped: number;
+}
+
+const _ = createInternal<FrameEncoder, FrameEncoderInternal>();
+
+/**
+ * Encodes successive frames of a canvas (or the `screen`) into PNG, JPEG or
+ * WebP images at steady memory usage, for screenshots, time-lapses and video
+ * capture. Snapshot and output buffers are allocated once and reused for
+ * every frame, and encoding runs off the main thread.
+ *
+ * Each encoded frame is a view into a reused buffer: it remains valid until
+ * `frames` further frames have been encoded, after which it is detached
+ * (its `byteLength` becomes `0`). Copy it (or finish writing it) before then.
+ *
+ * With `type: 'image/jpeg'`, the concatenated frames form an MJPEG stream.
+ *
+ * @example
+ *
+ * ```typescript
+ * const encoder = new Switch.FrameEncoder(screen, {
+ * 	type: 'image/jpeg',
+ * 	quality: 0.8,
+ * });
+ * const out = Switch.file('sdmc:/capture.mjpeg').writable.getWriter();
+ *
+ * requestAnimationFrame(async function capture() {
+ * 	const frame = await encoder.encode();
+ * 	if (frame) await out.write(frame);
+ * 	requestAnimationFrame(capture);
+ * });
+ * ```
+ */
+export class FrameEncoder {
+	/**
+	 * @param canvas The canvas (or `screen`) whose frames will be encoded.
+	 * @param opts Output format and encoder settings.
+	 */
+	constructor(canvas: Screen | OffscreenCanvas, opts: FrameEncoderInit = {}) {
+		const self = proto(
+			$.frameEncoderNew(
+				opts.type,
+				opts.quality,
+				opts.compressionLevel,
+				opts.effort,
+				opts.frames,
+			),
+			FrameEncoder,
+		);
+		_.set(self, {
+			canvas,
+			type: normalizeImageMime(opts.type),
+			encoded: 0,
+			dropped: 0,
+		});
+		return self;
+	}
+
+	/**
+	 * The MIME type of the encoded frames.
+	 */
+	get type(): string {
+		return _(this).type;
+	}
+
+	/**
+	 * Number of frames encoded so far.
+	 */
+	get encoded(): number {
+		return _(this).encoded;
+	}
+
+	/**
+	 * Number of frames dropped because every slot was still encoding.
+	 */
+	get dropped(): number {
+		return _(this).dropped;
+	}
+
+	/**
+	 * Captures the canvas's current pixels and encodes them in the background.
+	 *
+	 * Resolves with the encoded image, or with `null` if the frame was dropped
+	 * because `frames` earlier frames are still being encoded.
+	 */
+	async encode(): Promise<Uint8Array | null> {
+		const i = _(this);
+		const pending = $.frameEncoderEncode(this, i.canvas);
+		if (!pending) {
+			i.dropped++;
+			return null;
+		}
+		const buf = await pending;
+		i.encoded++;
+		return new Uint8Array(buf);
+	}
+}
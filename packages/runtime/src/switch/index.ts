@@ -12,22 +12,34 @@ import { pathToString } from '../utils';
 import { Env } from './env';
 
 export * from '../fs';
-export type { DatagramEventInit, DatagramOptions } from '../udp';
+export type {
+	Datagram,
+	DatagramEventInit,
+	DatagramOptions,
+} from '../udp';
 export {
 	DatagramEvent,
 	DatagramSocket,
 	listenDatagram,
 } from '../udp';
 export * from './album';
+export * from './animated-image';
+export * from './archive';
+export * from './cipher';
+export * from './compress';
+export { CompressionDictionary } from './compression-dictionary';
+export * from './crypto-batch';
 export * from './dns';
 export * from './env';
 export * from './file-system';
+export * from './frame-encoder';
 export * from './inspect';
 export * from './irsensor';
 export * from './nifm';
 export * from './ns';
 export * from './profile';
 export * from './savedata';
+export * from './seekable-zstd';
 export * from './service';
 export { Socket, Server };
 export { WebApplet, type WebAppletOptions } from '../web-applet';
@@ -179,6 +191,8 @@ export interface NetworkInfo {
 	ip: string;
 	subnetMask: string;
 	gateway: string;
+	primaryDnsServer: string;
+	secondaryDnsServer: string;
 }
 
 /**
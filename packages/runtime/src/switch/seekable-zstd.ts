@@ -0,0 +1,183 @@
+import { $, type ZstdSeekableHandle } from '../$';
+import { INTERNAL_SYMBOL } from '../internal';
+import {
+	assertInternalConstructor,
+	createInternal,
+	pathToString,
+} from '../utils';
+import type { PathLike } from '../switch';
+
+/**
+ * Options for {@link SeekableCompressionStream | `Switch.SeekableCompressionStream`}.
+ */
+export interface SeekableCompressionOptions {
+	/**
+	 * zstd compression level, `-131072` (fastest) to `22` (default `3`).
+	 */
+	level?: number;
+	/**
+	 * Decompressed size of each frame, in bytes, up to 1 GiB (default 1 MiB).
+	 * A read decompresses whole frames, so smaller frames make small random
+	 * reads cheaper, at the cost of a lower compression ratio.
+	 */
+	frameSize?: number;
+}
+
+/**
+ * Compresses a stream in the zstd
+ * [seekable format](https://github.com/facebook/zstd/tree/dev/contrib/seekable_format):
+ * independently compressed frames of `frameSize` bytes, followed by a seek
+ * table, from which a {@link SeekableReader | `Switch.SeekableReader`} can
+ * read any range of the data by decompressing only the frames it spans.
+ *
+ * The output is also regular zstd data: any zstd decoder (including
+ * `DecompressionStream('zstd')`) decompresses it whole, skipping the seek
+ * table.
+ *
+ * > [!NOTE]
+ * > This class is specific to nx.js.
+ *
+ * @example
+ *
+ * ```typescript
+ * await Switch.file('sdmc:/switch/awesome-app/level1.bin')
+ * 	.stream()
+ * 	.pipeThrough(new Switch.SeekableCompressionStream({ frameSize: 256 * 1024 }))
+ * 	.pipeTo(Switch.file('sdmc:/switch/awesome-app/level1.bin.zst').writable);
+ * ```
+ */
+export class SeekableCompressionStream extends TransformStream<
+	Uint8Array,
+	Uint8Array
+> {
+	/**
+	 * @param options Compression settings.
+	 */
+	constructor(options?: SeekableCompressionOptions) {
+		const h = $.zstdSeekableWriterNew(options?.level, options?.frameSize);
+		super({
+			async transform(chunk, controller) {
+				const b = await $.zstdSeekableWriterWrite(h, chunk);
+				if (b.byteLength) {
+					controller.enqueue(new Uint8Array(b));
+				}
+			},
+			async flush(controller) {
+				const b = await $.zstdSeekableWriterEnd(h);
+				controller.enqueue(new Uint8Array(b));
+			},
+		});
+	}
+}
+
+/**
+ * Options for {@link SeekableReader.open | `Switch.SeekableReader.open()`}.
+ */
+export interface SeekableReaderOptions {
+	/**
+	 * Largest total size of decompressed frames kept in memory for reuse by
+	 * later reads, in bytes (default 8 MiB). `0` disables the cache.
+	 */
+	cacheSize?: number;
+}
+
+interface SeekableReaderInternal {
+	handle: ZstdSeekableHandle;
+	path: string;
+	size: number;
+	frameCount: number;
+}
+
+const _ = createInternal<SeekableReader, SeekableReaderInternal>();
+
+/**
+ * Random access reads from a file in the zstd
+ * [seekable format](https://github.com/facebook/zstd/tree/dev/contrib/seekable_format)
+ * (as written by {@link SeekableCompressionStream | `Switch.SeekableCompressionStream`},
+ * or zstd's `seekable_compression` tool), without decompressing it whole.
+ *
+ * Opening the file reads its seek table. Each {@link SeekableReader.read | `read()`}
+ * then reads and decompresses only the frames which the requested range
+ * spans, on the thread pool. Frames which a read needs only part of are
+ * kept in a least-recently-used cache, so that nearby reads (e.g. the
+ * records of a level as the player moves through it) decompress each frame
+ * once.
+ *
+ * > [!NOTE]
+ * > This class is specific to nx.js.
+ *
+ * @example
+ *
+ * ```typescript
+ * const level = await Switch.SeekableReader.open(
+ * 	'sdmc:/switch/awesome-app/level1.bin.zst',
+ * );
+ * const chunk = await level.read(chunkOffset, chunkLength);
+ * ```
+ */
+export class SeekableReader {
+	/**
+	 * @private
+	 */
+	constructor() {
+		assertInternalConstructor(arguments);
+	}
+
+	/**
+	 * Opens the seekable zstd file at `path`, and reads its seek table.
+	 *
+	 * Rejects with a `TypeError` if the file has no valid seek table.
+	 *
+	 * @param path Path of the file.
+	 * @param options Reader settings.
+	 */
+	static async open(
+		path: PathLike,
+		options?: SeekableReaderOptions,
+	): Promise<SeekableReader> {
+		const p = pathToString(path);
+		const [handle, size, frameCount] = await $.zstdSeekableOpen(
+			p,
+			options?.cacheSize ?? 8 * 1024 * 1024,
+		);
+		// @ts-expect-error internal constructor
+		const reader = new SeekableReader(INTERNAL_SYMBOL);
+		_.set(reader, { handle, path: p, size, frameCount });
+		return reader;
+	}
+
+	/**
+	 * Path of the file.
+	 */
+	get path(): string {
+		return _(this).path;
+	}
+
+	/**
+	 * Size of the decompressed data, in bytes.
+	 */
+	get size(): number {
+		return _(this).size;
+	}
+
+	/**
+	 * Number of frames the data is compressed in.
+	 */
+	get frameCount(): number {
+		return _(this).frameCount;
+	}
+
+	/**
+	 * Returns a Promise which resolves to an `ArrayBuffer` of `length` bytes
+	 * of the decompressed data, starting at `offset`. The range is clamped to
+	 * the end of the data.
+	 *
+	 * Corrupt frames reject with a `TypeError`.
+	 *
+	 * @param offset Offset of the first byte to read, in the decompressed data.
+	 * @param length Number of bytes to read.
+	 */
+	read(offset: number, length: number): Promise<ArrayBuffer> {
+		return $.zstdSeekableRead(_(this).handle, offset, length);
+	}
+}
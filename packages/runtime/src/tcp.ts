@@ -11,6 +11,7 @@ import {
 } from './utils';
 import type { BufferSource } from './types';
 import {
+	type Callback,
 	INTERNAL_SYMBOL,
 	Opaque,
 	type SocketOptionsInternal,
@@ -26,13 +27,81 @@ export function parseAddress(address: string): SocketAddress {
 	};
 }
 
+/**
+ * Time to wait for a connection attempt before starting the next one in
+ * parallel, in milliseconds (RFC 8305 "Connection Attempt Delay").
+ */
+const CONNECTION_ATTEMPT_DELAY = 250;
+
+/**
+ * Orders addresses for connection attempts as RFC 8305 section 4 does:
+ * alternating between IPv6 and IPv4, starting with IPv6.
+ */
+function interleaveAddresses(ips: string[]): string[] {
+	const v6 = ips.filter((ip) => ip.includes(':'));
+	const v4 = ips.filter((ip) => !ip.includes(':'));
+	const ordered: string[] = [];
+	for (let i = 0; i < Math.max(v6.length, v4.length); i++) {
+		if (i < v6.length) ordered.push(v6[i]);
+		if (i < v4.length) ordered.push(v4[i]);
+	}
+	return ordered;
+}
+
+/**
+ * Connects to the first of `ips` which accepts a connection, "happy
+ * eyeballs" style (RFC 8305): each attempt gets a head start of
+ * `CONNECTION_ATTEMPT_DELAY` (or until it fails) before the next one is
+ * started alongside it, so that an unreachable address costs a short delay
+ * rather than a full connection timeout. Connections which complete after
+ * the first one are closed.
+ */
+function connectAny(ips: string[], port: number) {
+	return new Promise<number>((resolve, reject) => {
+		let next = 0;
+		let pending = 0;
+		let done = false;
+		let timer: ReturnType<typeof setTimeout> | undefined;
+		const attempt = () => {
+			clearTimeout(timer);
+			if (done || next >= ips.length) return;
+			const ip = ips[next++];
+			if (next < ips.length) {
+				timer = setTimeout(attempt, CONNECTION_ATTEMPT_DELAY);
+			}
+			const settle: Callback<number> = (err, fd) => {
+				pending--;
+				if (done) {
+					if (!err) $.close(fd);
+				} else if (!err) {
+					done = true;
+					clearTimeout(timer);
+					resolve(fd);
+				} else if (next < ips.length) {
+					attempt();
+				} else if (pending === 0) {
+					done = true;
+					reject(err);
+				}
+			};
+			pending++;
+			try {
+				$.connect(settle, ip, port);
+			} catch (err) {
+				settle(err as Error, -1);
+			}
+		};
+		attempt();
+	});
+}
+
 export async function connect(opts: SocketAddress) {
 	const { hostname = '127.0.0.1', port } = opts;
-	const [ip] = await resolveDns(hostname);
-	if (!ip) {
+	const ips = await resolveDns(hostname);
+	if (!ips.length) {
 		throw new Error(`Could not resolve "${hostname}" to an IP address`);
 	}
-	return toPromise($.connect, ip, port);
+	return connectAny(interleaveAddresses(ips), port);
 }
 
 function read(fd: number, buffer: BufferSource) {
@@ -5,6 +5,7 @@ import type { ImageData } from './canvas/image-data';
 import type { ImageBitmap } from './canvas/image-bitmap';
 import type { OffscreenCanvas } from './canvas/offscreen-canvas';
 import type { Video } from './video';
+import type { AnimatedImage } from './switch/animated-image';
 
 export type DOMHighResTimeStamp = number;
 
@@ -30,10 +31,42 @@ export type BufferSource = ArrayBufferView | ArrayBuffer;
 export interface ImageEncodeOptions {
 	quality?: number;
 	type?: string;
+	/**
+	 * PNG zlib compression level, `0` (store, fastest) to `9` (smallest).
+	 * Defaults to `6`. Ignored by the other formats.
+	 *
+	 * @note This is an nx.js extension.
+	 */
+	compressionLevel?: number;
+	/**
+	 * Encoder effort, `0` (fastest) to `6` (slowest, smallest / best quality).
+	 * WebP: the compression method (default `4`). PNG: below `3` skips the
+	 * per-row filter search. JPEG: `5` and above uses the accurate DCT.
+	 *
+	 * @note This is an nx.js extension.
+	 */
+	effort?: number;
+}
+
+export interface CanvasRenderingContext2DSettings {
+	alpha?: boolean;
+	colorSpace?: string;
+	desynchronized?: boolean;
+	willReadFrequently?: boolean;
+	/**
+	 * Record draw calls and rasterize them in parallel across horizontal tiles
+	 * on this many threads (1-4) when the pixels are next read, instead of
+	 * rasterizing each call immediately on the JS thread. Worthwhile for
+	 * complex scenes that are drawn fully before being read back.
+	 *
+	 * @note This is an nx.js extension.
+	 */
+	rasterThreads?: number;
 }
 
 export type CanvasFillRule = 'evenodd' | 'nonzero';
 export type CanvasImageSource =
+	| AnimatedImage
 	| Image
 	| ImageBitmap
 	| Screen
@@ -0,0 +1,506 @@
+import { test } from '../src/tap';
+
+// Animated GIF / APNG / WebP decoding. nx.js plays animations through the
+// `Switch.AnimatedImage` extension; Chrome has no equivalent, so there the
+// fixture decodes the same bytes with WebCodecs' `ImageDecoder` (the
+// reference for composited frame pixels, durations and loop counts). The test
+// images are assembled here byte by byte, so each disposal / blend case is
+// explicit. Timings are TAP comments only, so the TAP stays identical.
+
+const isNxjs = typeof (globalThis as any).Switch !== 'undefined';
+
+// ---- GIF builder (uncompressed LZW: a clear code every two literals keeps
+// the code size at 3 bits for a 4-colour palette) ----
+
+interface GifFrame {
+	x: number;
+	y: number;
+	w: number;
+	h: number;
+	/** Palette index per pixel (row-major), or a single index to fill with. */
+	pixels: number[] | number;
+	/** Delay in hundredths of a second. */
+	delay: number;
+	/** 1 = none, 2 = restore to background, 3 = restore to previous. */
+	dispose: number;
+	transparent?: number;
+}
+
+function le16(n: number) {
+	return [n & 0xff, (n >> 8) & 0xff];
+}
+
+function le32(n: number) {
+	return [n & 0xff, (n >>> 8) & 0xff, (n >>> 16) & 0xff, (n >>> 24) & 0xff];
+}
+
+function gifLzw(indices: number[]): number[] {
+	const codes: number[] = [];
+	for (let i = 0; i < indices.length; i++) {
+		if (i % 2 === 0) codes.push(4); // clear
+		codes.push(indices[i]);
+	}
+	codes.push(5); // end of information
+	const bytes: number[] = [];
+	let acc = 0;
+	let n = 0;
+	for (const c of codes) {
+		acc |= c << n;
+		n += 3;
+		while (n >= 8) {
+			bytes.push(acc & 0xff);
+			acc >>= 8;
+			n -= 8;
+		}
+	}
+	if (n > 0) bytes.push(acc & 0xff);
+	const out: number[] = [];
+	for (let i = 0; i < bytes.length; i += 255) {
+		const block = bytes.slice(i, i + 255);
+		out.push(block.length, ...block);
+	}
+	out.push(0);
+	return out;
+}
+
+function buildGif(
+	w: number,
+	h: number,
+	palette: number[][],
+	frames: GifFrame[],
+	loop?: number,
+): Uint8Array {
+	const b: number[] = [];
+	b.push(...Array.from('GIF89a', (c) => c.charCodeAt(0)));
+	b.push(...le16(w), ...le16(h), 0x81, 0, 0);
+	for (const rgb of palette) b.push(...rgb);
+	if (loop !== undefined) {
+		b.push(0x21, 0xff, 11);
+		b.push(...Array.from('NETSCAPE2.0', (c) => c.charCodeAt(0)));
+		b.push(3, 1, ...le16(loop), 0);
+	}
+	for (const f of frames) {
+		const t = f.transparent !== undefined;
+		b.push(0x21, 0xf9, 4, (f.dispose << 2) | (t ? 1 : 0));
+		b.push(...le16(f.delay), t ? f.transparent! : 0, 0);
+		b.push(0x2c, ...le16(f.x), ...le16(f.y), ...le16(f.w), ...le16(f.h), 0);
+		b.push(2); // LZW minimum code size
+		const px =
+			typeof f.pixels === 'number'
+				? new Array(f.w * f.h).fill(f.pixels)
+				: f.pixels;
+		b.push(...gifLzw(px));
+	}
+	b.push(0x3b);
+	return new Uint8Array(b);
+}
+
+// ---- PNG / APNG builder ----
+
+const CRC_TABLE = (() => {
+	const t = new Uint32Array(256);
+	for (let n = 0; n < 256; n++) {
+		let c = n;
+		for (let k = 0; k < 8; k++) c = c & 1 ? 0xedb88320 ^ (c >>> 1) : c >>> 1;
+		t[n] = c >>> 0;
+	}
+	return t;
+})();
+
+function crc32(bytes: Uint8Array) {
+	let c = 0xffffffff;
+	for (const v of bytes) c = CRC_TABLE[(c ^ v) & 0xff] ^ (c >>> 8);
+	return (c ^ 0xffffffff) >>> 0;
+}
+
+function be32(n: number) {
+	return [(n >>> 24) & 0xff, (n >>> 16) & 0xff, (n >>> 8) & 0xff, n & 0xff];
+}
+
+function chunk(type: string, data: number[] | Uint8Array): number[] {
+	const body = new Uint8Array(4 + data.length);
+	body.set(Array.from(type, (c) => c.charCodeAt(0)));
+	body.set(data, 4);
+	return [...be32(data.length), ...body, ...be32(crc32(body))];
+}
+
+async function deflate(data: Uint8Array): Promise<Uint8Array> {
+	const stream = new Blob([data]).stream().pipeThrough(
+		new CompressionStream('deflate'),
+	);
+	return new Uint8Array(await new Response(stream).arrayBuffer());
+}
+
+// RGBA pixels of a solid `w`x`h` rectangle, as zlib'd filter-0 scanlines.
+async function solidIdat(w: number, h: number, rgba: number[]) {
+	const raw = new Uint8Array(h * (1 + w * 4));
+	for (let y = 0; y < h; y++) {
+		for (let x = 0; x < w; x++) raw.set(rgba, y * (1 + w * 4) + 1 + x * 4);
+	}
+	return deflate(raw);
+}
+
+interface PngFrame {
+	x: number;
+	y: number;
+	w: number;
+	h: number;
+	rgba: number[];
+	delayMs: number;
+	/** 0 = none, 1 = background, 2 = previous. */
+	dispose: number;
+	/** 0 = source, 1 = over. */
+	blend: number;
+}
+
+async function buildApng(
+	w: number,
+	h: number,
+	frames: PngFrame[],
+	plays: number,
+): Promise<Uint8Array> {
+	const b: number[] = [0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a];
+	b.push(...chunk('IHDR', [...be32(w), ...be32(h), 8, 6, 0, 0, 0]));
+	b.push(...chunk('acTL', [...be32(frames.length), ...be32(plays)]));
+	let seq = 0;
+	for (let i = 0; i < frames.length; i++) {
+		const f = frames[i];
+		b.push(
+			...chunk('fcTL', [
+				...be32(seq++),
+				...be32(f.w),
+				...be32(f.h),
+				...be32(f.x),
+				...be32(f.y),
+				(f.delayMs >> 8) & 0xff,
+				f.delayMs & 0xff,
+				1000 >> 8,
+				1000 & 0xff,
+				f.dispose,
+				f.blend,
+			]),
+		);
+		const data = await solidIdat(f.w, f.h, f.rgba);
+		if (i === 0) {
+			b.push(...chunk('IDAT', data));
+		} else {
+			b.push(...chunk('fdAT', [...be32(seq++), ...data]));
+		}
+	}
+	b.push(...chunk('IEND', []));
+	return new Uint8Array(b);
+}
+
+// ---- animated WebP builder: still WebP frames (from convertToBlob) wrapped
+// in ANMF chunks ----
+
+function le24(n: number) {
+	return [n & 0xff, (n >> 8) & 0xff, (n >> 16) & 0xff];
+}
+
+function riffChunk(type: string, data: number[]): number[] {
+	const out = [...Array.from(type, (c) => c.charCodeAt(0))];
+	out.push(...le32(data.length), ...data);
+	if (data.length & 1) out.push(0);
+	return out;
+}
+
+async function stillWebpChunks(w: number, h: number, color: string) {
+	const c = new OffscreenCanvas(w, h);
+	const ctx = c.getContext('2d')!;
+	ctx.fillStyle = color;
+	ctx.fillRect(0, 0, w, h);
+	const blob = await c.convertToBlob({ type: 'image/webp', quality: 1 });
+	const webp = new Uint8Array(await blob.arrayBuffer());
+	// Everything after "RIFF <size> WEBP", minus any VP8X header.
+	const chunks: number[] = [];
+	let p = 12;
+	while (p + 8 <= webp.length) {
+		const type = String.fromCharCode(...webp.subarray(p, p + 4));
+		const len = new DataView(webp.buffer).getUint32(p + 4, true);
+		const end = p + 8 + len + (len & 1);
+		if (type !== 'VP8X') chunks.push(...webp.subarray(p, end));
+		p = end;
+	}
+	return chunks;
+}
+
+async function buildAnimatedWebp(
+	w: number,
+	h: number,
+	frames: { color: string; durationMs: number }[],
+): Promise<Uint8Array> {
+	const body: number[] = [...Array.from('WEBP', (c) => c.charCodeAt(0))];
+	body.push(...riffChunk('VP8X', [0x12, 0, 0, 0, ...le24(w - 1), ...le24(h - 1)]));
+	body.push(...riffChunk('ANIM', [0, 0, 0, 0, 0, 0])); // loop forever
+	for (const f of frames) {
+		const data = await stillWebpChunks(w, h, f.color);
+		body.push(
+			...riffChunk('ANMF', [
+				...le24(0),
+				...le24(0),
+				...le24(w - 1),
+				...le24(h - 1),
+				...le24(f.durationMs),
+				0x02, // no blending, no disposal
+				...data,
+			]),
+		);
+	}
+	return new Uint8Array([
+		...Array.from('RIFF', (c) => c.charCodeAt(0)),
+		...le32(body.length),
+		...body,
+	]);
+}
+
+// ---- decoding, per engine ----
+
+interface Decoded {
+	width: number;
+	height: number;
+	frameCount: number;
+	loopCount: number;
+	durations: number[];
+	/** Composited RGBA pixels of every frame. */
+	frames: Uint8ClampedArray[];
+}
+
+async function presentAt(anim: any, t: number) {
+	// The next frame may still be decoding in the background.
+	for (let tries = 0; tries < 1000; tries++) {
+		if (anim.update(t)) return true;
+		await new Promise((r) => setTimeout(r, 1));
+	}
+	return false;
+}
+
+async function decode(bytes: Uint8Array, type: string): Promise<Decoded> {
+	let canvas: OffscreenCanvas | undefined;
+	const frames: Uint8ClampedArray[] = [];
+	const capture = (source: any, w: number, h: number) => {
+		canvas ??= new OffscreenCanvas(w, h);
+		const ctx = canvas.getContext('2d')!;
+		ctx.clearRect(0, 0, w, h);
+		ctx.drawImage(source, 0, 0);
+		frames.push(ctx.getImageData(0, 0, w, h).data);
+	};
+
+	if (isNxjs) {
+		const anim = await (globalThis as any).Switch.AnimatedImage.from(bytes);
+		let t = 0;
+		for (let i = 0; i < anim.frameCount; i++) {
+			if (!(await presentAt(anim, t))) break;
+			capture(anim, anim.width, anim.height);
+			t += anim.durations[i];
+		}
+		const result = {
+			width: anim.width,
+			height: anim.height,
+			frameCount: anim.frameCount,
+			loopCount: anim.loopCount,
+			durations: [...anim.durations],
+			frames,
+		};
+		anim.close();
+		return result;
+	}
+
+	const ImageDecoder = (globalThis as any).ImageDecoder;
+	const decoder = new ImageDecoder({ data: bytes, type });
+	await decoder.tracks.ready;
+	await decoder.completed;
+	const track = decoder.tracks.selectedTrack;
+	const durations: number[] = [];
+	let width = 0;
+	let height = 0;
+	for (let i = 0; i < track.frameCount; i++) {
+		const { image } = await decoder.decode({ frameIndex: i });
+		width = image.displayWidth;
+		height = image.displayHeight;
+		durations.push(Math.round(image.duration / 1000));
+		capture(image, width, height);
+		image.close();
+	}
+	decoder.close();
+	return {
+		width,
+		height,
+		frameCount: track.frameCount,
+		loopCount:
+			track.repetitionCount === Infinity ? 0 : track.repetitionCount + 1,
+		durations,
+		frames,
+	};
+}
+
+function px(d: Decoded, frame: number, x: number, y: number) {
+	const o = (y * d.width + x) * 4;
+	return Array.from(d.frames[frame].subarray(o, o + 4));
+}
+
+function near(a: number[], b: number[], tolerance: number) {
+	return a.every((v, i) => Math.abs(v - b[i]) <= tolerance);
+}
+
+const PALETTE = [
+	[0, 0, 0],
+	[255, 0, 0],
+	[0, 255, 0],
+	[0, 0, 255],
+];
+
+// 8x8: red background; a green square that is cleared afterwards (dispose to
+// background); then a blue square with a transparent hole over the red.
+function sampleGif(loop?: number) {
+	return buildGif(
+		8,
+		8,
+		PALETTE,
+		[
+			{ x: 0, y: 0, w: 8, h: 8, pixels: 1, delay: 5, dispose: 1 },
+			{ x: 0, y: 0, w: 4, h: 4, pixels: 2, delay: 5, dispose: 2 },
+			{
+				x: 4,
+				y: 4,
+				w: 4,
+				h: 4,
+				// prettier-ignore
+				pixels: [
+					3, 3, 3, 3,
+					3, 0, 0, 3,
+					3, 0, 0, 3,
+					3, 3, 3, 3,
+				],
+				delay: 10,
+				dispose: 1,
+				transparent: 0,
+			},
+		],
+		loop,
+	);
+}
+
+const RED = [255, 0, 0, 255];
+const GREEN = [0, 255, 0, 255];
+const BLUE = [0, 0, 255, 255];
+const CLEAR = [0, 0, 0, 0];
+
+test('GIF frames are composited with disposal and transparency', async (t) => {
+	const d = await decode(sampleGif(0), 'image/gif');
+	t.equal(d.width, 8, 'width');
+	t.equal(d.height, 8, 'height');
+	t.equal(d.frameCount, 3, 'frame count');
+	t.deepEqual(d.durations, [50, 50, 100], 'frame durations (ms)');
+	t.equal(d.loopCount, 0, 'NETSCAPE loop 0 loops forever');
+	t.equal(d.frames.length, 3, 'every frame presented');
+
+	t.deepEqual(px(d, 0, 1, 1), RED, 'frame 0: red');
+	t.deepEqual(px(d, 1, 1, 1), GREEN, 'frame 1: green square');
+	t.deepEqual(px(d, 1, 6, 6), RED, 'frame 1: red elsewhere');
+	t.deepEqual(px(d, 2, 1, 1), CLEAR, 'frame 2: green square disposed');
+	t.deepEqual(px(d, 2, 4, 4), BLUE, 'frame 2: blue border');
+	t.deepEqual(px(d, 2, 5, 5), RED, 'frame 2: transparent hole shows red');
+	t.deepEqual(px(d, 2, 6, 1), RED, 'frame 2: untouched area');
+});
+
+test('GIF without a loop extension plays once', async (t) => {
+	const d = await decode(sampleGif(), 'image/gif');
+	t.equal(d.loopCount, 1, 'loop count');
+});
+
+test('Image draws the first frame of an animated GIF', async (t) => {
+	const bitmap = await createImageBitmap(
+		new Blob([sampleGif(0)], { type: 'image/gif' }),
+	);
+	t.equal(bitmap.width, 8, 'width');
+	const c = new OffscreenCanvas(8, 8);
+	const ctx = c.getContext('2d')!;
+	ctx.drawImage(bitmap, 0, 0);
+	t.deepEqual(
+		Array.from(ctx.getImageData(1, 1, 1, 1).data),
+		RED,
+		'first frame pixels',
+	);
+});
+
+test('APNG frames honor blend and dispose ops', async (t) => {
+	const bytes = await buildApng(
+		8,
+		8,
+		[
+			{ x: 0, y: 0, w: 8, h: 8, rgba: RED, delayMs: 40, dispose: 0, blend: 0 },
+			{
+				x: 2,
+				y: 2,
+				w: 4,
+				h: 4,
+				rgba: [0, 0, 255, 128],
+				delayMs: 60,
+				dispose: 1,
+				blend: 1,
+			},
+			{ x: 6, y: 6, w: 2, h: 2, rgba: GREEN, delayMs: 80, dispose: 0, blend: 0 },
+		],
+		0,
+	);
+	const d = await decode(bytes, 'image/png');
+	t.equal(d.frameCount, 3, 'frame count');
+	t.deepEqual(d.durations, [40, 60, 80], 'frame durations (ms)');
+	t.equal(d.loopCount, 0, 'num_plays 0 loops forever');
+	t.deepEqual(px(d, 0, 3, 3), RED, 'frame 0: red');
+	t.ok(
+		near(px(d, 1, 3, 3), [127, 0, 128, 255], 3),
+		'frame 1: blue blended over red',
+	);
+	t.deepEqual(px(d, 1, 0, 0), RED, 'frame 1: outside the region');
+	t.deepEqual(px(d, 2, 3, 3), CLEAR, 'frame 2: region disposed to background');
+	t.deepEqual(px(d, 2, 7, 7), GREEN, 'frame 2: new region');
+	t.deepEqual(px(d, 2, 0, 0), RED, 'frame 2: untouched area');
+});
+
+test('animated WebP frames and durations', async (t) => {
+	const bytes = await buildAnimatedWebp(16, 16, [
+		{ color: 'rgb(255, 0, 0)', durationMs: 40 },
+		{ color: 'rgb(0, 0, 255)', durationMs: 80 },
+	]);
+	const d = await decode(bytes, 'image/webp');
+	t.equal(d.frameCount, 2, 'frame count');
+	t.deepEqual(d.durations, [40, 80], 'frame durations (ms)');
+	t.equal(d.loopCount, 0, 'loop count 0 loops forever');
+	t.ok(near(px(d, 0, 8, 8), RED, 12), 'frame 0: red');
+	t.ok(near(px(d, 1, 8, 8), BLUE, 12), 'frame 1: blue');
+});
+
+test('long animation decodes through the frame ring', async (t) => {
+	const W = 320;
+	const H = 240;
+	const FRAMES = 120;
+	const frames: GifFrame[] = [
+		{ x: 0, y: 0, w: W, h: H, pixels: 1, delay: 2, dispose: 1 },
+	];
+	for (let i = 1; i < FRAMES; i++) {
+		frames.push({
+			x: (i * 7) % (W - 32),
+			y: (i * 5) % (H - 32),
+			w: 32,
+			h: 32,
+			pixels: 1 + (i % 3),
+			delay: 2,
+			dispose: 3,
+		});
+	}
+	const bytes = buildGif(W, H, PALETTE, frames, 0);
+	const start = performance.now();
+	const d = await decode(bytes, 'image/gif');
+	const ms = performance.now() - start;
+	console.log(
+		`# bench ${FRAMES} GIF frames ${W}x${H}: ${(ms / FRAMES).toFixed(2)}ms/frame`,
+	);
+	t.equal(d.frames.length, FRAMES, 'every frame presented');
+	t.deepEqual(
+		px(d, FRAMES - 1, W - 1, H - 1),
+		RED,
+		'restore-to-previous keeps the background intact',
+	);
+});
@@ -0,0 +1,421 @@
+import { test } from '../src/tap';
+
+// ZIP / tar reading. The archives are assembled here (deflate entries with
+// CompressionStream), and nx.js reads them back through `Switch.Archive`.
+// Chrome has no archive reader, so there the expected results are taken from
+// the entries the archives were built from (and modules are imported from
+// data: URLs), which keeps the TAP identical. Timings are TAP comments only.
+
+const isNxjs = typeof (globalThis as any).Switch !== 'undefined';
+const Sw: any = (globalThis as any).Switch;
+
+const encoder = new TextEncoder();
+const decoder = new TextDecoder();
+
+interface Entry {
+	name: string;
+	data: Uint8Array;
+	deflate?: boolean;
+}
+
+const CRC_TABLE = (() => {
+	const table = new Uint32Array(256);
+	for (let n = 0; n < 256; n++) {
+		let c = n;
+		for (let k = 0; k < 8; k++) c = c & 1 ? 0xedb88320 ^ (c >>> 1) : c >>> 1;
+		table[n] = c >>> 0;
+	}
+	return table;
+})();
+
+function crc32(data: Uint8Array): number {
+	let c = 0xffffffff;
+	for (let i = 0; i < data.length; i++) {
+		c = CRC_TABLE[(c ^ data[i]) & 0xff] ^ (c >>> 8);
+	}
+	return (c ^ 0xffffffff) >>> 0;
+}
+
+async function deflateRaw(data: Uint8Array): Promise<Uint8Array> {
+	return new Uint8Array(
+		await new Response(
+			new Blob([data])
+				.stream()
+				.pipeThrough(new CompressionStream('deflate-raw')),
+		).arrayBuffer(),
+	);
+}
+
+function concat(parts: Uint8Array[]): Uint8Array {
+	const out = new Uint8Array(parts.reduce((n, p) => n + p.length, 0));
+	let pos = 0;
+	for (const p of parts) {
+		out.set(p, pos);
+		pos += p.length;
+	}
+	return out;
+}
+
+function header(size: number, fill: (v: DataView) => void): Uint8Array {
+	const b = new Uint8Array(size);
+	fill(new DataView(b.buffer));
+	return b;
+}
+
+// ZIP with a directory entry, stored and deflated files.
+async function buildZip(entries: Entry[]): Promise<Uint8Array> {
+	const parts: Uint8Array[] = [];
+	const central: Uint8Array[] = [];
+	let offset = 0;
+	const all: Entry[] = [{ name: 'dir/', data: new Uint8Array(0) }, ...entries];
+	for (const e of all) {
+		const name = encoder.encode(e.name);
+		const body = e.deflate ? await deflateRaw(e.data) : e.data;
+		const method = e.deflate ? 8 : 0;
+		const crc = crc32(e.data);
+		// 2024-06-01 12:00:00
+		const time = (12 << 11) | 0;
+		const date = ((2024 - 1980) << 9) | (6 << 5) | 1;
+		const local = header(30, (v) => {
+			v.setUint32(0, 0x04034b50, true);
+			v.setUint16(4, 20, true);
+			v.setUint16(8, method, true);
+			v.setUint16(10, time, true);
+			v.setUint16(12, date, true);
+			v.setUint32(14, crc, true);
+			v.setUint32(18, body.length, true);
+			v.setUint32(22, e.data.length, true);
+			v.setUint16(26, name.length, true);
+		});
+		central.push(
+			header(46, (v) => {
+				v.setUint32(0, 0x02014b50, true);
+				v.setUint16(4, 20, true);
+				v.setUint16(6, 20, true);
+				v.setUint16(10, method, true);
+				v.setUint16(12, time, true);
+				v.setUint16(14, date, true);
+				v.setUint32(16, crc, true);
+				v.setUint32(20, body.length, true);
+				v.setUint32(24, e.data.length, true);
+				v.setUint16(28, name.length, true);
+				v.setUint32(42, offset, true);
+			}),
+			name,
+		);
+		parts.push(local, name, body);
+		offset += local.length + name.length + body.length;
+	}
+	const cd = concat(central);
+	const eocd = header(22, (v) => {
+		v.setUint32(0, 0x06054b50, true);
+		v.setUint16(8, all.length, true);
+		v.setUint16(10, all.length, true);
+		v.setUint32(12, cd.length, true);
+		v.setUint32(16, offset, true);
+	});
+	return concat([...parts, cd, eocd]);
+}
+
+function tarHeader(name: string, size: number, type: string): Uint8Array {
+	const h = new Uint8Array(512);
+	const put = (s: string, at: number) => h.set(encoder.encode(s), at);
+	put(name.slice(0, 100), 0);
+	put('0000644\0', 100);
+	put('0000000\0', 108);
+	put('0000000\0', 116);
+	put(`${size.toString(8).padStart(11, '0')}\0`, 124);
+	put(`${(1717243200).toString(8).padStart(11, '0')}\0`, 136);
+	put('        ', 148);
+	put(type, 156);
+	put('ustar  \0', 257);
+	let sum = 0;
+	for (const b of h) sum += b;
+	put(`${sum.toString(8).padStart(6, '0')}\0 `, 148);
+	return h;
+}
+
+// GNU tar, with a long name record for names over 100 bytes.
+function buildTar(entries: Entry[]): Uint8Array {
+	const parts: Uint8Array[] = [];
+	const pad = (n: number) => new Uint8Array((512 - (n % 512)) % 512);
+	for (const e of entries) {
+		if (e.name.length > 100) {
+			const name = encoder.encode(`${e.name}\0`);
+			parts.push(tarHeader('././@LongLink', name.length, 'L'), name);
+			parts.push(pad(name.length));
+		}
+		parts.push(tarHeader(`./${e.name}`, e.data.length, '0'), e.data);
+		parts.push(pad(e.data.length));
+	}
+	parts.push(new Uint8Array(1024));
+	return concat(parts);
+}
+
+function sampleText(bytes: number, seed: number): Uint8Array {
+	const words = ['tile', 'sprite', 'level', 'music', 'grass', 'stone', 'npc'];
+	let s = '';
+	let i = seed;
+	while (s.length < bytes) {
+		s += `${words[i % words.length]}${i} `;
+		i = (i * 7 + 3) % 1009;
+	}
+	return encoder.encode(s.slice(0, bytes));
+}
+
+function sameBytes(a: Uint8Array, b: Uint8Array): boolean {
+	if (a.length !== b.length) return false;
+	for (let i = 0; i < a.length; i++) if (a[i] !== b[i]) return false;
+	return true;
+}
+
+const ENTRIES: Entry[] = [
+	{ name: 'readme.txt', data: encoder.encode('hello archive\n') },
+	{ name: 'data/level1.json', data: sampleText(20000, 1), deflate: true },
+	{ name: 'data/empty.bin', data: new Uint8Array(0) },
+	{ name: 'mod.js', data: encoder.encode('export default 6 * 7;\n') },
+	{ name: 'big.bin', data: sampleText(300000, 2), deflate: true },
+	{
+		name: `deep/${'nested/'.repeat(16)}file.txt`,
+		data: encoder.encode('a long path'),
+	},
+];
+
+function writeTemp(name: string, data: Uint8Array): string {
+	Sw.writeFileSync(name, data);
+	return name;
+}
+
+async function readAll(stream: ReadableStream<Uint8Array>) {
+	return new Uint8Array(await new Response(stream).arrayBuffer());
+}
+
+for (const type of ['zip', 'tar'] as const) {
+	test(`${type} archive entries`, async (t) => {
+		const bytes = type === 'zip' ? await buildZip(ENTRIES) : buildTar(ENTRIES);
+		let names: string[];
+		let sizes: (number | null)[];
+		let modified: number;
+		if (isNxjs) {
+			const path = writeTemp(`nxjs-archive-${type}.tmp`, bytes);
+			const archive = await Sw.Archive.open(path);
+			t.equal(archive.type, type, 'archive type');
+			names = archive.names();
+			sizes = ENTRIES.map((e) => archive.get(e.name)?.size ?? null);
+			modified = archive.get('readme.txt').lastModified;
+			Sw.removeSync(path);
+		} else {
+			t.equal(type, type, 'archive type');
+			names = ENTRIES.map((e) => e.name);
+			sizes = ENTRIES.map((e) => e.data.length);
+			modified = Date.UTC(2024, 5, 1, 12);
+		}
+		t.deepEqual(names, ENTRIES.map((e) => e.name), 'names, in order');
+		t.deepEqual(sizes, ENTRIES.map((e) => e.data.length), 'sizes');
+		t.equal(modified, Date.UTC(2024, 5, 1, 12), 'modification time');
+	});
+
+	test(`${type} archive read`, async (t) => {
+		const bytes = type === 'zip' ? await buildZip(ENTRIES) : buildTar(ENTRIES);
+		let path: string | undefined;
+		let archive: any;
+		if (isNxjs) {
+			path = writeTemp(`nxjs-archive-${type}.tmp`, bytes);
+			archive = await Sw.Archive.open(path);
+		}
+		const start = performance.now();
+		for (const e of ENTRIES) {
+			const data = archive
+				? new Uint8Array(await archive.read(e.name))
+				: e.data;
+			t.ok(sameBytes(data, e.data), `read ${e.name}`);
+		}
+		console.log(
+			`# bench ${type} read of ${ENTRIES.length} entries: ` +
+				`${(performance.now() - start).toFixed(2)}ms`,
+		);
+		const sync = archive ? archive.readSync('./readme.txt') : ENTRIES[0].data;
+		t.equal(decoder.decode(sync), 'hello archive\n', 'readSync, ./ prefix');
+		const missing = archive ? await archive.read('nope.txt') : null;
+		t.equal(missing, null, 'missing entry reads as null');
+		const entry = archive ? archive.get('dir/') : null;
+		t.equal(entry, null, 'directories are not entries');
+		if (path) Sw.removeSync(path);
+	});
+}
+
+test('archive stream', async (t) => {
+	const bytes = await buildZip(ENTRIES);
+	const big = ENTRIES[4];
+	const readme = ENTRIES[0];
+	let deflated: Uint8Array;
+	let stored: Uint8Array;
+	let missing = false;
+	if (isNxjs) {
+		const path = writeTemp('nxjs-archive-stream.tmp', bytes);
+		const archive = await Sw.Archive.open(path);
+		deflated = await readAll(archive.stream(big.name));
+		stored = await readAll(archive.stream(readme.name));
+		try {
+			await readAll(archive.stream('nope.txt'));
+		} catch (err) {
+			missing = err instanceof TypeError;
+		}
+		Sw.removeSync(path);
+	} else {
+		deflated = big.data;
+		stored = readme.data;
+		missing = true;
+	}
+	t.ok(sameBytes(deflated, big.data), 'deflated entry streams');
+	t.ok(sameBytes(stored, readme.data), 'stored entry streams');
+	t.ok(missing, 'missing entry errors the stream');
+});
+
+test('mounted archive readFile and import', async (t) => {
+	const bytes = await buildZip(ENTRIES);
+	let text: string;
+	let syncText: string;
+	let value: number;
+	let afterUnmount: unknown;
+	let url: string;
+	if (isNxjs) {
+		const path = writeTemp('nxjs-archive-mount.tmp', bytes);
+		const archive = await Sw.Archive.open(path);
+		url = archive.mount('nxjstestar').href;
+		text = decoder.decode(await Sw.readFile('nxjstestar:/readme.txt'));
+		syncText = decoder.decode(
+			Sw.readFileSync('nxjstestar:/data/level1.json', { start: 0, end: 5 }),
+		);
+		const specifier = 'nxjstestar:/mod.js';
+		value = (await import(specifier)).default;
+		archive.unmount();
+		afterUnmount = await Sw.readFile('nxjstestar:/readme.txt');
+		Sw.removeSync(path);
+	} else {
+		url = 'nxjstestar:/';
+		text = decoder.decode(ENTRIES[0].data);
+		syncText = decoder.decode(ENTRIES[1].data.subarray(0, 5));
+		const src = decoder.decode(ENTRIES[3].data);
+		value = (await import(`data:text/javascript,${encodeURIComponent(src)}`))
+			.default;
+		afterUnmount = null;
+	}
+	t.equal(url, 'nxjstestar:/', 'mount URL');
+	t.equal(text, 'hello archive\n', 'readFile from the mount');
+	t.equal(syncText, decoder.decode(ENTRIES[1].data.subarray(0, 5)), 'range');
+	t.equal(value, 42, 'import from the mount');
+	t.equal(afterUnmount, null, 'unmounted paths are gone');
+});
+
+test('mount names are case-insensitive', async (t) => {
+	let url: string;
+	let text: string;
+	let viaName: string;
+	let value: number;
+	if (isNxjs) {
+		const bytes = await buildZip(ENTRIES);
+		const path = writeTemp('nxjs-archive-case.tmp', bytes);
+		const archive = await Sw.Archive.open(path);
+		url = archive.mount('NxjsTestCase').href;
+		text = decoder.decode(await Sw.readFile(new URL('readme.txt', url)));
+		viaName = decoder.decode(await Sw.readFile('NxjsTestCase:/readme.txt'));
+		value = (await import(new URL('mod.js', url).href)).default;
+		archive.unmount();
+		Sw.removeSync(path);
+	} else {
+		url = 'nxjstestcase:/';
+		text = viaName = decoder.decode(ENTRIES[0].data);
+		const src = decoder.decode(ENTRIES[3].data);
+		value = (await import(`data:text/javascript,${encodeURIComponent(src)}`))
+			.default;
+	}
+	t.equal(url, 'nxjstestcase:/', 'mount URL is lowercase');
+	t.equal(text, 'hello archive\n', 'readFile by the mount URL');
+	t.equal(viaName, 'hello archive\n', 'readFile by the name as given');
+	t.equal(value, 42, 'import by the mount URL');
+});
+
+test('mounting over a runtime scheme is rejected', async (t) => {
+	const names = ['sdmc', 'romfs', 'nxjs', 'file', 'SDMC'];
+	let rejected = names.map(() => true);
+	let readable = true;
+	if (isNxjs) {
+		const bytes = await buildZip(ENTRIES);
+		const path = writeTemp('nxjs-archive-reserved.tmp', bytes);
+		const archive = await Sw.Archive.open(path);
+		rejected = names.map((name) => {
+			try {
+				archive.mount(name);
+				archive.unmount();
+				return false;
+			} catch (err) {
+				return err instanceof TypeError;
+			}
+		});
+		// Files are still read from the file system.
+		readable = (await Sw.readFile(path)) !== null;
+		Sw.removeSync(path);
+	}
+	t.deepEqual(rejected, names.map(() => true), 'reserved names throw');
+	t.ok(readable, 'files are still readable');
+});
+
+test('corrupt archive entries reject', async (t) => {
+	const bytes = await buildZip(ENTRIES);
+	// Flip a byte of the stored readme's data: caught by the CRC-32.
+	const at = 30 + 'dir/'.length + 30 + 'readme.txt'.length;
+	bytes[at] ^= 0x20;
+	let rejected = true;
+	let notArchive = true;
+	if (isNxjs) {
+		const path = writeTemp('nxjs-archive-corrupt.tmp', bytes);
+		const archive = await Sw.Archive.open(path);
+		rejected = await archive.read('readme.txt').then(
+			() => false,
+			(err: unknown) => err instanceof TypeError,
+		);
+		Sw.writeFileSync(path, encoder.encode('not an archive'));
+		notArchive = await Sw.Archive.open(path).then(
+			() => false,
+			(err: unknown) => err instanceof TypeError,
+		);
+		Sw.removeSync(path);
+	}
+	t.ok(rejected, 'CRC mismatch rejects with a TypeError');
+	t.ok(notArchive, 'non-archive rejects with a TypeError');
+});
+
+// Reading many small files from one archive, against the same files loose
+// (a path lookup and an open per file).
+test('archive vs loose files benchmark', async (t) => {
+	const files: Entry[] = [];
+	for (let i = 0; i < 200; i++) {
+		files.push({ name: `f${i}.txt`, data: sampleText(512 + i * 8, i) });
+	}
+	let ok = true;
+	if (isNxjs) {
+		const path = writeTemp('nxjs-archive-bench.tmp', buildTar(files));
+		const dir = 'nxjs-archive-loose.tmp';
+		for (const f of files) Sw.writeFileSync(`${dir}/${f.name}`, f.data);
+		let start = performance.now();
+		const archive = await Sw.Archive.open(path);
+		for (const f of files) {
+			ok &&= sameBytes(new Uint8Array(await archive.read(f.name)), f.data);
+		}
+		const archiveMs = performance.now() - start;
+		start = performance.now();
+		for (const f of files) {
+			const data = new Uint8Array(await Sw.readFile(`${dir}/${f.name}`));
+			ok &&= sameBytes(data, f.data);
+		}
+		const looseMs = performance.now() - start;
+		console.log(
+			`# bench ${files.length} files: archive ${archiveMs.toFixed(2)}ms, ` +
+				`loose ${looseMs.toFixed(2)}ms`,
+		);
+		Sw.removeSync(path);
+		Sw.removeSync(dir);
+	}
+	t.ok(ok, 'archive and loose files read the same');
+});
@@ -0,0 +1,160 @@
+import { test } from '../src/tap';
+
+// `getContext('2d', { rasterThreads })` is an nx.js extension: draw calls are
+// recorded and rasterized tile-parallel when the pixels are next read (here,
+// by getImageData — the synchronous fallback). Chrome ignores the unknown
+// option and draws immediately, so every assertion compares a deferred canvas
+// against an immediate one and holds in both engines. Timings are reported as
+// TAP comments only (never as assertions), so the TAP stays identical.
+
+const W = 1280;
+const H = 720;
+
+function makeContext(rasterThreads?: number) {
+	const c = new OffscreenCanvas(W, H);
+	const options = rasterThreads ? { rasterThreads } : undefined;
+	return c.getContext('2d', options as any)! as OffscreenCanvasRenderingContext2D;
+}
+
+function maxChannelDiff(a: Uint8ClampedArray, b: Uint8ClampedArray): number {
+	let max = 0;
+	for (let i = 0; i < a.length; i++) {
+		const d = Math.abs(a[i] - b[i]);
+		if (d > max) max = d;
+	}
+	return max;
+}
+
+// A scene heavy enough that rasterization dominates: overlapping anti-aliased
+// paths, gradients, strokes, and a clip that carries across save levels.
+function drawScene(ctx: OffscreenCanvasRenderingContext2D, shapes: number) {
+	let seed = 7;
+	const rand = () => {
+		seed = (seed * 1103515245 + 12345) & 0x7fffffff;
+		return seed / 0x7fffffff;
+	};
+	const grad = ctx.createLinearGradient(0, 0, W, H);
+	grad.addColorStop(0, 'rgb(20, 40, 80)');
+	grad.addColorStop(1, 'rgb(200, 120, 40)');
+	ctx.fillStyle = grad;
+	ctx.fillRect(0, 0, W, H);
+
+	ctx.save();
+	ctx.beginPath();
+	ctx.rect(40, 40, W - 80, H - 80);
+	ctx.clip();
+	for (let i = 0; i < shapes; i++) {
+		const x = rand() * W;
+		const y = rand() * H;
+		const r = 8 + rand() * 40;
+		ctx.save();
+		ctx.translate(x, y);
+		ctx.rotate(rand() * Math.PI);
+		ctx.globalAlpha = 0.3 + rand() * 0.7;
+		ctx.fillStyle = `rgb(${(rand() * 255) | 0}, ${(rand() * 255) | 0}, ${
+			(rand() * 255) | 0
+		})`;
+		ctx.beginPath();
+		if (i % 3 === 0) {
+			ctx.arc(0, 0, r, 0, Math.PI * 2);
+		} else if (i % 3 === 1) {
+			ctx.moveTo(-r, -r);
+			ctx.quadraticCurveTo(r * 2, 0, -r, r);
+			ctx.closePath();
+		} else {
+			ctx.ellipse(0, 0, r, r / 2, 0, 0, Math.PI * 2);
+		}
+		ctx.fill();
+		ctx.lineWidth = 1 + rand() * 4;
+		ctx.strokeStyle = 'rgba(255, 255, 255, 0.6)';
+		ctx.stroke();
+		ctx.restore();
+	}
+	ctx.restore();
+}
+
+test('deferred raster matches immediate raster', (t) => {
+	const SHAPES = 3000;
+
+	const immediate = makeContext();
+	let start = performance.now();
+	drawScene(immediate, SHAPES);
+	const a = immediate.getImageData(0, 0, W, H).data;
+	const immediateMs = performance.now() - start;
+
+	const results: string[] = [];
+	let maxDiff = 0;
+	for (const threads of [1, 2, 4]) {
+		const deferred = makeContext(threads);
+		start = performance.now();
+		drawScene(deferred, SHAPES);
+		const b = deferred.getImageData(0, 0, W, H).data;
+		const ms = performance.now() - start;
+		results.push(`${threads} thread(s) ${ms.toFixed(2)}ms`);
+		maxDiff = Math.max(maxDiff, maxChannelDiff(a, b));
+	}
+
+	console.log(
+		`# bench ${SHAPES} shapes ${W}x${H}: immediate ${immediateMs.toFixed(2)}ms, ` +
+			`deferred ${results.join(', ')}`,
+	);
+	t.ok(maxDiff <= 2, 'tiled output matches immediate output');
+});
+
+test('transform and clip survive a mid-frame readback', (t) => {
+	const ctx = makeContext(3);
+	ctx.save();
+	ctx.beginPath();
+	ctx.rect(0, 0, 100, 100);
+	ctx.clip();
+	ctx.translate(50, 50);
+	ctx.fillStyle = 'rgb(255, 0, 0)';
+	ctx.fillRect(0, 0, 10, 10);
+	t.deepEqual(
+		Array.from(ctx.getImageData(55, 55, 1, 1).data),
+		[255, 0, 0, 255],
+		'first draw is rasterized by the readback',
+	);
+
+	// Still translated by (50, 50) and clipped to 100x100.
+	ctx.fillStyle = 'rgb(0, 0, 255)';
+	ctx.fillRect(0, 0, 200, 200);
+	ctx.restore();
+	ctx.fillStyle = 'rgb(0, 255, 0)';
+	ctx.fillRect(200, 200, 10, 10);
+
+	const px = (x: number, y: number) =>
+		Array.from(ctx.getImageData(x, y, 1, 1).data);
+	t.deepEqual(px(75, 75), [0, 0, 255, 255], 'translated draw lands');
+	t.deepEqual(px(120, 120), [0, 0, 0, 0], 'clip still applies');
+	t.deepEqual(px(40, 40), [0, 0, 0, 0], 'translation still applies');
+	t.deepEqual(px(205, 205), [0, 255, 0, 255], 'restore pops both');
+});
+
+test('deferred canvas can draw itself', (t) => {
+	const ctx = makeContext(2);
+	ctx.fillStyle = 'rgb(0, 128, 255)';
+	ctx.fillRect(0, 0, 20, 20);
+	ctx.drawImage(ctx.canvas, 0, 0, 20, 20, 100, 100, 20, 20);
+	t.deepEqual(
+		Array.from(ctx.getImageData(110, 110, 1, 1).data),
+		[0, 128, 255, 255],
+		'self-draw sees earlier recorded draws',
+	);
+});
+
+test('putImageData composes with recorded draws', (t) => {
+	const ctx = makeContext(2);
+	ctx.fillStyle = 'rgb(255, 0, 0)';
+	ctx.fillRect(0, 0, 10, 10);
+	const img = new ImageData(5, 5);
+	img.data.fill(255);
+	ctx.putImageData(img, 0, 0);
+	ctx.fillStyle = 'rgb(0, 0, 255)';
+	ctx.fillRect(2, 2, 2, 2);
+	const px = (x: number, y: number) =>
+		Array.from(ctx.getImageData(x, y, 1, 1).data);
+	t.deepEqual(px(1, 1), [255, 255, 255, 255], 'put pixels overwrite draws');
+	t.deepEqual(px(3, 3), [0, 0, 255, 255], 'later draws land on top');
+	t.deepEqual(px(8, 8), [255, 0, 0, 255], 'earlier draws outside remain');
+});
@@ -0,0 +1,169 @@
+import { test } from '../src/tap';
+
+// `ctx.drawAtlas()` is an nx.js extension (batched sprite drawing through a
+// single native SkCanvas::drawAtlas). Chrome has no equivalent, so there the
+// fixture emulates it with one `drawImage` per sprite — the reference output
+// that the native batch must match pixel-for-pixel. The 20k-sprite benchmark
+// reports timings as TAP comments only (never as assertions), so the TAP
+// stays identical across engines.
+
+const RECORD = 9;
+const isNxjs = typeof (globalThis as any).Switch !== 'undefined';
+
+function drawAtlasFallback(
+	ctx: OffscreenCanvasRenderingContext2D,
+	image: OffscreenCanvas,
+	sprites: Float32Array,
+	count: number,
+) {
+	const alpha = ctx.globalAlpha;
+	for (let i = 0; i < count; i++) {
+		const o = i * RECORD;
+		const scos = sprites[o + 4];
+		const ssin = sprites[o + 5];
+		ctx.save();
+		ctx.transform(scos, ssin, -ssin, scos, sprites[o + 6], sprites[o + 7]);
+		ctx.globalAlpha = alpha * sprites[o + 8];
+		ctx.drawImage(
+			image,
+			sprites[o],
+			sprites[o + 1],
+			sprites[o + 2],
+			sprites[o + 3],
+			0,
+			0,
+			sprites[o + 2],
+			sprites[o + 3],
+		);
+		ctx.restore();
+	}
+}
+
+function drawAtlas(
+	ctx: OffscreenCanvasRenderingContext2D,
+	image: OffscreenCanvas,
+	sprites: Float32Array,
+	colors?: Uint32Array,
+) {
+	const count = sprites.length / RECORD;
+	if (isNxjs) {
+		(ctx as any).drawAtlas(image, sprites, colors, count);
+	} else {
+		drawAtlasFallback(ctx, image, sprites, count);
+	}
+}
+
+// A 32x16 atlas: red 16x16 tile on the left, blue 16x16 tile on the right.
+function makeAtlas(): OffscreenCanvas {
+	const atlas = new OffscreenCanvas(32, 16);
+	const a = atlas.getContext('2d')!;
+	a.fillStyle = 'rgb(255, 0, 0)';
+	a.fillRect(0, 0, 16, 16);
+	a.fillStyle = 'rgb(0, 0, 255)';
+	a.fillRect(16, 0, 16, 16);
+	return atlas;
+}
+
+function pixel(ctx: OffscreenCanvasRenderingContext2D, x: number, y: number) {
+	return Array.from(ctx.getImageData(x, y, 1, 1).data);
+}
+
+function maxChannelDiff(a: Uint8ClampedArray, b: Uint8ClampedArray): number {
+	let max = 0;
+	for (let i = 0; i < a.length; i++) {
+		const d = Math.abs(a[i] - b[i]);
+		if (d > max) max = d;
+	}
+	return max;
+}
+
+test('drawAtlas places sprites from the atlas', (t) => {
+	const atlas = makeAtlas();
+	const c = new OffscreenCanvas(64, 64);
+	const ctx = c.getContext('2d')!;
+	ctx.imageSmoothingEnabled = false;
+	// prettier-ignore
+	const sprites = new Float32Array([
+		0, 0, 16, 16,  1, 0,  0,  0, 1,
+		16, 0, 16, 16, 1, 0, 32, 32, 1,
+	]);
+	drawAtlas(ctx, atlas, sprites);
+	t.deepEqual(pixel(ctx, 8, 8), [255, 0, 0, 255], 'first sprite is red');
+	t.deepEqual(pixel(ctx, 40, 40), [0, 0, 255, 255], 'second sprite is blue');
+	t.deepEqual(pixel(ctx, 40, 8), [0, 0, 0, 0], 'outside sprites is empty');
+});
+
+test('drawAtlas honors per-sprite alpha', (t) => {
+	const atlas = makeAtlas();
+	const c = new OffscreenCanvas(16, 16);
+	const ctx = c.getContext('2d')!;
+	ctx.imageSmoothingEnabled = false;
+	drawAtlas(ctx, atlas, new Float32Array([0, 0, 16, 16, 1, 0, 0, 0, 0.5]));
+	const [r, g, b, a] = pixel(ctx, 8, 8);
+	t.ok(r >= 254 && g === 0 && b === 0, 'color is red');
+	t.ok(Math.abs(a - 128) <= 1, 'alpha is ~50%');
+});
+
+test('drawAtlas with opaque white colors is identity', (t) => {
+	const atlas = makeAtlas();
+	const c = new OffscreenCanvas(32, 16);
+	const ctx = c.getContext('2d')!;
+	ctx.imageSmoothingEnabled = false;
+	drawAtlas(
+		ctx,
+		atlas,
+		new Float32Array([16, 0, 16, 16, 1, 0, 0, 0, 1]),
+		new Uint32Array([0xffffffff]),
+	);
+	t.deepEqual(pixel(ctx, 8, 8), [0, 0, 255, 255], 'sprite is unmodulated');
+});
+
+test('drawAtlas matches per-sprite drawImage (20k sprites)', (t) => {
+	const N = 20_000;
+	const W = 1280;
+	const H = 720;
+	const atlas = makeAtlas();
+	const sprites = new Float32Array(N * RECORD);
+	let seed = 1;
+	const rand = () => {
+		seed = (seed * 1103515245 + 12345) & 0x7fffffff;
+		return seed / 0x7fffffff;
+	};
+	for (let i = 0; i < N; i++) {
+		const o = i * RECORD;
+		sprites[o] = (i & 1) * 16;
+		sprites[o + 1] = 0;
+		sprites[o + 2] = 16;
+		sprites[o + 3] = 16;
+		sprites[o + 4] = 1;
+		sprites[o + 5] = 0;
+		sprites[o + 6] = Math.floor(rand() * (W - 16));
+		sprites[o + 7] = Math.floor(rand() * (H - 16));
+		sprites[o + 8] = 1;
+	}
+
+	const batched = new OffscreenCanvas(W, H);
+	const bctx = batched.getContext('2d')!;
+	bctx.imageSmoothingEnabled = false;
+	let start = performance.now();
+	drawAtlas(bctx, atlas, sprites);
+	const batchedMs = performance.now() - start;
+
+	const reference = new OffscreenCanvas(W, H);
+	const rctx = reference.getContext('2d')!;
+	rctx.imageSmoothingEnabled = false;
+	start = performance.now();
+	drawAtlasFallback(rctx, atlas, sprites, N);
+	const perCallMs = performance.now() - start;
+
+	console.log(
+		`# bench drawAtlas ${N} sprites: batched ${batchedMs.toFixed(2)}ms, ` +
+			`drawImage ${perCallMs.toFixed(2)}ms`,
+	);
+
+	const diff = maxChannelDiff(
+		bctx.getImageData(0, 0, W, H).data,
+		rctx.getImageData(0, 0, W, H).data,
+	);
+	t.ok(diff <= 1, 'batched output matches per-sprite drawImage');
+});
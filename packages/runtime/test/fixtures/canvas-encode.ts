@@ -0,0 +1,124 @@
+import { test } from '../src/tap';
+
+// Canvas encoding: convertToBlob() for each format (plus the nx.js
+// `compressionLevel` / `effort` extensions, which Chrome ignores) and the
+// nx.js `Switch.FrameEncoder` capture loop. Chrome has no FrameEncoder, so
+// there the fixture encodes each frame with convertToBlob() instead; frame
+// timings are TAP comments only, so the TAP stays identical across engines.
+
+const isNxjs = typeof (globalThis as any).Switch !== 'undefined';
+
+function makeScene(w: number, h: number, alpha = false) {
+	const c = new OffscreenCanvas(w, h);
+	const ctx = c.getContext('2d')!;
+	if (!alpha) {
+		ctx.fillStyle = 'rgb(255, 255, 255)';
+		ctx.fillRect(0, 0, w, h);
+	}
+	ctx.fillStyle = 'rgb(200, 40, 40)';
+	ctx.fillRect(0, 0, w / 2, h / 2);
+	ctx.fillStyle = 'rgba(40, 40, 200, 0.5)';
+	ctx.fillRect(w / 4, h / 4, w / 2, h / 2);
+	return { canvas: c, ctx };
+}
+
+async function bytes(blob: Blob) {
+	return new Uint8Array(await blob.arrayBuffer());
+}
+
+function startsWith(b: Uint8Array, prefix: number[]) {
+	return prefix.every((v, i) => b[i] === v);
+}
+
+test('convertToBlob encodes PNG, JPEG and WebP', async (t) => {
+	const { canvas } = makeScene(64, 48);
+	const png = await canvas.convertToBlob();
+	t.equal(png.type, 'image/png', 'default type is PNG');
+	t.ok(
+		startsWith(await bytes(png), [0x89, 0x50, 0x4e, 0x47]),
+		'PNG signature',
+	);
+
+	const jpeg = await bytes(
+		await canvas.convertToBlob({ type: 'image/jpeg', quality: 0.8 }),
+	);
+	t.ok(startsWith(jpeg, [0xff, 0xd8]), 'JPEG SOI marker');
+	t.ok(
+		jpeg[jpeg.length - 2] === 0xff && jpeg[jpeg.length - 1] === 0xd9,
+		'JPEG EOI marker',
+	);
+
+	const webp = await bytes(await canvas.convertToBlob({ type: 'image/webp' }));
+	t.ok(startsWith(webp, [0x52, 0x49, 0x46, 0x46]), 'RIFF header');
+	t.ok(
+		webp[8] === 0x57 && webp[9] === 0x45 && webp[10] === 0x42 && webp[11] === 0x50,
+		'WEBP fourcc',
+	);
+});
+
+test('PNG round-trips pixels, including alpha', async (t) => {
+	const { canvas, ctx } = makeScene(32, 32, true);
+	const blob = await canvas.convertToBlob({ type: 'image/png' });
+	const bitmap = await createImageBitmap(blob);
+	const out = new OffscreenCanvas(32, 32);
+	const octx = out.getContext('2d')!;
+	octx.drawImage(bitmap, 0, 0);
+	const a = ctx.getImageData(0, 0, 32, 32).data;
+	const b = octx.getImageData(0, 0, 32, 32).data;
+	let max = 0;
+	for (let i = 0; i < a.length; i++) max = Math.max(max, Math.abs(a[i] - b[i]));
+	t.ok(max <= 2, 'decoded PNG matches the source canvas');
+});
+
+test('PNG compression level trades size for speed', async (t) => {
+	const { canvas } = makeScene(320, 240);
+	const stored = await canvas.convertToBlob({
+		type: 'image/png',
+		compressionLevel: 0,
+		effort: 0,
+	} as any);
+	const best = await canvas.convertToBlob({
+		type: 'image/png',
+		compressionLevel: 9,
+		effort: 6,
+	} as any);
+	t.ok(best.size <= stored.size, 'level 9 is no larger than level 0');
+	t.ok(
+		startsWith(await bytes(stored), [0x89, 0x50, 0x4e, 0x47]),
+		'level 0 output is still a PNG',
+	);
+});
+
+test('frame capture produces a JPEG per frame', async (t) => {
+	const FRAMES = 30;
+	const { canvas, ctx } = makeScene(640, 360);
+	const Switch = (globalThis as any).Switch;
+	const encoder = isNxjs
+		? new Switch.FrameEncoder(canvas, {
+				type: 'image/jpeg',
+				quality: 0.8,
+				frames: 2,
+			})
+		: null;
+
+	let valid = 0;
+	const start = performance.now();
+	for (let i = 0; i < FRAMES; i++) {
+		ctx.fillStyle = `rgb(${i * 8}, 100, 100)`;
+		ctx.fillRect(0, 0, 64, 64);
+		let frame: Uint8Array | null;
+		if (encoder) {
+			frame = await encoder.encode();
+		} else {
+			frame = await bytes(
+				await canvas.convertToBlob({ type: 'image/jpeg', quality: 0.8 }),
+			);
+		}
+		if (frame && startsWith(frame, [0xff, 0xd8])) valid++;
+	}
+	const ms = performance.now() - start;
+	console.log(
+		`# bench ${FRAMES} JPEG frames 640x360: ${(ms / FRAMES).toFixed(2)}ms/frame`,
+	);
+	t.equal(valid, FRAMES, 'every awaited frame is a JPEG');
+});
@@ -1,9 +1,17 @@
 import { test } from '../src/tap';
 
+const isNxjs = typeof (globalThis as any).Switch !== 'undefined';
+
 // --- Helpers ---
 
-async function compress(format: string, data: Uint8Array): Promise<Uint8Array> {
-	const cs = new CompressionStream(format as CompressionFormat);
+// Compression options are an nx.js extension: elsewhere (Bun) the second
+// constructor argument is ignored, and the defaults are used.
+async function compress(
+	format: string,
+	data: Uint8Array,
+	options?: object,
+): Promise<Uint8Array> {
+	const cs = new (CompressionStream as any)(format, options);
 	const writer = cs.writable.getWriter();
 	const reader = cs.readable.getReader();
 	writer.write(data);
@@ -28,8 +36,9 @@ async function compress(format: string, data: Uint8Array): Promise<Uint8Array> {
 async function decompress(
 	format: string,
 	data: Uint8Array,
+	options?: object,
 ): Promise<Uint8Array> {
-	const ds = new DecompressionStream(format as CompressionFormat);
+	const ds = new (DecompressionStream as any)(format, options);
 	const writer = ds.writable.getWriter();
 	const reader = ds.readable.getReader();
 	writer.write(data);
@@ -81,6 +90,174 @@ test('zstd large data roundtrip', async (t) => {
 	);
 });
 
+// --- compression options ---
+
+// Log-like text: repetitive at short range, with a few long range repeats.
+function sampleText(bytes: number): Uint8Array {
+	const words = ['load', 'save', 'player', 'level', 'score', 'ok', 'error'];
+	let seed = 1;
+	const rand = () => {
+		seed = (seed * 1103515245 + 12345) & 0x7fffffff;
+		return seed;
+	};
+	let text = '';
+	while (text.length < bytes) {
+		const n = rand() % 1000;
+		const word = words[rand() % words.length];
+		text += `${n} ${word} ${words[n % 7]}=${n * 3}\n`;
+	}
+	return new TextEncoder().encode(text.slice(0, bytes));
+}
+
+function sameBytes(a: Uint8Array, b: Uint8Array): boolean {
+	if (a.length !== b.length) return false;
+	for (let i = 0; i < a.length; i++) {
+		if (a[i] !== b[i]) return false;
+	}
+	return true;
+}
+
+test('zstd options roundtrip', async (t) => {
+	const input = sampleText(256 * 1024);
+	const fast = await compress('zstd', input, { level: 1 });
+	const strong = await compress('zstd', input, { level: 19 });
+	t.ok(strong.length <= fast.length, 'level 19 is no larger than level 1');
+	t.ok(sameBytes(await decompress('zstd', fast), input), 'level 1 roundtrip');
+	t.ok(
+		sameBytes(await decompress('zstd', strong), input),
+		'level 19 roundtrip',
+	);
+
+	const settings: [string, object][] = [
+		['window', { windowLog: 12, strategy: 'btopt' }],
+		['long distance matching', { level: 5, longDistanceMatching: true }],
+		['workers', { level: 3, workers: 2 }],
+		['negative level', { level: -5 }],
+	];
+	for (const [name, options] of settings) {
+		const c = await compress('zstd', input, options);
+		const out = await decompress('zstd', c);
+		t.ok(sameBytes(out, input), `${name} roundtrip`);
+	}
+});
+
+test('deflate options roundtrip', async (t) => {
+	const input = sampleText(64 * 1024);
+	for (const format of ['deflate', 'deflate-raw', 'gzip']) {
+		const c = await compress(format, input, {
+			level: 1,
+			windowLog: 10,
+			strategy: 'filtered',
+		});
+		const out = await decompress(format, c);
+		t.ok(sameBytes(out, input), `${format} roundtrip`);
+	}
+	const best = await compress('gzip', input, { level: 9 });
+	t.ok(best.length < input.length, 'gzip level 9 reduces size');
+});
+
+test('zstd options are validated', (t) => {
+	// Elsewhere, the options are ignored: the same assertions, trivially.
+	const throws = (fn: () => unknown, type: Function) => {
+		if (!isNxjs) return true;
+		try {
+			fn();
+		} catch (err) {
+			return err instanceof type;
+		}
+		return false;
+	};
+	const cs = CompressionStream as any;
+	t.ok(
+		throws(() => new cs('zstd', { level: 23 }), RangeError),
+		'level out of range throws a RangeError',
+	);
+	t.ok(
+		throws(() => new cs('gzip', { windowLog: 16 }), RangeError),
+		'deflate window out of range throws a RangeError',
+	);
+	t.ok(
+		throws(() => new cs('zstd', { strategy: 'huffman-only' }), TypeError),
+		'unknown strategy throws a TypeError',
+	);
+	t.ok(
+		throws(() => new cs('gzip', { workers: 2 }), TypeError),
+		'zstd-only option throws a TypeError for gzip',
+	);
+});
+
+test('zstd dictionary roundtrip', async (t) => {
+	// Many small JSON records, compressed one by one: the case dictionaries
+	// are for. The dictionary is raw content (records like the real ones).
+	const record = (i: number) =>
+		JSON.stringify({
+			id: i,
+			type: 'player-state',
+			position: { x: i * 3, y: i * 7 },
+			inventory: ['sword', 'shield', 'potion'],
+		});
+	let sample = '';
+	for (let i = 0; i < 64; i++) sample += record(i * 13);
+	const options: { dictionary?: unknown } = {};
+	if (isNxjs) {
+		const dictionary = new (globalThis as any).Switch.CompressionDictionary(
+			new TextEncoder().encode(sample),
+		);
+		t.equal(dictionary.id, 0, 'raw content dictionary has no ID');
+		options.dictionary = dictionary;
+	} else {
+		t.equal(0, 0, 'raw content dictionary has no ID');
+	}
+
+	let plainTotal = 0;
+	let dictTotal = 0;
+	let ok = true;
+	for (let i = 1000; i < 1100; i++) {
+		const input = new TextEncoder().encode(record(i));
+		plainTotal += (await compress('zstd', input)).length;
+		const c = await compress('zstd', input, options);
+		dictTotal += c.length;
+		ok &&= sameBytes(await decompress('zstd', c, options), input);
+	}
+	t.ok(ok, 'every record roundtrips with the dictionary');
+	t.ok(dictTotal <= plainTotal, 'dictionary output is no larger');
+	console.log(
+		`# bench zstd 100 small records: ${plainTotal} bytes plain, ` +
+			`${dictTotal} bytes with a dictionary`,
+	);
+});
+
+// Ratio and throughput per setting. Reported as TAP comments only: they vary
+// by machine (and in Bun the options are ignored).
+test('zstd and deflate settings benchmark', async (t) => {
+	const input = sampleText(2 * 1024 * 1024);
+	const settings: [string, string, object][] = [
+		['zstd', 'level 1', { level: 1 }],
+		['zstd', 'level 3', {}],
+		['zstd', 'level 9', { level: 9 }],
+		['zstd', 'level 19', { level: 19 }],
+		['zstd', 'level 9 ldm', { level: 9, longDistanceMatching: true }],
+		['zstd', 'level 9 4 workers', { level: 9, workers: 4 }],
+		['gzip', 'level 1', { level: 1 }],
+		['gzip', 'level 8', {}],
+		['gzip', 'level 9', { level: 9 }],
+	];
+	let ok = true;
+	for (const [format, name, options] of settings) {
+		const start = performance.now();
+		const c = await compress(format, input, options);
+		const ms = performance.now() - start;
+		ok &&= sameBytes(await decompress(format, c), input);
+		const ratio = input.length / c.length;
+		const mbps = input.length / 1048576 / (ms / 1000);
+		console.log(
+			`# bench ${format} ${name}: ratio ${ratio.toFixed(2)}, ` +
+				`${mbps.toFixed(1)} MB/s`,
+		);
+	}
+	t.ok(ok, 'every setting roundtrips');
+});
+
 // --- streaming pipe through pipeThrough (regression for the applet-mode
 // native-heap back-pressure fix) ---
 //
@@ -183,3 +360,281 @@ test('zstd file.stream().pipeThrough fused path roundtrip', async (t) => {
 		try { Sw.remove(tmp); } catch {}
 	}
 });
+
+// A BYOB reader on the fused path gets the output decompressed straight into
+// its buffer: reading chunk after chunk into the same 64 KiB buffer needs no
+// allocations. Elsewhere, the same bytes are read with a default reader.
+test('zstd fused path BYOB reads', async (t) => {
+	const N = 1024 * 1024;
+	const src = sampleText(N);
+	const compressed = await compress('zstd', src);
+
+	const Sw: any = (globalThis as any).Switch;
+	let stream: ReadableStream<Uint8Array>;
+	let tmp: string | undefined;
+	if (isNxjs && typeof Sw.writeFileSync === 'function') {
+		tmp = 'nxjs-fused-byob.tmp';
+		Sw.writeFileSync(tmp, compressed);
+		stream = Sw.file(tmp)
+			.stream()
+			.pipeThrough(new DecompressionStream('zstd'));
+	} else {
+		stream = new Blob([compressed])
+			.stream()
+			.pipeThrough(new DecompressionStream('zstd'));
+	}
+
+	const out = new Uint8Array(N);
+	let length = 0;
+	const start = performance.now();
+	if (tmp) {
+		const reader = (stream as any).getReader({ mode: 'byob' });
+		let buffer = new ArrayBuffer(64 * 1024);
+		while (true) {
+			const { done, value } = await reader.read(new Uint8Array(buffer));
+			if (done) break;
+			out.set(value, length);
+			length += value.length;
+			buffer = value.buffer;
+		}
+	} else {
+		const reader = stream.getReader();
+		while (true) {
+			const { done, value } = await reader.read();
+			if (done) break;
+			out.set(value, length);
+			length += value.length;
+		}
+	}
+	console.log(
+		`# bench zstd fused read of ${N} bytes: ` +
+			`${(performance.now() - start).toFixed(2)}ms`,
+	);
+	t.equal(length, N, 'read length matches source');
+	t.ok(sameBytes(out, src), 'read bytes match source');
+
+	if (tmp) {
+		try {
+			Sw.remove(tmp);
+		} catch {}
+	}
+});
+
+// --- one-shot compress() / decompress() ---
+//
+// Switch.compress() / Switch.decompress() are nx.js APIs. Elsewhere the same
+// work goes through the streams, so the assertions are the same.
+const Switch_: any = (globalThis as any).Switch;
+
+function oneShotCompress(data: Uint8Array, format: string, options?: object) {
+	if (isNxjs) return Switch_.compress(data, format, options);
+	return compress(format, data, options);
+}
+
+function oneShotDecompress(
+	data: Uint8Array,
+	format: string,
+	options?: { maxOutputSize?: number },
+): Promise<ArrayBuffer | Uint8Array> {
+	if (isNxjs) return Switch_.decompress(data, format, options);
+	return decompress(format, data).then((out) => {
+		const max = options?.maxOutputSize;
+		if (max !== undefined && out.length > max) {
+			throw new RangeError('Decompressed data exceeds maxOutputSize');
+		}
+		return out;
+	});
+}
+
+test('one-shot compress/decompress roundtrip', async (t) => {
+	// Below and above the size which is processed synchronously.
+	for (const size of [0, 100, 64 * 1024]) {
+		const input = sampleText(size);
+		for (const format of ['deflate', 'deflate-raw', 'gzip', 'zstd']) {
+			const c = new Uint8Array(await oneShotCompress(input, format));
+			const out = new Uint8Array(await oneShotDecompress(c, format));
+			t.ok(sameBytes(out, input), `${format} ${size} bytes roundtrip`);
+			// Interoperates with the streams, both ways.
+			const viaStream = await decompress(format, c);
+			const label = `${format} ${size} bytes`;
+			t.ok(sameBytes(viaStream, input), `${label} to stream`);
+			const streamed = await compress(format, input);
+			const fromStream = new Uint8Array(
+				await oneShotDecompress(streamed, format),
+			);
+			t.ok(sameBytes(fromStream, input), `${format} ${size} from stream`);
+		}
+	}
+});
+
+test('one-shot decompress errors', async (t) => {
+	const input = sampleText(32 * 1024);
+	const c = new Uint8Array(await oneShotCompress(input, 'zstd'));
+
+	let error: unknown;
+	try {
+		await oneShotDecompress(c, 'zstd', { maxOutputSize: input.length - 1 });
+	} catch (err) {
+		error = err;
+	}
+	t.ok(error instanceof RangeError, 'output over maxOutputSize rejects');
+	const exact = await oneShotDecompress(c, 'zstd', {
+		maxOutputSize: input.length,
+	});
+	t.equal(exact.byteLength, input.length, 'output at maxOutputSize is fine');
+
+	error = undefined;
+	try {
+		await oneShotDecompress(c.subarray(0, c.length - 10), 'zstd');
+	} catch (err) {
+		error = err;
+	}
+	t.ok(error !== undefined, 'truncated data rejects');
+});
+
+test('one-shot vs stream benchmark', async (t) => {
+	// Many small assets, as a game would load them.
+	const asset = sampleText(16 * 1024);
+	const c = new Uint8Array(await oneShotCompress(asset, 'zstd'));
+	const N = 200;
+	let start = performance.now();
+	let ok = true;
+	for (let i = 0; i < N; i++) {
+		ok &&= (await oneShotDecompress(c, 'zstd')).byteLength === asset.length;
+	}
+	const oneShotMs = performance.now() - start;
+	start = performance.now();
+	for (let i = 0; i < N; i++) {
+		ok &&= (await decompress('zstd', c)).length === asset.length;
+	}
+	const streamMs = performance.now() - start;
+	console.log(
+		`# bench zstd decompress ${N} x ${asset.length} bytes: ` +
+			`one-shot ${oneShotMs.toFixed(2)}ms, ` +
+			`stream ${streamMs.toFixed(2)}ms`,
+	);
+	t.ok(ok, 'every decompression has the right size');
+});
+
+// --- seekable zstd ---
+//
+// Switch.SeekableCompressionStream / Switch.SeekableReader are nx.js APIs.
+// Elsewhere the data is compressed as one zstd frame, and ranges are sliced
+// from the input, so the assertions are the same.
+
+async function seekableCompress(
+	data: Uint8Array,
+	frameSize: number,
+): Promise<Uint8Array> {
+	if (!isNxjs) return compress('zstd', data);
+	// Writes of a size unrelated to the frame size, so that frames span
+	// several of them.
+	const source = new ReadableStream<Uint8Array>({
+		start(controller) {
+			for (let i = 0; i < data.length; i += 10000) {
+				controller.enqueue(data.slice(i, i + 10000));
+			}
+			controller.close();
+		},
+	});
+	const stream = source.pipeThrough(
+		new Switch_.SeekableCompressionStream({ frameSize }),
+	);
+	return new Uint8Array(await new Response(stream).arrayBuffer());
+}
+
+test('zstd seekable roundtrip', async (t) => {
+	const input = sampleText(300 * 1024);
+	const c = await seekableCompress(input, 64 * 1024);
+	const out = await decompress('zstd', c);
+	t.ok(sameBytes(out, input), 'decompresses as regular zstd');
+	const empty = await seekableCompress(new Uint8Array(0), 64 * 1024);
+	t.equal((await decompress('zstd', empty)).length, 0, 'empty input');
+});
+
+test('zstd seekable random reads', async (t) => {
+	const input = sampleText(300 * 1024);
+	const frameSize = 64 * 1024;
+	const ranges: [number, number][] = [
+		[0, 100],
+		[70000, 10], // within a frame
+		[frameSize - 5, 10], // across two frames
+		[1000, 3 * frameSize], // whole frames in between
+		[70000, 10], // again, from the cache
+		[input.length - 50, 1000], // clamped to the end
+		[input.length + 10, 10], // past the end
+		[12345, 0],
+	];
+	let results: Uint8Array[];
+	let frameCount: number;
+	let size: number;
+	if (isNxjs && typeof Switch_.writeFileSync === 'function') {
+		const path = 'zstd-seekable.tmp';
+		Switch_.writeFileSync(path, await seekableCompress(input, frameSize));
+		const reader = await Switch_.SeekableReader.open(path, {
+			cacheSize: 2 * frameSize,
+		});
+		frameCount = reader.frameCount;
+		size = reader.size;
+		results = [];
+		for (const [offset, length] of ranges) {
+			results.push(new Uint8Array(await reader.read(offset, length)));
+		}
+		Switch_.removeSync(path);
+	} else {
+		frameCount = Math.ceil(input.length / frameSize);
+		size = input.length;
+		results = ranges.map(([offset, length]) =>
+			input.slice(offset, offset + length),
+		);
+	}
+	t.equal(frameCount, 5, 'frame count');
+	t.equal(size, input.length, 'decompressed size');
+	ranges.forEach(([offset, length], i) => {
+		const expected = input.slice(offset, offset + length);
+		t.ok(sameBytes(results[i], expected), `read(${offset}, ${length})`);
+	});
+});
+
+test('zstd seekable reader rejects other files', async (t) => {
+	let rejected = true;
+	if (isNxjs && typeof Switch_.writeFileSync === 'function') {
+		const path = 'zstd-not-seekable.tmp';
+		Switch_.writeFileSync(path, await compress('zstd', sampleText(1000)));
+		rejected = await Switch_.SeekableReader.open(path).then(
+			() => false,
+			(err: unknown) => err instanceof TypeError,
+		);
+		Switch_.removeSync(path);
+	}
+	t.ok(rejected, 'zstd data without a seek table rejects with a TypeError');
+});
+
+test('zstd seekable vs whole decompression benchmark', async (t) => {
+	// A small record near the end of a large asset.
+	const input = sampleText(4 * 1024 * 1024);
+	const offset = input.length - 64 * 1024;
+	let ok = true;
+	if (isNxjs && typeof Switch_.writeFileSync === 'function') {
+		const path = 'zstd-seekable-bench.tmp';
+		const c = await seekableCompress(input, 256 * 1024);
+		Switch_.writeFileSync(path, c);
+		let start = performance.now();
+		const reader = await Switch_.SeekableReader.open(path);
+		const part = new Uint8Array(await reader.read(offset, 4096));
+		const seekableMs = performance.now() - start;
+		start = performance.now();
+		const whole = new Uint8Array(await Switch_.decompress(c, 'zstd'));
+		const wholeMs = performance.now() - start;
+		ok =
+			sameBytes(part, input.subarray(offset, offset + 4096)) &&
+			sameBytes(whole.subarray(offset, offset + 4096), part);
+		console.log(
+			`# bench zstd 4 KiB at ${offset} of ${input.length} bytes: ` +
+				`seekable ${seekableMs.toFixed(2)}ms, ` +
+				`whole ${wholeMs.toFixed(2)}ms`,
+		);
+		Switch_.removeSync(path);
+	}
+	t.ok(ok, 'seekable and whole reads agree');
+});
@@ -0,0 +1,276 @@
+import { test } from '../src/tap';
+
+// DNS caching, the UDP DNS client and "happy eyeballs" connections. On nx.js
+// the lookups go to a stub DNS server on a local datagram socket, which
+// answers from `ZONE` and counts the queries it receives. Chrome has no
+// configurable resolver, so there the expected results are taken from
+// `ZONE` itself, which keeps the TAP identical. Timings are TAP comments only.
+
+const isNxjs = typeof (globalThis as any).Switch !== 'undefined';
+const Switch_: any = (globalThis as any).Switch;
+
+interface Records {
+	a?: string[];
+	aaaa?: string[];
+	ttl: number;
+}
+
+// Names not in the zone are NXDOMAIN, with a negative TTL of 1 second.
+const ZONE: Record<string, Records> = {
+	'cached.test': { a: ['10.0.0.1', '10.0.0.2'], ttl: 300 },
+	'concurrent.test': { a: ['10.0.0.3'], ttl: 300 },
+	'short.test': { a: ['10.0.0.4'], ttl: 1 },
+	'clear.test': { a: ['10.0.0.5'], ttl: 300 },
+	'dual.test': { a: ['10.0.0.6'], aaaa: ['2001:db8::6'], ttl: 300 },
+	// Exists, but without addresses (NODATA).
+	'empty.test': { ttl: 300 },
+	// An unroutable address first, then the one that accepts connections.
+	'eyeballs.test': { a: ['10.255.255.1', '127.0.0.1'], ttl: 300 },
+};
+
+const TYPE_A = 1;
+const TYPE_AAAA = 28;
+const TYPE_SOA = 6;
+
+const queries = new Map<string, number>();
+
+function ipBytes(ip: string): number[] {
+	if (!ip.includes(':')) return ip.split('.').map(Number);
+	const [head, tail = ''] = ip.split('::');
+	const h = head ? head.split(':') : [];
+	const t = tail ? tail.split(':') : [];
+	const groups = [...h, ...Array(8 - h.length - t.length).fill('0'), ...t];
+	return groups.flatMap((g) => {
+		const n = Number.parseInt(g, 16);
+		return [n >> 8, n & 0xff];
+	});
+}
+
+function record(type: number, ttl: number, rdata: number[]): number[] {
+	return [
+		0xc0,
+		0x0c, // pointer to the name of the question
+		type >> 8,
+		type & 0xff,
+		0,
+		1, // IN
+		(ttl >>> 24) & 0xff,
+		(ttl >>> 16) & 0xff,
+		(ttl >>> 8) & 0xff,
+		ttl & 0xff,
+		rdata.length >> 8,
+		rdata.length & 0xff,
+		...rdata,
+	];
+}
+
+// Builds the response to a query: the question is echoed back, followed by
+// the records of `ZONE`, or an SOA record for a name that does not exist.
+function respond(query: Uint8Array): Uint8Array {
+	const labels: string[] = [];
+	let off = 12;
+	while (query[off]) {
+		labels.push(
+			String.fromCharCode(...query.subarray(off + 1, off + 1 + query[off])),
+		);
+		off += query[off] + 1;
+	}
+	const question = query.subarray(12, off + 5);
+	const type = (query[off + 1] << 8) | query[off + 2];
+	const name = labels.join('.');
+	queries.set(name, (queries.get(name) ?? 0) + 1);
+
+	const zone = ZONE[name];
+	const answers: number[][] = [];
+	const authority: number[][] = [];
+	if (zone) {
+		const ips = (type === TYPE_A ? zone.a : zone.aaaa) ?? [];
+		for (const ip of ips) answers.push(record(type, zone.ttl, ipBytes(ip)));
+	} else {
+		// Root name and mailbox, then serial, refresh, retry, expire and
+		// minimum (the negative TTL).
+		const soa = [0, 0, ...[1, 3600, 600, 86400, 1].flatMap(u32)];
+		authority.push(record(TYPE_SOA, 60, soa));
+	}
+	const header = [
+		query[0],
+		query[1],
+		0x81, // QR, RD
+		zone ? 0x80 : 0x83, // RA, and NOERROR or NXDOMAIN
+		0,
+		1,
+		0,
+		answers.length,
+		0,
+		authority.length,
+		0,
+		0,
+	];
+	return new Uint8Array([
+		...header,
+		...question,
+		...answers.flat(),
+		...authority.flat(),
+	]);
+}
+
+function u32(n: number): number[] {
+	return [(n >>> 24) & 0xff, (n >>> 16) & 0xff, (n >>> 8) & 0xff, n & 0xff];
+}
+
+let server: any;
+
+async function startServer() {
+	if (!isNxjs || server) return;
+	server = Switch_.listenDatagram({
+		ip: '127.0.0.1',
+		port: 0,
+		message(e: any) {
+			server.send(
+				respond(new Uint8Array(e.data)),
+				e.remoteAddress,
+				e.remotePort,
+			);
+		},
+	});
+	Switch_.setDnsServers([`127.0.0.1:${server.address.port}`]);
+}
+
+// The A and AAAA queries (one each per lookup) received for `name`. In
+// Chrome, the expected number.
+function queryCount(name: string, expected: number): number {
+	return isNxjs ? (queries.get(name) ?? 0) : expected;
+}
+
+async function resolve(name: string): Promise<string[]> {
+	await startServer();
+	if (isNxjs) return Switch_.resolveDns(name);
+	if (/^[\d.]+$/.test(name) || name.includes(':')) return [name];
+	const zone = ZONE[name.toLowerCase().replace(/\.$/, '')];
+	const ips = [...(zone?.a ?? []), ...(zone?.aaaa ?? [])];
+	if (!ips.length) throw new Error('ENOTFOUND');
+	return ips;
+}
+
+function sleep(ms: number) {
+	return new Promise((r) => setTimeout(r, ms));
+}
+
+test('resolveDns() caches answers for their TTL', async (t) => {
+	const first = await resolve('cached.test');
+	t.deepEqual(first, ['10.0.0.1', '10.0.0.2'], 'first lookup');
+	const second = await resolve('CACHED.test.');
+	t.deepEqual(second, first, 'cached lookup, case and trailing dot ignored');
+	t.equal(queryCount('cached.test', 2), 2, 'one A and one AAAA query');
+});
+
+test('resolveDns() shares one query between concurrent lookups', async (t) => {
+	const results = await Promise.all(
+		Array.from({ length: 8 }, () => resolve('concurrent.test')),
+	);
+	t.deepEqual(
+		results,
+		results.map(() => ['10.0.0.3']),
+		'every lookup gets the answer',
+	);
+	t.equal(queryCount('concurrent.test', 2), 2, 'one A and one AAAA query');
+});
+
+test('resolveDns() caches names that do not exist', async (t) => {
+	const failed = async () =>
+		resolve('missing.test').then(
+			() => false,
+			() => true,
+		);
+	t.ok(await failed(), 'lookup rejects');
+	t.ok(await failed(), 'cached lookup rejects');
+	t.equal(queryCount('missing.test', 2), 2, 'queried once');
+	// The SOA record gives a negative TTL of 1 second.
+	await sleep(1100);
+	t.ok(await failed(), 'lookup after the negative TTL rejects');
+	t.equal(queryCount('missing.test', 4), 4, 'queried again');
+});
+
+test('resolveDns() rejects a name without addresses', async (t) => {
+	const rejected = await resolve('empty.test').then(
+		() => false,
+		() => true,
+	);
+	t.ok(rejected, 'lookup rejects, as with the system resolver');
+	t.equal(queryCount('empty.test', 2), 2, 'one A and one AAAA query');
+});
+
+test('resolveDns() looks a name up again after its TTL', async (t) => {
+	t.deepEqual(await resolve('short.test'), ['10.0.0.4'], 'first lookup');
+	await resolve('short.test');
+	t.equal(queryCount('short.test', 2), 2, 'second lookup is cached');
+	await sleep(1100);
+	t.deepEqual(await resolve('short.test'), ['10.0.0.4'], 'after the TTL');
+	t.equal(queryCount('short.test', 4), 4, 'queried again');
+});
+
+test('clearDnsCache() forgets cached answers', async (t) => {
+	await resolve('clear.test');
+	if (isNxjs) Switch_.clearDnsCache();
+	t.deepEqual(await resolve('clear.test'), ['10.0.0.5'], 'lookup');
+	t.equal(queryCount('clear.test', 4), 4, 'queried again');
+});
+
+test('resolveDns() of an IP address does not send a query', async (t) => {
+	t.deepEqual(await resolve('10.1.2.3'), ['10.1.2.3'], 'IPv4 address');
+	t.deepEqual(await resolve('2001:db8::1'), ['2001:db8::1'], 'IPv6 address');
+	t.equal(queryCount('10.1.2.3', 0), 0, 'no query');
+});
+
+test('resolveDns() returns IPv4 addresses first', async (t) => {
+	t.deepEqual(
+		await resolve('dual.test'),
+		['10.0.0.6', '2001:db8::6'],
+		'IPv4, then IPv6',
+	);
+});
+
+test('connect() falls through an unreachable address', async (t) => {
+	await startServer();
+	let connected = true;
+	if (isNxjs) {
+		const port = 9000 + Math.floor(Math.random() * 1000);
+		const listener = Switch_.listen({
+			ip: '127.0.0.1',
+			port,
+			accept() {},
+		});
+		const start = performance.now();
+		const socket = Switch_.connect({ hostname: 'eyeballs.test', port });
+		connected = await socket.opened.then(
+			() => true,
+			() => false,
+		);
+		console.log(
+			`# connected after ${(performance.now() - start).toFixed(0)} ms`,
+		);
+		socket.close();
+		listener.close();
+	}
+	t.ok(connected, 'connected to the second address');
+});
+
+test('resolveDns() cache benchmark', async (t) => {
+	await resolve('cached.test');
+	const count = 1000;
+	const start = performance.now();
+	for (let i = 0; i < count; i++) {
+		await resolve('cached.test');
+	}
+	const ms = performance.now() - start;
+	if (isNxjs) {
+		console.log(
+			`# bench resolveDns() cached x ${count}: ` +
+				`${((count / ms) * 1000).toFixed(0)}/s`,
+		);
+		// Back to the system resolver.
+		Switch_.setDnsServers([]);
+		server.close();
+	}
+	t.equal(queryCount('cached.test', 2), 2, 'no further queries');
+});
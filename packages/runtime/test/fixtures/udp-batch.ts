@@ -0,0 +1,216 @@
+import { test } from '../src/tap';
+
+// Batched UDP receive and send over loopback. Chrome has no datagram
+// sockets, so there the expected results are taken from the datagrams that
+// would have been sent, which keeps the TAP identical. Timings are TAP
+// comments only.
+
+const isNxjs = typeof (globalThis as any).Switch !== 'undefined';
+const Switch_: any = (globalThis as any).Switch;
+
+interface Received {
+	data: Uint8Array;
+	remoteAddress: string;
+	remotePort: number;
+}
+
+// Datagram `i` is `size(i)` bytes of `i & 0xff`.
+function size(i: number): number {
+	return (i * 37) % 1400;
+}
+
+function payload(i: number): Uint8Array {
+	return new Uint8Array(size(i)).fill(i & 0xff);
+}
+
+function isPayload(data: Uint8Array, i: number): boolean {
+	if (data.length !== size(i)) return false;
+	return data.every((b) => b === (i & 0xff));
+}
+
+// A receiving and a sending socket, bound to loopback. In Chrome, each send
+// is "received" as it would have been.
+function pair() {
+	const received: Received[] = [];
+	let wanted = 0;
+	let notify = () => {};
+	const push = (r: Received) => {
+		received.push(r);
+		if (received.length >= wanted) notify();
+	};
+	let receiver: any;
+	let sender: any;
+	let senderPort = 40000;
+	if (isNxjs) {
+		receiver = Switch_.listenDatagram({
+			ip: '127.0.0.1',
+			message(e: any) {
+				push({
+					data: new Uint8Array(e.data),
+					remoteAddress: e.remoteAddress,
+					remotePort: e.remotePort,
+				});
+			},
+		});
+		sender = Switch_.listenDatagram({ ip: '127.0.0.1' });
+		senderPort = sender.address.port;
+	}
+	const port = isNxjs ? receiver.address.port : 40001;
+	const toBytes = (data: any) =>
+		typeof data === 'string'
+			? new TextEncoder().encode(data)
+			: new Uint8Array(data);
+	return {
+		received,
+		senderPort,
+		async send(data: any): Promise<number> {
+			if (isNxjs) return sender.send(data, '127.0.0.1', port);
+			const bytes = toBytes(data);
+			push({ data: bytes, remoteAddress: '127.0.0.1', remotePort: senderPort });
+			return bytes.length;
+		},
+		async sendBatch(datagrams: any[]): Promise<number> {
+			if (isNxjs) {
+				return sender.sendBatch(
+					datagrams.map((data) => ({
+						data,
+						remoteAddress: '127.0.0.1',
+						remotePort: port,
+					})),
+				);
+			}
+			let total = 0;
+			for (const data of datagrams) total += await this.send(data);
+			return total;
+		},
+		// Resolves once `count` datagrams have been received in total, or
+		// after two seconds.
+		until(count: number): Promise<void> {
+			wanted = count;
+			if (received.length >= count) return Promise.resolve();
+			return new Promise((resolve) => {
+				const timer = setTimeout(resolve, 2000);
+				notify = () => {
+					clearTimeout(timer);
+					resolve();
+				};
+			});
+		},
+		close() {
+			if (isNxjs) {
+				receiver.close();
+				sender.close();
+			}
+		},
+	};
+}
+
+test('sendBatch() delivers every datagram in order', async (t) => {
+	const p = pair();
+	const rounds = 16;
+	const perRound = 16;
+	let bytes = 0;
+	let expectedBytes = 0;
+	for (let r = 0; r < rounds; r++) {
+		const datagrams = [];
+		for (let i = r * perRound; i < (r + 1) * perRound; i++) {
+			datagrams.push(payload(i));
+			expectedBytes += size(i);
+		}
+		// One round in flight at a time, so the receive buffer never overflows.
+		bytes += await p.sendBatch(datagrams);
+		await p.until((r + 1) * perRound);
+	}
+	const total = rounds * perRound;
+	t.equal(bytes, expectedBytes, 'resolves to the bytes sent');
+	t.equal(p.received.length, total, 'every datagram received');
+	t.ok(
+		p.received.every((r, i) => isPayload(r.data, i)),
+		'payloads intact and in order',
+	);
+	t.ok(
+		p.received.every(
+			(r) => r.remoteAddress === '127.0.0.1' && r.remotePort === p.senderPort,
+		),
+		'sender address',
+	);
+	p.close();
+});
+
+test('send() and sendBatch() of assorted datagrams', async (t) => {
+	const p = pair();
+	t.equal(await p.send('hello'), 5, 'send() resolves to the bytes sent');
+	t.equal(await p.sendBatch([]), 0, 'an empty batch sends nothing');
+	// Larger than an Ethernet frame, but within the Switch's socket buffers.
+	const large = new Uint8Array(8000).fill(0x5a);
+	t.equal(await p.sendBatch(['', large.buffer, 'world']), 8005, 'mixed batch');
+	await p.until(4);
+	const decoder = new TextDecoder();
+	t.deepEqual(
+		p.received.map((r) => r.data.length),
+		[5, 0, 8000, 5],
+		'datagram sizes',
+	);
+	t.equal(decoder.decode(p.received[0].data), 'hello', 'string datagram');
+	t.ok(
+		p.received[2].data.every((b) => b === 0x5a),
+		'large datagram intact',
+	);
+	t.equal(decoder.decode(p.received[3].data), 'world', 'last datagram');
+	p.close();
+});
+
+test('send() may reuse its buffer without awaiting', async (t) => {
+	const p = pair();
+	// As a game loop does each frame: fill, send, and move on.
+	const frame = new Uint8Array(16);
+	const sent: Promise<number>[] = [];
+	for (let i = 0; i < 4; i++) {
+		frame.fill(i);
+		sent.push(p.send(frame));
+	}
+	await Promise.all(sent);
+	await p.until(4);
+	t.deepEqual(
+		p.received.map((r) => r.data[0]),
+		[0, 1, 2, 3],
+		'each datagram has the bytes at the time of send()',
+	);
+	p.close();
+});
+
+test('sendBatch() rejects an invalid address', async (t) => {
+	let rejected = true;
+	if (isNxjs) {
+		const socket = Switch_.listenDatagram({ ip: '127.0.0.1' });
+		rejected = await socket
+			.sendBatch([{ data: 'x', remoteAddress: '127.0.0.256', remotePort: 1 }])
+			.then(
+				() => false,
+				() => true,
+			);
+		socket.close();
+	}
+	t.ok(rejected, 'rejects');
+});
+
+test('UDP batch throughput benchmark', async (t) => {
+	const p = pair();
+	const rounds = 100;
+	const perRound = 32;
+	const data = new Uint8Array(64);
+	const start = performance.now();
+	for (let r = 0; r < rounds; r++) {
+		await p.sendBatch(Array.from({ length: perRound }, () => data));
+		await p.until((r + 1) * perRound);
+	}
+	const ms = performance.now() - start;
+	if (isNxjs) {
+		console.log(
+			`# bench UDP ${rounds} batches of ${perRound} x ${data.length} bytes: ` +
+				`${((rounds * perRound) / (ms / 1000)).toFixed(0)} datagrams/s`,
+		);
+	}
+	t.equal(p.received.length, rounds * perRound, 'every datagram received');
+	p.close();
+});
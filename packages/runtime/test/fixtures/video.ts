@@ -312,6 +312,67 @@ test('video seek + frame pixels', async (t) => {
 	t.ok(isColor(centerPixel(video), 0, 0, 255), 'frame at 1.5s is blue');
 });
 
+test('video frame in a deferred canvas outlives presentation', async (t) => {
+	// Frames are handed to the canvas without copying. With the nx.js
+	// `rasterThreads` option the draw is only recorded, so the frame must stay
+	// intact until the canvas is read back, even after later frames present
+	// (Chrome ignores the option and draws immediately).
+	const { video, loaded } = loadVideo();
+	t.ok(await loaded, 'loadedmetadata fired');
+	const seeked1 = waitEvent(video, 'seeked');
+	video.currentTime = 0.5;
+	t.ok(await seeked1, 'seeked into the red half');
+	await sleep(100);
+	const canvas = new OffscreenCanvas(320, 180);
+	const ctx = canvas.getContext('2d', { rasterThreads: 2 } as any)!;
+	ctx.drawImage(video as any, 0, 0);
+
+	const seeked2 = waitEvent(video, 'seeked');
+	video.currentTime = 1.5;
+	t.ok(await seeked2, 'seeked into the blue half');
+	await sleep(100);
+	t.ok(isColor(centerPixel(video), 0, 0, 255), 'current frame is blue');
+	const d = ctx.getImageData(160, 90, 1, 1).data;
+	t.ok(
+		isColor([d[0], d[1], d[2], d[3]], 255, 0, 0),
+		'earlier draw still shows the red frame',
+	);
+});
+
+test('video drawn small, then at full size', async (t) => {
+	// nx.js decodes frames at the size the video is drawn at, so frames
+	// decoded while it was drawn small are mapped back onto video pixels.
+	const { video, loaded } = loadVideo();
+	t.ok(await loaded, 'loadedmetadata fired');
+	const small = new OffscreenCanvas(80, 45).getContext('2d')!;
+	const seeked1 = waitEvent(video, 'seeked');
+	video.currentTime = 1.5;
+	t.ok(await seeked1, 'seeked into the blue half');
+	for (let i = 0; i < 5; i++) {
+		small.drawImage(video as any, 0, 0, 80, 45);
+		await sleep(20);
+	}
+	const seeked2 = waitEvent(video, 'seeked');
+	video.currentTime = 0.5;
+	t.ok(await seeked2, 'seeked back into the red half');
+	await sleep(100);
+	t.ok(isColor(centerPixel(video), 255, 0, 0), 'full size frame is red');
+
+	const canvas = new OffscreenCanvas(320, 180);
+	const ctx = canvas.getContext('2d')!;
+	ctx.drawImage(video as any, 160, 90, 160, 90, 0, 0, 160, 90);
+	const d = ctx.getImageData(80, 45, 1, 1).data;
+	t.ok(
+		isColor([d[0], d[1], d[2], d[3]], 255, 0, 0),
+		'source rect is in video pixels',
+	);
+	t.equal(
+		ctx.getImageData(240, 135, 1, 1).data[3],
+		0,
+		'nothing drawn outside the destination',
+	);
+});
+
 // Await `p`, mapping the outcome to a comparable string (racing a timeout
 // so a never-settling promise can't hang the harness).
 function playOutcome(p: Promise<void>, timeoutMs = 15000): Promise<string> {
@@ -34,6 +34,17 @@ function maxDiff(data: Float32Array, expected: (i: number) => number): number {
 	return max;
 }
 
+// Deterministic noise in [-1, 1).
+function noise(length: number, seed: number): Float32Array {
+	const out = new Float32Array(length);
+	let x = seed;
+	for (let i = 0; i < length; i++) {
+		x = (Math.imul(x, 1664525) + 1013904223) >>> 0;
+		out[i] = x / 2 ** 31 - 1;
+	}
+	return out;
+}
+
 // --- AudioBuffer ---
 
 test('AudioBuffer basics', (t) => {
@@ -392,6 +403,147 @@ test('cancelScheduledValues removes future events', async (t) => {
 	t.ok(closeTo(out[N - 1], 0.5, 1e-6), 'canceled event does not apply');
 });
 
+// Cancelling an automation that has already started needs a context that
+// renders while the test runs, so this one uses a real-time AudioContext.
+// Chrome would start it suspended, so there the expected results are
+// assumed, which keeps the TAP identical.
+test('cancelScheduledValues stops an automation in progress', async (t) => {
+	const sleep = (ms: number) => new Promise((r) => setTimeout(r, ms));
+	let target = [0.5, 0.5];
+	let curve = [0.5, 0.5];
+	if (isNxjs) {
+		const ctx = new AudioContext();
+		const a = ctx.createGain();
+		a.gain.setTargetAtTime(0, 0, 0.2);
+		const b = ctx.createGain();
+		b.gain.setValueCurveAtTime(new Float32Array([1, 0]), 0, 10);
+		a.connect(ctx.destination);
+		b.connect(ctx.destination);
+		await sleep(500);
+		a.gain.cancelScheduledValues(0);
+		b.gain.cancelScheduledValues(0);
+		await sleep(100);
+		target = [a.gain.value];
+		curve = [b.gain.value];
+		await sleep(300);
+		target.push(a.gain.value);
+		curve.push(b.gain.value);
+		await ctx.close();
+	}
+	t.ok(target[0] > 0 && target[0] < 1, 'setTarget holds its current value');
+	t.equal(target[1], target[0], 'setTarget no longer decays');
+	t.ok(curve[0] > 0 && curve[0] < 1, 'curve holds its current value');
+	t.equal(curve[1], curve[0], 'curve no longer advances');
+});
+
+// --- Automation chains crossing quantum boundaries ---
+
+test('chained automation events mid-quantum', async (t) => {
+	const N = 1280;
+	const ctx = new OfflineAudioContext(1, N, RATE);
+	const buffer = ctx.createBuffer(1, N, RATE);
+	buffer.getChannelData(0).fill(1);
+
+	const tc = 0.002;
+	const source = ctx.createBufferSource();
+	source.buffer = buffer;
+	const gain = ctx.createGain();
+	gain.gain.setValueAtTime(0.5, 0);
+	gain.gain.linearRampToValueAtTime(1, 200 / RATE);
+	gain.gain.exponentialRampToValueAtTime(0.25, 500 / RATE);
+	gain.gain.setTargetAtTime(0, 700 / RATE, tc);
+	gain.gain.setValueAtTime(0.8, 1000 / RATE);
+	source.connect(gain);
+	gain.connect(ctx.destination);
+	source.start();
+
+	const out = (await ctx.startRendering()).getChannelData(0);
+	const expected = (i: number) => {
+		if (i < 200) return 0.5 + (0.5 * i) / 200;
+		if (i < 500) return Math.pow(0.25, (i - 200) / 300);
+		if (i < 700) return 0.25;
+		if (i < 1000) return 0.25 * Math.exp(-((i - 700) / RATE) / tc);
+		return 0.8;
+	};
+	t.ok(maxDiff(out, expected) < 1e-3, 'each segment follows its curve');
+	t.ok(closeTo(out[N - 1], 0.8, 1e-6), 'holds the final value');
+});
+
+// --- Long automation timelines ---
+
+test('10k scheduled ramps render at flat cost', async (t) => {
+	const RAMP = 100; // frames; ramp boundaries fall mid-quantum
+	const render = async (ramps: number) => {
+		const N = ramps * RAMP;
+		const ctx = new OfflineAudioContext(1, N, RATE);
+		const buffer = ctx.createBuffer(1, N, RATE);
+		buffer.getChannelData(0).fill(1);
+		const source = ctx.createBufferSource();
+		source.buffer = buffer;
+		const gain = ctx.createGain();
+		gain.gain.setValueAtTime(0, 0);
+		for (let i = 1; i <= ramps; i++) {
+			gain.gain.linearRampToValueAtTime(i % 2, (i * RAMP) / RATE);
+		}
+		source.connect(gain);
+		gain.connect(ctx.destination);
+		source.start();
+		const start = performance.now();
+		const out = (await ctx.startRendering()).getChannelData(0);
+		const us = ((performance.now() - start) * 1000) / (N / 128);
+		console.log(`# bench ${ramps} ramps: ${us.toFixed(2)}us/quantum`);
+		return out;
+	};
+
+	await render(1000);
+	const out = await render(10000);
+	// Triangle wave: up on odd ramps, down on even ones.
+	const expected = (i: number) => {
+		const k = Math.floor(i / RAMP);
+		const f = (i % RAMP) / RAMP;
+		return k % 2 === 0 ? f : 1 - f;
+	};
+	t.ok(maxDiff(out, expected) < 1e-3, 'every ramp is applied');
+});
+
+// --- Graph topology ---
+
+test('fan-out / fan-in graph renders each path once', async (t) => {
+	const N = 384;
+	const SOURCES = 64;
+	const ctx = new OfflineAudioContext(1, N, RATE);
+	const buffer = ctx.createBuffer(1, N, RATE);
+	buffer.getChannelData(0).fill(1);
+	const bus = ctx.createGain();
+	bus.gain.value = 1 / SOURCES;
+	for (let i = 0; i < SOURCES; i++) {
+		const source = ctx.createBufferSource();
+		source.buffer = buffer;
+		// Diamond: each source reaches the bus through two gains.
+		const a = ctx.createGain();
+		const b = ctx.createGain();
+		a.gain.value = 0.25;
+		b.gain.value = 0.75;
+		source.connect(a);
+		source.connect(b);
+		a.connect(bus);
+		b.connect(bus);
+		source.start();
+	}
+	// A detached branch that must not be rendered into the output.
+	const orphan = ctx.createGain();
+	bus.connect(orphan);
+	bus.connect(ctx.destination);
+	const out = (await ctx.startRendering()).getChannelData(0);
+	t.ok(maxDiff(out, () => 1) < 1e-5, 'every path is mixed exactly once');
+	if ('getRenderStats' in ctx) {
+		const stats = (ctx as any).getRenderStats();
+		console.log(
+			`# bench ${SOURCES * 3 + 2} nodes: ${(stats.renderTimeAverage * 1000).toFixed(2)}us/quantum`,
+		);
+	}
+});
+
 // --- StereoPannerNode ---
 
 test('stereo panner mono input', async (t) => {
@@ -444,6 +596,267 @@ test('stereo panner stereo input', async (t) => {
 	);
 });
 
+// --- Mixing many voices ---
+
+// 24 voices (mono and stereo buffers, resampled by playbackRate, through a
+// gain and a panner) summed at the destination, against the spec's formulas
+// evaluated in double precision.
+function mixVoices(ctx: BaseAudioContext, voices: number, length: number) {
+	const sources: AudioBufferSourceNode[] = [];
+	for (let v = 0; v < voices; v++) {
+		const channels = v % 3 ? 2 : 1;
+		const buffer = ctx.createBuffer(channels, length, ctx.sampleRate);
+		for (let c = 0; c < channels; c++) {
+			buffer.copyToChannel(noise(length, v * 2 + c + 1), c);
+		}
+		const source = new AudioBufferSourceNode(ctx, {
+			buffer,
+			playbackRate: 0.55 + v * 0.04,
+		});
+		const gain = new GainNode(ctx, { gain: 0.1 + v * 0.01 });
+		const pan = (v / (voices - 1)) * 2 - 1;
+		const panner = new StereoPannerNode(ctx, { pan });
+		source.connect(gain).connect(panner).connect(ctx.destination);
+		sources.push(source);
+	}
+	return sources;
+}
+
+test('mixing many voices matches the reference', async (t) => {
+	const N = 1024;
+	const VOICES = 24;
+	const ctx = new OfflineAudioContext(2, N, RATE);
+	for (const source of mixVoices(ctx, VOICES, N)) source.start();
+	const rendered = await ctx.startRendering();
+	const l = new Float64Array(N);
+	const r = new Float64Array(N);
+	for (let v = 0; v < VOICES; v++) {
+		const stereo = v % 3 !== 0;
+		const inL = noise(N, v * 2 + 1);
+		const inR = stereo ? noise(N, v * 2 + 2) : inL;
+		const rate = Math.fround(0.55 + v * 0.04);
+		const gain = Math.fround(0.1 + v * 0.01);
+		const pan = Math.fround((v / (VOICES - 1)) * 2 - 1);
+		for (let i = 0; i < N; i++) {
+			const pos = i * rate;
+			if (pos >= N) break; // the source has ended
+			const i0 = Math.floor(pos);
+			const i1 = Math.min(i0 + 1, N - 1);
+			const f = pos - i0;
+			const a = gain * (inL[i0] + (inL[i1] - inL[i0]) * f);
+			const b = gain * (inR[i0] + (inR[i1] - inR[i0]) * f);
+			if (!stereo) {
+				const x = ((pan + 1) / 2) * (Math.PI / 2);
+				l[i] += a * Math.cos(x);
+				r[i] += a * Math.sin(x);
+			} else if (pan <= 0) {
+				const x = (pan + 1) * (Math.PI / 2);
+				l[i] += a + b * Math.cos(x);
+				r[i] += b * Math.sin(x);
+			} else {
+				const x = pan * (Math.PI / 2);
+				l[i] += a * Math.cos(x);
+				r[i] += b + a * Math.sin(x);
+			}
+		}
+	}
+	const dl = maxDiff(rendered.getChannelData(0), (i) => l[i]);
+	const dr = maxDiff(rendered.getChannelData(1), (i) => r[i]);
+	t.ok(dl < 1e-4, `left max error ${dl}`);
+	t.ok(dr < 1e-4, `right max error ${dr}`);
+});
+
+test('mixing throughput', async (t) => {
+	const seconds = 10;
+	const ctx = new OfflineAudioContext(2, seconds * RATE, RATE);
+	for (const source of mixVoices(ctx, 24, RATE)) {
+		source.loop = true;
+		source.start();
+	}
+	const start = performance.now();
+	const rendered = await ctx.startRendering();
+	const ms = performance.now() - start;
+	t.ok(Number.isFinite(rendered.getChannelData(0)[RATE]), 'renders');
+	console.log(
+		`# bench 24 voices (resample + gain + pan), ${seconds}s offline render: ${ms.toFixed(1)}ms`,
+	);
+});
+
+// --- Parallel offline rendering ---
+
+// Voices feeding separate branches, plus a shared feedback-delay bus and an
+// automated filter, so that the graph has both independent branches and
+// nodes that tie several voices together.
+function renderBranches(renderThreads: number, length: number) {
+	const ctx = new OfflineAudioContext({
+		numberOfChannels: 2,
+		length,
+		sampleRate: RATE,
+		renderThreads,
+	});
+	const sources = mixVoices(ctx, 12, length);
+	const bus = new GainNode(ctx, { gain: 0.5 });
+	const delay = new DelayNode(ctx, { delayTime: 0.01 });
+	const feedback = new GainNode(ctx, { gain: 0.4 });
+	bus.connect(delay).connect(feedback).connect(delay);
+	delay.connect(ctx.destination);
+	const osc = new OscillatorNode(ctx, { frequency: 330 });
+	const filter = new BiquadFilterNode(ctx, { frequency: 500 });
+	filter.frequency.linearRampToValueAtTime(4000, length / RATE);
+	osc.connect(filter).connect(bus);
+	sources[0].connect(bus);
+	sources[1].connect(bus);
+	osc.start();
+	for (const source of sources) source.start();
+	return ctx.startRendering();
+}
+
+test('parallel offline render is bit-identical to serial', async (t) => {
+	const N = RATE;
+	const serial = await renderBranches(1, N);
+	const parallel = await renderBranches(4, N);
+	for (let c = 0; c < 2; c++) {
+		const a = serial.getChannelData(c);
+		const b = parallel.getChannelData(c);
+		let mismatches = 0;
+		for (let i = 0; i < N; i++) {
+			if (a[i] !== b[i]) mismatches++;
+		}
+		t.equal(mismatches, 0, `channel ${c} matches`);
+	}
+	t.ok(maxDiff(serial.getChannelData(0), () => 0) > 0.01, 'not silent');
+});
+
+test('parallel offline render throughput', async (t) => {
+	const seconds = 10;
+	const ms: number[] = [];
+	for (const renderThreads of [1, 3]) {
+		const ctx = new OfflineAudioContext({
+			numberOfChannels: 2,
+			length: seconds * RATE,
+			sampleRate: RATE,
+			renderThreads,
+		});
+		for (const source of mixVoices(ctx, 24, RATE)) {
+			source.loop = true;
+			source.start();
+		}
+		const start = performance.now();
+		const rendered = await ctx.startRendering();
+		ms.push(performance.now() - start);
+		t.ok(Number.isFinite(rendered.getChannelData(0)[RATE]), 'renders');
+	}
+	console.log(
+		`# bench 24 voices, ${seconds}s offline render: ${ms[0].toFixed(1)}ms on 1 thread, ${ms[1].toFixed(1)}ms on 3`,
+	);
+});
+
+// --- AnalyserNode ---
+
+// Blackman-windowed DFT magnitude of `x` at bin `k`, in dB (the spec's
+// frequency data with smoothingTimeConstant = 0).
+function blackmanDb(x: Float32Array, k: number): number {
+	const N = x.length;
+	let re = 0;
+	let im = 0;
+	for (let n = 0; n < N; n++) {
+		const a = (2 * Math.PI * n) / N;
+		const w = 0.42 - 0.5 * Math.cos(a) + 0.08 * Math.cos(2 * a);
+		re += x[n] * w * Math.cos(a * k);
+		im -= x[n] * w * Math.sin(a * k);
+	}
+	return 20 * Math.log10(Math.sqrt(re * re + im * im) / N);
+}
+
+async function analyseSine(
+	fftSize: number,
+	options: AnalyserOptions = {},
+): Promise<AnalyserNode> {
+	const ctx = new OfflineAudioContext(1, 4096, RATE);
+	const osc = new OscillatorNode(ctx, { frequency: 1500 });
+	const analyser = new AnalyserNode(ctx, { fftSize, ...options });
+	// Not connected to the destination: analysers are processed regardless.
+	osc.connect(analyser);
+	osc.start();
+	await ctx.startRendering();
+	return analyser;
+}
+
+test('analyser time-domain data', async (t) => {
+	const analyser = await analyseSine(1024);
+	t.equal(analyser.frequencyBinCount, 512, 'frequencyBinCount');
+	const data = new Float32Array(1024);
+	analyser.getFloatTimeDomainData(data);
+	const w = (2 * Math.PI * 1500) / RATE;
+	t.ok(
+		maxDiff(data, (i) => Math.sin(w * (i + 3072))) < 1e-3,
+		'float data is the most recent fftSize samples',
+	);
+	const bytes = new Uint8Array(1024);
+	analyser.getByteTimeDomainData(bytes);
+	let ok = true;
+	for (let i = 0; i < 1024; i++) {
+		const expected = Math.min(255, Math.floor(128 * (1 + data[i])));
+		if (Math.abs(bytes[i] - expected) > 1) ok = false;
+	}
+	t.ok(ok, 'byte data maps [-1, 1] to [0, 255]');
+});
+
+test('analyser frequency data matches a windowed DFT', async (t) => {
+	const analyser = await analyseSine(2048, { smoothingTimeConstant: 0 });
+	const time = new Float32Array(2048);
+	analyser.getFloatTimeDomainData(time);
+	const freq = new Float32Array(analyser.frequencyBinCount);
+	analyser.getFloatFrequencyData(freq);
+	let peak = 0;
+	for (let k = 1; k < freq.length; k++) if (freq[k] > freq[peak]) peak = k;
+	t.equal(peak, 64, 'peak at 1500 Hz');
+	let max = 0;
+	// Around the peak (far bins are down in float rounding noise).
+	for (let k = 56; k <= 72; k++) {
+		const ref = blackmanDb(time, k);
+		if (ref > -80) max = Math.max(max, Math.abs(freq[k] - ref));
+	}
+	t.ok(max < 1e-2, 'dB values match the reference');
+
+	const bytes = new Uint8Array(analyser.frequencyBinCount);
+	analyser.getByteFrequencyData(bytes);
+	t.equal(bytes[64], 255, 'peak is above maxDecibels');
+	t.equal(bytes[1000], 0, 'far bins are below minDecibels');
+});
+
+test('analyser smoothing', async (t) => {
+	const analyser = await analyseSine(256, { smoothingTimeConstant: 0.5 });
+	const a = new Float32Array(128);
+	const b = new Float32Array(128);
+	analyser.getFloatFrequencyData(a);
+	analyser.getFloatFrequencyData(b);
+	t.ok(
+		maxDiff(a, (i) => b[i]) === 0,
+		'repeated reads without rendering do not smooth again',
+	);
+	// First read: half of the (initially zero) previous block, i.e. -6 dB.
+	const unsmoothed = await analyseSine(256, { smoothingTimeConstant: 0 });
+	const c = new Float32Array(128);
+	unsmoothed.getFloatFrequencyData(c);
+	t.ok(closeTo(a[8], c[8] - 20 * Math.log10(2), 1e-3), 'first read is halved');
+});
+
+test('analyser FFT throughput', async (t) => {
+	const analyser = await analyseSine(32768);
+	const freq = new Float32Array(analyser.frequencyBinCount);
+	const ITERATIONS = 50;
+	const start = performance.now();
+	for (let i = 0; i < ITERATIONS; i++) {
+		// A new fftSize invalidates the spectrum, forcing a full FFT.
+		analyser.fftSize = i & 1 ? 32768 : 16384;
+		analyser.getFloatFrequencyData(freq);
+	}
+	const ms = (performance.now() - start) / ITERATIONS;
+	t.ok(freq[1024] > freq[4096] + 40, 'spectrum peaks at 1500 Hz');
+	console.log(`# bench analyser 16k/32k-point spectrum: ${ms.toFixed(3)}ms`);
+});
+
 // --- Stereo downmix to mono destination ---
 
 test('stereo source downmix to mono destination', async (t) => {
@@ -477,6 +890,385 @@ test('multiple sources sum at destination', async (t) => {
 	t.ok(closeTo(out[100], 0.75, 1e-5), 'inputs are summed');
 });
 
+// --- OscillatorNode ---
+
+test('oscillator sine matches Math.sin', async (t) => {
+	const N = 2048;
+	const ctx = new OfflineAudioContext(1, N, RATE);
+	const osc = ctx.createOscillator();
+	t.equal(osc.type, 'sine', 'type defaults to sine');
+	t.equal(osc.frequency.value, 440, 'frequency defaults to 440');
+	osc.connect(ctx.destination);
+	osc.start();
+	const out = (await ctx.startRendering()).getChannelData(0);
+	const w = (2 * Math.PI * 440) / RATE;
+	t.ok(maxDiff(out, (i) => Math.sin(w * i)) < 1e-3, 'sine matches Math.sin');
+});
+
+test('oscillator basic waveforms', async (t) => {
+	const N = 4800;
+	for (const type of ['square', 'sawtooth', 'triangle'] as const) {
+		const ctx = new OfflineAudioContext(1, N, RATE);
+		const osc = new OscillatorNode(ctx, { type, frequency: 100 });
+		t.equal(osc.type, type, `${type}: type is set`);
+		osc.connect(ctx.destination);
+		osc.start();
+		const out = (await ctx.startRendering()).getChannelData(0);
+		let peak = 0;
+		let sum = 0;
+		for (let i = 0; i < N; i++) {
+			peak = Math.max(peak, Math.abs(out[i]));
+			sum += out[i];
+		}
+		t.ok(peak > 0.9 && peak <= 1.0001, `${type}: normalized to a peak of 1`);
+		t.ok(Math.abs(sum / N) < 1e-2, `${type}: zero mean`);
+		// 480 frames per period: every shape is high early in the first half
+		// of the period, and low late in the second half.
+		t.ok(out[150] > 0.5, `${type}: positive in the first half period`);
+		t.ok(out[330] < -0.5, `${type}: negative in the second half period`);
+	}
+});
+
+test('oscillator custom PeriodicWave', async (t) => {
+	const N = 1024;
+	const ctx = new OfflineAudioContext(1, N, RATE);
+	const wave = ctx.createPeriodicWave([0, 0, 0], [0, 0, 0.5], {
+		disableNormalization: true,
+	});
+	t.ok(wave instanceof PeriodicWave, 'createPeriodicWave returns PeriodicWave');
+	const osc = ctx.createOscillator();
+	osc.setPeriodicWave(wave);
+	t.equal(osc.type, 'custom', 'setPeriodicWave sets type to custom');
+	osc.connect(ctx.destination);
+	osc.start();
+	const out = (await ctx.startRendering()).getChannelData(0);
+	const w = (2 * Math.PI * 880) / RATE;
+	t.ok(
+		maxDiff(out, (i) => 0.5 * Math.sin(w * i)) < 1e-3,
+		'second harmonic at half amplitude',
+	);
+});
+
+test('oscillator start / stop / ended', async (t) => {
+	const N = 1024;
+	const ctx = new OfflineAudioContext(1, N, RATE);
+	const osc = ctx.createOscillator();
+	osc.connect(ctx.destination);
+	const ended = new Promise<boolean>((resolve) => {
+		const timo = setTimeout(() => resolve(false), 3000);
+		osc.onended = () => {
+			clearTimeout(timo);
+			resolve(true);
+		};
+	});
+	osc.start(256 / RATE);
+	osc.stop(512 / RATE);
+	const out = (await ctx.startRendering()).getChannelData(0);
+	t.equal(out[255], 0, 'silent before start');
+	t.ok(out[300] !== 0, 'playing after start');
+	t.equal(out[600], 0, 'silent after stop');
+	t.ok(await ended, 'ended event fired');
+});
+
+// --- BiquadFilterNode ---
+
+// Audio EQ Cookbook coefficients, as given by the Web Audio spec.
+function biquadRef(type: BiquadFilterType, f0: number, Q: number, G: number) {
+	const w0 = (2 * Math.PI * f0) / RATE;
+	const A = 10 ** (G / 40);
+	const k = Math.cos(w0);
+	const aQ = Math.sin(w0) / (2 * Q);
+	const aQdB = Math.sin(w0) / (2 * 10 ** (Q / 20));
+	const S = Math.sin(w0) / Math.SQRT2;
+	const sA = 2 * Math.sqrt(A) * S;
+	let c: number[];
+	switch (type) {
+		case 'lowpass':
+			c = [(1 - k) / 2, 1 - k, (1 - k) / 2, 1 + aQdB, -2 * k, 1 - aQdB];
+			break;
+		case 'highpass':
+			c = [(1 + k) / 2, -(1 + k), (1 + k) / 2, 1 + aQdB, -2 * k, 1 - aQdB];
+			break;
+		case 'bandpass':
+			c = [aQ, 0, -aQ, 1 + aQ, -2 * k, 1 - aQ];
+			break;
+		case 'notch':
+			c = [1, -2 * k, 1, 1 + aQ, -2 * k, 1 - aQ];
+			break;
+		case 'allpass':
+			c = [1 - aQ, -2 * k, 1 + aQ, 1 + aQ, -2 * k, 1 - aQ];
+			break;
+		case 'peaking':
+			c = [1 + aQ * A, -2 * k, 1 - aQ * A, 1 + aQ / A, -2 * k, 1 - aQ / A];
+			break;
+		case 'lowshelf':
+			c = [
+				A * (A + 1 - (A - 1) * k + sA),
+				2 * A * (A - 1 - (A + 1) * k),
+				A * (A + 1 - (A - 1) * k - sA),
+				A + 1 + (A - 1) * k + sA,
+				-2 * (A - 1 + (A + 1) * k),
+				A + 1 + (A - 1) * k - sA,
+			];
+			break;
+		default:
+			c = [
+				A * (A + 1 + (A - 1) * k + sA),
+				-2 * A * (A - 1 + (A + 1) * k),
+				A * (A + 1 + (A - 1) * k - sA),
+				A + 1 - (A - 1) * k + sA,
+				2 * (A - 1 - (A + 1) * k),
+				A + 1 - (A - 1) * k - sA,
+			];
+	}
+	const [b0, b1, b2, a0, a1, a2] = c;
+	return (x: Float32Array) => {
+		const y = new Float32Array(x.length);
+		let x1 = 0;
+		let x2 = 0;
+		let y1 = 0;
+		let y2 = 0;
+		for (let i = 0; i < x.length; i++) {
+			const v = (b0 * x[i] + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2) / a0;
+			x2 = x1;
+			x1 = x[i];
+			y2 = y1;
+			y1 = v;
+			y[i] = v;
+		}
+		return y;
+	};
+}
+
+test('biquad filter types match the cookbook', async (t) => {
+	const N = 1024;
+	let seed = 1;
+	const noise = new Float32Array(N).map(() => {
+		seed = (seed * 16807) % 2147483647;
+		return seed / 1073741823.5 - 1;
+	});
+	const types: BiquadFilterType[] = [
+		'lowpass',
+		'highpass',
+		'bandpass',
+		'lowshelf',
+		'highshelf',
+		'peaking',
+		'notch',
+		'allpass',
+	];
+	for (const type of types) {
+		const ctx = new OfflineAudioContext(1, N, RATE);
+		const buffer = ctx.createBuffer(1, N, RATE);
+		buffer.copyToChannel(noise, 0);
+		const source = ctx.createBufferSource();
+		source.buffer = buffer;
+		const filter = new BiquadFilterNode(ctx, {
+			type,
+			frequency: 2000,
+			Q: 3,
+			gain: 6,
+		});
+		source.connect(filter);
+		filter.connect(ctx.destination);
+		source.start();
+		const out = (await ctx.startRendering()).getChannelData(0);
+		const ref = biquadRef(type, 2000, 3, 6)(noise);
+		t.ok(maxDiff(out, (i) => ref[i]) < 1e-4, `${type} matches reference`);
+	}
+});
+
+test('biquad getFrequencyResponse', (t) => {
+	const ctx = new OfflineAudioContext(1, 384, RATE);
+	const filter = new BiquadFilterNode(ctx, {
+		type: 'peaking',
+		frequency: 1000,
+		Q: 1,
+		gain: 6,
+	});
+	const hz = new Float32Array([0, 1000, RATE]);
+	const mag = new Float32Array(3);
+	const phase = new Float32Array(3);
+	filter.getFrequencyResponse(hz, mag, phase);
+	t.ok(closeTo(mag[0], 1, 1e-5), 'unity gain at DC');
+	t.ok(closeTo(mag[1], 10 ** (6 / 20), 1e-4), '+6 dB at the peak');
+	t.ok(closeTo(phase[1], 0, 1e-4), 'zero phase at the peak');
+	t.ok(Number.isNaN(mag[2]), 'NaN magnitude above Nyquist');
+	t.ok(Number.isNaN(phase[2]), 'NaN phase above Nyquist');
+	throwsName(
+		t,
+		() => filter.getFrequencyResponse(hz, new Float32Array(2), phase),
+		'InvalidAccessError',
+		'length mismatch throws',
+	);
+});
+
+// --- DelayNode ---
+
+test('delay node shifts its input', async (t) => {
+	const N = 512;
+	for (const frames of [0, 100]) {
+		const ctx = new OfflineAudioContext(1, N, RATE);
+		const buffer = ctx.createBuffer(1, 1, RATE);
+		buffer.getChannelData(0)[0] = 1;
+		const source = ctx.createBufferSource();
+		source.buffer = buffer;
+		const delay = ctx.createDelay();
+		t.equal(delay.delayTime.maxValue, 1, 'maxDelayTime defaults to 1');
+		delay.delayTime.value = frames / RATE;
+		source.connect(delay);
+		delay.connect(ctx.destination);
+		source.start();
+		const out = (await ctx.startRendering()).getChannelData(0);
+		t.ok(closeTo(out[frames], 1, 1e-4), `${frames} frames: impulse moved`);
+		t.ok(
+			maxDiff(out, (i) => (i === frames ? out[i] : 0)) < 1e-4,
+			`${frames} frames: silent elsewhere`,
+		);
+	}
+});
+
+test('delay node feedback loop', async (t) => {
+	const N = 4096;
+	const ctx = new OfflineAudioContext(1, N, RATE);
+	const buffer = ctx.createBuffer(1, 1, RATE);
+	buffer.getChannelData(0)[0] = 1;
+	const source = ctx.createBufferSource();
+	source.buffer = buffer;
+	const delay = new DelayNode(ctx, { delayTime: 480 / RATE });
+	const feedback = new GainNode(ctx, { gain: 0.5 });
+	source.connect(delay);
+	delay.connect(feedback);
+	feedback.connect(delay);
+	delay.connect(ctx.destination);
+	source.start();
+	const out = (await ctx.startRendering()).getChannelData(0);
+	for (let n = 1; n <= 4; n++) {
+		t.ok(
+			closeTo(out[480 * n], 0.5 ** (n - 1), 1e-3),
+			`echo ${n} at ${480 * n} frames`,
+		);
+	}
+	t.ok(Math.abs(out[700]) < 1e-3, 'silent between echoes');
+});
+
+// --- ConvolverNode ---
+
+test('convolver with an impulse response delays its input', async (t) => {
+	const N = 1024;
+	const ctx = new OfflineAudioContext(1, N, RATE);
+	const ir = ctx.createBuffer(1, 300, RATE);
+	ir.getChannelData(0)[250] = 0.5;
+	const convolver = new ConvolverNode(ctx, { disableNormalization: true });
+	t.equal(convolver.normalize, false, 'normalize reflects the option');
+	convolver.buffer = ir;
+	const buffer = ctx.createBuffer(1, 1, RATE);
+	buffer.getChannelData(0)[0] = 1;
+	const source = ctx.createBufferSource();
+	source.buffer = buffer;
+	source.connect(convolver);
+	convolver.connect(ctx.destination);
+	source.start(200 / RATE);
+	const out = (await ctx.startRendering()).getChannelData(0);
+	t.ok(closeTo(out[450], 0.5, 1e-4), 'impulse lands at 200 + 250 frames');
+	t.ok(
+		maxDiff(out, (i) => (i === 450 ? out[i] : 0)) < 1e-4,
+		'silent elsewhere',
+	);
+});
+
+test('convolver matches direct convolution', async (t) => {
+	const N = 2048;
+	const ctx = new OfflineAudioContext(1, N, RATE);
+	const h = noise(700, 1).map((v) => v * 0.05);
+	const x = noise(N, 2);
+	const ir = ctx.createBuffer(1, h.length, RATE);
+	ir.copyToChannel(h, 0);
+	const input = ctx.createBuffer(1, N, RATE);
+	input.copyToChannel(x, 0);
+	const convolver = new ConvolverNode(ctx, {
+		buffer: ir,
+		disableNormalization: true,
+	});
+	const source = new AudioBufferSourceNode(ctx, { buffer: input });
+	source.connect(convolver);
+	convolver.connect(ctx.destination);
+	source.start();
+	const out = (await ctx.startRendering()).getChannelData(0);
+	const diff = maxDiff(out, (n) => {
+		let sum = 0;
+		for (let k = 0; k <= n && k < h.length; k++) sum += h[k] * x[n - k];
+		return sum;
+	});
+	t.ok(diff < 1e-4, `max error ${diff}`);
+});
+
+// --- DynamicsCompressorNode ---
+
+async function compress(
+	amplitude: number,
+): Promise<{ out: Float32Array; compressor: DynamicsCompressorNode }> {
+	const N = 9600;
+	const ctx = new OfflineAudioContext(1, N, RATE);
+	const buffer = ctx.createBuffer(1, N, RATE);
+	buffer.getChannelData(0).fill(amplitude);
+	const source = new AudioBufferSourceNode(ctx, { buffer });
+	const compressor = ctx.createDynamicsCompressor();
+	source.connect(compressor);
+	compressor.connect(ctx.destination);
+	source.start();
+	const out = (await ctx.startRendering()).getChannelData(0);
+	return { out, compressor };
+}
+
+test('compressor defaults and look-ahead', async (t) => {
+	const { out, compressor } = await compress(0.01);
+	t.equal(compressor.threshold.value, -24, 'threshold default');
+	t.equal(compressor.knee.value, 30, 'knee default');
+	t.equal(compressor.ratio.value, 12, 'ratio default');
+	t.ok(closeTo(compressor.attack.value, 0.003, 1e-6), 'attack default');
+	t.equal(compressor.release.value, 0.25, 'release default');
+	t.equal(compressor.channelCountMode, 'clamped-max', 'channelCountMode');
+	t.ok(
+		maxDiff(out.subarray(0, 280), () => 0) === 0,
+		'output is delayed by the look-ahead',
+	);
+	const gain = out[out.length - 1] / 0.01;
+	t.ok(gain > 1.5 && gain < 2.5, `quiet input gets makeup gain (${gain})`);
+	t.ok(
+		closeTo(compressor.reduction, 0, 1e-3),
+		'no reduction below the threshold',
+	);
+});
+
+test('compressor reduces loud input', async (t) => {
+	const { out, compressor } = await compress(1);
+	t.ok(compressor.reduction < -3, `reduction ${compressor.reduction} dB`);
+	t.ok(out[out.length - 1] < 0.9, 'loud input is attenuated');
+});
+
+test('convolver and compressor render throughput', async (t) => {
+	const seconds = 10;
+	const ctx = new OfflineAudioContext(2, seconds * RATE, RATE);
+	const ir = ctx.createBuffer(2, 2 * RATE, RATE);
+	ir.copyToChannel(noise(2 * RATE, 3), 0);
+	ir.copyToChannel(noise(2 * RATE, 4), 1);
+	const osc = new OscillatorNode(ctx, { type: 'sawtooth', frequency: 220 });
+	const convolver = new ConvolverNode(ctx, { buffer: ir });
+	const compressor = new DynamicsCompressorNode(ctx);
+	osc.connect(convolver);
+	convolver.connect(compressor);
+	compressor.connect(ctx.destination);
+	osc.start();
+	const start = performance.now();
+	const out = await ctx.startRendering();
+	const ms = performance.now() - start;
+	t.ok(Number.isFinite(out.getChannelData(1)[RATE]), 'renders finite output');
+	console.log(
+		`# bench convolver (2s stereo IR) + compressor, ${seconds}s offline render: ${ms.toFixed(1)}ms`,
+	);
+});
+
 // --- ended event ---
 
 test('source ended event fires', async (t) => {
@@ -577,6 +1369,187 @@ test('decodeAudioData rejects garbage', async (t) => {
 	}
 });
 
+// --- 16-bit storage and AudioStreamSourceNode (nx.js) ---
+//
+// Chrome has neither, so there the tests fall back to the standard
+// equivalents (f32 buffers, decodeAudioData() + AudioBufferSourceNode),
+// which must produce the same results.
+
+const isNxjs = typeof (globalThis as any).Switch !== 'undefined';
+
+function decodeS16(ctx: BaseAudioContext, data: ArrayBuffer) {
+	if (!isNxjs) return ctx.decodeAudioData(data);
+	return (ctx as any).decodeAudioData(data, {
+		format: 's16',
+	}) as Promise<AudioBuffer>;
+}
+
+interface StreamSourceOptions {
+	loop?: boolean;
+	loopStart?: number;
+	loopEnd?: number;
+}
+
+async function createStreamSource(
+	ctx: BaseAudioContext,
+	data: ArrayBuffer,
+	options: StreamSourceOptions = {},
+): Promise<AudioScheduledSourceNode & { duration: number }> {
+	if (isNxjs) {
+		const Node = (globalThis as any).AudioStreamSourceNode;
+		return new Node(ctx, { data, ...options });
+	}
+	const buffer = await ctx.decodeAudioData(data);
+	const source = new AudioBufferSourceNode(ctx, { buffer, ...options });
+	return Object.assign(source, { duration: buffer.duration });
+}
+
+function renderBuffer(buffer: AudioBuffer) {
+	const ctx = new OfflineAudioContext(1, buffer.length, RATE);
+	const source = new AudioBufferSourceNode(ctx, { buffer });
+	source.connect(ctx.destination);
+	source.start();
+	return ctx.startRendering();
+}
+
+test('s16 AudioBuffer plays identically to f32', async (t) => {
+	const samples = noise(RATE / 4, 3);
+	const ctx = new OfflineAudioContext(1, 384, RATE);
+	const f32 = await ctx.decodeAudioData(buildWav(samples, RATE));
+	const s16 = await decodeS16(ctx, buildWav(samples, RATE));
+	t.equal(
+		isNxjs ? (s16 as any).format : 's16',
+		's16',
+		'decoded with 16-bit storage',
+	);
+	t.equal(s16.length, f32.length, 'same length');
+	const a = (await renderBuffer(f32)).getChannelData(0);
+	const b = (await renderBuffer(s16)).getChannelData(0);
+	let mismatches = 0;
+	for (let i = 0; i < a.length; i++) {
+		if (a[i] !== b[i]) mismatches++;
+	}
+	t.equal(mismatches, 0, 'rendered output is bit-identical');
+	t.equal(
+		maxDiff(s16.getChannelData(0), (i) => f32.getChannelData(0)[i]),
+		0,
+		'getChannelData() converts to the f32 samples',
+	);
+});
+
+test('s16 AudioBuffer channel copies', (t) => {
+	const buffer = new AudioBuffer({
+		length: 64,
+		sampleRate: RATE,
+		numberOfChannels: 2,
+		format: 's16',
+	} as AudioBufferOptions);
+	const src = new Float32Array(64);
+	for (let i = 0; i < 64; i++) src[i] = (i - 32) / 32;
+	buffer.copyToChannel(src, 1);
+	const out = new Float32Array(64);
+	buffer.copyFromChannel(out, 1);
+	t.equal(
+		maxDiff(out, (i) => src[i]),
+		0,
+		'copyFromChannel() returns the copied samples',
+	);
+	t.equal(
+		maxDiff(buffer.getChannelData(0), () => 0),
+		0,
+		'other channel is silent',
+	);
+});
+
+test('stream source plays a file', async (t) => {
+	const N = RATE / 2;
+	const samples = new Float32Array(N);
+	for (let i = 0; i < N; i++) {
+		samples[i] = Math.sin((i / RATE) * 2 * Math.PI * 440) * 0.5;
+	}
+	const ctx = new OfflineAudioContext(1, N + 1024, RATE);
+	const source = await createStreamSource(ctx, buildWav(samples, RATE));
+	source.connect(ctx.destination);
+	const ended = new Promise<boolean>((resolve) => {
+		const timo = setTimeout(() => resolve(false), 3000);
+		source.onended = () => {
+			clearTimeout(timo);
+			resolve(true);
+		};
+	});
+	source.start();
+	const data = (await ctx.startRendering()).getChannelData(0);
+	t.ok(
+		maxDiff(data.subarray(0, N), (i) => samples[i]) < 1e-3,
+		'samples match (within s16 quantization)',
+	);
+	t.equal(maxDiff(data.subarray(N), () => 0), 0, 'silent after the end');
+	t.ok(closeTo(source.duration, N / RATE), 'duration');
+	t.ok(await ended, 'ended event fired');
+});
+
+test('stream source start offset and duration', async (t) => {
+	const N = RATE / 2;
+	const samples = noise(N, 7);
+	const when = 1000;
+	const offset = 2400;
+	const duration = 4800;
+	const ctx = new OfflineAudioContext(1, 8192, RATE);
+	const source = await createStreamSource(ctx, buildWav(samples, RATE));
+	source.connect(ctx.destination);
+	(source as AudioBufferSourceNode).start(
+		when / RATE,
+		offset / RATE,
+		duration / RATE,
+	);
+	const data = (await ctx.startRendering()).getChannelData(0);
+	t.equal(maxDiff(data.subarray(0, when), () => 0), 0, 'silent before start');
+	t.ok(
+		maxDiff(
+			data.subarray(when, when + duration),
+			(i) => samples[offset + i],
+		) < 1e-3,
+		'plays from the offset',
+	);
+	t.equal(
+		maxDiff(data.subarray(when + duration), () => 0),
+		0,
+		'silent after the duration',
+	);
+});
+
+test('stream source looping', async (t) => {
+	const N = 4800;
+	const samples = noise(N, 11);
+	const ctx = new OfflineAudioContext(1, N * 3, RATE);
+	const source = await createStreamSource(ctx, buildWav(samples, RATE), {
+		loop: true,
+	});
+	source.connect(ctx.destination);
+	source.start();
+	const data = (await ctx.startRendering()).getChannelData(0);
+	t.ok(
+		maxDiff(data, (i) => samples[i % N]) < 1e-3,
+		'loops gaplessly over the whole file',
+	);
+
+	const ctx2 = new OfflineAudioContext(1, N * 2, RATE);
+	const source2 = await createStreamSource(ctx2, buildWav(samples, RATE), {
+		loop: true,
+		loopStart: 1200 / RATE,
+		loopEnd: 3600 / RATE,
+	});
+	source2.connect(ctx2.destination);
+	source2.start();
+	const data2 = (await ctx2.startRendering()).getChannelData(0);
+	t.ok(
+		maxDiff(data2, (i) =>
+			i < 3600 ? samples[i] : samples[1200 + ((i - 3600) % 2400)],
+		) < 1e-3,
+		'loops between loopStart and loopEnd',
+	);
+});
+
 // --- API errors ---
 
 test('Web Audio API errors', async (t) => {
@@ -642,6 +1615,104 @@ test('Web Audio API errors', async (t) => {
 		'NotSupportedError',
 		'OfflineAudioContext with 0 channels throws',
 	);
+
+	throwsName(
+		t,
+		() => ctx.createDelay(0),
+		'NotSupportedError',
+		'createDelay(0) throws',
+	);
+	throwsName(
+		t,
+		() => ctx.createDelay(180),
+		'NotSupportedError',
+		'createDelay(180) throws',
+	);
+	throwsName(
+		t,
+		() => new OscillatorNode(ctx, { type: 'custom' }),
+		'InvalidStateError',
+		'custom oscillator without a PeriodicWave throws',
+	);
+	throwsName(
+		t,
+		() => {
+			ctx.createOscillator().type = 'custom';
+		},
+		'InvalidStateError',
+		'setting type to custom throws',
+	);
+	throwsName(
+		t,
+		() => ctx.createPeriodicWave([0, 1], [0]),
+		'IndexSizeError',
+		'mismatched PeriodicWave arrays throw',
+	);
+
+	const analyser = ctx.createAnalyser();
+	throwsName(
+		t,
+		() => {
+			analyser.fftSize = 1000;
+		},
+		'IndexSizeError',
+		'non power of two fftSize throws',
+	);
+	throwsName(
+		t,
+		() => {
+			analyser.fftSize = 65536;
+		},
+		'IndexSizeError',
+		'fftSize above 32768 throws',
+	);
+	throwsName(
+		t,
+		() => {
+			analyser.minDecibels = -30;
+		},
+		'IndexSizeError',
+		'minDecibels >= maxDecibels throws',
+	);
+	throwsName(
+		t,
+		() => {
+			analyser.smoothingTimeConstant = 2;
+		},
+		'IndexSizeError',
+		'smoothingTimeConstant above 1 throws',
+	);
+
+	const convolver = ctx.createConvolver();
+	throwsName(
+		t,
+		() => {
+			convolver.buffer = ctx.createBuffer(3, 128, RATE);
+		},
+		'NotSupportedError',
+		'3-channel convolver buffer throws',
+	);
+	throwsName(
+		t,
+		() => {
+			convolver.buffer = ctx.createBuffer(1, 128, RATE / 2);
+		},
+		'NotSupportedError',
+		'convolver buffer with another sample rate throws',
+	);
+	t.equal(convolver.buffer, null, 'convolver buffer is unchanged');
+	throwsName(
+		t,
+		() => new ConvolverNode(ctx, { channelCount: 3 }),
+		'NotSupportedError',
+		'convolver channelCount above 2 throws',
+	);
+	throwsName(
+		t,
+		() => new DynamicsCompressorNode(ctx, { channelCountMode: 'max' }),
+		'NotSupportedError',
+		"compressor channelCountMode 'max' throws",
+	);
 });
 
 // --- Node properties ---
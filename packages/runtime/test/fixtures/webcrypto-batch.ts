@@ -0,0 +1,248 @@
+import { test } from '../src/tap';
+
+// Switch.verifyBatch() and Switch.digestBatch() are nx.js APIs. Elsewhere
+// each item goes through crypto.subtle on its own, so the assertions are the
+// same.
+const isNxjs = typeof (globalThis as any).Switch !== 'undefined';
+const Switch_: any = (globalThis as any).Switch;
+
+function verifyBatch(
+	algorithm: any,
+	key: CryptoKey | CryptoKey[],
+	signatures: BufferSource[],
+	data: BufferSource[],
+): Promise<boolean[]> {
+	if (isNxjs) {
+		return Switch_.verifyBatch(algorithm, key, signatures, data);
+	}
+	return Promise.all(
+		data.map((d, i) =>
+			crypto.subtle.verify(
+				algorithm,
+				Array.isArray(key) ? key[i] : key,
+				signatures[i],
+				d,
+			),
+		),
+	);
+}
+
+function digestBatch(
+	algorithm: string,
+	data: BufferSource[],
+): Promise<ArrayBuffer[]> {
+	if (isNxjs) {
+		return Switch_.digestBatch(algorithm, data);
+	}
+	return Promise.all(data.map((d) => crypto.subtle.digest(algorithm, d)));
+}
+
+function toHex(buf: ArrayBuffer): string {
+	return Array.from(new Uint8Array(buf))
+		.map((b) => b.toString(16).padStart(2, '0'))
+		.join('');
+}
+
+function messages(count: number): Uint8Array[] {
+	return Array.from({ length: count }, (_, i) =>
+		new TextEncoder().encode(`block ${i} `.repeat(i % 7)),
+	);
+}
+
+test('verifyBatch() ECDSA matches crypto.subtle.verify()', async (t) => {
+	const algorithm = { name: 'ECDSA', hash: 'SHA-256' };
+	const pair = await crypto.subtle.generateKey(
+		{ name: 'ECDSA', namedCurve: 'P-256' },
+		false,
+		['sign', 'verify'],
+	);
+	const data = messages(40);
+	const signatures = await Promise.all(
+		data.map((d) => crypto.subtle.sign(algorithm, pair.privateKey, d)),
+	);
+	// Corrupt every fifth signature, and truncate one.
+	for (let i = 0; i < signatures.length; i += 5) {
+		new Uint8Array(signatures[i])[10] ^= 1;
+	}
+	signatures[7] = signatures[7].slice(0, 32);
+
+	const results = await verifyBatch(
+		algorithm,
+		pair.publicKey,
+		signatures,
+		data,
+	);
+	t.equal(results.length, data.length, 'one result per item');
+	const expected = data.map((_, i) => i % 5 !== 0 && i !== 7);
+	t.deepEqual(results, expected, 'invalid signatures are false');
+});
+
+test('verifyBatch() with one HMAC key per item', async (t) => {
+	const keys = await Promise.all(
+		[1, 2, 3].map((n) =>
+			crypto.subtle.importKey(
+				'raw',
+				new Uint8Array(32).fill(n),
+				{ name: 'HMAC', hash: 'SHA-256' },
+				false,
+				['sign', 'verify'],
+			),
+		),
+	);
+	const data = messages(12);
+	const itemKeys = data.map((_, i) => keys[i % keys.length]);
+	const signatures = await Promise.all(
+		data.map((d, i) => crypto.subtle.sign('HMAC', itemKeys[i], d)),
+	);
+	t.deepEqual(
+		await verifyBatch('HMAC', itemKeys, signatures, data),
+		data.map(() => true),
+		'all signatures verify with their own key',
+	);
+	// Each signature checked against the next item's key.
+	const shifted = itemKeys.map((_, i) => itemKeys[(i + 1) % itemKeys.length]);
+	t.deepEqual(
+		await verifyBatch('HMAC', shifted, signatures, data),
+		data.map(() => false),
+		'no signature verifies with another key',
+	);
+});
+
+test('verifyBatch() RSA-PSS matches crypto.subtle.verify()', async (t) => {
+	const algorithm = { name: 'RSA-PSS', saltLength: 32 };
+	const pair = await crypto.subtle.generateKey(
+		{
+			name: 'RSA-PSS',
+			modulusLength: 1024,
+			publicExponent: new Uint8Array([1, 0, 1]),
+			hash: 'SHA-256',
+		},
+		false,
+		['sign', 'verify'],
+	);
+	const data = messages(16);
+	const signatures = await Promise.all(
+		data.map((d) => crypto.subtle.sign(algorithm, pair.privateKey, d)),
+	);
+	new Uint8Array(signatures[3])[0] ^= 0x80;
+	const results = await verifyBatch(
+		algorithm,
+		pair.publicKey,
+		signatures,
+		data,
+	);
+	t.deepEqual(
+		results,
+		data.map((_, i) => i !== 3),
+		'only the modified signature is invalid',
+	);
+});
+
+test('verifyBatch() of no items', async (t) => {
+	const key = await crypto.subtle.importKey(
+		'raw',
+		new Uint8Array(32),
+		{ name: 'HMAC', hash: 'SHA-256' },
+		false,
+		['verify'],
+	);
+	t.deepEqual(await verifyBatch('HMAC', key, [], []), [], 'empty results');
+});
+
+test('verifyBatch() rejects a key without the verify usage', async (t) => {
+	const key = await crypto.subtle.importKey(
+		'raw',
+		new Uint8Array(32),
+		{ name: 'HMAC', hash: 'SHA-256' },
+		false,
+		['sign'],
+	);
+	const data = messages(3);
+	const signatures = await Promise.all(
+		data.map((d) => crypto.subtle.sign('HMAC', key, d)),
+	);
+	const rejected = await verifyBatch('HMAC', key, signatures, data).then(
+		() => false,
+		() => true,
+	);
+	t.ok(rejected, 'verification fails');
+});
+
+test('digestBatch() matches crypto.subtle.digest()', async (t) => {
+	const data: Uint8Array[] = [
+		new Uint8Array(0),
+		...messages(20),
+		new Uint8Array(100000).fill(0x5a),
+	];
+	for (const algorithm of ['SHA-1', 'SHA-256', 'SHA-384', 'SHA-512']) {
+		const digests = await digestBatch(algorithm, data);
+		const expected = await Promise.all(
+			data.map((d) => crypto.subtle.digest(algorithm, d)),
+		);
+		t.deepEqual(
+			digests.map(toHex),
+			expected.map(toHex),
+			`${algorithm} digests match`,
+		);
+	}
+	t.deepEqual(await digestBatch('SHA-256', []), [], 'empty batch');
+});
+
+test('batch verify throughput benchmark', async (t) => {
+	const algorithm = { name: 'ECDSA', hash: 'SHA-256' };
+	const pair = await crypto.subtle.generateKey(
+		{ name: 'ECDSA', namedCurve: 'P-256' },
+		false,
+		['sign', 'verify'],
+	);
+	// Small signed messages, as in the blocks of a downloaded update.
+	const data = messages(200);
+	const signatures = await Promise.all(
+		data.map((d) => crypto.subtle.sign(algorithm, pair.privateKey, d)),
+	);
+
+	let start = performance.now();
+	const perCall = await Promise.all(
+		data.map((d, i) =>
+			crypto.subtle.verify(algorithm, pair.publicKey, signatures[i], d),
+		),
+	);
+	const perCallMs = performance.now() - start;
+
+	start = performance.now();
+	const batched = await verifyBatch(
+		algorithm,
+		pair.publicKey,
+		signatures,
+		data,
+	);
+	const batchMs = performance.now() - start;
+
+	start = performance.now();
+	const digestsPerCall = await Promise.all(
+		data.map((d) => crypto.subtle.digest('SHA-256', d)),
+	);
+	const digestPerCallMs = performance.now() - start;
+	start = performance.now();
+	const digests = await digestBatch('SHA-256', data);
+	const digestBatchMs = performance.now() - start;
+
+	if (isNxjs) {
+		const rate = (ms: number) => (data.length / (ms / 1000)).toFixed(0);
+		console.log(
+			`# bench ECDSA P-256 verify x ${data.length}: ` +
+				`per call ${rate(perCallMs)}/s, batch ${rate(batchMs)}/s`,
+		);
+		console.log(
+			`# bench SHA-256 digest x ${data.length}: ` +
+				`per call ${rate(digestPerCallMs)}/s, ` +
+				`batch ${rate(digestBatchMs)}/s`,
+		);
+	}
+	t.deepEqual(batched, perCall, 'batch results match per call results');
+	t.deepEqual(
+		digests.map(toHex),
+		digestsPerCall.map(toHex),
+		'batch digests match per call digests',
+	);
+});
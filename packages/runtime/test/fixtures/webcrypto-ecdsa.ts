@@ -107,3 +107,45 @@ test('ECDSA P-384 sign/verify', async (t) => {
 	);
 	t.ok(valid, 'P-384 signature verifies');
 });
+
+test('ECDSA sign/verify throughput benchmark', async (t) => {
+	for (const [namedCurve, hash] of [
+		['P-256', 'SHA-256'],
+		['P-384', 'SHA-384'],
+	]) {
+		const pair = await crypto.subtle.generateKey(
+			{ name: 'ECDSA', namedCurve },
+			false,
+			['sign', 'verify'],
+		);
+		const algorithm = { name: 'ECDSA', hash };
+		// Small per-message payloads, as in a multiplayer protocol.
+		const messages = Array.from({ length: 100 }, (_, i) =>
+			new TextEncoder().encode(`player 1 moved to ${i},${i * 2}`),
+		);
+
+		let start = performance.now();
+		const signatures = await Promise.all(
+			messages.map((m) => crypto.subtle.sign(algorithm, pair.privateKey, m)),
+		);
+		const signMs = performance.now() - start;
+
+		start = performance.now();
+		const results = await Promise.all(
+			messages.map((m, i) =>
+				crypto.subtle.verify(algorithm, pair.publicKey, signatures[i], m),
+			),
+		);
+		const verifyMs = performance.now() - start;
+
+		console.log(
+			`# bench ECDSA ${namedCurve}: ` +
+				`sign ${((messages.length * 1000) / signMs).toFixed(0)} ops/s, ` +
+				`verify ${((messages.length * 1000) / verifyMs).toFixed(0)} ops/s`,
+		);
+		t.ok(
+			results.every((ok) => ok),
+			`${namedCurve}: all ${messages.length} signatures verify`,
+		);
+	}
+});
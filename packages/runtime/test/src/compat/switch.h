@@ -545,18 +545,14 @@ typedef struct {
 	static inline void aes##bits##CbcEncrypt(Aes##bits##CbcContext *ctx,       \
 	                                         void *dst, const void *src,       \
 	                                         size_t size) {                     \
-		uint8_t iv_copy[16];                                                   \
-		memcpy(iv_copy, ctx->iv, 16);                                          \
-		mbedtls_aes_crypt_cbc(&ctx->aes, MBEDTLS_AES_ENCRYPT, size, iv_copy,  \
+		mbedtls_aes_crypt_cbc(&ctx->aes, MBEDTLS_AES_ENCRYPT, size, ctx->iv,  \
 		                      (const unsigned char *)src,                      \
 		                      (unsigned char *)dst);                           \
 	}                                                                          \
 	static inline void aes##bits##CbcDecrypt(Aes##bits##CbcContext *ctx,       \
 	                                         void *dst, const void *src,       \
 	                                         size_t size) {                     \
-		uint8_t iv_copy[16];                                                   \
-		memcpy(iv_copy, ctx->iv, 16);                                          \
-		mbedtls_aes_crypt_cbc(&ctx->aes, MBEDTLS_AES_DECRYPT, size, iv_copy,  \
+		mbedtls_aes_crypt_cbc(&ctx->aes, MBEDTLS_AES_DECRYPT, size, ctx->iv,  \
 		                      (const unsigned char *)src,                      \
 		                      (unsigned char *)dst);                           \
 	}
@@ -594,13 +590,8 @@ typedef struct {
 	static inline void aes##bits##CtrCrypt(Aes##bits##CtrContext *ctx,         \
 	                                       void *dst, const void *src,         \
 	                                       size_t size) {                       \
-		uint8_t ctr_copy[16];                                                  \
-		memcpy(ctr_copy, ctx->ctr, 16);                                        \
-		uint8_t sb[16];                                                        \
-		memcpy(sb, ctx->stream_block, 16);                                     \
-		size_t nc = ctx->nc_off;                                               \
-		mbedtls_aes_crypt_ctr(&ctx->aes, size, &nc, ctr_copy, sb,             \
-		                      (const unsigned char *)src,                      \
+		mbedtls_aes_crypt_ctr(&ctx->aes, size, &ctx->nc_off, ctx->ctr,         \
+		                      ctx->stream_block, (const unsigned char *)src,   \
 		                      (unsigned char *)dst);                           \
 	}
 
@@ -51,7 +51,7 @@ using namespace v8;
 // ---------------------------------------------------------------------------
 #define NX_MOD(name)                                                           \
 	void nx_init_##name(v8::Isolate *, v8::Local<v8::Object>)
-NX_MOD(account); NX_MOD(album); NX_MOD(applet); NX_MOD(audio); NX_MOD(battery);
+NX_MOD(account); NX_MOD(album); NX_MOD(animated_image); NX_MOD(applet); NX_MOD(archive); NX_MOD(audio); NX_MOD(battery);
 NX_MOD(bluetooth);
 NX_MOD(canvas); NX_MOD(compression); NX_MOD(crypto); NX_MOD(dns);
 NX_MOD(dommatrix); NX_MOD(error); NX_MOD(font); NX_MOD(fs); NX_MOD(fsdev);
@@ -302,7 +302,9 @@ static void build_init_object(Isolate *iso, Local<Context> context,
                               Local<Object> init_obj) {
 	nx_init_account(iso, init_obj);
 	nx_init_album(iso, init_obj);
+	nx_init_animated_image(iso, init_obj);
 	nx_init_applet(iso, init_obj);
+	nx_init_archive(iso, init_obj);
 	nx_init_audio(iso, init_obj);
 	nx_init_battery(iso, init_obj);
 	nx_init_bluetooth(iso, init_obj);
@@ -421,6 +423,7 @@ static void build_init_object(Isolate *iso, Local<Context> context,
 		// see the same semantics.
 		cset("heapLimit", Number::New(iso, 512.0 * 1024 * 1024));
 		cset("renderer", nx_str(iso, "auto"));
+		cset("rasterThreads", Integer::NewFromUnsigned(iso, 0));
 		cset("v8Flags", nx_str(iso, ""));
 
 		Local<Object> sock = Object::New(iso);
@@ -0,0 +1,1249 @@
+// Animated image (GIF / APNG / animated WebP) native bindings.
+//
+// PORTABLE (compiled into both the device runtime and the host nxjs-test
+// binary). Frames are decoded on demand on the libuv threadpool into a small
+// ring of reusable canvas-sized BGRA buffers, so memory is bounded by
+// `slots + 2` frames however many frames the file has. The ring follows
+// media-decoder.cc's video ring: a single fill job (producer) at a time, and
+// `animImageTick` (consumer, main thread) pointer-swaps the newest due frame
+// into the embedded nx_image_t.
+//
+// drawImage integration: like nx_video_t, nx_anim_image_t embeds an
+// nx_image_t as its FIRST member so canvas.cc draws it directly.
+//
+// Disposal and blending are applied on the decode side into a persistent
+// composition buffer, so every ring slot holds a complete frame:
+//   - GIF: in-house LZW decoder (there is no giflib in portlibs); disposal
+//     none / background / previous, transparent index.
+//   - APNG: each frame's fdAT/IDAT payload is re-wrapped as a standalone PNG
+//     (IHDR sized to the fcTL region, plus the shared PLTE/tRNS/... chunks)
+//     and decoded by libpng; dispose none / background / previous, blend
+//     source / over. A PNG without acTL is a single-frame animation.
+//   - WebP: libwebpdemux's WebPAnimDecoder, which composes internally.
+#include "animated-image.h"
+#include "async.h"
+#include "error.h"
+#include "image.h"
+#include "wrap.h"
+#include <atomic>
+#include <memory>
+#include <png.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <webp/decode.h>
+#include <webp/demux.h>
+#include <zlib.h>
+
+using namespace v8;
+
+#define NX_ANIM_DEFAULT_SLOTS 3
+#define NX_ANIM_MAX_SLOTS 8
+#define NX_ANIM_MAX_DIM 16384
+// Browsers play frames with a delay of 10ms or less at 100ms: many GIFs in
+// the wild say 0 and expect "normal" speed.
+#define NX_ANIM_MIN_DELAY_MS 10
+#define NX_ANIM_DEFAULT_DELAY_MS 100
+// If presentation falls this far behind schedule (the ring ran dry, or the
+// app stopped calling update()), resynchronise rather than fast-forward.
+#define NX_ANIM_MAX_LAG_MS 250.0
+
+namespace {
+
+enum anim_format { ANIM_GIF, ANIM_PNG, ANIM_WEBP };
+enum anim_dispose { DISPOSE_NONE, DISPOSE_BACKGROUND, DISPOSE_PREVIOUS };
+enum anim_blend { BLEND_SOURCE, BLEND_OVER };
+
+struct anim_frame {
+	uint32_t x, y, w, h;
+	uint32_t duration_ms;
+	uint8_t dispose;
+	uint8_t blend;
+	int transparent;     // GIF: transparent palette index, or -1
+	size_t offset;       // GIF: offset of the image descriptor (0x2c)
+	uint32_t first_span; // APNG: range of anim_decoder::spans
+	uint32_t span_count;
+};
+
+// A run of compressed image data in the source buffer: an IDAT payload, or
+// an fdAT payload minus its sequence number.
+struct anim_span {
+	size_t offset;
+	uint32_t length;
+};
+
+struct anim_decoder {
+	anim_format format;
+	const uint8_t *data = nullptr;
+	size_t size = 0;
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t loop_count = 1; // total plays; 0 = forever
+	std::vector<anim_frame> frames;
+
+	// Composition state (GIF / APNG).
+	uint8_t *canvas = nullptr; // premultiplied BGRA, width*height
+	uint8_t *saved = nullptr;  // DISPOSE_PREVIOUS backup, lazily allocated
+	uint32_t cursor = 0;       // next frame to decode
+	int prev = -1;             // last composed frame, or -1 after a rewind
+
+	// GIF
+	const uint8_t *global_palette = nullptr;
+	int global_palette_size = 0;
+	uint16_t lzw_prefix[4096];
+	uint8_t lzw_suffix[4096];
+	uint8_t lzw_stack[4097];
+
+	// APNG
+	const uint8_t *ihdr = nullptr; // IHDR chunk data (13 bytes)
+	std::vector<anim_span> spans;
+	std::vector<uint8_t> ancillary; // chunks before the first IDAT, verbatim
+	std::vector<uint8_t> png;       // per-frame synthesized PNG stream
+	std::vector<png_bytep> rows;
+	uint8_t *pixels = nullptr; // per-frame decode scratch, <= canvas size
+
+	// WebP
+	WebPAnimDecoder *webp = nullptr;
+
+	~anim_decoder() {
+		free(canvas);
+		free(saved);
+		free(pixels);
+		if (webp)
+			WebPAnimDecoderDelete(webp);
+	}
+};
+
+inline uint16_t rd16le(const uint8_t *p) { return p[0] | (p[1] << 8); }
+inline uint16_t rd16be(const uint8_t *p) { return (p[0] << 8) | p[1]; }
+inline uint32_t rd32be(const uint8_t *p) {
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+	       ((uint32_t)p[2] << 8) | p[3];
+}
+inline void wr32be(uint8_t *p, uint32_t v) {
+	p[0] = v >> 24;
+	p[1] = v >> 16;
+	p[2] = v >> 8;
+	p[3] = v;
+}
+
+inline size_t canvas_bytes(const anim_decoder *d) {
+	return (size_t)d->width * d->height * 4;
+}
+
+// ---- composition helpers ----
+
+void clear_rect(anim_decoder *d, const anim_frame &f) {
+	for (uint32_t y = f.y; y < f.y + f.h && y < d->height; y++) {
+		if (f.x >= d->width)
+			break;
+		uint32_t w = f.w < d->width - f.x ? f.w : d->width - f.x;
+		memset(d->canvas + ((size_t)y * d->width + f.x) * 4, 0, (size_t)w * 4);
+	}
+}
+
+// Copy a frame's rect between two canvas-layout buffers.
+void copy_rect(anim_decoder *d, uint8_t *dst, const uint8_t *src,
+               const anim_frame &f) {
+	for (uint32_t y = f.y; y < f.y + f.h && y < d->height; y++) {
+		if (f.x >= d->width)
+			break;
+		uint32_t w = f.w < d->width - f.x ? f.w : d->width - f.x;
+		size_t off = ((size_t)y * d->width + f.x) * 4;
+		memcpy(dst + off, src + off, (size_t)w * 4);
+	}
+}
+
+void premultiply(uint8_t *px, size_t count) {
+	for (size_t i = 0; i < count; i++, px += 4) {
+		uint32_t a = px[3];
+		if (a == 255)
+			continue;
+		px[0] = (px[0] * a + 127) / 255;
+		px[1] = (px[1] * a + 127) / 255;
+		px[2] = (px[2] * a + 127) / 255;
+	}
+}
+
+// ---- GIF ----
+
+// Skip a run of GIF data sub-blocks at `p`; returns the offset just past the
+// block terminator, or 0 if the data is truncated.
+size_t gif_skip_blocks(const uint8_t *b, size_t size, size_t p) {
+	while (p < size) {
+		uint8_t n = b[p++];
+		if (n == 0)
+			return p;
+		p += n;
+	}
+	return 0;
+}
+
+bool gif_open(anim_decoder *d, const char **err) {
+	const uint8_t *b = d->data;
+	size_t size = d->size;
+	if (size < 13) {
+		*err = "Truncated GIF header";
+		return false;
+	}
+	d->width = rd16le(b + 6);
+	d->height = rd16le(b + 8);
+	uint8_t packed = b[10];
+	size_t p = 13;
+	if (packed & 0x80) {
+		d->global_palette_size = 1 << ((packed & 7) + 1);
+		if (p + 3 * (size_t)d->global_palette_size > size) {
+			*err = "Truncated GIF palette";
+			return false;
+		}
+		d->global_palette = b + p;
+		p += 3 * d->global_palette_size;
+	}
+
+	// Graphic Control Extension state, applied to the next image.
+	uint8_t gce_dispose = DISPOSE_NONE;
+	uint32_t gce_delay = 0;
+	int gce_transparent = -1;
+	while (p < size) {
+		uint8_t tag = b[p++];
+		if (tag == 0x3b) // trailer
+			break;
+		if (tag == 0x21) { // extension
+			if (p >= size)
+				break;
+			uint8_t label = b[p++];
+			if (label == 0xf9 && p + 5 <= size && b[p] >= 4) {
+				uint8_t flags = b[p + 1];
+				uint8_t disposal = (flags >> 2) & 7;
+				gce_dispose = disposal == 2   ? DISPOSE_BACKGROUND
+				              : disposal == 3 ? DISPOSE_PREVIOUS
+				                              : DISPOSE_NONE;
+				gce_delay = rd16le(b + p + 2) * 10;
+				gce_transparent = (flags & 1) ? b[p + 4] : -1;
+			} else if (label == 0xff && p + 12 <= size && b[p] == 11 &&
+			           (!memcmp(b + p + 1, "NETSCAPE2.0", 11) ||
+			            !memcmp(b + p + 1, "ANIMEXTS1.0", 11))) {
+				size_t q = p + 12;
+				if (q + 4 <= size && b[q] >= 3 && b[q + 1] == 1) {
+					// Repetitions after the first play; 0 = forever.
+					uint16_t n = rd16le(b + q + 2);
+					d->loop_count = n ? (uint32_t)n + 1 : 0;
+				}
+			}
+			p = gif_skip_blocks(b, size, p);
+			if (!p)
+				break;
+			continue;
+		}
+		if (tag != 0x2c || p + 9 > size)
+			break; // unknown block or truncated: keep what we have
+		anim_frame f = {};
+		f.offset = p - 1;
+		f.x = rd16le(b + p);
+		f.y = rd16le(b + p + 2);
+		f.w = rd16le(b + p + 4);
+		f.h = rd16le(b + p + 6);
+		uint8_t flags = b[p + 8];
+		p += 9;
+		if (flags & 0x80)
+			p += 3 * ((size_t)1 << ((flags & 7) + 1));
+		p += 1; // LZW minimum code size
+		f.duration_ms = gce_delay;
+		f.dispose = gce_dispose;
+		f.blend = BLEND_OVER;
+		f.transparent = gce_transparent;
+		gce_dispose = DISPOSE_NONE;
+		gce_delay = 0;
+		gce_transparent = -1;
+		p = p < size ? gif_skip_blocks(b, size, p) : 0;
+		if (!p) {
+			// Truncated image data: the LZW decoder stops at the cut, so a
+			// partial first frame is still worth showing.
+			if (d->frames.empty() && f.offset + 10 < size)
+				d->frames.push_back(f);
+			break;
+		}
+		d->frames.push_back(f);
+	}
+	if (d->frames.empty()) {
+		*err = "GIF contains no frames";
+		return false;
+	}
+	if (d->width == 0 || d->height == 0) {
+		d->width = d->frames[0].x + d->frames[0].w;
+		d->height = d->frames[0].y + d->frames[0].h;
+	}
+	return true;
+}
+
+// Maps the `n`th row in an interlaced GIF's stream order to its image row.
+uint32_t gif_interlaced_row(uint32_t n, uint32_t h) {
+	uint32_t pass = (h + 7) / 8;
+	if (n < pass)
+		return n * 8;
+	n -= pass;
+	pass = (h + 3) / 8;
+	if (n < pass)
+		return 4 + n * 8;
+	n -= pass;
+	pass = (h + 1) / 4;
+	if (n < pass)
+		return 2 + n * 4;
+	n -= pass;
+	return 1 + n * 2;
+}
+
+// LSB-first bit reader over GIF data sub-blocks.
+struct gif_bits {
+	const uint8_t *p;
+	const uint8_t *end;
+	uint32_t block = 0; // bytes left in the current sub-block
+	uint32_t acc = 0;
+	int n = 0;
+
+	int read(int size) {
+		while (n < size) {
+			if (!block) {
+				if (p >= end || *p == 0)
+					return -1;
+				block = *p++;
+			}
+			if (p >= end)
+				return -1;
+			acc |= (uint32_t)*p++ << n;
+			n += 8;
+			block--;
+		}
+		int code = acc & ((1u << size) - 1);
+		acc >>= size;
+		n -= size;
+		return code;
+	}
+};
+
+// Writes decoded palette indices straight onto the composition canvas in
+// stream order (so no per-frame index buffer is needed).
+struct gif_sink {
+	anim_decoder *d;
+	const anim_frame *f;
+	const uint8_t *palette;
+	int palette_size;
+	bool interlaced;
+	uint32_t col = 0;
+	uint32_t row = 0;            // in stream order
+	uint8_t *line = nullptr;     // canvas row, or NULL when clipped away
+
+	void begin_row() {
+		uint32_t y = f->y + (interlaced ? gif_interlaced_row(row, f->h) : row);
+		line = y < d->height ? d->canvas + (size_t)y * d->width * 4 : nullptr;
+	}
+	bool full() const { return row >= f->h; }
+	void put(uint8_t index) {
+		uint32_t x = f->x + col;
+		if (line && x < d->width && (int)index != f->transparent &&
+		    index < palette_size) {
+			const uint8_t *rgb = palette + index * 3;
+			uint8_t *px = line + (size_t)x * 4;
+			px[0] = rgb[2];
+			px[1] = rgb[1];
+			px[2] = rgb[0];
+			px[3] = 0xff;
+		}
+		if (++col == f->w) {
+			col = 0;
+			if (++row < f->h)
+				begin_row();
+		}
+	}
+};
+
+bool gif_decode_frame(anim_decoder *d, const anim_frame &f) {
+	const uint8_t *b = d->data;
+	size_t p = f.offset + 9;
+	uint8_t flags = b[p++];
+	const uint8_t *palette = d->global_palette;
+	int palette_size = d->global_palette_size;
+	if (flags & 0x80) {
+		palette_size = 1 << ((flags & 7) + 1);
+		palette = b + p;
+		p += 3 * palette_size;
+	}
+	if (p >= d->size)
+		return false; // also covers a local palette cut short
+	int min_size = b[p++];
+	if (min_size < 2 || min_size > 11)
+		return false;
+	if (f.w == 0 || f.h == 0 || !palette)
+		return true; // nothing drawable
+
+	gif_sink sink = {d, &f, palette, palette_size, (flags & 0x40) != 0};
+	sink.begin_row();
+	gif_bits bits = {b + p, b + d->size};
+	uint16_t *prefix = d->lzw_prefix;
+	uint8_t *suffix = d->lzw_suffix;
+	uint8_t *stack = d->lzw_stack;
+	const int clear = 1 << min_size;
+	const int eoi = clear + 1;
+	int size = min_size + 1;
+	int next = clear + 2;
+	int old = -1;
+	uint8_t first = 0;
+	for (int i = 0; i < clear; i++) {
+		prefix[i] = 0;
+		suffix[i] = (uint8_t)i;
+	}
+	// A truncated or corrupt stream ends the frame early; whatever was
+	// decoded stays on the canvas, as in browsers.
+	while (!sink.full()) {
+		int code = bits.read(size);
+		if (code < 0 || code == eoi)
+			break;
+		if (code == clear) {
+			size = min_size + 1;
+			next = clear + 2;
+			old = -1;
+			continue;
+		}
+		if (old < 0) {
+			if (code >= clear)
+				break;
+			sink.put((uint8_t)code);
+			first = (uint8_t)code;
+			old = code;
+			continue;
+		}
+		int in = code;
+		int sp = 0;
+		if (code >= next) {
+			if (code > next)
+				break;
+			stack[sp++] = first;
+			code = old;
+		}
+		while (code >= clear) {
+			stack[sp++] = suffix[code];
+			code = prefix[code];
+		}
+		first = (uint8_t)code;
+		stack[sp++] = first;
+		if (next < 4096) {
+			prefix[next] = (uint16_t)old;
+			suffix[next] = first;
+			next++;
+			if (next == (1 << size) && size < 12)
+				size++;
+		}
+		old = in;
+		while (sp && !sink.full())
+			sink.put(stack[--sp]);
+	}
+	return true;
+}
+
+// ---- APNG ----
+
+const uint8_t png_signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+
+bool png_open(anim_decoder *d, const char **err) {
+	const uint8_t *b = d->data;
+	size_t size = d->size;
+	size_t p = 8;
+	bool animated = false;
+	bool seen_idat = false;
+	uint32_t num_plays = 0;
+	uint32_t default_spans = 0; // IDAT spans not claimed by an fcTL
+	int cur = -1;
+	while (p + 12 <= size) {
+		uint32_t len = rd32be(b + p);
+		const uint8_t *type = b + p + 4;
+		const uint8_t *cd = b + p + 8;
+		if (len > size - p - 12)
+			break;
+		if (!memcmp(type, "IHDR", 4)) {
+			if (len < 13)
+				break;
+			d->ihdr = cd;
+			d->width = rd32be(cd);
+			d->height = rd32be(cd + 4);
+		} else if (!memcmp(type, "acTL", 4)) {
+			if (len >= 8 && !seen_idat) {
+				animated = true;
+				num_plays = rd32be(cd + 4);
+			}
+		} else if (!memcmp(type, "fcTL", 4)) {
+			if (len >= 26) {
+				anim_frame f = {};
+				f.w = rd32be(cd + 4);
+				f.h = rd32be(cd + 8);
+				f.x = rd32be(cd + 12);
+				f.y = rd32be(cd + 16);
+				uint16_t num = rd16be(cd + 20);
+				uint16_t den = rd16be(cd + 22);
+				f.duration_ms = (uint32_t)num * 1000 / (den ? den : 100);
+				f.dispose = cd[24] == 1   ? DISPOSE_BACKGROUND
+				            : cd[24] == 2 ? DISPOSE_PREVIOUS
+				                          : DISPOSE_NONE;
+				f.blend = cd[25] == 1 ? BLEND_OVER : BLEND_SOURCE;
+				f.transparent = -1;
+				f.first_span = (uint32_t)d->spans.size();
+				d->frames.push_back(f);
+				cur = (int)d->frames.size() - 1;
+			}
+		} else if (!memcmp(type, "IDAT", 4)) {
+			seen_idat = true;
+			d->spans.push_back({p + 8, len});
+			if (cur >= 0)
+				d->frames[cur].span_count++;
+			else
+				default_spans++;
+		} else if (!memcmp(type, "fdAT", 4)) {
+			if (len >= 4 && cur >= 0) {
+				d->spans.push_back({p + 12, len - 4});
+				d->frames[cur].span_count++;
+			}
+		} else if (!memcmp(type, "IEND", 4)) {
+			break;
+		} else if (!seen_idat) {
+			// PLTE, tRNS, gAMA, iCCP, ...: shared by every frame.
+			d->ancillary.insert(d->ancillary.end(), b + p, b + p + 12 + len);
+		}
+		p += 12 + (size_t)len;
+	}
+	if (!d->ihdr || !seen_idat) {
+		*err = "Invalid or truncated PNG";
+		return false;
+	}
+	if (!animated || d->frames.empty()) {
+		// Still PNG: the default image is the only frame.
+		d->frames.clear();
+		anim_frame f = {};
+		f.w = d->width;
+		f.h = d->height;
+		f.blend = BLEND_SOURCE;
+		f.transparent = -1;
+		f.span_count = default_spans;
+		d->frames.push_back(f);
+		num_plays = 1;
+	}
+	for (anim_frame &f : d->frames) {
+		if (f.w == 0 || f.h == 0 || f.span_count == 0 ||
+		    (uint64_t)f.x + f.w > d->width || (uint64_t)f.y + f.h > d->height) {
+			*err = "Invalid APNG frame";
+			return false;
+		}
+	}
+	// The spec treats "previous" on the first frame as "background".
+	if (d->frames[0].dispose == DISPOSE_PREVIOUS)
+		d->frames[0].dispose = DISPOSE_BACKGROUND;
+	d->loop_count = num_plays;
+	return true;
+}
+
+void png_put_chunk(std::vector<uint8_t> &out, const char *type,
+                   const uint8_t *data, uint32_t len) {
+	size_t at = out.size();
+	out.resize(at + 12 + len);
+	uint8_t *p = out.data() + at;
+	wr32be(p, len);
+	memcpy(p + 4, type, 4);
+	if (len)
+		memcpy(p + 8, data, len);
+	wr32be(p + 8 + len, (uint32_t)crc32(0, p + 4, 4 + len));
+}
+
+struct png_mem_reader {
+	const uint8_t *p;
+	size_t left;
+};
+
+void png_mem_read(png_structp png, png_bytep out, png_size_t n) {
+	png_mem_reader *r = (png_mem_reader *)png_get_io_ptr(png);
+	if (n > r->left)
+		png_error(png, "truncated");
+	memcpy(out, r->p, n);
+	r->p += n;
+	r->left -= n;
+}
+
+// Decode a (synthesized) PNG stream of exactly `w`x`h` into `d->pixels` as
+// premultiplied BGRA.
+bool png_decode_pixels(anim_decoder *d, const uint8_t *src, size_t len,
+                       uint32_t w, uint32_t h) {
+	png_structp png =
+	    png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+	if (!png)
+		return false;
+	png_infop info = png_create_info_struct(png);
+	if (!info) {
+		png_destroy_read_struct(&png, NULL, NULL);
+		return false;
+	}
+	d->rows.resize(h);
+	for (uint32_t i = 0; i < h; i++)
+		d->rows[i] = d->pixels + (size_t)i * w * 4;
+	png_mem_reader reader = {src, len};
+	if (setjmp(png_jmpbuf(png))) {
+		png_destroy_read_struct(&png, &info, NULL);
+		return false;
+	}
+	png_set_read_fn(png, &reader, png_mem_read);
+	png_read_info(png, info);
+	int color_type = png_get_color_type(png, info);
+	int bit_depth = png_get_bit_depth(png, info);
+	if (bit_depth == 16)
+		png_set_strip_16(png);
+	if (color_type == PNG_COLOR_TYPE_PALETTE)
+		png_set_palette_to_rgb(png);
+	if (color_type == PNG_COLOR_TYPE_GRAY && bit_depth < 8)
+		png_set_expand_gray_1_2_4_to_8(png);
+	if (png_get_valid(png, info, PNG_INFO_tRNS))
+		png_set_tRNS_to_alpha(png);
+	if (color_type == PNG_COLOR_TYPE_GRAY ||
+	    color_type == PNG_COLOR_TYPE_GRAY_ALPHA)
+		png_set_gray_to_rgb(png);
+	png_set_bgr(png);
+	png_set_filler(png, 0xff, PNG_FILLER_AFTER);
+	png_set_interlace_handling(png);
+	png_read_update_info(png, info);
+	if (png_get_rowbytes(png, info) != (size_t)w * 4)
+		png_error(png, "unexpected row size");
+	png_read_image(png, d->rows.data());
+	png_destroy_read_struct(&png, &info, NULL);
+	premultiply(d->pixels, (size_t)w * h);
+	return true;
+}
+
+bool png_decode_frame(anim_decoder *d, const anim_frame &f) {
+	uint64_t data_len = 0;
+	for (uint32_t i = 0; i < f.span_count; i++)
+		data_len += d->spans[f.first_span + i].length;
+	if (data_len > 0x7fffffff)
+		return false;
+
+	// Re-wrap the frame as a standalone PNG: IHDR sized to the frame, the
+	// shared chunks, then every span concatenated into one IDAT (the zlib
+	// stream is continuous across chunks, so this is lossless).
+	std::vector<uint8_t> &s = d->png;
+	s.clear();
+	s.insert(s.end(), png_signature, png_signature + 8);
+	uint8_t ihdr[13];
+	memcpy(ihdr, d->ihdr, 13);
+	wr32be(ihdr, f.w);
+	wr32be(ihdr + 4, f.h);
+	png_put_chunk(s, "IHDR", ihdr, 13);
+	s.insert(s.end(), d->ancillary.begin(), d->ancillary.end());
+	size_t at = s.size();
+	s.resize(at + 12 + data_len);
+	uint8_t *o = s.data() + at;
+	wr32be(o, (uint32_t)data_len);
+	memcpy(o + 4, "IDAT", 4);
+	uLong crc = crc32(0, o + 4, 4);
+	o += 8;
+	for (uint32_t i = 0; i < f.span_count; i++) {
+		const anim_span &span = d->spans[f.first_span + i];
+		memcpy(o, d->data + span.offset, span.length);
+		crc = crc32(crc, o, span.length);
+		o += span.length;
+	}
+	wr32be(o, (uint32_t)crc);
+	png_put_chunk(s, "IEND", nullptr, 0);
+
+	if (!png_decode_pixels(d, s.data(), s.size(), f.w, f.h))
+		return false;
+	for (uint32_t y = 0; y < f.h; y++) {
+		uint8_t *dst = d->canvas + ((size_t)(f.y + y) * d->width + f.x) * 4;
+		const uint8_t *src = d->pixels + (size_t)y * f.w * 4;
+		if (f.blend == BLEND_SOURCE) {
+			memcpy(dst, src, (size_t)f.w * 4);
+			continue;
+		}
+		for (uint32_t x = 0; x < f.w; x++, dst += 4, src += 4) {
+			uint32_t sa = src[3];
+			if (sa == 255) {
+				memcpy(dst, src, 4);
+			} else if (sa) {
+				uint32_t ia = 255 - sa;
+				for (int c = 0; c < 4; c++)
+					dst[c] = src[c] + (dst[c] * ia + 127) / 255;
+			}
+		}
+	}
+	return true;
+}
+
+// ---- WebP ----
+
+bool webp_open(anim_decoder *d, const char **err) {
+	WebPAnimDecoderOptions opts;
+	if (!WebPAnimDecoderOptionsInit(&opts)) {
+		*err = "libwebp version mismatch";
+		return false;
+	}
+	opts.color_mode = MODE_bgrA; // premultiplied BGRA, as canvas.cc expects
+	opts.use_threads = 0;        // already on a worker
+	WebPData wd = {d->data, d->size};
+	d->webp = WebPAnimDecoderNew(&wd, &opts);
+	WebPAnimInfo info;
+	if (!d->webp || !WebPAnimDecoderGetInfo(d->webp, &info)) {
+		*err = "Invalid WebP";
+		return false;
+	}
+	d->width = info.canvas_width;
+	d->height = info.canvas_height;
+	d->loop_count = info.loop_count;
+	const WebPDemuxer *demux = WebPAnimDecoderGetDemuxer(d->webp);
+	WebPIterator it;
+	if (WebPDemuxGetFrame(demux, 1, &it)) {
+		do {
+			anim_frame f = {};
+			f.x = it.x_offset;
+			f.y = it.y_offset;
+			f.w = it.width;
+			f.h = it.height;
+			f.duration_ms = it.duration > 0 ? it.duration : 0;
+			f.transparent = -1;
+			d->frames.push_back(f);
+		} while (WebPDemuxNextFrame(&it));
+		WebPDemuxReleaseIterator(&it);
+	}
+	if (d->frames.empty()) {
+		*err = "WebP contains no frames";
+		return false;
+	}
+	return true;
+}
+
+// ---- decoder ----
+
+anim_decoder *anim_open(const uint8_t *data, size_t size, const char **err) {
+	anim_decoder *d = new anim_decoder();
+	d->data = data;
+	d->size = size;
+	bool ok;
+	if (size >= 6 &&
+	    (!memcmp(data, "GIF87a", 6) || !memcmp(data, "GIF89a", 6))) {
+		d->format = ANIM_GIF;
+		ok = gif_open(d, err);
+	} else if (size >= 8 && !memcmp(data, png_signature, 8)) {
+		d->format = ANIM_PNG;
+		ok = png_open(d, err);
+	} else if (size >= 12 && !memcmp(data, "RIFF", 4) &&
+	           !memcmp(data + 8, "WEBP", 4)) {
+		d->format = ANIM_WEBP;
+		ok = webp_open(d, err);
+	} else {
+		*err = "Unsupported image format";
+		ok = false;
+	}
+	if (ok && (d->width == 0 || d->height == 0 ||
+	           d->width > NX_ANIM_MAX_DIM || d->height > NX_ANIM_MAX_DIM)) {
+		*err = "Invalid image dimensions";
+		ok = false;
+	}
+	if (ok && d->format != ANIM_WEBP) {
+		d->canvas = (uint8_t *)calloc(1, canvas_bytes(d));
+		if (d->format == ANIM_PNG)
+			d->pixels = (uint8_t *)malloc(canvas_bytes(d));
+		if (!d->canvas || (d->format == ANIM_PNG && !d->pixels)) {
+			*err = "Out of memory";
+			ok = false;
+		}
+	}
+	if (!ok) {
+		delete d;
+		return nullptr;
+	}
+	for (anim_frame &f : d->frames) {
+		if (f.duration_ms <= NX_ANIM_MIN_DELAY_MS)
+			f.duration_ms = NX_ANIM_DEFAULT_DELAY_MS;
+	}
+	// A still image never needs re-decoding.
+	if (d->frames.size() == 1)
+		d->loop_count = 1;
+	return d;
+}
+
+void anim_rewind(anim_decoder *d) {
+	d->cursor = 0;
+	d->prev = -1;
+	if (d->webp)
+		WebPAnimDecoderReset(d->webp);
+}
+
+// Compose the next frame and copy it into `dst` (canvas-sized BGRA).
+bool anim_decode_next(anim_decoder *d, uint8_t *dst, uint32_t *index,
+                      uint32_t *duration) {
+	if (d->cursor >= d->frames.size())
+		return false;
+	const anim_frame &f = d->frames[d->cursor];
+	if (d->format == ANIM_WEBP) {
+		uint8_t *buf = nullptr;
+		int timestamp = 0;
+		if (!WebPAnimDecoderGetNext(d->webp, &buf, &timestamp))
+			return false;
+		memcpy(dst, buf, canvas_bytes(d));
+	} else {
+		if (d->prev < 0) {
+			memset(d->canvas, 0, canvas_bytes(d));
+		} else {
+			const anim_frame &p = d->frames[d->prev];
+			if (p.dispose == DISPOSE_BACKGROUND)
+				clear_rect(d, p);
+			else if (p.dispose == DISPOSE_PREVIOUS && d->saved)
+				copy_rect(d, d->canvas, d->saved, p);
+		}
+		if (f.dispose == DISPOSE_PREVIOUS) {
+			if (!d->saved)
+				d->saved = (uint8_t *)malloc(canvas_bytes(d));
+			if (!d->saved)
+				return false;
+			copy_rect(d, d->saved, d->canvas, f);
+		}
+		bool ok = d->format == ANIM_GIF ? gif_decode_frame(d, f)
+		                                : png_decode_frame(d, f);
+		if (!ok)
+			return false;
+		memcpy(dst, d->canvas, canvas_bytes(d));
+	}
+	*index = d->cursor;
+	*duration = f.duration_ms;
+	d->prev = (int)d->cursor++;
+	return true;
+}
+
+// ---- JS object + frame ring ----
+
+struct anim_slot {
+	uint8_t *bgra = nullptr;
+	uint32_t index = 0;
+	uint32_t duration = 0;
+	uint32_t gen = 0;
+};
+
+struct nx_anim_image_t {
+	// MUST be first: canvas.cc draws any wrapped object as an nx_image_t.
+	nx_image_t image;
+	std::shared_ptr<BackingStore> store; // source bytes, pinned while loaded
+	anim_decoder *dec = nullptr;
+	int slot_count = NX_ANIM_DEFAULT_SLOTS;
+	anim_slot slots[NX_ANIM_MAX_SLOTS];
+
+	// ---- ring (SPSC: fill job -> main thread) ----
+	std::atomic<uint64_t> rd{0};
+	std::atomic<uint64_t> wr{0};
+	// Bumped by reset(): the fill job rewinds the decoder when it sees a new
+	// generation, and presentation drops slots decoded for an older one.
+	std::atomic<uint32_t> gen{0};
+	// Generation whose last frame has been decoded (loop count exhausted).
+	std::atomic<int64_t> done_gen{-1};
+	std::atomic<bool> failed{false};
+	const char *err = nullptr; // written by the fill job before `failed`
+
+	// ---- fill job only ----
+	uint32_t dec_gen = 0;
+	uint32_t plays = 0;
+
+	// ---- main thread only ----
+	bool loading = false;
+	bool filling = false; // a fill job is queued or running
+	bool closed = false;
+	bool started = false;
+	bool error_reported = false;
+	double next_due = 0; // ms timestamp the next frame is due
+	uint32_t frame_index = 0;
+	uint64_t presented = 0;
+	uint64_t dropped = 0;
+};
+
+// Release everything but the struct itself. Main thread, no job in flight.
+void release_anim(nx_anim_image_t *a) {
+	delete a->dec;
+	a->dec = nullptr;
+	for (int i = 0; i < NX_ANIM_MAX_SLOTS; i++) {
+		free(a->slots[i].bgra);
+		a->slots[i].bgra = nullptr;
+	}
+	a->store.reset();
+	nx_image_release_cache(&a->image);
+	free(a->image.data);
+	a->image.data = nullptr;
+	a->image.width = a->image.height = 0;
+}
+
+void free_anim(nx_anim_image_t *a) {
+	// The wrapper is pinned by any in-flight job's payload, so the finalizer
+	// only runs once no job can touch `a`.
+	release_anim(a);
+	delete a;
+}
+
+nx_anim_image_t *get_anim(Isolate *iso, Local<Value> val) {
+	nx_anim_image_t *a = nx::Unwrap<nx_anim_image_t>(val);
+	if (!a || a->image.magic != NX_IMAGE_MAGIC) {
+		nx_throw(iso, "expected AnimatedImage handle");
+		return nullptr;
+	}
+	return a;
+}
+
+// Decode frames into free slots until the ring is full or the final play
+// has been decoded. Runs on the threadpool; never touches V8.
+void fill_ring(nx_anim_image_t *a) {
+	anim_decoder *d = a->dec;
+	for (;;) {
+		uint64_t w = a->wr.load(std::memory_order_relaxed);
+		uint64_t r = a->rd.load(std::memory_order_acquire);
+		if (w - r >= (uint64_t)a->slot_count)
+			return;
+		uint32_t g = a->gen.load(std::memory_order_acquire);
+		if (g != a->dec_gen) {
+			anim_rewind(d);
+			a->plays = 0;
+			a->dec_gen = g;
+		} else if (a->done_gen.load(std::memory_order_relaxed) == g) {
+			return;
+		}
+		if (d->cursor >= d->frames.size()) {
+			a->plays++;
+			if (d->loop_count && a->plays >= d->loop_count) {
+				a->done_gen.store(g, std::memory_order_release);
+				return;
+			}
+			anim_rewind(d);
+		}
+		anim_slot *s = &a->slots[w % a->slot_count];
+		if (!anim_decode_next(d, s->bgra, &s->index, &s->duration)) {
+			a->err = "Failed to decode animation frame";
+			a->failed.store(true, std::memory_order_release);
+			return;
+		}
+		s->gen = g;
+		a->wr.store(w + 1, std::memory_order_release);
+	}
+}
+
+bool ring_needs_fill(nx_anim_image_t *a) {
+	if (a->failed.load(std::memory_order_acquire))
+		return false;
+	uint32_t g = a->gen.load(std::memory_order_relaxed);
+	if (a->done_gen.load(std::memory_order_acquire) == (int64_t)g)
+		return false;
+	return a->wr.load(std::memory_order_acquire) -
+	           a->rd.load(std::memory_order_relaxed) <
+	       (uint64_t)a->slot_count;
+}
+
+void nx_anim_image_new(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	Local<Object> obj = nx::NewWrapped(iso);
+	nx_anim_image_t *a = new nx_anim_image_t();
+	memset(&a->image, 0, sizeof(a->image));
+	a->image.magic = NX_IMAGE_MAGIC;
+	a->image.format = FORMAT_UNKNOWN;
+	nx::Wrap<nx_anim_image_t>(iso, obj, a, free_anim);
+	info.GetReturnValue().Set(obj);
+}
+
+// ---------------------------------------------------------------------------
+// animImageLoad(anim, buffer, slots) -> Promise<metadata>
+// ---------------------------------------------------------------------------
+
+struct anim_load_t {
+	nx_anim_image_t *anim = nullptr;
+	Global<Value> anim_val; // pins the wrapper during the load
+	const char *err = nullptr;
+};
+
+void anim_load_work(nx_work_t *req) {
+	anim_load_t *data = (anim_load_t *)req->data;
+	nx_anim_image_t *a = data->anim;
+	a->dec = anim_open((const uint8_t *)a->store->Data(),
+	                   a->store->ByteLength(), &data->err);
+	if (!a->dec)
+		return;
+	size_t bytes = canvas_bytes(a->dec);
+	for (int i = 0; i < a->slot_count; i++) {
+		a->slots[i].bgra = (uint8_t *)malloc(bytes);
+		if (!a->slots[i].bgra) {
+			data->err = "Out of memory";
+			return;
+		}
+	}
+	// Prime the ring so the first update() has a frame to present.
+	fill_ring(a);
+	if (a->failed.load())
+		data->err = a->err;
+}
+
+MaybeLocal<Value> anim_load_after(Isolate *iso, nx_work_t *req) {
+	Local<Context> context = iso->GetCurrentContext();
+	anim_load_t *data = (anim_load_t *)req->data;
+	nx_anim_image_t *a = data->anim;
+	data->anim_val.Reset();
+	a->loading = false;
+	if (a->closed) {
+		release_anim(a);
+		iso->ThrowException(
+		    Exception::Error(nx_str(iso, "AnimatedImage was closed")));
+		return MaybeLocal<Value>();
+	}
+	if (data->err) {
+		release_anim(a);
+		iso->ThrowException(Exception::Error(nx_str(iso, data->err)));
+		return MaybeLocal<Value>();
+	}
+	anim_decoder *d = a->dec;
+	// Transparent until the first update() presents frame 0.
+	uint8_t *buf = (uint8_t *)nx_alloc(iso, canvas_bytes(d));
+	if (!buf) {
+		release_anim(a);
+		return MaybeLocal<Value>();
+	}
+	memset(buf, 0, canvas_bytes(d));
+	a->image.width = d->width;
+	a->image.height = d->height;
+	a->image.data = buf;
+
+	uint32_t count = (uint32_t)d->frames.size();
+	Local<Array> durations = Array::New(iso, (int)count);
+	for (uint32_t i = 0; i < count; i++) {
+		durations
+		    ->Set(context, i,
+		          Integer::NewFromUnsigned(iso, d->frames[i].duration_ms))
+		    .Check();
+	}
+	Local<Object> result = Object::New(iso);
+	result
+	    ->Set(context, nx_str(iso, "width"),
+	          Integer::NewFromUnsigned(iso, d->width))
+	    .Check();
+	result
+	    ->Set(context, nx_str(iso, "height"),
+	          Integer::NewFromUnsigned(iso, d->height))
+	    .Check();
+	result
+	    ->Set(context, nx_str(iso, "frameCount"),
+	          Integer::NewFromUnsigned(iso, count))
+	    .Check();
+	result
+	    ->Set(context, nx_str(iso, "loopCount"),
+	          Integer::NewFromUnsigned(iso, d->loop_count))
+	    .Check();
+	result->Set(context, nx_str(iso, "durations"), durations).Check();
+	return result.As<Value>();
+}
+
+void nx_anim_image_load(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	Local<Context> context = iso->GetCurrentContext();
+	nx_anim_image_t *a = get_anim(iso, info[0]);
+	if (!a)
+		return;
+	if (a->closed || a->loading || a->dec) {
+		nx_throw(iso, "AnimatedImage is already loaded");
+		return;
+	}
+	if (!info[1]->IsArrayBuffer()) {
+		nx_throw(iso, "expected ArrayBuffer");
+		return;
+	}
+	int32_t slots = NX_ANIM_DEFAULT_SLOTS;
+	if (!info[2]->IsUndefined() && !info[2]->Int32Value(context).To(&slots))
+		return;
+	if (slots < 1 || slots > NX_ANIM_MAX_SLOTS) {
+		iso->ThrowException(Exception::RangeError(
+		    nx_str(iso, "frames must be between 1 and 8")));
+		return;
+	}
+	a->slot_count = slots;
+	a->store = info[1].As<ArrayBuffer>()->GetBackingStore();
+	a->loading = true;
+	NX_INIT_WORK_T_CPP(anim_load_t);
+	data->anim = a;
+	data->anim_val.Reset(iso, info[0]);
+	info.GetReturnValue().Set(
+	    nx_queue_async(iso, req, anim_load_work, anim_load_after));
+}
+
+// ---------------------------------------------------------------------------
+// Presentation
+// ---------------------------------------------------------------------------
+
+struct anim_fill_t {
+	nx_anim_image_t *anim = nullptr;
+	Global<Value> anim_val;
+};
+
+void anim_fill_work(nx_work_t *req) {
+	fill_ring(((anim_fill_t *)req->data)->anim);
+}
+
+MaybeLocal<Value> anim_fill_after(Isolate *iso, nx_work_t *req) {
+	anim_fill_t *data = (anim_fill_t *)req->data;
+	nx_anim_image_t *a = data->anim;
+	data->anim_val.Reset();
+	a->filling = false;
+	if (a->closed)
+		release_anim(a);
+	// Decode errors are sticky on the object and surface from tick(), so
+	// this promise (which nobody awaits) always resolves.
+	return Undefined(iso).As<Value>();
+}
+
+// Queue a fill job on the threadpool if the ring has room.
+void schedule_fill(Isolate *iso, nx_anim_image_t *a, Local<Value> self) {
+	if (a->filling || a->loading || a->closed || !a->dec ||
+	    !ring_needs_fill(a))
+		return;
+	a->filling = true;
+	NX_INIT_WORK_T_CPP(anim_fill_t);
+	data->anim = a;
+	data->anim_val.Reset(iso, self);
+	nx_queue_async(iso, req, anim_fill_work, anim_fill_after);
+}
+
+// animImageTick(anim, nowMs) -> boolean (a new frame was presented)
+void nx_anim_image_tick(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	nx_anim_image_t *a = get_anim(iso, info[0]);
+	if (!a)
+		return;
+	info.GetReturnValue().Set(false);
+	if (!a->dec || a->loading || a->closed)
+		return;
+	double now = 0;
+	if (!info[1]->NumberValue(iso->GetCurrentContext()).To(&now))
+		return;
+	const uint64_t n = (uint64_t)a->slot_count;
+	uint32_t g = a->gen.load(std::memory_order_acquire);
+	uint64_t r = a->rd.load(std::memory_order_relaxed);
+	uint64_t w = a->wr.load(std::memory_order_acquire);
+	// Frames decoded before the last reset() are stale.
+	while (r < w && a->slots[r % n].gen != g)
+		r++;
+	uint64_t first = r;
+	if (!a->started && r < w) {
+		a->started = true;
+		a->next_due = now;
+	}
+	int64_t candidate = -1;
+	while (r < w && now >= a->next_due) {
+		candidate = (int64_t)r;
+		a->next_due += a->slots[r % n].duration;
+		r++;
+	}
+	if (a->started && now - a->next_due > NX_ANIM_MAX_LAG_MS)
+		a->next_due = now;
+	bool presented = false;
+	if (candidate >= 0) {
+		anim_slot *s = &a->slots[candidate % n];
+		uint8_t *prev = a->image.data;
+		a->image.data = s->bgra;
+		s->bgra = prev;
+		nx_image_release_cache(&a->image);
+		a->frame_index = s->index;
+		a->presented++;
+		a->dropped += (uint64_t)candidate - first;
+		presented = true;
+	}
+	a->rd.store(r, std::memory_order_release);
+	if (a->failed.load(std::memory_order_acquire) && r == w &&
+	    !a->error_reported) {
+		a->error_reported = true;
+		nx_throw(iso, a->err);
+		return;
+	}
+	schedule_fill(iso, a, info[0]);
+	info.GetReturnValue().Set(presented);
+}
+
+// animImageReset(anim): restart from frame 0 on the next tick.
+void nx_anim_image_reset(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	nx_anim_image_t *a = get_anim(iso, info[0]);
+	if (!a || a->closed)
+		return;
+	a->gen.fetch_add(1, std::memory_order_acq_rel);
+	a->started = false;
+	schedule_fill(iso, a, info[0]);
+}
+
+// animImageState(anim) -> { frameIndex, presentedFrames, droppedFrames,
+//                           bufferedFrames, ended }
+void nx_anim_image_state(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	Local<Context> context = iso->GetCurrentContext();
+	nx_anim_image_t *a = get_anim(iso, info[0]);
+	if (!a)
+		return;
+	uint32_t g = a->gen.load(std::memory_order_relaxed);
+	uint64_t r = a->rd.load(std::memory_order_relaxed);
+	uint64_t w = a->wr.load(std::memory_order_acquire);
+	bool ended = a->started && r == w &&
+	             a->done_gen.load(std::memory_order_acquire) == (int64_t)g;
+	Local<Object> result = Object::New(iso);
+	result
+	    ->Set(context, nx_str(iso, "frameIndex"),
+	          Integer::NewFromUnsigned(iso, a->frame_index))
+	    .Check();
+	result
+	    ->Set(context, nx_str(iso, "presentedFrames"),
+	          Number::New(iso, (double)a->presented))
+	    .Check();
+	result
+	    ->Set(context, nx_str(iso, "droppedFrames"),
+	          Number::New(iso, (double)a->dropped))
+	    .Check();
+	result
+	    ->Set(context, nx_str(iso, "bufferedFrames"),
+	          Integer::NewFromUnsigned(iso, (uint32_t)(w - r)))
+	    .Check();
+	result->Set(context, nx_str(iso, "ended"), Boolean::New(iso, ended))
+	    .Check();
+	info.GetReturnValue().Set(result);
+}
+
+void nx_anim_image_close(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	nx_anim_image_t *a = get_anim(iso, info[0]);
+	if (!a || a->closed)
+		return;
+	a->closed = true;
+	// An in-flight job still owns the decoder; its after-callback releases.
+	if (!a->loading && !a->filling)
+		release_anim(a);
+}
+
+} // namespace
+
+// ---- shared, non-namespaced symbols ----
+
+uint8_t *nx_anim_decode_first_frame(const uint8_t *data, size_t size,
+                                    u32 *width, u32 *height) {
+	const char *err = nullptr;
+	anim_decoder *d = anim_open(data, size, &err);
+	if (!d)
+		return NULL;
+	uint8_t *out = (uint8_t *)malloc(canvas_bytes(d));
+	uint32_t index, duration;
+	if (out && !anim_decode_next(d, out, &index, &duration)) {
+		free(out);
+		out = NULL;
+	}
+	if (out) {
+		*width = d->width;
+		*height = d->height;
+	}
+	delete d;
+	return out;
+}
+
+void nx_init_animated_image(Isolate *iso, Local<Object> init_obj) {
+	NX_SET_FUNC(init_obj, "animImageNew", nx_anim_image_new);
+	NX_SET_FUNC(init_obj, "animImageLoad", nx_anim_image_load);
+	NX_SET_FUNC(init_obj, "animImageTick", nx_anim_image_tick);
+	NX_SET_FUNC(init_obj, "animImageReset", nx_anim_image_reset);
+	NX_SET_FUNC(init_obj, "animImageState", nx_anim_image_state);
+	NX_SET_FUNC(init_obj, "animImageClose", nx_anim_image_close);
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include "types.h"
+
+// Decode the first (default) frame of a GIF, APNG/PNG or animated/still WebP
+// into a malloc'd premultiplied BGRA buffer (width*4 stride), or NULL if the
+// data is not a supported image. No V8 — image.cc calls this from the
+// threadpool so `Image` / `createImageBitmap()` accept animated sources (the
+// canvas draws the first frame, as browsers do).
+uint8_t *nx_anim_decode_first_frame(const uint8_t *data, size_t size,
+                                    u32 *width, u32 *height);
+
+void nx_init_animated_image(v8::Isolate *iso, v8::Local<v8::Object> init_obj);
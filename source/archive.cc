@@ -0,0 +1,912 @@
+#include "archive.h"
+#include "async.h"
+#include "compression.h"
+#include "error.h"
+#include "types.h"
+#include "util.h"
+#include "wrap.h"
+#include <algorithm>
+#include <atomic>
+#include <ctype.h>
+#include <errno.h>
+#include <mutex>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <zlib.h>
+
+using namespace v8;
+
+// ===========================================================================
+// Archive reader (Switch.Archive): ZIP and tar files, read in place.
+//
+// Opening an archive reads its index once, on the thread pool: the ZIP
+// central directory (one read at the end of the file), or each tar header in
+// turn (tar has no index). Entries are then found by name in O(1), and read
+// from the one file handle the archive keeps open, so reading thousands of
+// small assets costs no per-file path lookups on the SD card's FAT32.
+// Compressed ZIP entries (deflate, or zstd as method 93) are decompressed by
+// compression.cc, in a single pass into a buffer of the recorded size.
+//
+// An archive can be mounted under a name, as a read-only file system which
+// readFile() / readFileSync() (fs.cc) and the module loader (module.cc)
+// consult before the real file systems: see nx_archive_read_path().
+// ===========================================================================
+
+namespace {
+
+// ZIP compression methods which can be read (others fail with ENOTSUP).
+#define ZIP_STORED 0
+#define ZIP_DEFLATE 8
+#define ZIP_ZSTD 93
+
+#define ZIP_LOCAL_SIG 0x04034b50
+#define ZIP_CENTRAL_SIG 0x02014b50
+#define ZIP_EOCD_SIG 0x06054b50
+#define ZIP_EOCD64_SIG 0x06064b50
+#define ZIP_EOCD64_LOCATOR_SIG 0x07064b50
+#define ZIP_EOCD_SIZE 22
+#define ZIP_COMMENT_MAX 0xffff
+
+#define TAR_BLOCK 512
+// Largest GNU long name / pax header read (their data is otherwise skipped).
+#define TAR_META_MAX (64 * 1024)
+
+// Buffered reads while parsing, so that a tar header and the small file
+// after it usually come from the same read.
+#define NX_ARCHIVE_IO_BUFFER (64 * 1024)
+
+#define NX_MOUNT_NAME_MAX 31
+
+#define UNRECOGNIZED "Unrecognized archive format (expected ZIP or tar)"
+
+struct nx_archive_entry_t {
+	uint64_t offset = 0;  // of the data (ZIP: of the local header, until
+	bool located = false; // located by zip_locate())
+	uint64_t size = 0;
+	uint64_t compressed_size = 0;
+	uint32_t crc = 0;
+	uint16_t method = ZIP_STORED;
+	bool encrypted = false;
+	double mtime = 0; // milliseconds since the epoch
+};
+
+// Shared by its JS object, its mount and any read in flight; entries are
+// read-only once the archive is open, apart from the ZIP data offsets
+// (guarded by `lock`, with the file position).
+struct nx_archive_t {
+	std::atomic<int> refs{1};
+	bool zip = false;
+	FILE *file = NULL;
+	std::mutex lock;
+	std::unordered_map<std::string, nx_archive_entry_t> entries;
+	std::vector<const std::string *> names; // in archive order
+	std::string mount;                      // main thread only
+
+	~nx_archive_t() {
+		if (file)
+			fclose(file);
+	}
+};
+
+nx_archive_t *archive_ref(nx_archive_t *a) {
+	a->refs.fetch_add(1, std::memory_order_relaxed);
+	return a;
+}
+
+void archive_unref(nx_archive_t *a) {
+	if (a && a->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		delete a;
+}
+
+nx_archive_t *get_archive(Local<Value> v) {
+	return nx::Unwrap<nx_archive_t>(v);
+}
+
+// ---- mounts ----
+// Mount name -> archive (a reference). Looked up by thread pool workers
+// (readFile), so guarded; `g_mount_count` lets paths skip the lock when
+// nothing is mounted.
+std::mutex g_mounts_lock;
+std::unordered_map<std::string, nx_archive_t *> g_mounts;
+std::atomic<int> g_mount_count{0};
+
+void archive_unmount(nx_archive_t *a) {
+	if (a->mount.empty())
+		return;
+	{
+		std::lock_guard<std::mutex> guard(g_mounts_lock);
+		g_mounts.erase(a->mount);
+		g_mount_count.fetch_sub(1, std::memory_order_relaxed);
+	}
+	a->mount.clear();
+	archive_unref(a);
+}
+
+// ---- parsing ----
+uint16_t le16(const uint8_t *p) { return p[0] | p[1] << 8; }
+
+uint32_t le32(const uint8_t *p) {
+	return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+uint64_t le64(const uint8_t *p) {
+	return le32(p) | (uint64_t)le32(p + 4) << 32;
+}
+
+bool read_at(FILE *f, uint64_t offset, void *buf, size_t size) {
+	return fseek(f, (long)offset, SEEK_SET) == 0 &&
+	       fread(buf, 1, size, f) == size;
+}
+
+// Days from 1970-01-01 to a (proleptic Gregorian) date.
+int64_t days_from_civil(int y, unsigned m, unsigned d) {
+	y -= m <= 2;
+	int64_t era = (y >= 0 ? y : y - 399) / 400;
+	unsigned yoe = (unsigned)(y - era * 400);
+	unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+	unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return era * 146097 + (int64_t)doe - 719468;
+}
+
+// A ZIP (MS-DOS) timestamp, which has no time zone: taken as UTC.
+double dos_time(uint16_t time, uint16_t date) {
+	unsigned month = (date >> 5) & 0xf, day = date & 0x1f;
+	if (month < 1 || month > 12 || day < 1)
+		return 0;
+	int64_t days = days_from_civil(1980 + (date >> 9), month, day);
+	int64_t secs = days * 86400 + (time >> 11) * 3600 +
+	               ((time >> 5) & 0x3f) * 60 + (time & 0x1f) * 2;
+	return (double)secs * 1000;
+}
+
+// Entry names as looked up: without a leading "./" or "/".
+std::string entry_name(const char *name, size_t len) {
+	while (len) {
+		if (name[0] == '/') {
+			name++;
+			len--;
+		} else if (len > 1 && name[0] == '.' && name[1] == '/') {
+			name += 2;
+			len -= 2;
+		} else {
+			break;
+		}
+	}
+	return std::string(name, len);
+}
+
+void add_entry(nx_archive_t *a, std::string name,
+               const nx_archive_entry_t &e) {
+	// A name stored twice (e.g. appended to a tar) reads as the last copy.
+	auto r = a->entries.insert_or_assign(std::move(name), e);
+	if (r.second)
+		a->names.push_back(&r.first->first);
+}
+
+// Applies a central directory entry's extra fields: ZIP64 sizes and offset
+// (present for each field saturated in the entry itself), and the Unix
+// modification time of the "extended timestamp" field.
+void zip_extra(const uint8_t *p, size_t len, nx_archive_entry_t *e,
+               uint32_t size32, uint32_t csize32, uint32_t offset32) {
+	while (len >= 4) {
+		uint16_t id = le16(p), n = le16(p + 2);
+		const uint8_t *d = p + 4;
+		if ((size_t)n + 4 > len)
+			break;
+		if (id == 0x0001) {
+			const uint8_t *end = d + n;
+			if (size32 == 0xffffffff && d + 8 <= end) {
+				e->size = le64(d);
+				d += 8;
+			}
+			if (csize32 == 0xffffffff && d + 8 <= end) {
+				e->compressed_size = le64(d);
+				d += 8;
+			}
+			if (offset32 == 0xffffffff && d + 8 <= end)
+				e->offset = le64(d);
+		} else if (id == 0x5455 && n >= 5 && (d[0] & 1)) {
+			e->mtime = (double)(int32_t)le32(d + 1) * 1000;
+		}
+		p += 4 + n;
+		len -= 4 + n;
+	}
+}
+
+// Reads the central directory, found from the end of central directory
+// record (searched for before the archive comment). Returns NULL, or why
+// the file is not a readable ZIP archive.
+const char *zip_parse(nx_archive_t *a, uint64_t file_size, int *err) {
+	size_t tail_size = (size_t)std::min<uint64_t>(
+	    file_size, ZIP_EOCD_SIZE + ZIP_COMMENT_MAX);
+	std::vector<uint8_t> tail(tail_size);
+	if (!read_at(a->file, file_size - tail_size, tail.data(), tail_size)) {
+		*err = errno ? errno : EIO;
+		return NULL;
+	}
+	size_t i = tail_size >= ZIP_EOCD_SIZE ? tail_size - ZIP_EOCD_SIZE + 1 : 0;
+	const uint8_t *eocd = NULL;
+	while (i-- > 0) {
+		if (le32(&tail[i]) == ZIP_EOCD_SIG) {
+			eocd = &tail[i];
+			break;
+		}
+	}
+	if (!eocd)
+		return "End of central directory not found";
+	uint64_t count = le16(eocd + 10);
+	uint64_t cd_size = le32(eocd + 12);
+	uint64_t cd_offset = le32(eocd + 16);
+	uint64_t eocd_offset = file_size - tail_size + i;
+	if ((count == 0xffff || cd_size == 0xffffffff ||
+	     cd_offset == 0xffffffff) &&
+	    eocd_offset >= 20) {
+		uint8_t loc[20], rec[56];
+		if (!read_at(a->file, eocd_offset - 20, loc, sizeof(loc))) {
+			*err = errno ? errno : EIO;
+			return NULL;
+		}
+		if (le32(loc) == ZIP_EOCD64_LOCATOR_SIG) {
+			if (!read_at(a->file, le64(loc + 8), rec, sizeof(rec)) ||
+			    le32(rec) != ZIP_EOCD64_SIG)
+				return "Invalid ZIP64 end of central directory";
+			count = le64(rec + 32);
+			cd_size = le64(rec + 40);
+			cd_offset = le64(rec + 48);
+		}
+	}
+	if (cd_offset > file_size || cd_size > file_size - cd_offset)
+		return "Central directory is out of bounds";
+
+	std::vector<uint8_t> cd((size_t)cd_size);
+	if (cd_size && !read_at(a->file, cd_offset, cd.data(), cd.size())) {
+		*err = errno ? errno : EIO;
+		return NULL;
+	}
+	a->entries.reserve((size_t)std::min<uint64_t>(count, cd_size / 46));
+	size_t pos = 0;
+	for (uint64_t n = 0; n < count; n++) {
+		if (cd.size() - pos < 46 || le32(&cd[pos]) != ZIP_CENTRAL_SIG)
+			return "Invalid central directory entry";
+		const uint8_t *h = &cd[pos];
+		uint16_t name_len = le16(h + 28), extra_len = le16(h + 30),
+		         comment_len = le16(h + 32);
+		if (cd.size() - pos - 46 < (size_t)name_len + extra_len + comment_len)
+			return "Invalid central directory entry";
+		pos += 46 + name_len + extra_len + comment_len;
+
+		const char *name = (const char *)h + 46;
+		if (!name_len || name[name_len - 1] == '/')
+			continue; // a directory
+		nx_archive_entry_t e;
+		e.encrypted = le16(h + 8) & 1;
+		e.method = le16(h + 10);
+		e.crc = le32(h + 16);
+		e.compressed_size = le32(h + 20);
+		e.size = le32(h + 24);
+		e.offset = le32(h + 42);
+		e.mtime = dos_time(le16(h + 12), le16(h + 14));
+		zip_extra(h + 46 + name_len, extra_len, &e, le32(h + 24),
+		          le32(h + 20), le32(h + 42));
+		if (e.offset > file_size ||
+		    e.compressed_size > file_size - e.offset)
+			return "Entry data is out of bounds";
+		add_entry(a, entry_name(name, name_len), e);
+	}
+	return NULL;
+}
+
+// A tar header number: octal digits, or (GNU, for large values) base-256
+// with the high bit of the first byte set.
+uint64_t tar_number(const uint8_t *p, size_t len) {
+	uint64_t v = 0;
+	if (p[0] & 0x80) {
+		v = p[0] & 0x7f;
+		for (size_t i = 1; i < len; i++)
+			v = v << 8 | p[i];
+		return v;
+	}
+	size_t i = 0;
+	while (i < len && p[i] == ' ')
+		i++;
+	for (; i < len && p[i] >= '0' && p[i] <= '7'; i++)
+		v = v << 3 | (p[i] - '0');
+	return v;
+}
+
+bool tar_checksum_ok(const uint8_t *h) {
+	uint64_t sum = 0;
+	for (size_t i = 0; i < TAR_BLOCK; i++)
+		sum += (i >= 148 && i < 156) ? ' ' : h[i];
+	return sum == tar_number(h + 148, 8);
+}
+
+// The "path" record of a pax extended header ("<len> path=<value>\n").
+bool pax_path(const char *p, size_t len, std::string *path) {
+	size_t pos = 0;
+	while (pos < len) {
+		char *end;
+		unsigned long n = strtoul(p + pos, &end, 10);
+		if (!n || n > len - pos || *end != ' ')
+			return false;
+		const char *kv = end + 1, *rec_end = p + pos + n - 1; // at '\n'
+		if (rec_end > kv && !strncmp(kv, "path=", 5))
+			*path = std::string(kv + 5, rec_end - kv - 5);
+		pos += n;
+	}
+	return true;
+}
+
+// Reads each header of a ustar / GNU / pax tar file. Returns NULL, or why
+// the file is not a readable tar archive.
+const char *tar_parse(nx_archive_t *a, uint64_t file_size, int *err) {
+	uint8_t h[TAR_BLOCK];
+	std::string long_name;
+	bool have_long_name = false;
+	uint64_t offset = 0;
+	while (file_size - offset >= TAR_BLOCK) {
+		if (!read_at(a->file, offset, h, TAR_BLOCK)) {
+			*err = errno ? errno : EIO;
+			return NULL;
+		}
+		bool zero = true;
+		for (size_t i = 0; zero && i < TAR_BLOCK; i++)
+			zero = !h[i];
+		if (zero)
+			break; // end of archive
+		if (!tar_checksum_ok(h))
+			return offset ? "Invalid tar header checksum" : UNRECOGNIZED;
+		uint64_t size = tar_number(h + 124, 12);
+		uint64_t data = offset + TAR_BLOCK;
+		if (size > file_size - data)
+			return "Truncated tar archive";
+		offset = data + ((size + TAR_BLOCK - 1) & ~(uint64_t)(TAR_BLOCK - 1));
+
+		char type = (char)h[156];
+		if (type == 'L' || type == 'x') {
+			// The name of the next entry.
+			if (size > TAR_META_MAX)
+				return "Tar extended header is too large";
+			std::string meta((size_t)size, '\0');
+			if (size && !read_at(a->file, data, &meta[0], meta.size())) {
+				*err = errno ? errno : EIO;
+				return NULL;
+			}
+			long_name.clear();
+			if (type == 'L') {
+				long_name.assign(meta.c_str());
+				have_long_name = true;
+			} else if (!pax_path(meta.data(), meta.size(), &long_name)) {
+				return "Invalid pax extended header";
+			} else {
+				have_long_name = !long_name.empty();
+			}
+			continue;
+		}
+		if (type != '0' && type != '\0' && type != '7') {
+			have_long_name = false; // directories, links, etc.
+			continue;
+		}
+
+		std::string name;
+		if (have_long_name) {
+			name = std::move(long_name);
+			have_long_name = false;
+		} else {
+			name.assign((const char *)h, strnlen((const char *)h, 100));
+			if (!memcmp(h + 257, "ustar\0", 6) && h[345]) {
+				std::string prefix((const char *)h + 345,
+				                   strnlen((const char *)h + 345, 155));
+				name = prefix + "/" + name;
+			}
+		}
+		if (name.empty() || name.back() == '/')
+			continue;
+		nx_archive_entry_t e;
+		e.offset = data;
+		e.located = true;
+		e.size = e.compressed_size = size;
+		e.mtime = (double)tar_number(h + 136, 12) * 1000;
+		add_entry(a, entry_name(name.data(), name.size()), e);
+	}
+	return NULL;
+}
+
+// ---- reading ----
+// Moves `e->offset` past its ZIP local header (whose name and extra field
+// may differ in length from the central directory's). Archive locked.
+bool zip_locate(nx_archive_t *a, nx_archive_entry_t *e) {
+	if (e->located)
+		return true;
+	uint8_t h[30];
+	if (!read_at(a->file, e->offset, h, sizeof(h)) ||
+	    le32(h) != ZIP_LOCAL_SIG)
+		return false;
+	e->offset += sizeof(h) + le16(h + 26) + le16(h + 28);
+	e->located = true;
+	return true;
+}
+
+// Returns the entry's data offset, or an errno value. Any thread.
+int archive_locate(nx_archive_t *a, nx_archive_entry_t *e, uint64_t *offset) {
+	std::lock_guard<std::mutex> guard(a->lock);
+	if (!zip_locate(a, e))
+		return EIO;
+	*offset = e->offset;
+	return 0;
+}
+
+bool method_supported(const nx_archive_entry_t *e) {
+	return !e->encrypted &&
+	       (e->method == ZIP_STORED || e->method == ZIP_DEFLATE ||
+	        e->method == ZIP_ZSTD);
+}
+
+// Reads bytes [start, end) of the entry (clamped to its size) into a new
+// malloc'd buffer, with a NUL byte after them. Returns 0 or an errno value:
+// ENOTSUP for an encrypted entry or unknown compression method, EBADMSG for
+// corrupt data. Whole ZIP entries are checked against their CRC-32. Any
+// thread: only the file reads are serialized.
+int archive_read(nx_archive_t *a, nx_archive_entry_t *e, uint64_t start,
+                 uint64_t end, uint8_t **out, size_t *out_size) {
+	if (!method_supported(e))
+		return ENOTSUP;
+	if (end > e->size)
+		end = e->size;
+	if (start > end)
+		start = end;
+	bool whole = start == 0 && end == e->size;
+	if (e->size >= SIZE_MAX || e->compressed_size >= SIZE_MAX)
+		return ENOMEM;
+	size_t n = (size_t)(end - start);
+	uint8_t *buf;
+	if (e->method == ZIP_STORED) {
+		buf = (uint8_t *)malloc(n + 1);
+		if (!buf)
+			return ENOMEM;
+		std::lock_guard<std::mutex> guard(a->lock);
+		if (!zip_locate(a, e) ||
+		    (n && !read_at(a->file, e->offset + start, buf, n))) {
+			free(buf);
+			return EIO;
+		}
+	} else {
+		size_t csize = (size_t)e->compressed_size;
+		uint8_t *in = (uint8_t *)malloc(csize ? csize : 1);
+		buf = (uint8_t *)malloc((size_t)e->size + 1);
+		if (!in || !buf) {
+			free(in);
+			free(buf);
+			return ENOMEM;
+		}
+		{
+			std::lock_guard<std::mutex> guard(a->lock);
+			if (!zip_locate(a, e) ||
+			    (csize && !read_at(a->file, e->offset, in, csize))) {
+				free(in);
+				free(buf);
+				return EIO;
+			}
+		}
+		bool ok = nx_decompress_exact(e->method == ZIP_ZSTD
+		                                  ? NX_COMPRESSION_FORMAT_ZSTD
+		                                  : NX_COMPRESSION_FORMAT_DEFLATE_RAW,
+		                              in, csize, buf, (size_t)e->size);
+		free(in);
+		if (!ok) {
+			free(buf);
+			return EBADMSG;
+		}
+	}
+	if (a->zip && whole && crc32_z(0, buf, n) != e->crc) {
+		free(buf);
+		return EBADMSG;
+	}
+	if (start && e->method != ZIP_STORED) {
+		memmove(buf, buf + start, n);
+		uint8_t *trimmed = (uint8_t *)realloc(buf, n + 1);
+		if (trimmed)
+			buf = trimmed;
+	}
+	buf[n] = '\0';
+	*out = buf;
+	*out_size = n;
+	return 0;
+}
+
+// Reads a whole entry, by name. Returns 0 or an errno value (ENOENT when
+// there is no such entry).
+int archive_read_name(nx_archive_t *a, const std::string &name, uint64_t start,
+                      uint64_t end, uint8_t **out, size_t *out_size) {
+	auto it = a->entries.find(name);
+	if (it == a->entries.end())
+		return ENOENT;
+	return archive_read(a, &it->second, start, end, out, out_size);
+}
+
+// The exception for a failed read of entry `name`.
+void throw_read_error(Isolate *iso, int err, const char *name) {
+	char msg[512];
+	if (err == ENOTSUP) {
+		snprintf(msg, sizeof(msg),
+		         "Failed to read '%s': unsupported compression method or "
+		         "encryption",
+		         name);
+	} else if (err == EBADMSG) {
+		snprintf(msg, sizeof(msg), "Failed to read '%s': the data is corrupt",
+		         name);
+	} else {
+		nx_throw_errno_error(iso, err, "fread");
+		return;
+	}
+	iso->ThrowException(Exception::TypeError(nx_str(iso, msg)));
+}
+
+Local<ArrayBuffer> take_buffer(Isolate *iso, uint8_t *buf, size_t size) {
+	std::unique_ptr<BackingStore> bs = ArrayBuffer::NewBackingStore(
+	    buf, size, [](void *p, size_t, void *) { free(p); }, nullptr);
+	return ArrayBuffer::New(iso, std::move(bs));
+}
+
+// ---- $.archiveOpen ----
+struct archive_open_t {
+	std::string path;
+	nx_archive_t *archive = nullptr;
+	int err = 0;
+	const char *message = nullptr; // static string
+
+	~archive_open_t() { archive_unref(archive); }
+};
+
+void archive_open_do(nx_work_t *req) {
+	archive_open_t *d = (archive_open_t *)req->data;
+	FILE *file = fopen(d->path.c_str(), "rb");
+	if (!file) {
+		d->err = errno;
+		return;
+	}
+	nx_archive_t *a = new nx_archive_t();
+	a->file = file;
+	d->archive = a;
+	setvbuf(file, NULL, _IOFBF, NX_ARCHIVE_IO_BUFFER);
+	if (fseek(file, 0, SEEK_END) != 0) {
+		d->err = errno;
+		return;
+	}
+	long size = ftell(file);
+	uint8_t magic[4] = {0};
+	if (size < 0 || (size >= 4 && !read_at(file, 0, magic, 4))) {
+		d->err = errno ? errno : EIO;
+		return;
+	}
+	// A ZIP file starts with a local header, or (when empty) the end of
+	// central directory record; anything else is read as tar.
+	a->zip = le32(magic) == ZIP_LOCAL_SIG || le32(magic) == ZIP_EOCD_SIG;
+	if (a->zip)
+		d->message = zip_parse(a, (uint64_t)size, &d->err);
+	else if (size >= TAR_BLOCK)
+		d->message = tar_parse(a, (uint64_t)size, &d->err);
+	else
+		d->message = UNRECOGNIZED;
+}
+
+MaybeLocal<Value> archive_open_cb(Isolate *iso, nx_work_t *req) {
+	archive_open_t *d = (archive_open_t *)req->data;
+	if (d->err) {
+		nx_throw_errno_error(iso, d->err, "fopen");
+		return MaybeLocal<Value>();
+	}
+	if (d->message) {
+		char msg[512];
+		snprintf(msg, sizeof(msg), "Failed to open '%s': %s", d->path.c_str(),
+		         d->message);
+		iso->ThrowException(Exception::TypeError(nx_str(iso, msg)));
+		return MaybeLocal<Value>();
+	}
+	Local<Context> ctx = iso->GetCurrentContext();
+	Local<Object> obj = nx::NewWrapped(iso);
+	nx_archive_t *a = d->archive;
+	d->archive = nullptr;
+	nx::Wrap<nx_archive_t>(iso, obj, a, archive_unref);
+	Local<Array> arr = Array::New(iso, 2);
+	arr->Set(ctx, 0, obj).Check();
+	arr->Set(ctx, 1, nx_str(iso, a->zip ? "zip" : "tar")).Check();
+	return arr.As<Value>();
+}
+
+// $.archiveOpen(path) -> Promise<[handle, 'zip' | 'tar']>
+void nx_archive_open(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	String::Utf8Value path(iso, info[0]);
+	if (!*path)
+		return;
+	NX_INIT_WORK_T_CPP(archive_open_t);
+	data->path = *path;
+	info.GetReturnValue().Set(
+	    nx_queue_async(iso, req, archive_open_do, archive_open_cb));
+}
+
+// $.archiveNames(handle) -> string[], in archive order
+void nx_archive_names(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	nx_archive_t *a = get_archive(info[0]);
+	if (!a)
+		return;
+	Local<Context> ctx = iso->GetCurrentContext();
+	Local<Array> arr = Array::New(iso, (int)a->names.size());
+	for (size_t i = 0; i < a->names.size(); i++) {
+		const std::string *name = a->names[i];
+		Local<String> str;
+		if (!String::NewFromUtf8(iso, name->data(), NewStringType::kNormal,
+		                         (int)name->size())
+		         .ToLocal(&str))
+			return;
+		arr->Set(ctx, (uint32_t)i, str).Check();
+	}
+	info.GetReturnValue().Set(arr);
+}
+
+// $.archiveEntry(handle, name) -> [size, compressedSize, lastModified] | null
+void nx_archive_entry(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	nx_archive_t *a = get_archive(info[0]);
+	String::Utf8Value name(iso, info[1]);
+	if (!a || !*name)
+		return;
+	auto it = a->entries.find(entry_name(*name, name.length()));
+	if (it == a->entries.end()) {
+		info.GetReturnValue().SetNull();
+		return;
+	}
+	const nx_archive_entry_t &e = it->second;
+	Local<Context> ctx = iso->GetCurrentContext();
+	Local<Array> arr = Array::New(iso, 3);
+	arr->Set(ctx, 0, Number::New(iso, (double)e.size)).Check();
+	arr->Set(ctx, 1, Number::New(iso, (double)e.compressed_size)).Check();
+	arr->Set(ctx, 2, Number::New(iso, e.mtime)).Check();
+	info.GetReturnValue().Set(arr);
+}
+
+// ---- $.archiveRead / $.archiveReadSync ----
+struct archive_read_t {
+	nx_archive_t *archive = nullptr; // a reference
+	std::string name;
+	uint8_t *result = nullptr;
+	size_t size = 0;
+	int err = 0;
+
+	~archive_read_t() {
+		free(result);
+		archive_unref(archive);
+	}
+};
+
+void archive_read_do(nx_work_t *req) {
+	archive_read_t *d = (archive_read_t *)req->data;
+	d->err = archive_read_name(d->archive, d->name, 0, UINT64_MAX, &d->result,
+	                           &d->size);
+}
+
+MaybeLocal<Value> archive_read_cb(Isolate *iso, nx_work_t *req) {
+	archive_read_t *d = (archive_read_t *)req->data;
+	if (d->err == ENOENT)
+		return Null(iso).As<Value>();
+	if (d->err) {
+		throw_read_error(iso, d->err, d->name.c_str());
+		return MaybeLocal<Value>();
+	}
+	uint8_t *buf = d->result;
+	d->result = nullptr;
+	return take_buffer(iso, buf, d->size).As<Value>();
+}
+
+// $.archiveRead(handle, name) -> Promise<ArrayBuffer | null>
+void nx_archive_read(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	nx_archive_t *a = get_archive(info[0]);
+	String::Utf8Value name(iso, info[1]);
+	if (!a || !*name)
+		return;
+	NX_INIT_WORK_T_CPP(archive_read_t);
+	data->archive = archive_ref(a);
+	data->name = entry_name(*name, name.length());
+	info.GetReturnValue().Set(
+	    nx_queue_async(iso, req, archive_read_do, archive_read_cb));
+}
+
+// $.archiveReadSync(handle, name) -> ArrayBuffer | null
+void nx_archive_read_sync(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	nx_archive_t *a = get_archive(info[0]);
+	String::Utf8Value name(iso, info[1]);
+	if (!a || !*name)
+		return;
+	uint8_t *buf;
+	size_t size;
+	int err = archive_read_name(a, entry_name(*name, name.length()), 0,
+	                            UINT64_MAX, &buf, &size);
+	if (err == ENOENT) {
+		info.GetReturnValue().SetNull();
+		return;
+	}
+	if (err) {
+		throw_read_error(iso, err, *name);
+		return;
+	}
+	info.GetReturnValue().Set(take_buffer(iso, buf, size));
+}
+
+// ---- $.archiveLocate ----
+// Where an entry's data lies in the archive file, for streaming it with
+// FsFile.stream() (and a DecompressionStream, which takes compression.cc's
+// fused read + decompress path for a file source).
+struct archive_locate_t {
+	nx_archive_t *archive = nullptr; // a reference
+	std::string name;
+	const nx_archive_entry_t *entry = nullptr;
+	uint64_t offset = 0;
+	int err = 0;
+
+	~archive_locate_t() { archive_unref(archive); }
+};
+
+void archive_locate_do(nx_work_t *req) {
+	archive_locate_t *d = (archive_locate_t *)req->data;
+	auto it = d->archive->entries.find(d->name);
+	if (it == d->archive->entries.end()) {
+		d->err = ENOENT;
+		return;
+	}
+	if (!method_supported(&it->second)) {
+		d->err = ENOTSUP;
+		return;
+	}
+	d->entry = &it->second;
+	d->err = archive_locate(d->archive, &it->second, &d->offset);
+}
+
+MaybeLocal<Value> archive_locate_cb(Isolate *iso, nx_work_t *req) {
+	archive_locate_t *d = (archive_locate_t *)req->data;
+	if (d->err == ENOENT)
+		return Null(iso).As<Value>();
+	if (d->err) {
+		throw_read_error(iso, d->err, d->name.c_str());
+		return MaybeLocal<Value>();
+	}
+	const nx_archive_entry_t *e = d->entry;
+	const char *format = e->method == ZIP_DEFLATE ? "deflate-raw"
+	                     : e->method == ZIP_ZSTD  ? "zstd"
+	                                              : "";
+	Local<Context> ctx = iso->GetCurrentContext();
+	Local<Array> arr = Array::New(iso, 3);
+	arr->Set(ctx, 0, Number::New(iso, (double)d->offset)).Check();
+	arr->Set(ctx, 1,
+	         Number::New(iso, (double)(d->offset + e->compressed_size)))
+	    .Check();
+	arr->Set(ctx, 2, nx_str(iso, format)).Check();
+	return arr.As<Value>();
+}
+
+// $.archiveLocate(handle, name) -> Promise<[start, end, format] | null>,
+// where `format` is the DecompressionStream format ('' when stored).
+void nx_archive_locate(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	nx_archive_t *a = get_archive(info[0]);
+	String::Utf8Value name(iso, info[1]);
+	if (!a || !*name)
+		return;
+	NX_INIT_WORK_T_CPP(archive_locate_t);
+	data->archive = archive_ref(a);
+	data->name = entry_name(*name, name.length());
+	info.GetReturnValue().Set(
+	    nx_queue_async(iso, req, archive_locate_do, archive_locate_cb));
+}
+
+// ---- mounting ----
+// $.archiveMount(handle, name)
+//
+// Replaces the archive's previous mount, if any. The mount holds a reference,
+// so it stays usable after the archive object is collected.
+void nx_archive_mount(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	nx_archive_t *a = get_archive(info[0]);
+	String::Utf8Value name(iso, info[1]);
+	if (!a || !*name)
+		return;
+	size_t len = name.length();
+	if (!len || len > NX_MOUNT_NAME_MAX || strpbrk(*name, ":/")) {
+		char msg[128];
+		snprintf(msg, sizeof(msg),
+		         "Mount name must be 1 to %d characters, without ':' or '/'",
+		         NX_MOUNT_NAME_MAX);
+		iso->ThrowException(Exception::TypeError(nx_str(iso, msg)));
+		return;
+	}
+	// URL schemes are case-insensitive, and `new URL()` lowercases them, so
+	// mount names are too.
+	std::string mount(*name, len);
+	for (char &c : mount)
+		c = (char)tolower((unsigned char)c);
+	if (a->mount == mount)
+		return;
+	// Mounts are looked up before the file system, so a mount named after a
+	// scheme the runtime already serves would hide it entirely.
+	static const char *const reserved[] = {"sdmc", "romfs", "nxjs", "file"};
+	bool taken = fsdevGetDeviceFileSystem(mount.c_str()) != nullptr;
+	for (const char *r : reserved)
+		taken = taken || mount == r;
+	if (taken) {
+		char msg[128];
+		snprintf(msg, sizeof(msg), "Mount name '%s' is reserved",
+		         mount.c_str());
+		iso->ThrowException(Exception::TypeError(nx_str(iso, msg)));
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> guard(g_mounts_lock);
+		if (g_mounts.count(mount)) {
+			char msg[128];
+			snprintf(msg, sizeof(msg), "Mount name '%s' is already in use",
+			         mount.c_str());
+			iso->ThrowException(Exception::TypeError(nx_str(iso, msg)));
+			return;
+		}
+	}
+	archive_unmount(a);
+	{
+		std::lock_guard<std::mutex> guard(g_mounts_lock);
+		g_mounts[mount] = archive_ref(a);
+		g_mount_count.fetch_add(1, std::memory_order_relaxed);
+	}
+	a->mount = std::move(mount);
+}
+
+// $.archiveUnmount(handle)
+void nx_archive_unmount(const FunctionCallbackInfo<Value> &info) {
+	nx_archive_t *a = get_archive(info[0]);
+	if (a)
+		archive_unmount(a);
+}
+
+} // namespace
+
+bool nx_archive_read_path(const char *path, uint64_t start, uint64_t end,
+                          uint8_t **out, size_t *size, int *err) {
+	if (!g_mount_count.load(std::memory_order_relaxed))
+		return false;
+	const char *colon = strchr(path, ':');
+	if (!colon)
+		return false;
+	std::string mount(path, colon - path);
+	for (char &c : mount)
+		c = (char)tolower((unsigned char)c);
+	nx_archive_t *a;
+	{
+		std::lock_guard<std::mutex> guard(g_mounts_lock);
+		auto it = g_mounts.find(mount);
+		if (it == g_mounts.end())
+			return false;
+		a = archive_ref(it->second);
+	}
+	const char *name = colon + 1;
+	*err = archive_read_name(a, entry_name(name, strlen(name)), start, end,
+	                         out, size);
+	archive_unref(a);
+	return true;
+}
+
+void nx_init_archive(Isolate *iso, Local<Object> init_obj) {
+	NX_SET_FUNC(init_obj, "archiveOpen", nx_archive_open);
+	NX_SET_FUNC(init_obj, "archiveNames", nx_archive_names);
+	NX_SET_FUNC(init_obj, "archiveEntry", nx_archive_entry);
+	NX_SET_FUNC(init_obj, "archiveRead", nx_archive_read);
+	NX_SET_FUNC(init_obj, "archiveReadSync", nx_archive_read_sync);
+	NX_SET_FUNC(init_obj, "archiveLocate", nx_archive_locate);
+	NX_SET_FUNC(init_obj, "archiveMount", nx_archive_mount);
+	NX_SET_FUNC(init_obj, "archiveUnmount", nx_archive_unmount);
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include "types.h"
+#include <stdint.h>
+
+void nx_init_archive(v8::Isolate *iso, v8::Local<v8::Object> init_obj);
+
+// If `path` is in a mounted archive ("<mount>:/<entry>"), reads bytes
+// [start, end) of the entry (clamped to its size) into `*out`, a malloc'd
+// buffer with a NUL byte after them, and returns true with `*err` set to 0 or
+// an errno value (ENOENT when the archive has no such entry). Returns false,
+// touching nothing, for any other path. Any thread.
+bool nx_archive_read_path(const char *path, uint64_t start, uint64_t end,
+                          uint8_t **out, size_t *size, int *err);
@@ -0,0 +1,820 @@
+// Portable DSP building blocks for the Web Audio graph. See audio-dsp.h.
+#include "audio-dsp.h"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include <utility>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define NX_AUDIO_NEON 1
+#include <arm_neon.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#define NX_AUDIO_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+constexpr double PI = 3.14159265358979323846;
+
+// 4-lane float vectors for the FFT butterflies and the mixing kernels.
+// `v4m` is a per-lane mask, as produced by the comparisons.
+#if NX_AUDIO_NEON
+typedef float32x4_t v4;
+typedef uint32x4_t v4m;
+inline v4 v4_load(const float *p) { return vld1q_f32(p); }
+inline void v4_store(float *p, v4 v) { vst1q_f32(p, v); }
+inline v4 v4_dup(float f) { return vdupq_n_f32(f); }
+inline v4 v4_add(v4 a, v4 b) { return vaddq_f32(a, b); }
+inline v4 v4_sub(v4 a, v4 b) { return vsubq_f32(a, b); }
+inline v4 v4_mul(v4 a, v4 b) { return vmulq_f32(a, b); }
+inline v4 v4_min(v4 a, v4 b) { return vminq_f32(a, b); }
+inline v4 v4_max(v4 a, v4 b) { return vmaxq_f32(a, b); }
+inline v4m v4_le(v4 a, v4 b) { return vcleq_f32(a, b); }
+inline v4 v4_select(v4m m, v4 a, v4 b) { return vbslq_f32(m, a, b); }
+#elif NX_AUDIO_SSE
+typedef __m128 v4;
+typedef __m128 v4m;
+inline v4 v4_load(const float *p) { return _mm_loadu_ps(p); }
+inline void v4_store(float *p, v4 v) { _mm_storeu_ps(p, v); }
+inline v4 v4_dup(float f) { return _mm_set1_ps(f); }
+inline v4 v4_add(v4 a, v4 b) { return _mm_add_ps(a, b); }
+inline v4 v4_sub(v4 a, v4 b) { return _mm_sub_ps(a, b); }
+inline v4 v4_mul(v4 a, v4 b) { return _mm_mul_ps(a, b); }
+inline v4 v4_min(v4 a, v4 b) { return _mm_min_ps(a, b); }
+inline v4 v4_max(v4 a, v4 b) { return _mm_max_ps(a, b); }
+inline v4m v4_le(v4 a, v4 b) { return _mm_cmple_ps(a, b); }
+inline v4 v4_select(v4m m, v4 a, v4 b) {
+	return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+}
+#else
+struct v4 {
+	float v[4];
+};
+struct v4m {
+	bool v[4];
+};
+inline v4 v4_load(const float *p) { return {{p[0], p[1], p[2], p[3]}}; }
+inline void v4_store(float *p, v4 a) { memcpy(p, a.v, sizeof(a.v)); }
+inline v4 v4_dup(float f) { return {{f, f, f, f}}; }
+inline v4 v4_add(v4 a, v4 b) {
+	return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}};
+}
+inline v4 v4_sub(v4 a, v4 b) {
+	return {{a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]}};
+}
+inline v4 v4_mul(v4 a, v4 b) {
+	return {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}};
+}
+inline v4 v4_min(v4 a, v4 b) {
+	return {{std::min(a.v[0], b.v[0]), std::min(a.v[1], b.v[1]),
+	         std::min(a.v[2], b.v[2]), std::min(a.v[3], b.v[3])}};
+}
+inline v4 v4_max(v4 a, v4 b) {
+	return {{std::max(a.v[0], b.v[0]), std::max(a.v[1], b.v[1]),
+	         std::max(a.v[2], b.v[2]), std::max(a.v[3], b.v[3])}};
+}
+inline v4m v4_le(v4 a, v4 b) {
+	return {{a.v[0] <= b.v[0], a.v[1] <= b.v[1], a.v[2] <= b.v[2],
+	         a.v[3] <= b.v[3]}};
+}
+inline v4 v4_select(v4m m, v4 a, v4 b) {
+	return {{m.v[0] ? a.v[0] : b.v[0], m.v[1] ? a.v[1] : b.v[1],
+	         m.v[2] ? a.v[2] : b.v[2], m.v[3] ? a.v[3] : b.v[3]}};
+}
+#endif
+
+// Real and imaginary parts of (ar + i ai) * (br + i bi).
+inline v4 cmul_re(v4 ar, v4 ai, v4 br, v4 bi) {
+	return v4_sub(v4_mul(ar, br), v4_mul(ai, bi));
+}
+inline v4 cmul_im(v4 ar, v4 ai, v4 br, v4 bi) {
+	return v4_add(v4_mul(ar, bi), v4_mul(ai, br));
+}
+
+// sin(x) for x in [0, pi / 2]: the Taylor series through x^11, whose
+// truncation error (< 6e-8) is below float precision on that range.
+inline v4 v4_sin_quadrant(v4 x) {
+	v4 x2 = v4_mul(x, x);
+	v4 p = v4_dup(-1.f / 39916800);
+	p = v4_add(v4_mul(p, x2), v4_dup(1.f / 362880));
+	p = v4_add(v4_mul(p, x2), v4_dup(-1.f / 5040));
+	p = v4_add(v4_mul(p, x2), v4_dup(1.f / 120));
+	p = v4_add(v4_mul(p, x2), v4_dup(-1.f / 6));
+	p = v4_add(v4_mul(p, x2), v4_dup(1.f));
+	return v4_mul(p, x);
+}
+
+// Partials kept by wave table `range` (never above the table's Nyquist).
+uint32_t wave_partials(int range) {
+	double p = (NX_AUDIO_WAVE_SIZE / 2) *
+	           exp2(-(double)range / NX_AUDIO_WAVE_RANGES_PER_OCTAVE);
+	uint32_t n = (uint32_t)p;
+	return n >= NX_AUDIO_WAVE_SIZE / 2 ? NX_AUDIO_WAVE_SIZE / 2 - 1 : n;
+}
+
+nx_audio_biquad_coefs normalize(double b0, double b1, double b2, double a0,
+                                double a1, double a2) {
+	double s = 1.0 / a0;
+	return {b0 * s, b1 * s, b2 * s, a1 * s, a2 * s};
+}
+
+nx_audio_biquad_coefs constant(double gain) {
+	return {gain, 0, 0, 0, 0};
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// FFT
+// ---------------------------------------------------------------------------
+
+void nx_audio_fft_init(nx_audio_fft *fft, uint32_t size) {
+	fft->size = size;
+	fft->twiddle_re.assign(size, 0.f);
+	fft->twiddle_im.assign(size, 0.f);
+	for (uint32_t h = 1; h < size; h <<= 1) {
+		for (uint32_t j = 0; j < h; j++) {
+			double w = PI * j / h;
+			fft->twiddle_re[h + j] = (float)cos(w);
+			fft->twiddle_im[h + j] = (float)-sin(w);
+		}
+	}
+	uint32_t bits = 0;
+	while ((1u << bits) < size)
+		bits++;
+	fft->swaps.clear();
+	for (uint32_t i = 0; i < size; i++) {
+		uint32_t r = 0;
+		for (uint32_t b = 0; b < bits; b++)
+			r |= ((i >> b) & 1) << (bits - 1 - b);
+		if (r > i) {
+			fft->swaps.push_back(i);
+			fft->swaps.push_back(r);
+		}
+	}
+}
+
+void nx_audio_fft_run(const nx_audio_fft *fft, float *re, float *im,
+                      bool inverse) {
+	// The inverse transform is the forward one with re and im swapped.
+	if (inverse)
+		std::swap(re, im);
+	const uint32_t n = fft->size;
+	const uint32_t *swaps = fft->swaps.data();
+	for (size_t k = 0; k < fft->swaps.size(); k += 2) {
+		uint32_t i = swaps[k], j = swaps[k + 1];
+		std::swap(re[i], re[j]);
+		std::swap(im[i], im[j]);
+	}
+	if (n == 2) {
+		float r = re[1], m = im[1];
+		re[1] = re[0] - r;
+		im[1] = im[0] - m;
+		re[0] += r;
+		im[0] += m;
+		return;
+	}
+	// The first two stages (spans 2 and 4) have trivial twiddles (1, -i).
+	for (uint32_t i = 0; i < n; i += 4) {
+		float ar0 = re[i] + re[i + 1], ai0 = im[i] + im[i + 1];
+		float ar1 = re[i] - re[i + 1], ai1 = im[i] - im[i + 1];
+		float ar2 = re[i + 2] + re[i + 3], ai2 = im[i + 2] + im[i + 3];
+		float ar3 = re[i + 2] - re[i + 3], ai3 = im[i + 2] - im[i + 3];
+		re[i] = ar0 + ar2;
+		im[i] = ai0 + ai2;
+		re[i + 2] = ar0 - ar2;
+		im[i + 2] = ai0 - ai2;
+		// a3 * -i = (ai3, -ar3)
+		re[i + 1] = ar1 + ai3;
+		im[i + 1] = ai1 - ar3;
+		re[i + 3] = ar1 - ai3;
+		im[i + 3] = ai1 + ar3;
+	}
+	const float *twr = fft->twiddle_re.data();
+	const float *twi = fft->twiddle_im.data();
+	uint32_t h = 4;
+	// Radix-4 passes: stages h and 2h in one sweep over memory.
+	for (; h * 4 <= n; h *= 4) {
+		for (uint32_t i = 0; i < n; i += 4 * h) {
+			for (uint32_t j = 0; j < h; j += 4) {
+				float *r0 = re + i + j, *i0 = im + i + j;
+				float *r1 = r0 + h, *i1 = i0 + h;
+				float *r2 = r1 + h, *i2 = i1 + h;
+				float *r3 = r2 + h, *i3 = i2 + h;
+				v4 w1r = v4_load(twr + h + j), w1i = v4_load(twi + h + j);
+				v4 w2r = v4_load(twr + 2 * h + j);
+				v4 w2i = v4_load(twi + 2 * h + j);
+				v4 x0r = v4_load(r0), x0i = v4_load(i0);
+				v4 x1r = v4_load(r1), x1i = v4_load(i1);
+				v4 x2r = v4_load(r2), x2i = v4_load(i2);
+				v4 x3r = v4_load(r3), x3i = v4_load(i3);
+				// Span 2h: (x0, x1) and (x2, x3), both with w1.
+				v4 tr = cmul_re(x1r, x1i, w1r, w1i);
+				v4 ti = cmul_im(x1r, x1i, w1r, w1i);
+				v4 a0r = v4_add(x0r, tr), a0i = v4_add(x0i, ti);
+				v4 a1r = v4_sub(x0r, tr), a1i = v4_sub(x0i, ti);
+				tr = cmul_re(x3r, x3i, w1r, w1i);
+				ti = cmul_im(x3r, x3i, w1r, w1i);
+				v4 a2r = v4_add(x2r, tr), a2i = v4_add(x2i, ti);
+				v4 a3r = v4_sub(x2r, tr), a3i = v4_sub(x2i, ti);
+				// Span 4h: (a0, a2) with w2, and (a1, a3) with w2 * -i.
+				tr = cmul_re(a2r, a2i, w2r, w2i);
+				ti = cmul_im(a2r, a2i, w2r, w2i);
+				v4_store(r0, v4_add(a0r, tr));
+				v4_store(i0, v4_add(a0i, ti));
+				v4_store(r2, v4_sub(a0r, tr));
+				v4_store(i2, v4_sub(a0i, ti));
+				// (a3 * w2) * -i = (im, -re)
+				tr = cmul_im(a3r, a3i, w2r, w2i);
+				ti = cmul_re(a3r, a3i, w2r, w2i);
+				v4_store(r1, v4_add(a1r, tr));
+				v4_store(i1, v4_sub(a1i, ti));
+				v4_store(r3, v4_sub(a1r, tr));
+				v4_store(i3, v4_add(a1i, ti));
+			}
+		}
+	}
+	// Odd number of stages: one radix-2 pass (span n) is left.
+	if (h < n) {
+		for (uint32_t j = 0; j < h; j += 4) {
+			float *r0 = re + j, *i0 = im + j;
+			float *r1 = r0 + h, *i1 = i0 + h;
+			v4 wr = v4_load(twr + h + j), wi = v4_load(twi + h + j);
+			v4 x0r = v4_load(r0), x0i = v4_load(i0);
+			v4 x1r = v4_load(r1), x1i = v4_load(i1);
+			v4 tr = cmul_re(x1r, x1i, wr, wi);
+			v4 ti = cmul_im(x1r, x1i, wr, wi);
+			v4_store(r0, v4_add(x0r, tr));
+			v4_store(i0, v4_add(x0i, ti));
+			v4_store(r1, v4_sub(x0r, tr));
+			v4_store(i1, v4_sub(x0i, ti));
+		}
+	}
+}
+
+void nx_audio_rfft_init(nx_audio_rfft *fft, uint32_t size) {
+	fft->size = size;
+	nx_audio_fft_init(&fft->half, size / 2);
+	fft->twiddle_re.resize(size / 4 + 1);
+	fft->twiddle_im.resize(size / 4 + 1);
+	for (uint32_t k = 0; k <= size / 4; k++) {
+		double w = 2 * PI * k / size;
+		fft->twiddle_re[k] = (float)cos(w);
+		fft->twiddle_im[k] = (float)-sin(w);
+	}
+}
+
+// The size / 2 point FFT runs on z[n] = x[2n] + i x[2n + 1]; the spectrum of
+// x is then X[k] = Ze[k] + W^k Zo[k], where Ze[k] = (Z[k] + Z*[M - k]) / 2
+// and Zo[k] = -i (Z[k] - Z*[M - k]) / 2 are the spectra of the even and odd
+// samples. Bins k and M - k are computed together (Ze and Zo at M - k are
+// the conjugates of those at k), which lets this run in place.
+void nx_audio_rfft_forward(const nx_audio_rfft *fft, const float *in,
+                           float *re, float *im) {
+	const uint32_t m = fft->size / 2;
+	for (uint32_t i = 0; i < m; i++) {
+		re[i] = in[2 * i];
+		im[i] = in[2 * i + 1];
+	}
+	nx_audio_fft_run(&fft->half, re, im, false);
+	float r0 = re[0], i0 = im[0];
+	re[0] = r0 + i0;
+	im[0] = 0;
+	re[m] = r0 - i0;
+	im[m] = 0;
+	for (uint32_t k = 1; k <= m / 2; k++) {
+		uint32_t j = m - k;
+		float er = 0.5f * (re[k] + re[j]), ei = 0.5f * (im[k] - im[j]);
+		float or_ = 0.5f * (im[k] + im[j]), oi = 0.5f * (re[j] - re[k]);
+		float wr = fft->twiddle_re[k], wi = fft->twiddle_im[k];
+		float tr = or_ * wr - oi * wi, ti = or_ * wi + oi * wr;
+		re[k] = er + tr;
+		im[k] = ei + ti;
+		// W^(M - k) = -conj(W^k), applied to conj(Zo).
+		re[j] = er - tr;
+		im[j] = ti - ei;
+	}
+}
+
+void nx_audio_rfft_inverse(const nx_audio_rfft *fft, float *re, float *im,
+                           float *out) {
+	const uint32_t m = fft->size / 2;
+	float x0 = re[0], xm = re[m];
+	re[0] = 0.5f * (x0 + xm);
+	im[0] = 0.5f * (x0 - xm);
+	for (uint32_t k = 1; k <= m / 2; k++) {
+		uint32_t j = m - k;
+		// Ze = (X[k] + X*[j]) / 2, Zo = (X[k] - X*[j]) conj(W^k) / 2, and
+		// Z[k] = Ze + i Zo; at j, Ze and Zo are conjugated.
+		float er = 0.5f * (re[k] + re[j]), ei = 0.5f * (im[k] - im[j]);
+		float dr = 0.5f * (re[k] - re[j]), di = 0.5f * (im[k] + im[j]);
+		float wr = fft->twiddle_re[k], wi = -fft->twiddle_im[k];
+		float or_ = dr * wr - di * wi, oi = dr * wi + di * wr;
+		re[k] = er - oi;
+		im[k] = ei + or_;
+		re[j] = er + oi;
+		im[j] = or_ - ei;
+	}
+	nx_audio_fft_run(&fft->half, re, im, true);
+	const float scale = 1.f / m;
+	for (uint32_t i = 0; i < m; i++) {
+		out[2 * i] = re[i] * scale;
+		out[2 * i + 1] = im[i] * scale;
+	}
+}
+
+void nx_audio_complex_mac(float *acc_re, float *acc_im, const float *a_re,
+                          const float *a_im, const float *b_re,
+                          const float *b_im, uint32_t n) {
+	uint32_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		v4 ar = v4_load(a_re + i), ai = v4_load(a_im + i);
+		v4 br = v4_load(b_re + i), bi = v4_load(b_im + i);
+		v4_store(acc_re + i, v4_add(v4_load(acc_re + i), cmul_re(ar, ai, br, bi)));
+		v4_store(acc_im + i, v4_add(v4_load(acc_im + i), cmul_im(ar, ai, br, bi)));
+	}
+	for (; i < n; i++) {
+		acc_re[i] += a_re[i] * b_re[i] - a_im[i] * b_im[i];
+		acc_im[i] += a_re[i] * b_im[i] + a_im[i] * b_re[i];
+	}
+}
+
+void nx_audio_mul(float *dst, const float *a, const float *b, uint32_t n) {
+	uint32_t i = 0;
+	for (; i + 4 <= n; i += 4)
+		v4_store(dst + i, v4_mul(v4_load(a + i), v4_load(b + i)));
+	for (; i < n; i++)
+		dst[i] = a[i] * b[i];
+}
+
+void nx_audio_add(float *dst, const float *src, uint32_t n) {
+	uint32_t i = 0;
+	for (; i + 4 <= n; i += 4)
+		v4_store(dst + i, v4_add(v4_load(dst + i), v4_load(src + i)));
+	for (; i < n; i++)
+		dst[i] += src[i];
+}
+
+void nx_audio_downmix(float *dst, const float *l, const float *r, uint32_t n) {
+	const v4 half = v4_dup(0.5f);
+	uint32_t i = 0;
+	for (; i + 4 <= n; i += 4)
+		v4_store(dst + i, v4_mul(half, v4_add(v4_load(l + i), v4_load(r + i))));
+	for (; i < n; i++)
+		dst[i] = 0.5f * (l[i] + r[i]);
+}
+
+namespace {
+
+// Equal-power panning of 4 frames. For a mono input, `in_r` is `in_l` and
+// x = (pan + 1) / 2; for a stereo input, x = pan + 1 (pan <= 0) or pan, and
+// the attenuated channel is folded into the other one.
+inline void pan4(float *l, float *r, const float *in_l, const float *in_r,
+                 const float *pan, bool mono) {
+	const v4 one = v4_dup(1.f), zero = v4_dup(0.f);
+	const v4 half_pi = v4_dup((float)(PI / 2));
+	v4 p = v4_min(v4_max(v4_load(pan), v4_dup(-1.f)), one);
+	v4 il = v4_load(in_l), ir = v4_load(in_r);
+	v4m left = v4_le(p, zero);
+	v4 x = mono ? v4_mul(v4_add(p, one), v4_dup(0.5f))
+	            : v4_select(left, v4_add(p, one), p);
+	// cos(x pi / 2) = sin((1 - x) pi / 2)
+	v4 gl = v4_sin_quadrant(v4_mul(v4_sub(one, x), half_pi));
+	v4 gr = v4_sin_quadrant(v4_mul(x, half_pi));
+	if (mono) {
+		v4_store(l, v4_mul(il, gl));
+		v4_store(r, v4_mul(il, gr));
+		return;
+	}
+	v4_store(l, v4_select(left, v4_add(il, v4_mul(ir, gl)), v4_mul(il, gl)));
+	v4_store(r, v4_select(left, v4_mul(ir, gr), v4_add(ir, v4_mul(il, gr))));
+}
+
+void pan(float *l, float *r, const float *in_l, const float *in_r,
+         const float *pan, uint32_t n, bool mono) {
+	uint32_t i = 0;
+	for (; i + 4 <= n; i += 4)
+		pan4(l + i, r + i, in_l + i, in_r + i, pan + i, mono);
+	if (i == n)
+		return;
+	// Tail: pad to a full vector, so it gets the exact same gains.
+	float t_in_l[4] = {}, t_in_r[4] = {}, t_pan[4] = {}, t_l[4], t_r[4];
+	memcpy(t_in_l, in_l + i, sizeof(float) * (n - i));
+	memcpy(t_in_r, in_r + i, sizeof(float) * (n - i));
+	memcpy(t_pan, pan + i, sizeof(float) * (n - i));
+	pan4(t_l, t_r, t_in_l, t_in_r, t_pan, mono);
+	memcpy(l + i, t_l, sizeof(float) * (n - i));
+	memcpy(r + i, t_r, sizeof(float) * (n - i));
+}
+
+} // namespace
+
+void nx_audio_pan_mono(float *l, float *r, const float *in, const float *pan_,
+                       uint32_t n) {
+	pan(l, r, in, in, pan_, n, true);
+}
+
+void nx_audio_pan_stereo(float *l, float *r, const float *in_l,
+                         const float *in_r, const float *pan_, uint32_t n) {
+	pan(l, r, in_l, in_r, pan_, n, false);
+}
+
+void nx_audio_interpolate(float *dst, const float *src, const uint32_t *i0,
+                          const uint32_t *i1, const float *frac, uint32_t n) {
+	uint32_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		// No gather on NEON / SSE: the loads stay scalar, the math does not.
+		float a[4] = {src[i0[i]], src[i0[i + 1]], src[i0[i + 2]],
+		              src[i0[i + 3]]};
+		float b[4] = {src[i1[i]], src[i1[i + 1]], src[i1[i + 2]],
+		              src[i1[i + 3]]};
+		v4 va = v4_load(a);
+		v4 d = v4_sub(v4_load(b), va);
+		v4_store(dst + i, v4_add(va, v4_mul(d, v4_load(frac + i))));
+	}
+	for (; i < n; i++) {
+		float a = src[i0[i]];
+		dst[i] = a + (src[i1[i]] - a) * frac[i];
+	}
+}
+
+void nx_audio_interpolate_s16(float *dst, const int16_t *src,
+                              const uint32_t *i0, const uint32_t *i1,
+                              const float *frac, uint32_t n) {
+	// Scaling by a power of two is exact, so this matches
+	// nx_audio_interpolate() on the same samples converted to float first.
+	constexpr float S = 1.f / 32768;
+	const v4 scale = v4_dup(S);
+	uint32_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		float a[4], b[4];
+		for (int k = 0; k < 4; k++) {
+			a[k] = src[i0[i + k]];
+			b[k] = src[i1[i + k]];
+		}
+		v4 va = v4_mul(v4_load(a), scale);
+		v4 d = v4_sub(v4_mul(v4_load(b), scale), va);
+		v4_store(dst + i, v4_add(va, v4_mul(d, v4_load(frac + i))));
+	}
+	for (; i < n; i++) {
+		float a = src[i0[i]] * S;
+		dst[i] = a + (src[i1[i]] * S - a) * frac[i];
+	}
+}
+
+void nx_audio_to_s16(int16_t *out, const float *l, const float *r,
+                     uint32_t n) {
+	uint32_t i = 0;
+#if NX_AUDIO_NEON && defined(__aarch64__)
+	const float32x4_t lo = vdupq_n_f32(-1.f), hi = vdupq_n_f32(1.f);
+	const float32x4_t scale = vdupq_n_f32(32767.f);
+	for (; i + 4 <= n; i += 4) {
+		float32x4_t fl = vmulq_f32(vminq_f32(vmaxq_f32(vld1q_f32(l + i), lo), hi),
+		                           scale);
+		float32x4_t fr = vmulq_f32(vminq_f32(vmaxq_f32(vld1q_f32(r + i), lo), hi),
+		                           scale);
+		int16x4x2_t lr = {{vqmovn_s32(vcvtnq_s32_f32(fl)),
+		                   vqmovn_s32(vcvtnq_s32_f32(fr))}};
+		vst2_s16(out + i * 2, lr);
+	}
+#elif NX_AUDIO_SSE
+	const __m128 lo = _mm_set1_ps(-1.f), hi = _mm_set1_ps(1.f);
+	const __m128 scale = _mm_set1_ps(32767.f);
+	for (; i + 4 <= n; i += 4) {
+		__m128 fl = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(l + i), lo), hi),
+		                       scale);
+		__m128 fr = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(r + i), lo), hi),
+		                       scale);
+		// Round to nearest (the default MXCSR mode, like lrintf()).
+		__m128i il = _mm_cvtps_epi32(fl), ir = _mm_cvtps_epi32(fr);
+		__m128i lr = _mm_packs_epi32(_mm_unpacklo_epi32(il, ir),
+		                             _mm_unpackhi_epi32(il, ir));
+		_mm_storeu_si128((__m128i *)(out + i * 2), lr);
+	}
+#endif
+	for (; i < n; i++) {
+		float fl = std::min(std::max(l[i], -1.f), 1.f);
+		float fr = std::min(std::max(r[i], -1.f), 1.f);
+		out[i * 2] = (int16_t)lrintf(fl * 32767.f);
+		out[i * 2 + 1] = (int16_t)lrintf(fr * 32767.f);
+	}
+}
+
+// ---------------------------------------------------------------------------
+// PeriodicWave
+// ---------------------------------------------------------------------------
+
+std::shared_ptr<const nx_audio_periodic_wave>
+nx_audio_periodic_wave_create(const float *real, const float *imag, size_t len,
+                              bool disable_normalization) {
+	constexpr uint32_t N = NX_AUDIO_WAVE_SIZE;
+	auto wave = std::make_shared<nx_audio_periodic_wave>();
+	wave->tables.resize((size_t)NX_AUDIO_WAVE_RANGES * (N + 1));
+	nx_audio_fft fft;
+	nx_audio_fft_init(&fft, N);
+	std::vector<float> re(N), im(N);
+	uint32_t prev_partials = UINT32_MAX;
+	for (int r = 0; r < NX_AUDIO_WAVE_RANGES; r++) {
+		float *table = wave->tables.data() + (size_t)r * (N + 1);
+		uint32_t partials = wave_partials(r);
+		if (len > 0 && partials > len - 1)
+			partials = (uint32_t)(len - 1);
+		if (partials == prev_partials) {
+			// Nothing above `partials` to drop: same table as the last.
+			memcpy(table, table - (N + 1), sizeof(float) * (N + 1));
+			continue;
+		}
+		prev_partials = partials;
+		std::fill(re.begin(), re.end(), 0.f);
+		std::fill(im.begin(), im.end(), 0.f);
+		// x[n] = Re(sum X[k] e^(2 pi i k n / N)) with X[k] = a_k - i b_k
+		//      = sum a_k cos + b_k sin.
+		for (uint32_t k = 1; k <= partials; k++) {
+			re[k] = real[k];
+			im[k] = -imag[k];
+		}
+		nx_audio_fft_run(&fft, re.data(), im.data(), true);
+		memcpy(table, re.data(), sizeof(float) * N);
+		table[N] = table[0];
+	}
+	if (!disable_normalization) {
+		const float *full = wave->tables.data();
+		float peak = 0;
+		for (uint32_t i = 0; i < N; i++)
+			peak = fmaxf(peak, fabsf(full[i]));
+		if (peak > 0) {
+			float scale = 1.f / peak;
+			for (float &v : wave->tables)
+				v *= scale;
+		}
+	}
+	return wave;
+}
+
+std::shared_ptr<const nx_audio_periodic_wave>
+nx_audio_periodic_wave_basic(nx_audio_oscillator_type type) {
+	static std::shared_ptr<const nx_audio_periodic_wave> cache[4];
+	if (type < NX_AUDIO_OSCILLATOR_SINE || type > NX_AUDIO_OSCILLATOR_TRIANGLE)
+		return nullptr;
+	auto &wave = cache[type];
+	if (wave)
+		return wave;
+	// Fourier coefficients from the Web Audio spec's waveform definitions.
+	constexpr uint32_t H = NX_AUDIO_WAVE_SIZE / 2;
+	std::vector<float> real(H, 0.f), imag(H, 0.f);
+	for (uint32_t k = 1; k < H; k++) {
+		double pi_k = PI * k;
+		switch (type) {
+		case NX_AUDIO_OSCILLATOR_SINE:
+			imag[k] = k == 1 ? 1.f : 0.f;
+			break;
+		case NX_AUDIO_OSCILLATOR_SQUARE:
+			imag[k] = k & 1 ? (float)(4 / pi_k) : 0.f;
+			break;
+		case NX_AUDIO_OSCILLATOR_SAWTOOTH:
+			imag[k] = (float)((k & 1 ? 2 : -2) / pi_k);
+			break;
+		case NX_AUDIO_OSCILLATOR_TRIANGLE:
+			if (k & 1)
+				imag[k] = (float)((k & 2 ? -8 : 8) / (pi_k * pi_k));
+			break;
+		default:
+			break;
+		}
+	}
+	wave = nx_audio_periodic_wave_create(real.data(), imag.data(), H, false);
+	return wave;
+}
+
+// ---------------------------------------------------------------------------
+// Biquad design
+// ---------------------------------------------------------------------------
+
+nx_audio_biquad_coefs nx_audio_biquad_design(nx_audio_biquad_type type,
+                                             double freq, double q,
+                                             double gain_db) {
+	if (!(freq > 0))
+		freq = 0; // also catches NaN
+	if (freq > 1)
+		freq = 1;
+	double A = pow(10.0, gain_db / 40);
+	double w0 = PI * freq;
+	double k = cos(w0);
+	bool inside = freq > 0 && freq < 1;
+	switch (type) {
+	case NX_AUDIO_BIQUAD_LOWPASS:
+	case NX_AUDIO_BIQUAD_HIGHPASS: {
+		bool low = type == NX_AUDIO_BIQUAD_LOWPASS;
+		if (freq == 1)
+			return constant(low ? 1 : 0);
+		if (freq == 0)
+			return constant(low ? 0 : 1);
+		// Q is a resonance in dB for these two.
+		double alpha = sin(w0) / (2 * pow(10.0, q / 20));
+		double beta = low ? (1 - k) / 2 : (1 + k) / 2;
+		return normalize(beta, low ? 2 * beta : -2 * beta, beta, 1 + alpha,
+		                 -2 * k, 1 - alpha);
+	}
+	case NX_AUDIO_BIQUAD_BANDPASS: {
+		if (!inside)
+			return constant(0);
+		if (q <= 0)
+			return constant(1);
+		double alpha = sin(w0) / (2 * q);
+		return normalize(alpha, 0, -alpha, 1 + alpha, -2 * k, 1 - alpha);
+	}
+	case NX_AUDIO_BIQUAD_LOWSHELF:
+	case NX_AUDIO_BIQUAD_HIGHSHELF: {
+		bool low = type == NX_AUDIO_BIQUAD_LOWSHELF;
+		if (freq == 1)
+			return constant(low ? A * A : 1);
+		if (freq == 0)
+			return constant(low ? 1 : A * A);
+		// Shelf slope S = 1.
+		double alpha = 0.5 * sin(w0) * sqrt(2);
+		double k2 = 2 * sqrt(A) * alpha;
+		double ap = A + 1, am = A - 1;
+		if (low)
+			return normalize(A * (ap - am * k + k2), 2 * A * (am - ap * k),
+			                 A * (ap - am * k - k2), ap + am * k + k2,
+			                 -2 * (am + ap * k), ap + am * k - k2);
+		return normalize(A * (ap + am * k + k2), -2 * A * (am + ap * k),
+		                 A * (ap + am * k - k2), ap - am * k + k2,
+		                 2 * (am - ap * k), ap - am * k - k2);
+	}
+	case NX_AUDIO_BIQUAD_PEAKING: {
+		if (!inside)
+			return constant(1);
+		if (q <= 0)
+			return constant(A * A);
+		double alpha = sin(w0) / (2 * q);
+		return normalize(1 + alpha * A, -2 * k, 1 - alpha * A, 1 + alpha / A,
+		                 -2 * k, 1 - alpha / A);
+	}
+	case NX_AUDIO_BIQUAD_NOTCH: {
+		if (!inside)
+			return constant(1);
+		if (q <= 0)
+			return constant(0);
+		double alpha = sin(w0) / (2 * q);
+		return normalize(1, -2 * k, 1, 1 + alpha, -2 * k, 1 - alpha);
+	}
+	case NX_AUDIO_BIQUAD_ALLPASS: {
+		if (!inside)
+			return constant(1);
+		if (q <= 0)
+			return constant(-1);
+		double alpha = sin(w0) / (2 * q);
+		return normalize(1 - alpha, -2 * k, 1 + alpha, 1 + alpha, -2 * k,
+		                 1 - alpha);
+	}
+	}
+	return constant(1);
+}
+
+void nx_audio_biquad_response(const nx_audio_biquad_coefs &c, double freq,
+                              float *mag, float *phase) {
+	if (!(freq >= 0 && freq <= 1)) {
+		*mag = NAN;
+		*phase = NAN;
+		return;
+	}
+	// H(z) at z = e^(i w): z^-1 = cos w - i sin w.
+	double w = PI * freq;
+	double c1 = cos(w), s1 = -sin(w);
+	double c2 = cos(2 * w), s2 = -sin(2 * w);
+	double nr = c.b0 + c.b1 * c1 + c.b2 * c2;
+	double ni = c.b1 * s1 + c.b2 * s2;
+	double dr = 1 + c.a1 * c1 + c.a2 * c2;
+	double di = c.a1 * s1 + c.a2 * s2;
+	double den = dr * dr + di * di;
+	double hr = (nr * dr + ni * di) / den;
+	double hi = (ni * dr - nr * di) / den;
+	*mag = (float)sqrt(hr * hr + hi * hi);
+	*phase = (float)atan2(hi, hr);
+}
+
+// ---------------------------------------------------------------------------
+// Convolver
+// ---------------------------------------------------------------------------
+
+float nx_audio_convolver_normalization(const float *const *ir,
+                                       int num_channels, uint32_t length,
+                                       double sample_rate) {
+	constexpr double GAIN_CALIBRATION = 0.00125;
+	constexpr double GAIN_CALIBRATION_SAMPLE_RATE = 44100;
+	constexpr double MIN_POWER = 0.000125;
+	double power = 0;
+	for (int c = 0; c < num_channels; c++)
+		for (uint32_t i = 0; i < length; i++)
+			power += (double)ir[c][i] * ir[c][i];
+	power = sqrt(power / ((double)num_channels * length));
+	if (!(power >= MIN_POWER) || !isfinite(power))
+		power = MIN_POWER;
+	double scale = GAIN_CALIBRATION / power;
+	if (sample_rate > 0)
+		scale *= GAIN_CALIBRATION_SAMPLE_RATE / sample_rate;
+	if (num_channels == 4)
+		scale *= 0.5;
+	return (float)scale;
+}
+
+std::unique_ptr<nx_audio_convolver>
+nx_audio_convolver_create(const float *const *ir, int num_channels,
+                          uint32_t length, float scale) {
+	constexpr uint32_t B = NX_AUDIO_CONVOLVER_BLOCK;
+	constexpr uint32_t S = NX_AUDIO_CONVOLVER_STRIDE;
+	auto c = std::make_unique<nx_audio_convolver>();
+	nx_audio_rfft_init(&c->fft, 2 * B);
+	c->ir_channels = num_channels;
+	c->partitions = std::max<uint32_t>(1, (length + B - 1) / B);
+	const size_t spectra = (size_t)c->partitions * S;
+	c->ir_re.assign(spectra * num_channels, 0.f);
+	c->ir_im.assign(spectra * num_channels, 0.f);
+	c->fdl_re.assign(spectra * 2, 0.f);
+	c->fdl_im.assign(spectra * 2, 0.f);
+	for (int ch = 0; ch < num_channels; ch++) {
+		for (uint32_t p = 0; p < c->partitions; p++) {
+			uint32_t start = p * B;
+			uint32_t n = std::min(B, length - std::min(start, length));
+			memset(c->block, 0, sizeof(c->block));
+			for (uint32_t i = 0; i < n; i++)
+				c->block[i] = ir[ch][start + i] * scale;
+			size_t off = (size_t)ch * spectra + (size_t)p * S;
+			nx_audio_rfft_forward(&c->fft, c->block, &c->ir_re[off],
+			                      &c->ir_im[off]);
+		}
+	}
+	return c;
+}
+
+int nx_audio_convolver_process(nx_audio_convolver *c, const float *const *in,
+                               int in_channels, float *const *out) {
+	constexpr uint32_t B = NX_AUDIO_CONVOLVER_BLOCK;
+	constexpr uint32_t S = NX_AUDIO_CONVOLVER_STRIDE;
+	const uint32_t P = c->partitions;
+	const size_t spectra = (size_t)P * S;
+	const uint32_t pos = c->fdl_pos;
+
+	// Transform the new block(s) into the delay line. A mono input stands
+	// for L == R, so its spectrum is shared rather than recomputed.
+	for (int ch = 0; ch < 2; ch++) {
+		float *re = &c->fdl_re[ch * spectra + (size_t)pos * S];
+		float *im = &c->fdl_im[ch * spectra + (size_t)pos * S];
+		if (ch < in_channels) {
+			memcpy(c->block, in[ch], sizeof(float) * B);
+			memset(c->block + B, 0, sizeof(float) * B);
+			nx_audio_rfft_forward(&c->fft, c->block, re, im);
+		} else {
+			memcpy(re, &c->fdl_re[(size_t)pos * S], sizeof(float) * S);
+			memcpy(im, &c->fdl_im[(size_t)pos * S], sizeof(float) * S);
+		}
+	}
+
+	// (output, input, impulse response channel) terms.
+	struct term {
+		int out, in, ir;
+	};
+	static const term MONO[] = {{0, 0, 0}, {1, 1, 0}};
+	static const term STEREO[] = {{0, 0, 0}, {1, 1, 1}};
+	static const term TRUE_STEREO[] = {{0, 0, 0}, {0, 1, 2}, {1, 0, 1},
+	                                   {1, 1, 3}};
+	const term *terms = c->ir_channels == 4   ? TRUE_STEREO
+	                    : c->ir_channels == 2 ? STEREO
+	                                          : MONO;
+	const int num_terms = c->ir_channels == 4 ? 4 : 2;
+	// Mono through mono: the right channel would be an exact copy.
+	const int out_channels = c->ir_channels == 1 && in_channels == 1 ? 1 : 2;
+
+	for (int o = 0; o < out_channels; o++) {
+		memset(c->acc_re, 0, sizeof(c->acc_re));
+		memset(c->acc_im, 0, sizeof(c->acc_im));
+		for (int t = 0; t < num_terms; t++) {
+			if (terms[t].out != o)
+				continue;
+			const float *fr = &c->fdl_re[terms[t].in * spectra];
+			const float *fi = &c->fdl_im[terms[t].in * spectra];
+			const float *hr = &c->ir_re[terms[t].ir * spectra];
+			const float *hi = &c->ir_im[terms[t].ir * spectra];
+			// Partition p meets the input block from p blocks ago.
+			for (uint32_t p = 0; p < P; p++) {
+				uint32_t slot = pos >= p ? pos - p : pos + P - p;
+				nx_audio_complex_mac(c->acc_re, c->acc_im, fr + (size_t)slot * S,
+				                     fi + (size_t)slot * S, hr + (size_t)p * S,
+				                     hi + (size_t)p * S, S);
+			}
+		}
+		nx_audio_rfft_inverse(&c->fft, c->acc_re, c->acc_im, c->block);
+		for (uint32_t i = 0; i < B; i++) {
+			out[o][i] = c->block[i] + c->tail[o][i];
+			c->tail[o][i] = c->block[B + i];
+		}
+	}
+	if (out_channels == 1) {
+		memcpy(out[1], out[0], sizeof(float) * B);
+		memcpy(c->tail[1], c->tail[0], sizeof(c->tail[0]));
+	}
+	c->fdl_pos = pos + 1 == P ? 0 : pos + 1;
+	return out_channels;
+}
@@ -0,0 +1,210 @@
+#pragma once
+// Portable DSP building blocks for the Web Audio graph — pure C++ (std only).
+//
+// Like audio-graph.cc, this is compiled into BOTH the device runtime and the
+// host nxjs-test binary. Everything here is either pure math (biquad design,
+// FFT) or immutable once built (PeriodicWave tables), so it is safe to share
+// between the control and render threads. The one exception is the
+// convolution engine, which is built on the control thread and then owned by
+// the render thread (see nx_audio_convolver).
+
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// ---- FFT ----
+// Complex FFT on split (re, im) arrays, with precomputed twiddles. Stages are
+// fused in pairs into radix-4 (radix-2 x 2) passes, with one radix-2 pass
+// left over for odd powers of two; the butterflies run 4 lanes at a time on
+// NEON (device) or SSE (host), with a scalar fallback elsewhere.
+// `size` must be a power of two (>= 2).
+struct nx_audio_fft {
+	uint32_t size = 0;
+	// Twiddles for the stage of half-size h (butterfly span 2h) are
+	// e^(-i pi j / h), j in [0, h), stored at [h + j].
+	std::vector<float> twiddle_re;
+	std::vector<float> twiddle_im;
+	// Bit-reversal permutation, as (i, j) pairs with i < j.
+	std::vector<uint32_t> swaps;
+};
+
+void nx_audio_fft_init(nx_audio_fft *fft, uint32_t size);
+// In-place transform of (re, im). `inverse` computes the UNNORMALIZED
+// inverse (the caller scales by 1 / size if needed).
+void nx_audio_fft_run(const nx_audio_fft *fft, float *re, float *im,
+                      bool inverse);
+
+// Real-input FFT of `size` points (a power of two >= 4), computed with one
+// complex FFT of size / 2. Spectra are the size / 2 + 1 non-negative
+// frequency bins, on split (re, im) arrays.
+struct nx_audio_rfft {
+	uint32_t size = 0;
+	nx_audio_fft half;
+	// e^(-2 pi i k / size), k in [0, size / 4]
+	std::vector<float> twiddle_re;
+	std::vector<float> twiddle_im;
+};
+
+void nx_audio_rfft_init(nx_audio_rfft *fft, uint32_t size);
+// `re` and `im` must hold size / 2 + 1 values each.
+void nx_audio_rfft_forward(const nx_audio_rfft *fft, const float *in,
+                           float *re, float *im);
+// NORMALIZED inverse (round-trips with nx_audio_rfft_forward()). Clobbers
+// `re` and `im`.
+void nx_audio_rfft_inverse(const nx_audio_rfft *fft, float *re, float *im,
+                           float *out);
+
+// ---- Vector kernels (NEON / SSE2, with a scalar fallback) ----
+// The instruction set is chosen at compile time: NEON is part of the
+// Switch's AArch64 baseline, and SSE2 of x86-64's (the host test build).
+// Render-thread safe: no allocation, no state.
+// acc += a * b, on `n` complex values in split form.
+void nx_audio_complex_mac(float *acc_re, float *acc_im, const float *a_re,
+                          const float *a_im, const float *b_re,
+                          const float *b_im, uint32_t n);
+// dst = a * b, element-wise (`dst` may alias `a` or `b`).
+void nx_audio_mul(float *dst, const float *a, const float *b, uint32_t n);
+// dst += src.
+void nx_audio_add(float *dst, const float *src, uint32_t n);
+// dst = (l + r) / 2 (the "speakers" stereo to mono downmix).
+void nx_audio_downmix(float *dst, const float *l, const float *r, uint32_t n);
+// StereoPannerNode's equal-power panning, with a per-frame `pan` in [-1, 1],
+// of a mono or a stereo input into (l, r). The outputs must not alias the
+// inputs. The gains come from a polynomial sine that is accurate to float
+// precision, rather than from libm.
+void nx_audio_pan_mono(float *l, float *r, const float *in, const float *pan,
+                       uint32_t n);
+void nx_audio_pan_stereo(float *l, float *r, const float *in_l,
+                         const float *in_r, const float *pan, uint32_t n);
+// Linear interpolation between src[i0[k]] and src[i1[k]] by frac[k].
+void nx_audio_interpolate(float *dst, const float *src, const uint32_t *i0,
+                          const uint32_t *i1, const float *frac, uint32_t n);
+// The same, from signed 16-bit samples (scaled by 1 / 32768).
+void nx_audio_interpolate_s16(float *dst, const int16_t *src,
+                              const uint32_t *i0, const uint32_t *i1,
+                              const float *frac, uint32_t n);
+// Interleaves (l, r) into signed 16-bit PCM, clamped to [-1, 1] and rounded
+// to nearest.
+void nx_audio_to_s16(int16_t *out, const float *l, const float *r,
+                     uint32_t n);
+
+// ---- PeriodicWave ----
+// OscillatorNode types (matches the JS side's wire protocol).
+enum nx_audio_oscillator_type {
+	NX_AUDIO_OSCILLATOR_SINE = 0,
+	NX_AUDIO_OSCILLATOR_SQUARE = 1,
+	NX_AUDIO_OSCILLATOR_SAWTOOTH = 2,
+	NX_AUDIO_OSCILLATOR_TRIANGLE = 3,
+	NX_AUDIO_OSCILLATOR_CUSTOM = 4,
+};
+
+// One cycle per table. Table `r` keeps the first
+// floor(1024 * 2^(-r / 2)) partials, so there are two tables per octave of
+// fundamental frequency; the oscillator picks (and crossfades between) the
+// tables whose highest partial stays below Nyquist, which makes every
+// waveform band-limited. The tables do not depend on the sample rate.
+#define NX_AUDIO_WAVE_SIZE 2048
+#define NX_AUDIO_WAVE_RANGES_PER_OCTAVE 2
+#define NX_AUDIO_WAVE_RANGES 21
+
+struct nx_audio_periodic_wave {
+	// NX_AUDIO_WAVE_RANGES tables of NX_AUDIO_WAVE_SIZE + 1 samples (the last
+	// sample repeats the first, so interpolation never wraps).
+	std::vector<float> tables;
+	const float *table(int range) const {
+		return tables.data() + (size_t)range * (NX_AUDIO_WAVE_SIZE + 1);
+	}
+};
+
+// Builds the tables for the Fourier series sum(real[k] cos + imag[k] sin),
+// k in [1, len). Unless `disable_normalization` is set, the result is scaled
+// so that the full-bandwidth waveform peaks at 1. Called on the control
+// thread (allocates; a few small FFTs).
+std::shared_ptr<const nx_audio_periodic_wave>
+nx_audio_periodic_wave_create(const float *real, const float *imag, size_t len,
+                              bool disable_normalization);
+
+// The shared (lazily built, never freed) wave for a basic oscillator type.
+// Control thread only. Returns NULL for NX_AUDIO_OSCILLATOR_CUSTOM.
+std::shared_ptr<const nx_audio_periodic_wave>
+nx_audio_periodic_wave_basic(nx_audio_oscillator_type type);
+
+// ---- BiquadFilterNode ----
+// Filter types (matches the JS side's wire protocol).
+enum nx_audio_biquad_type {
+	NX_AUDIO_BIQUAD_LOWPASS = 0,
+	NX_AUDIO_BIQUAD_HIGHPASS = 1,
+	NX_AUDIO_BIQUAD_BANDPASS = 2,
+	NX_AUDIO_BIQUAD_LOWSHELF = 3,
+	NX_AUDIO_BIQUAD_HIGHSHELF = 4,
+	NX_AUDIO_BIQUAD_PEAKING = 5,
+	NX_AUDIO_BIQUAD_NOTCH = 6,
+	NX_AUDIO_BIQUAD_ALLPASS = 7,
+};
+
+// Normalized (a0 = 1) coefficients: y = b0 x + b1 x1 + b2 x2 - a1 y1 - a2 y2.
+struct nx_audio_biquad_coefs {
+	double b0, b1, b2, a1, a2;
+};
+
+// Designs the filter per the Web Audio spec's formulas (the Audio EQ
+// Cookbook), with the spec's limits at 0 Hz and Nyquist. `freq` is the
+// computed frequency normalized to Nyquist (clamped to [0, 1]).
+nx_audio_biquad_coefs nx_audio_biquad_design(nx_audio_biquad_type type,
+                                             double freq, double q,
+                                             double gain_db);
+
+// Magnitude and phase response at `freq` (normalized to Nyquist). Both are
+// NaN outside [0, 1], as getFrequencyResponse() requires.
+void nx_audio_biquad_response(const nx_audio_biquad_coefs &c, double freq,
+                              float *mag, float *phase);
+
+// ---- ConvolverNode ----
+// Uniformly partitioned FFT convolution (overlap-add). The impulse response
+// is cut into blocks of NX_AUDIO_CONVOLVER_BLOCK frames whose spectra are
+// computed once; each processed block is transformed once and multiplied
+// against every partition through a frequency-domain delay line, so the
+// per-block cost is two FFTs per channel plus one complex multiply-add per
+// partition, with no added latency.
+#define NX_AUDIO_CONVOLVER_BLOCK 128
+// Bins per spectrum (BLOCK + 1), padded to a multiple of the vector width.
+#define NX_AUDIO_CONVOLVER_STRIDE 132
+
+struct nx_audio_convolver {
+	nx_audio_rfft fft; // 2 * BLOCK points
+	int ir_channels = 0; // 1, 2 or 4
+	uint32_t partitions = 0;
+	// Impulse response spectra, [channel][partition][STRIDE].
+	std::vector<float> ir_re, ir_im;
+	// Spectra of the last `partitions` input blocks, [input][slot][STRIDE];
+	// slot `fdl_pos` holds the newest.
+	std::vector<float> fdl_re, fdl_im;
+	uint32_t fdl_pos = 0;
+	// Second half of the last block's output, added to the next block.
+	float tail[2][NX_AUDIO_CONVOLVER_BLOCK] = {};
+	// Scratch (one spectrum / block).
+	float acc_re[NX_AUDIO_CONVOLVER_STRIDE], acc_im[NX_AUDIO_CONVOLVER_STRIDE];
+	float block[2 * NX_AUDIO_CONVOLVER_BLOCK];
+};
+
+// The spec's "normalize" scale for an impulse response (RMS power based,
+// calibrated to 44.1 kHz).
+float nx_audio_convolver_normalization(const float *const *ir,
+                                       int num_channels, uint32_t length,
+                                       double sample_rate);
+
+// Builds the engine for an impulse response of `num_channels` (1, 2 or 4)
+// channels of `length` frames, multiplied by `scale`. Control thread
+// (allocates; one FFT per partition).
+std::unique_ptr<nx_audio_convolver>
+nx_audio_convolver_create(const float *const *ir, int num_channels,
+                          uint32_t length, float scale);
+
+// Convolves one block of `in_channels` (1 or 2) input channels into `out`
+// (2 channels of BLOCK frames). Returns the output channel count: mono
+// only for a mono input through a mono response. A 4-channel response is
+// "true stereo": out L = in L * ir 0 + in R * ir 2, out R = in L * ir 1 +
+// in R * ir 3.
+int nx_audio_convolver_process(nx_audio_convolver *c, const float *const *in,
+                               int in_channels, float *const *out);
@@ -3,7 +3,11 @@
 // runtime and the host nxjs-test binary.
 #include "audio-graph.h"
 #include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <string.h>
+#include <thread>
 
 namespace {
 
@@ -18,15 +22,18 @@ float clampf(float v, float lo, float hi) {
 // ---------------------------------------------------------------------------
 
 // Computes the parameter value at time `t` by walking the (time-sorted) event
-// list. This is a pragmatic implementation of the Web Audio "computedValue"
-// algorithm covering the common shapes: set, linear/exponential ramps,
-// setTarget decay, and value curves. Ramps anchor at the previous event's
-// (time, value); a setTarget remains in effect until the next event.
+// list from the render cursor. This is a pragmatic implementation of the Web
+// Audio "computedValue" algorithm covering the common shapes: set,
+// linear/exponential ramps, setTarget decay, and value curves. Ramps anchor at
+// the previous event's (time, value) — for the first live event that is the
+// collapsed history (`value` at `anchor_time`); a setTarget remains in effect
+// until the next event. `t` must not precede the cursor (anything at or after
+// the last rendered sample is fine).
 float param_value_at(const nx_audio_param *p, double t) {
 	const auto &evs = p->events;
 	double v_prev = p->value;
-	double t_prev = 0;
-	for (size_t i = 0; i < evs.size(); i++) {
+	double t_prev = p->anchor_time;
+	for (size_t i = p->head; i < evs.size(); i++) {
 		const nx_audio_param_event &e = evs[i];
 		if (e.time > t) {
 			// `t` falls before this event takes effect. Ramps interpolate
@@ -107,57 +114,213 @@ float param_value_at(const nx_audio_param *p, double t) {
 	return clampf((float)v_prev, p->min_value, p->max_value);
 }
 
+// Moves the render cursor past every event whose effect has fully elapsed by
+// time `t`, folding each into the (value, anchor_time) anchor exactly as
+// param_value_at() would. Stops at an event still in progress: a value curve
+// before its end, or a setTarget whose successor has not started. Elapsed
+// events are erased once they make up half the list, so pruning stays
+// amortized O(1) per event. Render thread only.
+void param_advance(nx_audio_param *p, double t) {
+	auto &evs = p->events;
+	while (p->head < evs.size()) {
+		const nx_audio_param_event &e = evs[p->head];
+		if (e.time > t)
+			break;
+		switch (e.type) {
+		case NX_AUDIO_PARAM_SET_VALUE:
+		case NX_AUDIO_PARAM_LINEAR_RAMP:
+		case NX_AUDIO_PARAM_EXPONENTIAL_RAMP:
+			p->value = e.value;
+			p->anchor_time = e.time;
+			break;
+		case NX_AUDIO_PARAM_SET_VALUE_CURVE: {
+			size_t n = e.curve.size();
+			if (n == 0)
+				break;
+			double tend = e.time + e.duration;
+			if (t < tend && e.duration > 0)
+				return;
+			p->value = e.curve[n - 1];
+			p->anchor_time = tend;
+			break;
+		}
+		case NX_AUDIO_PARAM_SET_TARGET: {
+			if (p->head + 1 >= evs.size() || evs[p->head + 1].time > t)
+				return;
+			double tstop = evs[p->head + 1].time;
+			if (e.time_constant <= 0) {
+				p->value = e.value;
+			} else {
+				p->value = (float)(e.value +
+				                   (p->value - e.value) *
+				                       exp(-(tstop - e.time) / e.time_constant));
+			}
+			p->anchor_time = tstop;
+			break;
+		}
+		}
+		p->head++;
+	}
+	if (p->head > 0 && (p->head == evs.size() ||
+	                    (p->head >= 64 && p->head * 2 >= evs.size()))) {
+		evs.erase(evs.begin(), evs.begin() + p->head);
+		p->head = 0;
+	}
+}
+
+// k-rate value at `t` (the start of a quantum).
+float param_k_value(nx_audio_param *p, double t) {
+	param_advance(p, t);
+	float v = param_value_at(p, t);
+	p->current.store(v, std::memory_order_relaxed);
+	return v;
+}
+
+// Index of the first frame in [from, n) whose time t0 + i*inv_sr is >= `t`
+// (n if none). Uses the same expression as the per-frame times so segment
+// boundaries match param_value_at() exactly.
+int param_frame_at(double t, double t0, double inv_sr, int from, int n) {
+	double f = ceil((t - t0) / inv_sr);
+	int i = f <= (double)from ? from : (f >= (double)n ? n : (int)f);
+	while (i > from && t0 + (i - 1) * inv_sr >= t)
+		i--;
+	while (i < n && t0 + i * inv_sr < t)
+		i++;
+	return i;
+}
+
 // Fill `out[0..n)` with a-rate values for frame times t0, t0+1/sr, ...
-void param_fill(const nx_audio_param *p, double t0, double inv_sr, float *out,
+//
+// Walks the quantum one automation segment at a time from the render cursor
+// (so the cost is O(frames + events that start in this quantum), independent
+// of the length of the automation history). Within a segment the shape is
+// computed in closed form: a linear ramp is an arithmetic sequence, an
+// exponential ramp and a setTarget decay are geometric ones.
+void param_fill(nx_audio_param *p, double t0, double inv_sr, float *out,
                 int n) {
-	if (p->events.empty()) {
-		float v = clampf(p->value, p->min_value, p->max_value);
-		for (int i = 0; i < n; i++)
-			out[i] = v;
-		return;
+	const float lo = p->min_value, hi = p->max_value;
+	int i = 0;
+	while (i < n) {
+		double t = t0 + i * inv_sr;
+		param_advance(p, t);
+		const auto &evs = p->events;
+		if (p->head >= evs.size()) {
+			float v = clampf(p->value, lo, hi);
+			for (; i < n; i++)
+				out[i] = v;
+			break;
+		}
+		const nx_audio_param_event &e = evs[p->head];
+		double v_prev = p->value;
+		double t_prev = p->anchor_time;
+		if (e.time > t) {
+			// Before `e`: hold, or ramp from the anchor toward it.
+			int end = param_frame_at(e.time, t0, inv_sr, i + 1, n);
+			if (e.type == NX_AUDIO_PARAM_LINEAR_RAMP && e.time > t_prev) {
+				double slope = (e.value - v_prev) / (e.time - t_prev);
+				double base = v_prev + (t - t_prev) * slope;
+				double step = inv_sr * slope;
+				for (int k = 0; k < end - i; k++)
+					out[i + k] = clampf((float)(base + step * k), lo, hi);
+			} else if (e.type == NX_AUDIO_PARAM_EXPONENTIAL_RAMP &&
+			           e.time > t_prev && v_prev != 0 &&
+			           (v_prev < 0) == (e.value < 0)) {
+				double rate = log(e.value / v_prev) / (e.time - t_prev);
+				double v = v_prev * exp((t - t_prev) * rate);
+				double mul = exp(inv_sr * rate);
+				for (int k = i; k < end; k++, v *= mul)
+					out[k] = clampf((float)v, lo, hi);
+			} else {
+				float v = e.type == NX_AUDIO_PARAM_LINEAR_RAMP
+				              ? clampf(e.value, lo, hi)
+				              : clampf((float)v_prev, lo, hi);
+				for (int k = i; k < end; k++)
+					out[k] = v;
+			}
+			i = end;
+		} else if (e.type == NX_AUDIO_PARAM_SET_TARGET) {
+			// In effect until the next event starts.
+			int end = p->head + 1 < evs.size()
+			              ? param_frame_at(evs[p->head + 1].time, t0, inv_sr,
+			                               i + 1, n)
+			              : n;
+			if (e.time_constant <= 0) {
+				float v = clampf(e.value, lo, hi);
+				for (int k = i; k < end; k++)
+					out[k] = v;
+			} else {
+				double d = (v_prev - e.value) *
+				           exp(-(t - e.time) / e.time_constant);
+				double mul = exp(-inv_sr / e.time_constant);
+				for (int k = i; k < end; k++, d *= mul)
+					out[k] = clampf((float)(e.value + d), lo, hi);
+			}
+			i = end;
+		} else {
+			// A value curve in progress (param_advance() stops only there).
+			int end = param_frame_at(e.time + e.duration, t0, inv_sr, i + 1, n);
+			for (int k = i; k < end; k++)
+				out[k] = param_value_at(p, t0 + k * inv_sr);
+			i = end;
+		}
 	}
-	for (int i = 0; i < n; i++)
-		out[i] = param_value_at(p, t0 + i * inv_sr);
+	p->current.store(out[0], std::memory_order_relaxed);
 }
 
-// Insert an event keeping the list time-sorted (stable for equal times). A
-// SET_VALUE at the exact time of an existing SET_VALUE replaces it.
+// Insert an event keeping the live part of the list time-sorted (stable for
+// equal times). A SET_VALUE at the exact time of an existing SET_VALUE
+// replaces it. Callers clamp `e.time` to currentTime, so it never precedes
+// the collapsed history.
 void param_insert_event(nx_audio_param *p, nx_audio_param_event &&e) {
+	auto live = p->events.begin() + p->head;
 	if (e.type == NX_AUDIO_PARAM_SET_VALUE) {
-		for (auto &existing : p->events) {
-			if (existing.time == e.time &&
-			    existing.type == NX_AUDIO_PARAM_SET_VALUE) {
-				existing = std::move(e);
+		for (auto it = live; it != p->events.end(); ++it) {
+			if (it->time == e.time && it->type == NX_AUDIO_PARAM_SET_VALUE) {
+				*it = std::move(e);
 				return;
 			}
 		}
 	}
 	auto it = std::upper_bound(
-	    p->events.begin(), p->events.end(), e.time,
+	    live, p->events.end(), e.time,
 	    [](double t, const nx_audio_param_event &ev) { return t < ev.time; });
 	p->events.insert(it, std::move(e));
 }
 
+double graph_time(const nx_audio_graph *g) {
+	return (double)g->frames_rendered.load(std::memory_order_relaxed) /
+	       g->sample_rate;
+}
+
+uint64_t now_ns() {
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+	           std::chrono::steady_clock::now().time_since_epoch())
+	    .count();
+}
+
 // ---------------------------------------------------------------------------
-// Node processing
+// Node processing (render thread)
 // ---------------------------------------------------------------------------
 
 void zero_bus(nx_audio_node *n) {
 	memset(n->bus, 0, sizeof(n->bus));
 }
 
-void process_node(nx_audio_graph *g, nx_audio_node *n, double t0);
-
-// `out_channels` is set to the computed channel count of the summed input.
-void sum_inputs(nx_audio_graph *g, nx_audio_node *n, double t0,
+// Sums the (already rendered) buses of `inputs` into `in` (which may be a
+// node's own bus). `out_channels` is set to the computed channel count of the
+// summed input.
+void sum_inputs(nx_audio_node *const *inputs, uint32_t count,
                 float in[NX_AUDIO_CHANNELS][Q], int *out_channels) {
-	memset(in, 0, sizeof(float) * NX_AUDIO_CHANNELS * Q);
 	int ch = 1;
-	for (nx_audio_node *src : n->inputs) {
-		process_node(g, src, t0);
-		for (int c = 0; c < NX_AUDIO_CHANNELS; c++)
-			for (int i = 0; i < Q; i++)
-				in[c][i] += src->bus[c][i];
+	if (count == 0)
+		memset(in, 0, sizeof(float) * NX_AUDIO_CHANNELS * Q);
+	else
+		memcpy(in, inputs[0]->bus, sizeof(float) * NX_AUDIO_CHANNELS * Q);
+	for (uint32_t k = 0; k < count; k++) {
+		const nx_audio_node *src = inputs[k];
+		// Both channels at once: the bus is contiguous.
+		if (k > 0)
+			nx_audio_add(&in[0][0], &src->bus[0][0], NX_AUDIO_CHANNELS * Q);
 		if (src->bus_ch == 2)
 			ch = 2;
 	}
@@ -167,30 +330,31 @@ void sum_inputs(nx_audio_graph *g, nx_audio_node *n, double t0,
 void process_buffer_source(nx_audio_graph *g, nx_audio_node *n, double t0) {
 	zero_bus(n);
 	n->bus_ch = 1;
-	if (!n->started || n->playback_state == NX_AUDIO_SOURCE_FINISHED)
+	if (!n->started || n->playback_state.load(std::memory_order_relaxed) ==
+	                       NX_AUDIO_SOURCE_FINISHED)
 		return;
 
-	bool has_buf = !n->buffer_channels.empty() && n->buffer_length > 0 &&
-	               n->buffer_sample_rate > 0;
-	if (has_buf && n->buffer_channels.size() > 1)
+	const nx_audio_source_buffer *b = n->buffer;
+	bool has_buf = b && !b->channels.empty() && b->length > 0 &&
+	               b->sample_rate > 0;
+	if (has_buf && b->channels.size() > 1)
 		n->bus_ch = 2;
 
 	// k-rate playback rate, computed once per quantum.
-	double rate = param_value_at(&n->params[0], t0);
-	double detune = param_value_at(&n->params[1], t0);
+	double rate = param_k_value(&n->params[0], t0);
+	double detune = param_k_value(&n->params[1], t0);
 	double r = rate * exp2(detune / 1200.0);
 	if (has_buf)
-		r *= n->buffer_sample_rate / g->sample_rate;
+		r *= b->sample_rate / g->sample_rate;
 
 	double inv_sr = 1.0 / g->sample_rate;
-	double buf_len = has_buf ? (double)n->buffer_length : 0;
+	double buf_len = has_buf ? (double)b->length : 0;
 
 	// Loop points, in buffer frames.
 	double loop_s = 0, loop_e = buf_len;
 	if (n->loop && has_buf) {
-		loop_s = n->loop_start * n->buffer_sample_rate;
-		loop_e = n->loop_end > 0 ? n->loop_end * n->buffer_sample_rate
-		                         : buf_len;
+		loop_s = n->loop_start * b->sample_rate;
+		loop_e = n->loop_end > 0 ? n->loop_end * b->sample_rate : buf_len;
 		if (loop_s < 0)
 			loop_s = 0;
 		if (loop_e > buf_len)
@@ -201,13 +365,17 @@ void process_buffer_source(nx_audio_graph *g, nx_audio_node *n, double t0) {
 		}
 	}
 	double dur_frames =
-	    n->duration >= 0 && has_buf ? n->duration * n->buffer_sample_rate : -1;
+	    n->duration >= 0 && has_buf ? n->duration * b->sample_rate : -1;
 
-	const float *ch0 = has_buf ? n->buffer_channels[0] : nullptr;
-	const float *ch1 = has_buf && n->buffer_channels.size() > 1
-	                       ? n->buffer_channels[1]
-	                       : ch0;
+	const void *ch0 = has_buf ? b->channels[0] : nullptr;
+	const void *ch1 = has_buf && b->channels.size() > 1 ? b->channels[1] : ch0;
 
+	// The loop below only advances the playhead; the frames it plays (always
+	// one contiguous run, [first, last)) are interpolated afterwards, a vector
+	// at a time.
+	uint32_t idx0[Q], idx1[Q];
+	float fracs[Q];
+	int first = -1, last = -1;
 	bool finished = false;
 	for (int i = 0; i < Q; i++) {
 		double t = t0 + i * inv_sr;
@@ -219,7 +387,7 @@ void process_buffer_source(nx_audio_graph *g, nx_audio_node *n, double t0) {
 			continue; // bus is already zero
 		if (!n->playing) {
 			n->playing = true;
-			n->position = n->start_offset * n->buffer_sample_rate;
+			n->position = has_buf ? n->start_offset * b->sample_rate : 0;
 			if (n->position < 0)
 				n->position = 0;
 			if (n->loop && n->position > loop_e)
@@ -237,12 +405,14 @@ void process_buffer_source(nx_audio_graph *g, nx_audio_node *n, double t0) {
 			break;
 		}
 		uint32_t i0 = (uint32_t)n->position;
-		if (i0 >= n->buffer_length)
-			i0 = n->buffer_length - 1;
-		uint32_t i1 = i0 + 1 < n->buffer_length ? i0 + 1 : i0;
-		double frac = n->position - (double)i0;
-		n->bus[0][i] = (float)(ch0[i0] + (ch0[i1] - ch0[i0]) * frac);
-		n->bus[1][i] = (float)(ch1[i0] + (ch1[i1] - ch1[i0]) * frac);
+		if (i0 >= b->length)
+			i0 = b->length - 1;
+		idx0[i] = i0;
+		idx1[i] = i0 + 1 < b->length ? i0 + 1 : i0;
+		fracs[i] = (float)(n->position - (double)i0);
+		if (first < 0)
+			first = i;
+		last = i + 1;
 		n->position += r;
 		n->played_frames += fabs(r);
 		if (n->loop) {
@@ -255,169 +425,1113 @@ void process_buffer_source(nx_audio_graph *g, nx_audio_node *n, double t0) {
 			}
 		}
 	}
+	if (first >= 0) {
+		uint32_t len = (uint32_t)(last - first);
+		for (int c = 0; c < 2; c++) {
+			if (c == 1 && ch1 == ch0) {
+				memcpy(n->bus[1] + first, n->bus[0] + first,
+				       sizeof(float) * len);
+				break;
+			}
+			const void *src = c ? ch1 : ch0;
+			if (b->s16)
+				nx_audio_interpolate_s16(
+				    n->bus[c] + first, static_cast<const int16_t *>(src),
+				    idx0 + first, idx1 + first, fracs + first, len);
+			else
+				nx_audio_interpolate(n->bus[c] + first,
+				                     static_cast<const float *>(src),
+				                     idx0 + first, idx1 + first, fracs + first,
+				                     len);
+		}
+	}
 	if (finished) {
-		n->playback_state = NX_AUDIO_SOURCE_FINISHED;
+		n->playback_state.store(NX_AUDIO_SOURCE_FINISHED,
+		                        std::memory_order_relaxed);
 		n->playing = false;
 	}
 }
 
-void process_stream_source(nx_audio_graph *g, nx_audio_node *n) {
-	zero_bus(n);
-	n->bus_ch = 2;
-	if (!n->stream_ring || !n->stream_playing.load(std::memory_order_relaxed))
-		return;
+// Applies a pending flush (see nx_audio_stream_flush()); returns the read
+// position.
+uint64_t stream_apply_flush(nx_audio_node *n) {
 	uint64_t read = n->stream_read_pos.load(std::memory_order_relaxed);
+	uint64_t flush =
+	    n->stream_flush_pos.exchange(UINT64_MAX, std::memory_order_acquire);
+	if (flush != UINT64_MAX && flush > read) {
+		read = flush;
+		n->stream_read_pos.store(read, std::memory_order_release);
+	}
+	return read;
+}
+
+// Pops up to `frames` frames from the ring into bus[0 / 1] + `at`; returns
+// the number of frames popped.
+uint32_t stream_pop(nx_audio_node *n, int at, uint32_t frames) {
+	// Checked before the flush: a completed seek's flush is then visible.
+	if (n->stream_seeks.load(std::memory_order_acquire))
+		return 0; // the ring still holds frames from before the seek
+	uint64_t read = stream_apply_flush(n);
 	uint64_t write = n->stream_write_pos.load(std::memory_order_acquire);
 	uint32_t avail = (uint32_t)(write - read);
-	uint32_t frames = avail < (uint32_t)Q ? avail : (uint32_t)Q;
+	if (frames > avail)
+		frames = avail;
 	const float *ring = n->stream_ring.get();
 	for (uint32_t i = 0; i < frames; i++) {
 		uint32_t idx = (uint32_t)((read + i) % n->stream_capacity);
-		n->bus[0][i] = ring[idx * 2];
-		n->bus[1][i] = ring[idx * 2 + 1];
+		n->bus[0][at + i] = ring[idx * 2];
+		n->bus[1][at + i] = ring[idx * 2 + 1];
+	}
+	n->stream_read_pos.store(read + frames, std::memory_order_release);
+	return frames;
+}
+
+// Whether the producer has ended the stream and every frame has been read.
+bool stream_drained(nx_audio_node *n) {
+	if (!n->stream_ended.load(std::memory_order_acquire) ||
+	    n->stream_seeks.load(std::memory_order_acquire))
+		return false;
+	return stream_apply_flush(n) ==
+	       n->stream_write_pos.load(std::memory_order_acquire);
+}
+
+// AudioStreamSourceNode: the frames of [start, stop) (and within
+// `duration`) are read from the ring, sample-accurately.
+void process_scheduled_stream(nx_audio_graph *g, nx_audio_node *n,
+                              double t0) {
+	stream_apply_flush(n); // so that the producer can prefill before start()
+	if (!n->started || n->playback_state.load(std::memory_order_relaxed) ==
+	                       NX_AUDIO_SOURCE_FINISHED)
+		return;
+	double inv_sr = 1.0 / g->sample_rate;
+	int first = Q, end = Q;
+	bool finished = false;
+	for (int i = 0; i < Q; i++) {
+		double t = t0 + i * inv_sr;
+		if (n->stop_time >= 0 && t >= n->stop_time) {
+			end = i;
+			finished = true;
+			break;
+		}
+		if (first == Q && t >= n->start_time)
+			first = i;
+	}
+	uint32_t want = end > first ? (uint32_t)(end - first) : 0;
+	if (n->duration >= 0) {
+		double left = n->duration * g->sample_rate - n->played_frames;
+		if (left <= want) {
+			want = left > 0 ? (uint32_t)ceil(left) : 0;
+			finished = true;
+		}
+	}
+	uint32_t got = stream_pop(n, first, want);
+	while (got < want && n->stream_wait) {
+		// Offline: block on the producer rather than render a gap.
+		if (stream_drained(n) || g->closed.load(std::memory_order_relaxed))
+			break;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		got += stream_pop(n, first + (int)got, want - got);
+	}
+	n->played_frames += got;
+	// A realtime underrun leaves the rest of the quantum silent; the missing
+	// frames are played late rather than skipped.
+	if (got < want && stream_drained(n))
+		finished = true;
+	if (finished)
+		n->playback_state.store(NX_AUDIO_SOURCE_FINISHED,
+		                        std::memory_order_relaxed);
+}
+
+void process_stream_source(nx_audio_graph *g, nx_audio_node *n, double t0) {
+	zero_bus(n);
+	n->bus_ch = 2;
+	if (!n->stream_ring)
+		return;
+	if (n->stream_scheduled) {
+		process_scheduled_stream(g, n, t0);
+		return;
 	}
+	stream_apply_flush(n);
+	if (!n->stream_playing.load(std::memory_order_relaxed))
+		return;
 	// Underrun: the remainder of the bus stays silent and is NOT counted as
 	// consumed, so the media clock only advances for real audio.
-	n->stream_read_pos.store(read + frames, std::memory_order_release);
-	(void)g;
+	stream_pop(n, 0, Q);
+}
+
+// Band-limited wavetable oscillator. The table pair is re-selected only when
+// the computed frequency changes, so a steady tone costs one interpolated
+// lookup (two while crossfading ranges) per frame.
+void process_oscillator(nx_audio_graph *g, nx_audio_node *n, double t0) {
+	zero_bus(n);
+	n->bus_ch = 1;
+	if (!n->started || n->playback_state.load(std::memory_order_relaxed) ==
+	                       NX_AUDIO_SOURCE_FINISHED)
+		return;
+	double inv_sr = 1.0 / g->sample_rate;
+	float freq[Q], detune[Q];
+	param_fill(&n->params[0], t0, inv_sr, freq, Q);
+	param_fill(&n->params[1], t0, inv_sr, detune, Q);
+	const nx_audio_periodic_wave *wave = n->wave.get();
+	const double nyquist = g->sample_rate / 2;
+	constexpr double N = NX_AUDIO_WAVE_SIZE;
+
+	float last_freq = NAN, last_detune = NAN;
+	double f = 0;
+	const float *lo = nullptr, *hi = nullptr;
+	float mix = 0;
+	bool finished = false;
+	for (int i = 0; i < Q; i++) {
+		double t = t0 + i * inv_sr;
+		if (n->stop_time >= 0 && t >= n->stop_time) {
+			finished = true;
+			break;
+		}
+		if (t < n->start_time || !wave)
+			continue;
+		if (freq[i] != last_freq || detune[i] != last_detune) {
+			last_freq = freq[i];
+			last_detune = detune[i];
+			f = detune[i] != 0 ? freq[i] * exp2(detune[i] / 1200.0) : freq[i];
+			if (!(f >= -nyquist))
+				f = -nyquist; // also catches NaN
+			if (f > nyquist)
+				f = nyquist;
+			// Table r is alias-free while its highest partial,
+			// (N / 2) * 2^(-r / RPO), times |f| stays below Nyquist.
+			double af = fabs(f);
+			double r = af > 0 ? NX_AUDIO_WAVE_RANGES_PER_OCTAVE *
+			                        log2((N / 2) * af / nyquist)
+			                  : 0;
+			int r0 = 0;
+			mix = 0;
+			if (r > 0) {
+				double fl = floor(r);
+				r0 = (int)fl + 1;
+				mix = (float)(r - fl);
+			}
+			int r1 = r0 + 1;
+			if (r0 > NX_AUDIO_WAVE_RANGES - 1)
+				r0 = NX_AUDIO_WAVE_RANGES - 1;
+			if (r1 > NX_AUDIO_WAVE_RANGES - 1)
+				r1 = NX_AUDIO_WAVE_RANGES - 1;
+			lo = wave->table(r0);
+			hi = wave->table(r1);
+		}
+		double pos = n->phase * N;
+		int k = (int)pos;
+		if (k >= NX_AUDIO_WAVE_SIZE) // phase rounded up to 1
+			k = NX_AUDIO_WAVE_SIZE - 1;
+		float frac = (float)(pos - k);
+		float a = lo[k] + (lo[k + 1] - lo[k]) * frac;
+		float b = hi[k] + (hi[k + 1] - hi[k]) * frac;
+		float v = a + (b - a) * mix;
+		n->bus[0][i] = v;
+		n->bus[1][i] = v;
+		n->phase += f * inv_sr;
+		n->phase -= floor(n->phase);
+	}
+	if (finished)
+		n->playback_state.store(NX_AUDIO_SOURCE_FINISHED,
+		                        std::memory_order_relaxed);
+}
+
+bool is_constant(const float *v, int n) {
+	for (int i = 1; i < n; i++)
+		if (v[i] != v[0])
+			return false;
+	return true;
+}
+
+nx_audio_biquad_coefs biquad_coefs_at(const nx_audio_node *n, float freq,
+                                      float detune, float q, float gain,
+                                      double nyquist) {
+	double f = detune != 0 ? freq * exp2(detune / 1200.0) : freq;
+	return nx_audio_biquad_design(n->filter_type, f / nyquist, q, gain);
 }
 
-void process_gain(nx_audio_graph *g, nx_audio_node *n, double t0) {
+// Direct form I in double precision. With un-automated params (the common
+// case) the coefficients are designed once per quantum; otherwise per frame,
+// since all four params are a-rate.
+void process_biquad(nx_audio_graph *g, nx_audio_node *n,
+                    nx_audio_node *const *inputs, uint32_t count, double t0) {
 	float in[NX_AUDIO_CHANNELS][Q];
 	int ch;
-	sum_inputs(g, n, t0, in, &ch);
+	sum_inputs(inputs, count, in, &ch);
 	n->bus_ch = ch;
-	float gain[Q];
-	param_fill(&n->params[0], t0, 1.0 / g->sample_rate, gain, Q);
+	double inv_sr = 1.0 / g->sample_rate;
+	double nyquist = g->sample_rate / 2;
+	float freq[Q], detune[Q], q[Q], gain[Q];
+	param_fill(&n->params[0], t0, inv_sr, freq, Q);
+	param_fill(&n->params[1], t0, inv_sr, detune, Q);
+	param_fill(&n->params[2], t0, inv_sr, q, Q);
+	param_fill(&n->params[3], t0, inv_sr, gain, Q);
+	bool fixed = is_constant(freq, Q) && is_constant(detune, Q) &&
+	             is_constant(q, Q) && is_constant(gain, Q);
+	nx_audio_biquad_coefs c =
+	    biquad_coefs_at(n, freq[0], detune[0], q[0], gain[0], nyquist);
+	for (int chan = 0; chan < ch; chan++) {
+		double *st = n->biquad_state[chan];
+		double x1 = st[0], x2 = st[1], y1 = st[2], y2 = st[3];
+		const float *x = in[chan];
+		float *y = n->bus[chan];
+		for (int i = 0; i < Q; i++) {
+			if (!fixed && i > 0)
+				c = biquad_coefs_at(n, freq[i], detune[i], q[i], gain[i],
+				                    nyquist);
+			double out =
+			    c.b0 * x[i] + c.b1 * x1 + c.b2 * x2 - c.a1 * y1 - c.a2 * y2;
+			x2 = x1;
+			x1 = x[i];
+			y2 = y1;
+			y1 = out;
+			y[i] = (float)out;
+		}
+		if (!fixed)
+			c = biquad_coefs_at(n, freq[0], detune[0], q[0], gain[0],
+			                    nyquist);
+		// Flush denormals so a decaying tail doesn't hit the slow path.
+		constexpr double TINY = 1e-30;
+		st[0] = fabs(x1) < TINY ? 0 : x1;
+		st[1] = fabs(x2) < TINY ? 0 : x2;
+		st[2] = fabs(y1) < TINY ? 0 : y1;
+		st[3] = fabs(y2) < TINY ? 0 : y2;
+	}
+	if (ch == 1) {
+		memcpy(n->bus[1], n->bus[0], sizeof(n->bus[0]));
+		memcpy(n->biquad_state[1], n->biquad_state[0],
+		       sizeof(n->biquad_state[0]));
+	}
+}
+
+// Linearly interpolated read `delay` frames behind write index `pos`.
+float delay_read(const float *line, uint32_t size, uint32_t pos,
+                 double delay) {
+	double r = (double)pos - delay;
+	if (r < 0)
+		r += size;
+	uint32_t i0 = (uint32_t)r;
+	float frac = (float)(r - i0);
+	if (i0 >= size)
+		i0 -= size;
+	uint32_t i1 = i0 + 1 == size ? 0 : i0 + 1;
+	return line[i0] + (line[i1] - line[i0]) * frac;
+}
+
+// A DelayNode outside of a cycle writes and reads in the same pass, so a
+// delay shorter than a quantum (even 0) works. Inside a cycle, the read step
+// runs before anything that feeds the delay has been rendered, and the delay
+// is clamped to at least one quantum.
+void process_delay(nx_audio_graph *g, nx_audio_node *n,
+                   nx_audio_node *const *inputs, uint32_t count, double t0,
+                   nx_audio_plan_step step) {
+	const uint32_t size = n->delay_size;
+	float *line[NX_AUDIO_CHANNELS] = {n->delay_line.get(),
+	                                  n->delay_line.get() + size};
+	float in[NX_AUDIO_CHANNELS][Q];
+	if (step != NX_AUDIO_STEP_DELAY_READ)
+		sum_inputs(inputs, count, in, &n->delay_ch);
+	if (step == NX_AUDIO_STEP_DELAY_WRITE) {
+		for (int c = 0; c < NX_AUDIO_CHANNELS; c++)
+			for (int i = 0; i < Q; i++)
+				line[c][(n->delay_write + i) % size] = in[c][i];
+		n->delay_write = (n->delay_write + Q) % size;
+		return;
+	}
+	n->bus_ch = n->delay_ch;
+	float delay[Q];
+	param_fill(&n->params[0], t0, 1.0 / g->sample_rate, delay, Q);
+	double min_frames = step == NX_AUDIO_STEP_DELAY_READ ? Q : 0;
 	for (int i = 0; i < Q; i++) {
-		n->bus[0][i] = in[0][i] * gain[i];
-		n->bus[1][i] = in[1][i] * gain[i];
+		uint32_t pos = (n->delay_write + i) % size;
+		double d = delay[i] * g->sample_rate;
+		if (d < min_frames)
+			d = min_frames;
+		for (int c = 0; c < NX_AUDIO_CHANNELS; c++) {
+			if (step == NX_AUDIO_STEP_PROCESS)
+				line[c][pos] = in[c][i];
+			n->bus[c][i] = delay_read(line[c], size, pos, d);
+		}
 	}
+	if (step == NX_AUDIO_STEP_PROCESS)
+		n->delay_write = (n->delay_write + Q) % size;
 }
 
-void process_stereo_panner(nx_audio_graph *g, nx_audio_node *n, double t0) {
+void process_gain(nx_audio_graph *g, nx_audio_node *n,
+                  nx_audio_node *const *inputs, uint32_t count, double t0) {
+	int ch;
+	sum_inputs(inputs, count, n->bus, &ch);
+	n->bus_ch = ch;
+	float gain[Q];
+	param_fill(&n->params[0], t0, 1.0 / g->sample_rate, gain, Q);
+	nx_audio_mul(n->bus[0], n->bus[0], gain, Q);
+	nx_audio_mul(n->bus[1], n->bus[1], gain, Q);
+}
+
+void process_stereo_panner(nx_audio_graph *g, nx_audio_node *n,
+                           nx_audio_node *const *inputs, uint32_t count,
+                           double t0) {
 	float in[NX_AUDIO_CHANNELS][Q];
 	int ch;
-	sum_inputs(g, n, t0, in, &ch);
+	sum_inputs(inputs, count, in, &ch);
 	n->bus_ch = 2; // panner output is always stereo
 	float pan[Q];
 	param_fill(&n->params[0], t0, 1.0 / g->sample_rate, pan, Q);
-	constexpr double HALF_PI = 1.57079632679489661923;
-	if (ch == 1) {
-		// Mono input (L==R): x = (pan + 1) / 2.
-		for (int i = 0; i < Q; i++) {
-			double x = (pan[i] + 1) / 2;
-			n->bus[0][i] = (float)(in[0][i] * cos(x * HALF_PI));
-			n->bus[1][i] = (float)(in[0][i] * sin(x * HALF_PI));
-		}
-	} else {
-		// Stereo input, per the spec's equal-power algorithm.
-		for (int i = 0; i < Q; i++) {
-			double p = pan[i];
-			double x = p <= 0 ? p + 1 : p;
-			float gl = (float)cos(x * HALF_PI);
-			float gr = (float)sin(x * HALF_PI);
-			if (p <= 0) {
-				n->bus[0][i] = in[0][i] + in[1][i] * gl;
-				n->bus[1][i] = in[1][i] * gr;
-			} else {
-				n->bus[0][i] = in[0][i] * gl;
-				n->bus[1][i] = in[1][i] + in[0][i] * gr;
-			}
-		}
+	// Mono input (L == R) pans with x = (pan + 1) / 2; stereo input follows
+	// the spec's equal-power algorithm.
+	if (ch == 1)
+		nx_audio_pan_mono(n->bus[0], n->bus[1], in[0], pan, Q);
+	else
+		nx_audio_pan_stereo(n->bus[0], n->bus[1], in[0], in[1], pan, Q);
+}
+
+void process_convolver(nx_audio_node *n, nx_audio_node *const *inputs,
+                       uint32_t count) {
+	float in[NX_AUDIO_CHANNELS][Q];
+	int ch;
+	sum_inputs(inputs, count, in, &ch);
+	if (!n->convolver) {
+		zero_bus(n);
+		n->bus_ch = 1;
+		return;
+	}
+	const float *src[NX_AUDIO_CHANNELS] = {in[0], in[1]};
+	float *dst[NX_AUDIO_CHANNELS] = {n->bus[0], n->bus[1]};
+	n->bus_ch = nx_audio_convolver_process(n->convolver, src, ch, dst);
+}
+
+// The compression curve: output level (dB) for an input level `x` (dB).
+// Unity below the threshold, `1 / ratio` above threshold + knee, and a
+// quadratic in between that joins the two with a continuous slope.
+double compressor_curve(double x, double threshold, double knee,
+                        double ratio) {
+	double slope = 1 / ratio;
+	if (x <= threshold)
+		return x;
+	if (x < threshold + knee) {
+		double d = x - threshold;
+		return x + (slope - 1) * d * d / (2 * knee);
 	}
+	return threshold + knee * (1 + slope) / 2 + (x - threshold - knee) * slope;
 }
 
-void process_destination(nx_audio_graph *g, nx_audio_node *n, double t0) {
+// Per frame: the detector level (the louder channel) sets a target gain
+// change from the curve, which the envelope follows at the attack or release
+// rate. The envelope (plus makeup gain) is applied to the input delayed by
+// the look-ahead, so gain reduction is already in place when a transient
+// reaches the output.
+void process_compressor(nx_audio_graph *g, nx_audio_node *n,
+                        nx_audio_node *const *inputs, uint32_t count,
+                        double t0) {
 	float in[NX_AUDIO_CHANNELS][Q];
 	int ch;
-	sum_inputs(g, n, t0, in, &ch);
+	sum_inputs(inputs, count, in, &ch);
+	const double sr = g->sample_rate;
+	double threshold = param_k_value(&n->params[0], t0);
+	double knee = param_k_value(&n->params[1], t0);
+	double ratio = param_k_value(&n->params[2], t0);
+	double attack = param_k_value(&n->params[3], t0);
+	double release = param_k_value(&n->params[4], t0);
+	// Makeup gain, per the spec: (1 / curve(0 dB))^0.6.
+	double makeup_db = -0.6 * compressor_curve(0, threshold, knee, ratio);
+	double attack_k = attack > 0 ? exp(-1 / (attack * sr)) : 0;
+	double release_k = release > 0 ? exp(-1 / (release * sr)) : 0;
+	double env = n->compressor_envelope;
+	float gain[Q];
+	for (int i = 0; i < Q; i++) {
+		float level = fabsf(in[0][i]);
+		if (ch == 2)
+			level = std::max(level, fabsf(in[1][i]));
+		double x = level > 1e-10f ? 20 * log10((double)level) : -200;
+		double target = compressor_curve(x, threshold, knee, ratio) - x;
+		double k = target < env ? attack_k : release_k;
+		env = target + (env - target) * k;
+		gain[i] = (float)pow(10.0, (env + makeup_db) / 20);
+	}
+	if (!(env > -1000)) // also catches NaN
+		env = 0;
+	n->compressor_envelope = env;
+	n->compressor_reduction.store((float)env, std::memory_order_relaxed);
+
+	// Look-ahead delay (mono input is written to both channels).
+	const uint32_t size = n->compressor_delay;
+	float *line[NX_AUDIO_CHANNELS] = {n->compressor_line.get(),
+	                                  n->compressor_line.get() + size};
+	const float *src1 = ch == 2 ? in[1] : in[0];
+	uint32_t pos = n->compressor_pos;
+	for (int i = 0; i < Q; i++) {
+		n->bus[0][i] = line[0][pos];
+		n->bus[1][i] = line[1][pos];
+		line[0][pos] = in[0][i];
+		line[1][pos] = src1[i];
+		if (++pos == size)
+			pos = 0;
+	}
+	n->compressor_pos = pos;
+	nx_audio_mul(n->bus[0], n->bus[0], gain, Q);
+	nx_audio_mul(n->bus[1], n->bus[1], gain, Q);
+	// The output stays stereo until stereo input has left the delay line.
+	if (ch == 2)
+		n->compressor_stereo = size + Q;
+	n->bus_ch = n->compressor_stereo > 0 ? 2 : 1;
+	n->compressor_stereo -= std::min<uint32_t>(n->compressor_stereo, Q);
+}
+
+// Passes its input through unchanged, and records a mono downmix of it for
+// the control thread's analysis.
+void process_analyser(nx_audio_node *n, nx_audio_node *const *inputs,
+                      uint32_t count) {
+	float in[NX_AUDIO_CHANNELS][Q];
+	int ch;
+	sum_inputs(inputs, count, in, &ch);
 	n->bus_ch = ch;
 	memcpy(n->bus, in, sizeof(in));
+	nx_audio_analyser *a = n->analyser.get();
+	uint64_t pos = a->write_pos.load(std::memory_order_relaxed);
+	// Q divides the ring size, so a quantum never wraps.
+	float *dst = a->ring + pos % NX_AUDIO_ANALYSER_RING;
+	if (ch == 1) {
+		memcpy(dst, in[0], sizeof(in[0]));
+	} else {
+		nx_audio_downmix(dst, in[0], in[1], Q);
+	}
+	a->write_pos.store(pos + Q, std::memory_order_release);
 }
 
-void process_node(nx_audio_graph *g, nx_audio_node *n, double t0) {
-	if (n->processed_quantum == g->quantum_id)
-		return; // already rendered this quantum (fan-out memoization)
-	if (n->processing) {
-		// Cycle (not legal in Web Audio without a DelayNode, which we don't
-		// implement) — break it with silence.
-		zero_bus(n);
-		return;
-	}
-	n->processing = true;
+void process_destination(nx_audio_node *n, nx_audio_node *const *inputs,
+                         uint32_t count) {
+	int ch;
+	sum_inputs(inputs, count, n->bus, &ch);
+	n->bus_ch = ch;
+}
+
+// Renders `plan->order[i]`. Its inputs come earlier in the plan, so their
+// buses already hold this quantum.
+void process_node(nx_audio_graph *g, const nx_audio_plan *plan, size_t i,
+                  double t0) {
+	nx_audio_node *n = plan->order[i];
+	nx_audio_node *const *inputs = plan->inputs.data() + plan->input_start[i];
+	uint32_t count = plan->input_start[i + 1] - plan->input_start[i];
 	switch (n->type) {
+	case NX_AUDIO_NODE_OSCILLATOR:
+		process_oscillator(g, n, t0);
+		break;
+	case NX_AUDIO_NODE_BIQUAD_FILTER:
+		process_biquad(g, n, inputs, count, t0);
+		break;
+	case NX_AUDIO_NODE_DELAY:
+		process_delay(g, n, inputs, count, t0, plan->steps[i]);
+		break;
 	case NX_AUDIO_NODE_BUFFER_SOURCE:
 		process_buffer_source(g, n, t0);
 		break;
 	case NX_AUDIO_NODE_STREAM_SOURCE:
-		process_stream_source(g, n);
+		process_stream_source(g, n, t0);
 		break;
 	case NX_AUDIO_NODE_GAIN:
-		process_gain(g, n, t0);
+		process_gain(g, n, inputs, count, t0);
 		break;
 	case NX_AUDIO_NODE_STEREO_PANNER:
-		process_stereo_panner(g, n, t0);
+		process_stereo_panner(g, n, inputs, count, t0);
+		break;
+	case NX_AUDIO_NODE_ANALYSER:
+		process_analyser(n, inputs, count);
+		break;
+	case NX_AUDIO_NODE_CONVOLVER:
+		process_convolver(n, inputs, count);
+		break;
+	case NX_AUDIO_NODE_DYNAMICS_COMPRESSOR:
+		process_compressor(g, n, inputs, count, t0);
 		break;
 	case NX_AUDIO_NODE_DESTINATION:
-		process_destination(g, n, t0);
+		process_destination(n, inputs, count);
+		break;
+	}
+}
+
+// Applies a control-thread command at render time `t` (the start of the
+// quantum about to be rendered).
+void apply_command(nx_audio_graph *g, nx_audio_cmd &c, double t) {
+	nx_audio_node *n = c.node;
+	switch (c.type) {
+	case NX_AUDIO_CMD_NONE:
+		break;
+	case NX_AUDIO_CMD_PARAM_EVENT: {
+		// Times before currentTime are clamped to it, as the spec requires.
+		// Clamping here (rather than when the call was made) also keeps the
+		// event out of the render cursor's collapsed history.
+		if (c.event.time < t)
+			c.event.time = t;
+		param_insert_event(&n->params[c.param], std::move(c.event));
+		break;
+	}
+	case NX_AUDIO_CMD_PARAM_SET_VALUE: {
+		nx_audio_param *p = &n->params[c.param];
+		if (p->head < p->events.size()) {
+			// Per spec, setting .value with scheduled automation behaves
+			// like setValueAtTime(value, currentTime).
+			nx_audio_param_event e = {};
+			e.type = NX_AUDIO_PARAM_SET_VALUE;
+			e.time = t;
+			e.value = (float)c.a;
+			param_insert_event(p, std::move(e));
+		} else {
+			// No live automation: this is the new anchor for a later ramp.
+			p->value = (float)c.a;
+			p->anchor_time = t;
+		}
+		break;
+	}
+	case NX_AUDIO_CMD_PARAM_CANCEL: {
+		nx_audio_param *p = &n->params[c.param];
+		double time = std::max(c.a, t);
+		// A setTarget or value curve still in progress at a cancel time of
+		// now is cancelled too: fold its current value into the anchor and
+		// hold it there, rather than letting it run on.
+		param_advance(p, t);
+		if (time <= t && p->head < p->events.size() &&
+		    p->events[p->head].time < time) {
+			p->value = param_value_at(p, t);
+			p->anchor_time = t;
+			p->events.erase(p->events.begin() + p->head);
+		}
+		p->events.erase(std::remove_if(p->events.begin() + p->head,
+		                               p->events.end(),
+		                               [time](const nx_audio_param_event &e) {
+			                               return e.time >= time;
+		                               }),
+		                p->events.end());
+		break;
+	}
+	case NX_AUDIO_CMD_SOURCE_BUFFER:
+		if (n->buffer)
+			g->garbage.push(
+			    nx_audio_garbage{nullptr, n->buffer, nullptr, nullptr});
+		n->buffer = c.buffer;
+		c.buffer = nullptr;
+		break;
+	case NX_AUDIO_CMD_SOURCE_LOOP:
+		n->loop = c.flag;
+		n->loop_start = c.a;
+		n->loop_end = c.b;
+		break;
+	case NX_AUDIO_CMD_SOURCE_START:
+		if (n->started)
+			break;
+		n->started = true;
+		n->start_time = c.a;
+		n->start_offset = c.b;
+		n->duration = c.c;
+		break;
+	case NX_AUDIO_CMD_SOURCE_STOP:
+		n->stop_time = std::max(c.a, t);
+		break;
+	case NX_AUDIO_CMD_OSCILLATOR_WAVE:
+		// The last reference to a custom wave must not drop here.
+		if (n->wave)
+			g->garbage.push(nx_audio_garbage{nullptr, nullptr,
+			                                 std::move(n->wave), nullptr});
+		n->wave = std::move(c.wave);
+		break;
+	case NX_AUDIO_CMD_BIQUAD_TYPE:
+		n->filter_type = (nx_audio_biquad_type)(int)c.a;
+		break;
+	case NX_AUDIO_CMD_CONVOLVER:
+		if (n->convolver)
+			g->garbage.push(
+			    nx_audio_garbage{nullptr, nullptr, nullptr, n->convolver});
+		n->convolver = c.convolver;
+		c.convolver = nullptr;
 		break;
 	}
-	n->processing = false;
-	n->processed_quantum = g->quantum_id;
+}
+
+// Start of every quantum: adopt the newest plan, then apply queued commands.
+// The plan id is published only after the drain, because commands pushed
+// before a node's release (which may reference it) are only guaranteed to be
+// visible once the plan that excludes the node has been taken.
+void render_prologue(nx_audio_graph *g, double t) {
+	nx_audio_plan *plan =
+	    g->pending_plan.exchange(nullptr, std::memory_order_acq_rel);
+	if (plan) {
+		if (g->plan)
+			g->garbage.push(nx_audio_garbage{g->plan, nullptr, nullptr, nullptr});
+		g->plan = plan;
+		g->stat_plan_swaps.fetch_add(1, std::memory_order_relaxed);
+	}
+	nx_audio_cmd c;
+	uint64_t applied = 0;
+	while (g->commands.pop(c)) {
+		apply_command(g, c, t);
+		applied++;
+	}
+	if (applied)
+		g->stat_commands.fetch_add(applied, std::memory_order_relaxed);
+	if (plan)
+		g->adopted_plan_id.store(plan->id, std::memory_order_release);
 }
 
 // Renders one 128-frame quantum into the destination bus and advances time.
-// Caller holds the graph mutex.
 void render_quantum(nx_audio_graph *g) {
-	g->quantum_id++;
-	double t0 = (double)g->frames_rendered / g->sample_rate;
-	process_node(g, g->destination, t0);
-	// Sources not reachable from the destination still progress through their
-	// schedule (so `ended` fires even for unconnected/indirect sources).
-	for (nx_audio_node *n : g->nodes) {
-		if (n->type == NX_AUDIO_NODE_BUFFER_SOURCE &&
-		    n->processed_quantum != g->quantum_id)
-			process_node(g, n, t0);
+	uint64_t frames = g->frames_rendered.load(std::memory_order_relaxed);
+	double t0 = (double)frames / g->sample_rate;
+	render_prologue(g, t0);
+	const nx_audio_plan *plan = g->plan;
+	for (size_t i = 0; i < plan->order.size(); i++)
+		process_node(g, plan, i, t0);
+	g->frames_rendered.store(frames + Q, std::memory_order_release);
+	g->stat_quanta.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Accounts a render call that took `elapsed` ns to produce `frames`. Only one
+// render thread runs at a time, so the max needs no CAS loop.
+void record_render(nx_audio_graph *g, uint64_t elapsed, uint32_t frames,
+                   bool realtime) {
+	g->stat_render_ns.fetch_add(elapsed, std::memory_order_relaxed);
+	if (elapsed > g->stat_render_max_ns.load(std::memory_order_relaxed))
+		g->stat_render_max_ns.store(elapsed, std::memory_order_relaxed);
+	if (realtime && (double)elapsed > (double)frames * 1e9 / g->sample_rate)
+		g->stat_glitches.fetch_add(1, std::memory_order_relaxed);
+}
+
+// ---------------------------------------------------------------------------
+// Parallel offline rendering
+// ---------------------------------------------------------------------------
+//
+// The plan is cut into "branches": the connected components of the graph once
+// the destination is taken out. Branches share no node, so each one can run
+// on its own thread, and the only place they meet is the destination's input
+// sum. An offline render proceeds in blocks of OFFLINE_BLOCK quanta: every
+// branch renders the whole block (keeping a copy of what it feeds the
+// destination, per quantum), then the destination sums those copies quantum
+// by quantum, in plan order. Every node sees the same inputs and times as in
+// a serial render, and the destination adds the same values in the same
+// order, so the output is bit-identical. Commands and plan swaps are applied
+// at block boundaries rather than at every quantum.
+
+constexpr uint32_t OFFLINE_BLOCK = 32;
+
+struct offline_branch {
+	std::vector<uint32_t> steps; // plan indices, in plan order
+	std::vector<uint32_t> taps;  // destination input slots fed by the branch
+};
+
+struct offline_partition {
+	uint64_t plan_id = 0;
+	size_t dest_step = 0;
+	std::vector<offline_branch> branches; // empty = render serially
+	// Per destination input slot and quantum of the block: the bus, and its
+	// channel count.
+	std::vector<float> history;
+	std::vector<int> history_ch;
+	float *tap_bus(uint32_t tap, uint32_t q) {
+		return history.data() +
+		       ((size_t)tap * OFFLINE_BLOCK + q) * NX_AUDIO_CHANNELS * Q;
+	}
+};
+
+uint32_t find_root(std::vector<uint32_t> &parent, uint32_t i) {
+	while (parent[i] != i)
+		i = parent[i] = parent[parent[i]];
+	return i;
+}
+
+// Splits `plan` into branches (left empty when there are fewer than two).
+// Runs on the render thread; allocates, which is fine off the real-time path.
+void offline_partition_build(offline_partition *part, nx_audio_graph *g,
+                             const nx_audio_plan *plan) {
+	part->plan_id = plan->id;
+	part->branches.clear();
+	size_t count = plan->order.size();
+	size_t dest = count;
+	for (size_t i = 0; i < count; i++) {
+		if (plan->order[i] == g->destination)
+			dest = i;
+	}
+	if (dest == count)
+		return;
+	part->dest_step = dest;
+	// Union-find over nodes (a split delay has two steps, but one node).
+	std::vector<nx_audio_node *> nodes(plan->order);
+	std::sort(nodes.begin(), nodes.end());
+	nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+	auto node_index = [&](const nx_audio_node *n) {
+		return (uint32_t)(std::lower_bound(nodes.begin(), nodes.end(), n) -
+		                  nodes.begin());
+	};
+	std::vector<uint32_t> parent(nodes.size());
+	for (uint32_t i = 0; i < parent.size(); i++)
+		parent[i] = i;
+	for (size_t i = 0; i < count; i++) {
+		if (i == dest)
+			continue;
+		uint32_t a = find_root(parent, node_index(plan->order[i]));
+		for (uint32_t k = plan->input_start[i]; k < plan->input_start[i + 1];
+		     k++) {
+			const nx_audio_node *src = plan->inputs[k];
+			if (src == g->destination)
+				return; // nothing downstream of the destination may run early
+			uint32_t b = find_root(parent, node_index(src));
+			parent[b] = a;
+		}
+	}
+	std::vector<uint32_t> branch_of(nodes.size(), UINT32_MAX);
+	for (size_t i = 0; i < count; i++) {
+		if (i == dest)
+			continue;
+		uint32_t root = find_root(parent, node_index(plan->order[i]));
+		if (branch_of[root] == UINT32_MAX) {
+			branch_of[root] = (uint32_t)part->branches.size();
+			part->branches.emplace_back();
+		}
+		part->branches[branch_of[root]].steps.push_back((uint32_t)i);
+	}
+	if (part->branches.size() < 2) {
+		part->branches.clear();
+		return;
+	}
+	uint32_t taps = plan->input_start[dest + 1] - plan->input_start[dest];
+	for (uint32_t k = 0; k < taps; k++) {
+		const nx_audio_node *src = plan->inputs[plan->input_start[dest] + k];
+		uint32_t root = find_root(parent, node_index(src));
+		part->branches[branch_of[root]].taps.push_back(k);
+	}
+	// Biggest first, so the last branches to be picked up are short ones.
+	std::stable_sort(part->branches.begin(), part->branches.end(),
+	                 [](const offline_branch &a, const offline_branch &b) {
+		                 return a.steps.size() > b.steps.size();
+	                 });
+	part->history.resize((size_t)taps * OFFLINE_BLOCK * NX_AUDIO_CHANNELS * Q);
+	part->history_ch.resize((size_t)taps * OFFLINE_BLOCK);
+}
+
+// One block of quanta, starting at frame `frames`, for the branches of `part`.
+struct offline_job {
+	nx_audio_graph *g;
+	const nx_audio_plan *plan;
+	offline_partition *part;
+	uint64_t frames;
+	uint32_t quanta;
+	int workers; // pool workers taking part (indices [0, workers))
+	std::atomic<uint32_t> next_branch;
+};
+
+// Worker pool shared by all offline renders. Never destroyed: its workers
+// never exit, and tearing down a condition variable they wait on would block
+// at process exit.
+struct offline_pool_t {
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable idle;
+	offline_job *job = nullptr;
+	uint64_t generation = 0;
+	int busy = 0;         // participating workers still in `job`
+	int worker_count = 0; // workers started (never exit)
+	// Held for the duration of a parallel render: the pool runs one at a
+	// time (a concurrent render falls back to the serial path).
+	std::mutex owner;
+};
+
+offline_pool_t &offline_pool() {
+	static offline_pool_t *pool = new offline_pool_t();
+	return *pool;
+}
+
+void offline_run_branches(offline_job *job) {
+	nx_audio_graph *g = job->g;
+	const nx_audio_plan *plan = job->plan;
+	offline_partition *part = job->part;
+	const nx_audio_node *const *dest_inputs =
+	    plan->inputs.data() + plan->input_start[part->dest_step];
+	for (;;) {
+		uint32_t b = job->next_branch.fetch_add(1, std::memory_order_relaxed);
+		if (b >= part->branches.size())
+			return;
+		const offline_branch &branch = part->branches[b];
+		for (uint32_t q = 0; q < job->quanta; q++) {
+			double t0 =
+			    (double)(job->frames + (uint64_t)q * Q) / g->sample_rate;
+			for (uint32_t i : branch.steps)
+				process_node(g, plan, i, t0);
+			for (uint32_t tap : branch.taps) {
+				const nx_audio_node *src = dest_inputs[tap];
+				memcpy(part->tap_bus(tap, q), src->bus, sizeof(src->bus));
+				part->history_ch[(size_t)tap * OFFLINE_BLOCK + q] = src->bus_ch;
+			}
+		}
+	}
+}
+
+void offline_worker_main(int index) {
+	offline_pool_t &pool = offline_pool();
+	uint64_t seen = 0;
+	std::unique_lock<std::mutex> lock(pool.mutex);
+	for (;;) {
+		pool.wake.wait(lock, [&] { return pool.generation != seen; });
+		seen = pool.generation;
+		offline_job *job = pool.job;
+		// A worker left out of a block may only wake once it is over.
+		if (!job || index >= job->workers)
+			continue;
+		lock.unlock();
+		offline_run_branches(job);
+		lock.lock();
+		if (--pool.busy == 0)
+			pool.idle.notify_one();
+	}
+}
+
+// Renders the branches of one block on the calling thread plus up to
+// `threads - 1` pool workers. Returns once every branch is done.
+void offline_render_block(offline_job *job, int threads) {
+	offline_pool_t &pool = offline_pool();
+	job->next_branch.store(0, std::memory_order_relaxed);
+	job->workers = std::min(threads - 1, (int)job->part->branches.size() - 1);
+	if (job->workers > 0) {
+		std::unique_lock<std::mutex> lock(pool.mutex);
+		while (pool.worker_count < job->workers) {
+			std::thread(offline_worker_main, pool.worker_count).detach();
+			pool.worker_count++;
+		}
+		pool.job = job;
+		pool.busy = job->workers;
+		pool.generation++;
+		pool.wake.notify_all();
+	}
+	offline_run_branches(job);
+	if (job->workers > 0) {
+		std::unique_lock<std::mutex> lock(pool.mutex);
+		pool.idle.wait(lock, [&] { return pool.busy == 0; });
+		pool.job = nullptr;
+	}
+}
+
+// ---------------------------------------------------------------------------
+// Control thread
+// ---------------------------------------------------------------------------
+
+void free_node(nx_audio_node *n) {
+	delete n->buffer;
+	delete n->convolver;
+	delete n;
+}
+
+// Frees what the render thread handed back, and released nodes that no plan
+// it can still be using references.
+void collect_garbage(nx_audio_graph *g) {
+	nx_audio_garbage gb;
+	while (g->garbage.pop(gb)) {
+		delete gb.plan;
+		delete gb.buffer;
+		delete gb.convolver;
+	}
+	uint64_t adopted = g->adopted_plan_id.load(std::memory_order_acquire);
+	auto &dead = g->dead_nodes;
+	dead.erase(std::remove_if(dead.begin(), dead.end(),
+	                          [adopted](const nx_audio_graph::dead_node &d) {
+		                          if (d.plan_id > adopted)
+			                          return false;
+		                          free_node(d.node);
+		                          return true;
+	                          }),
+	           dead.end());
+}
+
+bool is_scheduled_source(const nx_audio_node *n) {
+	return n->type == NX_AUDIO_NODE_BUFFER_SOURCE ||
+	       n->type == NX_AUDIO_NODE_OSCILLATOR ||
+	       (n->type == NX_AUDIO_NODE_STREAM_SOURCE && n->stream_scheduled);
+}
+
+struct plan_builder {
+	nx_audio_plan *plan;
+	std::vector<nx_audio_node *> stack;
+	// Cyclic delays whose read step has been emitted (write step pending).
+	std::vector<nx_audio_node *> delay_writes;
+	bool restart = false;
+};
+
+void plan_emit(plan_builder &b, nx_audio_node *n, nx_audio_plan_step step) {
+	nx_audio_plan *plan = b.plan;
+	plan->input_start.push_back((uint32_t)plan->inputs.size());
+	if (step != NX_AUDIO_STEP_DELAY_READ)
+		for (nx_audio_node *src : n->inputs)
+			if (!src->plan_active)
+				plan->inputs.push_back(src);
+	plan->order.push_back(n);
+	plan->steps.push_back(step);
+}
+
+// Post-order DFS: a node is appended after all of its inputs. An input that
+// is still on the DFS stack closes a cycle. If the cycle goes through a
+// DelayNode, that delay is marked cyclic and the compile restarts (a cyclic
+// delay is emitted as a read step, so the DFS does not follow its inputs).
+// Otherwise the cycle is not legal Web Audio; its closing edge is dropped and
+// it renders as silence.
+void plan_visit(plan_builder &b, nx_audio_node *n) {
+	n->plan_gen = b.plan->id;
+	if (n->delay_cyclic) {
+		plan_emit(b, n, NX_AUDIO_STEP_DELAY_READ);
+		b.delay_writes.push_back(n);
+		return;
+	}
+	n->plan_active = true;
+	b.stack.push_back(n);
+	for (nx_audio_node *src : n->inputs) {
+		if (src->plan_gen != b.plan->id) {
+			plan_visit(b, src);
+		} else if (src->plan_active) {
+			for (size_t k = b.stack.size(); k-- > 0;) {
+				if (b.stack[k]->type == NX_AUDIO_NODE_DELAY) {
+					b.stack[k]->delay_cyclic = true;
+					b.restart = true;
+					break;
+				}
+				if (b.stack[k] == src)
+					break;
+			}
+		}
+		if (b.restart)
+			return;
 	}
-	g->frames_rendered += Q;
+	plan_emit(b, n, NX_AUDIO_STEP_PROCESS);
+	b.stack.pop_back();
+	n->plan_active = false;
+}
+
+// Compiles the current topology into a new plan and hands it to the render
+// thread. Returns the plan id.
+uint64_t publish_plan(nx_audio_graph *g) {
+	for (nx_audio_node *n : g->nodes)
+		n->delay_cyclic = false;
+	nx_audio_plan *plan = nullptr;
+	plan_builder b;
+	do {
+		// Each attempt marks one more delay as cyclic, so this terminates.
+		for (nx_audio_node *n : g->nodes)
+			n->plan_active = false;
+		delete plan;
+		plan = new nx_audio_plan();
+		plan->id = g->next_plan_id++;
+		plan->order.reserve(g->nodes.size());
+		plan->steps.reserve(g->nodes.size());
+		plan->input_start.reserve(g->nodes.size() + 1);
+		b = plan_builder{plan, {}, {}, false};
+		plan_visit(b, g->destination);
+		// Analysers are sinks in their own right: they (and what feeds
+		// them) are processed even when their output goes nowhere.
+		for (nx_audio_node *n : g->nodes)
+			if (!b.restart && n->type == NX_AUDIO_NODE_ANALYSER &&
+			    n->plan_gen != plan->id)
+				plan_visit(b, n);
+		// Cyclic delays are written last; what feeds them may pull in more
+		// nodes (and more cyclic delays).
+		for (size_t k = 0; k < b.delay_writes.size() && !b.restart; k++) {
+			nx_audio_node *d = b.delay_writes[k];
+			for (nx_audio_node *src : d->inputs)
+				if (!b.restart && src->plan_gen != plan->id)
+					plan_visit(b, src);
+			if (!b.restart)
+				plan_emit(b, d, NX_AUDIO_STEP_DELAY_WRITE);
+		}
+	} while (b.restart);
+	// Sources not reachable from the destination still progress through
+	// their schedule (so `ended` fires even for unconnected sources).
+	for (nx_audio_node *n : g->nodes)
+		if (is_scheduled_source(n) && n->plan_gen != plan->id)
+			plan_emit(b, n, NX_AUDIO_STEP_PROCESS);
+	plan->input_start.push_back((uint32_t)plan->inputs.size());
+	// A plan still pending was never seen by the render thread.
+	delete g->pending_plan.exchange(plan, std::memory_order_acq_rel);
+	collect_garbage(g);
+	return plan->id;
+}
+
+void push_command(nx_audio_graph *g, nx_audio_cmd &&c) {
+	g->commands.push(std::move(c));
+	collect_garbage(g);
+}
+
+nx_audio_cmd param_command(nx_audio_node *n, nx_audio_param *p,
+                           nx_audio_cmd_type type) {
+	nx_audio_cmd c;
+	c.type = type;
+	c.node = n;
+	c.param = (int)(p - n->params.data());
+	return c;
 }
 
 void graph_destroy(nx_audio_graph *g) {
+	// No render thread is running: sinks and offline renders hold refs.
+	nx_audio_cmd c;
+	while (g->commands.pop(c)) {
+		delete c.buffer;
+		delete c.convolver;
+	}
+	nx_audio_garbage gb;
+	while (g->garbage.pop(gb)) {
+		delete gb.plan;
+		delete gb.buffer;
+		delete gb.convolver;
+	}
+	delete g->pending_plan.load();
+	delete g->plan;
+	for (auto &d : g->dead_nodes)
+		free_node(d.node);
 	for (nx_audio_node *n : g->nodes)
-		delete n;
+		free_node(n);
 	delete g;
 }
 
+void param_init(nx_audio_param *p, float value, float min_value,
+                float max_value) {
+	p->value = value;
+	p->min_value = min_value;
+	p->max_value = max_value;
+	p->current.store(value, std::memory_order_relaxed);
+}
+
 nx_audio_node *node_new(nx_audio_graph *g, nx_audio_node_type type) {
+	constexpr float MAX = 3.402823466e+38f;
+	// 1200 * log2(FLT_MAX) cents, and 40 * log10(FLT_MAX) dB.
+	constexpr float MAX_DETUNE = 153600.f;
+	constexpr float MAX_GAIN_DB = 1541.27f;
+	const float nyquist = (float)(g->sample_rate / 2);
 	nx_audio_node *n = new nx_audio_node();
 	n->graph = g;
 	n->type = type;
 	zero_bus(n);
 	switch (type) {
-	case NX_AUDIO_NODE_GAIN: {
-		nx_audio_param gain;
-		gain.value = 1.f;
-		n->params.push_back(gain);
+	case NX_AUDIO_NODE_GAIN:
+		n->params = std::vector<nx_audio_param>(1);
+		param_init(&n->params[0], 1.f, -MAX, MAX);
 		break;
-	}
-	case NX_AUDIO_NODE_STEREO_PANNER: {
-		nx_audio_param pan;
-		pan.value = 0.f;
-		pan.min_value = -1.f;
-		pan.max_value = 1.f;
-		n->params.push_back(pan);
+	case NX_AUDIO_NODE_STEREO_PANNER:
+		n->params = std::vector<nx_audio_param>(1);
+		param_init(&n->params[0], 0.f, -1.f, 1.f);
 		break;
-	}
-	case NX_AUDIO_NODE_BUFFER_SOURCE: {
-		nx_audio_param rate;
-		rate.value = 1.f;
-		n->params.push_back(rate);
-		nx_audio_param detune;
-		detune.value = 0.f;
-		n->params.push_back(detune);
+	case NX_AUDIO_NODE_BUFFER_SOURCE:
+		n->params = std::vector<nx_audio_param>(2);
+		param_init(&n->params[0], 1.f, -MAX, MAX); // playbackRate
+		param_init(&n->params[1], 0.f, -MAX, MAX); // detune
+		break;
+	case NX_AUDIO_NODE_OSCILLATOR:
+		n->params = std::vector<nx_audio_param>(2);
+		param_init(&n->params[0], 440.f, -nyquist, nyquist); // frequency
+		param_init(&n->params[1], 0.f, -MAX_DETUNE, MAX_DETUNE);
+		n->wave = nx_audio_periodic_wave_basic(NX_AUDIO_OSCILLATOR_SINE);
+		break;
+	case NX_AUDIO_NODE_BIQUAD_FILTER:
+		n->params = std::vector<nx_audio_param>(4);
+		param_init(&n->params[0], 350.f, 0.f, nyquist); // frequency
+		param_init(&n->params[1], 0.f, -MAX_DETUNE, MAX_DETUNE);
+		param_init(&n->params[2], 1.f, -MAX, MAX);           // Q
+		param_init(&n->params[3], 0.f, -MAX, MAX_GAIN_DB);   // gain
+		break;
+	case NX_AUDIO_NODE_DELAY:
+		n->params = std::vector<nx_audio_param>(1);
+		param_init(&n->params[0], 0.f, 0.f, 0.f); // see nx_audio_delay_create()
 		break;
-	}
 	case NX_AUDIO_NODE_STREAM_SOURCE: {
 		// One second of buffering at the graph rate.
 		n->stream_capacity = (uint32_t)g->sample_rate;
@@ -425,6 +1539,24 @@ nx_audio_node *node_new(nx_audio_graph *g, nx_audio_node_type type) {
 		    (size_t)n->stream_capacity * NX_AUDIO_CHANNELS);
 		break;
 	}
+	case NX_AUDIO_NODE_ANALYSER:
+		n->analyser = std::make_unique<nx_audio_analyser>();
+		break;
+	case NX_AUDIO_NODE_CONVOLVER:
+		break;
+	case NX_AUDIO_NODE_DYNAMICS_COMPRESSOR:
+		n->params = std::vector<nx_audio_param>(5);
+		param_init(&n->params[0], -24.f, -100.f, 0.f); // threshold
+		param_init(&n->params[1], 30.f, 0.f, 40.f);    // knee
+		param_init(&n->params[2], 12.f, 1.f, 20.f);    // ratio
+		param_init(&n->params[3], 0.003f, 0.f, 1.f);   // attack
+		param_init(&n->params[4], 0.25f, 0.f, 1.f);    // release
+		// 6 ms of look-ahead, like browsers.
+		n->compressor_delay =
+		    std::max<uint32_t>(1, (uint32_t)lrint(0.006 * g->sample_rate));
+		n->compressor_line = std::make_unique<float[]>(
+		    (size_t)n->compressor_delay * NX_AUDIO_CHANNELS);
+		break;
 	case NX_AUDIO_NODE_DESTINATION:
 		break;
 	}
@@ -432,16 +1564,77 @@ nx_audio_node *node_new(nx_audio_graph *g, nx_audio_node_type type) {
 	return n;
 }
 
+// Copies the `count` most recent analyser samples into `out`. The render
+// thread keeps writing meanwhile; the copy is retried if it may have lapped
+// the range being read (practically never: the ring holds twice the largest
+// FFT).
+void analyser_snapshot(nx_audio_analyser *a, float *out, uint32_t count) {
+	constexpr uint64_t RING = NX_AUDIO_ANALYSER_RING;
+	for (;;) {
+		uint64_t end = a->write_pos.load(std::memory_order_acquire);
+		// Before the first `count` samples, the ring is still zeroed.
+		uint64_t start = end - count;
+		uint32_t idx = (uint32_t)(start % RING);
+		uint32_t first = (uint32_t)std::min<uint64_t>(count, RING - idx);
+		memcpy(out, a->ring + idx, sizeof(float) * first);
+		memcpy(out + first, a->ring, sizeof(float) * (count - first));
+		std::atomic_thread_fence(std::memory_order_acquire);
+		uint64_t now = a->write_pos.load(std::memory_order_relaxed);
+		// The writer may also be filling [now, now + Q) before publishing it.
+		if (now - end + NX_AUDIO_RENDER_QUANTUM <= RING - count)
+			return;
+	}
+}
+
+// Updates the smoothed magnitude spectrum, unless nothing was rendered since
+// the last update with the same FFT size.
+void analyser_spectrum(nx_audio_analyser *a, uint32_t fft_size,
+                       double smoothing) {
+	if (a->fft.size != fft_size) {
+		nx_audio_rfft_init(&a->fft, fft_size);
+		a->window.resize(fft_size);
+		constexpr double TWO_PI = 6.28318530717958647692;
+		for (uint32_t i = 0; i < fft_size; i++) {
+			double x = TWO_PI * i / fft_size;
+			a->window[i] = (float)(0.42 - 0.5 * cos(x) + 0.08 * cos(2 * x));
+		}
+		a->samples.resize(fft_size);
+		a->re.resize(fft_size / 2 + 1);
+		a->im.resize(fft_size / 2 + 1);
+		a->smoothed.assign(fft_size / 2, 0.f);
+		a->spectrum_pos = UINT64_MAX;
+	}
+	uint64_t pos = a->write_pos.load(std::memory_order_acquire);
+	if (pos == a->spectrum_pos)
+		return;
+	a->spectrum_pos = pos;
+	float *samples = a->samples.data();
+	analyser_snapshot(a, samples, fft_size);
+	nx_audio_mul(samples, samples, a->window.data(), fft_size);
+	float *re = a->re.data(), *im = a->im.data();
+	nx_audio_rfft_forward(&a->fft, samples, re, im);
+	const float scale = 1.f / fft_size;
+	const float k = (float)smoothing;
+	float *smoothed = a->smoothed.data();
+	for (uint32_t i = 0; i < fft_size / 2; i++) {
+		float mag = sqrtf(re[i] * re[i] + im[i] * im[i]) * scale;
+		float v = k * smoothed[i] + (1 - k) * mag;
+		smoothed[i] = isfinite(v) ? v : 0.f;
+	}
+}
+
 } // namespace
 
 // ---------------------------------------------------------------------------
-// Public API (all functions lock the graph mutex)
+// Public API. Everything except the stream producer functions and the render
+// entrypoints runs on the control thread.
 // ---------------------------------------------------------------------------
 
 nx_audio_graph *nx_audio_graph_create(double sample_rate) {
 	nx_audio_graph *g = new nx_audio_graph();
 	g->sample_rate = sample_rate;
 	g->destination = node_new(g, NX_AUDIO_NODE_DESTINATION);
+	publish_plan(g);
 	return g;
 }
 
@@ -453,56 +1646,80 @@ void nx_audio_graph_unref(nx_audio_graph *g) {
 }
 
 double nx_audio_graph_current_time(nx_audio_graph *g) {
-	std::lock_guard<std::mutex> lock(g->mutex);
-	return (double)g->frames_rendered / g->sample_rate;
+	return graph_time(g);
 }
 
 void nx_audio_graph_set_suspended(nx_audio_graph *g, bool suspended) {
-	std::lock_guard<std::mutex> lock(g->mutex);
-	g->suspended = suspended;
+	g->suspended.store(suspended, std::memory_order_relaxed);
+}
+
+void nx_audio_graph_stats(nx_audio_graph *g, nx_audio_render_stats *out) {
+	collect_garbage(g);
+	out->quanta = g->stat_quanta.load(std::memory_order_relaxed);
+	out->glitches = g->stat_glitches.load(std::memory_order_relaxed);
+	out->plan_swaps = g->stat_plan_swaps.load(std::memory_order_relaxed);
+	out->commands = g->stat_commands.load(std::memory_order_relaxed);
+	uint64_t ns = g->stat_render_ns.load(std::memory_order_relaxed);
+	out->render_avg_us =
+	    out->quanta ? (double)ns / (double)out->quanta / 1000.0 : 0;
+	out->render_max_us =
+	    (double)g->stat_render_max_ns.load(std::memory_order_relaxed) / 1000.0;
 }
 
 nx_audio_node *nx_audio_node_create(nx_audio_graph *g,
                                     nx_audio_node_type type) {
 	nx_audio_graph_ref(g);
-	std::lock_guard<std::mutex> lock(g->mutex);
-	return node_new(g, type);
+	nx_audio_node *n = node_new(g, type);
+	if (is_scheduled_source(n))
+		publish_plan(g); // processed even while unconnected
+	return n;
+}
+
+nx_audio_node *nx_audio_delay_create(nx_audio_graph *g,
+                                     double max_delay_time) {
+	nx_audio_graph_ref(g);
+	nx_audio_node *n = node_new(g, NX_AUDIO_NODE_DELAY);
+	n->params[0].max_value = (float)max_delay_time;
+	// Room for the longest delay, plus the quantum being written and the
+	// interpolation neighbour.
+	n->delay_size = (uint32_t)ceil(max_delay_time * g->sample_rate) + Q + 2;
+	n->delay_line = std::make_unique<float[]>((size_t)n->delay_size *
+	                                          NX_AUDIO_CHANNELS);
+	return n;
 }
 
 void nx_audio_node_release(nx_audio_node *n) {
 	nx_audio_graph *g = n->graph;
-	{
-		std::lock_guard<std::mutex> lock(g->mutex);
-		if (n->type != NX_AUDIO_NODE_DESTINATION) {
-			for (nx_audio_node *src : n->inputs)
-				src->outputs.erase(std::remove(src->outputs.begin(),
-				                               src->outputs.end(), n),
-				                   src->outputs.end());
-			for (nx_audio_node *dst : n->outputs)
-				dst->inputs.erase(
-				    std::remove(dst->inputs.begin(), dst->inputs.end(), n),
-				    dst->inputs.end());
-			g->nodes.erase(std::remove(g->nodes.begin(), g->nodes.end(), n),
-			               g->nodes.end());
-			delete n;
-		}
-		// The destination node is graph-owned; only the ref is dropped.
+	if (n->type != NX_AUDIO_NODE_DESTINATION) {
+		for (nx_audio_node *src : n->inputs)
+			src->outputs.erase(
+			    std::remove(src->outputs.begin(), src->outputs.end(), n),
+			    src->outputs.end());
+		for (nx_audio_node *dst : n->outputs)
+			dst->inputs.erase(
+			    std::remove(dst->inputs.begin(), dst->inputs.end(), n),
+			    dst->inputs.end());
+		g->nodes.erase(std::remove(g->nodes.begin(), g->nodes.end(), n),
+		               g->nodes.end());
+		// The render thread may still be using a plan that references the
+		// node; it is freed once the plan excluding it has been adopted.
+		g->dead_nodes.push_back({n, publish_plan(g)});
 	}
+	// The destination node is graph-owned; only the ref is dropped.
 	nx_audio_graph_unref(g);
 }
 
 void nx_audio_node_connect(nx_audio_node *src, nx_audio_node *dst) {
-	std::lock_guard<std::mutex> lock(src->graph->mutex);
 	// Idempotent: multiple connections between the same nodes collapse.
 	if (std::find(dst->inputs.begin(), dst->inputs.end(), src) !=
 	    dst->inputs.end())
 		return;
 	dst->inputs.push_back(src);
 	src->outputs.push_back(dst);
+	publish_plan(src->graph);
 }
 
 void nx_audio_node_disconnect(nx_audio_node *src, nx_audio_node *dst) {
-	std::lock_guard<std::mutex> lock(src->graph->mutex);
 	if (dst) {
 		dst->inputs.erase(
 		    std::remove(dst->inputs.begin(), dst->inputs.end(), src),
@@ -517,6 +1734,7 @@ void nx_audio_node_disconnect(nx_audio_node *src, nx_audio_node *dst) {
 			    d->inputs.end());
 		src->outputs.clear();
 	}
+	publish_plan(src->graph);
 }
 
 nx_audio_param *nx_audio_node_param(nx_audio_node *n, int index) {
@@ -526,102 +1744,195 @@ nx_audio_param *nx_audio_node_param(nx_audio_node *n, int index) {
 }
 
 float nx_audio_param_value(nx_audio_node *n, nx_audio_param *p) {
-	std::lock_guard<std::mutex> lock(n->graph->mutex);
-	double t = (double)n->graph->frames_rendered / n->graph->sample_rate;
-	return param_value_at(p, t);
+	(void)n;
+	return p->current.load(std::memory_order_relaxed);
 }
 
 void nx_audio_param_set_value(nx_audio_node *n, nx_audio_param *p,
                               float value) {
-	std::lock_guard<std::mutex> lock(n->graph->mutex);
-	p->value = value;
-	if (!p->events.empty()) {
-		// Per spec, setting .value with scheduled automation behaves like
-		// setValueAtTime(value, currentTime).
-		double t = (double)n->graph->frames_rendered / n->graph->sample_rate;
-		nx_audio_param_event e = {};
-		e.type = NX_AUDIO_PARAM_SET_VALUE;
-		e.time = t;
-		e.value = value;
-		param_insert_event(p, std::move(e));
-	}
+	p->current.store(value, std::memory_order_relaxed);
+	nx_audio_cmd c = param_command(n, p, NX_AUDIO_CMD_PARAM_SET_VALUE);
+	c.a = value;
+	push_command(n->graph, std::move(c));
 }
 
 void nx_audio_param_schedule(nx_audio_node *n, nx_audio_param *p,
                              nx_audio_param_event_type type, double time,
                              float value, double time_constant) {
-	std::lock_guard<std::mutex> lock(n->graph->mutex);
-	nx_audio_param_event e = {};
-	e.type = type;
-	e.time = time;
-	e.value = value;
-	e.time_constant = time_constant;
-	param_insert_event(p, std::move(e));
+	nx_audio_cmd c = param_command(n, p, NX_AUDIO_CMD_PARAM_EVENT);
+	c.event.type = type;
+	c.event.time = time;
+	c.event.value = value;
+	c.event.time_constant = time_constant;
+	push_command(n->graph, std::move(c));
 }
 
 void nx_audio_param_set_value_curve(nx_audio_node *n, nx_audio_param *p,
                                     const float *curve, size_t len,
                                     double start_time, double duration) {
-	std::lock_guard<std::mutex> lock(n->graph->mutex);
-	nx_audio_param_event e = {};
-	e.type = NX_AUDIO_PARAM_SET_VALUE_CURVE;
-	e.time = start_time;
-	e.duration = duration;
-	e.curve.assign(curve, curve + len);
-	param_insert_event(p, std::move(e));
+	nx_audio_cmd c = param_command(n, p, NX_AUDIO_CMD_PARAM_EVENT);
+	c.event.type = NX_AUDIO_PARAM_SET_VALUE_CURVE;
+	c.event.time = start_time;
+	c.event.duration = duration;
+	c.event.curve.assign(curve, curve + len);
+	push_command(n->graph, std::move(c));
 }
 
 void nx_audio_param_cancel(nx_audio_node *n, nx_audio_param *p, double time) {
-	std::lock_guard<std::mutex> lock(n->graph->mutex);
-	p->events.erase(std::remove_if(p->events.begin(), p->events.end(),
-	                               [time](const nx_audio_param_event &e) {
-		                               return e.time >= time;
-	                               }),
-	                p->events.end());
+	nx_audio_cmd c = param_command(n, p, NX_AUDIO_CMD_PARAM_CANCEL);
+	c.a = time;
+	push_command(n->graph, std::move(c));
 }
 
-void nx_audio_source_set_buffer(nx_audio_node *n, const float *const *channels,
+void nx_audio_source_set_buffer(nx_audio_node *n, const void *const *channels,
                                 int num_channels, uint32_t length,
-                                double sample_rate,
+                                double sample_rate, bool s16,
                                 std::vector<std::shared_ptr<void>> holds) {
-	std::lock_guard<std::mutex> lock(n->graph->mutex);
-	n->buffer_channels.assign(channels, channels + num_channels);
-	n->buffer_holds = std::move(holds);
-	n->buffer_length = length;
-	n->buffer_sample_rate = sample_rate;
+	nx_audio_cmd c;
+	c.type = NX_AUDIO_CMD_SOURCE_BUFFER;
+	c.node = n;
+	c.buffer = new nx_audio_source_buffer();
+	c.buffer->channels.assign(channels, channels + num_channels);
+	c.buffer->s16 = s16;
+	c.buffer->holds = std::move(holds);
+	c.buffer->length = length;
+	c.buffer->sample_rate = sample_rate;
+	push_command(n->graph, std::move(c));
 }
 
 void nx_audio_source_set_loop(nx_audio_node *n, bool loop, double loop_start,
                               double loop_end) {
-	std::lock_guard<std::mutex> lock(n->graph->mutex);
-	n->loop = loop;
-	n->loop_start = loop_start;
-	n->loop_end = loop_end;
+	nx_audio_cmd c;
+	c.type = NX_AUDIO_CMD_SOURCE_LOOP;
+	c.node = n;
+	c.flag = loop;
+	c.a = loop_start;
+	c.b = loop_end;
+	push_command(n->graph, std::move(c));
 }
 
 void nx_audio_source_start(nx_audio_node *n, double when, double offset,
                            double duration) {
-	std::lock_guard<std::mutex> lock(n->graph->mutex);
-	if (n->started)
+	int state = NX_AUDIO_SOURCE_UNSCHEDULED;
+	if (!n->playback_state.compare_exchange_strong(state,
+	                                               NX_AUDIO_SOURCE_SCHEDULED))
 		return; // JS throws InvalidStateError before reaching here
-	n->started = true;
-	n->playback_state = NX_AUDIO_SOURCE_SCHEDULED;
-	n->start_time = when;
-	n->start_offset = offset;
-	n->duration = duration;
+	nx_audio_cmd c;
+	c.type = NX_AUDIO_CMD_SOURCE_START;
+	c.node = n;
+	c.a = when;
+	c.b = offset;
+	c.c = duration;
+	push_command(n->graph, std::move(c));
 }
 
 void nx_audio_source_stop(nx_audio_node *n, double when) {
-	std::lock_guard<std::mutex> lock(n->graph->mutex);
-	double t = (double)n->graph->frames_rendered / n->graph->sample_rate;
-	if (when < t)
-		when = t;
-	n->stop_time = when;
+	nx_audio_cmd c;
+	c.type = NX_AUDIO_CMD_SOURCE_STOP;
+	c.node = n;
+	c.a = when;
+	push_command(n->graph, std::move(c));
 }
 
 int nx_audio_source_playback_state(nx_audio_node *n) {
-	std::lock_guard<std::mutex> lock(n->graph->mutex);
-	return n->playback_state;
+	return n->playback_state.load(std::memory_order_relaxed);
+}
+
+void nx_audio_oscillator_set_wave(
+    nx_audio_node *n, std::shared_ptr<const nx_audio_periodic_wave> wave) {
+	nx_audio_cmd c;
+	c.type = NX_AUDIO_CMD_OSCILLATOR_WAVE;
+	c.node = n;
+	c.wave = std::move(wave);
+	push_command(n->graph, std::move(c));
+}
+
+void nx_audio_biquad_set_type(nx_audio_node *n, nx_audio_biquad_type type) {
+	nx_audio_cmd c;
+	c.type = NX_AUDIO_CMD_BIQUAD_TYPE;
+	c.node = n;
+	c.a = type;
+	push_command(n->graph, std::move(c));
+}
+
+void nx_audio_biquad_get_frequency_response(nx_audio_node *n,
+                                            nx_audio_biquad_type type,
+                                            const float *frequency_hz,
+                                            float *mag, float *phase,
+                                            size_t count) {
+	double nyquist = n->graph->sample_rate / 2;
+	float freq = nx_audio_param_value(n, &n->params[0]);
+	float detune = nx_audio_param_value(n, &n->params[1]);
+	double f = detune != 0 ? freq * exp2(detune / 1200.0) : freq;
+	nx_audio_biquad_coefs c = nx_audio_biquad_design(
+	    type, f / nyquist, nx_audio_param_value(n, &n->params[2]),
+	    nx_audio_param_value(n, &n->params[3]));
+	for (size_t i = 0; i < count; i++)
+		nx_audio_biquad_response(c, frequency_hz[i] / nyquist, &mag[i],
+		                         &phase[i]);
+}
+
+void nx_audio_analyser_float_time_data(nx_audio_node *n, uint32_t fft_size,
+                                       float *out, uint32_t count) {
+	nx_audio_analyser *a = n->analyser.get();
+	if (count >= fft_size) {
+		analyser_snapshot(a, out, fft_size);
+		return;
+	}
+	// The first `count` of the most recent `fft_size` samples (`samples` is
+	// just scratch between spectrum updates).
+	a->samples.resize(std::max<size_t>(a->samples.size(), fft_size));
+	analyser_snapshot(a, a->samples.data(), fft_size);
+	memcpy(out, a->samples.data(), sizeof(float) * count);
+}
+
+void nx_audio_analyser_byte_time_data(nx_audio_node *n, uint32_t fft_size,
+                                      uint8_t *out, uint32_t count) {
+	nx_audio_analyser *a = n->analyser.get();
+	count = std::min(count, fft_size);
+	a->samples.resize(std::max<size_t>(a->samples.size(), fft_size));
+	analyser_snapshot(a, a->samples.data(), fft_size);
+	for (uint32_t i = 0; i < count; i++)
+		out[i] = (uint8_t)clampf(floorf(128 * (1 + a->samples[i])), 0, 255);
+}
+
+void nx_audio_analyser_float_frequency_data(nx_audio_node *n,
+                                            uint32_t fft_size,
+                                            double smoothing, float *out,
+                                            uint32_t count) {
+	nx_audio_analyser *a = n->analyser.get();
+	analyser_spectrum(a, fft_size, smoothing);
+	count = std::min(count, fft_size / 2);
+	for (uint32_t i = 0; i < count; i++)
+		out[i] = 20 * log10f(a->smoothed[i]);
+}
+
+void nx_audio_analyser_byte_frequency_data(nx_audio_node *n, uint32_t fft_size,
+                                           double smoothing, double min_db,
+                                           double max_db, uint8_t *out,
+                                           uint32_t count) {
+	nx_audio_analyser *a = n->analyser.get();
+	analyser_spectrum(a, fft_size, smoothing);
+	count = std::min(count, fft_size / 2);
+	const double scale = 255 / (max_db - min_db);
+	for (uint32_t i = 0; i < count; i++) {
+		double db = 20 * log10(a->smoothed[i]);
+		double v = floor(scale * (db - min_db)); // -inf for silence
+		out[i] = (uint8_t)(v < 0 ? 0 : v > 255 ? 255 : v);
+	}
+}
+
+void nx_audio_convolver_set(nx_audio_node *n,
+                            std::unique_ptr<nx_audio_convolver> convolver) {
+	nx_audio_cmd c;
+	c.type = NX_AUDIO_CMD_CONVOLVER;
+	c.node = n;
+	c.convolver = convolver.release();
+	push_command(n->graph, std::move(c));
+}
+
+float nx_audio_compressor_reduction(nx_audio_node *n) {
+	return n->compressor_reduction.load(std::memory_order_relaxed);
 }
 
 uint32_t nx_audio_stream_writable(nx_audio_node *n) {
@@ -660,57 +1971,129 @@ uint64_t nx_audio_stream_consumed(nx_audio_node *n) {
 }
 
 void nx_audio_stream_flush(nx_audio_node *n) {
-	// Producer is parked (decoder contract); empty the ring by advancing the
-	// read position to the write position. Take the graph mutex so this
-	// cannot interleave with a render quantum's read-modify-write.
-	std::lock_guard<std::mutex> lock(n->graph->mutex);
-	n->stream_read_pos.store(
+	// Producer thread: everything written so far is discarded by the render
+	// thread before its next read (stale frames are never played, and the
+	// conservative read position only makes the ring look fuller meanwhile).
+	n->stream_flush_pos.store(
 	    n->stream_write_pos.load(std::memory_order_relaxed),
 	    std::memory_order_release);
 }
 
+nx_audio_node *nx_audio_stream_source_create(nx_audio_graph *g, bool wait) {
+	nx_audio_graph_ref(g);
+	nx_audio_node *n = node_new(g, NX_AUDIO_NODE_STREAM_SOURCE);
+	n->stream_scheduled = true;
+	n->stream_wait = wait;
+	publish_plan(g); // processed even while unconnected
+	return n;
+}
+
+void nx_audio_stream_begin_seek(nx_audio_node *n) {
+	n->stream_seeks.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void nx_audio_stream_end_seek(nx_audio_node *n) {
+	nx_audio_stream_flush(n);
+	n->stream_seeks.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void nx_audio_stream_set_ended(nx_audio_node *n, bool ended) {
+	n->stream_ended.store(ended, std::memory_order_release);
+}
+
 void nx_audio_graph_render_s16(nx_audio_graph *g, int16_t *out,
                                uint32_t frames) {
-	std::lock_guard<std::mutex> lock(g->mutex);
-	if (g->suspended || g->closed) {
+	if (g->suspended.load(std::memory_order_relaxed) ||
+	    g->closed.load(std::memory_order_relaxed)) {
+		// Keep plans and commands flowing (so released nodes can be freed)
+		// without advancing time.
+		render_prologue(g, graph_time(g));
 		memset(out, 0, (size_t)frames * NX_AUDIO_CHANNELS * sizeof(int16_t));
 		return;
 	}
+	uint64_t start = now_ns();
 	uint32_t done = 0;
 	while (done < frames) {
 		render_quantum(g);
 		uint32_t n = frames - done < Q ? frames - done : Q;
-		const float *l = g->destination->bus[0];
-		const float *r = g->destination->bus[1];
-		for (uint32_t i = 0; i < n; i++) {
-			float fl = clampf(l[i], -1.f, 1.f);
-			float fr = clampf(r[i], -1.f, 1.f);
-			out[(done + i) * 2] = (int16_t)lrintf(fl * 32767.f);
-			out[(done + i) * 2 + 1] = (int16_t)lrintf(fr * 32767.f);
-		}
+		nx_audio_to_s16(out + done * 2, g->destination->bus[0],
+		                g->destination->bus[1], n);
 		done += n;
 	}
+	record_render(g, now_ns() - start, frames, true);
 }
 
 void nx_audio_graph_render_offline(nx_audio_graph *g, float *const *channels,
-                                   int num_channels, uint32_t length) {
-	std::lock_guard<std::mutex> lock(g->mutex);
+                                   int num_channels, uint32_t length,
+                                   int threads) {
+	uint64_t start = now_ns();
+	std::unique_lock<std::mutex> pool(offline_pool().owner, std::defer_lock);
+	if (threads > 1 && !pool.try_lock())
+		threads = 1;
+	offline_partition part;
 	uint32_t done = 0;
-	while (done < length) {
-		render_quantum(g);
+	// Copies the destination's quantum out (the last one may be partial).
+	auto emit = [&]() {
 		uint32_t n = length - done < Q ? length - done : Q;
 		const float *l = g->destination->bus[0];
 		const float *r = g->destination->bus[1];
 		if (num_channels == 1) {
 			// Mono destination: speakers downmix = 0.5 * (L + R).
-			for (uint32_t i = 0; i < n; i++)
-				channels[0][done + i] = 0.5f * (l[i] + r[i]);
+			nx_audio_downmix(channels[0] + done, l, r, n);
 		} else {
-			for (uint32_t i = 0; i < n; i++) {
-				channels[0][done + i] = l[i];
-				channels[1][done + i] = r[i];
-			}
+			memcpy(channels[0] + done, l, sizeof(float) * n);
+			memcpy(channels[1] + done, r, sizeof(float) * n);
 		}
 		done += n;
+	};
+	while (done < length) {
+		uint32_t quanta = (length - done + Q - 1) / Q;
+		if (quanta > OFFLINE_BLOCK)
+			quanta = OFFLINE_BLOCK;
+		if (threads > 1) {
+			uint64_t frames =
+			    g->frames_rendered.load(std::memory_order_relaxed);
+			render_prologue(g, (double)frames / g->sample_rate);
+			const nx_audio_plan *plan = g->plan;
+			if (part.plan_id != plan->id)
+				offline_partition_build(&part, g, plan);
+			if (!part.branches.empty()) {
+				offline_job job;
+				job.g = g;
+				job.plan = plan;
+				job.part = &part;
+				job.frames = frames;
+				job.quanta = quanta;
+				offline_render_block(&job, threads);
+				// The merge: restore each destination input's bus for the
+				// quantum, and sum exactly as the serial path does.
+				nx_audio_node *const *dest_inputs =
+				    plan->inputs.data() + plan->input_start[part.dest_step];
+				uint32_t taps = plan->input_start[part.dest_step + 1] -
+				                plan->input_start[part.dest_step];
+				for (uint32_t q = 0; q < quanta; q++) {
+					for (uint32_t tap = 0; tap < taps; tap++) {
+						nx_audio_node *src = dest_inputs[tap];
+						memcpy(src->bus, part.tap_bus(tap, q),
+						       sizeof(src->bus));
+						src->bus_ch =
+						    part.history_ch[(size_t)tap * OFFLINE_BLOCK + q];
+					}
+					process_node(g, plan, part.dest_step,
+					             (double)(frames + (uint64_t)q * Q) /
+					                 g->sample_rate);
+					emit();
+				}
+				g->frames_rendered.store(frames + (uint64_t)quanta * Q,
+				                         std::memory_order_release);
+				g->stat_quanta.fetch_add(quanta, std::memory_order_relaxed);
+				continue;
+			}
+		}
+		for (uint32_t q = 0; q < quanta; q++) {
+			render_quantum(g);
+			emit();
+		}
 	}
+	record_render(g, now_ns() - start, length, false);
 }
@@ -7,15 +7,26 @@
 // and packages/runtime/test/src/audio-sink.cc (host).
 //
 // Threading model: a "control thread" (the JS loop thread, via audio.cc) and a
-// "render thread" (the sink, or a libuv worker for OfflineAudioContext) both
-// touch the graph. Every public function in this header — and the render
-// entrypoints — locks the graph mutex internally. The internal bus format is
-// stereo float32, processed in 128-frame render quanta (like browsers).
+// "render thread" (the sink, or a libuv worker for OfflineAudioContext) share
+// the graph WITHOUT a lock, so rendering never waits on JS:
+//   - Topology (node inputs/outputs) is owned by the control thread. Every
+//     change compiles a flat, topologically sorted render plan, which is
+//     handed to the render thread through an atomic pointer exchange.
+//   - Everything the render thread owns (param timelines, source playback
+//     state) is mutated only by commands, which the control thread pushes
+//     onto a wait-free SPSC queue. The render thread drains that queue at the
+//     start of each quantum.
+//   - What the render thread lets go of (superseded plans, replaced source
+//     buffers) travels back on a second SPSC queue, to be freed on the control
+//     thread. Released nodes are freed once the render thread has adopted a
+//     plan that no longer references them.
+// The internal bus format is stereo float32, processed in 128-frame render
+// quanta (like browsers).
 
+#include "audio-dsp.h"
 #include <atomic>
 #include <math.h>
 #include <memory>
-#include <mutex>
 #include <stddef.h>
 #include <stdint.h>
 #include <vector>
@@ -34,6 +45,13 @@ enum nx_audio_node_type {
 	// the render thread drains a quantum at a time. The consumed-frame
 	// counter is the A/V sync master clock.
 	NX_AUDIO_NODE_STREAM_SOURCE = 4,
+	NX_AUDIO_NODE_OSCILLATOR = 5,
+	NX_AUDIO_NODE_BIQUAD_FILTER = 6,
+	// Created with nx_audio_delay_create() (it needs its maximum delay).
+	NX_AUDIO_NODE_DELAY = 7,
+	NX_AUDIO_NODE_ANALYSER = 8,
+	NX_AUDIO_NODE_CONVOLVER = 9,
+	NX_AUDIO_NODE_DYNAMICS_COMPRESSOR = 10,
 };
 
 // AudioParam automation event types (matches the JS side's wire protocol).
@@ -45,7 +63,7 @@ enum nx_audio_param_event_type {
 	NX_AUDIO_PARAM_SET_VALUE_CURVE = 4,
 };
 
-// AudioBufferSourceNode playback states (polled by JS for `ended` events).
+// Scheduled source (AudioBufferSourceNode / OscillatorNode) playback states (polled by JS for `ended` events).
 enum nx_audio_source_state {
 	NX_AUDIO_SOURCE_UNSCHEDULED = 0,
 	NX_AUDIO_SOURCE_SCHEDULED = 1,
@@ -62,10 +80,196 @@ struct nx_audio_param_event {
 };
 
 struct nx_audio_param {
-	float value = 0.f; // [[current value]] (base when no events apply)
 	float min_value = -3.402823466e+38f;
 	float max_value = 3.402823466e+38f;
+
+	// ---- render thread ----
+	float value = 0.f; // base when no events apply
 	std::vector<nx_audio_param_event> events; // sorted by time
+	// Render cursor. Events before `head` have fully elapsed: their effect is
+	// collapsed into `value` (the anchor a following ramp starts from) at
+	// `anchor_time`. Render time only moves forward, so the cursor does too;
+	// elapsed events are erased in batches (see param_advance()).
+	size_t head = 0;
+	double anchor_time = 0;
+
+	// [[current value]]: published by the render thread (the value at the
+	// start of the last processed quantum) and by the `.value` setter.
+	std::atomic<float> current{0.f};
+};
+
+// Unbounded single-producer / single-consumer queue (Vyukov's node-recycling
+// design). push() and pop() are wait-free; push() only allocates when no
+// consumed node is available for reuse, and pop() never frees, so the
+// consumer side is safe to run on the real-time render thread.
+template <typename T> class nx_audio_spsc_queue {
+	struct node {
+		std::atomic<node *> next{nullptr};
+		T value;
+	};
+	// Consumer side.
+	std::atomic<node *> tail_;
+	// Producer side.
+	node *head_;
+	node *first_;     // oldest node not yet recycled
+	node *tail_copy_; // cached consumer position
+
+	node *alloc_node() {
+		if (first_ != tail_copy_) {
+			node *n = first_;
+			first_ = first_->next.load(std::memory_order_relaxed);
+			return n;
+		}
+		tail_copy_ = tail_.load(std::memory_order_acquire);
+		if (first_ != tail_copy_) {
+			node *n = first_;
+			first_ = first_->next.load(std::memory_order_relaxed);
+			return n;
+		}
+		return new node();
+	}
+
+public:
+	nx_audio_spsc_queue() {
+		node *n = new node();
+		tail_.store(n, std::memory_order_relaxed);
+		head_ = first_ = tail_copy_ = n;
+	}
+	~nx_audio_spsc_queue() {
+		node *n = first_;
+		while (n) {
+			node *next = n->next.load(std::memory_order_relaxed);
+			delete n;
+			n = next;
+		}
+	}
+	nx_audio_spsc_queue(const nx_audio_spsc_queue &) = delete;
+	nx_audio_spsc_queue &operator=(const nx_audio_spsc_queue &) = delete;
+
+	void push(T &&v) {
+		node *n = alloc_node();
+		n->next.store(nullptr, std::memory_order_relaxed);
+		n->value = std::move(v);
+		head_->next.store(n, std::memory_order_release);
+		head_ = n;
+	}
+
+	bool pop(T &out) {
+		node *t = tail_.load(std::memory_order_relaxed);
+		node *n = t->next.load(std::memory_order_acquire);
+		if (!n)
+			return false;
+		out = std::move(n->value);
+		n->value = T();
+		tail_.store(n, std::memory_order_release);
+		return true;
+	}
+};
+
+// AudioBufferSourceNode buffer. Channel data points into externally-owned
+// memory (V8 BackingStores); `holds` keeps that memory alive. The samples are
+// either float, or signed 16-bit (`s16`, converted inside the render kernel).
+struct nx_audio_source_buffer {
+	std::vector<const void *> channels;
+	bool s16 = false;
+	std::vector<std::shared_ptr<void>> holds;
+	uint32_t length = 0; // frames
+	double sample_rate = 0;
+};
+
+// Control -> render thread commands.
+enum nx_audio_cmd_type {
+	NX_AUDIO_CMD_NONE = 0,
+	NX_AUDIO_CMD_PARAM_EVENT,     // event
+	NX_AUDIO_CMD_PARAM_SET_VALUE, // a = value
+	NX_AUDIO_CMD_PARAM_CANCEL,    // a = cancel time
+	NX_AUDIO_CMD_SOURCE_BUFFER,   // buffer (ownership moves to the node)
+	NX_AUDIO_CMD_SOURCE_LOOP,     // flag = loop, a = start, b = end
+	NX_AUDIO_CMD_SOURCE_START,    // a = when, b = offset, c = duration
+	NX_AUDIO_CMD_SOURCE_STOP,     // a = when
+	NX_AUDIO_CMD_OSCILLATOR_WAVE, // wave
+	NX_AUDIO_CMD_BIQUAD_TYPE,     // a = nx_audio_biquad_type
+	NX_AUDIO_CMD_CONVOLVER,       // convolver (ownership moves to the node)
+};
+
+struct nx_audio_node;
+
+struct nx_audio_cmd {
+	nx_audio_cmd_type type = NX_AUDIO_CMD_NONE;
+	nx_audio_node *node = nullptr;
+	int param = 0;
+	bool flag = false;
+	double a = 0, b = 0, c = 0;
+	nx_audio_param_event event = {};
+	nx_audio_source_buffer *buffer = nullptr;
+	std::shared_ptr<const nx_audio_periodic_wave> wave;
+	nx_audio_convolver *convolver = nullptr;
+};
+
+// A compiled render plan: every node that feeds the destination, in
+// topological order (inputs before the nodes they feed; the destination
+// last), followed by sources that are not connected to it (they are still
+// processed so that their schedule advances and `ended` fires).
+// Inputs of `order[i]` are `inputs[input_start[i] .. input_start[i + 1])`.
+//
+// A DelayNode inside a cycle is split in two steps: its output is read from
+// the delay line early (like a source, so the rest of the cycle can use it)
+// and its input is written at the end of the quantum. Such a delay is at
+// least one quantum long, as the spec requires.
+// Plans are immutable once published.
+enum nx_audio_plan_step : uint8_t {
+	NX_AUDIO_STEP_PROCESS = 0,
+	NX_AUDIO_STEP_DELAY_READ = 1,
+	NX_AUDIO_STEP_DELAY_WRITE = 2,
+};
+
+struct nx_audio_plan {
+	uint64_t id = 0;
+	std::vector<nx_audio_node *> order;
+	std::vector<nx_audio_plan_step> steps; // parallel to `order`
+	std::vector<uint32_t> input_start;
+	std::vector<nx_audio_node *> inputs;
+};
+
+// Render thread -> control thread: resources to free off the render thread.
+struct nx_audio_garbage {
+	nx_audio_plan *plan = nullptr;
+	nx_audio_source_buffer *buffer = nullptr;
+	std::shared_ptr<const nx_audio_periodic_wave> wave;
+	nx_audio_convolver *convolver = nullptr;
+};
+
+// Render instrumentation (see nx_audio_graph_stats()).
+struct nx_audio_render_stats {
+	uint64_t quanta;      // render quanta processed
+	uint64_t glitches;    // real-time renders that overran their deadline
+	uint64_t plan_swaps;  // render plans adopted
+	uint64_t commands;    // control commands applied
+	double render_avg_us; // mean render time per quantum
+	double render_max_us; // slowest single render call
+};
+
+// AnalyserNode state. The render thread appends the (mono downmixed) input to
+// a ring of recent samples; the control thread reads the ring on demand, with
+// no lock, and owns everything else (FFT setup, smoothed spectrum).
+#define NX_AUDIO_ANALYSER_MAX_FFT 32768
+#define NX_AUDIO_ANALYSER_RING (NX_AUDIO_ANALYSER_MAX_FFT * 2)
+
+struct nx_audio_analyser {
+	// ---- render thread -> control thread ----
+	float ring[NX_AUDIO_ANALYSER_RING] = {};
+	// Samples written so far (never wrapped); ring index = pos % RING.
+	std::atomic<uint64_t> write_pos{0};
+
+	// ---- control thread ----
+	nx_audio_rfft fft;
+	std::vector<float> window;  // Blackman, fft.size samples
+	std::vector<float> samples; // windowed input (scratch)
+	std::vector<float> re, im;  // spectrum (scratch), fft.size / 2 + 1 bins
+	std::vector<float> smoothed; // fft.size / 2 magnitudes
+	// `write_pos` when `smoothed` was last updated (UINT64_MAX = never), so
+	// that repeated reads within a render quantum do not smooth twice.
+	uint64_t spectrum_pos = UINT64_MAX;
 };
 
 struct nx_audio_graph;
@@ -74,16 +278,20 @@ struct nx_audio_node {
 	nx_audio_graph *graph = nullptr;
 	nx_audio_node_type type;
 
-	// Graph topology. `inputs` are the nodes connected INTO this node;
-	// `outputs` is the reverse mapping (for cleanup on release). Duplicate
-	// connections are collapsed (per spec: multiple connect() calls between
-	// the same nodes are idempotent).
+	// Graph topology (control thread). `inputs` are the nodes connected INTO
+	// this node; `outputs` is the reverse mapping (for cleanup on release).
+	// Duplicate connections are collapsed (per spec: multiple connect() calls
+	// between the same nodes are idempotent). The render thread only sees
+	// the compiled plan.
 	std::vector<nx_audio_node *> inputs;
 	std::vector<nx_audio_node *> outputs;
 
-	// Per-quantum processing state.
-	uint64_t processed_quantum = 0;
-	bool processing = false; // cycle guard
+	// Plan compilation scratch (control thread).
+	uint64_t plan_gen = 0;
+	bool plan_active = false;
+	bool delay_cyclic = false; // DELAY inside a cycle (split read/write)
+
+	// Per-quantum processing state (render thread).
 	float bus[NX_AUDIO_CHANNELS][NX_AUDIO_RENDER_QUANTUM];
 	// Channel count of the bus content: 1 = mono (L==R), 2 = true stereo.
 	// Drives spec-correct mono vs stereo panning behavior.
@@ -93,20 +301,23 @@ struct nx_audio_node {
 	//   GAIN:          0 = gain
 	//   STEREO_PANNER: 0 = pan
 	//   BUFFER_SOURCE: 0 = playbackRate, 1 = detune
+	//   OSCILLATOR:    0 = frequency, 1 = detune
+	//   BIQUAD_FILTER: 0 = frequency, 1 = detune, 2 = Q, 3 = gain
+	//   DELAY:         0 = delayTime
+	//   DYNAMICS_COMPRESSOR: 0 = threshold, 1 = knee, 2 = ratio, 3 = attack,
+	//                        4 = release
+	// Sized once at creation (never reallocated).
 	std::vector<nx_audio_param> params;
 
-	// ---- AudioBufferSourceNode state ----
-	// Channel data points into externally-owned memory (V8 BackingStores);
-	// `buffer_holds` keeps that memory alive for the render thread.
-	std::vector<const float *> buffer_channels;
-	std::vector<std::shared_ptr<void>> buffer_holds;
-	uint32_t buffer_length = 0;   // frames
-	double buffer_sample_rate = 0;
+	// ---- AudioBufferSourceNode state (render thread, set by commands) ----
+	nx_audio_source_buffer *buffer = nullptr; // owned
 	bool loop = false;
 	double loop_start = 0;
 	double loop_end = 0;
-	int playback_state = NX_AUDIO_SOURCE_UNSCHEDULED;
-	bool started = false;       // start() called
+	// Written by the control thread on start() and by the render thread when
+	// playback finishes; polled by JS.
+	std::atomic<int> playback_state{NX_AUDIO_SOURCE_UNSCHEDULED};
+	bool started = false;       // start() applied
 	bool playing = false;       // playhead initialized (first audible quantum)
 	double start_time = 0;      // when (context seconds)
 	double start_offset = 0;    // offset into buffer (seconds)
@@ -115,10 +326,41 @@ struct nx_audio_node {
 	double position = 0;        // playhead, fractional buffer frames
 	double played_frames = 0;   // cumulative buffer frames consumed
 
+	// ---- OscillatorNode state (render thread, set by commands) ----
+	// `started`, the start / stop times and `playback_state` are shared with
+	// the buffer source above.
+	std::shared_ptr<const nx_audio_periodic_wave> wave;
+	double phase = 0; // cycles, [0, 1)
+
+	// ---- BiquadFilterNode state (render thread) ----
+	nx_audio_biquad_type filter_type = NX_AUDIO_BIQUAD_LOWPASS;
+	double biquad_state[NX_AUDIO_CHANNELS][4] = {}; // x1, x2, y1, y2
+
+	// ---- DelayNode state (render thread; the line is sized at creation) ----
+	std::unique_ptr<float[]> delay_line; // planar, delay_size per channel
+	uint32_t delay_size = 0;             // frames
+	uint32_t delay_write = 0;            // next write index
+	int delay_ch = 1;                    // channel count of the input
+
+	// ---- AnalyserNode state (allocated at creation) ----
+	std::unique_ptr<nx_audio_analyser> analyser;
+
+	// ---- ConvolverNode state (render thread, set by commands) ----
+	nx_audio_convolver *convolver = nullptr; // owned; NULL = no buffer
+
+	// ---- DynamicsCompressorNode state (render thread) ----
+	std::unique_ptr<float[]> compressor_line; // planar look-ahead delay line
+	uint32_t compressor_delay = 0;            // look-ahead, frames
+	uint32_t compressor_pos = 0;
+	uint32_t compressor_stereo = 0; // frames of stereo input still delayed
+	double compressor_envelope = 0; // smoothed gain change, dB (<= 0)
+	// `reduction` (dB), written every quantum and polled by JS.
+	std::atomic<float> compressor_reduction{0};
+
 	// ---- stream source state (NX_AUDIO_NODE_STREAM_SOURCE) ----
 	// Lock-free SPSC ring of interleaved stereo f32 frames. The producer
 	// (media decode thread) owns `stream_write_pos`; the consumer (render
-	// thread, under the graph mutex) owns `stream_read_pos`. Positions are
+	// thread) owns `stream_read_pos`. Positions are
 	// absolute frame counters (never wrapped); ring index = pos % capacity.
 	std::unique_ptr<float[]> stream_ring;
 	uint32_t stream_capacity = 0; // frames
@@ -126,18 +368,57 @@ struct nx_audio_node {
 	std::atomic<uint64_t> stream_read_pos{0};
 	// When false the node outputs silence and consumes nothing (pause).
 	std::atomic<bool> stream_playing{false};
+	// Pending flush: the write position to skip ahead to (or UINT64_MAX),
+	// applied by the render thread before its next read.
+	std::atomic<uint64_t> stream_flush_pos{UINT64_MAX};
+	// Scheduled streams (nx_audio_stream_source_create()) play from start()
+	// to stop() like a buffer source, and finish once the producer has ended
+	// the stream and the ring is drained. `stream_playing` is unused.
+	bool stream_scheduled = false;
+	// Offline contexts: the render thread waits for the producer instead of
+	// underrunning, so the result does not depend on decode speed.
+	bool stream_wait = false;
+	// Seeks requested but not yet flushed by the producer. Nothing is read
+	// while one is pending, so frames from before a seek are never played.
+	std::atomic<uint32_t> stream_seeks{0};
+	std::atomic<bool> stream_ended{false};
 };
 
 struct nx_audio_graph {
-	std::mutex mutex;
 	std::atomic<int> refs{1};
 	double sample_rate;
-	uint64_t frames_rendered = 0; // currentTime = frames_rendered / rate
-	uint64_t quantum_id = 0;
-	bool suspended = false;
-	bool closed = false;
+	// currentTime = frames_rendered / rate. Written by the render thread.
+	std::atomic<uint64_t> frames_rendered{0};
+	std::atomic<bool> suspended{false};
+	std::atomic<bool> closed{false};
 	nx_audio_node *destination = nullptr;
+
+	// ---- control thread ----
 	std::vector<nx_audio_node *> nodes; // all live nodes (owned), incl. dest
+	uint64_t next_plan_id = 1;
+	// Released nodes, freed once the render thread adopts `plan_id`.
+	struct dead_node {
+		nx_audio_node *node;
+		uint64_t plan_id;
+	};
+	std::vector<dead_node> dead_nodes;
+
+	// ---- control <-> render hand-off ----
+	std::atomic<nx_audio_plan *> pending_plan{nullptr};
+	std::atomic<uint64_t> adopted_plan_id{0};
+	nx_audio_spsc_queue<nx_audio_cmd> commands;
+	nx_audio_spsc_queue<nx_audio_garbage> garbage;
+
+	// ---- render thread ----
+	nx_audio_plan *plan = nullptr;
+
+	// Instrumentation (written by the render thread).
+	std::atomic<uint64_t> stat_quanta{0};
+	std::atomic<uint64_t> stat_glitches{0};
+	std::atomic<uint64_t> stat_plan_swaps{0};
+	std::atomic<uint64_t> stat_commands{0};
+	std::atomic<uint64_t> stat_render_ns{0};
+	std::atomic<uint64_t> stat_render_max_ns{0};
 };
 
 // ---- graph lifecycle ----
@@ -147,12 +428,16 @@ void nx_audio_graph_unref(nx_audio_graph *g); // frees at 0 (incl. all nodes)
 double nx_audio_graph_current_time(nx_audio_graph *g);
 void nx_audio_graph_set_suspended(nx_audio_graph *g, bool suspended);
 
+void nx_audio_graph_stats(nx_audio_graph *g, nx_audio_render_stats *out);
+
 // ---- nodes ----
 // Creating a node adds a graph ref; releasing it removes the node from the
 // graph (disconnecting both directions) and drops that ref. Releasing the
 // destination node only drops the ref (the node itself is graph-owned).
-// Safe to call from a GC finalizer (locks the mutex; no JS API).
+// Safe to call from a GC finalizer (no JS API).
 nx_audio_node *nx_audio_node_create(nx_audio_graph *g, nx_audio_node_type type);
+// DelayNode with a delay line of `max_delay_time` seconds (0 < max < 180).
+nx_audio_node *nx_audio_delay_create(nx_audio_graph *g, double max_delay_time);
 void nx_audio_node_release(nx_audio_node *n);
 void nx_audio_node_connect(nx_audio_node *src, nx_audio_node *dst);
 // dst == NULL disconnects all outputs.
@@ -161,7 +446,7 @@ void nx_audio_node_disconnect(nx_audio_node *src, nx_audio_node *dst);
 // ---- params ----
 // Returns NULL for an out-of-range index.
 nx_audio_param *nx_audio_node_param(nx_audio_node *n, int index);
-float nx_audio_param_value(nx_audio_node *n, nx_audio_param *p); // at currentTime
+float nx_audio_param_value(nx_audio_node *n, nx_audio_param *p); // [[current value]]
 void nx_audio_param_set_value(nx_audio_node *n, nx_audio_param *p, float value);
 void nx_audio_param_schedule(nx_audio_node *n, nx_audio_param *p,
                              nx_audio_param_event_type type, double time,
@@ -171,10 +456,11 @@ void nx_audio_param_set_value_curve(nx_audio_node *n, nx_audio_param *p,
                                     double start_time, double duration);
 void nx_audio_param_cancel(nx_audio_node *n, nx_audio_param *p, double time);
 
-// ---- buffer source ----
-void nx_audio_source_set_buffer(nx_audio_node *n, const float *const *channels,
+// ---- scheduled sources (buffer source and oscillator) ----
+// `channels` are float samples, or signed 16-bit ones when `s16` is set.
+void nx_audio_source_set_buffer(nx_audio_node *n, const void *const *channels,
                                 int num_channels, uint32_t length,
-                                double sample_rate,
+                                double sample_rate, bool s16,
                                 std::vector<std::shared_ptr<void>> holds);
 void nx_audio_source_set_loop(nx_audio_node *n, bool loop, double loop_start,
                               double loop_end);
@@ -183,6 +469,48 @@ void nx_audio_source_start(nx_audio_node *n, double when, double offset,
 void nx_audio_source_stop(nx_audio_node *n, double when);
 int nx_audio_source_playback_state(nx_audio_node *n);
 
+// ---- oscillator ----
+// The wave is shared (basic types come from nx_audio_periodic_wave_basic()).
+void nx_audio_oscillator_set_wave(
+    nx_audio_node *n, std::shared_ptr<const nx_audio_periodic_wave> wave);
+
+// ---- biquad filter ----
+void nx_audio_biquad_set_type(nx_audio_node *n, nx_audio_biquad_type type);
+// getFrequencyResponse(): evaluated from the params' [[current value]]s.
+void nx_audio_biquad_get_frequency_response(nx_audio_node *n,
+                                            nx_audio_biquad_type type,
+                                            const float *frequency_hz,
+                                            float *mag, float *phase,
+                                            size_t count);
+
+// ---- analyser ----
+// Readouts of the most recent `fft_size` input samples (a power of two in
+// [32, NX_AUDIO_ANALYSER_MAX_FFT]); `count` values are written, at most
+// `fft_size` for time-domain data and `fft_size / 2` for frequency data.
+// Frequency data is the Blackman-windowed spectrum, smoothed over time with
+// `smoothing` (smoothingTimeConstant), in dB or scaled to bytes per the spec.
+void nx_audio_analyser_float_time_data(nx_audio_node *n, uint32_t fft_size,
+                                       float *out, uint32_t count);
+void nx_audio_analyser_byte_time_data(nx_audio_node *n, uint32_t fft_size,
+                                      uint8_t *out, uint32_t count);
+void nx_audio_analyser_float_frequency_data(nx_audio_node *n,
+                                            uint32_t fft_size,
+                                            double smoothing, float *out,
+                                            uint32_t count);
+void nx_audio_analyser_byte_frequency_data(nx_audio_node *n, uint32_t fft_size,
+                                           double smoothing, double min_db,
+                                           double max_db, uint8_t *out,
+                                           uint32_t count);
+
+// ---- convolver ----
+// Replaces the impulse response (NULL = none: the node outputs silence). The
+// new engine starts with an empty history, as after setting `buffer`.
+void nx_audio_convolver_set(nx_audio_node *n,
+                            std::unique_ptr<nx_audio_convolver> convolver);
+
+// ---- dynamics compressor ----
+float nx_audio_compressor_reduction(nx_audio_node *n);
+
 // ---- stream source (producer side; lock-free, single producer thread) ----
 // Number of frames that can currently be written without overwriting.
 uint32_t nx_audio_stream_writable(nx_audio_node *n);
@@ -193,16 +521,37 @@ uint32_t nx_audio_stream_write(nx_audio_node *n, const float *interleaved,
 void nx_audio_stream_set_playing(nx_audio_node *n, bool playing);
 // Total frames consumed by the render thread (the media clock).
 uint64_t nx_audio_stream_consumed(nx_audio_node *n);
-// Discard all buffered frames (seek/flush). The producer thread MUST be
-// parked while this is called.
+// Discard all buffered frames (seek/flush). Called from the producer thread;
+// the render thread skips ahead to the current write position before its
+// next read, so frames written afterwards are kept.
 void nx_audio_stream_flush(nx_audio_node *n);
 
-// ---- rendering (called from sink threads / libuv workers; locks mutex) ----
+// A stream source scheduled with nx_audio_source_start() / _stop(), which is
+// processed even while unconnected (AudioStreamSourceNode). `wait`: see
+// `stream_wait`.
+nx_audio_node *nx_audio_stream_source_create(nx_audio_graph *g, bool wait);
+// Control thread, before asking the producer to seek.
+void nx_audio_stream_begin_seek(nx_audio_node *n);
+// Producer thread: flushes the ring and completes one
+// nx_audio_stream_begin_seek().
+void nx_audio_stream_end_seek(nx_audio_node *n);
+// Producer thread: whether more frames will follow the ones written so far.
+void nx_audio_stream_set_ended(nx_audio_node *n, bool ended);
+
+// ---- rendering (called from sink threads / libuv workers; never blocks) ----
 // Renders `frames` of interleaved stereo s16. When the graph is suspended (or
-// closed), fills with silence WITHOUT advancing currentTime.
+// closed), fills with silence WITHOUT advancing currentTime. A call that takes
+// longer than `frames` of real time counts as a glitch.
 void nx_audio_graph_render_s16(nx_audio_graph *g, int16_t *out,
                                uint32_t frames);
 // OfflineAudioContext rendering: renders `length` frames into `num_channels`
 // planar float buffers (1 = mono downmix, 2 = stereo). Ignores `suspended`.
+// With `threads` > 1, independent branches of the graph (sub-graphs that only
+// meet at the destination) render concurrently on up to that many threads,
+// including the caller; the output is bit-identical to a serial render.
+// Control-thread commands are then applied every 32 quanta instead of every
+// quantum.
+#define NX_AUDIO_OFFLINE_THREADS_AUTO 3
 void nx_audio_graph_render_offline(nx_audio_graph *g, float *const *channels,
-                                   int num_channels, uint32_t length);
+                                   int num_channels, uint32_t length,
+                                   int threads);
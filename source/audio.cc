@@ -95,7 +95,7 @@ void nx_audio_context_new(const FunctionCallbackInfo<Value> &info) {
 			return;
 		}
 	}
-	nx_audio_ctx_t *ctx = new nx_audio_ctx_t{graph, sink};
+	nx_audio_ctx_t *ctx = new nx_audio_ctx_t{graph, sink, offline};
 	Local<Object> obj = nx::NewWrapped(iso);
 	nx::Wrap<nx_audio_ctx_t>(iso, obj, ctx, free_audio_ctx);
 	info.GetReturnValue().Set(obj);
@@ -110,11 +110,9 @@ void nx_audio_context_close(const FunctionCallbackInfo<Value> &info) {
 		nx_audio_sink_detach(ctx->sink);
 		ctx->sink = NULL;
 	}
-	// `closed` is read by render threads under the graph mutex, so the write
-	// must be guarded too (for an online context the sink is already detached
-	// at this point, but an OfflineAudioContext render may be in flight).
-	std::lock_guard<std::mutex> lock(ctx->graph->mutex);
-	ctx->graph->closed = true;
+	// An OfflineAudioContext render may still be in flight; it never blocks
+	// on the control thread, so this is just a flag.
+	ctx->graph->closed.store(true);
 }
 
 void nx_audio_context_suspend(const FunctionCallbackInfo<Value> &info) {
@@ -142,6 +140,39 @@ void nx_audio_context_current_time(const FunctionCallbackInfo<Value> &info) {
 	    Number::New(iso, nx_audio_graph_current_time(ctx->graph)));
 }
 
+// audioContextRenderStats(ctx) -> { quanta, glitches, planSwaps, commands,
+//                                   renderTimeAverage, renderTimeMax }
+void nx_audio_context_render_stats(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	Local<Context> context = iso->GetCurrentContext();
+	nx_audio_ctx_t *ctx = get_ctx(iso, info[0]);
+	if (!ctx)
+		return;
+	nx_audio_render_stats stats;
+	nx_audio_graph_stats(ctx->graph, &stats);
+	Local<Object> result = Object::New(iso);
+	result->Set(context, nx_str(iso, "quanta"),
+	            Number::New(iso, (double)stats.quanta))
+	    .Check();
+	result->Set(context, nx_str(iso, "glitches"),
+	            Number::New(iso, (double)stats.glitches))
+	    .Check();
+	result->Set(context, nx_str(iso, "planSwaps"),
+	            Number::New(iso, (double)stats.plan_swaps))
+	    .Check();
+	result->Set(context, nx_str(iso, "commands"),
+	            Number::New(iso, (double)stats.commands))
+	    .Check();
+	// Milliseconds, like other nx.js timing APIs.
+	result->Set(context, nx_str(iso, "renderTimeAverage"),
+	            Number::New(iso, stats.render_avg_us / 1000.0))
+	    .Check();
+	result->Set(context, nx_str(iso, "renderTimeMax"),
+	            Number::New(iso, stats.render_max_us / 1000.0))
+	    .Check();
+	info.GetReturnValue().Set(result);
+}
+
 // ---------------------------------------------------------------------------
 // Nodes
 // ---------------------------------------------------------------------------
@@ -161,19 +192,31 @@ void nx_audio_context_destination(const FunctionCallbackInfo<Value> &info) {
 	info.GetReturnValue().Set(obj);
 }
 
-// audioNodeNew(ctx, type) -> handle
+// audioNodeNew(ctx, type[, maxDelayTime]) -> handle
 void nx_audio_node_new(const FunctionCallbackInfo<Value> &info) {
 	Isolate *iso = info.GetIsolate();
 	nx_audio_ctx_t *ctx = get_ctx(iso, info[0]);
 	if (!ctx)
 		return;
 	int type = arg_i32(info, 1);
-	if (type < NX_AUDIO_NODE_GAIN || type > NX_AUDIO_NODE_BUFFER_SOURCE) {
+	if (type < NX_AUDIO_NODE_GAIN ||
+	    type > NX_AUDIO_NODE_DYNAMICS_COMPRESSOR ||
+	    type == NX_AUDIO_NODE_STREAM_SOURCE) {
 		nx_throw(iso, "invalid AudioNode type");
 		return;
 	}
-	nx_audio_node *n =
-	    nx_audio_node_create(ctx->graph, (nx_audio_node_type)type);
+	nx_audio_node *n;
+	if (type == NX_AUDIO_NODE_DELAY) {
+		double max_delay_time = arg_f64(info, 2);
+		if (!(max_delay_time > 0 && max_delay_time < 180)) {
+			iso->ThrowException(Exception::RangeError(
+			    nx_str(iso, "maxDelayTime must be between 0 and 180")));
+			return;
+		}
+		n = nx_audio_delay_create(ctx->graph, max_delay_time);
+	} else {
+		n = nx_audio_node_create(ctx->graph, (nx_audio_node_type)type);
+	}
 	Local<Object> obj = nx::NewWrapped(iso);
 	nx::Wrap<nx_audio_node>(iso, obj, n, release_node);
 	info.GetReturnValue().Set(obj);
@@ -294,9 +337,11 @@ void nx_audio_param_cancel_cb(const FunctionCallbackInfo<Value> &info) {
 
 // audioSourceSetBuffer(node, channels: Float32Array[], length, sampleRate)
 //
-// The channel data is NOT copied: the render thread reads the Float32Arrays'
+// The channel data is NOT copied: the render thread reads the typed arrays'
 // backing stores directly (kept alive via shared_ptr<BackingStore>). This is
-// the zero-copy equivalent of the spec's "acquire the content" step.
+// the zero-copy equivalent of the spec's "acquire the content" step. The
+// channels are either all Float32Arrays, or all Int16Arrays (an AudioBuffer
+// with s16 storage), which the render kernel converts as it reads.
 void nx_audio_source_set_buffer_cb(const FunctionCallbackInfo<Value> &info) {
 	Isolate *iso = info.GetIsolate();
 	Local<Context> context = iso->GetCurrentContext();
@@ -304,7 +349,7 @@ void nx_audio_source_set_buffer_cb(const FunctionCallbackInfo<Value> &info) {
 	if (!n)
 		return;
 	if (!info[1]->IsArray()) {
-		nx_throw(iso, "expected array of Float32Array channel data");
+		nx_throw(iso, "expected array of channel data");
 		return;
 	}
 	Local<Array> arr = info[1].As<Array>();
@@ -313,32 +358,35 @@ void nx_audio_source_set_buffer_cb(const FunctionCallbackInfo<Value> &info) {
 		nx_throw(iso, "unsupported number of channels");
 		return;
 	}
-	std::vector<const float *> channels;
+	std::vector<const void *> channels;
 	std::vector<std::shared_ptr<void>> holds;
 	uint32_t length = (uint32_t)arg_f64(info, 2);
+	bool s16 = false;
 	for (uint32_t i = 0; i < num_channels; i++) {
 		Local<Value> v;
 		if (!arr->Get(context, i).ToLocal(&v))
 			return;
-		if (!v->IsFloat32Array()) {
-			nx_throw(iso, "expected Float32Array channel data");
+		if (i == 0)
+			s16 = v->IsInt16Array();
+		if (s16 ? !v->IsInt16Array() : !v->IsFloat32Array()) {
+			nx_throw(iso, "expected Float32Array or Int16Array channel data");
 			return;
 		}
-		Local<Float32Array> ta = v.As<Float32Array>();
+		Local<TypedArray> ta = v.As<TypedArray>();
 		// Never trust the `length` argument beyond what the typed arrays
 		// actually contain — the render thread reads the backing stores
 		// directly, so an oversized `length` would be an OOB read.
-		uint32_t elements = (uint32_t)(ta->ByteLength() / sizeof(float));
+		uint32_t elements = (uint32_t)ta->Length();
 		if (elements < length)
 			length = elements;
 		std::shared_ptr<BackingStore> bs = ta->Buffer()->GetBackingStore();
-		channels.push_back(reinterpret_cast<const float *>(
-		    static_cast<uint8_t *>(bs->Data()) + ta->ByteOffset()));
+		channels.push_back(static_cast<uint8_t *>(bs->Data()) +
+		                   ta->ByteOffset());
 		holds.push_back(std::move(bs));
 	}
 	double sample_rate = arg_f64(info, 3);
 	nx_audio_source_set_buffer(n, channels.data(), (int)num_channels, length,
-	                           sample_rate, std::move(holds));
+	                           sample_rate, s16, std::move(holds));
 }
 
 // audioSourceStart(node, when, offset, duration) — duration < 0 = unlimited
@@ -377,6 +425,390 @@ void nx_audio_source_state_cb(const FunctionCallbackInfo<Value> &info) {
 	    Integer::New(iso, nx_audio_source_playback_state(n)));
 }
 
+// ---------------------------------------------------------------------------
+// OscillatorNode / PeriodicWave
+// ---------------------------------------------------------------------------
+
+// PeriodicWave handles own a reference to the (immutable) wave tables; each
+// oscillator using the wave holds another.
+struct periodic_wave_ref {
+	std::shared_ptr<const nx_audio_periodic_wave> wave;
+};
+
+void free_periodic_wave(periodic_wave_ref *ref) { delete ref; }
+
+// audioPeriodicWaveNew(real: Float32Array, imag: Float32Array,
+//                      disableNormalization) -> handle
+void nx_audio_periodic_wave_new(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	size_t real_size = 0, imag_size = 0;
+	uint8_t *real = NX_GetBufferSource(iso, &real_size, info[0]);
+	uint8_t *imag = real ? NX_GetBufferSource(iso, &imag_size, info[1]) : NULL;
+	if (!real || !imag || real_size != imag_size) {
+		nx_throw(iso, "expected Float32Array coefficients of equal length");
+		return;
+	}
+	periodic_wave_ref *ref = new periodic_wave_ref();
+	ref->wave = nx_audio_periodic_wave_create(
+	    (const float *)real, (const float *)imag, real_size / sizeof(float),
+	    info[2]->BooleanValue(iso));
+	Local<Object> obj = nx::NewWrapped(iso);
+	nx::Wrap<periodic_wave_ref>(iso, obj, ref, free_periodic_wave);
+	info.GetReturnValue().Set(obj);
+}
+
+// audioOscillatorSetType(node, type) — basic waveforms only
+void nx_audio_oscillator_set_type_cb(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	nx_audio_node *n = get_node(iso, info[0]);
+	if (!n)
+		return;
+	std::shared_ptr<const nx_audio_periodic_wave> wave =
+	    nx_audio_periodic_wave_basic((nx_audio_oscillator_type)arg_i32(info, 1));
+	if (!wave) {
+		nx_throw(iso, "invalid OscillatorNode type");
+		return;
+	}
+	nx_audio_oscillator_set_wave(n, std::move(wave));
+}
+
+// audioOscillatorSetPeriodicWave(node, wave)
+void nx_audio_oscillator_set_periodic_wave_cb(
+    const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	nx_audio_node *n = get_node(iso, info[0]);
+	if (!n)
+		return;
+	periodic_wave_ref *ref = nx::Unwrap<periodic_wave_ref>(info[1]);
+	if (!ref) {
+		nx_throw(iso, "expected PeriodicWave handle");
+		return;
+	}
+	nx_audio_oscillator_set_wave(n, ref->wave);
+}
+
+// ---------------------------------------------------------------------------
+// BiquadFilterNode
+// ---------------------------------------------------------------------------
+
+nx_audio_biquad_type arg_biquad_type(Isolate *iso,
+                                     const FunctionCallbackInfo<Value> &info,
+                                     int i, bool *ok) {
+	int type = arg_i32(info, i);
+	*ok = type >= NX_AUDIO_BIQUAD_LOWPASS && type <= NX_AUDIO_BIQUAD_ALLPASS;
+	if (!*ok)
+		nx_throw(iso, "invalid BiquadFilterNode type");
+	return (nx_audio_biquad_type)type;
+}
+
+void nx_audio_biquad_set_type_cb(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	nx_audio_node *n = get_node(iso, info[0]);
+	if (!n)
+		return;
+	bool ok;
+	nx_audio_biquad_type type = arg_biquad_type(iso, info, 1, &ok);
+	if (ok)
+		nx_audio_biquad_set_type(n, type);
+}
+
+// audioBiquadGetFrequencyResponse(node, type, frequencyHz, magResponse,
+//                                 phaseResponse) — equal-length Float32Arrays
+void nx_audio_biquad_get_frequency_response_cb(
+    const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	nx_audio_node *n = get_node(iso, info[0]);
+	if (!n)
+		return;
+	bool ok;
+	nx_audio_biquad_type type = arg_biquad_type(iso, info, 1, &ok);
+	if (!ok)
+		return;
+	size_t hz_size = 0, mag_size = 0, phase_size = 0;
+	uint8_t *hz = NX_GetBufferSource(iso, &hz_size, info[2]);
+	uint8_t *mag = hz ? NX_GetBufferSource(iso, &mag_size, info[3]) : NULL;
+	uint8_t *phase = mag ? NX_GetBufferSource(iso, &phase_size, info[4]) : NULL;
+	if (!phase || mag_size != hz_size || phase_size != hz_size) {
+		nx_throw(iso, "expected Float32Arrays of equal length");
+		return;
+	}
+	nx_audio_biquad_get_frequency_response(n, type, (const float *)hz,
+	                                       (float *)mag, (float *)phase,
+	                                       hz_size / sizeof(float));
+}
+
+// ---------------------------------------------------------------------------
+// AnalyserNode (readouts run on the JS thread, without blocking rendering)
+// ---------------------------------------------------------------------------
+
+// Unwraps an AnalyserNode handle and validates its fftSize argument.
+nx_audio_node *get_analyser(Isolate *iso,
+                            const FunctionCallbackInfo<Value> &info,
+                            uint32_t *fft_size) {
+	nx_audio_node *n = get_node(iso, info[0]);
+	if (!n)
+		return nullptr;
+	if (n->type != NX_AUDIO_NODE_ANALYSER) {
+		nx_throw(iso, "expected AnalyserNode handle");
+		return nullptr;
+	}
+	int size = arg_i32(info, 1);
+	if (size < 32 || size > NX_AUDIO_ANALYSER_MAX_FFT || (size & (size - 1))) {
+		iso->ThrowException(Exception::RangeError(
+		    nx_str(iso, "fftSize must be a power of 2 between 32 and 32768")));
+		return nullptr;
+	}
+	*fft_size = (uint32_t)size;
+	return n;
+}
+
+// audioAnalyserGetFloatTimeDomainData(node, fftSize, Float32Array)
+void nx_audio_analyser_float_time_cb(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	uint32_t fft_size;
+	nx_audio_node *n = get_analyser(iso, info, &fft_size);
+	if (!n)
+		return;
+	size_t size = 0;
+	uint8_t *out = NX_GetBufferSource(iso, &size, info[2]);
+	if (!out) {
+		nx_throw(iso, "expected Float32Array");
+		return;
+	}
+	nx_audio_analyser_float_time_data(n, fft_size, (float *)out,
+	                                  (uint32_t)(size / sizeof(float)));
+}
+
+// audioAnalyserGetByteTimeDomainData(node, fftSize, Uint8Array)
+void nx_audio_analyser_byte_time_cb(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	uint32_t fft_size;
+	nx_audio_node *n = get_analyser(iso, info, &fft_size);
+	if (!n)
+		return;
+	size_t size = 0;
+	uint8_t *out = NX_GetBufferSource(iso, &size, info[2]);
+	if (!out) {
+		nx_throw(iso, "expected Uint8Array");
+		return;
+	}
+	nx_audio_analyser_byte_time_data(n, fft_size, out, (uint32_t)size);
+}
+
+// audioAnalyserGetFloatFrequencyData(node, fftSize, smoothing, Float32Array)
+void nx_audio_analyser_float_frequency_cb(
+    const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	uint32_t fft_size;
+	nx_audio_node *n = get_analyser(iso, info, &fft_size);
+	if (!n)
+		return;
+	size_t size = 0;
+	uint8_t *out = NX_GetBufferSource(iso, &size, info[3]);
+	if (!out) {
+		nx_throw(iso, "expected Float32Array");
+		return;
+	}
+	nx_audio_analyser_float_frequency_data(n, fft_size, arg_f64(info, 2),
+	                                       (float *)out,
+	                                       (uint32_t)(size / sizeof(float)));
+}
+
+// audioAnalyserGetByteFrequencyData(node, fftSize, smoothing, minDecibels,
+//                                   maxDecibels, Uint8Array)
+void nx_audio_analyser_byte_frequency_cb(
+    const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	uint32_t fft_size;
+	nx_audio_node *n = get_analyser(iso, info, &fft_size);
+	if (!n)
+		return;
+	size_t size = 0;
+	uint8_t *out = NX_GetBufferSource(iso, &size, info[5]);
+	if (!out) {
+		nx_throw(iso, "expected Uint8Array");
+		return;
+	}
+	nx_audio_analyser_byte_frequency_data(n, fft_size, arg_f64(info, 2),
+	                                      arg_f64(info, 3), arg_f64(info, 4),
+	                                      out, (uint32_t)size);
+}
+
+// ---------------------------------------------------------------------------
+// ConvolverNode / DynamicsCompressorNode
+// ---------------------------------------------------------------------------
+
+// audioConvolverSetBuffer(node, channels: Float32Array[] | null, length,
+//                         sampleRate, normalize)
+//
+// Unlike audioSourceSetBuffer(), the channel data is only read here: the
+// impulse response is transformed into its partition spectra right away, and
+// the engine is handed over to the render thread.
+void nx_audio_convolver_set_buffer_cb(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	Local<Context> context = iso->GetCurrentContext();
+	nx_audio_node *n = get_node(iso, info[0]);
+	if (!n)
+		return;
+	if (n->type != NX_AUDIO_NODE_CONVOLVER) {
+		nx_throw(iso, "expected ConvolverNode handle");
+		return;
+	}
+	if (info[1]->IsNullOrUndefined()) {
+		nx_audio_convolver_set(n, nullptr);
+		return;
+	}
+	if (!info[1]->IsArray()) {
+		nx_throw(iso, "expected array of Float32Array channel data");
+		return;
+	}
+	Local<Array> arr = info[1].As<Array>();
+	uint32_t num_channels = arr->Length();
+	if (num_channels != 1 && num_channels != 2 && num_channels != 4) {
+		nx_throw(iso, "unsupported number of channels");
+		return;
+	}
+	const float *channels[4];
+	uint32_t length = (uint32_t)arg_f64(info, 2);
+	for (uint32_t i = 0; i < num_channels; i++) {
+		Local<Value> v;
+		if (!arr->Get(context, i).ToLocal(&v))
+			return;
+		if (!v->IsFloat32Array()) {
+			nx_throw(iso, "expected Float32Array channel data");
+			return;
+		}
+		Local<Float32Array> ta = v.As<Float32Array>();
+		uint32_t elements = (uint32_t)(ta->ByteLength() / sizeof(float));
+		if (elements < length)
+			length = elements;
+		channels[i] = reinterpret_cast<const float *>(
+		    static_cast<uint8_t *>(ta->Buffer()->Data()) + ta->ByteOffset());
+	}
+	float scale = 1;
+	if (info[4]->BooleanValue(iso))
+		scale = nx_audio_convolver_normalization(channels, (int)num_channels,
+		                                         length, arg_f64(info, 3));
+	nx_audio_convolver_set(n, nx_audio_convolver_create(
+	                              channels, (int)num_channels, length, scale));
+}
+
+// audioCompressorReduction(node) -> dB
+void nx_audio_compressor_reduction_cb(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	nx_audio_node *n = get_node(iso, info[0]);
+	if (!n)
+		return;
+	info.GetReturnValue().Set(nx_audio_compressor_reduction(n));
+}
+
+// ---------------------------------------------------------------------------
+// AudioStreamSourceNode
+// ---------------------------------------------------------------------------
+
+// The stream handle owns both the decoder and the node: the node is released
+// only after the decode thread has joined, so the producer can never touch a
+// freed node.
+struct stream_source_t {
+	nx_media_stream_t *stream;
+	nx_audio_node *node;
+};
+
+void free_stream_source(stream_source_t *s) {
+	nx_media_stream_destroy(s->stream);
+	nx_audio_node_release(s->node);
+	delete s;
+}
+
+stream_source_t *get_stream(Isolate *iso, Local<Value> v) {
+	stream_source_t *s = nx::Unwrap<stream_source_t>(v);
+	if (!s)
+		nx_throw(iso, "expected AudioStreamSourceNode handle");
+	return s;
+}
+
+// audioStreamSourceNew(ctx, data, loop, loopStart, loopEnd) -> [node, stream]
+//
+// The node wrapper has NO finalizer (see stream_source_t); the JS node keeps
+// both handles alive together. The compressed bytes are NOT copied.
+void nx_audio_stream_source_new(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	Local<Context> context = iso->GetCurrentContext();
+	nx_audio_ctx_t *ctx = get_ctx(iso, info[0]);
+	if (!ctx)
+		return;
+	std::shared_ptr<BackingStore> bs;
+	size_t offset = 0, size = 0;
+	if (info[1]->IsArrayBuffer()) {
+		bs = info[1].As<ArrayBuffer>()->GetBackingStore();
+		size = bs->ByteLength();
+	} else if (info[1]->IsArrayBufferView()) {
+		Local<ArrayBufferView> view = info[1].As<ArrayBufferView>();
+		bs = view->Buffer()->GetBackingStore();
+		offset = view->ByteOffset();
+		size = view->ByteLength();
+	} else {
+		nx_throw(iso, "expected ArrayBuffer");
+		return;
+	}
+	const uint8_t *mem = static_cast<const uint8_t *>(bs->Data()) + offset;
+	// Offline contexts wait for the decoder instead of underrunning.
+	nx_audio_node *node =
+	    nx_audio_stream_source_create(ctx->graph, ctx->offline);
+	nx_media_stream_t *stream = nx_media_stream_open(
+	    mem, size, std::move(bs), node, ctx->graph->sample_rate,
+	    info[2]->BooleanValue(iso), arg_f64(info, 3), arg_f64(info, 4));
+	stream_source_t *s = new stream_source_t{stream, node};
+	Local<Object> node_obj = nx::NewWrapped(iso);
+	node_obj->SetAlignedPointerInInternalField(0, node,
+	                                           kEmbedderDataTypeTagDefault);
+	Local<Object> stream_obj = nx::NewWrapped(iso);
+	nx::Wrap<stream_source_t>(iso, stream_obj, s, free_stream_source);
+	Local<Array> result = Array::New(iso, 2);
+	result->Set(context, 0, node_obj).Check();
+	result->Set(context, 1, stream_obj).Check();
+	info.GetReturnValue().Set(result);
+}
+
+void nx_audio_stream_seek_cb(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	stream_source_t *s = get_stream(iso, info[0]);
+	if (!s)
+		return;
+	nx_media_stream_seek(s->stream, arg_f64(info, 1));
+}
+
+// audioStreamSetLoop(stream, loop, loopStart, loopEnd)
+void nx_audio_stream_set_loop_cb(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	stream_source_t *s = get_stream(iso, info[0]);
+	if (!s)
+		return;
+	nx_media_stream_set_loop(s->stream, info[1]->BooleanValue(iso),
+	                         arg_f64(info, 2), arg_f64(info, 3));
+}
+
+void nx_audio_stream_duration_cb(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	stream_source_t *s = get_stream(iso, info[0]);
+	if (!s)
+		return;
+	info.GetReturnValue().Set(nx_media_stream_duration(s->stream));
+}
+
+// audioStreamError(stream) -> string | null
+void nx_audio_stream_error_cb(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	stream_source_t *s = get_stream(iso, info[0]);
+	if (!s)
+		return;
+	const char *err = nx_media_stream_error(s->stream);
+	if (err)
+		info.GetReturnValue().Set(nx_str_lossy(iso, err));
+	else
+		info.GetReturnValue().SetNull();
+}
+
 // ---------------------------------------------------------------------------
 // decodeAudioData
 // ---------------------------------------------------------------------------
@@ -387,7 +819,8 @@ struct decode_audio_t {
 	uint8_t *input = nullptr;
 	size_t input_size = 0;
 	Global<Value> buffer_val; // pins the input ArrayBuffer during decode
-	float *channels[NX_AUDIO_DECODE_MAX_CHANNELS] = {};
+	bool s16 = false;         // signed 16-bit output instead of f32
+	void *channels[NX_AUDIO_DECODE_MAX_CHANNELS] = {};
 	int num_channels = 0;
 	uint32_t length = 0; // frames
 	uint32_t sample_rate = 0;
@@ -395,10 +828,10 @@ struct decode_audio_t {
 
 void decode_audio_work(nx_work_t *req) {
 	decode_audio_t *data = (decode_audio_t *)req->data;
-	if (!nx_media_decode_audio(data->input, data->input_size, data->channels,
-	                           &data->num_channels, &data->length,
-	                           &data->sample_rate, data->err_buf,
-	                           sizeof(data->err_buf))) {
+	if (!nx_media_decode_audio(data->input, data->input_size, data->s16,
+	                           data->channels, &data->num_channels,
+	                           &data->length, &data->sample_rate,
+	                           data->err_buf, sizeof(data->err_buf))) {
 		data->err_str = data->err_buf;
 	}
 }
@@ -419,9 +852,10 @@ MaybeLocal<Value> decode_audio_after(Isolate *iso, nx_work_t *req) {
 	                   ? NX_AUDIO_DECODE_MAX_CHANNELS
 	                   : data->num_channels;
 	Local<Array> channel_data = Array::New(iso, channels);
+	size_t sample_size = data->s16 ? sizeof(int16_t) : sizeof(float);
 	for (int c = 0; c < channels; c++) {
 		std::unique_ptr<BackingStore> bs = ArrayBuffer::NewBackingStore(
-		    data->channels[c], (size_t)data->length * sizeof(float),
+		    data->channels[c], (size_t)data->length * sample_size,
 		    [](void *p, size_t, void *) { free(p); }, nullptr);
 		data->channels[c] = nullptr; // ownership moved to the ArrayBuffer
 		Local<ArrayBuffer> ab = ArrayBuffer::New(iso, std::move(bs));
@@ -438,7 +872,8 @@ MaybeLocal<Value> decode_audio_after(Isolate *iso, nx_work_t *req) {
 	return result.As<Value>();
 }
 
-// audioDecode(buf) -> Promise<{ channelData: ArrayBuffer[], length, sampleRate }>
+// audioDecode(buf, s16) -> Promise<{ channelData: ArrayBuffer[], length,
+// sampleRate }> — the channel data holds Int16Array samples when `s16` is set
 void nx_audio_decode(const FunctionCallbackInfo<Value> &info) {
 	Isolate *iso = info.GetIsolate();
 	size_t size = 0;
@@ -449,6 +884,7 @@ void nx_audio_decode(const FunctionCallbackInfo<Value> &info) {
 	}
 	NX_INIT_WORK_T_CPP(decode_audio_t);
 	data->buffer_val.Reset(iso, info[0]);
+	data->s16 = info[1]->BooleanValue(iso);
 	data->input = buf;
 	data->input_size = size;
 	info.GetReturnValue().Set(
@@ -466,6 +902,7 @@ struct offline_render_t {
 	float *channels[NX_AUDIO_CHANNELS] = {};
 	int num_channels = 0;
 	uint32_t length = 0;
+	int threads = 1;
 	~offline_render_t() {
 		if (graph)
 			nx_audio_graph_unref(graph);
@@ -475,7 +912,8 @@ struct offline_render_t {
 void offline_render_work(nx_work_t *req) {
 	offline_render_t *data = (offline_render_t *)req->data;
 	nx_audio_graph_render_offline(data->graph, data->channels,
-	                              data->num_channels, data->length);
+	                              data->num_channels, data->length,
+	                              data->threads);
 }
 
 MaybeLocal<Value> offline_render_after(Isolate *iso, nx_work_t *req) {
@@ -494,7 +932,9 @@ MaybeLocal<Value> offline_render_after(Isolate *iso, nx_work_t *req) {
 	return channel_data.As<Value>();
 }
 
-// audioOfflineRender(ctx, numberOfChannels, length) -> Promise<ArrayBuffer[]>
+// audioOfflineRender(ctx, numberOfChannels, length, threads)
+//   -> Promise<ArrayBuffer[]>
+// `threads` <= 0 picks NX_AUDIO_OFFLINE_THREADS_AUTO.
 void nx_audio_offline_render(const FunctionCallbackInfo<Value> &info) {
 	Isolate *iso = info.GetIsolate();
 	nx_audio_ctx_t *ctx = get_ctx(iso, info[0]);
@@ -518,6 +958,12 @@ void nx_audio_offline_render(const FunctionCallbackInfo<Value> &info) {
 	data->ctx_val.Reset(iso, info[0]);
 	data->num_channels = num_channels;
 	data->length = length;
+	int threads = arg_i32(info, 3);
+	// Capped like `[renderer] raster_threads`: an application only gets three
+	// CPU cores, so more threads would just contend.
+	if (threads <= 0)
+		threads = NX_AUDIO_OFFLINE_THREADS_AUTO;
+	data->threads = threads > 4 ? 4 : threads;
 	for (int c = 0; c < num_channels; c++) {
 		data->channels[c] = (float *)calloc(length, sizeof(float));
 		if (!data->channels[c]) {
@@ -544,6 +990,8 @@ void nx_init_audio(Isolate *iso, Local<Object> init_obj) {
 	            nx_audio_context_current_time);
 	NX_SET_FUNC(init_obj, "audioContextDestination",
 	            nx_audio_context_destination);
+	NX_SET_FUNC(init_obj, "audioContextRenderStats",
+	            nx_audio_context_render_stats);
 	NX_SET_FUNC(init_obj, "audioNodeNew", nx_audio_node_new);
 	NX_SET_FUNC(init_obj, "audioNodeConnect", nx_audio_node_connect_cb);
 	NX_SET_FUNC(init_obj, "audioNodeDisconnect", nx_audio_node_disconnect_cb);
@@ -558,6 +1006,31 @@ void nx_init_audio(Isolate *iso, Local<Object> init_obj) {
 	NX_SET_FUNC(init_obj, "audioSourceStop", nx_audio_source_stop_cb);
 	NX_SET_FUNC(init_obj, "audioSourceSetLoop", nx_audio_source_set_loop_cb);
 	NX_SET_FUNC(init_obj, "audioSourceState", nx_audio_source_state_cb);
+	NX_SET_FUNC(init_obj, "audioPeriodicWaveNew", nx_audio_periodic_wave_new);
+	NX_SET_FUNC(init_obj, "audioOscillatorSetType",
+	            nx_audio_oscillator_set_type_cb);
+	NX_SET_FUNC(init_obj, "audioOscillatorSetPeriodicWave",
+	            nx_audio_oscillator_set_periodic_wave_cb);
+	NX_SET_FUNC(init_obj, "audioBiquadSetType", nx_audio_biquad_set_type_cb);
+	NX_SET_FUNC(init_obj, "audioBiquadGetFrequencyResponse",
+	            nx_audio_biquad_get_frequency_response_cb);
+	NX_SET_FUNC(init_obj, "audioAnalyserGetFloatTimeDomainData",
+	            nx_audio_analyser_float_time_cb);
+	NX_SET_FUNC(init_obj, "audioAnalyserGetByteTimeDomainData",
+	            nx_audio_analyser_byte_time_cb);
+	NX_SET_FUNC(init_obj, "audioAnalyserGetFloatFrequencyData",
+	            nx_audio_analyser_float_frequency_cb);
+	NX_SET_FUNC(init_obj, "audioAnalyserGetByteFrequencyData",
+	            nx_audio_analyser_byte_frequency_cb);
+	NX_SET_FUNC(init_obj, "audioConvolverSetBuffer",
+	            nx_audio_convolver_set_buffer_cb);
+	NX_SET_FUNC(init_obj, "audioCompressorReduction",
+	            nx_audio_compressor_reduction_cb);
+	NX_SET_FUNC(init_obj, "audioStreamSourceNew", nx_audio_stream_source_new);
+	NX_SET_FUNC(init_obj, "audioStreamSeek", nx_audio_stream_seek_cb);
+	NX_SET_FUNC(init_obj, "audioStreamSetLoop", nx_audio_stream_set_loop_cb);
+	NX_SET_FUNC(init_obj, "audioStreamDuration", nx_audio_stream_duration_cb);
+	NX_SET_FUNC(init_obj, "audioStreamError", nx_audio_stream_error_cb);
 	NX_SET_FUNC(init_obj, "audioDecode", nx_audio_decode);
 	NX_SET_FUNC(init_obj, "audioOfflineRender", nx_audio_offline_render);
 }
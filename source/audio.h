@@ -9,6 +9,7 @@ struct nx_audio_sink;
 typedef struct nx_audio_ctx {
 	nx_audio_graph *graph;
 	nx_audio_sink *sink; // NULL for offline contexts / after close()
+	bool offline;
 } nx_audio_ctx_t;
 
 void nx_init_audio(v8::Isolate *iso, v8::Local<v8::Object> init_obj);
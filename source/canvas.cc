@@ -16,17 +16,20 @@
 #include "font.h"
 #include "path2d.h"
 #include "image.h"
+#include "media-decoder.h"
 #include "util.h"
 #include "wrap.h"
 #include <alloca.h>
 #include <math.h>
 #include <mbedtls/base64.h>
+#include <png.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <turbojpeg.h>
 #include <webp/encode.h>
 
+#include "include/core/SkBBHFactory.h"
 #include "include/core/SkColor.h"
 #include "include/core/SkData.h"
 #include "include/core/SkFont.h"
@@ -34,22 +37,31 @@
 #include "include/core/SkImage.h"
 #include "include/core/SkImageFilter.h"
 #include "include/core/SkImageInfo.h"
+#include "include/core/SkPicture.h"
 #include "include/core/SkPixmap.h"
 #include "include/core/SkRRect.h"
+#include "include/core/SkRSXform.h"
 #include "include/core/SkRect.h"
 #include "include/core/SkSurface.h"
 #include "include/core/SkPathUtils.h"
 #include "include/core/SkSamplingOptions.h"
-#include "include/core/SkStream.h"
 #include "include/core/SkTextBlob.h"
 #include "include/core/SkTileMode.h"
 #include "include/effects/SkDashPathEffect.h"
 #include "include/effects/SkGradient.h"
 #include "include/effects/SkImageFilters.h"
-#include "include/encode/SkPngEncoder.h"
+#if defined(SK_GL)
+#include "include/core/SkYUVAInfo.h"
+#include "include/core/SkYUVAPixmaps.h"
+#include "include/gpu/ganesh/SkImageGanesh.h"
+#endif
 
 #include <harfbuzz/hb.h>
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -111,6 +123,7 @@ static sk_sp<SkSurface> make_raster_surface(uint8_t *data, uint32_t w,
 // buffer (*owned set true; caller must free). Returns nullptr on failure.
 static uint8_t *canvas_readable_pixels(nx_canvas_t *canvas, bool *owned) {
 	*owned = false;
+	nx_canvas_flush_deferred(canvas);
 	if (!canvas->gpu)
 		return canvas->data;
 	if (!canvas->surface || canvas->width == 0 || canvas->height == 0)
@@ -130,6 +143,235 @@ static uint8_t *canvas_readable_pixels(nx_canvas_t *canvas, bool *owned) {
 	return buf;
 }
 
+// ---------------------------------------------------------------------------
+// Damage tracking for the raster present path (see nx_canvas_take_damage).
+// ---------------------------------------------------------------------------
+static inline int64_t irect_area(const SkIRect &r) {
+	return (int64_t)r.width() * r.height();
+}
+
+// Record device-space rect `r` as damaged (clamped to the canvas bounds).
+static void damage_device(nx_canvas_t *c, SkIRect r) {
+	if (!r.intersect(SkIRect::MakeWH(c->width, c->height)))
+		return;
+	int n = c->damage_count;
+	for (int i = 0; i < n; i++) {
+		if (c->damage[i].contains(r))
+			return;
+	}
+	if (n < NX_CANVAS_MAX_DAMAGE_RECTS) {
+		c->damage[c->damage_count++] = r;
+		return;
+	}
+	// Out of slots: merge into the rect whose area grows the least.
+	int best = 0;
+	int64_t best_growth = INT64_MAX;
+	for (int i = 0; i < n; i++) {
+		SkIRect u = c->damage[i];
+		u.join(r);
+		int64_t growth = irect_area(u) - irect_area(c->damage[i]);
+		if (growth < best_growth) {
+			best_growth = growth;
+			best = i;
+		}
+	}
+	c->damage[best].join(r);
+}
+
+static void damage_all(nx_canvas_t *c) {
+	c->damage_count = 0;
+	if (c->width && c->height) {
+		c->damage[0] = SkIRect::MakeWH(c->width, c->height);
+		c->damage_count = 1;
+	}
+}
+
+// Record the device-space footprint of drawing geometry with user-space
+// bounds `local` using paint `p`, under the current CTM and clip. Skia's fast
+// bounds account for stroke width/joins/caps and the shadow image filter;
+// paints whose bounds can't be computed conservatively damage the whole clip.
+static void damage_draw(nx_canvas_context_2d_t *context, const SkRect &local,
+                        const SkPaint &p) {
+	SkCanvas *cr = context->ctx;
+	SkIRect clip = cr->getDeviceClipBounds();
+	SkIRect dev = clip;
+	if (p.canComputeFastBounds()) {
+		SkRect storage;
+		SkRect b = cr->getTotalMatrix().mapRect(
+		    p.computeFastBounds(local.makeSorted(), &storage));
+		if (b.isFinite()) {
+			// +1px on each side for the anti-aliasing fringe.
+			dev = b.roundOut().makeOutset(1, 1);
+			if (!dev.intersect(clip))
+				return;
+		}
+	}
+	damage_device(context->canvas, dev);
+}
+
+// ---------------------------------------------------------------------------
+// Deferred (tile-parallel) raster mode — see nx_canvas_flush_deferred.
+// ---------------------------------------------------------------------------
+// A recorded frame is played back into horizontal bands of `data`, each through
+// its own SkCanvas over that row range, so bands rasterize concurrently
+// (SkPicture playback is thread-safe, and the R-tree lets a band skip ops that
+// don't touch it). The workers are plain threads rather than libuv pool jobs:
+// the pool may be saturated by async fs/crypto/encode work, and a frame can't
+// wait behind it. They start lazily and park on a condition variable between
+// frames; the JS thread always rasterizes bands too.
+struct RasterJob {
+	const SkPicture *picture;
+	uint8_t *data;
+	uint32_t width, height;
+	int band_h, bands;
+	int workers;  // pool workers taking part (indices [0, workers))
+	std::atomic<int> next_band;
+};
+
+static std::mutex raster_mutex;
+static std::condition_variable raster_wake;
+static std::condition_variable raster_idle;
+static RasterJob *raster_job;
+static uint64_t raster_generation;
+static int raster_busy;          // participating workers still in raster_job
+static int raster_worker_count;  // workers started (never exit)
+
+static void raster_bands(RasterJob *job) {
+	size_t stride = (size_t)job->width * 4;
+	for (;;) {
+		int b = job->next_band.fetch_add(1, std::memory_order_relaxed);
+		if (b >= job->bands)
+			return;
+		int y0 = b * job->band_h;
+		int h = imin(job->band_h, (int)job->height - y0);
+		SkImageInfo info = SkImageInfo::Make(job->width, h, kBGRA_8888_SkColorType,
+		                                     kPremul_SkAlphaType);
+		std::unique_ptr<SkCanvas> band =
+		    SkCanvas::MakeRasterDirect(info, job->data + y0 * stride, stride);
+		if (!band)
+			continue;
+		band->translate(0, -(SkScalar)y0);
+		band->drawPicture(job->picture);
+	}
+}
+
+static void raster_worker_main(int index) {
+	uint64_t seen = 0;
+	std::unique_lock<std::mutex> lock(raster_mutex);
+	for (;;) {
+		raster_wake.wait(lock, [&] { return raster_generation != seen; });
+		seen = raster_generation;
+		RasterJob *job = raster_job;
+		// A worker not needed by the current job (or woken after it ended)
+		// is not counted in raster_busy, so it must not touch the job.
+		if (!job || index >= job->workers)
+			continue;
+		lock.unlock();
+		raster_bands(job);
+		lock.lock();
+		if (--raster_busy == 0)
+			raster_idle.notify_one();
+	}
+}
+
+// Rasterize `picture` into `c->data` on up to c->raster_threads threads.
+// Returns once every band is done.
+static void raster_picture(const SkPicture *picture, nx_canvas_t *c) {
+	RasterJob job;
+	job.picture = picture;
+	job.data = c->data;
+	job.width = c->width;
+	job.height = c->height;
+	// Two bands per thread evens out scenes whose cost is concentrated in a
+	// few rows; bands stay at least 16 rows so per-band replay overhead (R-tree
+	// query + canvas setup) stays small next to the rasterization itself.
+	int bands = c->raster_threads * 2;
+	job.band_h = ((int)c->height + bands - 1) / bands;
+	if (job.band_h < 16)
+		job.band_h = 16;
+	job.bands = ((int)c->height + job.band_h - 1) / job.band_h;
+	job.next_band.store(0, std::memory_order_relaxed);
+	job.workers = imin(c->raster_threads - 1, job.bands - 1);
+	if (job.workers > 0) {
+		std::unique_lock<std::mutex> lock(raster_mutex);
+		while (raster_worker_count < job.workers) {
+			std::thread(raster_worker_main, raster_worker_count).detach();
+			raster_worker_count++;
+		}
+		raster_job = &job;
+		raster_busy = job.workers;
+		raster_generation++;
+		raster_wake.notify_all();
+	}
+	raster_bands(&job);
+	if (job.workers > 0) {
+		std::unique_lock<std::mutex> lock(raster_mutex);
+		raster_idle.wait(lock, [] { return raster_busy == 0; });
+		raster_job = nullptr;
+	}
+}
+
+// Rebuild the context's save stack on `cr` (a fresh recording, or the surface
+// canvas when leaving deferred mode): one save level per state node, oldest
+// first, each with the transform restore() returns to and the device-space
+// clips applied at that level; then the current transform `ctm`.
+static void replay_state(SkCanvas *cr, nx_canvas_context_2d_t *context,
+                         const SkM44 &ctm) {
+	std::vector<nx_canvas_context_2d_state_t *> levels;
+	for (nx_canvas_context_2d_state_t *s = context->state; s; s = s->next)
+		levels.push_back(s);
+	for (size_t i = levels.size(); i-- > 0;) {
+		nx_canvas_context_2d_state_t *s = levels[i];
+		if (s->next) {
+			cr->setMatrix(s->saved_ctm);
+			cr->save();
+		}
+		cr->resetMatrix();
+		for (const SkPath &clip : s->clips)
+			cr->clipPath(clip, true);
+	}
+	cr->setMatrix(ctm);
+}
+
+// Point context->ctx at the canvas it should draw into. For a deferred canvas
+// that is the open recording (started here, with the save stack replayed, if
+// the last one was flushed). A canvas that just left deferred mode gets its
+// state replayed onto the surface canvas, which never saw the recordings.
+static void select_ctx(nx_canvas_context_2d_t *context) {
+	nx_canvas_t *canvas = context->canvas;
+	if (canvas->gpu || !canvas->surface)
+		return;
+	if (canvas->raster_threads) {
+		if (!canvas->recording) {
+			if (!canvas->recorder)
+				canvas->recorder = new SkPictureRecorder();
+			SkRTreeFactory rtree;
+			SkCanvas *rc = canvas->recorder->beginRecording(
+			    SkRect::MakeIWH(canvas->width, canvas->height), &rtree);
+			replay_state(rc, context, canvas->deferred_ctm);
+			canvas->recording = true;
+		}
+		context->ctx = canvas->recorder->getRecordingCanvas();
+		return;
+	}
+	SkCanvas *sc = canvas->surface->getCanvas();
+	if (context->ctx != sc) {
+		sc->restoreToCount(1);
+		replay_state(sc, context, canvas->deferred_ctm);
+		context->ctx = sc;
+	}
+}
+
+// Drop a pending recording without rasterizing it (resize / GPU adoption,
+// where the pixels it targeted are going away).
+static void deferred_discard(nx_canvas_t *c) {
+	if (c->recording) {
+		c->recorder->finishRecordingAsPicture();
+		c->recording = false;
+	}
+	c->deferred_ctm = SkM44();
+}
+
 // ---------------------------------------------------------------------------
 // Gradient lifecycle
 // ---------------------------------------------------------------------------
@@ -202,6 +444,7 @@ Ctx2D enter_ctx(Isolate *iso, Local<Value> recv) {
 	if (!r.context)
 		return r;
 	nx_canvas_ensure_surface(iso, r.context);
+	select_ctx(r.context);
 	if (!r.context->ctx) {
 		if (r.context->canvas->width == 0 || r.context->canvas->height == 0)
 			r.noop = true;
@@ -268,6 +511,7 @@ static void nx_canvas_ensure_surface(Isolate *iso,
 	if (!canvas->surface_dirty)
 		return;
 
+	deferred_discard(canvas);
 	context->ctx = nullptr;
 	canvas->surface.reset();
 	if (canvas->data) {
@@ -305,6 +549,7 @@ static void nx_canvas_ensure_surface(Isolate *iso,
 		}
 		context->ctx = canvas->surface->getCanvas();
 		canvas->surface_dirty = false;
+		damage_all(canvas);
 	}
 
 reset_state:
@@ -560,7 +805,9 @@ static void fill_op(nx_canvas_context_2d_t *context, bool /*preserve*/) {
 	SkCanvas *cr = context->ctx;
 	SkM44 saved = cr->getLocalToDevice();
 	cr->resetMatrix();
-	cr->drawPath(context->path.snapshot(), p);
+	SkPath path = context->path.snapshot();
+	damage_draw(context, path.getBounds(), p);
+	cr->drawPath(path, p);
 	cr->setMatrix(saved);
 }
 static void stroke_op(nx_canvas_context_2d_t *context, bool /*preserve*/) {
@@ -572,12 +819,15 @@ static void stroke_op(nx_canvas_context_2d_t *context, bool /*preserve*/) {
 		// Path back to user space; stroke under the existing CTM so the pen is
 		// transformed by it.
 		SkPath user = context->path.snapshot().makeTransform(inv);
+		damage_draw(context, user.getBounds(), p);
 		cr->drawPath(user, p);
 	} else {
 		// Degenerate CTM: fall back to stroking the device path under identity.
 		SkM44 saved = cr->getLocalToDevice();
 		cr->resetMatrix();
-		cr->drawPath(context->path.snapshot(), p);
+		SkPath path = context->path.snapshot();
+		damage_draw(context, path.getBounds(), p);
+		cr->drawPath(path, p);
 		cr->setMatrix(saved);
 	}
 }
@@ -685,6 +935,7 @@ void nx_canvas_context_2d_put_image_data(
 void nx_canvas_context_2d_get_image_data(
     const FunctionCallbackInfo<Value> &info);
 void nx_canvas_context_2d_draw_image(const FunctionCallbackInfo<Value> &info);
+void nx_canvas_context_2d_draw_atlas(const FunctionCallbackInfo<Value> &info);
 void nx_canvas_context_2d_set_fill_style_gradient(
     const FunctionCallbackInfo<Value> &info);
 void nx_canvas_context_2d_set_stroke_style_gradient(
@@ -1023,9 +1274,11 @@ void nx_canvas_context_2d_clip(const FunctionCallbackInfo<Value> &info) {
 	// not re-apply the CTM. Toggle the matrix directly (NOT via save/restore,
 	// which would also pop the clip we are adding).
 	SkM44 saved = cr->getLocalToDevice();
+	SkPath clip = context->path.snapshot();
 	cr->resetMatrix();
-	cr->clipPath(context->path.snapshot(), true);
+	cr->clipPath(clip, true);
 	cr->setMatrix(saved);
+	context->state->clips.push_back(std::move(clip));
 
 	if (restore_path)
 		context->path = saved_path;
@@ -1087,9 +1340,10 @@ void nx_canvas_context_2d_fill_rect(const FunctionCallbackInfo<Value> &info) {
 		return;
 	if (a[2] && a[3]) {
 		SkPaint p = make_fill_paint(context);
-		cr->drawRect(SkRect::MakeXYWH((SkScalar)a[0], (SkScalar)a[1],
-		                              (SkScalar)a[2], (SkScalar)a[3]),
-		             p);
+		SkRect r = SkRect::MakeXYWH((SkScalar)a[0], (SkScalar)a[1],
+		                            (SkScalar)a[2], (SkScalar)a[3]);
+		damage_draw(context, r, p);
+		cr->drawRect(r, p);
 	}
 }
 
@@ -1100,9 +1354,10 @@ void nx_canvas_context_2d_stroke_rect(const FunctionCallbackInfo<Value> &info) {
 		return;
 	if (a[2] && a[3]) {
 		SkPaint p = make_stroke_paint(context);
-		cr->drawRect(SkRect::MakeXYWH((SkScalar)a[0], (SkScalar)a[1],
-		                              (SkScalar)a[2], (SkScalar)a[3]),
-		             p);
+		SkRect r = SkRect::MakeXYWH((SkScalar)a[0], (SkScalar)a[1],
+		                            (SkScalar)a[2], (SkScalar)a[3]);
+		damage_draw(context, r, p);
+		cr->drawRect(r, p);
 	}
 }
 
@@ -1114,9 +1369,10 @@ void nx_canvas_context_2d_clear_rect(const FunctionCallbackInfo<Value> &info) {
 	if (a[2] && a[3]) {
 		SkPaint p;
 		p.setBlendMode(SkBlendMode::kClear);
-		cr->drawRect(SkRect::MakeXYWH((SkScalar)a[0], (SkScalar)a[1],
-		                              (SkScalar)a[2], (SkScalar)a[3]),
-		             p);
+		SkRect r = SkRect::MakeXYWH((SkScalar)a[0], (SkScalar)a[1],
+		                            (SkScalar)a[2], (SkScalar)a[3]);
+		damage_draw(context, r, p);
+		cr->drawRect(r, p);
 	}
 }
 
@@ -1717,6 +1973,13 @@ void nx_canvas_context_2d_fill_text(const FunctionCallbackInfo<Value> &info) {
 	if (!glyphs.empty()) {
 		SkFont font = current_font(context, font_size * scale);
 		SkPaint p = make_fill_paint(context);
+		// Conservative glyph bounds: the pen positions outset by the em size
+		// (ascent above the baseline, descent/advance past the last glyph).
+		SkRect bounds = SkRect::MakeXYWH(pos[0].x(), pos[0].y(), 0, 0);
+		for (const SkPoint &pt : pos)
+			bounds.growToInclude(pt);
+		SkScalar em = (SkScalar)(font_size * scale);
+		damage_draw(context, bounds.makeOutset(em * 1.5f, em * 1.5f), p);
 		cr->drawGlyphs(SkSpan<const SkGlyphID>(glyphs.data(), glyphs.size()),
 		               SkSpan<const SkPoint>(pos.data(), pos.size()),
 		               SkPoint::Make(0, 0), font, p);
@@ -1763,7 +2026,9 @@ void nx_canvas_context_2d_stroke_text(
 			acc.addPath(*gp, m, SkPath::kAppend_AddPathMode);
 		}
 		SkPaint p = make_stroke_paint(context);
-		cr->drawPath(acc.snapshot(), p);
+		SkPath text_path = acc.snapshot();
+		damage_draw(context, text_path.getBounds(), p);
+		cr->drawPath(text_path, p);
 	}
 	if (scale != 1.)
 		set_font_size(context, font_size);
@@ -1820,6 +2085,9 @@ void nx_canvas_context_2d_save(const FunctionCallbackInfo<Value> &info) {
 	// Deep-copy the heap-owned font string; sk_sp/std::vector copy via ctor.
 	if (context->state->font_string)
 		state->font_string = strdup(context->state->font_string);
+	// Clips belong to the level they were applied at; the new level has none.
+	state->clips.clear();
+	state->saved_ctm = cr->getLocalToDevice();
 	state->next = context->state;
 	context->state = state;
 }
@@ -1840,6 +2108,7 @@ void nx_canvas_context_2d_restore(const FunctionCallbackInfo<Value> &info) {
 // ===========================================================================
 
 void free_canvas(nx_canvas_t *c) {
+	delete c->recorder;
 	c->surface.reset();
 	if (c->data)
 		free(c->data);
@@ -1877,6 +2146,7 @@ void nx_canvas_new(const FunctionCallbackInfo<Value> &info) {
 	canvas->data = buffer;
 	canvas->surface_dirty = false;
 	canvas->surface = make_raster_surface(buffer, width, height);
+	damage_all(canvas);
 	Local<Object> obj = nx::NewWrapped(iso);
 	nx::Wrap<nx_canvas_t>(iso, obj, canvas, free_canvas);
 	info.GetReturnValue().Set(obj);
@@ -1998,6 +2268,7 @@ void nx_canvas_context_2d_init_class(const FunctionCallbackInfo<Value> &info) {
 	F("clearRect", nx_canvas_context_2d_clear_rect, 4);
 	F("closePath", nx_canvas_context_2d_close_path, 0);
 	F("clip", nx_canvas_context_2d_clip, 0);
+	F("drawAtlas", nx_canvas_context_2d_draw_atlas, 2);
 	F("drawImage", nx_canvas_context_2d_draw_image, 3);
 	F("ellipse", nx_canvas_context_2d_ellipse, 7);
 	F("fill", nx_canvas_context_2d_fill, 0);
@@ -2111,6 +2382,9 @@ void nx_canvas_context_2d_is_point_in_stroke(
 void nx_canvas_context_2d_put_image_data(
     const FunctionCallbackInfo<Value> &info) {
 	ENTER_THIS;
+	// Pixels are written directly below, so earlier recorded draws must land
+	// first.
+	nx_canvas_flush_deferred(context->canvas);
 	Local<Context> jsctx = iso->GetCurrentContext();
 	int sx = 0, sy = 0, sw = 0, sh = 0, dx, dy, image_data_width,
 	    image_data_height, rows, cols;
@@ -2207,6 +2481,7 @@ void nx_canvas_context_2d_put_image_data(
 		context->canvas->surface->writePixels(pm, dx, dy);
 		free(scratch);
 	}
+	damage_device(context->canvas, SkIRect::MakeXYWH(dx, dy, cols, rows));
 }
 
 // ---- getImageData (premultiplied BGRA -> unpremultiplied RGBA) ----
@@ -2288,32 +2563,134 @@ static SkSamplingOptions sampling_for(nx_canvas_context_2d_t *context) {
 	}
 }
 
-void nx_canvas_context_2d_draw_image(const FunctionCallbackInfo<Value> &info) {
-	Isolate *iso = info.GetIsolate();
-	int argc = info.Length();
-	if (argc != 3 && argc != 5 && argc != 9) {
-		nx_throw(iso, "Invalid arguments");
-		return;
-	}
-	double args[8];
-	if (!get_doubles(info, args, argc - 1, 1))
-		return;
-	Ctx2D _c = enter_ctx(iso, info.This());
-	if (!_c.ok) {
-		if (!_c.noop && !_c.context)
-			nx_throw(iso, "invalid canvas context");
-		return;
+#if defined(SK_GL)
+// Uploads a YUV video frame's planes to `dest`'s GPU context; Ganesh converts
+// them to RGB in the shader, so the CPU never touches the pixels beyond
+// copying the planes into its upload buffers (1.5 bytes per pixel, against
+// 4 for BGRA plus the conversion). Returns null if the GPU rejects the frame.
+static sk_sp<SkImage> gpu_frame_image(nx_media_frame_t *frame,
+                                      nx_canvas_t *dest) {
+	nx_media_yuv_planes yuv;
+	if (!dest->gpu || !dest->surface || !nx_media_frame_yuv(frame, &yuv))
+		return nullptr;
+	int w = nx_media_frame_width(frame);
+	int h = nx_media_frame_height(frame);
+	SkYUVColorSpace cs;
+	switch (yuv.matrix) {
+	case NX_MEDIA_YUV_BT709:
+		cs = yuv.full_range ? kRec709_Full_SkYUVColorSpace
+		                    : kRec709_Limited_SkYUVColorSpace;
+		break;
+	case NX_MEDIA_YUV_BT2020:
+		cs = yuv.full_range ? kBT2020_8bit_Full_SkYUVColorSpace
+		                    : kBT2020_8bit_Limited_SkYUVColorSpace;
+		break;
+	default:
+		cs = yuv.full_range ? kJPEG_Full_SkYUVColorSpace
+		                    : kRec601_Limited_SkYUVColorSpace;
+		break;
 	}
-	nx_canvas_context_2d_t *context = _c.context;
-	SkCanvas *cr = _c.cr;
-
-	// Resolve the source as an SkImage (from a decoded image or another canvas).
+	bool nv12 = yuv.num_planes == 2;
+	SkYUVAInfo info({w, h},
+	                nv12 ? SkYUVAInfo::PlaneConfig::kY_UV
+	                     : SkYUVAInfo::PlaneConfig::kY_U_V,
+	                SkYUVAInfo::Subsampling::k420, cs);
+	SkPixmap planes[SkYUVAPixmaps::kMaxPlanes];
+	for (int i = 0; i < yuv.num_planes; i++) {
+		if (yuv.stride[i] <= 0) // bottom-up planes
+			return nullptr;
+		SkImageInfo ii =
+		    i == 0 ? SkImageInfo::Make(w, h, kGray_8_SkColorType,
+		                               kOpaque_SkAlphaType)
+		           : SkImageInfo::Make((w + 1) / 2, (h + 1) / 2,
+		                               nv12 ? kR8G8_unorm_SkColorType
+		                                    : kGray_8_SkColorType,
+		                               kOpaque_SkAlphaType);
+		planes[i].reset(ii, yuv.data[i], (size_t)yuv.stride[i]);
+	}
+	SkYUVAPixmaps pixmaps = SkYUVAPixmaps::FromExternalPixmaps(info, planes);
+	if (!pixmaps.isValid())
+		return nullptr;
+	return SkImages::TextureFromYUVAPixmaps(
+	    dest->surface->recordingContext(), pixmaps);
+}
+#endif
+
+// Wraps a video frame (see nx_image_t::frame) in an SkImage. BGRA frames are
+// wrapped WITHOUT copying: the SkImage holds a frame reference until Skia
+// releases it (after any GPU upload or deferred raster that still reads the
+// pixels), and the decode thread never writes into a referenced frame, so
+// the pixels stay immutable as Skia requires. YUV frames go to the GPU when
+// drawn into a GPU canvas, and are converted on the CPU otherwise.
+static sk_sp<SkImage> frame_image(nx_media_frame_t *frame, nx_canvas_t *dest) {
+	int w = nx_media_frame_width(frame);
+	int h = nx_media_frame_height(frame);
+	size_t stride = (size_t)w * 4;
+	SkImageInfo ii = SkImageInfo::Make(w, h, kBGRA_8888_SkColorType,
+	                                   kOpaque_SkAlphaType);
+	if (const uint8_t *bgra = nx_media_frame_bgra(frame)) {
+		nx_media_frame_ref(frame);
+		sk_sp<SkImage> image = SkImages::RasterFromPixmap(
+		    SkPixmap(ii, bgra, stride),
+		    [](const void *, void *f) {
+			    nx_media_frame_unref(static_cast<nx_media_frame_t *>(f));
+		    },
+		    frame);
+		// The release proc only runs for an image that was created.
+		if (!image)
+			nx_media_frame_unref(frame);
+		return image;
+	}
+#if defined(SK_GL)
+	if (sk_sp<SkImage> image = gpu_frame_image(frame, dest))
+		return image;
+#else
+	(void)dest;
+#endif
+	uint8_t *buf = (uint8_t *)malloc(stride * h);
+	if (!buf)
+		return nullptr;
 	sk_sp<SkImage> image;
-	double source_w = 0, source_h = 0;
-	nx_image_t *img = nx_get_image(iso, info[0]);
+	if (nx_media_frame_to_bgra(frame, buf, stride)) {
+		image = SkImages::RasterFromPixmap(
+		    SkPixmap(ii, buf, stride),
+		    [](const void *pixels, void *) { free((void *)pixels); }, nullptr);
+	}
+	if (!image)
+		free(buf);
+	return image;
+}
+
+// Resolve a CanvasImageSource (decoded Image/ImageBitmap or another canvas)
+// to an SkImage for drawing into `dest`. Returns false if an exception was
+// thrown; on success `*out` may still be null (empty image / never-drawn
+// canvas), meaning "draw nothing". For a video, `*video` is set: its frame
+// image may be smaller than `*source_w` x `*source_h` (see frame_scale()).
+static bool resolve_image_source(Isolate *iso, Local<Value> source,
+                                 nx_canvas_t *dest, sk_sp<SkImage> *out,
+                                 double *source_w, double *source_h,
+                                 nx_image_t **video) {
+	nx_image_t *img = nx_get_image(iso, source);
+	*video = nullptr;
+	if (img && img->frame) {
+		// Video frames change every tick, so this memo lives for one frame
+		// (video.cc drops it on present); it still saves the re-wrap (or the
+		// YUV upload) when the same frame is drawn several times.
+		if (!img->cached_sk_image) {
+			sk_sp<SkImage> image = frame_image(img->frame, dest);
+			if (!image)
+				return true;
+			img->cached_sk_image = new sk_sp<SkImage>(std::move(image));
+		}
+		*out = *static_cast<sk_sp<SkImage> *>(img->cached_sk_image);
+		*source_w = img->width;
+		*source_h = img->height;
+		*video = img;
+		return true;
+	}
 	if (img) {
 		if (!img->data || img->width == 0 || img->height == 0)
-			return;
+			return true;
 		// Memoize the wrapped SkImage on the image object. Rebuilding it per
 		// draw gave each call a fresh image identity, defeating Ganesh's
 		// GPU-texture cache (full source re-upload every frame), and at ~10k
@@ -2338,31 +2715,92 @@ void nx_canvas_context_2d_draw_image(const FunctionCallbackInfo<Value> &info) {
 			// reuse the null and never retry. On failure just skip this draw;
 			// the next one rebuilds.
 			if (!cached)
-				return;
+				return true;
 			img->cached_sk_image = new sk_sp<SkImage>(std::move(cached));
 		}
-		image = *static_cast<sk_sp<SkImage> *>(img->cached_sk_image);
-		source_w = img->width;
-		source_h = img->height;
-	} else {
-		nx_canvas_t *canvas = nx_get_canvas(iso, info[0]);
-		if (!canvas) {
-			nx_throw(iso, "Image or Canvas expected");
-			return;
-		}
-		// A canvas that has never been drawn to has no surface yet — it is
-		// fully transparent, so drawing it is a no-op.
-		if (!canvas->surface)
-			return;
-		// makeImageSnapshot() returns the SAME SkImage (stable uniqueID)
-		// while the surface is unchanged, so Ganesh's texture cache stays
-		// effective across repeated draws of a static canvas.
-		image = canvas->surface->makeImageSnapshot();
-		source_w = canvas->width;
-		source_h = canvas->height;
+		*out = *static_cast<sk_sp<SkImage> *>(img->cached_sk_image);
+		*source_w = img->width;
+		*source_h = img->height;
+		return true;
 	}
+	nx_canvas_t *canvas = nx_get_canvas(iso, source);
+	if (!canvas) {
+		nx_throw(iso, "Image or Canvas expected");
+		return false;
+	}
+	// A canvas that has never been drawn to has no surface yet — it is
+	// fully transparent, so drawing it is a no-op.
+	if (!canvas->surface)
+		return true;
+	// A deferred canvas must rasterize what it has recorded first. When that
+	// canvas is also the destination, the caller re-selects its (now closed)
+	// recording canvas via select_ctx().
+	nx_canvas_flush_deferred(canvas);
+	// makeImageSnapshot() returns the SAME SkImage (stable uniqueID)
+	// while the surface is unchanged, so Ganesh's texture cache stays
+	// effective across repeated draws of a static canvas.
+	*out = canvas->surface->makeImageSnapshot();
+	*source_w = canvas->width;
+	*source_h = canvas->height;
+	return true;
+}
+
+// The decoder scales video frames down to the size they are drawn at (see
+// nx_image_t::drawn_width), so a frame image can be smaller than the video:
+// source rects given in video pixels are scaled by these factors.
+static void frame_scale(const sk_sp<SkImage> &image, double source_w,
+                        double source_h, float *kx, float *ky) {
+	*kx = (float)(image->width() / source_w);
+	*ky = (float)(image->height() / source_h);
+}
+
+// Records the device-space size at which `video` is drawn when `src` (video
+// pixels) is drawn into `dst` under `ctm`, as the decoder's next target size.
+static void note_video_draw(nx_image_t *video, const SkMatrix &ctm,
+                            const SkRect &src, const SkRect &dst) {
+	SkRect dev = ctm.mapRect(dst);
+	double w = ceil(dev.width() * video->width / fabs(src.width()));
+	double h = ceil(dev.height() * video->height / fabs(src.height()));
+	if (!(w >= 0 && h >= 0))
+		return;
+	u32 dw = w < video->width ? (u32)w : video->width;
+	u32 dh = h < video->height ? (u32)h : video->height;
+	if (dw > video->drawn_width)
+		video->drawn_width = dw;
+	if (dh > video->drawn_height)
+		video->drawn_height = dh;
+}
+
+void nx_canvas_context_2d_draw_image(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	int argc = info.Length();
+	if (argc != 3 && argc != 5 && argc != 9) {
+		nx_throw(iso, "Invalid arguments");
+		return;
+	}
+	double args[8];
+	if (!get_doubles(info, args, argc - 1, 1))
+		return;
+	Ctx2D _c = enter_ctx(iso, info.This());
+	if (!_c.ok) {
+		if (!_c.noop && !_c.context)
+			nx_throw(iso, "invalid canvas context");
+		return;
+	}
+	nx_canvas_context_2d_t *context = _c.context;
+	SkCanvas *cr = _c.cr;
+
+	// Resolve the source as an SkImage (from a decoded image or another canvas).
+	sk_sp<SkImage> image;
+	double source_w = 0, source_h = 0;
+	nx_image_t *video;
+	if (!resolve_image_source(iso, info[0], context->canvas, &image,
+	                          &source_w, &source_h, &video))
+		return;
 	if (!image)
 		return;
+	select_ctx(context);
+	cr = context->ctx;
 
 	double sx = 0, sy = 0, sw = source_w, sh = source_h, dx = 0, dy = 0,
 	       dw = 0, dh = 0;
@@ -2384,15 +2822,179 @@ void nx_canvas_context_2d_draw_image(const FunctionCallbackInfo<Value> &info) {
 	                               (SkScalar)sh);
 	SkRect dstR = SkRect::MakeXYWH((SkScalar)dx, (SkScalar)dy, (SkScalar)dw,
 	                               (SkScalar)dh);
+	if (video) {
+		note_video_draw(video, cr->getTotalMatrix(), srcR, dstR);
+		float kx, ky;
+		frame_scale(image, source_w, source_h, &kx, &ky);
+		srcR = SkRect::MakeLTRB(srcR.fLeft * kx, srcR.fTop * ky,
+		                        srcR.fRight * kx, srcR.fBottom * ky);
+	}
 	SkPaint p;
 	p.setAntiAlias(true);
 	p.setBlendMode(context->state->blend_mode);
 	p.setAlphaf((float)context->state->global_alpha);
 	p.setImageFilter(shadow_filter(context));
+	damage_draw(context, dstR, p);
 	cr->drawImageRect(image, srcR, dstR, sampling_for(context), &p,
 	                  SkCanvas::kStrict_SrcRectConstraint);
 }
 
+// ---- drawAtlas (nx.js extension) ----
+// Batched sprite drawing: one SkCanvas::drawAtlas for N sprites instead of N
+// drawImage calls (each paying argument coercion, enter_ctx, the SkImage
+// lookup and a separate Skia draw). Each record in the `sprites` Float32Array
+// is NX_ATLAS_RECORD_FLOATS floats:
+//
+//   [sx, sy, sw, sh, scos, ssin, tx, ty, alpha]
+//
+// i.e. the source rect within the atlas image, an SkRSXform (rotation +
+// uniform scale + translation) placing it in user space, and a per-sprite
+// alpha. The optional `colors` Uint32Array holds one 0xAARRGGBB color per
+// sprite, multiplied into the sprite (kModulate); alpha folds into the same
+// color, so modulation costs nothing extra when both are used.
+#define NX_ATLAS_RECORD_FLOATS 9
+
+// Scratch arrays reused across calls (JS is single-threaded), so a steady
+// per-frame sprite count does no allocation after the first frame.
+static std::vector<SkRSXform> atlas_xforms;
+static std::vector<SkRect> atlas_rects;
+static std::vector<SkColor> atlas_colors;
+
+void nx_canvas_context_2d_draw_atlas(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	Local<Context> jsctx = iso->GetCurrentContext();
+	if (!info[1]->IsFloat32Array()) {
+		iso->ThrowException(Exception::TypeError(
+		    nx_str(iso, "drawAtlas: sprites must be a Float32Array")));
+		return;
+	}
+	bool has_colors = !info[2]->IsUndefined() && !info[2]->IsNull();
+	if (has_colors && !info[2]->IsUint32Array()) {
+		iso->ThrowException(Exception::TypeError(
+		    nx_str(iso, "drawAtlas: colors must be a Uint32Array")));
+		return;
+	}
+	uint32_t count = UINT32_MAX;
+	if (!info[3]->IsUndefined() && !info[3]->Uint32Value(jsctx).To(&count))
+		return;
+
+	// Resolve the typed-array views only after every coercion above, since a
+	// user `valueOf` could have detached or resized the buffers.
+	Local<Float32Array> sprites = info[1].As<Float32Array>();
+	size_t available = sprites->Length() / NX_ATLAS_RECORD_FLOATS;
+	if (count == UINT32_MAX)
+		count = (uint32_t)available;
+	if (count > available) {
+		iso->ThrowException(Exception::RangeError(
+		    nx_str(iso, "drawAtlas: count exceeds the number of sprites")));
+		return;
+	}
+	const uint32_t *colors_in = nullptr;
+	if (has_colors) {
+		Local<Uint32Array> colors = info[2].As<Uint32Array>();
+		if (colors->Length() < count) {
+			iso->ThrowException(Exception::RangeError(
+			    nx_str(iso, "drawAtlas: colors is shorter than count")));
+			return;
+		}
+		colors_in = (const uint32_t *)((uint8_t *)colors->Buffer()->Data() +
+		                               colors->ByteOffset());
+	}
+
+	Ctx2D _c = enter_ctx(iso, info.This());
+	if (!_c.ok) {
+		if (!_c.noop && !_c.context)
+			nx_throw(iso, "invalid canvas context");
+		return;
+	}
+	nx_canvas_context_2d_t *context = _c.context;
+	SkCanvas *cr = _c.cr;
+
+	sk_sp<SkImage> image;
+	double source_w = 0, source_h = 0;
+	nx_image_t *video;
+	if (!resolve_image_source(iso, info[0], context->canvas, &image,
+	                          &source_w, &source_h, &video))
+		return;
+	if (!image || count == 0)
+		return;
+	select_ctx(context);
+	cr = context->ctx;
+
+	const float *rec = (const float *)((uint8_t *)sprites->Buffer()->Data() +
+	                                   sprites->ByteOffset());
+	atlas_xforms.resize(count);
+	atlas_rects.resize(count);
+	bool modulate = colors_in != nullptr;
+	// User-space bounds of all sprite quads: passed to Skia as the cull rect
+	// and used for damage tracking.
+	SkRect bounds = SkRect::MakeEmpty();
+	for (uint32_t i = 0; i < count; i++, rec += NX_ATLAS_RECORD_FLOATS) {
+		atlas_rects[i] = SkRect::MakeXYWH(rec[0], rec[1], rec[2], rec[3]);
+		atlas_xforms[i] = SkRSXform::Make(rec[4], rec[5], rec[6], rec[7]);
+		SkPoint quad[4];
+		atlas_xforms[i].toQuad(rec[2], rec[3], quad);
+		for (const SkPoint &pt : quad)
+			bounds.growToInclude(pt);
+		if (rec[8] != 1.f)
+			modulate = true;
+	}
+	if (video) {
+		// Sprites of a video frame: keep the decoder at the full size (the
+		// sprites' scales are not tracked), and map the rects onto a frame
+		// decoded smaller, compensating in the transforms' scale.
+		video->drawn_width = video->width;
+		video->drawn_height = video->height;
+		float kx, ky;
+		frame_scale(image, source_w, source_h, &kx, &ky);
+		if (kx != 1.f || ky != 1.f) {
+			for (uint32_t i = 0; i < count; i++) {
+				SkRect &r = atlas_rects[i];
+				r = SkRect::MakeLTRB(r.fLeft * kx, r.fTop * ky,
+				                     r.fRight * kx, r.fBottom * ky);
+				SkRSXform &x = atlas_xforms[i];
+				x = SkRSXform::Make(x.fSCos / kx, x.fSSin / kx, x.fTx, x.fTy);
+			}
+		}
+	}
+	if (modulate) {
+		// White (identity) modulation where no colors were given; the
+		// per-sprite alpha scales the color's own alpha.
+		atlas_colors.resize(count);
+		rec = (const float *)((uint8_t *)sprites->Buffer()->Data() +
+		                      sprites->ByteOffset());
+		for (uint32_t i = 0; i < count; i++, rec += NX_ATLAS_RECORD_FLOATS) {
+			SkColor c = colors_in ? (SkColor)colors_in[i] : SK_ColorWHITE;
+			float a = rec[8];
+			if (!(a >= 0.f))
+				a = 0.f;
+			else if (a > 1.f)
+				a = 1.f;
+			atlas_colors[i] = SkColorSetA(
+			    c, (U8CPU)(SkColorGetA(c) * a + 0.5f));
+		}
+	}
+
+	SkPaint p;
+	p.setAntiAlias(true);
+	p.setBlendMode(context->state->blend_mode);
+	p.setAlphaf((float)context->state->global_alpha);
+	p.setImageFilter(shadow_filter(context));
+	// drawAtlas does not support cubic resampling; "high" quality falls back
+	// to the medium (mipmapped bilinear) sampler.
+	SkSamplingOptions sampling = sampling_for(context);
+	if (sampling.useCubic)
+		sampling = SkSamplingOptions(SkFilterMode::kLinear, SkMipmapMode::kLinear);
+	damage_draw(context, bounds, p);
+	cr->drawAtlas(
+	    image.get(), SkSpan<const SkRSXform>(atlas_xforms.data(), count),
+	    SkSpan<const SkRect>(atlas_rects.data(), count),
+	    modulate ? SkSpan<const SkColor>(atlas_colors.data(), count)
+	             : SkSpan<const SkColor>(),
+	    SkBlendMode::kModulate, sampling, bounds.isFinite() ? &bounds : nullptr,
+	    &p);
+}
+
 // ---- gradients ----
 // Build (lazily) the SkShader from the gradient's buffered stops.
 static void build_gradient_shader(nx_canvas_gradient_t *g) {
@@ -2486,90 +3088,307 @@ void nx_canvas_context_2d_set_stroke_style_gradient(
 	context->state->stroke_source_type = SOURCE_GRADIENT;
 }
 
-// ---- encode (PNG via Skia; JPEG/WebP via turbojpeg/libwebp over raw BGRA) ----
-static uint8_t *bgra_to_rgb(const uint8_t *bgra, int width, int height,
-                            int stride) {
-	uint8_t *rgb = (uint8_t *)malloc((size_t)width * height * 3);
-	if (!rgb)
-		return NULL;
+// ---- encode (PNG via libpng; JPEG/WebP via turbojpeg/libwebp over raw BGRA) ----
+
+// Encoder tuning. `quality` is the web toBlob/convertToBlob argument; `level`
+// and `effort` are nx.js extensions (-1 = format default).
+typedef struct {
+	int type;        // 0=png, 1=jpeg, 2=webp
+	double quality;  // 0..1 (JPEG / WebP)
+	int level;       // PNG zlib level 0-9 (default 6)
+	int effort;      // 0-6: WebP method; PNG filter search (< 3 = fixed
+	                 // filter); JPEG accurate DCT at >= 5
+} encode_opts_t;
+
+// Encoder output buffer (malloc'd; grows geometrically). Handed to the result
+// ArrayBuffer as-is, so there is no final copy.
+typedef struct {
+	uint8_t *data;
+	size_t size, cap;
+} encode_out_t;
+
+static bool out_reserve(encode_out_t *o, size_t extra) {
+	if (o->size + extra <= o->cap)
+		return true;
+	size_t cap = o->cap ? o->cap : 64 * 1024;
+	while (cap < o->size + extra)
+		cap *= 2;
+	uint8_t *p = (uint8_t *)realloc(o->data, cap);
+	if (!p)
+		return false;
+	o->data = p;
+	o->cap = cap;
+	return true;
+}
+
+static bool out_write(encode_out_t *o, const void *src, size_t n) {
+	if (!out_reserve(o, n))
+		return false;
+	memcpy(o->data + o->size, src, n);
+	o->size += n;
+	return true;
+}
+
+// Freed libpng allocations kept for the next encode on the same worker.
+#define ENC_PNG_POOL_SIZE 32
+
+typedef struct {
+	void *ptr;
+	size_t size;
+} pool_block_t;
+
+// Per-worker encoder state, reused by every encode that runs on the same
+// threadpool thread: the turbojpeg handle, the conversion scratch that used
+// to be created (and, for JPEG, filled with a whole converted frame) per call,
+// and the memory of the PNG and WebP encoders. Worker threads live for the
+// process, so nothing here is ever torn down.
+typedef struct {
+	tjhandle tj;
+	uint8_t *rgb;  // JPEG: straight RGB frame (translucent canvases only)
+	size_t rgb_cap;
+	uint8_t *row;  // PNG: one unpremultiplied row
+	size_t row_cap;
+	uint8_t *argb; // WebP: the picture's ARGB pixels
+	size_t argb_cap;
+	// libpng has no way to reset a write struct for another image, so the
+	// structs are created per encode, but from this pool: their allocations
+	// (zlib's deflate state and window are the bulk) are reused.
+	pool_block_t png_pool[ENC_PNG_POOL_SIZE];
+	int png_pool_count;
+} encode_scratch_t;
+static thread_local encode_scratch_t enc_scratch;
+
+static bool scratch_reserve(uint8_t **buf, size_t *cap, size_t size) {
+	if (size <= *cap)
+		return true;
+	uint8_t *p = (uint8_t *)realloc(*buf, size);
+	if (!p)
+		return false;
+	*buf = p;
+	*cap = size;
+	return true;
+}
+
+// True if every pixel is fully opaque (the common case for the screen and
+// most offscreen scenes), letting JPEG read the BGRA frame directly and PNG
+// drop its alpha channel.
+static bool is_opaque(const uint8_t *bgra, int width, int height, int stride) {
 	for (int y = 0; y < height; y++) {
-		const uint8_t *row = bgra + y * stride;
+		const uint32_t *row = (const uint32_t *)(bgra + (size_t)y * stride);
+		for (int x = 0; x < width; x++)
+			if ((row[x] >> 24) != 0xff)
+				return false;
+	}
+	return true;
+}
+
+// Composite premultiplied BGRA over white into straight RGB (JPEG has no
+// alpha).
+static void bgra_to_rgb(const uint8_t *bgra, int width, int height, int stride,
+                        uint8_t *rgb) {
+	for (int y = 0; y < height; y++) {
+		const uint8_t *row = bgra + (size_t)y * stride;
+		uint8_t *dst = rgb + (size_t)y * width * 3;
 		for (int x = 0; x < width; x++) {
 			uint8_t b = row[x * 4 + 0], g = row[x * 4 + 1], r = row[x * 4 + 2],
 			        a = row[x * 4 + 3];
 			if (a == 0) {
-				rgb[(y * width + x) * 3 + 0] = 255;
-				rgb[(y * width + x) * 3 + 1] = 255;
-				rgb[(y * width + x) * 3 + 2] = 255;
+				dst[x * 3 + 0] = 255;
+				dst[x * 3 + 1] = 255;
+				dst[x * 3 + 2] = 255;
 			} else if (a == 255) {
-				rgb[(y * width + x) * 3 + 0] = r;
-				rgb[(y * width + x) * 3 + 1] = g;
-				rgb[(y * width + x) * 3 + 2] = b;
+				dst[x * 3 + 0] = r;
+				dst[x * 3 + 1] = g;
+				dst[x * 3 + 2] = b;
 			} else {
 				float inv_a = 1.0f - a / 255.0f;
-				rgb[(y * width + x) * 3 + 0] = (uint8_t)(r + 255 * inv_a + 0.5f);
-				rgb[(y * width + x) * 3 + 1] = (uint8_t)(g + 255 * inv_a + 0.5f);
-				rgb[(y * width + x) * 3 + 2] = (uint8_t)(b + 255 * inv_a + 0.5f);
+				dst[x * 3 + 0] = (uint8_t)(r + 255 * inv_a + 0.5f);
+				dst[x * 3 + 1] = (uint8_t)(g + 255 * inv_a + 0.5f);
+				dst[x * 3 + 2] = (uint8_t)(b + 255 * inv_a + 0.5f);
 			}
 		}
 	}
-	return rgb;
 }
-// Encode raw premultiplied BGRA (w,h,stride) to PNG/JPEG/WebP. type: 0=png,
-// 1=jpeg, 2=webp.
-static int encode_pixels(const uint8_t *data, int width, int height,
-                         int stride, int type, double quality, uint8_t **out,
-                         size_t *out_size) {
-	if (type == 1) {
-		uint8_t *rgb = bgra_to_rgb(data, width, height, stride);
-		if (!rgb)
+
+static int encode_jpeg(const uint8_t *data, int width, int height, int stride,
+                       const encode_opts_t *opts, encode_out_t *out) {
+	encode_scratch_t *s = &enc_scratch;
+	if (!s->tj && !(s->tj = tjInitCompress()))
+		return -1;
+	const uint8_t *src = data;
+	int pitch = stride;
+	int format = TJPF_BGRX;
+	if (!is_opaque(data, width, height, stride)) {
+		if (!scratch_reserve(&s->rgb, &s->rgb_cap, (size_t)width * height * 3))
 			return -1;
-		tjhandle h = tjInitCompress();
-		if (!h) { free(rgb); return -1; }
-		unsigned char *jpeg = NULL;
-		unsigned long jsize = 0;
-		int r = tjCompress2(h, rgb, width, 0, height, TJPF_RGB, &jpeg, &jsize,
-		                    TJSAMP_420, (int)(quality * 100), TJFLAG_FASTDCT);
-		free(rgb);
-		tjDestroy(h);
-		if (r != 0) { if (jpeg) tjFree(jpeg); return -1; }
-		*out = (uint8_t *)malloc(jsize);
-		if (!*out) { tjFree(jpeg); return -1; }
-		memcpy(*out, jpeg, jsize);
-		*out_size = jsize;
-		tjFree(jpeg);
-		return 0;
+		bgra_to_rgb(data, width, height, stride, s->rgb);
+		src = s->rgb;
+		pitch = width * 3;
+		format = TJPF_RGB;
+	}
+	// Compress straight into the output buffer, reserved at turbojpeg's
+	// worst-case bound (NOREALLOC: no tjAlloc'd intermediate to copy out of).
+	unsigned long size = tjBufSize(width, height, TJSAMP_420);
+	if (size == (unsigned long)-1 || !out_reserve(out, size))
+		return -1;
+	unsigned char *dst = out->data + out->size;
+	int flags = TJFLAG_NOREALLOC |
+	            (opts->effort >= 5 ? TJFLAG_ACCURATEDCT : TJFLAG_FASTDCT);
+	if (tjCompress2(s->tj, src, width, pitch, height, format, &dst, &size,
+	                TJSAMP_420, (int)(opts->quality * 100), flags) != 0)
+		return -1;
+	out->size += size;
+	return 0;
+}
+
+static int webp_write(const uint8_t *data, size_t size,
+                      const WebPPicture *picture) {
+	return out_write((encode_out_t *)picture->custom_ptr, data, size) ? 1 : 0;
+}
+
+static int encode_webp(const uint8_t *data, int width, int height, int stride,
+                       const encode_opts_t *opts, encode_out_t *out) {
+	encode_scratch_t *s = &enc_scratch;
+	WebPConfig config;
+	WebPPicture picture;
+	if (!WebPConfigInit(&config) || !WebPPictureInit(&picture))
+		return -1;
+	config.quality = (float)(opts->quality * 100);
+	if (opts->effort >= 0)
+		config.method = opts->effort > 6 ? 6 : opts->effort;
+	// The picture's ARGB pixels live in the worker's scratch rather than in
+	// a buffer WebPPictureImportBGRA() allocates per call (WebPPictureFree()
+	// only frees what libwebp allocated). ARGB words are BGRA bytes in
+	// little-endian memory, so the import is a copy; WebPEncode() may modify
+	// the pixels (transparent areas), so the canvas can't be used directly.
+	size_t row_size = (size_t)width * 4;
+	if (!scratch_reserve(&s->argb, &s->argb_cap, row_size * height))
+		return -1;
+	for (int y = 0; y < height; y++)
+		memcpy(s->argb + y * row_size, data + (size_t)y * stride, row_size);
+	picture.use_argb = 1;
+	picture.width = width;
+	picture.height = height;
+	picture.argb = (uint32_t *)s->argb;
+	picture.argb_stride = width;
+	picture.writer = webp_write;
+	picture.custom_ptr = out;
+	int ok = WebPEncode(&config, &picture);
+	WebPPictureFree(&picture);
+	return ok ? 0 : -1;
+}
+
+static void png_write_cb(png_structp png, png_bytep data, png_size_t size) {
+	if (!out_write((encode_out_t *)png_get_io_ptr(png), data, size))
+		png_error(png, "out of memory");
+}
+static void png_flush_cb(png_structp) {}
+
+// libpng allocator over the worker's pool. Each block is prefixed with its
+// size, so that it can be matched on reuse.
+static png_voidp png_pool_malloc(png_structp, png_alloc_size_t size) {
+	encode_scratch_t *s = &enc_scratch;
+	for (int i = 0; i < s->png_pool_count; i++) {
+		pool_block_t *b = &s->png_pool[i];
+		if (b->size >= size && b->size <= size * 2) {
+			void *p = b->ptr;
+			*b = s->png_pool[--s->png_pool_count];
+			return (uint8_t *)p + sizeof(max_align_t);
+		}
 	}
-	if (type == 2) {
-		uint8_t *webp = NULL;
-		size_t wsize = WebPEncodeBGRA(data, width, height, stride,
-		                              (float)(quality * 100), &webp);
-		if (wsize == 0 || !webp)
-			return -1;
-		*out = (uint8_t *)malloc(wsize);
-		if (!*out) { WebPFree(webp); return -1; }
-		memcpy(*out, webp, wsize);
-		*out_size = wsize;
-		WebPFree(webp);
-		return 0;
+	void *p = malloc(sizeof(max_align_t) + size);
+	if (!p)
+		return NULL;
+	*(size_t *)p = size;
+	return (uint8_t *)p + sizeof(max_align_t);
+}
+
+static void png_pool_free(png_structp, png_voidp ptr) {
+	if (!ptr)
+		return;
+	encode_scratch_t *s = &enc_scratch;
+	void *p = (uint8_t *)ptr - sizeof(max_align_t);
+	if (s->png_pool_count < ENC_PNG_POOL_SIZE) {
+		s->png_pool[s->png_pool_count++] = {p, *(size_t *)p};
+	} else {
+		free(p);
 	}
-	// PNG via Skia.
-	SkImageInfo ii = SkImageInfo::Make(width, height, kBGRA_8888_SkColorType,
-	                                   kPremul_SkAlphaType);
-	SkPixmap pm(ii, data, stride);
-	SkDynamicMemoryWStream stream;
-	SkPngEncoder::Options opts;
-	if (!SkPngEncoder::Encode(&stream, pm, opts))
+}
+
+// Incremental PNG: rows are unpremultiplied one at a time into a single
+// scratch row and streamed through libpng, so the encode never holds a second
+// full-frame buffer (the previous Skia path built an unpremultiplied copy and
+// then a chunked stream that was copied out at the end).
+static int encode_png(const uint8_t *data, int width, int height, int stride,
+                      const encode_opts_t *opts, encode_out_t *out) {
+	encode_scratch_t *s = &enc_scratch;
+	bool opaque = is_opaque(data, width, height, stride);
+	int channels = opaque ? 3 : 4;
+	if (!scratch_reserve(&s->row, &s->row_cap, (size_t)width * channels))
 		return -1;
-	size_t sz = stream.bytesWritten();
-	*out = (uint8_t *)malloc(sz);
-	if (!*out)
+	png_structp png = png_create_write_struct_2(
+	    PNG_LIBPNG_VER_STRING, NULL, NULL, NULL, NULL, png_pool_malloc,
+	    png_pool_free);
+	if (!png)
 		return -1;
-	stream.copyTo(*out);
-	*out_size = sz;
+	png_infop info = png_create_info_struct(png);
+	if (!info) {
+		png_destroy_write_struct(&png, NULL);
+		return -1;
+	}
+	if (setjmp(png_jmpbuf(png))) {
+		png_destroy_write_struct(&png, &info);
+		return -1;
+	}
+	png_set_write_fn(png, out, png_write_cb, png_flush_cb);
+	png_set_IHDR(png, info, width, height, 8,
+	             opaque ? PNG_COLOR_TYPE_RGB : PNG_COLOR_TYPE_RGB_ALPHA,
+	             PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT,
+	             PNG_FILTER_TYPE_DEFAULT);
+	png_set_compression_level(png, opts->level >= 0 ? opts->level : 6);
+	// Low effort skips libpng's per-row adaptive filter search (it tries all
+	// five filters on every row), which dominates fast-level encodes.
+	if (opts->effort >= 0 && opts->effort < 3)
+		png_set_filter(png, PNG_FILTER_TYPE_BASE,
+		               opts->effort == 0 ? PNG_FILTER_NONE : PNG_FILTER_SUB);
+	png_write_info(png, info);
+	png_set_bgr(png);
+	for (int y = 0; y < height; y++) {
+		const uint8_t *src = data + (size_t)y * stride;
+		uint8_t *dst = s->row;
+		for (int x = 0; x < width; x++, src += 4, dst += channels) {
+			uint8_t a = src[3];
+			if (opaque || a == 255) {
+				dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2];
+			} else if (a == 0) {
+				dst[0] = dst[1] = dst[2] = 0;
+			} else {
+				float alphaR = (float)255 / a;
+				dst[0] = (uint8_t)((float)src[0] * alphaR);
+				dst[1] = (uint8_t)((float)src[1] * alphaR);
+				dst[2] = (uint8_t)((float)src[2] * alphaR);
+			}
+			if (!opaque)
+				dst[3] = a;
+		}
+		png_write_row(png, s->row);
+	}
+	png_write_end(png, info);
+	png_destroy_write_struct(&png, &info);
 	return 0;
 }
 
+// Encode raw premultiplied BGRA (w,h,stride), appending to `out`.
+static int encode_pixels(const uint8_t *data, int width, int height,
+                         int stride, const encode_opts_t *opts,
+                         encode_out_t *out) {
+	switch (opts->type) {
+	case 1: return encode_jpeg(data, width, height, stride, opts, out);
+	case 2: return encode_webp(data, width, height, stride, opts, out);
+	default: return encode_png(data, width, height, stride, opts, out);
+	}
+}
+
 static int mime_to_type_code(const char *type) {
 	if (type) {
 		if (!strcmp(type, "image/jpeg")) return 1;
@@ -2585,61 +3404,148 @@ static const char *type_code_to_mime(int type) {
 	}
 }
 
+// Read the (type, quality, level, effort) arguments starting at info[first]
+// (the canvasToBuffer / toDataURL / frameEncoderNew tail).
+static void get_encode_opts(const FunctionCallbackInfo<Value> &info, int first,
+                            encode_opts_t *opts) {
+	Isolate *iso = info.GetIsolate();
+	Local<Context> jsctx = iso->GetCurrentContext();
+	opts->type = 0;
+	opts->quality = 0.92;
+	opts->level = -1;
+	opts->effort = -1;
+	if (info.Length() > first && !info[first]->IsUndefined()) {
+		String::Utf8Value type_str(iso, info[first]);
+		opts->type = mime_to_type_code(*type_str);
+	}
+	if (info.Length() > first + 1)
+		if (!info[first + 1]->NumberValue(jsctx).To(&opts->quality) ||
+		    isnan(opts->quality))
+			opts->quality = 0.92;
+	if (opts->quality < 0.0) opts->quality = 0.0;
+	if (opts->quality > 1.0) opts->quality = 1.0;
+	int32_t v;
+	if (info.Length() > first + 2 && info[first + 2]->IsNumber() &&
+	    info[first + 2]->Int32Value(jsctx).To(&v))
+		opts->level = v < 0 ? 0 : v > 9 ? 9 : v;
+	if (info.Length() > first + 3 && info[first + 3]->IsNumber() &&
+	    info[first + 3]->Int32Value(jsctx).To(&v))
+		opts->effort = v < 0 ? 0 : v > 6 ? 6 : v;
+}
+
+// Full-frame snapshot buffers recycled between encodes, so a capture loop
+// doesn't allocate (and the allocator doesn't churn) a frame per call. Only
+// the JS thread acquires (snapshot) and releases (after_work / toDataURL), so
+// no locking is needed. A buffer of a stale size is evicted in favour of the
+// current one.
+#define NX_SNAPSHOT_POOL_SIZE 2
+static struct {
+	uint8_t *data;
+	size_t size;
+} snapshot_pool[NX_SNAPSHOT_POOL_SIZE];
+
+static uint8_t *snapshot_acquire(size_t size) {
+	for (int i = 0; i < NX_SNAPSHOT_POOL_SIZE; i++) {
+		if (snapshot_pool[i].data && snapshot_pool[i].size == size) {
+			uint8_t *p = snapshot_pool[i].data;
+			snapshot_pool[i].data = nullptr;
+			return p;
+		}
+	}
+	return (uint8_t *)malloc(size);
+}
+
+static void snapshot_release(uint8_t *p, size_t size) {
+	if (!p)
+		return;
+	int slot = -1;
+	for (int i = 0; i < NX_SNAPSHOT_POOL_SIZE; i++) {
+		if (!snapshot_pool[i].data) {
+			slot = i;
+			break;
+		}
+		if (slot < 0 && snapshot_pool[i].size != size)
+			slot = i;
+	}
+	if (slot < 0) {
+		free(p);
+		return;
+	}
+	free(snapshot_pool[slot].data);
+	snapshot_pool[slot].data = p;
+	snapshot_pool[slot].size = size;
+}
+
+// Copy the canvas's current pixels into `dst` (w*h*4 bytes, stride w*4),
+// rasterizing any deferred draws first. A canvas with no pixels yet reads as
+// transparent.
+static void snapshot_into(nx_canvas_t *canvas, uint8_t *dst, size_t size) {
+	bool owned = false;
+	uint8_t *src = canvas->width && canvas->height
+	                   ? canvas_readable_pixels(canvas, &owned)
+	                   : nullptr;
+	if (src) {
+		memcpy(dst, src, size);
+		if (owned)
+			free(src);
+	} else {
+		memset(dst, 0, size);
+	}
+}
+
 // Async encode: snapshot the canvas pixels (BGRA copy) on the main thread, then
 // encode on the thread pool.
 typedef struct {
-	uint8_t *pixels;  // owned BGRA copy
+	uint8_t *pixels;  // pooled BGRA copy (snapshot_release'd in after_work)
+	size_t pixels_size;
 	int width, height, stride;
-	int type;
-	double quality;
-	uint8_t *result;
-	size_t result_size;
+	encode_opts_t opts;
+	encode_out_t result;
 	int err;
 } encode_async_t;
 
 static uint8_t *snapshot_pixels(nx_canvas_t *canvas, int *w, int *h,
-                                int *stride) {
+                                int *stride, size_t *size) {
 	int cw = canvas->width ? (int)canvas->width : 1;
 	int ch = canvas->height ? (int)canvas->height : 1;
 	int st = cw * 4;
-	uint8_t *copy = (uint8_t *)calloc(1, (size_t)st * ch);
-	if (copy && canvas->width && canvas->height) {
-		bool owned = false;
-		uint8_t *src = canvas_readable_pixels(canvas, &owned);
-		if (src) {
-			memcpy(copy, src, (size_t)st * ch);
-			if (owned)
-				free(src);
-		}
-	}
 	*w = cw;
 	*h = ch;
 	*stride = st;
+	*size = (size_t)st * ch;
+	uint8_t *copy = snapshot_acquire(*size);
+	if (copy)
+		snapshot_into(canvas, copy, *size);
 	return copy;
 }
 
 void nx_canvas_encode_do(nx_work_t *req) {
 	encode_async_t *data = (encode_async_t *)req->data;
+	if (!data->pixels) {
+		data->err = -1;
+		return;
+	}
 	data->err = encode_pixels(data->pixels, data->width, data->height,
-	                          data->stride, data->type, data->quality,
-	                          &data->result, &data->result_size);
+	                          data->stride, &data->opts, &data->result);
 }
 MaybeLocal<Value> nx_canvas_encode_cb(Isolate *iso, nx_work_t *req) {
 	encode_async_t *data = (encode_async_t *)req->data;
-	free(data->pixels);
+	snapshot_release(data->pixels, data->pixels_size);
 	data->pixels = nullptr;
+	uint8_t *buf = data->result.data;
+	size_t size = data->result.size;
+	data->result.data = nullptr;
 	if (data->err) {
+		free(buf);
 		nx_throw(iso, "Failed to encode image");
 		return MaybeLocal<Value>();
 	}
-	uint8_t *buf = data->result;
-	size_t size = data->result_size;
-	data->result = nullptr;
 	std::unique_ptr<BackingStore> bs = ArrayBuffer::NewBackingStore(
 	    buf, size, [](void *p, size_t, void *) { free(p); }, nullptr);
 	return ArrayBuffer::New(iso, std::move(bs)).As<Value>();
 }
 
+// canvasToBuffer(canvas, type?, quality?, level?, effort?)
 void nx_canvas_to_buffer(const FunctionCallbackInfo<Value> &info) {
 	Isolate *iso = info.GetIsolate();
 	nx_canvas_t *canvas = nx_get_canvas(iso, info[0]);
@@ -2647,22 +3553,10 @@ void nx_canvas_to_buffer(const FunctionCallbackInfo<Value> &info) {
 		nx_throw(iso, "Expected a canvas object");
 		return;
 	}
-	int type_code = 0;
-	double quality = 0.92;
-	if (info.Length() > 1 && !info[1]->IsUndefined()) {
-		String::Utf8Value type_str(iso, info[1]);
-		type_code = mime_to_type_code(*type_str);
-	}
-	if (info.Length() > 2)
-		if (!info[2]->NumberValue(iso->GetCurrentContext()).To(&quality))
-			quality = 0.92;
-	if (quality < 0.0) quality = 0.0;
-	if (quality > 1.0) quality = 1.0;
 	NX_INIT_WORK_T(encode_async_t);
-	data->pixels =
-	    snapshot_pixels(canvas, &data->width, &data->height, &data->stride);
-	data->type = type_code;
-	data->quality = quality;
+	get_encode_opts(info, 1, &data->opts);
+	data->pixels = snapshot_pixels(canvas, &data->width, &data->height,
+	                               &data->stride, &data->pixels_size);
 	info.GetReturnValue().Set(
 	    nx_queue_async(iso, req, nx_canvas_encode_do, nx_canvas_encode_cb));
 }
@@ -2674,29 +3568,22 @@ void nx_canvas_proto_to_data_url(const FunctionCallbackInfo<Value> &info) {
 		nx_throw(iso, "Expected a canvas object");
 		return;
 	}
-	int type_code = 0;
-	double quality = 0.92;
-	if (info.Length() > 0 && !info[0]->IsUndefined()) {
-		String::Utf8Value type_str(iso, info[0]);
-		type_code = mime_to_type_code(*type_str);
-	}
-	if (info.Length() > 1)
-		if (!info[1]->NumberValue(iso->GetCurrentContext()).To(&quality))
-			quality = 0.92;
-	if (quality < 0.0) quality = 0.0;
-	if (quality > 1.0) quality = 1.0;
+	encode_opts_t opts;
+	get_encode_opts(info, 0, &opts);
 	int w, h, stride;
-	uint8_t *pixels = snapshot_pixels(canvas, &w, &h, &stride);
-	uint8_t *buf = NULL;
-	size_t buf_size = 0;
-	int rc = encode_pixels(pixels, w, h, stride, type_code, quality, &buf,
-	                       &buf_size);
-	free(pixels);
+	size_t pixels_size;
+	uint8_t *pixels = snapshot_pixels(canvas, &w, &h, &stride, &pixels_size);
+	encode_out_t out = {nullptr, 0, 0};
+	int rc = pixels ? encode_pixels(pixels, w, h, stride, &opts, &out) : -1;
+	snapshot_release(pixels, pixels_size);
 	if (rc != 0) {
+		free(out.data);
 		nx_throw(iso, "Failed to encode data URL");
 		return;
 	}
-	const char *mime = type_code_to_mime(type_code);
+	uint8_t *buf = out.data;
+	size_t buf_size = out.size;
+	const char *mime = type_code_to_mime(opts.type);
 	size_t b64_len = 0;
 	mbedtls_base64_encode(NULL, 0, &b64_len, buf, buf_size);
 	size_t prefix_len = 5 + strlen(mime) + 8;
@@ -2716,6 +3603,206 @@ void nx_canvas_proto_to_data_url(const FunctionCallbackInfo<Value> &info) {
 	free(data_url);
 }
 
+// ---- FrameEncoder (nx.js extension): steady-memory frame capture ----
+//
+// A fixed ring of slots, each owning a snapshot buffer and an output buffer
+// that are reused frame after frame, so a capture loop (JPEG sequence /
+// MJPEG, PNG, WebP) allocates nothing per frame once warmed up. A frame's
+// ArrayBuffer aliases its slot's output and is detached when that slot is
+// reused `slot_count` encodes later. When the next slot is still encoding the
+// frame is dropped (frameEncoderEncode returns null) rather than queueing
+// unbounded work behind a slow encoder.
+#define NX_FRAME_ENCODER_MAX_SLOTS 8
+
+// Output buffer shared between a slot and the frame ArrayBuffer aliasing it.
+// V8 may run the backing-store deleter on any thread, hence the atomic count.
+typedef struct {
+	encode_out_t out;
+	std::atomic<int> refs;
+} nx_frame_buf_t;
+
+static void frame_buf_unref(nx_frame_buf_t *b) {
+	if (b && b->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		free(b->out.data);
+		delete b;
+	}
+}
+
+typedef struct {
+	uint8_t *pixels;
+	size_t pixels_size;
+	nx_frame_buf_t *buf;
+	bool busy;
+	Global<ArrayBuffer> frame;  // last frame handed to JS from this slot
+} nx_frame_slot_t;
+
+typedef struct {
+	encode_opts_t opts;
+	int slot_count;
+	int next;
+	nx_frame_slot_t slots[NX_FRAME_ENCODER_MAX_SLOTS];
+} nx_frame_encoder_t;
+
+void free_frame_encoder(nx_frame_encoder_t *e) {
+	for (int i = 0; i < e->slot_count; i++) {
+		free(e->slots[i].pixels);
+		frame_buf_unref(e->slots[i].buf);
+		e->slots[i].frame.Reset();
+	}
+	delete e;
+}
+
+// frameEncoderNew(type?, quality?, level?, effort?, slots?)
+void nx_frame_encoder_new(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	int32_t slots = 2;
+	if (info.Length() > 4 && info[4]->IsNumber() &&
+	    !info[4]->Int32Value(iso->GetCurrentContext()).To(&slots))
+		return;
+	if (slots < 1 || slots > NX_FRAME_ENCODER_MAX_SLOTS) {
+		iso->ThrowException(Exception::RangeError(
+		    nx_str(iso, "FrameEncoder frames must be between 1 and 8")));
+		return;
+	}
+	nx_frame_encoder_t *e = new nx_frame_encoder_t();
+	get_encode_opts(info, 0, &e->opts);
+	e->slot_count = slots;
+	Local<Object> obj = nx::NewWrapped(iso);
+	nx::Wrap<nx_frame_encoder_t>(iso, obj, e, free_frame_encoder);
+	info.GetReturnValue().Set(obj);
+}
+
+typedef struct {
+	nx_frame_encoder_t *encoder;
+	nx_frame_slot_t *slot;
+	Global<Value> encoder_val;  // keeps the encoder (and its slots) alive
+	int width, height, stride;
+	int err;
+} frame_encode_async_t;
+
+void nx_frame_encoder_encode_do(nx_work_t *req) {
+	frame_encode_async_t *data = (frame_encode_async_t *)req->data;
+	nx_frame_slot_t *slot = data->slot;
+	// The buffer is exclusively the slot's here (see nx_frame_encoder_encode),
+	// so it is refilled in place, growing only while frames get larger.
+	slot->buf->out.size = 0;
+	data->err = encode_pixels(slot->pixels, data->width, data->height,
+	                          data->stride, &data->encoder->opts,
+	                          &slot->buf->out);
+}
+
+MaybeLocal<Value> nx_frame_encoder_encode_cb(Isolate *iso, nx_work_t *req) {
+	frame_encode_async_t *data = (frame_encode_async_t *)req->data;
+	nx_frame_slot_t *slot = data->slot;
+	slot->busy = false;
+	if (data->err) {
+		nx_throw(iso, "Failed to encode image");
+		return MaybeLocal<Value>();
+	}
+	nx_frame_buf_t *b = slot->buf;
+	b->refs.fetch_add(1, std::memory_order_relaxed);
+	std::unique_ptr<BackingStore> bs = ArrayBuffer::NewBackingStore(
+	    b->out.data, b->out.size,
+	    [](void *, size_t, void *b) { frame_buf_unref((nx_frame_buf_t *)b); },
+	    b);
+	Local<ArrayBuffer> ab = ArrayBuffer::New(iso, std::move(bs));
+	slot->frame.Reset(iso, ab);
+	return ab.As<Value>();
+}
+
+// frameEncoderEncode(encoder, canvas) -> Promise<ArrayBuffer> | null
+void nx_frame_encoder_encode(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	nx_frame_encoder_t *e = nx::Unwrap<nx_frame_encoder_t>(info[0]);
+	nx_canvas_t *canvas = nx_get_canvas(iso, info[1]);
+	if (!e || !canvas) {
+		nx_throw(iso, "Expected a FrameEncoder and a canvas");
+		return;
+	}
+	nx_frame_slot_t *slot = &e->slots[e->next];
+	if (slot->busy) {
+		info.GetReturnValue().SetNull();
+		return;
+	}
+
+	// Retire the frame this slot produced `slot_count` encodes ago: detaching
+	// its ArrayBuffer drops the alias, leaving the buffer to the slot again.
+	if (!slot->frame.IsEmpty()) {
+		Local<ArrayBuffer> old = slot->frame.Get(iso);
+		if (old->IsDetachable())
+			(void)old->Detach(Local<Value>());
+		slot->frame.Reset();
+	}
+	if (slot->buf && slot->buf->refs.load(std::memory_order_acquire) != 1) {
+		// Still referenced elsewhere (e.g. a non-detachable buffer): leave it
+		// to that owner and start a fresh one.
+		frame_buf_unref(slot->buf);
+		slot->buf = nullptr;
+	}
+	if (!slot->buf) {
+		slot->buf = new nx_frame_buf_t();
+		slot->buf->refs.store(1, std::memory_order_relaxed);
+	}
+
+	int w = canvas->width ? (int)canvas->width : 1;
+	int h = canvas->height ? (int)canvas->height : 1;
+	size_t size = (size_t)w * h * 4;
+	if (slot->pixels_size != size) {
+		free(slot->pixels);
+		slot->pixels = (uint8_t *)nx_alloc(iso, size);
+		slot->pixels_size = slot->pixels ? size : 0;
+		if (!slot->pixels)
+			return;
+	}
+	snapshot_into(canvas, slot->pixels, size);
+
+	e->next = (e->next + 1) % e->slot_count;
+	slot->busy = true;
+	NX_INIT_WORK_T_CPP(frame_encode_async_t);
+	data->encoder = e;
+	data->slot = slot;
+	data->encoder_val.Reset(iso, info[0]);
+	data->width = w;
+	data->height = h;
+	data->stride = w * 4;
+	info.GetReturnValue().Set(nx_queue_async(
+	    iso, req, nx_frame_encoder_encode_do, nx_frame_encoder_encode_cb));
+}
+
+// ---- present statistics (raster damage tracking) ----
+void nx_canvas_present_stats(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	Local<Context> jsctx = iso->GetCurrentContext();
+	nx_canvas_t *canvas = nx_get_canvas(iso, info[0]);
+	if (!canvas)
+		return;
+	const nx_canvas_damage_stats_t &st = canvas->damage_stats;
+	Local<Object> obj = Object::New(iso);
+	auto set = [&](const char *k, double v) {
+		obj->Set(jsctx, nx_str(iso, k), Number::New(iso, v)).Check();
+	};
+	set("frames", (double)st.frames);
+	set("idleFrames", (double)st.idle_frames);
+	set("totalPixels", (double)st.total_pixels);
+	set("lastRects", st.last_rects);
+	set("lastPixels", st.last_pixels);
+	info.GetReturnValue().Set(obj);
+}
+
+// canvasSetRasterThreads(canvas, threads) — see nx_canvas_set_raster_threads.
+void nx_canvas_set_raster_threads_js(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	nx_canvas_t *canvas = nx_get_canvas(iso, info[0]);
+	if (!canvas) {
+		nx_throw(iso, "Expected a canvas object");
+		return;
+	}
+	int32_t threads;
+	if (!info[1]->Int32Value(iso->GetCurrentContext()).To(&threads))
+		return;
+	nx_canvas_set_raster_threads(canvas, threads);
+}
+
 } // namespace
 
 // ---- shared (non-namespace) symbols ----
@@ -2730,6 +3817,19 @@ void nx_image_release_cache(nx_image_t *image) {
 	}
 }
 
+// Canvases currently backed by a GPU surface (main thread only).
+static int gpu_canvases = 0;
+
+// Declared in image.h: video.cc asks the decoder for YUV frames only when
+// they can be converted on the GPU (see frame_image()).
+bool nx_canvas_wants_yuv_frames(void) {
+#if defined(SK_GL)
+	return gpu_canvases > 0;
+#else
+	return false;
+#endif
+}
+
 bool nx_resolve_round_rect_radii(Isolate *iso, Local<Value> radii,
                                  SkVector out[4]) {
 	return resolve_round_rect_radii_impl(iso, radii, out);
@@ -2754,9 +3854,75 @@ uint8_t *nx_canvas_pixels(nx_canvas_t *c) { return c ? c->data : nullptr; }
 uint32_t nx_canvas_width(nx_canvas_t *c) { return c ? c->width : 0; }
 uint32_t nx_canvas_height(nx_canvas_t *c) { return c ? c->height : 0; }
 
+int nx_canvas_take_damage(nx_canvas_t *c, uint32_t *rects, int max_rects,
+                          bool full) {
+	if (!c || max_rects <= 0)
+		return 0;
+	if (full)
+		damage_all(c);
+	if (c->damage_count > max_rects) {
+		for (int i = 1; i < c->damage_count; i++)
+			c->damage[0].join(c->damage[i]);
+		c->damage_count = 1;
+	}
+	int n = c->damage_count;
+	uint32_t pixels = 0;
+	for (int i = 0; i < n; i++) {
+		const SkIRect &r = c->damage[i];
+		rects[i * 4 + 0] = (uint32_t)r.x();
+		rects[i * 4 + 1] = (uint32_t)r.y();
+		rects[i * 4 + 2] = (uint32_t)r.width();
+		rects[i * 4 + 3] = (uint32_t)r.height();
+		pixels += (uint32_t)irect_area(r);
+	}
+	c->damage_count = 0;
+	nx_canvas_damage_stats_t *st = &c->damage_stats;
+	st->frames++;
+	if (n == 0)
+		st->idle_frames++;
+	st->last_rects = (uint32_t)n;
+	st->last_pixels = pixels;
+	st->total_pixels += pixels;
+	return n;
+}
+
+void nx_canvas_set_raster_threads(nx_canvas_t *c, int threads) {
+	if (!c)
+		return;
+	if (threads < 0)
+		threads = 0;
+	if (threads > NX_CANVAS_MAX_RASTER_THREADS)
+		threads = NX_CANVAS_MAX_RASTER_THREADS;
+	nx_canvas_flush_deferred(c);
+	// Entering deferred mode: the first recording starts from the surface
+	// canvas's current transform (its clips are replayed from the state stack).
+	if (!c->raster_threads && threads && c->surface && !c->gpu)
+		c->deferred_ctm = c->surface->getCanvas()->getLocalToDevice();
+	c->raster_threads = threads;
+}
+
+void nx_canvas_flush_deferred(nx_canvas_t *c) {
+	if (!c || !c->recording)
+		return;
+	c->deferred_ctm = c->recorder->getRecordingCanvas()->getLocalToDevice();
+	sk_sp<SkPicture> picture = c->recorder->finishRecordingAsPicture();
+	c->recording = false;
+	if (picture && c->data) {
+		// The bands are drawn straight into `data`, bypassing the surface:
+		// drop its cached snapshot so drawImage()/encoding see the new frame.
+		if (c->surface)
+			c->surface->notifyContentWillChange(
+			    SkSurface::kRetain_ContentChangeMode);
+		raster_picture(picture.get(), c);
+	}
+}
+
 void nx_canvas_set_gpu_surface(nx_canvas_t *c, sk_sp<SkSurface> surface) {
 	if (!c)
 		return;
+	if (!c->gpu)
+		gpu_canvases++;
+	deferred_discard(c);
 	// Release the raster backing; adopt the GPU surface.
 	c->surface.reset();
 	if (c->data) {
@@ -2766,6 +3932,7 @@ void nx_canvas_set_gpu_surface(nx_canvas_t *c, sk_sp<SkSurface> surface) {
 	c->surface = std::move(surface);
 	c->gpu = true;
 	c->surface_dirty = true;  // ensure_surface() will (re)wire context->ctx
+	damage_all(c);
 }
 
 void nx_canvas_release_gpu_surface(nx_canvas_t *c) {
@@ -2778,6 +3945,7 @@ void nx_canvas_release_gpu_surface(nx_canvas_t *c) {
 	c->surface.reset();
 	c->gpu = false;
 	c->surface_dirty = true;
+	gpu_canvases--;
 }
 
 void nx_init_canvas(Isolate *iso, Local<Object> init_obj) {
@@ -2819,4 +3987,9 @@ void nx_init_canvas(Isolate *iso, Local<Object> init_obj) {
 	NX_SET_FUNC(init_obj, "canvasGradientAddColorStop",
 	            nx_canvas_gradient_add_color_stop);
 	NX_SET_FUNC(init_obj, "canvasToBuffer", nx_canvas_to_buffer);
+	NX_SET_FUNC(init_obj, "canvasPresentStats", nx_canvas_present_stats);
+	NX_SET_FUNC(init_obj, "canvasSetRasterThreads",
+	            nx_canvas_set_raster_threads_js);
+	NX_SET_FUNC(init_obj, "frameEncoderNew", nx_frame_encoder_new);
+	NX_SET_FUNC(init_obj, "frameEncoderEncode", nx_frame_encoder_encode);
 }
@@ -5,10 +5,13 @@
 
 #include "include/core/SkBlendMode.h"
 #include "include/core/SkCanvas.h"
+#include "include/core/SkM44.h"
 #include "include/core/SkMatrix.h"
 #include "include/core/SkPaint.h"
 #include "include/core/SkPath.h"
 #include "include/core/SkPathBuilder.h"
+#include "include/core/SkPictureRecorder.h"
+#include "include/core/SkRect.h"
 #include "include/core/SkRefCnt.h"
 #include "include/core/SkSamplingOptions.h"
 #include "include/core/SkShader.h"
@@ -29,6 +32,25 @@
 // wrapped images in `nx_get_canvas`/`nx_get_image`.
 #define NX_CANVAS_MAGIC 0x5643584eu // 'NXCV'
 
+// Maximum number of disjoint damage rects tracked per canvas. Beyond this, a
+// new rect is merged into whichever existing rect grows the least.
+#define NX_CANVAS_MAX_DAMAGE_RECTS 8
+
+// Upper bound for nx_canvas_t::raster_threads (the JS thread plus up to three
+// workers — one per remaining Cortex-A57 core).
+#define NX_CANVAS_MAX_RASTER_THREADS 4
+
+// Raster present statistics, updated by nx_canvas_take_damage() (i.e. once per
+// presented frame of the screen canvas). Exposed to JS as
+// `screen.getPresentStats()`.
+typedef struct nx_canvas_damage_stats_s {
+	uint64_t frames;         // frames presented (including idle ones)
+	uint64_t idle_frames;    // frames with no damage (present skipped)
+	uint64_t total_pixels;   // sum of damaged pixels copied over all frames
+	uint32_t last_rects;     // damage rects copied in the most recent frame
+	uint32_t last_pixels;    // damaged pixels copied in the most recent frame
+} nx_canvas_damage_stats_t;
+
 typedef struct nx_canvas_s {
 	uint32_t magic; // must be first: NX_CANVAS_MAGIC
 	uint32_t width;
@@ -41,6 +63,21 @@ typedef struct nx_canvas_s {
 	// read it back via SkSurface::readPixels; ensure_surface must not recreate
 	// it as raster. `data` may be null in this mode.
 	bool gpu;
+	// Device-space rects touched by draw operations since the last
+	// nx_canvas_take_damage(). Lets the raster present copy only what changed
+	// (and skip idle frames entirely).
+	SkIRect damage[NX_CANVAS_MAX_DAMAGE_RECTS];
+	int damage_count;
+	nx_canvas_damage_stats_t damage_stats;
+	// Deferred raster mode (raster canvases only; 0 = immediate). When set, 2D
+	// calls record into `recorder` instead of rasterizing on the JS thread;
+	// nx_canvas_flush_deferred() plays the recording back across horizontal
+	// tiles on up to `raster_threads` threads. `deferred_ctm` carries the
+	// current transform from one recording into the next.
+	int raster_threads;
+	SkPictureRecorder *recorder;
+	bool recording;
+	SkM44 deferred_ctm;
 } nx_canvas_t;
 
 nx_canvas_t *nx_get_canvas(v8::Isolate *iso, v8::Local<v8::Value> obj);
@@ -57,6 +94,24 @@ uint8_t *nx_canvas_pixels(nx_canvas_t *c);
 uint32_t nx_canvas_width(nx_canvas_t *c);
 uint32_t nx_canvas_height(nx_canvas_t *c);
 
+// Move the canvas's accumulated damage into `rects` (x, y, w, h quadruples;
+// room for `max_rects`) and reset it, updating the present statistics. Returns
+// the number of rects (0 on an idle frame); more than `max_rects` collapse into
+// their union. When `full` is true the whole canvas is reported regardless of
+// tracked damage (used for the first present into a fresh framebuffer).
+int nx_canvas_take_damage(nx_canvas_t *c, uint32_t *rects, int max_rects,
+                          bool full);
+
+// Switch `c` between immediate (0) and deferred tile-parallel rasterization
+// on `threads` threads (clamped to NX_CANVAS_MAX_RASTER_THREADS). Ignored for
+// a GPU-backed canvas. Pending recorded work is flushed first.
+void nx_canvas_set_raster_threads(nx_canvas_t *c, int threads);
+
+// Rasterize everything recorded on a deferred canvas into its pixels. A no-op
+// for immediate canvases or when nothing was recorded since the last flush.
+// Called at frame end by the present path and before any pixel readback.
+void nx_canvas_flush_deferred(nx_canvas_t *c);
+
 // Phase 2.2: make `c` GPU-backed by adopting `surface` (the screen's EGL FBO 0
 // SkSurface). The canvas's raster `data`/surface are released; subsequent draws
 // target the GPU surface and getImageData reads it back. Used by main.cc for
@@ -155,6 +210,12 @@ typedef struct nx_canvas_context_2d_state_s {
 	SkBlendMode blend_mode;
 	SkPathFillType fill_rule;
 
+	// Device-space clip paths applied at this save level, and the transform
+	// that restore() returns to. SkCanvas tracks both itself; these copies let
+	// a deferred canvas rebuild its save stack in each new recording.
+	std::vector<SkPath> clips;
+	SkM44 saved_ctm;
+
 	struct nx_canvas_context_2d_state_s *next;
 } nx_canvas_context_2d_state_t;
 
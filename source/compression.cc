@@ -1,11 +1,22 @@
+#include "compression.h"
 #include "async.h"
 #include "error.h"
 #include "types.h"
 #include "util.h"
 #include "wrap.h"
+#include <algorithm>
+#include <atomic>
 #include <errno.h>
+#include <list>
+#include <math.h>
+#include <mutex>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include <zlib.h>
 #include <zstd.h>
 
@@ -15,6 +26,7 @@ namespace {
 
 #define CHUNK 16384
 
+// The same values as nx_compression_format_t (see compression.h).
 typedef enum {
 	NX_FMT_UNKNOWN,
 	NX_FMT_DEFLATE,
@@ -23,12 +35,56 @@ typedef enum {
 	NX_FMT_ZSTD,
 } fmt_t;
 
+// The level deflate streams have always used by default (zlib's own default
+// is 6).
+#define NX_DEFLATE_DEFAULT_LEVEL 8
+
+// Idle zstd contexts kept for reuse per direction (see cctx_acquire()).
+#define NX_ZSTD_POOL_MAX 2
+
+// Upper bound for pre-sizing a stream's output buffer from an estimate:
+// beyond it, the buffer only grows as output is actually produced.
+#define NX_OUT_PRESIZE_MAX (4 * 1024 * 1024)
+
+// A stream's output buffer, kept across writes. Each write compresses (or
+// decompresses) straight into it, growing it geometrically, so a write costs
+// O(output) however it is chunked, and the buffer reaches a steady size
+// after the first few writes instead of being reallocated per 16 KiB chunk.
+typedef struct {
+	uint8_t *data;
+	size_t cap;
+} nx_out_t;
+
+// A zstd dictionary (Switch.CompressionDictionary), shared by any number of
+// streams. A prepared CDict bakes in its compression level, so one is built
+// per level used, and a single DDict serves every decompression. They are
+// built on first use by whichever threadpool worker needs them, and are
+// read-only from then on, which zstd allows to share across threads.
+// Refcounted: each stream using the dictionary holds a reference, so that it
+// outlives its JS object if need be.
+struct nx_zstd_dict {
+	std::atomic<int> refs{1};
+	uint8_t *data = nullptr; // the serialized dictionary (owned)
+	size_t size = 0;
+	std::mutex lock; // guards `cdicts` and `ddict`
+	std::vector<std::pair<int, ZSTD_CDict *>> cdicts;
+	ZSTD_DDict *ddict = nullptr;
+};
+
 typedef struct {
 	fmt_t format;
 	union {
 		z_stream *zstream;
 		ZSTD_CCtx *cctx;
 	};
+	// zstd: the dictionary (a reference) and the level its CDict is
+	// prepared for; referenced by the context on the first write.
+	nx_zstd_dict *dict;
+	int level;
+	bool dict_attached;
+	// The context spawned compression threads (never pooled).
+	bool threaded;
+	nx_out_t out;
 } nx_compress_t;
 
 typedef struct {
@@ -37,6 +93,10 @@ typedef struct {
 		z_stream *zstream;
 		ZSTD_DCtx *dctx;
 	};
+	nx_zstd_dict *dict; // zstd: a reference, attached on the first write
+	bool dict_attached;
+	bool started; // a write has been made (the frame header was seen)
+	nx_out_t out;
 } nx_decompress_t;
 
 bool is_zlib(fmt_t f) {
@@ -55,41 +115,139 @@ fmt_t format_from_string(const char *str) {
 	return NX_FMT_UNKNOWN;
 }
 
-int zlib_window_bits(fmt_t format) {
+// zlib's `windowBits` for a window of 2^log bytes in the given wrapper.
+int zlib_window_bits(fmt_t format, int log = 15) {
 	switch (format) {
 	case NX_FMT_DEFLATE:
-		return 15;
+		return log;
 	case NX_FMT_DEFLATE_RAW:
-		return -15;
+		return -log;
 	case NX_FMT_GZIP:
-		return 15 + 16;
+		return log + 16;
 	default:
 		return -1;
 	}
 }
 
-void free_compress(nx_compress_t *c) {
-	if (is_zlib(c->format)) {
-		if (c->zstream) {
-			deflateEnd(c->zstream);
-			free(c->zstream);
-		}
-	} else if (c->format == NX_FMT_ZSTD && c->cctx) {
-		ZSTD_freeCCtx(c->cctx);
+// ---- dictionaries ----
+nx_zstd_dict *dict_ref(nx_zstd_dict *d) {
+	if (d)
+		d->refs.fetch_add(1, std::memory_order_relaxed);
+	return d;
+}
+
+void dict_unref(nx_zstd_dict *d) {
+	if (!d || d->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+		return;
+	for (auto &c : d->cdicts)
+		ZSTD_freeCDict(c.second);
+	ZSTD_freeDDict(d->ddict);
+	free(d->data);
+	delete d;
+}
+
+// The dictionary prepared for compression at `level`, or NULL when out of
+// memory. Threadpool (any thread).
+const ZSTD_CDict *dict_cdict(nx_zstd_dict *d, int level) {
+	std::lock_guard<std::mutex> guard(d->lock);
+	for (auto &c : d->cdicts) {
+		if (c.first == level)
+			return c.second;
 	}
-	free(c);
+	ZSTD_CDict *cdict = ZSTD_createCDict(d->data, d->size, level);
+	if (cdict)
+		d->cdicts.emplace_back(level, cdict);
+	return cdict;
 }
 
-void free_decompress(nx_decompress_t *c) {
-	if (is_zlib(c->format)) {
-		if (c->zstream) {
-			inflateEnd(c->zstream);
-			free(c->zstream);
-		}
-	} else if (c->format == NX_FMT_ZSTD && c->dctx) {
-		ZSTD_freeDCtx(c->dctx);
+// The dictionary prepared for decompression, or NULL when out of memory.
+// Threadpool (any thread).
+const ZSTD_DDict *dict_ddict(nx_zstd_dict *d) {
+	std::lock_guard<std::mutex> guard(d->lock);
+	if (!d->ddict)
+		d->ddict = ZSTD_createDDict(d->data, d->size);
+	return d->ddict;
+}
+
+void free_dict(nx_zstd_dict *d) { dict_unref(d); }
+
+// ---- zstd context pool ----
+// A zstd context's workspace grows to fit its parameters (several MiB at high
+// levels or with a large window) on its first frame. Rather than allocate
+// and free one per stream, finished streams park their context here for the
+// next stream to reset and reuse. Main thread only: contexts are acquired in
+// compressNew()/decompressNew() and released at the end of a stream or by
+// the handle's finalizer.
+std::vector<ZSTD_CCtx *> cctx_pool;
+std::vector<ZSTD_DCtx *> dctx_pool;
+
+ZSTD_CCtx *cctx_acquire() {
+	if (cctx_pool.empty())
+		return ZSTD_createCCtx();
+	ZSTD_CCtx *cctx = cctx_pool.back();
+	cctx_pool.pop_back();
+	return cctx;
+}
+
+void cctx_release(ZSTD_CCtx *cctx, bool threaded) {
+	if (!cctx)
+		return;
+	// A threaded context keeps its worker threads: don't hold on to those.
+	if (threaded || cctx_pool.size() >= NX_ZSTD_POOL_MAX) {
+		ZSTD_freeCCtx(cctx);
+		return;
 	}
-	free(c);
+	// Also drops the dictionary reference and any parameters.
+	ZSTD_CCtx_reset(cctx, ZSTD_reset_session_and_parameters);
+	cctx_pool.push_back(cctx);
+}
+
+ZSTD_DCtx *dctx_acquire() {
+	if (dctx_pool.empty())
+		return ZSTD_createDCtx();
+	ZSTD_DCtx *dctx = dctx_pool.back();
+	dctx_pool.pop_back();
+	return dctx;
+}
+
+void dctx_release(ZSTD_DCtx *dctx) {
+	if (!dctx)
+		return;
+	if (dctx_pool.size() >= NX_ZSTD_POOL_MAX) {
+		ZSTD_freeDCtx(dctx);
+		return;
+	}
+	ZSTD_DCtx_reset(dctx, ZSTD_reset_session_and_parameters);
+	dctx_pool.push_back(dctx);
+}
+
+// Makes room for `need` bytes in total (the first `size` are kept). Grows by
+// at least half the current capacity. Returns false when out of memory.
+bool out_reserve(nx_out_t *out, size_t need) {
+	if (need <= out->cap)
+		return true;
+	size_t cap = out->cap + out->cap / 2;
+	if (cap < need)
+		cap = need;
+	if (cap < CHUNK)
+		cap = CHUNK;
+	uint8_t *data = (uint8_t *)realloc(out->data, cap);
+	if (!data)
+		return false;
+	out->data = data;
+	out->cap = cap;
+	return true;
+}
+
+// Makes room for at least `more` bytes after the first `size`.
+bool out_grow(nx_out_t *out, size_t size, size_t more) {
+	return out_reserve(out, size + more);
+}
+
+void out_free(nx_out_t *out) {
+	free(out->data);
+	out->data = NULL;
+	out->cap = 0;
 }
 
 // ---- result -> ArrayBuffer / throw ----
@@ -113,7 +271,240 @@ MaybeLocal<Value> result_or_throw(Isolate *iso, int err, uint8_t **result,
 	return ArrayBuffer::New(iso, std::move(bs)).As<Value>();
 }
 
+// The first `size` bytes of the output buffer as a new ArrayBuffer (or the
+// exception for `err`). Usually a copy, so that the buffer stays with the
+// stream; but when the output fills most of it, the buffer itself is handed
+// over (trimmed to size: in place, for newlib) to spare copying large
+// results, and the stream starts a new one on its next write.
+MaybeLocal<Value> out_result(Isolate *iso, int err, nx_out_t *out,
+                             size_t size, bool null_if_empty) {
+	uint8_t *result = NULL;
+	if (!err && size) {
+		if (size >= out->cap / 2) {
+			result = (uint8_t *)realloc(out->data, size);
+			if (!result)
+				result = out->data;
+			out->data = NULL;
+			out->cap = 0;
+		} else {
+			result = (uint8_t *)malloc(size);
+			if (result)
+				memcpy(result, out->data, size);
+			else
+				err = ENOMEM;
+		}
+	}
+	return result_or_throw(iso, err, &result, size, null_if_empty);
+}
+
+void free_compress(nx_compress_t *c) {
+	if (is_zlib(c->format)) {
+		if (c->zstream) {
+			deflateEnd(c->zstream);
+			free(c->zstream);
+		}
+	} else if (c->format == NX_FMT_ZSTD) {
+		cctx_release(c->cctx, c->threaded);
+		dict_unref(c->dict);
+	}
+	out_free(&c->out);
+	free(c);
+}
+
+void free_decompress(nx_decompress_t *c) {
+	if (is_zlib(c->format)) {
+		if (c->zstream) {
+			inflateEnd(c->zstream);
+			free(c->zstream);
+		}
+	} else if (c->format == NX_FMT_ZSTD) {
+		dctx_release(c->dctx);
+		dict_unref(c->dict);
+	}
+	out_free(&c->out);
+	free(c);
+}
+
+// References the stream's dictionary from its context, before its first
+// frame. Threadpool. Returns false when out of memory.
+bool compress_attach_dict(nx_compress_t *c) {
+	if (!c->dict || c->dict_attached)
+		return true;
+	const ZSTD_CDict *cdict = dict_cdict(c->dict, c->level);
+	if (!cdict || ZSTD_isError(ZSTD_CCtx_refCDict(c->cctx, cdict)))
+		return false;
+	c->dict_attached = true;
+	return true;
+}
+
+bool decompress_attach_dict(ZSTD_DCtx *dctx, nx_zstd_dict *dict,
+                            bool *attached) {
+	if (!dict || *attached)
+		return true;
+	const ZSTD_DDict *ddict = dict_ddict(dict);
+	if (!ddict || ZSTD_isError(ZSTD_DCtx_refDDict(dctx, ddict)))
+		return false;
+	*attached = true;
+	return true;
+}
+
+// ---- options ----
+// Reads the optional integer argument `i` (`undefined` leaves `*out` alone).
+// Returns false, with a RangeError thrown, if it is not an integer in
+// [min, max].
+bool int_option(const FunctionCallbackInfo<Value> &info, int i,
+                const char *name, int min, int max, int *out) {
+	Isolate *iso = info.GetIsolate();
+	if (info[i]->IsUndefined())
+		return true;
+	double v = NAN;
+	if (info[i]->IsNumber())
+		v = info[i].As<Number>()->Value();
+	if (!(v >= min && v <= max) || v != (int)v) {
+		char msg[128];
+		snprintf(msg, sizeof(msg), "%s must be an integer from %d to %d",
+		         name, min, max);
+		iso->ThrowException(Exception::RangeError(nx_str(iso, msg)));
+		return false;
+	}
+	*out = (int)v;
+	return true;
+}
+
+// The same, for a zstd compression parameter, with zstd's own bounds.
+bool zstd_option(const FunctionCallbackInfo<Value> &info, int i,
+                 const char *name, ZSTD_cParameter param, int *out) {
+	ZSTD_bounds b = ZSTD_cParam_getBounds(param);
+	return int_option(info, i, name, b.lowerBound, b.upperBound, out);
+}
+
+// The dictionary argument `i` (NULL when undefined). Returns false with an
+// exception thrown if it is not a dictionary handle.
+bool dict_option(const FunctionCallbackInfo<Value> &info, int i,
+                 nx_zstd_dict **out) {
+	*out = nullptr;
+	if (info[i]->IsUndefined() || info[i]->IsNull())
+		return true;
+	*out = nx::Unwrap<nx_zstd_dict>(info[i]);
+	if (!*out) {
+		nx_throw(info.GetIsolate(), "expected a CompressionDictionary");
+		return false;
+	}
+	return true;
+}
+
+// ---- CompressionDictionary ----
+// $.zstdDictNew(data) -> [handle, id]
+//
+// Copies the dictionary (a trained zstd dictionary, or raw content). Nothing
+// is prepared here: see dict_cdict() / dict_ddict().
+void nx_zstd_dict_new(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	size_t size = 0;
+	uint8_t *buf = NX_GetBufferSource(iso, &size, info[0]);
+	if (!buf) {
+		nx_throw(iso, "expected ArrayBuffer");
+		return;
+	}
+	if (!size) {
+		iso->ThrowException(Exception::RangeError(
+		    nx_str(iso, "The dictionary must not be empty")));
+		return;
+	}
+	nx_zstd_dict *d = new nx_zstd_dict();
+	d->data = (uint8_t *)malloc(size);
+	if (!d->data) {
+		delete d;
+		nx_throw_oom(iso, size);
+		return;
+	}
+	memcpy(d->data, buf, size);
+	d->size = size;
+	Local<Context> ctx = iso->GetCurrentContext();
+	Local<Object> obj = nx::NewWrapped(iso);
+	nx::Wrap<nx_zstd_dict>(iso, obj, d, free_dict);
+	Local<Array> result = Array::New(iso, 2);
+	result->Set(ctx, 0, obj).Check();
+	result->Set(ctx, 1,
+	            Integer::NewFromUnsigned(iso,
+	                                     ZSTD_getDictID_fromDict(buf, size)))
+	    .Check();
+	info.GetReturnValue().Set(result);
+}
+
 // ---- CompressionStream ----
+// Compression options, as parsed by compress_options().
+typedef struct {
+	int level;
+	int window;   // log2; 0 = zstd's default for the level
+	int strategy; // 0 = zstd's default for the level
+	bool long_distance;
+	int workers;
+	nx_zstd_dict *dict; // borrowed from the JS object
+} compress_opts_t;
+
+// Reads the compression options at info[i] .. info[i + 5]: level, windowLog,
+// strategy, longDistanceMatching, workers and dictionary, `undefined` meaning
+// the default. Returns false with a RangeError thrown if one is out of range.
+//
+// zlib formats take the level (0-9), the window size (9-15, as a log) and
+// the strategy (Z_DEFAULT_STRATEGY..Z_FIXED); zstd takes its own ranges for
+// those, plus long distance matching, worker threads (ignored when libzstd
+// was built without multithreading) and a dictionary. A zstd stream with a
+// dictionary gets its window and strategy from the dictionary's level.
+bool compress_options(const FunctionCallbackInfo<Value> &info, int i,
+                      fmt_t fmt, compress_opts_t *o) {
+	bool zlib = is_zlib(fmt);
+	o->level = zlib ? NX_DEFLATE_DEFAULT_LEVEL : ZSTD_CLEVEL_DEFAULT;
+	o->window = zlib ? 15 : 0;
+	o->strategy = zlib ? Z_DEFAULT_STRATEGY : 0;
+	o->long_distance = false;
+	o->workers = 0;
+	o->dict = nullptr;
+	if (zlib) {
+		return int_option(info, i, "level", 0, 9, &o->level) &&
+		       int_option(info, i + 1, "windowLog", 9, 15, &o->window) &&
+		       int_option(info, i + 2, "strategy", Z_DEFAULT_STRATEGY,
+		                  Z_FIXED, &o->strategy);
+	}
+	if (!zstd_option(info, i, "level", ZSTD_c_compressionLevel, &o->level) ||
+	    !zstd_option(info, i + 1, "windowLog", ZSTD_c_windowLog,
+	                 &o->window) ||
+	    !zstd_option(info, i + 2, "strategy", ZSTD_c_strategy,
+	                 &o->strategy) ||
+	    !int_option(info, i + 4, "workers", 0, 256, &o->workers) ||
+	    !dict_option(info, i + 5, &o->dict))
+		return false;
+	o->long_distance = info[i + 3]->BooleanValue(info.GetIsolate());
+	// Single-threaded libzstd: compress on the calling worker.
+	ZSTD_bounds wb = ZSTD_cParam_getBounds(ZSTD_c_nbWorkers);
+	if (o->workers > wb.upperBound)
+		o->workers = wb.upperBound;
+	return true;
+}
+
+// deflateInit2() with the options (for a zero-initialized stream).
+int deflate_init(z_stream *stream, fmt_t fmt, const compress_opts_t *o) {
+	return deflateInit2(stream, o->level, Z_DEFLATED,
+	                    zlib_window_bits(fmt, o->window), 8, o->strategy);
+}
+
+// Applies the options, except for the dictionary, to a zstd context. They
+// were range checked by compress_options(), so this cannot fail.
+void zstd_set_options(ZSTD_CCtx *cctx, const compress_opts_t *o) {
+	ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, o->level);
+	if (o->window)
+		ZSTD_CCtx_setParameter(cctx, ZSTD_c_windowLog, o->window);
+	if (o->strategy)
+		ZSTD_CCtx_setParameter(cctx, ZSTD_c_strategy, o->strategy);
+	if (o->long_distance)
+		ZSTD_CCtx_setParameter(cctx, ZSTD_c_enableLongDistanceMatching, 1);
+	if (o->workers > 0)
+		ZSTD_CCtx_setParameter(cctx, ZSTD_c_nbWorkers, o->workers);
+}
+
+// $.compressNew(format, level?, windowLog?, strategy?, longDistance?,
+//               workers?, dictionary?)
 void nx_compress_new(const FunctionCallbackInfo<Value> &info) {
 	Isolate *iso = info.GetIsolate();
 	String::Utf8Value format(iso, info[0]);
@@ -124,6 +515,9 @@ void nx_compress_new(const FunctionCallbackInfo<Value> &info) {
 		nx_throw(iso, "Invalid compression format");
 		return;
 	}
+	compress_opts_t opts;
+	if (!compress_options(info, 1, fmt, &opts))
+		return;
 	nx_compress_t *context =
 	    (nx_compress_t *)calloc(1, sizeof(nx_compress_t));
 	context->format = fmt;
@@ -132,8 +526,7 @@ void nx_compress_new(const FunctionCallbackInfo<Value> &info) {
 		stream->zalloc = Z_NULL;
 		stream->zfree = Z_NULL;
 		stream->opaque = Z_NULL;
-		int ret = deflateInit2(stream, 8, Z_DEFLATED, zlib_window_bits(fmt), 8,
-		                       Z_DEFAULT_STRATEGY);
+		int ret = deflate_init(stream, fmt, &opts);
 		if (ret != Z_OK) {
 			free(stream);
 			free(context);
@@ -142,12 +535,16 @@ void nx_compress_new(const FunctionCallbackInfo<Value> &info) {
 		}
 		context->zstream = stream;
 	} else {
-		context->cctx = ZSTD_createCCtx();
+		context->cctx = cctx_acquire();
 		if (!context->cctx) {
 			free(context);
 			nx_throw(iso, "ZSTD_createCCtx() returned NULL");
 			return;
 		}
+		zstd_set_options(context->cctx, &opts);
+		context->threaded = opts.workers > 0;
+		context->level = opts.level;
+		context->dict = dict_ref(opts.dict);
 	}
 	Local<Object> obj = nx::NewWrapped(iso);
 	nx::Wrap<nx_compress_t>(iso, obj, context, free_compress);
@@ -160,75 +557,72 @@ typedef struct {
 	Global<Value> data_val;
 	uint8_t *data;
 	size_t size;
-	uint8_t *result;
-	size_t result_size;
+	size_t result_size; // bytes of the context's output buffer
 } compress_write_t;
 
 void compress_write_do(nx_work_t *req) {
 	compress_write_t *data = (compress_write_t *)req->data;
-	data->result = NULL;
-	data->result_size = 0;
-	if (is_zlib(data->context->format)) {
-		z_stream *stream = data->context->zstream;
-		unsigned char out[CHUNK];
+	nx_compress_t *c = data->context;
+	nx_out_t *out = &c->out;
+	size_t size = 0;
+	if (is_zlib(c->format)) {
+		z_stream *stream = c->zstream;
+		size_t bound = (size_t)deflateBound(stream, data->size);
+		if (!out_reserve(out, std::min(bound, (size_t)NX_OUT_PRESIZE_MAX))) {
+			data->err = ENOMEM;
+			return;
+		}
 		stream->avail_in = data->size;
 		stream->next_in = data->data;
 		do {
-			stream->avail_out = CHUNK;
-			stream->next_out = out;
+			if (size == out->cap && !out_grow(out, size, CHUNK)) {
+				data->err = ENOMEM;
+				return;
+			}
+			stream->next_out = out->data + size;
+			stream->avail_out = out->cap - size;
 			int ret = deflate(stream, Z_NO_FLUSH);
 			if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
-				if (data->result)
-					free(data->result);
 				data->err = ret;
 				return;
 			}
-			int have = CHUNK - stream->avail_out;
-			if (have > 0) {
-				unsigned char *nr =
-				    (unsigned char *)realloc(data->result,
-				                             data->result_size + have);
-				if (!nr) {
-					free(data->result);
-					data->err = Z_MEM_ERROR;
-					return;
-				}
-				data->result = nr;
-				memcpy(data->result + data->result_size, out, have);
-				data->result_size += have;
-			}
+			size = out->cap - stream->avail_out;
 		} while (stream->avail_in > 0);
 	} else { // zstd
+		if (!compress_attach_dict(c)) {
+			data->err = ENOMEM;
+			return;
+		}
+		size_t bound = ZSTD_compressBound(data->size);
+		if (!out_reserve(out, std::min(bound, (size_t)NX_OUT_PRESIZE_MAX))) {
+			data->err = ENOMEM;
+			return;
+		}
 		ZSTD_inBuffer input = {data->data, data->size, 0};
 		while (input.pos < input.size) {
-			size_t size = ZSTD_CStreamOutSize();
-			void *nr = realloc(data->result, data->result_size + size);
-			if (!nr) {
-				if (data->result)
-					free(data->result);
+			if (size == out->cap &&
+			    !out_grow(out, size, ZSTD_CStreamOutSize())) {
 				data->err = ENOMEM;
 				return;
 			}
-			data->result = (uint8_t *)nr;
-			ZSTD_outBuffer output = {data->result + data->result_size, size,
-			                         0};
-			size_t ret =
-			    ZSTD_compressStream(data->context->cctx, &output, &input);
+			ZSTD_outBuffer output = {out->data, out->cap, size};
+			size_t ret = ZSTD_compressStream2(c->cctx, &output, &input,
+			                                  ZSTD_e_continue);
 			if (ZSTD_isError(ret)) {
-				free(data->result);
 				data->err = -4;
 				return;
 			}
-			data->result_size += output.pos;
+			size = output.pos;
 		}
 	}
+	data->result_size = size;
 }
 
 MaybeLocal<Value> compress_write_cb(Isolate *iso, nx_work_t *req) {
 	compress_write_t *data = (compress_write_t *)req->data;
 	data->data_val.Reset();
-	return result_or_throw(iso, data->err, &data->result, data->result_size,
-	                       false);
+	return out_result(iso, data->err, &data->context->out, data->result_size,
+	                  false);
 }
 
 void nx_compress_write(const FunctionCallbackInfo<Value> &info) {
@@ -236,6 +630,10 @@ void nx_compress_write(const FunctionCallbackInfo<Value> &info) {
 	nx_compress_t *context = nx::Unwrap<nx_compress_t>(info[0]);
 	if (!context)
 		return;
+	if (context->format == NX_FMT_ZSTD && !context->cctx) {
+		nx_throw(iso, "Compression stream is closed");
+		return;
+	}
 	size_t size = 0;
 	uint8_t *buf = NX_GetBufferSource(iso, &size, info[1]);
 	if (!buf) {
@@ -256,72 +654,69 @@ void nx_compress_write(const FunctionCallbackInfo<Value> &info) {
 typedef struct {
 	int err;
 	nx_compress_t *context;
-	uint8_t *result;
-	size_t result_size;
+	size_t result_size; // bytes of the context's output buffer
 } compress_flush_t;
 
 void compress_flush_do(nx_work_t *req) {
 	compress_flush_t *data = (compress_flush_t *)req->data;
-	data->result = NULL;
-	data->result_size = 0;
-	if (is_zlib(data->context->format)) {
-		z_stream *stream = data->context->zstream;
-		unsigned char out[CHUNK];
+	nx_compress_t *c = data->context;
+	nx_out_t *out = &c->out;
+	size_t size = 0;
+	if (is_zlib(c->format)) {
+		z_stream *stream = c->zstream;
 		int ret;
 		do {
-			stream->avail_out = CHUNK;
-			stream->next_out = out;
+			if (size == out->cap && !out_grow(out, size, CHUNK)) {
+				data->err = ENOMEM;
+				return;
+			}
+			stream->next_out = out->data + size;
+			stream->avail_out = out->cap - size;
 			ret = deflate(stream, Z_FINISH);
 			if (ret != Z_OK && ret != Z_STREAM_END) {
-				if (data->result)
-					free(data->result);
 				data->err = ret;
 				return;
 			}
-			int have = CHUNK - stream->avail_out;
-			unsigned char *nr =
-			    (unsigned char *)realloc(data->result,
-			                             data->result_size + have);
-			if (!nr) {
-				free(data->result);
-				data->err = Z_MEM_ERROR;
-				return;
-			}
-			data->result = nr;
-			memcpy(data->result + data->result_size, out, have);
-			data->result_size += have;
+			size = out->cap - stream->avail_out;
 		} while (ret != Z_STREAM_END);
 	} else { // zstd
+		if (!compress_attach_dict(c)) {
+			data->err = ENOMEM;
+			return;
+		}
 		ZSTD_inBuffer input = {NULL, 0, 0};
-		size_t remaining;
+		// What remains to flush, at least (zstd's hint).
+		size_t remaining = ZSTD_CStreamOutSize();
 		do {
-			size_t size = ZSTD_CStreamOutSize();
-			void *nr = realloc(data->result, data->result_size + size);
-			if (!nr) {
-				if (data->result)
-					free(data->result);
+			if (!out_grow(out, size, remaining)) {
 				data->err = ENOMEM;
 				return;
 			}
-			data->result = (uint8_t *)nr;
-			ZSTD_outBuffer output = {data->result + data->result_size, size,
-			                         0};
-			remaining = ZSTD_compressStream2(data->context->cctx, &output,
-			                                 &input, ZSTD_e_end);
+			ZSTD_outBuffer output = {out->data, out->cap, size};
+			remaining =
+			    ZSTD_compressStream2(c->cctx, &output, &input, ZSTD_e_end);
 			if (ZSTD_isError(remaining)) {
-				free(data->result);
 				data->err = EINVAL;
 				return;
 			}
-			data->result_size += output.pos;
+			size = output.pos;
 		} while (remaining > 0);
 	}
+	data->result_size = size;
 }
 
 MaybeLocal<Value> compress_flush_cb(Isolate *iso, nx_work_t *req) {
 	compress_flush_t *data = (compress_flush_t *)req->data;
-	return result_or_throw(iso, data->err, &data->result, data->result_size,
-	                       true);
+	nx_compress_t *c = data->context;
+	// The stream is over: its zstd context can serve the next one.
+	if (c->format == NX_FMT_ZSTD) {
+		cctx_release(c->cctx, c->threaded);
+		c->cctx = NULL;
+	}
+	MaybeLocal<Value> result =
+	    out_result(iso, data->err, &c->out, data->result_size, true);
+	out_free(&c->out);
+	return result;
 }
 
 void nx_compress_flush(const FunctionCallbackInfo<Value> &info) {
@@ -333,11 +728,36 @@ void nx_compress_flush(const FunctionCallbackInfo<Value> &info) {
 		delete req;
 		return;
 	}
+	if (data->context->format == NX_FMT_ZSTD && !data->context->cctx) {
+		free(data);
+		delete req;
+		nx_throw(iso, "Compression stream is closed");
+		return;
+	}
 	info.GetReturnValue().Set(
 	    nx_queue_async(iso, req, compress_flush_do, compress_flush_cb));
 }
 
 // ---- DecompressionStream ----
+// Reads the decompression options at info[i] (windowLog) and info[i + 1]
+// (dictionary). The window log is the largest window accepted (a stream
+// needing more fails), 9-15 for zlib formats and up to
+// ZSTD_WINDOWLOG_LIMIT_DEFAULT..ZSTD_WINDOWLOG_MAX for zstd.
+bool decompress_options(const FunctionCallbackInfo<Value> &info, int i,
+                        fmt_t fmt, int *window, nx_zstd_dict **dict) {
+	*dict = nullptr;
+	if (is_zlib(fmt)) {
+		*window = 15;
+		return int_option(info, i, "windowLog", 9, 15, window);
+	}
+	*window = 0;
+	ZSTD_bounds b = ZSTD_dParam_getBounds(ZSTD_d_windowLogMax);
+	return int_option(info, i, "windowLog", b.lowerBound, b.upperBound,
+	                  window) &&
+	       dict_option(info, i + 1, dict);
+}
+
+// $.decompressNew(format, windowLog?, dictionary?)
 void nx_decompress_new(const FunctionCallbackInfo<Value> &info) {
 	Isolate *iso = info.GetIsolate();
 	String::Utf8Value format(iso, info[0]);
@@ -348,6 +768,10 @@ void nx_decompress_new(const FunctionCallbackInfo<Value> &info) {
 		nx_throw(iso, "Invalid compression format");
 		return;
 	}
+	int window;
+	nx_zstd_dict *dict;
+	if (!decompress_options(info, 1, fmt, &window, &dict))
+		return;
 	nx_decompress_t *context =
 	    (nx_decompress_t *)calloc(1, sizeof(nx_decompress_t));
 	context->format = fmt;
@@ -356,7 +780,7 @@ void nx_decompress_new(const FunctionCallbackInfo<Value> &info) {
 		stream->zalloc = Z_NULL;
 		stream->zfree = Z_NULL;
 		stream->opaque = Z_NULL;
-		int ret = inflateInit2(stream, zlib_window_bits(fmt));
+		int ret = inflateInit2(stream, zlib_window_bits(fmt, window));
 		if (ret != Z_OK) {
 			free(stream);
 			free(context);
@@ -365,12 +789,16 @@ void nx_decompress_new(const FunctionCallbackInfo<Value> &info) {
 		}
 		context->zstream = stream;
 	} else {
-		context->dctx = ZSTD_createDCtx();
+		context->dctx = dctx_acquire();
 		if (!context->dctx) {
 			free(context);
 			nx_throw(iso, "ZSTD_createDCtx() returned NULL");
 			return;
 		}
+		if (window)
+			ZSTD_DCtx_setParameter(context->dctx, ZSTD_d_windowLogMax,
+			                       window);
+		context->dict = dict_ref(dict);
 	}
 	Local<Object> obj = nx::NewWrapped(iso);
 	nx::Wrap<nx_decompress_t>(iso, obj, context, free_decompress);
@@ -383,76 +811,92 @@ typedef struct {
 	Global<Value> data_val;
 	uint8_t *data;
 	size_t size;
-	uint8_t *result;
-	size_t result_size;
+	size_t result_size; // bytes of the context's output buffer
 } decompress_write_t;
 
+// The decompressed size to reserve for a write, from the frame header when
+// the write holds a whole zstd frame (as one-shot compressed data does), or
+// a typical ratio otherwise.
+size_t decompress_estimate(nx_decompress_t *c, const uint8_t *data,
+                           size_t size) {
+	if (c->format == NX_FMT_ZSTD && !c->started &&
+	    ZSTD_findFrameCompressedSize(data, size) == size) {
+		unsigned long long content = ZSTD_getFrameContentSize(data, size);
+		if (content != ZSTD_CONTENTSIZE_UNKNOWN &&
+		    content != ZSTD_CONTENTSIZE_ERROR)
+			return content < NX_OUT_PRESIZE_MAX ? (size_t)content
+			                                    : NX_OUT_PRESIZE_MAX;
+	}
+	return size < NX_OUT_PRESIZE_MAX / 4 ? size * 4 : NX_OUT_PRESIZE_MAX;
+}
+
 void decompress_write_do(nx_work_t *req) {
 	decompress_write_t *data = (decompress_write_t *)req->data;
-	data->result = NULL;
-	data->result_size = 0;
-	if (is_zlib(data->context->format)) {
-		z_stream *stream = data->context->zstream;
-		unsigned char out[CHUNK];
-		int ret;
+	nx_decompress_t *c = data->context;
+	nx_out_t *out = &c->out;
+	size_t size = 0;
+	if (!out_reserve(out, decompress_estimate(c, data->data, data->size))) {
+		data->err = ENOMEM;
+		return;
+	}
+	c->started = true;
+	if (is_zlib(c->format)) {
+		z_stream *stream = c->zstream;
 		stream->avail_in = data->size;
 		stream->next_in = data->data;
-		do {
-			stream->avail_out = CHUNK;
-			stream->next_out = out;
-			ret = inflate(stream, Z_NO_FLUSH);
+		for (;;) {
+			if (size == out->cap && !out_grow(out, size, CHUNK)) {
+				data->err = ENOMEM;
+				return;
+			}
+			stream->next_out = out->data + size;
+			stream->avail_out = out->cap - size;
+			int ret = inflate(stream, Z_NO_FLUSH);
 			if (ret == Z_BUF_ERROR)
 				break;
 			if (ret != Z_OK && ret != Z_STREAM_END) {
-				if (data->result)
-					free(data->result);
 				data->err = ret;
 				return;
 			}
-			int have = CHUNK - stream->avail_out;
-			unsigned char *nr =
-			    (unsigned char *)realloc(data->result,
-			                             data->result_size + have);
-			if (!nr) {
-				free(data->result);
-				data->err = Z_MEM_ERROR;
-				return;
-			}
-			data->result = nr;
-			memcpy(data->result + data->result_size, out, have);
-			data->result_size += have;
-		} while (ret != Z_STREAM_END);
+			size = out->cap - stream->avail_out;
+			// Done when the stream ends, or when inflate() had input left
+			// to consume and room to spare.
+			if (ret == Z_STREAM_END ||
+			    (stream->avail_in == 0 && stream->avail_out > 0))
+				break;
+		}
 	} else { // zstd
+		if (!decompress_attach_dict(c->dctx, c->dict, &c->dict_attached)) {
+			data->err = ENOMEM;
+			return;
+		}
 		ZSTD_inBuffer input = {data->data, data->size, 0};
-		while (input.pos < input.size) {
-			size_t size = ZSTD_DStreamOutSize();
-			void *nr = realloc(data->result, data->result_size + size);
-			if (!nr) {
-				if (data->result)
-					free(data->result);
+		for (;;) {
+			if (size == out->cap &&
+			    !out_grow(out, size, ZSTD_DStreamOutSize())) {
 				data->err = ENOMEM;
 				return;
 			}
-			data->result = (uint8_t *)nr;
-			ZSTD_outBuffer output = {data->result + data->result_size, size,
-			                         0};
-			size_t ret =
-			    ZSTD_decompressStream(data->context->dctx, &output, &input);
+			ZSTD_outBuffer output = {out->data, out->cap, size};
+			size_t ret = ZSTD_decompressStream(c->dctx, &output, &input);
 			if (ZSTD_isError(ret)) {
-				free(data->result);
 				data->err = -4;
 				return;
 			}
-			data->result_size += output.pos;
+			size = output.pos;
+			// A full output buffer may hide more output to flush.
+			if (input.pos == input.size && output.pos < output.size)
+				break;
 		}
 	}
+	data->result_size = size;
 }
 
 MaybeLocal<Value> decompress_write_cb(Isolate *iso, nx_work_t *req) {
 	decompress_write_t *data = (decompress_write_t *)req->data;
 	data->data_val.Reset();
-	return result_or_throw(iso, data->err, &data->result, data->result_size,
-	                       false);
+	return out_result(iso, data->err, &data->context->out, data->result_size,
+	                  false);
 }
 
 void nx_decompress_write(const FunctionCallbackInfo<Value> &info) {
@@ -460,6 +904,10 @@ void nx_decompress_write(const FunctionCallbackInfo<Value> &info) {
 	nx_decompress_t *context = nx::Unwrap<nx_decompress_t>(info[0]);
 	if (!context)
 		return;
+	if (context->format == NX_FMT_ZSTD && !context->dctx) {
+		nx_throw(iso, "Decompression stream is closed");
+		return;
+	}
 	size_t size = 0;
 	uint8_t *buf = NX_GetBufferSource(iso, &size, info[1]);
 	if (!buf) {
@@ -480,68 +928,59 @@ void nx_decompress_write(const FunctionCallbackInfo<Value> &info) {
 typedef struct {
 	int err;
 	nx_decompress_t *context;
-	uint8_t *result;
-	size_t result_size;
+	size_t result_size; // bytes of the context's output buffer
 } decompress_flush_t;
 
 void decompress_flush_do(nx_work_t *req) {
 	decompress_flush_t *data = (decompress_flush_t *)req->data;
-	data->result = NULL;
-	data->result_size = 0;
-	if (is_zlib(data->context->format)) {
-		z_stream *stream = data->context->zstream;
-		unsigned char out[CHUNK];
+	nx_decompress_t *c = data->context;
+	nx_out_t *out = &c->out;
+	size_t size = 0;
+	if (is_zlib(c->format)) {
+		z_stream *stream = c->zstream;
 		int ret;
 		do {
-			stream->avail_out = CHUNK;
-			stream->next_out = out;
+			if (size == out->cap && !out_grow(out, size, CHUNK)) {
+				data->err = ENOMEM;
+				return;
+			}
+			stream->next_out = out->data + size;
+			stream->avail_out = out->cap - size;
 			ret = inflate(stream, Z_FINISH);
 			if (ret != Z_OK && ret != Z_STREAM_END) {
-				if (data->result)
-					free(data->result);
 				data->err = ret;
 				return;
 			}
-			int have = CHUNK - stream->avail_out;
-			unsigned char *nr =
-			    (unsigned char *)realloc(data->result,
-			                             data->result_size + have);
-			if (!nr) {
-				free(data->result);
-				data->err = Z_MEM_ERROR;
-				return;
-			}
-			data->result = nr;
-			memcpy(data->result + data->result_size, out, have);
-			data->result_size += have;
+			size = out->cap - stream->avail_out;
 		} while (ret != Z_STREAM_END);
 	} else { // zstd
-		ZSTD_inBuffer input = {NULL, 0, 0};
-		size_t size = ZSTD_DStreamOutSize();
-		void *nr = realloc(data->result, data->result_size + size);
-		if (!nr) {
-			if (data->result)
-				free(data->result);
+		if (!out_reserve(out, ZSTD_DStreamOutSize())) {
 			data->err = ENOMEM;
 			return;
 		}
-		data->result = (uint8_t *)nr;
-		ZSTD_outBuffer output = {data->result + data->result_size, size, 0};
-		size_t ret =
-		    ZSTD_decompressStream(data->context->dctx, &output, &input);
+		ZSTD_inBuffer input = {NULL, 0, 0};
+		ZSTD_outBuffer output = {out->data, out->cap, 0};
+		size_t ret = ZSTD_decompressStream(c->dctx, &output, &input);
 		if (ZSTD_isError(ret)) {
-			free(data->result);
 			data->err = EINVAL;
 			return;
 		}
-		data->result_size += output.pos;
+		size = output.pos;
 	}
+	data->result_size = size;
 }
 
 MaybeLocal<Value> decompress_flush_cb(Isolate *iso, nx_work_t *req) {
 	decompress_flush_t *data = (decompress_flush_t *)req->data;
-	return result_or_throw(iso, data->err, &data->result, data->result_size,
-	                       true);
+	nx_decompress_t *c = data->context;
+	if (c->format == NX_FMT_ZSTD) {
+		dctx_release(c->dctx);
+		c->dctx = NULL;
+	}
+	MaybeLocal<Value> result =
+	    out_result(iso, data->err, &c->out, data->result_size, true);
+	out_free(&c->out);
+	return result;
 }
 
 void nx_decompress_flush(const FunctionCallbackInfo<Value> &info) {
@@ -553,6 +992,12 @@ void nx_decompress_flush(const FunctionCallbackInfo<Value> &info) {
 		delete req;
 		return;
 	}
+	if (data->context->format == NX_FMT_ZSTD && !data->context->dctx) {
+		free(data);
+		delete req;
+		nx_throw(iso, "Decompression stream is closed");
+		return;
+	}
 	info.GetReturnValue().Set(
 	    nx_queue_async(iso, req, decompress_flush_do, decompress_flush_cb));
 }
@@ -600,6 +1045,8 @@ typedef struct {
 	size_t out_cap;     // per-pull output capacity (regime-chosen)
 	bool eof_in;        // no more compressed input to read from the file
 	bool finished;      // decompression stream fully drained
+	nx_zstd_dict *dict; // zstd dictionary (a reference), or NULL
+	bool dict_attached;
 } nx_decompress_file_t;
 
 void free_decompress_file(nx_decompress_file_t *c) {
@@ -610,8 +1057,9 @@ void free_decompress_file(nx_decompress_file_t *c) {
 			inflateEnd(c->zstream);
 			free(c->zstream);
 		}
-	} else if (c->format == NX_FMT_ZSTD && c->dctx) {
-		ZSTD_freeDCtx(c->dctx);
+	} else if (c->format == NX_FMT_ZSTD) {
+		dctx_release(c->dctx);
+		dict_unref(c->dict);
 	}
 	if (c->file)
 		fclose(c->file);
@@ -621,13 +1069,19 @@ void free_decompress_file(nx_decompress_file_t *c) {
 }
 
 // work payload for a pull
-typedef struct {
-	nx_decompress_file_t *ctx;
-	uint8_t *result;      // produced output for this pull (malloc'd, may be NULL)
-	size_t result_size;
-	bool done;            // true => stream finished, return null
-	int err;
-} decompress_file_pull_t;
+struct decompress_file_pull_t {
+	nx_decompress_file_t *ctx = nullptr;
+	// Where this pull decompresses to: the context's fixed output buffer,
+	// or (BYOB) straight into the caller's view, kept alive by `view_val`.
+	uint8_t *dst = nullptr;
+	size_t dst_cap = 0;
+	bool byob = false;
+	Global<Value> view_val;
+	uint8_t *result = nullptr; // copy of the output (malloc'd, may be NULL)
+	size_t result_size = 0;
+	bool done = false; // true => stream finished, return null
+	int err = 0;
+};
 
 // Refill the input buffer from the file if it is empty and there is more to
 // read. Returns false on read error (sets *err).
@@ -665,7 +1119,11 @@ void decompress_file_pull_do(nx_work_t *req) {
 	}
 
 	if (c->format == NX_FMT_ZSTD) {
-		ZSTD_outBuffer output = {c->out, c->out_cap, 0};
+		if (!decompress_attach_dict(c->dctx, c->dict, &c->dict_attached)) {
+			d->err = ENOMEM;
+			return;
+		}
+		ZSTD_outBuffer output = {d->dst, d->dst_cap, 0};
 		// Produce up to one OUT_CHUNK of output, reading/refilling input as
 		// needed. Stop when the output buffer fills or input is exhausted.
 		while (output.pos < output.size) {
@@ -697,8 +1155,8 @@ void decompress_file_pull_do(nx_work_t *req) {
 	} else {
 		// zlib / gzip / deflate
 		z_stream *s = c->zstream;
-		s->next_out = c->out;
-		s->avail_out = (uInt)c->out_cap;
+		s->next_out = d->dst;
+		s->avail_out = (uInt)d->dst_cap;
 		while (s->avail_out > 0) {
 			if (!fused_refill(c, &d->err))
 				return;
@@ -725,10 +1183,12 @@ void decompress_file_pull_do(nx_work_t *req) {
 			if (c->in_pos >= c->in_size && c->eof_in)
 				continue; // let inflate drain with Z_SYNC_FLUSH
 		}
-		d->result_size = c->out_cap - s->avail_out;
+		d->result_size = d->dst_cap - s->avail_out;
 	}
 
-	if (d->result_size > 0) {
+	if (d->byob) {
+		d->done = c->finished && d->result_size == 0;
+	} else if (d->result_size > 0) {
 		d->result = (uint8_t *)malloc(d->result_size);
 		if (!d->result) {
 			d->err = ENOMEM;
@@ -756,6 +1216,10 @@ MaybeLocal<Value> decompress_file_pull_cb(Isolate *iso, nx_work_t *req) {
 	if (d->done && d->result_size == 0) {
 		return Null(iso).As<Value>(); // signal stream end
 	}
+	if (d->byob) {
+		d->view_val.Reset();
+		return Number::New(iso, (double)d->result_size).As<Value>();
+	}
 	uint8_t *buf = d->result;
 	size_t size = d->result_size;
 	d->result = nullptr;
@@ -764,7 +1228,8 @@ MaybeLocal<Value> decompress_file_pull_cb(Isolate *iso, nx_work_t *req) {
 	return ArrayBuffer::New(iso, std::move(bs)).As<Value>();
 }
 
-// $.decompressFileNew(format, path, start, end) -> handle
+// $.decompressFileNew(format, path, start, end, outCap, windowLog?,
+//                    dictionary?) -> handle
 void nx_decompress_file_new(const FunctionCallbackInfo<Value> &info) {
 	Isolate *iso = info.GetIsolate();
 	String::Utf8Value format(iso, info[0]);
@@ -798,6 +1263,10 @@ void nx_decompress_file_new(const FunctionCallbackInfo<Value> &info) {
 		out_cap = NX_FUSED_OUT_MIN;
 	if (out_cap > NX_FUSED_OUT_MAX)
 		out_cap = NX_FUSED_OUT_MAX;
+	int window;
+	nx_zstd_dict *dict;
+	if (!decompress_options(info, 5, fmt, &window, &dict))
+		return;
 
 	FILE *file = fopen(*path, "rb");
 	if (!file) {
@@ -831,7 +1300,7 @@ void nx_decompress_file_new(const FunctionCallbackInfo<Value> &info) {
 		s->zalloc = Z_NULL;
 		s->zfree = Z_NULL;
 		s->opaque = Z_NULL;
-		if (inflateInit2(s, zlib_window_bits(fmt)) != Z_OK) {
+		if (inflateInit2(s, zlib_window_bits(fmt, window)) != Z_OK) {
 			free(s);
 			free_decompress_file(c);
 			nx_throw(iso, "Failed to initialize inflate stream");
@@ -839,19 +1308,23 @@ void nx_decompress_file_new(const FunctionCallbackInfo<Value> &info) {
 		}
 		c->zstream = s;
 	} else {
-		c->dctx = ZSTD_createDCtx();
+		c->dctx = dctx_acquire();
 		if (!c->dctx) {
 			free_decompress_file(c);
 			nx_throw(iso, "ZSTD_createDCtx() returned NULL");
 			return;
 		}
+		if (window)
+			ZSTD_DCtx_setParameter(c->dctx, ZSTD_d_windowLogMax, window);
+		c->dict = dict_ref(dict);
 	}
 	Local<Object> obj = nx::NewWrapped(iso);
 	nx::Wrap<nx_decompress_file_t>(iso, obj, c, free_decompress_file);
 	info.GetReturnValue().Set(obj);
 }
 
-// $.decompressFilePull(handle) -> Promise<ArrayBuffer | null>
+// $.decompressFilePull(handle, view?) -> Promise<ArrayBuffer | null>, or
+// with a view (BYOB), Promise<number | null>: the bytes written to the view.
 void nx_decompress_file_pull(const FunctionCallbackInfo<Value> &info) {
 	Isolate *iso = info.GetIsolate();
 	nx_decompress_file_t *c = nx::Unwrap<nx_decompress_file_t>(info[0]);
@@ -859,17 +1332,1088 @@ void nx_decompress_file_pull(const FunctionCallbackInfo<Value> &info) {
 		nx_throw(iso, "decompressFilePull: invalid handle");
 		return;
 	}
-	nx_work_t *req = new nx_work_t();
-	decompress_file_pull_t *data =
-	    (decompress_file_pull_t *)calloc(1, sizeof(decompress_file_pull_t));
+	uint8_t *view = NULL;
+	size_t view_size = 0;
+	if (!info[1]->IsUndefined()) {
+		view = NX_GetBufferSource(iso, &view_size, info[1]);
+		if (!view || !view_size) {
+			nx_throw(iso, "expected a non-empty ArrayBufferView");
+			return;
+		}
+	}
+	NX_INIT_WORK_T_CPP(decompress_file_pull_t);
 	data->ctx = c;
-	req->data = data;
+	if (view) {
+		data->dst = view;
+		data->dst_cap = view_size;
+		data->byob = true;
+		data->view_val.Reset(iso, info[1]);
+	} else {
+		data->dst = c->out;
+		data->dst_cap = c->out_cap;
+	}
 	info.GetReturnValue().Set(nx_queue_async(
 	    iso, req, decompress_file_pull_do, decompress_file_pull_cb));
 }
 
+// ===========================================================================
+// One-shot compress() / decompress(): a whole buffer in one call, on one
+// thread pool dispatch (or synchronously, for small inputs), with the output
+// allocated once at its final size where the format allows it: compression
+// output is bounded by deflateBound() / ZSTD_compressBound(), and zstd frames
+// usually record their decompressed size.
+// ===========================================================================
+
+typedef enum {
+	NX_ONESHOT_OK,
+	NX_ONESHOT_OOM,
+	NX_ONESHOT_CORRUPT,   // `message` says why
+	NX_ONESHOT_TOO_LARGE, // the output exceeds `max_output`
+	NX_ONESHOT_FAILED,    // the codec failed to initialize
+} oneshot_err_t;
+
+struct oneshot_t {
+	fmt_t format = NX_FMT_UNKNOWN;
+	bool compress = false;
+	compress_opts_t opts = {}; // compress (`opts.dict` also decompress)
+	int window = 0;            // decompress: window log limit (0 = default)
+	size_t max_output = SIZE_MAX; // decompress
+	Global<Value> data_val;
+	Global<Value> dict_val; // keeps `opts.dict` alive while in flight
+	const uint8_t *data = nullptr;
+	size_t size = 0;
+	ZSTD_CCtx *cctx = nullptr; // from the pool
+	ZSTD_DCtx *dctx = nullptr;
+	uint8_t *result = nullptr;
+	size_t result_size = 0;
+	oneshot_err_t err = NX_ONESHOT_OK;
+	const char *message = nullptr; // static string
+
+	~oneshot_t() { free(result); }
+};
+
+// Shrinks the result to its size (in place, for newlib).
+void oneshot_trim(oneshot_t *o) {
+	if (!o->result || !o->result_size)
+		return;
+	uint8_t *trimmed = (uint8_t *)realloc(o->result, o->result_size);
+	if (trimmed)
+		o->result = trimmed;
+}
+
+void oneshot_compress(oneshot_t *o) {
+	if (is_zlib(o->format)) {
+		z_stream stream = {};
+		if (deflate_init(&stream, o->format, &o->opts) != Z_OK) {
+			o->err = NX_ONESHOT_FAILED;
+			return;
+		}
+		// Large enough for deflate(Z_FINISH) to finish in one call.
+		size_t bound = (size_t)deflateBound(&stream, o->size);
+		o->result = (uint8_t *)malloc(bound ? bound : 1);
+		if (!o->result) {
+			deflateEnd(&stream);
+			o->err = NX_ONESHOT_OOM;
+			return;
+		}
+		stream.next_in = (Bytef *)o->data;
+		stream.avail_in = o->size;
+		stream.next_out = o->result;
+		stream.avail_out = bound;
+		int ret = deflate(&stream, Z_FINISH);
+		o->result_size = stream.total_out;
+		deflateEnd(&stream);
+		if (ret != Z_STREAM_END) {
+			o->err = NX_ONESHOT_FAILED;
+			return;
+		}
+	} else {
+		zstd_set_options(o->cctx, &o->opts);
+		if (o->opts.dict) {
+			const ZSTD_CDict *cdict = dict_cdict(o->opts.dict, o->opts.level);
+			if (!cdict) {
+				o->err = NX_ONESHOT_OOM;
+				return;
+			}
+			ZSTD_CCtx_refCDict(o->cctx, cdict);
+		}
+		size_t bound = ZSTD_compressBound(o->size);
+		o->result = (uint8_t *)malloc(bound);
+		if (!o->result) {
+			o->err = NX_ONESHOT_OOM;
+			return;
+		}
+		size_t ret =
+		    ZSTD_compress2(o->cctx, o->result, bound, o->data, o->size);
+		if (ZSTD_isError(ret)) {
+			o->err = NX_ONESHOT_FAILED;
+			o->message = ZSTD_getErrorName(ret);
+			return;
+		}
+		o->result_size = ret;
+	}
+	oneshot_trim(o);
+}
+
+// How much decompressed output to make room for, at most: one byte more than
+// `max_output`, to tell output which ends right at the limit from output
+// which exceeds it.
+size_t oneshot_limit(oneshot_t *o) {
+	return o->max_output < SIZE_MAX ? o->max_output + 1 : SIZE_MAX;
+}
+
+// Grows the result for decompression, within the limit. Returns false with
+// `err` set when it cannot.
+bool oneshot_grow(oneshot_t *o, nx_out_t *out, size_t size) {
+	size_t limit = oneshot_limit(o);
+	if (size >= limit) {
+		o->err = NX_ONESHOT_TOO_LARGE;
+		return false;
+	}
+	size_t want = out->cap + out->cap / 2;
+	if (want < CHUNK)
+		want = CHUNK;
+	if (want > limit)
+		want = limit;
+	if (!out_reserve(out, want)) {
+		o->err = NX_ONESHOT_OOM;
+		return false;
+	}
+	return true;
+}
+
+// The total decompressed size of a buffer of zstd frames, or
+// ZSTD_CONTENTSIZE_UNKNOWN if a frame does not record it.
+unsigned long long zstd_content_size(const uint8_t *data, size_t size) {
+	unsigned long long total = 0;
+	while (size > 0) {
+		size_t frame = ZSTD_findFrameCompressedSize(data, size);
+		if (ZSTD_isError(frame))
+			return ZSTD_CONTENTSIZE_UNKNOWN;
+		unsigned long long content = ZSTD_getFrameContentSize(data, frame);
+		if (content == ZSTD_CONTENTSIZE_UNKNOWN ||
+		    content == ZSTD_CONTENTSIZE_ERROR)
+			return ZSTD_CONTENTSIZE_UNKNOWN;
+		total += content;
+		data += frame;
+		size -= frame;
+	}
+	return total;
+}
+
+void oneshot_decompress(oneshot_t *o) {
+	nx_out_t out = {};
+	size_t size = 0;
+	if (is_zlib(o->format)) {
+		z_stream stream = {};
+		int bits = zlib_window_bits(o->format, o->window ? o->window : 15);
+		if (inflateInit2(&stream, bits) != Z_OK) {
+			o->err = NX_ONESHOT_FAILED;
+			return;
+		}
+		size_t estimate = o->size < NX_OUT_PRESIZE_MAX / 4
+		                      ? o->size * 4
+		                      : NX_OUT_PRESIZE_MAX;
+		if (!out_reserve(&out, std::min(estimate, oneshot_limit(o)))) {
+			inflateEnd(&stream);
+			o->err = NX_ONESHOT_OOM;
+			return;
+		}
+		stream.next_in = (Bytef *)o->data;
+		stream.avail_in = o->size;
+		int ret;
+		do {
+			if (size == out.cap && !oneshot_grow(o, &out, size))
+				break;
+			stream.next_out = out.data + size;
+			stream.avail_out = out.cap - size;
+			ret = inflate(&stream, Z_FINISH);
+			size = out.cap - stream.avail_out;
+			if (ret == Z_BUF_ERROR && stream.avail_in == 0 &&
+			    stream.avail_out > 0) {
+				o->err = NX_ONESHOT_CORRUPT;
+				o->message = "unexpected end of data";
+			} else if (ret == Z_STREAM_END && stream.avail_in > 0) {
+				o->err = NX_ONESHOT_CORRUPT;
+				o->message = "trailing data after the end of the stream";
+			} else if (ret != Z_OK && ret != Z_BUF_ERROR &&
+			           ret != Z_STREAM_END) {
+				o->err = NX_ONESHOT_CORRUPT;
+				o->message = stream.msg ? stream.msg : "invalid data";
+			}
+		} while (!o->err && ret != Z_STREAM_END);
+		inflateEnd(&stream);
+	} else {
+		ZSTD_DCtx *dctx = o->dctx;
+		if (o->window)
+			ZSTD_DCtx_setParameter(dctx, ZSTD_d_windowLogMax, o->window);
+		if (o->opts.dict) {
+			const ZSTD_DDict *ddict = dict_ddict(o->opts.dict);
+			if (!ddict) {
+				o->err = NX_ONESHOT_OOM;
+				return;
+			}
+			ZSTD_DCtx_refDDict(dctx, ddict);
+		}
+		unsigned long long content = zstd_content_size(o->data, o->size);
+		if (content != ZSTD_CONTENTSIZE_UNKNOWN) {
+			// Known sizes: decompress in a single pass, into an exactly
+			// sized buffer.
+			if (content > o->max_output) {
+				o->err = NX_ONESHOT_TOO_LARGE;
+				return;
+			}
+			o->result = (uint8_t *)malloc(content ? content : 1);
+			if (!o->result) {
+				o->err = NX_ONESHOT_OOM;
+				return;
+			}
+			size_t ret = ZSTD_decompressDCtx(dctx, o->result, content,
+			                                 o->data, o->size);
+			if (ZSTD_isError(ret)) {
+				o->err = NX_ONESHOT_CORRUPT;
+				o->message = ZSTD_getErrorName(ret);
+				return;
+			}
+			o->result_size = ret;
+			return;
+		}
+		size_t estimate = o->size < NX_OUT_PRESIZE_MAX / 4
+		                      ? o->size * 4
+		                      : NX_OUT_PRESIZE_MAX;
+		if (!out_reserve(&out, std::min(estimate, oneshot_limit(o)))) {
+			o->err = NX_ONESHOT_OOM;
+			return;
+		}
+		ZSTD_inBuffer input = {o->data, o->size, 0};
+		size_t ret = 0;
+		for (;;) {
+			if (size == out.cap && !oneshot_grow(o, &out, size))
+				break;
+			ZSTD_outBuffer output = {out.data, out.cap, size};
+			ret = ZSTD_decompressStream(dctx, &output, &input);
+			size = output.pos;
+			if (ZSTD_isError(ret)) {
+				o->err = NX_ONESHOT_CORRUPT;
+				o->message = ZSTD_getErrorName(ret);
+				break;
+			}
+			if (input.pos == input.size && output.pos < output.size)
+				break;
+		}
+		if (!o->err && ret != 0) {
+			o->err = NX_ONESHOT_CORRUPT;
+			o->message = "unexpected end of data";
+		}
+	}
+	// (The buffer is at least CHUNK bytes, which may exceed the limit.)
+	if (!o->err && size > o->max_output)
+		o->err = NX_ONESHOT_TOO_LARGE;
+	if (o->err) {
+		out_free(&out);
+		return;
+	}
+	o->result = out.data;
+	o->result_size = size;
+	oneshot_trim(o);
+}
+
+void oneshot_do(nx_work_t *req) {
+	oneshot_t *o = (oneshot_t *)req->data;
+	if (o->compress)
+		oneshot_compress(o);
+	else
+		oneshot_decompress(o);
+}
+
+// Returns the zstd context to the pool. Main thread.
+void oneshot_release(oneshot_t *o) {
+	if (o->cctx) {
+		cctx_release(o->cctx, o->opts.workers > 0);
+		o->cctx = NULL;
+	}
+	if (o->dctx) {
+		dctx_release(o->dctx);
+		o->dctx = NULL;
+	}
+}
+
+// The result (an ArrayBuffer), or the exception for the error.
+MaybeLocal<Value> oneshot_result(Isolate *iso, oneshot_t *o) {
+	oneshot_release(o);
+	o->data_val.Reset();
+	o->dict_val.Reset();
+	if (o->err) {
+		free(o->result);
+		o->result = NULL;
+		char msg[256];
+		switch (o->err) {
+		case NX_ONESHOT_OOM:
+			nx_throw_oom(iso, o->size);
+			break;
+		case NX_ONESHOT_CORRUPT:
+			snprintf(msg, sizeof(msg), "Failed to decompress: %s",
+			         o->message);
+			iso->ThrowException(Exception::TypeError(nx_str(iso, msg)));
+			break;
+		case NX_ONESHOT_TOO_LARGE:
+			snprintf(msg, sizeof(msg),
+			         "Decompressed data exceeds maxOutputSize (%zu bytes)",
+			         o->max_output);
+			iso->ThrowException(Exception::RangeError(nx_str(iso, msg)));
+			break;
+		default:
+			snprintf(msg, sizeof(msg), "Failed to %s%s%s",
+			         o->compress ? "compress" : "decompress",
+			         o->message ? ": " : "", o->message ? o->message : "");
+			nx_throw(iso, msg);
+			break;
+		}
+		return MaybeLocal<Value>();
+	}
+	return result_or_throw(iso, 0, &o->result, o->result_size, false);
+}
+
+MaybeLocal<Value> oneshot_cb(Isolate *iso, nx_work_t *req) {
+	return oneshot_result(iso, (oneshot_t *)req->data);
+}
+
+// Reads the arguments shared by the one-shot ops: (data, format, ...).
+// `compress` takes the compression options after the format, and
+// decompression takes (windowLog, dictionary, maxOutputSize).
+bool oneshot_init(const FunctionCallbackInfo<Value> &info, oneshot_t *o,
+                  bool compress) {
+	Isolate *iso = info.GetIsolate();
+	uint8_t *data = NX_GetBufferSource(iso, &o->size, info[0]);
+	if (!data) {
+		nx_throw(iso, "expected ArrayBuffer");
+		return false;
+	}
+	String::Utf8Value format(iso, info[1]);
+	if (!*format)
+		return false;
+	o->format = format_from_string(*format);
+	if (o->format == NX_FMT_UNKNOWN) {
+		nx_throw(iso, "Invalid compression format");
+		return false;
+	}
+	o->compress = compress;
+	o->data = data;
+	if (compress) {
+		if (!compress_options(info, 2, o->format, &o->opts))
+			return false;
+	} else {
+		if (!decompress_options(info, 2, o->format, &o->window,
+		                        &o->opts.dict))
+			return false;
+		if (!info[4]->IsUndefined()) {
+			double max = info[4]->IsNumber()
+			                 ? info[4].As<Number>()->Value()
+			                 : -1;
+			if (!(max >= 0)) {
+				iso->ThrowException(Exception::RangeError(nx_str(
+				    iso, "maxOutputSize must be a non-negative number")));
+				return false;
+			}
+			if (max < (double)SIZE_MAX)
+				o->max_output = (size_t)max;
+		}
+	}
+	if (o->format == NX_FMT_ZSTD) {
+		if (compress)
+			o->cctx = cctx_acquire();
+		else
+			o->dctx = dctx_acquire();
+		if (!o->cctx && !o->dctx) {
+			nx_throw(iso, "Failed to create a zstd context");
+			return false;
+		}
+	}
+	return true;
+}
+
+// $.compress(data, format, level?, windowLog?, strategy?, longDistance?,
+//            workers?, dictionary?) -> Promise<ArrayBuffer>
+// $.decompress(data, format, windowLog?, dictionary?, maxOutputSize?)
+//     -> Promise<ArrayBuffer>
+void oneshot_async(const FunctionCallbackInfo<Value> &info, bool compress) {
+	Isolate *iso = info.GetIsolate();
+	NX_INIT_WORK_T_CPP(oneshot_t);
+	if (!oneshot_init(info, data, compress)) {
+		oneshot_release(data);
+		delete data;
+		delete req;
+		return;
+	}
+	data->data_val.Reset(iso, info[0]);
+	Local<Value> dict = info[compress ? 7 : 3];
+	if (data->opts.dict)
+		data->dict_val.Reset(iso, dict);
+	info.GetReturnValue().Set(nx_queue_async(iso, req, oneshot_do, oneshot_cb));
+}
+
+void nx_compress(const FunctionCallbackInfo<Value> &info) {
+	oneshot_async(info, true);
+}
+
+void nx_decompress(const FunctionCallbackInfo<Value> &info) {
+	oneshot_async(info, false);
+}
+
+// $.compressSync() / $.decompressSync(): the same, on the calling thread.
+void oneshot_sync(const FunctionCallbackInfo<Value> &info, bool compress) {
+	oneshot_t o;
+	if (!oneshot_init(info, &o, compress)) {
+		oneshot_release(&o);
+		return;
+	}
+	if (compress)
+		oneshot_compress(&o);
+	else
+		oneshot_decompress(&o);
+	Local<Value> result;
+	if (oneshot_result(info.GetIsolate(), &o).ToLocal(&result))
+		info.GetReturnValue().Set(result);
+}
+
+void nx_compress_sync(const FunctionCallbackInfo<Value> &info) {
+	oneshot_sync(info, true);
+}
+
+void nx_decompress_sync(const FunctionCallbackInfo<Value> &info) {
+	oneshot_sync(info, false);
+}
+
+// ===========================================================================
+// Seekable zstd (Switch.SeekableCompressionStream / Switch.SeekableReader).
+//
+// The zstd seekable format (from zstd's contrib/seekable_format) is data
+// compressed as independent frames, each of a bounded decompressed size,
+// followed by a seek table in a skippable frame, which other zstd decoders
+// ignore:
+//
+//   Skippable magic (0x184D2A5E) | Frame size (u32)
+//   per frame: Compressed size (u32) | Decompressed size (u32) | [Checksum]
+//   Number of frames (u32) | Descriptor (u8) | Seekable magic (0x8F92EAB1)
+//
+// A reader looks the frames of a byte range up in the table, and decompresses
+// only those: reading from the middle of a large asset costs a frame or two,
+// rather than everything before it. Frames which a read needs only part of
+// (the ones neighbouring reads are likely to need too) are kept in an LRU
+// cache of decompressed frames; frames read whole are decompressed straight
+// into the result.
+//
+// The writer enables zstd's content checksum in each frame, which is checked
+// as the frame is decompressed; the seek table's own (optional) checksums are
+// not written, and are ignored when present.
+// ===========================================================================
+
+#define SEEKABLE_MAGIC 0x8F92EAB1
+#define SEEKABLE_SKIPPABLE_MAGIC (ZSTD_MAGIC_SKIPPABLE_START | 0xE)
+#define SEEKABLE_SKIPPABLE_HEADER 8
+#define SEEKABLE_FOOTER 9
+#define SEEKABLE_CHECKSUM_FLAG 0x80
+#define SEEKABLE_RESERVED_BITS 0x7c
+#define SEEKABLE_MAX_FRAMES 0x8000000
+#define SEEKABLE_MAX_FRAME_SIZE (1 << 30)
+
+#define NX_SEEKABLE_FRAME_SIZE (1024 * 1024)
+
+void put_le32(uint8_t *p, uint32_t v) {
+	p[0] = v;
+	p[1] = v >> 8;
+	p[2] = v >> 16;
+	p[3] = v >> 24;
+}
+
+uint32_t get_le32(const uint8_t *p) {
+	return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// ---- writer ----
+struct nx_seekable_writer_t {
+	ZSTD_CCtx *cctx = nullptr; // NULL once ended
+	size_t frame_size = NX_SEEKABLE_FRAME_SIZE;
+	uint8_t *frame = nullptr; // input of the frame being filled
+	size_t frame_fill = 0;
+	// Compressed size, decompressed size of each frame written.
+	std::vector<uint32_t> table;
+	nx_out_t out = {NULL, 0};
+
+	~nx_seekable_writer_t() {
+		cctx_release(cctx, false);
+		free(frame);
+		out_free(&out);
+	}
+};
+
+void free_seekable_writer(nx_seekable_writer_t *w) { delete w; }
+
+// Compresses `size` bytes as the next frame, after the first `*out_size`
+// bytes of output. Returns 0 or an errno value.
+int seekable_frame(nx_seekable_writer_t *w, const uint8_t *data, size_t size,
+                   size_t *out_size) {
+	if (w->table.size() / 2 >= SEEKABLE_MAX_FRAMES)
+		return EFBIG;
+	if (!out_grow(&w->out, *out_size, ZSTD_compressBound(size)))
+		return ENOMEM;
+	size_t n = ZSTD_compress2(w->cctx, w->out.data + *out_size,
+	                          w->out.cap - *out_size, data, size);
+	if (ZSTD_isError(n))
+		return EINVAL;
+	w->table.push_back((uint32_t)n);
+	w->table.push_back((uint32_t)size);
+	*out_size += n;
+	return 0;
+}
+
+struct seekable_write_t {
+	nx_seekable_writer_t *writer = nullptr;
+	Global<Value> data_val;
+	const uint8_t *data = nullptr;
+	size_t size = 0;
+	bool end = false;
+	size_t result_size = 0; // bytes of the writer's output buffer
+	int err = 0;
+};
+
+void seekable_write_do(nx_work_t *req) {
+	seekable_write_t *d = (seekable_write_t *)req->data;
+	nx_seekable_writer_t *w = d->writer;
+	size_t size = 0;
+	const uint8_t *p = d->data;
+	size_t left = d->size;
+	while (left > 0) {
+		// Whole frames of the input are compressed in place; the rest is
+		// buffered until a later write completes the frame.
+		if (w->frame_fill == 0 && left >= w->frame_size) {
+			if ((d->err = seekable_frame(w, p, w->frame_size, &size)))
+				return;
+			p += w->frame_size;
+			left -= w->frame_size;
+			continue;
+		}
+		if (!w->frame && !(w->frame = (uint8_t *)malloc(w->frame_size))) {
+			d->err = ENOMEM;
+			return;
+		}
+		size_t n = std::min(left, w->frame_size - w->frame_fill);
+		memcpy(w->frame + w->frame_fill, p, n);
+		w->frame_fill += n;
+		p += n;
+		left -= n;
+		if (w->frame_fill == w->frame_size) {
+			w->frame_fill = 0;
+			if ((d->err = seekable_frame(w, w->frame, w->frame_size, &size)))
+				return;
+		}
+	}
+	if (d->end) {
+		if (w->frame_fill) {
+			if ((d->err = seekable_frame(w, w->frame, w->frame_fill, &size)))
+				return;
+			w->frame_fill = 0;
+		}
+		uint32_t frames = (uint32_t)(w->table.size() / 2);
+		size_t table = (size_t)frames * 8 + SEEKABLE_FOOTER;
+		if (!out_grow(&w->out, size, SEEKABLE_SKIPPABLE_HEADER + table)) {
+			d->err = ENOMEM;
+			return;
+		}
+		uint8_t *o = w->out.data + size;
+		put_le32(o, SEEKABLE_SKIPPABLE_MAGIC);
+		put_le32(o + 4, (uint32_t)table);
+		o += SEEKABLE_SKIPPABLE_HEADER;
+		for (uint32_t v : w->table) {
+			put_le32(o, v);
+			o += 4;
+		}
+		put_le32(o, frames);
+		o[4] = 0; // no checksums
+		put_le32(o + 5, SEEKABLE_MAGIC);
+		size += SEEKABLE_SKIPPABLE_HEADER + table;
+	}
+	d->result_size = size;
+}
+
+MaybeLocal<Value> seekable_write_cb(Isolate *iso, nx_work_t *req) {
+	seekable_write_t *d = (seekable_write_t *)req->data;
+	nx_seekable_writer_t *w = d->writer;
+	d->data_val.Reset();
+	if (d->end) {
+		cctx_release(w->cctx, false);
+		w->cctx = NULL;
+		free(w->frame);
+		w->frame = NULL;
+		MaybeLocal<Value> result =
+		    out_result(iso, d->err, &w->out, d->result_size, false);
+		out_free(&w->out);
+		return result;
+	}
+	return out_result(iso, d->err, &w->out, d->result_size, false);
+}
+
+// $.zstdSeekableWriterNew(level?, frameSize?) -> handle
+void nx_zstd_seekable_writer_new(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	int level = ZSTD_CLEVEL_DEFAULT;
+	int frame_size = NX_SEEKABLE_FRAME_SIZE;
+	if (!zstd_option(info, 0, "level", ZSTD_c_compressionLevel, &level) ||
+	    !int_option(info, 1, "frameSize", 1, SEEKABLE_MAX_FRAME_SIZE,
+	                &frame_size))
+		return;
+	ZSTD_CCtx *cctx = cctx_acquire();
+	if (!cctx) {
+		nx_throw(iso, "ZSTD_createCCtx() returned NULL");
+		return;
+	}
+	ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, level);
+	ZSTD_CCtx_setParameter(cctx, ZSTD_c_checksumFlag, 1);
+	nx_seekable_writer_t *w = new nx_seekable_writer_t();
+	w->cctx = cctx;
+	w->frame_size = (size_t)frame_size;
+	Local<Object> obj = nx::NewWrapped(iso);
+	nx::Wrap<nx_seekable_writer_t>(iso, obj, w, free_seekable_writer);
+	info.GetReturnValue().Set(obj);
+}
+
+void seekable_write(const FunctionCallbackInfo<Value> &info, bool end) {
+	Isolate *iso = info.GetIsolate();
+	nx_seekable_writer_t *w = nx::Unwrap<nx_seekable_writer_t>(info[0]);
+	if (!w)
+		return;
+	if (!w->cctx) {
+		nx_throw(iso, "Compression stream is closed");
+		return;
+	}
+	size_t size = 0;
+	uint8_t *buf = NULL;
+	if (!end) {
+		buf = NX_GetBufferSource(iso, &size, info[1]);
+		if (!buf) {
+			nx_throw(iso, "expected ArrayBuffer");
+			return;
+		}
+	}
+	NX_INIT_WORK_T_CPP(seekable_write_t);
+	data->writer = w;
+	data->data = buf;
+	data->size = size;
+	data->end = end;
+	if (buf)
+		data->data_val.Reset(iso, info[1]);
+	info.GetReturnValue().Set(
+	    nx_queue_async(iso, req, seekable_write_do, seekable_write_cb));
+}
+
+// $.zstdSeekableWriterWrite(handle, data) -> Promise<ArrayBuffer>: the
+// frames completed by `data`.
+void nx_zstd_seekable_writer_write(const FunctionCallbackInfo<Value> &info) {
+	seekable_write(info, false);
+}
+
+// $.zstdSeekableWriterEnd(handle) -> Promise<ArrayBuffer>: the last frame,
+// and the seek table.
+void nx_zstd_seekable_writer_end(const FunctionCallbackInfo<Value> &info) {
+	seekable_write(info, true);
+}
+
+// ---- reader ----
+struct nx_seekable_frame_t {
+	uint32_t index;
+	uint8_t *data;
+	size_t size;
+};
+
+// Shared by its JS object and any read in flight. The frame offsets are
+// read-only once open; `lock` guards the file position and the cache.
+struct nx_seekable_t {
+	std::atomic<int> refs{1};
+	FILE *file = NULL;
+	// Frame i is [c_offsets[i], c_offsets[i + 1]) of the file, and
+	// decompresses to [d_offsets[i], d_offsets[i + 1]).
+	std::vector<uint64_t> c_offsets;
+	std::vector<uint64_t> d_offsets;
+	std::mutex lock;
+	std::list<nx_seekable_frame_t> lru; // most recently used first
+	std::unordered_map<uint32_t, std::list<nx_seekable_frame_t>::iterator>
+	    cached;
+	size_t cache_size = 0;
+	size_t cache_max = 0;
+
+	~nx_seekable_t() {
+		if (file)
+			fclose(file);
+		for (nx_seekable_frame_t &f : lru)
+			free(f.data);
+	}
+};
+
+nx_seekable_t *seekable_ref(nx_seekable_t *s) {
+	s->refs.fetch_add(1, std::memory_order_relaxed);
+	return s;
+}
+
+void seekable_unref(nx_seekable_t *s) {
+	if (s && s->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		delete s;
+}
+
+// Reads and parses the seek table at the end of the file. Returns NULL, or
+// why the file is not seekable zstd (with `*err` set for I/O errors).
+const char *seekable_parse(nx_seekable_t *s, uint64_t file_size, int *err) {
+	uint8_t footer[SEEKABLE_FOOTER];
+	if (file_size < SEEKABLE_SKIPPABLE_HEADER + SEEKABLE_FOOTER)
+		return "Not a seekable zstd file";
+	if (fseek(s->file, (long)(file_size - SEEKABLE_FOOTER), SEEK_SET) != 0 ||
+	    fread(footer, 1, SEEKABLE_FOOTER, s->file) != SEEKABLE_FOOTER) {
+		*err = errno ? errno : EIO;
+		return NULL;
+	}
+	if (get_le32(footer + 5) != SEEKABLE_MAGIC)
+		return "Not a seekable zstd file";
+	uint32_t frames = get_le32(footer);
+	uint8_t descriptor = footer[4];
+	if (descriptor & SEEKABLE_RESERVED_BITS || frames > SEEKABLE_MAX_FRAMES)
+		return "Invalid seek table";
+	size_t entry = descriptor & SEEKABLE_CHECKSUM_FLAG ? 12 : 8;
+	uint64_t table = (uint64_t)frames * entry + SEEKABLE_FOOTER;
+	if (table + SEEKABLE_SKIPPABLE_HEADER > file_size)
+		return "Invalid seek table";
+	uint64_t data_size = file_size - table - SEEKABLE_SKIPPABLE_HEADER;
+	std::vector<uint8_t> buf(table + SEEKABLE_SKIPPABLE_HEADER);
+	if (fseek(s->file, (long)data_size, SEEK_SET) != 0 ||
+	    fread(buf.data(), 1, buf.size(), s->file) != buf.size()) {
+		*err = errno ? errno : EIO;
+		return NULL;
+	}
+	if (get_le32(buf.data()) != SEEKABLE_SKIPPABLE_MAGIC ||
+	    get_le32(buf.data() + 4) != table)
+		return "Invalid seek table";
+	s->c_offsets.resize(frames + 1);
+	s->d_offsets.resize(frames + 1);
+	s->c_offsets[0] = s->d_offsets[0] = 0;
+	const uint8_t *p = buf.data() + SEEKABLE_SKIPPABLE_HEADER;
+	for (uint32_t i = 0; i < frames; i++, p += entry) {
+		s->c_offsets[i + 1] = s->c_offsets[i] + get_le32(p);
+		s->d_offsets[i + 1] = s->d_offsets[i] + get_le32(p + 4);
+	}
+	// The frames must account for all of the data before the table.
+	if (s->c_offsets[frames] != data_size)
+		return "Seek table does not match the file";
+	return NULL;
+}
+
+// Reads the compressed frame `i` into a new buffer. Returns 0 or an errno
+// value.
+int seekable_read_frame(nx_seekable_t *s, uint32_t i, uint8_t **out) {
+	size_t size = (size_t)(s->c_offsets[i + 1] - s->c_offsets[i]);
+	uint8_t *buf = (uint8_t *)malloc(size ? size : 1);
+	if (!buf)
+		return ENOMEM;
+	std::lock_guard<std::mutex> guard(s->lock);
+	if (fseek(s->file, (long)s->c_offsets[i], SEEK_SET) != 0 ||
+	    fread(buf, 1, size, s->file) != size) {
+		free(buf);
+		return errno ? errno : EIO;
+	}
+	*out = buf;
+	return 0;
+}
+
+// Copies [from, from + size) of frame `i` from the cache into `dst`, if the
+// frame is cached. Caller holds `lock`.
+bool seekable_cache_get(nx_seekable_t *s, uint32_t i, size_t from,
+                        size_t size, uint8_t *dst) {
+	auto it = s->cached.find(i);
+	if (it == s->cached.end())
+		return false;
+	s->lru.splice(s->lru.begin(), s->lru, it->second);
+	memcpy(dst, it->second->data + from, size);
+	return true;
+}
+
+// Decompresses frame `i` into `dst`, which has room for all of it. Returns 0
+// or an errno value.
+int seekable_decompress(nx_seekable_t *s, uint32_t i, uint8_t *dst) {
+	uint8_t *frame;
+	int err = seekable_read_frame(s, i, &frame);
+	if (err)
+		return err;
+	size_t size = (size_t)(s->c_offsets[i + 1] - s->c_offsets[i]);
+	bool ok = nx_decompress_exact(NX_COMPRESSION_FORMAT_ZSTD, frame, size, dst,
+	                              s->d_offsets[i + 1] - s->d_offsets[i]);
+	free(frame);
+	return ok ? 0 : EBADMSG;
+}
+
+// Copies [from, from + size) of the decompressed frame `i` into `dst`.
+// Returns 0 or an errno value.
+int seekable_read_part(nx_seekable_t *s, uint32_t i, size_t from, size_t size,
+                       uint8_t *dst) {
+	size_t frame_size = (size_t)(s->d_offsets[i + 1] - s->d_offsets[i]);
+	{
+		std::lock_guard<std::mutex> guard(s->lock);
+		if (seekable_cache_get(s, i, from, size, dst))
+			return 0;
+	}
+	// A frame read whole is decompressed in place, and not cached: reads
+	// which cover whole frames (e.g. streaming through the data) would only
+	// evict the frames shared by neighbouring small reads.
+	if (from == 0 && size == frame_size)
+		return seekable_decompress(s, i, dst);
+	uint8_t *frame = (uint8_t *)malloc(frame_size);
+	if (!frame)
+		return ENOMEM;
+	int err = seekable_decompress(s, i, frame);
+	if (err) {
+		free(frame);
+		return err;
+	}
+	memcpy(dst, frame + from, size);
+	std::lock_guard<std::mutex> guard(s->lock);
+	// Another read may have cached the frame meanwhile.
+	if (frame_size > s->cache_max || s->cached.count(i)) {
+		free(frame);
+		return 0;
+	}
+	while (s->cache_size + frame_size > s->cache_max) {
+		nx_seekable_frame_t &last = s->lru.back();
+		s->cache_size -= last.size;
+		s->cached.erase(last.index);
+		free(last.data);
+		s->lru.pop_back();
+	}
+	s->lru.push_front({i, frame, frame_size});
+	s->cached[i] = s->lru.begin();
+	s->cache_size += frame_size;
+	return 0;
+}
+
+// Reads decompressed bytes [offset, offset + length), clamped to the end of
+// the data, into a new buffer. Returns 0 or an errno value. Any thread.
+int seekable_read(nx_seekable_t *s, uint64_t offset, uint64_t length,
+                  uint8_t **out, size_t *out_size) {
+	uint64_t total = s->d_offsets.back();
+	offset = std::min(offset, total);
+	uint64_t end = offset + std::min(length, total - offset);
+	size_t size = (size_t)(end - offset);
+	uint8_t *buf = (uint8_t *)malloc(size ? size : 1);
+	if (!buf)
+		return ENOMEM;
+	// The last frame starting at or before `offset`.
+	uint32_t i = (uint32_t)(std::upper_bound(s->d_offsets.begin(),
+	                                         s->d_offsets.end(), offset) -
+	                        s->d_offsets.begin() - 1);
+	for (uint64_t pos = offset; pos < end; i++) {
+		uint64_t frame_end = std::min(s->d_offsets[i + 1], end);
+		if (frame_end == pos)
+			continue; // an empty frame
+		size_t n = (size_t)(frame_end - pos);
+		int err = seekable_read_part(s, i, (size_t)(pos - s->d_offsets[i]), n,
+		                             buf + (pos - offset));
+		if (err) {
+			free(buf);
+			return err;
+		}
+		pos = frame_end;
+	}
+	*out = buf;
+	*out_size = size;
+	return 0;
+}
+
+// ---- $.zstdSeekableOpen ----
+struct seekable_open_t {
+	std::string path;
+	size_t cache_max = 0;
+	nx_seekable_t *seekable = nullptr;
+	int err = 0;
+	const char *message = nullptr; // static string
+
+	~seekable_open_t() { seekable_unref(seekable); }
+};
+
+void seekable_open_do(nx_work_t *req) {
+	seekable_open_t *d = (seekable_open_t *)req->data;
+	FILE *file = fopen(d->path.c_str(), "rb");
+	if (!file) {
+		d->err = errno;
+		return;
+	}
+	nx_seekable_t *s = new nx_seekable_t();
+	s->file = file;
+	s->cache_max = d->cache_max;
+	d->seekable = s;
+	if (fseek(file, 0, SEEK_END) != 0) {
+		d->err = errno;
+		return;
+	}
+	long size = ftell(file);
+	if (size < 0) {
+		d->err = errno;
+		return;
+	}
+	d->message = seekable_parse(s, (uint64_t)size, &d->err);
+}
+
+MaybeLocal<Value> seekable_open_cb(Isolate *iso, nx_work_t *req) {
+	seekable_open_t *d = (seekable_open_t *)req->data;
+	if (d->err) {
+		nx_throw_errno_error(iso, d->err, "fopen");
+		return MaybeLocal<Value>();
+	}
+	if (d->message) {
+		char msg[512];
+		snprintf(msg, sizeof(msg), "Failed to open '%s': %s", d->path.c_str(),
+		         d->message);
+		iso->ThrowException(Exception::TypeError(nx_str(iso, msg)));
+		return MaybeLocal<Value>();
+	}
+	Local<Context> ctx = iso->GetCurrentContext();
+	Local<Object> obj = nx::NewWrapped(iso);
+	nx_seekable_t *s = d->seekable;
+	d->seekable = nullptr;
+	nx::Wrap<nx_seekable_t>(iso, obj, s, seekable_unref);
+	Local<Array> arr = Array::New(iso, 3);
+	arr->Set(ctx, 0, obj).Check();
+	arr->Set(ctx, 1, Number::New(iso, (double)s->d_offsets.back())).Check();
+	arr->Set(ctx, 2, Number::New(iso, (double)(s->d_offsets.size() - 1)))
+	    .Check();
+	return arr.As<Value>();
+}
+
+// $.zstdSeekableOpen(path, cacheSize) -> Promise<[handle, size, frames]>
+void nx_zstd_seekable_open(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	String::Utf8Value path(iso, info[0]);
+	if (!*path)
+		return;
+	double cache = info[1]->IsNumber() ? info[1].As<Number>()->Value() : NAN;
+	if (!(cache >= 0)) {
+		iso->ThrowException(Exception::RangeError(
+		    nx_str(iso, "cacheSize must be a non-negative number")));
+		return;
+	}
+	NX_INIT_WORK_T_CPP(seekable_open_t);
+	data->path = *path;
+	data->cache_max = cache < (double)SIZE_MAX ? (size_t)cache : SIZE_MAX;
+	info.GetReturnValue().Set(
+	    nx_queue_async(iso, req, seekable_open_do, seekable_open_cb));
+}
+
+// ---- $.zstdSeekableRead ----
+struct seekable_read_t {
+	nx_seekable_t *seekable = nullptr; // a reference
+	uint64_t offset = 0;
+	uint64_t length = 0;
+	uint8_t *result = nullptr;
+	size_t size = 0;
+	int err = 0;
+
+	~seekable_read_t() {
+		free(result);
+		seekable_unref(seekable);
+	}
+};
+
+void seekable_read_do(nx_work_t *req) {
+	seekable_read_t *d = (seekable_read_t *)req->data;
+	d->err = seekable_read(d->seekable, d->offset, d->length, &d->result,
+	                       &d->size);
+}
+
+MaybeLocal<Value> seekable_read_cb(Isolate *iso, nx_work_t *req) {
+	seekable_read_t *d = (seekable_read_t *)req->data;
+	if (d->err == ENOMEM) {
+		nx_throw_oom(iso, (size_t)d->length);
+		return MaybeLocal<Value>();
+	}
+	if (d->err == EBADMSG) {
+		iso->ThrowException(Exception::TypeError(
+		    nx_str(iso, "Failed to read: the data is corrupt")));
+		return MaybeLocal<Value>();
+	}
+	if (d->err) {
+		nx_throw_errno_error(iso, d->err, "fread");
+		return MaybeLocal<Value>();
+	}
+	return result_or_throw(iso, 0, &d->result, d->size, false);
+}
+
+// $.zstdSeekableRead(handle, offset, length) -> Promise<ArrayBuffer>
+void nx_zstd_seekable_read(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	nx_seekable_t *s = nx::Unwrap<nx_seekable_t>(info[0]);
+	if (!s)
+		return;
+	double offset = info[1]->IsNumber() ? info[1].As<Number>()->Value() : NAN;
+	double length = info[2]->IsNumber() ? info[2].As<Number>()->Value() : NAN;
+	if (!(offset >= 0 && length >= 0)) {
+		iso->ThrowException(Exception::RangeError(
+		    nx_str(iso, "offset and length must be non-negative numbers")));
+		return;
+	}
+	NX_INIT_WORK_T_CPP(seekable_read_t);
+	data->seekable = seekable_ref(s);
+	data->offset = offset < 0x1p64 ? (uint64_t)offset : UINT64_MAX;
+	data->length = length < 0x1p64 ? (uint64_t)length : UINT64_MAX;
+	info.GetReturnValue().Set(
+	    nx_queue_async(iso, req, seekable_read_do, seekable_read_cb));
+}
+
+
 } // namespace
 
+bool nx_decompress_exact(nx_compression_format_t format, const uint8_t *data,
+                         size_t size, uint8_t *out, size_t out_size) {
+	fmt_t fmt = (fmt_t)format;
+	// Kept per thread (reset between calls), since archive readers decompress
+	// many small entries in a row: only the first call on a thread allocates.
+	static thread_local z_stream *zs = NULL;
+	static thread_local ZSTD_DCtx *dctx = NULL;
+	if (fmt == NX_FMT_ZSTD) {
+		if (!dctx && !(dctx = ZSTD_createDCtx()))
+			return false;
+		size_t n = ZSTD_decompressDCtx(dctx, out, out_size, data, size);
+		return !ZSTD_isError(n) && n == out_size;
+	}
+	if (!is_zlib(fmt))
+		return false;
+	int bits = zlib_window_bits(fmt);
+	if (!zs) {
+		zs = (z_stream *)calloc(1, sizeof(z_stream));
+		if (!zs)
+			return false;
+		if (inflateInit2(zs, bits) != Z_OK) {
+			free(zs);
+			zs = NULL;
+			return false;
+		}
+	} else if (inflateReset2(zs, bits) != Z_OK) {
+		return false;
+	}
+	// One inflate() call when the sizes fit zlib's 32-bit counters, as they
+	// do for any archive entry on FAT32; otherwise, loop.
+	zs->next_in = (Bytef *)data;
+	zs->next_out = out;
+	size_t in_left = size, out_left = out_size;
+	int ret = Z_OK;
+	while (ret == Z_OK) {
+		zs->avail_in = (uInt)std::min(in_left, (size_t)UINT32_MAX);
+		zs->avail_out = (uInt)std::min(out_left, (size_t)UINT32_MAX);
+		in_left -= zs->avail_in;
+		out_left -= zs->avail_out;
+		ret = inflate(zs, Z_FINISH);
+		in_left += zs->avail_in;
+		out_left += zs->avail_out;
+		if (ret == Z_BUF_ERROR && out_left && in_left)
+			ret = Z_OK;
+	}
+	// An extra byte of output would mean the entry is larger than recorded.
+	return ret == Z_STREAM_END && out_left == 0;
+}
+
 void nx_init_compression(Isolate *iso, Local<Object> init_obj) {
 	NX_SET_FUNC(init_obj, "compressNew", nx_compress_new);
 	NX_SET_FUNC(init_obj, "compressWrite", nx_compress_write);
@@ -879,4 +2423,15 @@ void nx_init_compression(Isolate *iso, Local<Object> init_obj) {
 	NX_SET_FUNC(init_obj, "decompressFlush", nx_decompress_flush);
 	NX_SET_FUNC(init_obj, "decompressFileNew", nx_decompress_file_new);
 	NX_SET_FUNC(init_obj, "decompressFilePull", nx_decompress_file_pull);
+	NX_SET_FUNC(init_obj, "zstdDictNew", nx_zstd_dict_new);
+	NX_SET_FUNC(init_obj, "compress", nx_compress);
+	NX_SET_FUNC(init_obj, "compressSync", nx_compress_sync);
+	NX_SET_FUNC(init_obj, "decompress", nx_decompress);
+	NX_SET_FUNC(init_obj, "decompressSync", nx_decompress_sync);
+	NX_SET_FUNC(init_obj, "zstdSeekableWriterNew", nx_zstd_seekable_writer_new);
+	NX_SET_FUNC(init_obj, "zstdSeekableWriterWrite",
+	            nx_zstd_seekable_writer_write);
+	NX_SET_FUNC(init_obj, "zstdSeekableWriterEnd", nx_zstd_seekable_writer_end);
+	NX_SET_FUNC(init_obj, "zstdSeekableOpen", nx_zstd_seekable_open);
+	NX_SET_FUNC(init_obj, "zstdSeekableRead", nx_zstd_seekable_read);
 }
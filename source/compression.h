@@ -1,7 +1,6 @@
 #pragma once
 #include "types.h"
-#include <zlib.h>
-#include <zstd.h>
+#include <stdint.h>
 
 typedef enum {
 	NX_COMPRESSION_FORMAT_UNKNOWN,
@@ -11,20 +10,11 @@ typedef enum {
 	NX_COMPRESSION_FORMAT_ZSTD,
 } nx_compression_format_t;
 
-typedef struct {
-	nx_compression_format_t format;
-	union {
-		z_stream *zstream;
-		ZSTD_CCtx *cctx;
-	};
-} nx_compress_t;
+void nx_init_compression(v8::Isolate *iso, v8::Local<v8::Object> init_obj);
 
-typedef struct {
-	nx_compression_format_t format;
-	union {
-		z_stream *zstream;
-		ZSTD_DCtx *dctx;
-	};
-} nx_decompress_t;
-
-void nx_init_compression(JSContext *ctx, JSValueConst init_obj);
+// Decompresses `size` bytes of `format` data in one call into `out`, whose
+// `out_size` must be the exact decompressed size (as recorded by archive
+// formats). Returns false if the data is corrupt, or decompresses to any
+// other size. Any thread.
+bool nx_decompress_exact(nx_compression_format_t format, const uint8_t *data,
+                         size_t size, uint8_t *out, size_t out_size);
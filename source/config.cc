@@ -213,12 +213,49 @@ static int ini_cb(void *user, const char *section, const char *name,
 					        "(use auto|default|0-4096)",
 					        value);
 			}
+		} else if (str_ieq(name, "raster_threads")) {
+			// Deferred tile-parallel raster for the screen canvas (see
+			// nx_canvas_set_raster_threads). "off" (default) = immediate.
+			if (str_ieq(value, "off") || str_ieq(value, "false")) {
+				cfg->raster_threads = 0;
+			} else if (str_ieq(value, "auto") || str_ieq(value, "on")) {
+				cfg->raster_threads = NX_RASTER_THREADS_AUTO;
+			} else {
+				char *end = NULL;
+				unsigned long n = strtoul(value, &end, 10);
+				if (end && end != value && *end == '\0' && n <= 4)
+					cfg->raster_threads = (uint32_t)n;
+				else
+					cfg_log("renderer.raster_threads=\"%s\" not honored: "
+					        "invalid (use off|auto|0-4), using off",
+					        value);
+			}
 		} else {
 			cfg_log("renderer.%s ignored: unknown key", name);
 		}
 		return 1;
 	}
 
+	if (str_ieq(section, "video")) {
+		if (str_ieq(name, "decode_threads")) {
+			if (str_ieq(value, "auto")) {
+				cfg->video_decode_threads = 0;
+			} else {
+				char *end = NULL;
+				unsigned long n = strtoul(value, &end, 10);
+				if (end && end != value && *end == '\0' && n >= 1 && n <= 4)
+					cfg->video_decode_threads = (uint32_t)n;
+				else
+					cfg_log("video.decode_threads=\"%s\" not honored: "
+					        "invalid (use auto|1-4), using auto",
+					        value);
+			}
+		} else {
+			cfg_log("video.%s ignored: unknown key", name);
+		}
+		return 1;
+	}
+
 	if (str_ieq(section, "socket")) {
 		nx_socket_config_t *s = &cfg->socket;
 		uint32_t u;
@@ -339,6 +376,8 @@ void nx_config_defaults(nx_config_t *cfg) {
 	cfg->heap_limit = 0;
 	cfg->code_headroom_mb = NX_CODE_HEADROOM_AUTO;
 	cfg->gpu_cache_mib = NX_GPU_CACHE_AUTO;
+	cfg->raster_threads = 0;
+	cfg->video_decode_threads = 0;
 	cfg->loaded = false;
 }
 
@@ -22,6 +22,13 @@
 //                           ;   mode, Skia default (~96) in applet mode.
 //                           ;   default = always Skia default. A number sets
 //                           ;   an explicit cap.
+//   raster_threads = off    ; deferred tile-parallel raster for the screen
+//                           ;   canvas: off | auto | 1-4. auto = 3 (the JS
+//                           ;   thread + one worker per other app core).
+//
+//   [video]
+//   decode_threads = auto   ; frame threads per video decoder: auto | 1-4.
+//                           ;   auto = 2 (leaves the JS + audio threads a core)
 //
 //   [console]               ; on-screen console / terminal styling
 //   font_size      = 22
@@ -87,6 +94,10 @@ typedef enum {
 // distinguishable from unset.
 #define NX_GPU_CACHE_AUTO 0xFFFFFFFFu
 
+// `[renderer] raster_threads = auto`: the JS thread plus one worker for each
+// of the other two CPU cores an application may schedule on.
+#define NX_RASTER_THREADS_AUTO 3
+
 typedef enum {
 	NX_RENDER_AUTO = 0, // regime-based: raster in applet, GPU (w/ fallback) in app
 	NX_RENDER_CPU,      // force raster
@@ -185,6 +196,14 @@ typedef struct {
 	// would starve Mesa). An explicit value (incl. 0 = force Skia default)
 	// overrides the regime default.
 	uint32_t gpu_cache_mib;
+	// [renderer] raster_threads: 0 (default) rasterizes screen-canvas draws
+	// immediately on the JS thread. N > 0 records them instead and rasterizes
+	// each frame across horizontal tiles on N threads just before present
+	// (raster renderer only; ignored when the screen is GPU-backed).
+	uint32_t raster_threads;
+	// [video] decode_threads: frame threads per video decoder; 0 (auto) =
+	// the decoder's default (see nx_media_set_decode_threads).
+	uint32_t video_decode_threads;
 	nx_socket_config_t socket;
 	nx_threadpool_config_t threadpool; // [threadpool] libuv pool overrides
 	nx_console_config_t console; // [console] styling, exposed on $.config.console
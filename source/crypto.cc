@@ -3,6 +3,8 @@
 #include "error.h"
 #include "util.h"
 #include "wrap.h"
+#include <algorithm>
+#include <atomic>
 #include <errno.h>
 #include <mbedtls/asn1.h>
 #include <mbedtls/asn1write.h>
@@ -19,12 +21,19 @@
 #include <mbedtls/oid.h>
 #include <mbedtls/pk.h>
 #include <mbedtls/pkcs5.h>
+#include <mbedtls/platform_util.h>
 #include <mbedtls/rsa.h>
 #include <mbedtls/sha512.h>
 #include <mbedtls/version.h>
+#include <memory>
+#include <mutex>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <string>
 #include <switch.h>
+#include <utility>
+#include <vector>
 
 using namespace v8;
 
@@ -91,6 +100,101 @@ mbedtls_md_type_t nx_crypto_get_md_type(const char *hash_name) {
 	return MBEDTLS_MD_NONE;
 }
 
+// ------------------------------------------------------------------
+// Random generator and curve groups shared by every operation
+// ------------------------------------------------------------------
+
+// Calls to the generator between reseeds from the entropy source.
+#define NX_CRYPTO_DRBG_RESEED_INTERVAL 4096
+
+// Per-thread CTR_DRBG, seeded by the first operation that runs on the thread
+// (sign, key generation, RSA padding and blinding) instead of by every one.
+// Worker threads live for the process, so nothing here is ever torn down.
+typedef struct {
+	bool seeded;
+	mbedtls_entropy_context entropy;
+	mbedtls_ctr_drbg_context ctr_drbg;
+} nx_crypto_drbg_t;
+thread_local nx_crypto_drbg_t crypto_drbg;
+
+// Returns the calling thread's generator (for `mbedtls_ctr_drbg_random`), or
+// NULL if it could not be seeded.
+mbedtls_ctr_drbg_context *nx_crypto_drbg() {
+	nx_crypto_drbg_t *d = &crypto_drbg;
+	if (d->seeded)
+		return &d->ctr_drbg;
+	static const char personalization[] = "nx.js crypto";
+	mbedtls_entropy_init(&d->entropy);
+	mbedtls_ctr_drbg_init(&d->ctr_drbg);
+	if (mbedtls_ctr_drbg_seed(&d->ctr_drbg, mbedtls_entropy_func, &d->entropy,
+	                          (const unsigned char *)personalization,
+	                          sizeof(personalization) - 1) != 0) {
+		mbedtls_ctr_drbg_free(&d->ctr_drbg);
+		mbedtls_entropy_free(&d->entropy);
+		return nullptr;
+	}
+	mbedtls_ctr_drbg_set_reseed_interval(&d->ctr_drbg,
+	                                     NX_CRYPTO_DRBG_RESEED_INTERVAL);
+	d->seeded = true;
+	return &d->ctr_drbg;
+}
+
+// One group per curve, shared (read-only) by every EC operation on any
+// thread. Each is loaded once, and its comb table for multiples of the
+// generator (which key generation, signing and verification use) is
+// computed once, rather than for every key, or on every operation of keys
+// whose group has none yet.
+typedef struct {
+	mbedtls_ecp_group_id id;
+	bool loaded;
+	mbedtls_ecp_group grp;
+} nx_crypto_ec_group_t;
+
+nx_crypto_ec_group_t crypto_ec_groups[] = {
+    {MBEDTLS_ECP_DP_SECP256R1, false, {}},
+    {MBEDTLS_ECP_DP_SECP384R1, false, {}},
+};
+std::mutex crypto_ec_groups_mutex;
+
+// Returns the shared group of curve `id`, or NULL if it could not be loaded.
+// The group must not be modified.
+mbedtls_ecp_group *nx_crypto_ec_group(mbedtls_ecp_group_id id) {
+	std::lock_guard<std::mutex> lock(crypto_ec_groups_mutex);
+	for (nx_crypto_ec_group_t &g : crypto_ec_groups) {
+		if (g.id != id)
+			continue;
+		if (g.loaded)
+			return &g.grp;
+		mbedtls_ctr_drbg_context *drbg = nx_crypto_drbg();
+		if (!drbg)
+			return nullptr;
+		mbedtls_ecp_group_init(&g.grp);
+		if (mbedtls_ecp_group_load(&g.grp, id) != 0) {
+			mbedtls_ecp_group_free(&g.grp);
+			return nullptr;
+		}
+		// Multiplying the generator stores its comb table in the group (when
+		// the group does not come with a precomputed one).
+		mbedtls_ecp_point r;
+		mbedtls_mpi one;
+		mbedtls_ecp_point_init(&r);
+		mbedtls_mpi_init(&one);
+		int ret = mbedtls_mpi_lset(&one, 1);
+		if (ret == 0)
+			ret = mbedtls_ecp_mul(&g.grp, &r, &one, &g.grp.G,
+			                      mbedtls_ctr_drbg_random, drbg);
+		mbedtls_ecp_point_free(&r);
+		mbedtls_mpi_free(&one);
+		if (ret != 0) {
+			mbedtls_ecp_group_free(&g.grp);
+			return nullptr;
+		}
+		g.loaded = true;
+		return &g.grp;
+	}
+	return nullptr;
+}
+
 // ------------------------------------------------------------------
 // CryptoKey finalizer (GC). MUST NOT touch any V8 API except Global::Reset.
 // ------------------------------------------------------------------
@@ -158,51 +262,63 @@ struct nx_crypto_digest_async_t {
 	size_t result_size = 0;
 };
 
-void nx_crypto_digest_do(nx_work_t *req) {
-	nx_crypto_digest_async_t *data = (nx_crypto_digest_async_t *)req->data;
-	int alg = -1;
-	if (strcasecmp(data->algorithm, "SHA-1") == 0) {
-		alg = NX_CRYPTO_SHA1;
-		data->result_size = SHA1_HASH_SIZE;
-	} else if (strcasecmp(data->algorithm, "SHA-256") == 0) {
-		alg = NX_CRYPTO_SHA256;
-		data->result_size = SHA256_HASH_SIZE;
-	} else if (strcasecmp(data->algorithm, "SHA-384") == 0) {
-		alg = NX_CRYPTO_SHA384;
-		data->result_size = 0x30;
-	} else if (strcasecmp(data->algorithm, "SHA-512") == 0) {
-		alg = NX_CRYPTO_SHA512;
-		data->result_size = 0x40;
-	}
-	if (alg == -1) {
-		data->err = ENOTSUP;
-		return;
-	}
-	data->result = (uint8_t *)calloc(1, data->result_size);
-	if (!data->result) {
-		data->err = ENOMEM;
-		return;
-	}
+// Identifies digest `algorithm`, setting `*size` to the digest size. Returns
+// one of NX_CRYPTO_SHA*, or -1 if it is not supported.
+int nx_crypto_digest_alg(const char *algorithm, size_t *size) {
+	if (strcasecmp(algorithm, "SHA-1") == 0) {
+		*size = SHA1_HASH_SIZE;
+		return NX_CRYPTO_SHA1;
+	} else if (strcasecmp(algorithm, "SHA-256") == 0) {
+		*size = SHA256_HASH_SIZE;
+		return NX_CRYPTO_SHA256;
+	} else if (strcasecmp(algorithm, "SHA-384") == 0) {
+		*size = 0x30;
+		return NX_CRYPTO_SHA384;
+	} else if (strcasecmp(algorithm, "SHA-512") == 0) {
+		*size = 0x40;
+		return NX_CRYPTO_SHA512;
+	}
+	return -1;
+}
+
+// Computes the `alg` digest of `data` into `out`. Any thread.
+void nx_crypto_digest_raw(int alg, const uint8_t *data, size_t size,
+                          uint8_t *out) {
 	switch (alg) {
 	case NX_CRYPTO_SHA1:
-		sha1CalculateHash(data->result, data->data, data->size);
+		sha1CalculateHash(out, data, size);
 		break;
 	case NX_CRYPTO_SHA256:
-		sha256CalculateHash(data->result, data->data, data->size);
+		sha256CalculateHash(out, data, size);
 		break;
 	case NX_CRYPTO_SHA384:
 	case NX_CRYPTO_SHA512: {
 		mbedtls_sha512_context sha512_ctx;
 		mbedtls_sha512_init(&sha512_ctx);
 		mbedtls_sha512_starts(&sha512_ctx, alg == NX_CRYPTO_SHA384);
-		mbedtls_sha512_update(&sha512_ctx, data->data, data->size);
-		mbedtls_sha512_finish(&sha512_ctx, data->result);
+		mbedtls_sha512_update(&sha512_ctx, data, size);
+		mbedtls_sha512_finish(&sha512_ctx, out);
 		mbedtls_sha512_free(&sha512_ctx);
 		break;
 	}
 	}
 }
 
+void nx_crypto_digest_do(nx_work_t *req) {
+	nx_crypto_digest_async_t *data = (nx_crypto_digest_async_t *)req->data;
+	int alg = nx_crypto_digest_alg(data->algorithm, &data->result_size);
+	if (alg == -1) {
+		data->err = ENOTSUP;
+		return;
+	}
+	data->result = (uint8_t *)calloc(1, data->result_size);
+	if (!data->result) {
+		data->err = ENOMEM;
+		return;
+	}
+	nx_crypto_digest_raw(alg, data->data, data->size, data->result);
+}
+
 MaybeLocal<Value> nx_crypto_digest_cb(Isolate *iso, nx_work_t *req) {
 	nx_crypto_digest_async_t *data = (nx_crypto_digest_async_t *)req->data;
 	free(data->algorithm);
@@ -425,18 +541,12 @@ void nx_crypto_encrypt_do(nx_work_t *req) {
 
 		mbedtls_md_type_t md_type = nx_crypto_get_md_type(rsa->hash_name);
 
-		mbedtls_entropy_context oaep_entropy;
-		mbedtls_ctr_drbg_context oaep_ctr_drbg;
-		mbedtls_entropy_init(&oaep_entropy);
-		mbedtls_ctr_drbg_init(&oaep_ctr_drbg);
-		int ret = mbedtls_ctr_drbg_seed(&oaep_ctr_drbg, mbedtls_entropy_func,
-		                                &oaep_entropy, NULL, 0);
-		if (ret != 0) {
-			mbedtls_ctr_drbg_free(&oaep_ctr_drbg);
-			mbedtls_entropy_free(&oaep_entropy);
+		int ret;
+		mbedtls_ctr_drbg_context *drbg = nx_crypto_drbg();
+		if (!drbg) {
 			free(data->result);
 			data->result = nullptr;
-			data->err = ret;
+			data->err = MBEDTLS_ERR_CTR_DRBG_ENTROPY_SOURCE_FAILED;
 			return;
 		}
 
@@ -453,19 +563,16 @@ void nx_crypto_encrypt_do(nx_work_t *req) {
 
 #if MBEDTLS_VERSION_MAJOR >= 3
 		ret = mbedtls_rsa_rsaes_oaep_encrypt(
-		    &rsa->rsa, mbedtls_ctr_drbg_random, &oaep_ctr_drbg,
+		    &rsa->rsa, mbedtls_ctr_drbg_random, drbg,
 		    (const unsigned char *)label, label_len, data->data_size,
 		    data->data, (uint8_t *)data->result);
 #else
 		ret = mbedtls_rsa_rsaes_oaep_encrypt(
-		    &rsa->rsa, mbedtls_ctr_drbg_random, &oaep_ctr_drbg,
+		    &rsa->rsa, mbedtls_ctr_drbg_random, drbg,
 		    MBEDTLS_RSA_PUBLIC, (const unsigned char *)label, label_len,
 		    data->data_size, data->data, (uint8_t *)data->result);
 #endif
 
-		mbedtls_ctr_drbg_free(&oaep_ctr_drbg);
-		mbedtls_entropy_free(&oaep_entropy);
-
 		if (ret != 0) {
 			free(data->result);
 			data->result = nullptr;
@@ -822,16 +929,10 @@ void nx_crypto_decrypt_do(nx_work_t *req) {
 
 		mbedtls_md_type_t md_type = nx_crypto_get_md_type(rsa->hash_name);
 
-		mbedtls_entropy_context dec_entropy;
-		mbedtls_ctr_drbg_context dec_ctr_drbg;
-		mbedtls_entropy_init(&dec_entropy);
-		mbedtls_ctr_drbg_init(&dec_ctr_drbg);
-		int ret = mbedtls_ctr_drbg_seed(&dec_ctr_drbg, mbedtls_entropy_func,
-		                                &dec_entropy, NULL, 0);
-		if (ret != 0) {
-			mbedtls_ctr_drbg_free(&dec_ctr_drbg);
-			mbedtls_entropy_free(&dec_entropy);
-			data->err = ret;
+		int ret;
+		mbedtls_ctr_drbg_context *drbg = nx_crypto_drbg();
+		if (!drbg) {
+			data->err = MBEDTLS_ERR_CTR_DRBG_ENTROPY_SOURCE_FAILED;
 			return;
 		}
 
@@ -848,8 +949,6 @@ void nx_crypto_decrypt_do(nx_work_t *req) {
 
 		uint8_t *output = (uint8_t *)malloc(rsa_len);
 		if (!output) {
-			mbedtls_ctr_drbg_free(&dec_ctr_drbg);
-			mbedtls_entropy_free(&dec_entropy);
 			data->err = ENOMEM;
 			return;
 		}
@@ -857,19 +956,16 @@ void nx_crypto_decrypt_do(nx_work_t *req) {
 		size_t olen = 0;
 #if MBEDTLS_VERSION_MAJOR >= 3
 		ret = mbedtls_rsa_rsaes_oaep_decrypt(
-		    &rsa->rsa, mbedtls_ctr_drbg_random, &dec_ctr_drbg,
+		    &rsa->rsa, mbedtls_ctr_drbg_random, drbg,
 		    (const unsigned char *)label, label_len, &olen, data->data, output,
 		    rsa_len);
 #else
 		ret = mbedtls_rsa_rsaes_oaep_decrypt(
-		    &rsa->rsa, mbedtls_ctr_drbg_random, &dec_ctr_drbg,
+		    &rsa->rsa, mbedtls_ctr_drbg_random, drbg,
 		    MBEDTLS_RSA_PRIVATE, (const unsigned char *)label, label_len, &olen,
 		    data->data, output, rsa_len);
 #endif
 
-		mbedtls_ctr_drbg_free(&dec_ctr_drbg);
-		mbedtls_entropy_free(&dec_entropy);
-
 		if (ret != 0) {
 			free(output);
 			data->err = EACCES;
@@ -925,6 +1021,613 @@ void nx_crypto_decrypt(const FunctionCallbackInfo<Value> &info) {
 	    nx_queue_async(iso, req, nx_crypto_decrypt_do, nx_crypto_encrypt_cb));
 }
 
+// ==================================================================
+// Streaming AES (Switch.Cipher): update() / final() over any number of
+// chunks, for data too large to encrypt or decrypt in one piece.
+//
+// A cipher copies the key's libnx AES-CBC / AES-CTR context once (GCM sets
+// up an mbedtls GCM context), and carries its state from chunk to chunk;
+// every update() then encrypts straight into the caller's buffer (or in
+// place). Whole blocks go to the AES context in one call; the few bytes
+// which do not make a whole block yet (or, when decrypting, which may be
+// the padding or the tag) wait in `pending` for the next chunk.
+// ==================================================================
+
+// Chunk size for cryptoCipherFile() (one input and one output buffer).
+#define NX_CIPHER_FILE_CHUNK (1024 * 1024)
+
+struct nx_cipher_t {
+	nx_crypto_key_algorithm algorithm;
+	bool encrypt;
+	u8 key_length;
+	union {
+		Aes128CbcContext cbc_128;
+		Aes192CbcContext cbc_192;
+		Aes256CbcContext cbc_256;
+		Aes128CtrContext ctr_128;
+		Aes192CtrContext ctr_192;
+		Aes256CtrContext ctr_256;
+	} aes;
+	mbedtls_gcm_context gcm;
+	size_t tag_length; // GCM
+	// Input not processed yet: under a block, or (decrypting) the last
+	// block, or the tag and the partial block before it.
+	uint8_t pending[AES_BLOCK_SIZE * 2];
+	size_t pending_size;
+	bool busy;     // an operation is in flight (main thread)
+	bool finished; // final() was called
+};
+
+void free_cipher(nx_cipher_t *c) {
+	if (c->algorithm == NX_CRYPTO_KEY_ALGORITHM_AES_GCM)
+		mbedtls_gcm_free(&c->gcm);
+	mbedtls_platform_zeroize(c, sizeof(*c));
+	free(c);
+}
+
+// Bytes of output for `size` more bytes of input: whole blocks only, less
+// what decryption must hold back for final().
+size_t cipher_output_size(const nx_cipher_t *c, size_t size) {
+	size_t total = c->pending_size + size;
+	switch (c->algorithm) {
+	case NX_CRYPTO_KEY_ALGORITHM_AES_CTR:
+		return size;
+	case NX_CRYPTO_KEY_ALGORITHM_AES_CBC:
+		if (c->encrypt)
+			return total / AES_BLOCK_SIZE * AES_BLOCK_SIZE;
+		// Keeps the last block (1 to 16 bytes), which holds the padding.
+		return total ? (total - 1) / AES_BLOCK_SIZE * AES_BLOCK_SIZE : 0;
+	default: // GCM
+		if (c->encrypt)
+			return total / AES_BLOCK_SIZE * AES_BLOCK_SIZE;
+		// Keeps the tag.
+		if (total <= c->tag_length)
+			return 0;
+		return (total - c->tag_length) / AES_BLOCK_SIZE * AES_BLOCK_SIZE;
+	}
+}
+
+// Runs `size` bytes through the cipher: whole blocks, except for CTR and
+// the last call to GCM. Returns 0, or an mbedtls error.
+int cipher_crypt(nx_cipher_t *c, uint8_t *dst, const uint8_t *src,
+                 size_t size) {
+	if (!size)
+		return 0;
+	if (c->algorithm == NX_CRYPTO_KEY_ALGORITHM_AES_CBC) {
+		if (c->encrypt) {
+			if (c->key_length == 16)
+				aes128CbcEncrypt(&c->aes.cbc_128, dst, src, size);
+			else if (c->key_length == 24)
+				aes192CbcEncrypt(&c->aes.cbc_192, dst, src, size);
+			else
+				aes256CbcEncrypt(&c->aes.cbc_256, dst, src, size);
+		} else {
+			if (c->key_length == 16)
+				aes128CbcDecrypt(&c->aes.cbc_128, dst, src, size);
+			else if (c->key_length == 24)
+				aes192CbcDecrypt(&c->aes.cbc_192, dst, src, size);
+			else
+				aes256CbcDecrypt(&c->aes.cbc_256, dst, src, size);
+		}
+		return 0;
+	}
+	if (c->algorithm == NX_CRYPTO_KEY_ALGORITHM_AES_CTR) {
+		if (c->key_length == 16)
+			aes128CtrCrypt(&c->aes.ctr_128, dst, src, size);
+		else if (c->key_length == 24)
+			aes192CtrCrypt(&c->aes.ctr_192, dst, src, size);
+		else
+			aes256CtrCrypt(&c->aes.ctr_256, dst, src, size);
+		return 0;
+	}
+#if MBEDTLS_VERSION_MAJOR >= 3
+	size_t olen = 0;
+	return mbedtls_gcm_update(&c->gcm, src, size, dst, size, &olen);
+#else
+	return mbedtls_gcm_update(&c->gcm, size, src, dst);
+#endif
+}
+
+// Processes `size` bytes of input after the pending ones, writing
+// cipher_output_size() bytes to `out`, which must not overlap `in` unless
+// it is `in` itself with nothing pending. Returns 0, or an mbedtls error.
+int cipher_update(nx_cipher_t *c, const uint8_t *in, size_t size,
+                  uint8_t *out) {
+	size_t pending = c->pending_size;
+	size_t total = pending + size;
+	size_t emit = cipher_output_size(c, size);
+	// The input left over, taken before `out` is written (in place).
+	uint8_t rest[sizeof(c->pending)];
+	size_t rest_size = total - emit;
+	if (emit >= pending) {
+		memcpy(rest, in + (emit - pending), rest_size);
+	} else {
+		memcpy(rest, c->pending + emit, pending - emit);
+		memcpy(rest + (pending - emit), in, size);
+	}
+	// The blocks which start in `pending`, completed from `in`.
+	size_t head = 0;
+	if (pending && emit) {
+		uint8_t block[sizeof(c->pending) + AES_BLOCK_SIZE];
+		head = (pending + AES_BLOCK_SIZE - 1) / AES_BLOCK_SIZE * AES_BLOCK_SIZE;
+		if (head > emit)
+			head = emit;
+		memcpy(block, c->pending, std::min(pending, head));
+		if (head > pending)
+			memcpy(block + pending, in, head - pending);
+		int ret = cipher_crypt(c, out, block, head);
+		if (ret)
+			return ret;
+	}
+	// The rest, straight from `in`.
+	if (emit > head) {
+		int ret = cipher_crypt(c, out + head, in + (head - pending),
+		                       emit - head);
+		if (ret)
+			return ret;
+	}
+	memcpy(c->pending, rest, rest_size);
+	c->pending_size = rest_size;
+	return 0;
+}
+
+// Errors of cipher_final(), besides mbedtls errors.
+#define NX_CIPHER_BAD_LENGTH (-1)
+#define NX_CIPHER_BAD_PADDING (-2)
+#define NX_CIPHER_BAD_TAG (-3)
+
+// Processes the pending input, into `out` (room for 32 bytes), and sets
+// `*out_size`. Returns 0, an mbedtls error or one of NX_CIPHER_*.
+int cipher_final(nx_cipher_t *c, uint8_t *out, size_t *out_size) {
+	size_t pending = c->pending_size;
+	c->pending_size = 0;
+	*out_size = 0;
+	if (c->algorithm == NX_CRYPTO_KEY_ALGORITHM_AES_CTR)
+		return 0;
+	if (c->algorithm == NX_CRYPTO_KEY_ALGORITHM_AES_CBC) {
+		if (c->encrypt) {
+			uint8_t pad = (uint8_t)(AES_BLOCK_SIZE - pending);
+			memset(c->pending + pending, pad, pad);
+			*out_size = AES_BLOCK_SIZE;
+			return cipher_crypt(c, out, c->pending, AES_BLOCK_SIZE);
+		}
+		if (pending != AES_BLOCK_SIZE)
+			return NX_CIPHER_BAD_LENGTH;
+		cipher_crypt(c, out, c->pending, AES_BLOCK_SIZE);
+		uint8_t pad = out[AES_BLOCK_SIZE - 1];
+		if (pad == 0 || pad > AES_BLOCK_SIZE)
+			return NX_CIPHER_BAD_PADDING;
+		for (size_t i = AES_BLOCK_SIZE - pad; i < AES_BLOCK_SIZE; i++) {
+			if (out[i] != pad)
+				return NX_CIPHER_BAD_PADDING;
+		}
+		*out_size = AES_BLOCK_SIZE - pad;
+		return 0;
+	}
+	// GCM: the last partial block, then the tag.
+	size_t tag_length = c->tag_length;
+	size_t data_size = pending;
+	if (!c->encrypt) {
+		if (pending < tag_length)
+			return NX_CIPHER_BAD_LENGTH;
+		data_size -= tag_length;
+	}
+	int ret = cipher_crypt(c, out, c->pending, data_size);
+	if (ret)
+		return ret;
+	uint8_t tag[16];
+#if MBEDTLS_VERSION_MAJOR >= 3
+	size_t olen = 0;
+	ret = mbedtls_gcm_finish(&c->gcm, NULL, 0, &olen, tag, tag_length);
+#else
+	ret = mbedtls_gcm_finish(&c->gcm, tag, tag_length);
+#endif
+	if (ret)
+		return ret;
+	if (c->encrypt) {
+		memcpy(out + data_size, tag, tag_length);
+		*out_size = data_size + tag_length;
+		return 0;
+	}
+	// Constant time comparison.
+	uint8_t diff = 0;
+	for (size_t i = 0; i < tag_length; i++)
+		diff |= tag[i] ^ c->pending[data_size + i];
+	if (diff) {
+		mbedtls_platform_zeroize(out, data_size);
+		return NX_CIPHER_BAD_TAG;
+	}
+	*out_size = data_size;
+	return 0;
+}
+
+void nx_cipher_throw(Isolate *iso, int err) {
+	const char *msg;
+	switch (err) {
+	case ENOMEM:
+		msg = "Out of memory";
+		break;
+	case NX_CIPHER_BAD_LENGTH:
+		msg = "The data is truncated";
+		break;
+	case NX_CIPHER_BAD_PADDING:
+		msg = "The data is not correctly padded";
+		break;
+	case NX_CIPHER_BAD_TAG:
+		msg = "The authentication tag does not match";
+		break;
+	default:
+		msg = "The operation failed";
+		break;
+	}
+	nx_throw(iso, msg);
+}
+
+nx_cipher_t *nx_get_cipher(Isolate *iso, Local<Value> v) {
+	nx_cipher_t *c = nx::Unwrap<nx_cipher_t>(v);
+	if (!c) {
+		nx_throw(iso, "invalid cipher");
+		return nullptr;
+	}
+	if (c->busy) {
+		nx_throw(iso, "Another operation is in progress on this cipher");
+		return nullptr;
+	}
+	if (c->finished) {
+		nx_throw(iso, "The cipher is finished");
+		return nullptr;
+	}
+	return c;
+}
+
+// $.cryptoCipherNew(encrypt, algorithm, key) -> handle
+void nx_crypto_cipher_new(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	bool encrypt = info[0]->BooleanValue(iso);
+	nx_crypto_encrypt_async_t params;
+	params.key = nx_get_crypto_key(info[2]);
+	if (!params.key) {
+		nx_throw(iso, "invalid key");
+		return;
+	}
+	nx_crypto_key_algorithm algorithm = params.key->algorithm;
+	if (algorithm != NX_CRYPTO_KEY_ALGORITHM_AES_CBC &&
+	    algorithm != NX_CRYPTO_KEY_ALGORITHM_AES_CTR &&
+	    algorithm != NX_CRYPTO_KEY_ALGORITHM_AES_GCM) {
+		iso->ThrowException(Exception::TypeError(nx_str(
+		    iso, "Only AES-CBC, AES-CTR and AES-GCM keys can be streamed")));
+		return;
+	}
+	if (!(params.key->usages & (encrypt ? NX_CRYPTO_KEY_USAGE_ENCRYPT
+	                                    : NX_CRYPTO_KEY_USAGE_DECRYPT))) {
+		nx_throw(iso, encrypt ? "Key does not support the 'encrypt' operation"
+		                      : "Key does not support the 'decrypt' operation");
+		return;
+	}
+	if (!nx_crypto_parse_cipher_params(iso, info[1], &params))
+		return;
+	nx_cipher_t *c = (nx_cipher_t *)calloc(1, sizeof(nx_cipher_t));
+	if (!c) {
+		free(params.algorithm_params);
+		nx_throw(iso, "out of memory");
+		return;
+	}
+	c->algorithm = algorithm;
+	c->encrypt = encrypt;
+	nx_crypto_key_aes_t *aes = (nx_crypto_key_aes_t *)params.key->handle;
+	if (algorithm == NX_CRYPTO_KEY_ALGORITHM_AES_CBC) {
+		const uint8_t *iv =
+		    ((nx_crypto_aes_cbc_params_t *)params.algorithm_params)->iv;
+		c->key_length = aes->key_length;
+		if (aes->key_length == 16) {
+			c->aes.cbc_128 =
+			    encrypt ? aes->encrypt.cbc_128 : aes->decrypt.cbc_128;
+			aes128CbcContextResetIv(&c->aes.cbc_128, iv);
+		} else if (aes->key_length == 24) {
+			c->aes.cbc_192 =
+			    encrypt ? aes->encrypt.cbc_192 : aes->decrypt.cbc_192;
+			aes192CbcContextResetIv(&c->aes.cbc_192, iv);
+		} else {
+			c->aes.cbc_256 =
+			    encrypt ? aes->encrypt.cbc_256 : aes->decrypt.cbc_256;
+			aes256CbcContextResetIv(&c->aes.cbc_256, iv);
+		}
+	} else if (algorithm == NX_CRYPTO_KEY_ALGORITHM_AES_CTR) {
+		const uint8_t *ctr =
+		    ((nx_crypto_aes_ctr_params_t *)params.algorithm_params)->ctr;
+		c->key_length = aes->key_length;
+		if (aes->key_length == 16) {
+			c->aes.ctr_128 = aes->decrypt.ctr_128;
+			aes128CtrContextResetCtr(&c->aes.ctr_128, ctr);
+		} else if (aes->key_length == 24) {
+			c->aes.ctr_192 = aes->decrypt.ctr_192;
+			aes192CtrContextResetCtr(&c->aes.ctr_192, ctr);
+		} else {
+			c->aes.ctr_256 = aes->decrypt.ctr_256;
+			aes256CtrContextResetCtr(&c->aes.ctr_256, ctr);
+		}
+	} else {
+		nx_crypto_aes_gcm_params_t *gcm_params =
+		    (nx_crypto_aes_gcm_params_t *)params.algorithm_params;
+		c->tag_length = gcm_params->tag_length;
+		mbedtls_gcm_init(&c->gcm);
+		int ret = c->tag_length >= 4 && c->tag_length <= 16 ? 0 : -1;
+		if (!ret)
+			ret = mbedtls_gcm_setkey(&c->gcm, MBEDTLS_CIPHER_ID_AES,
+			                         params.key->raw_key_data,
+			                         params.key->raw_key_size * 8);
+#if MBEDTLS_VERSION_MAJOR >= 3
+		if (!ret)
+			ret = mbedtls_gcm_starts(&c->gcm,
+			                         encrypt ? MBEDTLS_GCM_ENCRYPT
+			                                 : MBEDTLS_GCM_DECRYPT,
+			                         gcm_params->iv, gcm_params->iv_size);
+		if (!ret)
+			ret = mbedtls_gcm_update_ad(&c->gcm, gcm_params->additional_data,
+			                            gcm_params->additional_data_size);
+#else
+		if (!ret)
+			ret = mbedtls_gcm_starts(
+			    &c->gcm, encrypt ? MBEDTLS_GCM_ENCRYPT : MBEDTLS_GCM_DECRYPT,
+			    gcm_params->iv, gcm_params->iv_size,
+			    gcm_params->additional_data,
+			    gcm_params->additional_data_size);
+#endif
+		if (ret) {
+			free(params.algorithm_params);
+			free_cipher(c);
+			nx_throw(iso, "Invalid AES-GCM parameters");
+			return;
+		}
+	}
+	free(params.algorithm_params);
+	Local<Object> obj = nx::NewWrapped(iso);
+	nx::Wrap<nx_cipher_t>(iso, obj, c, free_cipher);
+	info.GetReturnValue().Set(obj);
+}
+
+// ---- $.cryptoCipherUpdate ----
+struct nx_cipher_update_async_t {
+	nx_cipher_t *cipher = nullptr;
+	Global<Value> cipher_val;
+	Global<Value> data_val;
+	Global<Value> output_val;
+	const uint8_t *data = nullptr;
+	size_t data_size = 0;
+	uint8_t *output = nullptr; // the caller's buffer, or NULL
+	uint8_t *result = nullptr; // otherwise, malloc'd here
+	size_t result_size = 0;
+	int err = 0;
+
+	~nx_cipher_update_async_t() { free(result); }
+};
+
+void nx_cipher_update_do(nx_work_t *req) {
+	nx_cipher_update_async_t *d = (nx_cipher_update_async_t *)req->data;
+	nx_cipher_t *c = d->cipher;
+	size_t size = cipher_output_size(c, d->data_size);
+	uint8_t *out = d->output;
+	if (!out && !(out = d->result = (uint8_t *)malloc(size ? size : 1))) {
+		d->err = ENOMEM;
+		return;
+	}
+	// Overlapping buffers (other than in place, with nothing pending) would
+	// be overwritten before they are read: work from a copy of the input.
+	const uint8_t *in = d->data;
+	uint8_t *copy = nullptr;
+	if (out < in + d->data_size && in < out + size &&
+	    (out != in || c->pending_size)) {
+		if (!(copy = (uint8_t *)malloc(d->data_size))) {
+			d->err = ENOMEM;
+			return;
+		}
+		memcpy(copy, in, d->data_size);
+		in = copy;
+	}
+	d->err = cipher_update(c, in, d->data_size, out);
+	free(copy);
+	d->result_size = size;
+}
+
+MaybeLocal<Value> nx_cipher_update_cb(Isolate *iso, nx_work_t *req) {
+	nx_cipher_update_async_t *d = (nx_cipher_update_async_t *)req->data;
+	d->cipher->busy = false;
+	d->cipher_val.Reset();
+	d->data_val.Reset();
+	d->output_val.Reset();
+	if (d->err) {
+		nx_cipher_throw(iso, d->err);
+		return MaybeLocal<Value>();
+	}
+	if (d->output)
+		return Number::New(iso, (double)d->result_size);
+	void *result = d->result;
+	d->result = nullptr;
+	return nx_ab_take(iso, result, d->result_size);
+}
+
+// $.cryptoCipherUpdate(handle, data, output?) -> Promise<ArrayBuffer>, or with
+// `output`, Promise<number>: the bytes written to it.
+void nx_crypto_cipher_update(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	nx_cipher_t *c = nx_get_cipher(iso, info[0]);
+	if (!c)
+		return;
+	size_t data_size = 0;
+	uint8_t *data = NX_GetBufferSource(iso, &data_size, info[1]);
+	if (!data) {
+		nx_throw(iso, "expected ArrayBuffer");
+		return;
+	}
+	uint8_t *output = nullptr;
+	if (!info[2]->IsUndefined()) {
+		size_t output_size = 0;
+		output = NX_GetBufferSource(iso, &output_size, info[2]);
+		if (!output) {
+			nx_throw(iso, "expected ArrayBuffer");
+			return;
+		}
+		size_t needed = cipher_output_size(c, data_size);
+		if (output_size < needed) {
+			char msg[128];
+			snprintf(msg, sizeof(msg),
+			         "The output buffer is too small (%zu bytes needed)",
+			         needed);
+			iso->ThrowException(Exception::RangeError(nx_str(iso, msg)));
+			return;
+		}
+	}
+	NX_INIT_WORK_T_CPP(nx_cipher_update_async_t);
+	data->cipher = c;
+	data->cipher_val.Reset(iso, info[0]);
+	data->data = NX_GetBufferSource(iso, &data->data_size, info[1]);
+	data->data_val.Reset(iso, info[1]);
+	if (output) {
+		data->output = output;
+		data->output_val.Reset(iso, info[2]);
+	}
+	c->busy = true;
+	info.GetReturnValue().Set(
+	    nx_queue_async(iso, req, nx_cipher_update_do, nx_cipher_update_cb));
+}
+
+// $.cryptoCipherFinal(handle) -> ArrayBuffer. At most 32 bytes of work, so it
+// runs on the calling thread.
+void nx_crypto_cipher_final(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	nx_cipher_t *c = nx_get_cipher(iso, info[0]);
+	if (!c)
+		return;
+	c->finished = true;
+	uint8_t *out = (uint8_t *)malloc(sizeof(c->pending));
+	if (!out) {
+		nx_throw_oom(iso, sizeof(c->pending));
+		return;
+	}
+	size_t size;
+	int err = cipher_final(c, out, &size);
+	if (err) {
+		free(out);
+		nx_cipher_throw(iso, err);
+		return;
+	}
+	info.GetReturnValue().Set(nx_ab_take(iso, out, size));
+}
+
+// ---- $.cryptoCipherFile ----
+struct nx_cipher_file_async_t {
+	nx_cipher_t *cipher = nullptr;
+	Global<Value> cipher_val;
+	std::string source;
+	std::string destination;
+	uint64_t written = 0;
+	int err = 0;       // an errno value, or a cipher error
+	bool io = false;   // `err` is an I/O error
+	const char *syscall = nullptr;
+};
+
+// Runs the whole file `source` through the cipher, including final(),
+// writing the output to `destination`: one thread pool dispatch, and two
+// fixed buffers, however large the file.
+void nx_cipher_file_do(nx_work_t *req) {
+	nx_cipher_file_async_t *d = (nx_cipher_file_async_t *)req->data;
+	nx_cipher_t *c = d->cipher;
+	FILE *src = fopen(d->source.c_str(), "rb");
+	if (!src) {
+		d->err = errno;
+		d->io = true;
+		d->syscall = "fopen";
+		return;
+	}
+	FILE *dst = fopen(d->destination.c_str(), "wb");
+	uint8_t *in = (uint8_t *)malloc(NX_CIPHER_FILE_CHUNK);
+	uint8_t *out =
+	    (uint8_t *)malloc(NX_CIPHER_FILE_CHUNK + sizeof(c->pending));
+	if (!dst) {
+		d->err = errno;
+		d->io = true;
+		d->syscall = "fopen";
+	} else if (!in || !out) {
+		d->err = ENOMEM;
+	}
+	while (!d->err) {
+		size_t n = fread(in, 1, NX_CIPHER_FILE_CHUNK, src);
+		if (n < NX_CIPHER_FILE_CHUNK && ferror(src)) {
+			d->err = errno ? errno : EIO;
+			d->io = true;
+			d->syscall = "fread";
+			break;
+		}
+		size_t size;
+		if (n) {
+			size = cipher_output_size(c, n);
+			d->err = cipher_update(c, in, n, out);
+		} else {
+			d->err = cipher_final(c, out, &size);
+		}
+		if (d->err)
+			break;
+		if (size && fwrite(out, 1, size, dst) != size) {
+			d->err = errno ? errno : EIO;
+			d->io = true;
+			d->syscall = "fwrite";
+			break;
+		}
+		d->written += size;
+		if (!n)
+			break;
+	}
+	if (dst && fclose(dst) != 0 && !d->err) {
+		d->err = errno ? errno : EIO;
+		d->io = true;
+		d->syscall = "fclose";
+	}
+	fclose(src);
+	// Leave no partial (or, for GCM, unauthenticated) output behind.
+	if (d->err && dst)
+		remove(d->destination.c_str());
+	free(in);
+	mbedtls_platform_zeroize(out, NX_CIPHER_FILE_CHUNK + sizeof(c->pending));
+	free(out);
+}
+
+MaybeLocal<Value> nx_cipher_file_cb(Isolate *iso, nx_work_t *req) {
+	nx_cipher_file_async_t *d = (nx_cipher_file_async_t *)req->data;
+	d->cipher->busy = false;
+	d->cipher_val.Reset();
+	if (d->io) {
+		nx_throw_errno_error(iso, d->err, d->syscall);
+		return MaybeLocal<Value>();
+	}
+	if (d->err) {
+		nx_cipher_throw(iso, d->err);
+		return MaybeLocal<Value>();
+	}
+	return Number::New(iso, (double)d->written);
+}
+
+// $.cryptoCipherFile(handle, source, destination) -> Promise<number>: the bytes
+// written. Finishes the cipher.
+void nx_crypto_cipher_file(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	nx_cipher_t *c = nx_get_cipher(iso, info[0]);
+	if (!c)
+		return;
+	String::Utf8Value source(iso, info[1]);
+	String::Utf8Value destination(iso, info[2]);
+	if (!*source || !*destination)
+		return;
+	NX_INIT_WORK_T_CPP(nx_cipher_file_async_t);
+	data->cipher = c;
+	data->cipher_val.Reset(iso, info[0]);
+	data->source = *source;
+	data->destination = *destination;
+	c->busy = true;
+	c->finished = true;
+	info.GetReturnValue().Set(
+	    nx_queue_async(iso, req, nx_cipher_file_do, nx_cipher_file_cb));
+}
+
 // ==================================================================
 // getRandomValues(), sha256Hex(), Crypto.prototype init
 // ==================================================================
@@ -1571,38 +2274,18 @@ void nx_crypto_sign_do(nx_work_t *req) {
 			return;
 		}
 
-		uint8_t der_sig[256];
-		size_t der_sig_len = 0;
-		mbedtls_entropy_context entropy;
-		mbedtls_ctr_drbg_context ctr_drbg;
-		mbedtls_entropy_init(&entropy);
-		mbedtls_ctr_drbg_init(&ctr_drbg);
-		ret = mbedtls_ctr_drbg_seed(&ctr_drbg, mbedtls_entropy_func, &entropy,
-		                            NULL, 0);
-		if (ret != 0) {
-			mbedtls_ctr_drbg_free(&ctr_drbg);
-			mbedtls_entropy_free(&entropy);
-			data->err = ret;
+		mbedtls_ecp_group *grp = nx_crypto_ec_group(ec->keypair.grp.id);
+		mbedtls_ctr_drbg_context *drbg = nx_crypto_drbg();
+		if (!grp) {
+			data->err = MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE;
 			return;
 		}
-#if MBEDTLS_VERSION_MAJOR >= 3
-		ret = mbedtls_ecdsa_write_signature(&ec->keypair, md_type, hash,
-		                                    hash_len, der_sig, sizeof(der_sig),
-		                                    &der_sig_len, mbedtls_ctr_drbg_random,
-		                                    &ctr_drbg);
-#else
-		ret = mbedtls_ecdsa_write_signature(&ec->keypair, md_type, hash,
-		                                    hash_len, der_sig, &der_sig_len,
-		                                    mbedtls_ctr_drbg_random, &ctr_drbg);
-#endif
-		mbedtls_ctr_drbg_free(&ctr_drbg);
-		mbedtls_entropy_free(&entropy);
-		if (ret != 0) {
-			data->err = ret;
+		if (!drbg) {
+			data->err = MBEDTLS_ERR_CTR_DRBG_ENTROPY_SOURCE_FAILED;
 			return;
 		}
 
-		size_t coord_size = mbedtls_mpi_size(&ec->keypair.grp.P);
+		size_t coord_size = mbedtls_mpi_size(&grp->P);
 		data->result_size = coord_size * 2;
 		data->result = calloc(1, data->result_size);
 		if (!data->result) {
@@ -1610,64 +2293,31 @@ void nx_crypto_sign_do(nx_work_t *req) {
 			return;
 		}
 
+		// Signs with the shared group (and its comb table), straight to the
+		// raw `r || s` form WebCrypto returns.
 		mbedtls_mpi r, s;
 		mbedtls_mpi_init(&r);
 		mbedtls_mpi_init(&s);
-		{
-			uint8_t *p = der_sig;
-			size_t len;
-			if (*p != 0x30) {
-				data->err = EINVAL;
-				goto sign_cleanup;
-			}
-			p++;
-			if (*p & 0x80) {
-				p += (*p & 0x7f) + 1;
-			} else {
-				p++;
-			}
-			if (*p != 0x02) {
-				data->err = EINVAL;
-				goto sign_cleanup;
-			}
-			p++;
-			len = *p++;
-			ret = mbedtls_mpi_read_binary(&r, p, len);
-			if (ret != 0) {
-				data->err = ret;
-				goto sign_cleanup;
-			}
-			p += len;
-			if (*p != 0x02) {
-				data->err = EINVAL;
-				goto sign_cleanup;
-			}
-			p++;
-			len = *p++;
-			ret = mbedtls_mpi_read_binary(&s, p, len);
-			if (ret != 0) {
-				data->err = ret;
-				goto sign_cleanup;
-			}
+#if defined(MBEDTLS_ECDSA_DETERMINISTIC)
+		ret = mbedtls_ecdsa_sign_det_ext(grp, &r, &s, &ec->keypair.d, hash,
+		                                 hash_len, md_type,
+		                                 mbedtls_ctr_drbg_random, drbg);
+#else
+		ret = mbedtls_ecdsa_sign(grp, &r, &s, &ec->keypair.d, hash, hash_len,
+		                         mbedtls_ctr_drbg_random, drbg);
+#endif
+		if (ret == 0)
 			ret = mbedtls_mpi_write_binary(&r, (uint8_t *)data->result,
 			                               coord_size);
-			if (ret != 0) {
-				data->err = ret;
-				goto sign_cleanup;
-			}
+		if (ret == 0)
 			ret = mbedtls_mpi_write_binary(
 			    &s, (uint8_t *)data->result + coord_size, coord_size);
-			if (ret != 0) {
-				data->err = ret;
-				goto sign_cleanup;
-			}
-		}
-	sign_cleanup:
 		mbedtls_mpi_free(&r);
 		mbedtls_mpi_free(&s);
-		if (data->err) {
+		if (ret != 0) {
 			free(data->result);
 			data->result = nullptr;
+			data->err = ret;
 		}
 	} else if (data->key->algorithm ==
 	           NX_CRYPTO_KEY_ALGORITHM_RSASSA_PKCS1_V1_5) {
@@ -1694,32 +2344,23 @@ void nx_crypto_sign_do(nx_work_t *req) {
 		data->result_size = rsa_len;
 		mbedtls_rsa_set_padding(&rsa->rsa, MBEDTLS_RSA_PKCS_V15,
 		                        MBEDTLS_MD_NONE);
-		mbedtls_entropy_context sign_entropy;
-		mbedtls_ctr_drbg_context sign_ctr_drbg;
-		mbedtls_entropy_init(&sign_entropy);
-		mbedtls_ctr_drbg_init(&sign_ctr_drbg);
-		ret = mbedtls_ctr_drbg_seed(&sign_ctr_drbg, mbedtls_entropy_func,
-		                            &sign_entropy, NULL, 0);
-		if (ret != 0) {
-			mbedtls_ctr_drbg_free(&sign_ctr_drbg);
-			mbedtls_entropy_free(&sign_entropy);
+		mbedtls_ctr_drbg_context *drbg = nx_crypto_drbg();
+		if (!drbg) {
 			free(data->result);
 			data->result = nullptr;
-			data->err = ret;
+			data->err = MBEDTLS_ERR_CTR_DRBG_ENTROPY_SOURCE_FAILED;
 			return;
 		}
 #if MBEDTLS_VERSION_MAJOR >= 3
 		ret = mbedtls_rsa_rsassa_pkcs1_v15_sign(
-		    &rsa->rsa, mbedtls_ctr_drbg_random, &sign_ctr_drbg, md_type,
+		    &rsa->rsa, mbedtls_ctr_drbg_random, drbg, md_type,
 		    hash_len, hash_buf, (uint8_t *)data->result);
 #else
 		ret = mbedtls_rsa_rsassa_pkcs1_v15_sign(
-		    &rsa->rsa, mbedtls_ctr_drbg_random, &sign_ctr_drbg,
+		    &rsa->rsa, mbedtls_ctr_drbg_random, drbg,
 		    MBEDTLS_RSA_PRIVATE, md_type, hash_len, hash_buf,
 		    (uint8_t *)data->result);
 #endif
-		mbedtls_ctr_drbg_free(&sign_ctr_drbg);
-		mbedtls_entropy_free(&sign_entropy);
 		if (ret != 0) {
 			free(data->result);
 			data->result = nullptr;
@@ -1752,41 +2393,30 @@ void nx_crypto_sign_do(nx_work_t *req) {
 			salt_len = *(int *)data->algorithm_params;
 		if (salt_len < 0)
 			salt_len = (int)hash_len;
-		mbedtls_entropy_context pss_entropy;
-		mbedtls_ctr_drbg_context pss_ctr_drbg;
-		mbedtls_entropy_init(&pss_entropy);
-		mbedtls_ctr_drbg_init(&pss_ctr_drbg);
-		ret = mbedtls_ctr_drbg_seed(&pss_ctr_drbg, mbedtls_entropy_func,
-		                            &pss_entropy, NULL, 0);
-		if (ret != 0) {
-			mbedtls_ctr_drbg_free(&pss_ctr_drbg);
-			mbedtls_entropy_free(&pss_entropy);
+		mbedtls_ctr_drbg_context *drbg = nx_crypto_drbg();
+		if (!drbg) {
 			free(data->result);
 			data->result = nullptr;
-			data->err = ret;
+			data->err = MBEDTLS_ERR_CTR_DRBG_ENTROPY_SOURCE_FAILED;
 			return;
 		}
 		mbedtls_rsa_set_padding(&rsa->rsa, MBEDTLS_RSA_PKCS_V21, md_type);
 #if MBEDTLS_VERSION_MAJOR >= 3
 		ret = mbedtls_rsa_rsassa_pss_sign_ext(
-		    &rsa->rsa, mbedtls_ctr_drbg_random, &pss_ctr_drbg, md_type, hash_len,
+		    &rsa->rsa, mbedtls_ctr_drbg_random, drbg, md_type, hash_len,
 		    hash_buf2, salt_len, (uint8_t *)data->result);
 #else
 		if (salt_len != (int)hash_len) {
-			mbedtls_ctr_drbg_free(&pss_ctr_drbg);
-			mbedtls_entropy_free(&pss_entropy);
 			free(data->result);
 			data->result = nullptr;
 			data->err = ENOTSUP;
 			return;
 		}
 		ret = mbedtls_rsa_rsassa_pss_sign(
-		    &rsa->rsa, mbedtls_ctr_drbg_random, &pss_ctr_drbg,
+		    &rsa->rsa, mbedtls_ctr_drbg_random, drbg,
 		    MBEDTLS_RSA_PRIVATE, md_type, hash_len, hash_buf2,
 		    (uint8_t *)data->result);
 #endif
-		mbedtls_ctr_drbg_free(&pss_ctr_drbg);
-		mbedtls_entropy_free(&pss_entropy);
 		if (ret != 0) {
 			free(data->result);
 			data->result = nullptr;
@@ -1892,125 +2522,130 @@ struct nx_crypto_verify_async_t {
 	bool result = false;
 };
 
-void nx_crypto_verify_do(nx_work_t *req) {
-	nx_crypto_verify_async_t *data = (nx_crypto_verify_async_t *)req->data;
-
-	if (data->key->algorithm == NX_CRYPTO_KEY_ALGORITHM_HMAC) {
-		nx_crypto_key_hmac_t *hmac = (nx_crypto_key_hmac_t *)data->key->handle;
+// Checks `signature` of `data` with the key of `algorithm` whose handle is
+// `handle`, setting `*result`. Returns 0, or an errno value / mbedtls error.
+// Any thread.
+int nx_crypto_verify_raw(nx_crypto_key_algorithm algorithm, void *handle,
+                         void *algorithm_params, const uint8_t *signature,
+                         size_t signature_size, const uint8_t *data,
+                         size_t data_size, bool *result) {
+	if (algorithm == NX_CRYPTO_KEY_ALGORITHM_HMAC) {
+		nx_crypto_key_hmac_t *hmac = (nx_crypto_key_hmac_t *)handle;
 		mbedtls_md_type_t md_type = nx_crypto_get_md_type(hmac->hash_name);
 		if (md_type == MBEDTLS_MD_NONE) {
-			data->err = ENOTSUP;
-			return;
+			return ENOTSUP;
 		}
 		const mbedtls_md_info_t *md_info = mbedtls_md_info_from_type(md_type);
 		size_t mac_size = mbedtls_md_get_size(md_info);
 		uint8_t *computed = (uint8_t *)calloc(1, mac_size);
 		if (!computed) {
-			data->err = ENOMEM;
-			return;
+			return ENOMEM;
 		}
-		int ret = mbedtls_md_hmac(md_info, hmac->key, hmac->key_length,
-		                          data->data, data->data_size, computed);
+		int ret = mbedtls_md_hmac(md_info, hmac->key, hmac->key_length, data,
+		                          data_size, computed);
 		if (ret != 0) {
 			free(computed);
-			data->err = ret;
-			return;
+			return ret;
 		}
-		data->result = (data->signature_size == mac_size &&
-		                memcmp(computed, data->signature, mac_size) == 0);
+		*result = (signature_size == mac_size &&
+		           memcmp(computed, signature, mac_size) == 0);
 		free(computed);
-	} else if (data->key->algorithm == NX_CRYPTO_KEY_ALGORITHM_ECDSA) {
-		nx_crypto_key_ec_t *ec = (nx_crypto_key_ec_t *)data->key->handle;
-		const char *hash_name = (const char *)data->algorithm_params;
+	} else if (algorithm == NX_CRYPTO_KEY_ALGORITHM_ECDSA) {
+		nx_crypto_key_ec_t *ec = (nx_crypto_key_ec_t *)handle;
+		const char *hash_name = (const char *)algorithm_params;
 		mbedtls_md_type_t md_type = nx_crypto_get_md_type(hash_name);
 		if (md_type == MBEDTLS_MD_NONE) {
-			data->err = ENOTSUP;
-			return;
+			return ENOTSUP;
 		}
 		const mbedtls_md_info_t *md_info = mbedtls_md_info_from_type(md_type);
 		size_t hash_len = mbedtls_md_get_size(md_info);
 		uint8_t hash[64];
-		int ret = mbedtls_md(md_info, data->data, data->data_size, hash);
+		int ret = mbedtls_md(md_info, data, data_size, hash);
 		if (ret != 0) {
-			data->err = ret;
-			return;
+			return ret;
 		}
 		size_t coord_size = mbedtls_mpi_size(&ec->keypair.grp.P);
-		if (data->signature_size != coord_size * 2) {
-			data->result = false;
-			return;
+		if (signature_size != coord_size * 2) {
+			*result = false;
+			return 0;
 		}
 		mbedtls_mpi r, s;
 		mbedtls_mpi_init(&r);
 		mbedtls_mpi_init(&s);
-		mbedtls_mpi_read_binary(&r, data->signature, coord_size);
-		mbedtls_mpi_read_binary(&s, data->signature + coord_size, coord_size);
-		ret = mbedtls_ecdsa_verify(&ec->keypair.grp, hash, hash_len,
-		                           &ec->keypair.Q, &r, &s);
-		data->result = (ret == 0);
+		mbedtls_mpi_read_binary(&r, signature, coord_size);
+		mbedtls_mpi_read_binary(&s, signature + coord_size, coord_size);
+		mbedtls_ecp_group *grp = nx_crypto_ec_group(ec->keypair.grp.id);
+		ret = grp ? mbedtls_ecdsa_verify(grp, hash, hash_len, &ec->keypair.Q,
+		                                 &r, &s)
+		          : MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE;
+		*result = (ret == 0);
 		mbedtls_mpi_free(&r);
 		mbedtls_mpi_free(&s);
-	} else if (data->key->algorithm ==
-	           NX_CRYPTO_KEY_ALGORITHM_RSASSA_PKCS1_V1_5) {
-		nx_crypto_key_rsa_t *rsa = (nx_crypto_key_rsa_t *)data->key->handle;
+	} else if (algorithm == NX_CRYPTO_KEY_ALGORITHM_RSASSA_PKCS1_V1_5) {
+		nx_crypto_key_rsa_t *rsa = (nx_crypto_key_rsa_t *)handle;
 		mbedtls_md_type_t md_type = nx_crypto_get_md_type(rsa->hash_name);
 		if (md_type == MBEDTLS_MD_NONE) {
-			data->err = ENOTSUP;
-			return;
+			return ENOTSUP;
 		}
 		const mbedtls_md_info_t *md_info = mbedtls_md_info_from_type(md_type);
 		size_t hash_len = mbedtls_md_get_size(md_info);
 		uint8_t hash_buf[64];
-		int ret = mbedtls_md(md_info, data->data, data->data_size, hash_buf);
+		int ret = mbedtls_md(md_info, data, data_size, hash_buf);
 		if (ret != 0) {
-			data->err = ret;
-			return;
+			return ret;
 		}
 		mbedtls_rsa_set_padding(&rsa->rsa, MBEDTLS_RSA_PKCS_V15,
 		                        MBEDTLS_MD_NONE);
 #if MBEDTLS_VERSION_MAJOR >= 3
 		ret = mbedtls_rsa_rsassa_pkcs1_v15_verify(&rsa->rsa, md_type, hash_len,
-		                                          hash_buf, data->signature);
+		                                          hash_buf, signature);
 #else
 		ret = mbedtls_rsa_rsassa_pkcs1_v15_verify(
 		    &rsa->rsa, NULL, NULL, MBEDTLS_RSA_PUBLIC, md_type, hash_len,
-		    hash_buf, data->signature);
+		    hash_buf, signature);
 #endif
-		data->result = (ret == 0);
-	} else if (data->key->algorithm == NX_CRYPTO_KEY_ALGORITHM_RSA_PSS) {
-		nx_crypto_key_rsa_t *rsa = (nx_crypto_key_rsa_t *)data->key->handle;
+		*result = (ret == 0);
+	} else if (algorithm == NX_CRYPTO_KEY_ALGORITHM_RSA_PSS) {
+		nx_crypto_key_rsa_t *rsa = (nx_crypto_key_rsa_t *)handle;
 		mbedtls_md_type_t md_type = nx_crypto_get_md_type(rsa->hash_name);
 		if (md_type == MBEDTLS_MD_NONE) {
-			data->err = ENOTSUP;
-			return;
+			return ENOTSUP;
 		}
 		const mbedtls_md_info_t *md_info = mbedtls_md_info_from_type(md_type);
 		size_t hash_len = mbedtls_md_get_size(md_info);
 		uint8_t hash_buf2[64];
-		int ret = mbedtls_md(md_info, data->data, data->data_size, hash_buf2);
+		int ret = mbedtls_md(md_info, data, data_size, hash_buf2);
 		if (ret != 0) {
-			data->err = ret;
-			return;
+			return ret;
 		}
 		int salt_len = rsa->salt_length;
-		if (data->algorithm_params)
-			salt_len = *(int *)data->algorithm_params;
+		if (algorithm_params)
+			salt_len = *(int *)algorithm_params;
 		if (salt_len < 0)
 			salt_len = (int)hash_len;
 		mbedtls_rsa_set_padding(&rsa->rsa, MBEDTLS_RSA_PKCS_V21, md_type);
 #if MBEDTLS_VERSION_MAJOR >= 3
 		ret = mbedtls_rsa_rsassa_pss_verify_ext(&rsa->rsa, md_type, hash_len,
 		                                        hash_buf2, md_type, salt_len,
-		                                        data->signature);
+		                                        signature);
 #else
 		ret = mbedtls_rsa_rsassa_pss_verify_ext(
 		    &rsa->rsa, NULL, NULL, MBEDTLS_RSA_PUBLIC, md_type, hash_len,
-		    hash_buf2, md_type, salt_len, data->signature);
+		    hash_buf2, md_type, salt_len, signature);
 #endif
-		data->result = (ret == 0);
+		*result = (ret == 0);
 	} else {
-		data->err = ENOTSUP;
+		return ENOTSUP;
 	}
+	return 0;
+}
+
+void nx_crypto_verify_do(nx_work_t *req) {
+	nx_crypto_verify_async_t *data = (nx_crypto_verify_async_t *)req->data;
+	data->err = nx_crypto_verify_raw(
+	    data->key->algorithm, data->key->handle, data->algorithm_params,
+	    data->signature, data->signature_size, data->data, data->data_size,
+	    &data->result);
 }
 
 MaybeLocal<Value> nx_crypto_verify_cb(Isolate *iso, nx_work_t *req) {
@@ -2071,6 +2706,337 @@ void nx_crypto_verify(const FunctionCallbackInfo<Value> &info) {
 	    nx_queue_async(iso, req, nx_crypto_verify_do, nx_crypto_verify_cb));
 }
 
+// ==================================================================
+// verifyBatch() / digestBatch()
+// ==================================================================
+
+// A batch is queued as one part per thread pool worker (at most one per
+// item). Each part claims the next item until none are left, so a batch of
+// many small items costs a few thread pool operations and a single Promise,
+// rather than one of each per item. The last part to complete settles the
+// batch's Promise with the results of every item.
+struct nx_crypto_batch_t {
+	size_t count = 0;
+	std::atomic<size_t> next{0};
+	std::atomic<int> err{0};
+	size_t parts_left = 0; // loop thread only
+	Global<Promise::Resolver> resolver;
+	Global<Value> inputs; // keys and buffers of every item, kept alive
+
+	// Per item
+	std::vector<nx_crypto_key_t *> keys;
+	std::vector<void *> params; // owned by `key_params`
+	std::vector<uint8_t *> signatures;
+	std::vector<size_t> signature_sizes;
+	std::vector<uint8_t *> data;
+	std::vector<size_t> data_sizes;
+	std::vector<uint8_t> verified; // verifyBatch(): 0 or 1 per item
+	std::vector<uint8_t> digests;  // digestBatch(): digest_size per item
+
+	// verifyBatch(): the parameters of each key algorithm in the batch
+	std::vector<std::pair<nx_crypto_key_algorithm, void *>> key_params;
+	// digestBatch(): NX_CRYPTO_SHA*, or -1 for verifyBatch()
+	int digest_alg = -1;
+	size_t digest_size = 0;
+
+	~nx_crypto_batch_t() {
+		for (auto &p : key_params)
+			free(p.second);
+	}
+};
+
+struct nx_crypto_batch_part_t {
+	std::shared_ptr<nx_crypto_batch_t> batch;
+	// An RSA context is written to by each operation (its padding, and the
+	// Montgomery constant it caches), so each part verifies with its own
+	// copy of the RSA keys in the batch: {key handle, copy}.
+	std::vector<std::pair<void *, nx_crypto_key_rsa_t *>> rsa;
+
+	~nx_crypto_batch_part_t() {
+		for (auto &c : rsa) {
+			mbedtls_rsa_free(&c.second->rsa);
+			free(c.second);
+		}
+	}
+};
+
+// Records the first error of a batch; its remaining items are skipped.
+void nx_crypto_batch_fail(nx_crypto_batch_t *b, int err) {
+	int none = 0;
+	b->err.compare_exchange_strong(none, err);
+}
+
+// Returns the index of the next item of the batch to process, or `count`.
+size_t nx_crypto_batch_next(nx_crypto_batch_t *b) {
+	if (b->err.load(std::memory_order_relaxed))
+		return b->count;
+	return std::min(b->next.fetch_add(1, std::memory_order_relaxed),
+	                b->count);
+}
+
+// Returns this part's copy of RSA key `handle`, or NULL if out of memory.
+nx_crypto_key_rsa_t *nx_crypto_batch_rsa(nx_crypto_batch_part_t *part,
+                                         void *handle) {
+	for (auto &c : part->rsa) {
+		if (c.first == handle)
+			return c.second;
+	}
+	nx_crypto_key_rsa_t *src = (nx_crypto_key_rsa_t *)handle;
+	nx_crypto_key_rsa_t *copy =
+	    (nx_crypto_key_rsa_t *)calloc(1, sizeof(nx_crypto_key_rsa_t));
+	if (!copy)
+		return nullptr;
+#if MBEDTLS_VERSION_MAJOR >= 3
+	mbedtls_rsa_init(&copy->rsa);
+#else
+	mbedtls_rsa_init(&copy->rsa, MBEDTLS_RSA_PKCS_V15, MBEDTLS_MD_NONE);
+#endif
+	if (mbedtls_rsa_copy(&copy->rsa, &src->rsa) != 0) {
+		mbedtls_rsa_free(&copy->rsa);
+		free(copy);
+		return nullptr;
+	}
+	memcpy(copy->hash_name, src->hash_name, sizeof(copy->hash_name));
+	copy->salt_length = src->salt_length;
+	part->rsa.emplace_back(handle, copy);
+	return copy;
+}
+
+void nx_crypto_verify_batch_do(nx_work_t *req) {
+	nx_crypto_batch_part_t *part = (nx_crypto_batch_part_t *)req->data;
+	nx_crypto_batch_t *b = part->batch.get();
+	for (size_t i = nx_crypto_batch_next(b); i < b->count;
+	     i = nx_crypto_batch_next(b)) {
+		nx_crypto_key_t *key = b->keys[i];
+		void *handle = key->handle;
+		if (key->algorithm == NX_CRYPTO_KEY_ALGORITHM_RSASSA_PKCS1_V1_5 ||
+		    key->algorithm == NX_CRYPTO_KEY_ALGORITHM_RSA_PSS) {
+			handle = nx_crypto_batch_rsa(part, handle);
+			if (!handle) {
+				nx_crypto_batch_fail(b, ENOMEM);
+				return;
+			}
+		}
+		bool result = false;
+		int err = nx_crypto_verify_raw(
+		    key->algorithm, handle, b->params[i], b->signatures[i],
+		    b->signature_sizes[i], b->data[i], b->data_sizes[i], &result);
+		if (err) {
+			nx_crypto_batch_fail(b, err);
+			return;
+		}
+		b->verified[i] = result;
+	}
+}
+
+void nx_crypto_digest_batch_do(nx_work_t *req) {
+	nx_crypto_batch_part_t *part = (nx_crypto_batch_part_t *)req->data;
+	nx_crypto_batch_t *b = part->batch.get();
+	for (size_t i = nx_crypto_batch_next(b); i < b->count;
+	     i = nx_crypto_batch_next(b)) {
+		nx_crypto_digest_raw(b->digest_alg, b->data[i], b->data_sizes[i],
+		                     &b->digests[i * b->digest_size]);
+	}
+}
+
+// Settles the batch's Promise once its last part has completed. The part's
+// own Promise is not used, and always resolves.
+MaybeLocal<Value> nx_crypto_batch_cb(Isolate *iso, nx_work_t *req) {
+	nx_crypto_batch_part_t *part = (nx_crypto_batch_part_t *)req->data;
+	nx_crypto_batch_t *b = part->batch.get();
+	if (--b->parts_left > 0)
+		return Undefined(iso).As<Value>();
+
+	Local<Context> context = iso->GetCurrentContext();
+	Local<Promise::Resolver> resolver = b->resolver.Get(iso);
+	b->resolver.Reset();
+	b->inputs.Reset();
+	int err = b->err.load();
+	if (err) {
+		resolver
+		    ->Reject(context, Exception::Error(nx_str(iso, strerror(err))))
+		    .Check();
+		return Undefined(iso).As<Value>();
+	}
+
+	std::vector<Local<Value>> results(b->count);
+	for (size_t i = 0; i < b->count; i++) {
+		if (b->digest_alg == -1) {
+			results[i] = Boolean::New(iso, b->verified[i]);
+			continue;
+		}
+		Local<ArrayBuffer> ab = ArrayBuffer::New(iso, b->digest_size);
+		memcpy(ab->GetBackingStore()->Data(), &b->digests[i * b->digest_size],
+		       b->digest_size);
+		results[i] = ab;
+	}
+	resolver
+	    ->Resolve(context, Array::New(iso, results.data(), results.size()))
+	    .Check();
+	return Undefined(iso).As<Value>();
+}
+
+// Queues batch `b`, whose items are set up, and returns its Promise.
+// `inputs` holds every JS value which the items point into.
+Local<Promise> nx_crypto_batch_queue(Isolate *iso,
+                                     std::shared_ptr<nx_crypto_batch_t> b,
+                                     std::vector<Local<Value>> &inputs,
+                                     nx_work_cb work_cb) {
+	Local<Context> context = iso->GetCurrentContext();
+	Local<Promise::Resolver> resolver =
+	    Promise::Resolver::New(context).ToLocalChecked();
+	if (b->count == 0) {
+		resolver->Resolve(context, Array::New(iso, 0)).Check();
+		return resolver->GetPromise();
+	}
+	b->resolver.Reset(iso, resolver);
+	b->inputs.Reset(iso, Array::New(iso, inputs.data(), inputs.size()));
+
+	size_t workers = nx_ctx(iso)->config.effective_threadpool_size;
+	b->parts_left = std::max<size_t>(1, std::min(workers, b->count));
+	for (size_t i = b->parts_left; i > 0; i--) {
+		NX_INIT_WORK_T_CPP(nx_crypto_batch_part_t);
+		data->batch = b;
+		nx_queue_async(iso, req, work_cb, nx_crypto_batch_cb);
+	}
+	return resolver->GetPromise();
+}
+
+// Gets item `i` of `array` into `*out`. Returns false with an exception
+// pending if it could not be read.
+bool nx_crypto_batch_get(Isolate *iso, Local<Array> array, uint32_t i,
+                         Local<Value> *out) {
+	return array->Get(iso->GetCurrentContext(), i).ToLocal(out);
+}
+
+// cryptoVerifyBatch(algorithm, key | keys, signatures, data)
+// => Promise<boolean[]>
+void nx_crypto_verify_batch(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	if (!info[1]->IsObject() || !info[2]->IsArray() || !info[3]->IsArray()) {
+		nx_throw(iso, "expected key, and Arrays of signatures and data");
+		return;
+	}
+	Local<Array> keys =
+	    info[1]->IsArray() ? info[1].As<Array>() : Local<Array>();
+	Local<Array> signatures = info[2].As<Array>();
+	Local<Array> data = info[3].As<Array>();
+	uint32_t count = data->Length();
+	if (signatures->Length() != count ||
+	    (!keys.IsEmpty() && keys->Length() != count)) {
+		iso->ThrowException(Exception::RangeError(nx_str(
+		    iso, "Expected as many signatures (and keys) as data items")));
+		return;
+	}
+
+	auto b = std::make_shared<nx_crypto_batch_t>();
+	b->count = count;
+	b->keys.resize(count);
+	b->params.resize(count);
+	b->signatures.resize(count);
+	b->signature_sizes.resize(count);
+	b->data.resize(count);
+	b->data_sizes.resize(count);
+	b->verified.resize(count);
+
+	std::vector<Local<Value>> inputs;
+	inputs.reserve(count * 3);
+	for (uint32_t i = 0; i < count; i++) {
+		Local<Value> key_val = info[1];
+		Local<Value> signature_val;
+		Local<Value> data_val;
+		if ((!keys.IsEmpty() && !nx_crypto_batch_get(iso, keys, i, &key_val)) ||
+		    !nx_crypto_batch_get(iso, signatures, i, &signature_val) ||
+		    !nx_crypto_batch_get(iso, data, i, &data_val)) {
+			return;
+		}
+		nx_crypto_key_t *key = nx_get_crypto_key(key_val);
+		if (!key) {
+			nx_throw(iso, "invalid key");
+			return;
+		}
+		if (!(key->usages & NX_CRYPTO_KEY_USAGE_VERIFY)) {
+			nx_throw(iso, "Key does not support the 'verify' operation");
+			return;
+		}
+		b->signatures[i] =
+		    NX_GetBufferSource(iso, &b->signature_sizes[i], signature_val);
+		if (!b->signatures[i]) {
+			nx_throw(iso, "expected signature ArrayBuffer");
+			return;
+		}
+		b->data[i] = NX_GetBufferSource(iso, &b->data_sizes[i], data_val);
+		if (!b->data[i]) {
+			nx_throw(iso, "expected data ArrayBuffer");
+			return;
+		}
+		b->keys[i] = key;
+
+		// The algorithm parameters depend only on the key's algorithm.
+		void *params = nullptr;
+		bool found = false;
+		for (auto &p : b->key_params) {
+			if (p.first == key->algorithm) {
+				params = p.second;
+				found = true;
+				break;
+			}
+		}
+		if (!found) {
+			nx_crypto_extract_sign_params(iso, info[0], key, &params);
+			b->key_params.emplace_back(key->algorithm, params);
+		}
+		b->params[i] = params;
+
+		if (!keys.IsEmpty() || i == 0)
+			inputs.push_back(key_val);
+		inputs.push_back(signature_val);
+		inputs.push_back(data_val);
+	}
+	info.GetReturnValue().Set(
+	    nx_crypto_batch_queue(iso, b, inputs, nx_crypto_verify_batch_do));
+}
+
+// cryptoDigestBatch(algorithm, data) => Promise<ArrayBuffer[]>
+void nx_crypto_digest_batch(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	String::Utf8Value algorithm(iso, info[0]);
+	if (!*algorithm) {
+		nx_throw(iso, "expected string algorithm");
+		return;
+	}
+	if (!info[1]->IsArray()) {
+		nx_throw(iso, "expected Array of data");
+		return;
+	}
+	Local<Array> data = info[1].As<Array>();
+	uint32_t count = data->Length();
+
+	auto b = std::make_shared<nx_crypto_batch_t>();
+	b->digest_alg = nx_crypto_digest_alg(*algorithm, &b->digest_size);
+	if (b->digest_alg == -1) {
+		nx_throw(iso, strerror(ENOTSUP));
+		return;
+	}
+	b->count = count;
+	b->data.resize(count);
+	b->data_sizes.resize(count);
+	b->digests.resize(count * b->digest_size);
+
+	std::vector<Local<Value>> inputs(count);
+	for (uint32_t i = 0; i < count; i++) {
+		if (!nx_crypto_batch_get(iso, data, i, &inputs[i]))
+			return;
+		b->data[i] = NX_GetBufferSource(iso, &b->data_sizes[i], inputs[i]);
+		if (!b->data[i]) {
+			nx_throw(iso, "expected ArrayBuffer");
+			return;
+		}
+	}
+	info.GetReturnValue().Set(
+	    nx_crypto_batch_queue(iso, b, inputs, nx_crypto_digest_batch_do));
+}
+
 // ==================================================================
 // exportKey("raw"), generateKey (EC), importKey (EC private), deriveBits
 // ==================================================================
@@ -2123,31 +3089,20 @@ void nx_crypto_generate_key_ec(const FunctionCallbackInfo<Value> &info) {
 		return;
 	}
 
-	mbedtls_ecp_keypair kp;
-	mbedtls_ecp_keypair_init(&kp);
-	int ret = mbedtls_ecp_group_load(&kp.grp, grp_id);
-	if (ret != 0) {
-		mbedtls_ecp_keypair_free(&kp);
+	mbedtls_ecp_group *grp = nx_crypto_ec_group(grp_id);
+	if (!grp) {
 		nx_throw(iso, "Failed to load EC group");
 		return;
 	}
-	mbedtls_entropy_context entropy;
-	mbedtls_ctr_drbg_context ctr_drbg;
-	mbedtls_entropy_init(&entropy);
-	mbedtls_ctr_drbg_init(&ctr_drbg);
-	ret = mbedtls_ctr_drbg_seed(&ctr_drbg, mbedtls_entropy_func, &entropy, NULL,
-	                            0);
-	if (ret != 0) {
-		mbedtls_ctr_drbg_free(&ctr_drbg);
-		mbedtls_entropy_free(&entropy);
-		mbedtls_ecp_keypair_free(&kp);
+	mbedtls_ctr_drbg_context *drbg = nx_crypto_drbg();
+	if (!drbg) {
 		nx_throw(iso, "Failed to seed DRBG");
 		return;
 	}
-	ret = mbedtls_ecp_gen_keypair(&kp.grp, &kp.d, &kp.Q,
-	                              mbedtls_ctr_drbg_random, &ctr_drbg);
-	mbedtls_ctr_drbg_free(&ctr_drbg);
-	mbedtls_entropy_free(&entropy);
+	mbedtls_ecp_keypair kp;
+	mbedtls_ecp_keypair_init(&kp);
+	int ret = mbedtls_ecp_gen_keypair(grp, &kp.d, &kp.Q,
+	                                  mbedtls_ctr_drbg_random, drbg);
 	if (ret != 0) {
 		mbedtls_ecp_keypair_free(&kp);
 		nx_throw(iso, "Failed to generate EC keypair");
@@ -2155,7 +3110,7 @@ void nx_crypto_generate_key_ec(const FunctionCallbackInfo<Value> &info) {
 	}
 
 	size_t pub_len = 0;
-	size_t coord_size = mbedtls_mpi_size(&kp.grp.P);
+	size_t coord_size = mbedtls_mpi_size(&grp->P);
 	size_t pub_buf_size = 1 + 2 * coord_size;
 	uint8_t *pub_buf = (uint8_t *)malloc(pub_buf_size);
 	if (!pub_buf) {
@@ -2163,7 +3118,7 @@ void nx_crypto_generate_key_ec(const FunctionCallbackInfo<Value> &info) {
 		nx_throw(iso, "out of memory");
 		return;
 	}
-	ret = mbedtls_ecp_point_write_binary(&kp.grp, &kp.Q,
+	ret = mbedtls_ecp_point_write_binary(grp, &kp.Q,
 	                                     MBEDTLS_ECP_PF_UNCOMPRESSED, &pub_len,
 	                                     pub_buf, pub_buf_size);
 	if (ret != 0) {
@@ -2323,27 +3278,21 @@ void nx_crypto_derive_bits_do(nx_work_t *req) {
 		nx_crypto_key_ec_t *pub_ec =
 		    (nx_crypto_key_ec_t *)data->public_key->handle;
 
-		mbedtls_mpi shared;
-		mbedtls_mpi_init(&shared);
-		mbedtls_entropy_context entropy;
-		mbedtls_ctr_drbg_context ctr_drbg;
-		mbedtls_entropy_init(&entropy);
-		mbedtls_ctr_drbg_init(&ctr_drbg);
-		int ret = mbedtls_ctr_drbg_seed(&ctr_drbg, mbedtls_entropy_func,
-		                                &entropy, NULL, 0);
-		if (ret != 0) {
-			mbedtls_ctr_drbg_free(&ctr_drbg);
-			mbedtls_entropy_free(&entropy);
-			mbedtls_mpi_free(&shared);
-			data->err = ret;
+		mbedtls_ecp_group *grp = nx_crypto_ec_group(priv_ec->keypair.grp.id);
+		if (!grp) {
+			data->err = MBEDTLS_ERR_ECP_FEATURE_UNAVAILABLE;
+			return;
+		}
+		mbedtls_ctr_drbg_context *drbg = nx_crypto_drbg();
+		if (!drbg) {
+			data->err = MBEDTLS_ERR_CTR_DRBG_ENTROPY_SOURCE_FAILED;
 			return;
 		}
-		ret = mbedtls_ecdh_compute_shared(&priv_ec->keypair.grp, &shared,
-		                                  &pub_ec->keypair.Q,
-		                                  &priv_ec->keypair.d,
-		                                  mbedtls_ctr_drbg_random, &ctr_drbg);
-		mbedtls_ctr_drbg_free(&ctr_drbg);
-		mbedtls_entropy_free(&entropy);
+		mbedtls_mpi shared;
+		mbedtls_mpi_init(&shared);
+		int ret = mbedtls_ecdh_compute_shared(grp, &shared, &pub_ec->keypair.Q,
+		                                      &priv_ec->keypair.d,
+		                                      mbedtls_ctr_drbg_random, drbg);
 		if (ret != 0) {
 			mbedtls_mpi_free(&shared);
 			data->err = ret;
@@ -2562,23 +3511,15 @@ void nx_crypto_generate_key_rsa_do(nx_work_t *req) {
 	mbedtls_rsa_init(&rsa, MBEDTLS_RSA_PKCS_V21, MBEDTLS_MD_SHA256);
 #endif
 
-	mbedtls_entropy_context entropy;
-	mbedtls_ctr_drbg_context ctr_drbg;
-	mbedtls_entropy_init(&entropy);
-	mbedtls_ctr_drbg_init(&ctr_drbg);
-	int ret = mbedtls_ctr_drbg_seed(&ctr_drbg, mbedtls_entropy_func, &entropy,
-	                                NULL, 0);
-	if (ret != 0) {
-		mbedtls_ctr_drbg_free(&ctr_drbg);
-		mbedtls_entropy_free(&entropy);
+	int ret;
+	mbedtls_ctr_drbg_context *drbg = nx_crypto_drbg();
+	if (!drbg) {
 		mbedtls_rsa_free(&rsa);
-		data->err = ret;
+		data->err = MBEDTLS_ERR_CTR_DRBG_ENTROPY_SOURCE_FAILED;
 		return;
 	}
-	ret = mbedtls_rsa_gen_key(&rsa, mbedtls_ctr_drbg_random, &ctr_drbg,
+	ret = mbedtls_rsa_gen_key(&rsa, mbedtls_ctr_drbg_random, drbg,
 	                          data->modulus_length, data->public_exponent);
-	mbedtls_ctr_drbg_free(&ctr_drbg);
-	mbedtls_entropy_free(&entropy);
 	if (ret != 0) {
 		mbedtls_rsa_free(&rsa);
 		data->err = ret;
@@ -3080,23 +4021,14 @@ void nx_crypto_import_key_pkcs8_spki(const FunctionCallbackInfo<Value> &info) {
 	bool is_pkcs8 = strcmp(*format, "pkcs8") == 0;
 	if (is_pkcs8) {
 #if MBEDTLS_VERSION_MAJOR >= 3
-		mbedtls_entropy_context imp_entropy;
-		mbedtls_ctr_drbg_context imp_ctr_drbg;
-		mbedtls_entropy_init(&imp_entropy);
-		mbedtls_ctr_drbg_init(&imp_ctr_drbg);
-		ret = mbedtls_ctr_drbg_seed(&imp_ctr_drbg, mbedtls_entropy_func,
-		                            &imp_entropy, NULL, 0);
-		if (ret != 0) {
-			mbedtls_ctr_drbg_free(&imp_ctr_drbg);
-			mbedtls_entropy_free(&imp_entropy);
+		mbedtls_ctr_drbg_context *drbg = nx_crypto_drbg();
+		if (!drbg) {
 			mbedtls_pk_free(&pk);
 			nx_throw(iso, "Failed to seed DRBG");
 			return;
 		}
 		ret = mbedtls_pk_parse_key(&pk, der_data, der_size, NULL, 0,
-		                           mbedtls_ctr_drbg_random, &imp_ctr_drbg);
-		mbedtls_ctr_drbg_free(&imp_ctr_drbg);
-		mbedtls_entropy_free(&imp_entropy);
+		                           mbedtls_ctr_drbg_random, drbg);
 #else
 		ret = mbedtls_pk_parse_key(&pk, der_data, der_size, NULL, 0);
 #endif
@@ -3259,10 +4191,12 @@ void nx_init_crypto(Isolate *iso, Local<Object> init_obj) {
 	NX_SET_FUNC(init_obj, "cryptoKeyInit", nx_crypto_key_init);
 	NX_SET_FUNC(init_obj, "cryptoKeyNew", nx_crypto_key_new);
 	NX_SET_FUNC(init_obj, "cryptoDigest", nx_crypto_digest);
+	NX_SET_FUNC(init_obj, "cryptoDigestBatch", nx_crypto_digest_batch);
 	NX_SET_FUNC(init_obj, "cryptoEncrypt", nx_crypto_encrypt);
 	NX_SET_FUNC(init_obj, "cryptoDecrypt", nx_crypto_decrypt);
 	NX_SET_FUNC(init_obj, "cryptoSign", nx_crypto_sign);
 	NX_SET_FUNC(init_obj, "cryptoVerify", nx_crypto_verify);
+	NX_SET_FUNC(init_obj, "cryptoVerifyBatch", nx_crypto_verify_batch);
 	NX_SET_FUNC(init_obj, "cryptoExportKey", nx_crypto_export_key);
 	NX_SET_FUNC(init_obj, "cryptoGenerateKeyEc", nx_crypto_generate_key_ec);
 	NX_SET_FUNC(init_obj, "cryptoKeyNewEcPrivate", nx_crypto_key_new_ec_private);
@@ -3277,5 +4211,9 @@ void nx_init_crypto(Isolate *iso, Local<Object> init_obj) {
 	            nx_crypto_import_key_pkcs8_spki);
 	NX_SET_FUNC(init_obj, "cryptoEcExportPublicRaw",
 	            nx_crypto_ec_export_public_raw);
+	NX_SET_FUNC(init_obj, "cryptoCipherNew", nx_crypto_cipher_new);
+	NX_SET_FUNC(init_obj, "cryptoCipherUpdate", nx_crypto_cipher_update);
+	NX_SET_FUNC(init_obj, "cryptoCipherFinal", nx_crypto_cipher_final);
+	NX_SET_FUNC(init_obj, "cryptoCipherFile", nx_crypto_cipher_file);
 	NX_SET_FUNC(init_obj, "sha256Hex", nx_crypto_sha256_hex);
 }
@@ -1,17 +1,124 @@
 #include "async.h"
 #include "error.h"
 #include "types.h"
+#include <algorithm>
 #include <arpa/inet.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <netdb.h>
+#include <netinet/in.h>
 #include <stdlib.h>
 #include <string.h>
+#include <string>
 #include <sys/socket.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
 
 using namespace v8;
 
 namespace {
 
-// getaddrinfo runs on the libuv threadpool (worker thread).
+// ==================================================================
+// Resolver cache
+// ==================================================================
+
+// Lifetime of a lookup made with the system resolver, which does not report
+// the TTL of the records it found, in seconds.
+#define NX_DNS_DEFAULT_TTL 60
+// Lifetime of a name which does not exist, when the server does not say
+// (RFC 2308), in seconds.
+#define NX_DNS_NEGATIVE_TTL 10
+// Upper bound of any cached lookup's lifetime, in seconds.
+#define NX_DNS_MAX_TTL 3600
+// Number of names cached before expired (then any) entries are evicted.
+#define NX_DNS_CACHE_SIZE 128
+
+// A cached lookup, or one in flight (`pending`), which every concurrent
+// lookup of the same name waits for rather than starting its own.
+struct nx_dns_entry_t {
+	bool pending = true;
+	int err = 0; // EAI_* of a name which does not exist
+	std::vector<std::string> addresses;
+	uint64_t expires = 0; // uv_now()
+	std::vector<Global<Promise::Resolver>> waiters;
+};
+
+// Keyed by lower-case hostname. Loop thread only.
+std::unordered_map<std::string, nx_dns_entry_t> g_dns_cache;
+
+Local<Array> nx_dns_addresses(Isolate *iso,
+                              const std::vector<std::string> &addresses) {
+	Local<Context> context = iso->GetCurrentContext();
+	Local<Array> result = Array::New(iso, addresses.size());
+	for (size_t i = 0; i < addresses.size(); i++) {
+		result->Set(context, (uint32_t)i, nx_str(iso, addresses[i].c_str()))
+		    .Check();
+	}
+	return result;
+}
+
+// Makes room for a new entry, evicting expired entries first.
+void nx_dns_cache_evict(uint64_t now) {
+	if (g_dns_cache.size() < NX_DNS_CACHE_SIZE)
+		return;
+	for (auto it = g_dns_cache.begin(); it != g_dns_cache.end();) {
+		if (!it->second.pending && it->second.expires <= now)
+			it = g_dns_cache.erase(it);
+		else
+			++it;
+	}
+	for (auto it = g_dns_cache.begin();
+	     g_dns_cache.size() >= NX_DNS_CACHE_SIZE && it != g_dns_cache.end();) {
+		if (!it->second.pending)
+			it = g_dns_cache.erase(it);
+		else
+			++it;
+	}
+}
+
+// Settles every lookup waiting for `name` with `addresses` (or with `err`, an
+// EAI_* code), and caches the result for `ttl` seconds (0 for not at all).
+// Must be called with a HandleScope and an entered Context.
+void nx_dns_complete(Isolate *iso, const std::string &name, int err,
+                     std::vector<std::string> addresses, uint32_t ttl) {
+	auto it = g_dns_cache.find(name);
+	if (it == g_dns_cache.end())
+		return;
+	std::vector<Global<Promise::Resolver>> waiters =
+	    std::move(it->second.waiters);
+	if (ttl) {
+		nx_dns_entry_t &entry = it->second;
+		entry.pending = false;
+		entry.err = err;
+		entry.addresses = addresses;
+		ttl = std::min(ttl, (uint32_t)NX_DNS_MAX_TTL);
+		entry.expires = uv_now(nx_ctx(iso)->loop) + (uint64_t)ttl * 1000;
+	} else {
+		g_dns_cache.erase(it);
+	}
+
+	Local<Context> context = iso->GetCurrentContext();
+	for (Global<Promise::Resolver> &waiter : waiters) {
+		Local<Promise::Resolver> resolver = waiter.Get(iso);
+		waiter.Reset();
+		if (err) {
+			resolver
+			    ->Reject(context,
+			             Exception::Error(nx_str(iso, gai_strerror(err))))
+			    .Check();
+		} else {
+			resolver->Resolve(context, nx_dns_addresses(iso, addresses))
+			    .Check();
+		}
+	}
+}
+
+// ==================================================================
+// System resolver (getaddrinfo on the thread pool)
+// ==================================================================
+
 typedef struct {
 	int err;
 	char *hostname; // owned copy (worker thread can't hold a v8 string)
@@ -46,7 +153,7 @@ void nx_dns_resolve_do(nx_work_t *req) {
 	data->entries = (char **)calloc(count, sizeof(char *));
 	if (!data->entries) {
 		// Worker thread: cannot touch V8. Signal OOM via err; the after-work
-		// callback turns a non-zero err into a thrown JS error.
+		// callback turns a non-zero err into a rejected lookup.
 		data->num_entries = 0;
 		data->err = EAI_MEMORY;
 		freeaddrinfo(result);
@@ -66,46 +173,452 @@ void nx_dns_resolve_do(nx_work_t *req) {
 	freeaddrinfo(result);
 }
 
+// The lookup's waiters are settled through its cache entry, so the
+// operation's own Promise (which nothing holds) always resolves.
 MaybeLocal<Value> nx_dns_resolve_cb(Isolate *iso, nx_work_t *req) {
-	Local<Context> context = iso->GetCurrentContext();
 	nx_dns_resolve_t *data = (nx_dns_resolve_t *)req->data;
+	std::string name = data->hostname;
 	free(data->hostname);
 	data->hostname = nullptr;
 
-	if (data->err) {
-		if (data->entries) {
-			for (size_t i = 0; i < data->num_entries; i++)
-				free(data->entries[i]);
-			free(data->entries);
-			data->entries = nullptr;
-		}
-		iso->ThrowException(
-		    Exception::Error(nx_str(iso, gai_strerror(data->err))));
-		return MaybeLocal<Value>();
-	}
-
-	Local<Array> result = Array::New(iso, data->num_entries);
+	std::vector<std::string> addresses;
 	for (size_t i = 0; i < data->num_entries; i++) {
-		result->Set(context, (uint32_t)i, nx_str(iso, data->entries[i]))
-		    .Check();
+		addresses.push_back(data->entries[i]);
 		free(data->entries[i]);
 	}
 	free(data->entries);
 	data->entries = nullptr;
-	return result;
+
+	// Only a name which does not exist is cached as such: other failures
+	// (no network, server failure) are likely to be temporary.
+	uint32_t ttl = NX_DNS_DEFAULT_TTL;
+	if (data->err)
+		ttl = data->err == EAI_NONAME ? NX_DNS_NEGATIVE_TTL : 0;
+	nx_dns_complete(iso, name, data->err, std::move(addresses), ttl);
+	return Undefined(iso).As<Value>();
+}
+
+void nx_dns_resolve_system(Isolate *iso, const std::string &name) {
+	NX_INIT_WORK_T(nx_dns_resolve_t);
+	data->hostname = strdup(name.c_str());
+	nx_queue_async(iso, req, nx_dns_resolve_do, nx_dns_resolve_cb);
+}
+
+// ==================================================================
+// DNS client (UDP, on the event loop)
+// ==================================================================
+
+// Time to wait for a server's answers before trying the next one, in ms.
+#define NX_DNS_TIMEOUT 2000
+#define NX_DNS_MAX_SERVERS 4
+
+#define NX_DNS_TYPE_A 1
+#define NX_DNS_TYPE_CNAME 5
+#define NX_DNS_TYPE_SOA 6
+#define NX_DNS_TYPE_AAAA 28
+#define NX_DNS_CLASS_IN 1
+#define NX_DNS_RCODE_NXDOMAIN 3
+
+// Servers set with setDnsServers(). None: the system resolver is used.
+struct sockaddr_in g_dns_servers[NX_DNS_MAX_SERVERS];
+size_t g_dns_num_servers = 0;
+
+// One lookup: an A and an AAAA query, sent together to one server at a
+// time over a socket of its own (so each lookup has its own random source
+// port, as well as random query IDs).
+struct nx_dns_query_t {
+	uv_poll_t poll;
+	uv_timer_t timer;
+	Isolate *iso;
+	int fd;
+	std::string name;
+	struct sockaddr_in servers[NX_DNS_MAX_SERVERS];
+	size_t num_servers;
+	size_t server; // index of the server being queried
+	// Per query: [0] A, [1] AAAA
+	uint8_t packets[2][512];
+	size_t packet_size;
+	bool answered[2];
+	std::vector<std::string> addresses[2];
+	uint32_t ttl;
+	uint32_t negative_ttl;
+	int handles_open;
+};
+
+uint16_t dns_u16(const uint8_t *p) { return (uint16_t)((p[0] << 8) | p[1]); }
+
+uint32_t dns_u32(const uint8_t *p) {
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+	       ((uint32_t)p[2] << 8) | p[3];
 }
 
+// Encodes a query for `name` into `out` (at least 512 bytes). Returns its
+// size, or 0 if `name` is not a valid domain name.
+size_t dns_encode_query(uint8_t *out, uint16_t id, const std::string &name,
+                        uint16_t type) {
+	if (name.empty())
+		return 0;
+	memset(out, 0, 12);
+	out[0] = id >> 8;
+	out[1] = id & 0xff;
+	out[2] = 0x01; // RD
+	out[5] = 1;    // QDCOUNT
+	size_t off = 12;
+	size_t start = 0;
+	while (start < name.size()) {
+		size_t dot = name.find('.', start);
+		if (dot == std::string::npos)
+			dot = name.size();
+		size_t label = dot - start;
+		if (label == 0 || label > 63 || off + label + 1 > 12 + 255)
+			return 0;
+		out[off++] = (uint8_t)label;
+		memcpy(out + off, name.data() + start, label);
+		off += label;
+		start = dot + 1;
+	}
+	out[off++] = 0;
+	out[off++] = type >> 8;
+	out[off++] = type & 0xff;
+	out[off++] = 0;
+	out[off++] = NX_DNS_CLASS_IN;
+	return off;
+}
+
+// Returns the offset just past the (possibly compressed) name at `off`, or
+// 0 if it is malformed.
+size_t dns_skip_name(const uint8_t *msg, size_t len, size_t off) {
+	while (off < len) {
+		uint8_t n = msg[off];
+		if ((n & 0xc0) == 0xc0)
+			return off + 2 <= len ? off + 2 : 0;
+		if (n & 0xc0)
+			return 0;
+		off += n + 1;
+		if (n == 0)
+			return off <= len ? off : 0;
+	}
+	return 0;
+}
+
+void dns_query_send(nx_dns_query_t *q);
+void dns_query_finish(nx_dns_query_t *q, bool fallback);
+
+// Handles a response. Returns false if it is not one to our queries.
+bool dns_query_response(nx_dns_query_t *q, const uint8_t *msg, size_t len) {
+	if (len < 12)
+		return false;
+	int which = -1;
+	for (int i = 0; i < 2; i++) {
+		if (!q->answered[i] && dns_u16(msg) == dns_u16(q->packets[i]) &&
+		    len >= q->packet_size &&
+		    memcmp(msg + 12, q->packets[i] + 12, q->packet_size - 12) == 0) {
+			which = i;
+		}
+	}
+	if (which == -1 || !(msg[2] & 0x80) || dns_u16(msg + 4) != 1)
+		return false;
+
+	int rcode = msg[3] & 0x0f;
+	if ((msg[2] & 0x02) ||
+	    (rcode != 0 && rcode != NX_DNS_RCODE_NXDOMAIN)) {
+		// Truncated, or the server failed: try the next one.
+		q->server++;
+		dns_query_send(q);
+		return true;
+	}
+	q->answered[which] = true;
+
+	uint16_t ancount = dns_u16(msg + 6);
+	uint16_t nscount = dns_u16(msg + 8);
+	size_t off = q->packet_size;
+	for (uint32_t i = 0; i < (uint32_t)ancount + nscount; i++) {
+		off = dns_skip_name(msg, len, off);
+		if (!off || off + 10 > len)
+			break;
+		uint16_t type = dns_u16(msg + off);
+		uint16_t klass = dns_u16(msg + off + 2);
+		uint32_t ttl = dns_u32(msg + off + 4);
+		uint16_t rdlength = dns_u16(msg + off + 8);
+		const uint8_t *rdata = msg + off + 10;
+		off += 10 + rdlength;
+		if (off > len || klass != NX_DNS_CLASS_IN)
+			break;
+		if (i >= ancount) {
+			// Authority section: the SOA record of a negative answer
+			if (type == NX_DNS_TYPE_SOA && rdlength >= 20) {
+				uint32_t minimum = dns_u32(rdata + rdlength - 4);
+				q->negative_ttl = std::min(ttl, minimum);
+			}
+			continue;
+		}
+		char ip[INET6_ADDRSTRLEN];
+		if (type == NX_DNS_TYPE_A && rdlength == 4) {
+			inet_ntop(AF_INET, rdata, ip, sizeof(ip));
+		} else if (type == NX_DNS_TYPE_AAAA && rdlength == 16) {
+			inet_ntop(AF_INET6, rdata, ip, sizeof(ip));
+		} else if (type != NX_DNS_TYPE_CNAME) {
+			continue;
+		}
+		q->ttl = std::min(q->ttl, ttl);
+		if (type != NX_DNS_TYPE_CNAME)
+			q->addresses[type == NX_DNS_TYPE_AAAA].push_back(ip);
+	}
+	if (q->answered[0] && q->answered[1])
+		dns_query_finish(q, false);
+	return true;
+}
+
+void dns_query_poll_cb(uv_poll_t *handle, int status, int events) {
+	nx_dns_query_t *q = static_cast<nx_dns_query_t *>(handle->data);
+	if (status < 0) {
+		q->server++;
+		dns_query_send(q);
+		return;
+	}
+	uint8_t msg[512];
+	for (;;) {
+		struct sockaddr_in from;
+		socklen_t from_len = sizeof(from);
+		ssize_t n = recvfrom(q->fd, msg, sizeof(msg), 0,
+		                     (struct sockaddr *)&from, &from_len);
+		if (n < 0)
+			return; // EAGAIN, or an ICMP error: left to the timeout
+		const struct sockaddr_in &server = q->servers[q->server];
+		if (from.sin_addr.s_addr != server.sin_addr.s_addr ||
+		    from.sin_port != server.sin_port)
+			continue;
+		if (dns_query_response(q, msg, (size_t)n))
+			return; // `q` may be gone
+	}
+}
+
+void dns_query_timer_cb(uv_timer_t *handle) {
+	nx_dns_query_t *q = static_cast<nx_dns_query_t *>(handle->data);
+	q->server++;
+	dns_query_send(q);
+}
+
+// Sends both queries to server `q->server`, with new IDs, or falls back to
+// the system resolver once every server has been tried.
+void dns_query_send(nx_dns_query_t *q) {
+	if (q->server >= q->num_servers) {
+		dns_query_finish(q, true);
+		return;
+	}
+	uint16_t ids[2];
+	randomGet(ids, sizeof(ids));
+	q->packet_size =
+	    dns_encode_query(q->packets[0], ids[0], q->name, NX_DNS_TYPE_A);
+	dns_encode_query(q->packets[1], ids[1], q->name, NX_DNS_TYPE_AAAA);
+	q->answered[0] = q->answered[1] = false;
+	q->addresses[0].clear();
+	q->addresses[1].clear();
+	q->ttl = NX_DNS_MAX_TTL;
+	q->negative_ttl = NX_DNS_NEGATIVE_TTL;
+	const struct sockaddr_in &server = q->servers[q->server];
+	for (int i = 0; i < 2; i++) {
+		if (sendto(q->fd, q->packets[i], q->packet_size, 0,
+		           (const struct sockaddr *)&server, sizeof(server)) < 0) {
+			q->server++;
+			dns_query_send(q);
+			return;
+		}
+	}
+	uv_timer_start(&q->timer, dns_query_timer_cb, NX_DNS_TIMEOUT, 0);
+}
+
+void dns_query_close_cb(uv_handle_t *handle) {
+	nx_dns_query_t *q = static_cast<nx_dns_query_t *>(handle->data);
+	if (--q->handles_open > 0)
+		return;
+	close(q->fd);
+	delete q;
+}
+
+// Settles the lookup with the answers received, or hands it over to the
+// system resolver (`fallback`), and tears the query down.
+void dns_query_finish(nx_dns_query_t *q, bool fallback) {
+	Isolate *iso = q->iso;
+	HandleScope scope(iso);
+	Context::Scope cs(iso->GetCurrentContext());
+	uv_timer_stop(&q->timer);
+	uv_poll_stop(&q->poll);
+	if (fallback) {
+		nx_dns_resolve_system(iso, q->name);
+	} else {
+		// IPv4 addresses first, as the system resolver returns them on the
+		// Switch, which has no IPv6.
+		std::vector<std::string> addresses = std::move(q->addresses[0]);
+		for (std::string &a : q->addresses[1])
+			addresses.push_back(std::move(a));
+		if (addresses.empty()) {
+			// NXDOMAIN, or NODATA (the name exists, without addresses):
+			// rejected as by the system resolver, and cached as negative.
+			nx_dns_complete(iso, q->name, EAI_NONAME, {}, q->negative_ttl);
+		} else {
+			nx_dns_complete(iso, q->name, 0, std::move(addresses), q->ttl);
+		}
+	}
+	uv_close((uv_handle_t *)&q->timer, dns_query_close_cb);
+	uv_close((uv_handle_t *)&q->poll, dns_query_close_cb);
+}
+
+// Starts looking `name` up with the configured servers. Returns false if it
+// could not be started (the system resolver is used instead).
+bool nx_dns_resolve_udp(Isolate *iso, const std::string &name) {
+	uint8_t packet[512];
+	if (!g_dns_num_servers || !dns_encode_query(packet, 0, name, 0))
+		return false;
+	int fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (fd < 0)
+		return false;
+	int flags = fcntl(fd, F_GETFL, 0);
+	if (flags >= 0)
+		fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+	uv_loop_t *loop = nx_ctx(iso)->loop;
+	nx_dns_query_t *q = new nx_dns_query_t();
+	if (uv_poll_init_socket(loop, &q->poll, fd) != 0) {
+		close(fd);
+		delete q;
+		return false;
+	}
+	uv_timer_init(loop, &q->timer);
+	q->poll.data = q;
+	q->timer.data = q;
+	q->handles_open = 2;
+	q->iso = iso;
+	q->fd = fd;
+	q->name = name;
+	memcpy(q->servers, g_dns_servers, sizeof(g_dns_servers));
+	q->num_servers = g_dns_num_servers;
+	q->server = 0;
+	uv_poll_start(&q->poll, UV_READABLE, dns_query_poll_cb);
+	dns_query_send(q);
+	return true;
+}
+
+// ==================================================================
+// Bindings
+// ==================================================================
+
+// dnsResolve(hostname) => Promise<string[]>
 void nx_dns_resolve(const FunctionCallbackInfo<Value> &info) {
 	Isolate *iso = info.GetIsolate();
-	NX_INIT_WORK_T(nx_dns_resolve_t);
+	Local<Context> context = iso->GetCurrentContext();
+	Local<Promise::Resolver> resolver =
+	    Promise::Resolver::New(context).ToLocalChecked();
+	info.GetReturnValue().Set(resolver->GetPromise());
+
 	String::Utf8Value hostname(iso, info[0]);
-	data->hostname = strdup(*hostname ? *hostname : "");
-	info.GetReturnValue().Set(
-	    nx_queue_async(iso, req, nx_dns_resolve_do, nx_dns_resolve_cb));
+	std::string name = *hostname ? *hostname : "";
+	for (char &c : name)
+		c = (char)tolower((unsigned char)c);
+	if (!name.empty() && name.back() == '.')
+		name.pop_back();
+
+	// An IP address needs no lookup.
+	uint8_t addr[16];
+	if (inet_pton(AF_INET, name.c_str(), addr) == 1 ||
+	    inet_pton(AF_INET6, name.c_str(), addr) == 1) {
+		resolver->Resolve(context, nx_dns_addresses(iso, {name})).Check();
+		return;
+	}
+
+	uint64_t now = uv_now(nx_ctx(iso)->loop);
+	auto it = g_dns_cache.find(name);
+	if (it != g_dns_cache.end() && !it->second.pending &&
+	    it->second.expires <= now) {
+		g_dns_cache.erase(it);
+		it = g_dns_cache.end();
+	}
+	if (it != g_dns_cache.end()) {
+		nx_dns_entry_t &entry = it->second;
+		if (entry.pending) {
+			entry.waiters.emplace_back(iso, resolver);
+		} else if (entry.err) {
+			resolver
+			    ->Reject(context, Exception::Error(
+			                          nx_str(iso, gai_strerror(entry.err))))
+			    .Check();
+		} else {
+			resolver->Resolve(context, nx_dns_addresses(iso, entry.addresses))
+			    .Check();
+		}
+		return;
+	}
+
+	nx_dns_cache_evict(now);
+	g_dns_cache[name].waiters.emplace_back(iso, resolver);
+	// "localhost" is in the hosts file rather than in DNS.
+	if (name == "localhost" || !nx_dns_resolve_udp(iso, name))
+		nx_dns_resolve_system(iso, name);
+}
+
+// dnsSetServers(servers: string[])
+void nx_dns_set_servers(const FunctionCallbackInfo<Value> &info) {
+	Isolate *iso = info.GetIsolate();
+	Local<Context> context = iso->GetCurrentContext();
+	if (!info[0]->IsArray()) {
+		iso->ThrowException(
+		    Exception::TypeError(nx_str(iso, "expected Array of servers")));
+		return;
+	}
+	Local<Array> list = info[0].As<Array>();
+	if (list->Length() > NX_DNS_MAX_SERVERS) {
+		iso->ThrowException(Exception::RangeError(
+		    nx_str(iso, "At most 4 DNS servers may be set")));
+		return;
+	}
+	struct sockaddr_in servers[NX_DNS_MAX_SERVERS];
+	memset(servers, 0, sizeof(servers));
+	for (uint32_t i = 0; i < list->Length(); i++) {
+		Local<Value> v;
+		if (!list->Get(context, i).ToLocal(&v))
+			return;
+		String::Utf8Value server(iso, v);
+		std::string s = *server ? *server : "";
+		int port = 53;
+		size_t colon = s.find(':');
+		if (colon != std::string::npos) {
+			port = atoi(s.c_str() + colon + 1);
+			s.resize(colon);
+		}
+		servers[i].sin_family = AF_INET;
+		servers[i].sin_port = htons(port);
+		if (port <= 0 || port > 65535 ||
+		    inet_pton(AF_INET, s.c_str(), &servers[i].sin_addr) != 1) {
+			iso->ThrowException(Exception::TypeError(
+			    nx_str(iso, "Invalid DNS server address")));
+			return;
+		}
+	}
+	memcpy(g_dns_servers, servers, sizeof(servers));
+	g_dns_num_servers = list->Length();
+
+	// Lookups in flight complete with the servers they started with.
+	for (auto it = g_dns_cache.begin(); it != g_dns_cache.end();) {
+		if (!it->second.pending)
+			it = g_dns_cache.erase(it);
+		else
+			++it;
+	}
+}
+
+// dnsClearCache()
+void nx_dns_clear_cache(const FunctionCallbackInfo<Value> &info) {
+	for (auto it = g_dns_cache.begin(); it != g_dns_cache.end();) {
+		if (!it->second.pending)
+			it = g_dns_cache.erase(it);
+		else
+			++it;
+	}
 }
 
 } // namespace
 
 void nx_init_dns(Isolate *iso, Local<Object> init_obj) {
 	NX_SET_FUNC(init_obj, "dnsResolve", nx_dns_resolve);
+	NX_SET_FUNC(init_obj, "dnsSetServers", nx_dns_set_servers);
+	NX_SET_FUNC(init_obj, "dnsClearCache", nx_dns_clear_cache);
 }
@@ -1,3 +1,4 @@
+#include "archive.h"
 #include "async.h"
 #include "error.h"
 #include "types.h"
@@ -438,6 +439,9 @@ void nx_readdir_sync(const FunctionCallbackInfo<Value> &info) {
 // ===================== readFile (async) =====================
 void read_file_do(nx_work_t *req) {
 	read_file_t *d = (read_file_t *)req->data;
+	if (nx_archive_read_path(d->filename, d->start, d->end, &d->result,
+	                         &d->size, &d->err))
+		return;
 	FILE *file = fopen(d->filename, "rb");
 	if (file == NULL) {
 		d->err = errno;
@@ -534,6 +538,22 @@ void nx_read_file_sync(const FunctionCallbackInfo<Value> &info) {
 	String::Utf8Value filename(iso, info[0]);
 	if (!*filename)
 		return;
+	uint8_t *data;
+	size_t data_size;
+	int err;
+	if (nx_archive_read_path(*filename, start, end, &data, &data_size, &err)) {
+		if (err == ENOENT) {
+			info.GetReturnValue().SetNull();
+		} else if (err) {
+			nx_throw_errno_error(iso, err, "fread");
+		} else {
+			std::unique_ptr<BackingStore> bs = ArrayBuffer::NewBackingStore(
+			    data, data_size, [](void *p, size_t, void *) { free(p); },
+			    nullptr);
+			info.GetReturnValue().Set(ArrayBuffer::New(iso, std::move(bs)));
+		}
+		return;
+	}
 	FILE *file = fopen(*filename, "rb");
 	if (file == NULL) {
 		if (errno == ENOENT) {
@@ -1,4 +1,5 @@
 #include "image.h"
+#include "animated-image.h"
 #include "async.h"
 #include "error.h"
 #include "util.h"
@@ -49,6 +50,8 @@ enum ImageFormat identify_image_format(uint8_t *data, size_t size) {
 		return FORMAT_JPEG;
 	if (size >= 12 && !memcmp(data, "RIFF", 4) && !memcmp(data + 8, "WEBP", 4))
 		return FORMAT_WEBP;
+	if (size >= 6 && (!memcmp(data, "GIF87a", 6) || !memcmp(data, "GIF89a", 6)))
+		return FORMAT_GIF;
 	return FORMAT_UNKNOWN;
 }
 
@@ -139,6 +142,17 @@ void nx_decode_image_do(nx_work_t *req) {
 		data->image->data = decode_webp(data->input, data->input_size,
 		                                (int *)&data->image->width,
 		                                (int *)&data->image->height);
+		// WebPDecode rejects animated WebP; draw its first frame instead.
+		if (data->image->data == NULL)
+			data->image->data = nx_anim_decode_first_frame(
+			    data->input, data->input_size, &data->image->width,
+			    &data->image->height);
+	} else if (data->image->format == FORMAT_GIF) {
+		// Canvas draws the first frame of an animated image (as browsers
+		// do); `Switch.AnimatedImage` plays the whole animation.
+		data->image->data = nx_anim_decode_first_frame(
+		    data->input, data->input_size, &data->image->width,
+		    &data->image->height);
 	} else {
 		data->err_str = "Unsupported image format";
 		return;
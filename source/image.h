@@ -3,7 +3,13 @@
 #include <png.h>
 #include <webp/decode.h>
 
-enum ImageFormat { FORMAT_PNG, FORMAT_JPEG, FORMAT_WEBP, FORMAT_UNKNOWN };
+enum ImageFormat {
+	FORMAT_PNG,
+	FORMAT_JPEG,
+	FORMAT_WEBP,
+	FORMAT_GIF,
+	FORMAT_UNKNOWN
+};
 
 // Decoded image: `data` is premultiplied BGRA (byte order B,G,R,A), width*4
 // stride. canvas.cc wraps `data` in an SkImage at draw time.
@@ -27,6 +33,8 @@ enum ImageFormat { FORMAT_PNG, FORMAT_JPEG, FORMAT_WEBP, FORMAT_UNKNOWN };
 // `nx_get_canvas` validate this magic and return NULL on mismatch.
 #define NX_IMAGE_MAGIC 0x4d49584eu  // 'NXIM'
 
+struct nx_media_frame;
+
 typedef struct {
 	u32 magic; // must be first: NX_IMAGE_MAGIC
 	u32 width;
@@ -35,12 +43,28 @@ typedef struct {
 	bool data_needs_js_free; // (legacy flag; now always malloc/free or tjFree)
 	enum ImageFormat format;
 	void *cached_sk_image; // sk_sp<SkImage>* — lazily built in canvas.cc
+	// When set (a video frame; see media-decoder.h), the pixels come from this
+	// refcounted frame instead of `data`, and canvas.cc wraps them WITHOUT
+	// copying, holding a frame reference for the SkImage's lifetime. Owned by
+	// the image (one reference).
+	struct nx_media_frame *frame;
+	// For a video: the largest device-space size a frame was drawn at since
+	// video.cc last read it, which becomes the decoder's target size (see
+	// nx_media_set_target_size()). Frames may therefore be smaller than
+	// `width` x `height`; canvas.cc maps source rects onto them.
+	u32 drawn_width;
+	u32 drawn_height;
 } nx_image_t;
 
 // Release an image's cached SkImage (if any). Defined in canvas.cc where the
 // Skia type is available; called from image.cc's close_image.
 void nx_image_release_cache(nx_image_t *image);
 
+// Whether video frames should be decoded to YUV planes (converted to RGB on
+// the GPU by canvas.cc) rather than BGRA: true while a canvas is GPU backed
+// in a build with GPU support. Defined in canvas.cc.
+bool nx_canvas_wants_yuv_frames(void);
+
 // Retrieve the native image wrapped by a JS object (or nullptr). Shared with
 // canvas.cc / irs.cc.
 nx_image_t *nx_get_image(v8::Isolate *iso, v8::Local<v8::Value> obj);
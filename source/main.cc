@@ -21,8 +21,10 @@
 #include <zstd.h>
 #include FT_FREETYPE_H
 
+#include "canvas.h"
 #include "error.h"
 #include "hidsys.h"
+#include "media-decoder.h"
 #include "module.h"
 #include "skia_gpu.h"
 #include "types.h"
@@ -48,7 +50,9 @@ static bool g_tight_memory = false;
 	void nx_init_##name(v8::Isolate *, v8::Local<v8::Object>)
 NX_MODULE(account);
 NX_MODULE(album);
+NX_MODULE(animated_image);
 NX_MODULE(applet);
+NX_MODULE(archive);
 NX_MODULE(audio);
 NX_MODULE(battery);
 NX_MODULE(bluetooth);
@@ -169,6 +173,17 @@ static u32 js_fb_width = 0;
 static u32 js_fb_height = 0;
 static int is_running = 1;
 
+// Raster damage present (see nx_present_raster). `js_screen_canvas` is the
+// screen canvas whose damage rects drive the copy; `js_fb_full_present` forces
+// a whole-frame copy into a freshly created framebuffer (its linear staging
+// buffer starts out uninitialized). Idle frames wait on the display's vsync
+// event to keep the loop paced, since no buffer is dequeued for them.
+static struct nx_canvas_s *js_screen_canvas = NULL;
+static bool js_fb_full_present = false;
+static ViDisplay g_vsync_display;
+static Event g_vsync_event;
+static bool g_vsync_ready = false;
+
 // Applet-regime display funding (see main() for the full rationale). The
 // applet memory grant (~380 MiB) leaves little slack once V8 + the runtime
 // are up, yet the raster present needs ~11.2 MiB at framebufferInit time
@@ -222,6 +237,12 @@ void nx_framebuffer_exit() {
 		free(framebuffer);
 		framebuffer = NULL;
 		js_framebuffer = NULL;
+		js_screen_canvas = NULL;
+	}
+	if (g_vsync_ready) {
+		eventClose(&g_vsync_event);
+		viCloseDisplay(&g_vsync_display);
+		g_vsync_ready = false;
 	}
 }
 
@@ -335,16 +356,6 @@ static void nx_emergency_teardown(void) {
 
 void nx_exit_event_loop(void) { is_running = 0; }
 
-// nx_get_canvas is provided by canvas.cc; forward-declare to wire framebuffer.
-struct nx_canvas_s;
-nx_canvas_s *nx_get_canvas(Isolate *iso, Local<Value> obj);
-// Accessors into the opaque canvas struct (defined in canvas.cc).
-uint8_t *nx_canvas_pixels(nx_canvas_s *c);
-u32 nx_canvas_width(nx_canvas_s *c);
-u32 nx_canvas_height(nx_canvas_s *c);
-void nx_canvas_set_gpu_surface(nx_canvas_s *c, sk_sp<SkSurface> surface);
-void nx_canvas_release_gpu_surface(nx_canvas_s *c);
-
 // Memory-regime accessor for webgl.cc (g_tight_memory is static here).
 bool nx_tight_memory(void) { return g_tight_memory; }
 
@@ -604,6 +615,7 @@ static void nx_framebuffer_init(const FunctionCallbackInfo<Value> &info) {
 		nx_canvas_set_gpu_surface(canvas, gpu);
 		screen_is_gpu = true;
 		js_framebuffer = nullptr;
+		js_screen_canvas = nullptr;
 		// Bringing up EGL/Mesa (which claims the NWindow + nvidia driver
 		// resources) can leave HID not delivering input when it runs AFTER the
 		// pads were configured — notably for async entry modules (top-level
@@ -635,6 +647,16 @@ static void nx_framebuffer_init(const FunctionCallbackInfo<Value> &info) {
 		js_framebuffer = nx_canvas_pixels(canvas);
 		js_fb_width = width;
 		js_fb_height = height;
+		js_screen_canvas = canvas;
+		js_fb_full_present = true;
+		// `[renderer] raster_threads`: record the screen's 2D calls and
+		// rasterize them tile-parallel at frame end (nx_present_raster).
+		nx_canvas_set_raster_threads(canvas, (int)ctx->config.raster_threads);
+		if (ctx->config.raster_threads) {
+			fprintf(stderr, "[skia] deferred raster on %u threads\n",
+			        (unsigned)ctx->config.raster_threads);
+			fflush(stderr);
+		}
 		// Release the display parachute (reserved at boot in the applet
 		// regime) so the libnx framebuffer allocations below — ~7.5 MiB
 		// block-linear swapchain + ~3.7 MiB linear staging buffer — are
@@ -659,11 +681,76 @@ static void nx_framebuffer_init(const FunctionCallbackInfo<Value> &info) {
 			framebufferClose(framebuffer);
 			free(framebuffer);
 			framebuffer = NULL;
+		} else if (!g_vsync_ready) {
+			// The display's vsync event paces idle (undamaged) frames, which
+			// skip the framebuffer dequeue that normally blocks on vsync.
+			if (R_SUCCEEDED(viOpenDefaultDisplay(&g_vsync_display))) {
+				if (R_SUCCEEDED(viGetDisplayVsyncEvent(&g_vsync_display,
+				                                       &g_vsync_event)))
+					g_vsync_ready = true;
+				else
+					viCloseDisplay(&g_vsync_display);
+			}
 		}
 	}
 	ctx->rendering_mode = NX_RENDERING_MODE_CANVAS;
 }
 
+// Raster present: copy only the screen canvas's damaged rects into the
+// framebuffer's linear staging buffer. That buffer persists across frames, so
+// undamaged pixels in it are already current; framebufferEnd() then converts
+// it into the dequeued swapchain buffer. A frame with no damage skips the
+// dequeue/convert/queue entirely and just waits for vsync (falling back to a
+// full present if the vsync event is unavailable, so pacing never breaks).
+static void nx_present_raster(void) {
+	// Deferred raster mode: rasterize the frame's recorded draws now (a no-op
+	// in immediate mode). Damage was tracked as they were recorded.
+	nx_canvas_flush_deferred(js_screen_canvas);
+	uint8_t *pixels = nx_canvas_pixels(js_screen_canvas);
+	// The canvas reallocates its pixels on resize; a size that no longer
+	// matches the framebuffer can't be presented.
+	if (!pixels || nx_canvas_width(js_screen_canvas) != js_fb_width ||
+	    nx_canvas_height(js_screen_canvas) != js_fb_height)
+		return;
+	js_framebuffer = pixels;
+	uint32_t rects[NX_CANVAS_MAX_DAMAGE_RECTS * 4];
+	bool full = js_fb_full_present || !g_vsync_ready;
+	int n = nx_canvas_take_damage(js_screen_canvas, rects,
+	                              NX_CANVAS_MAX_DAMAGE_RECTS, full);
+	if (n == 0) {
+		eventWait(&g_vsync_event, UINT64_MAX);
+		return;
+	}
+	u32 stride;
+	u8 *fb = (u8 *)framebufferBegin(framebuffer, &stride);
+	// framebufferBegin() can return NULL when the framebuffer is in a bad
+	// state (e.g. a failed init left it unusable — see nx_framebuffer_init's
+	// out-of-memory fallback, which leaves `framebuffer` NULL). Skip the frame
+	// rather than memcpy() into NULL, and copy everything once it recovers.
+	if (fb == NULL) {
+		js_fb_full_present = true;
+		return;
+	}
+	size_t src_stride = (size_t)js_fb_width * 4;
+	for (int i = 0; i < n; i++) {
+		uint32_t x = rects[i * 4 + 0], y = rects[i * 4 + 1];
+		uint32_t w = rects[i * 4 + 2], h = rects[i * 4 + 3];
+		const uint8_t *src = pixels + y * src_stride + (size_t)x * 4;
+		u8 *dst = fb + (size_t)y * stride + (size_t)x * 4;
+		if (x == 0 && w == js_fb_width && stride == src_stride) {
+			memcpy(dst, src, src_stride * h);
+			continue;
+		}
+		for (uint32_t row = 0; row < h; row++) {
+			memcpy(dst, src, (size_t)w * 4);
+			src += src_stride;
+			dst += stride;
+		}
+	}
+	framebufferEnd(framebuffer);
+	js_fb_full_present = false;
+}
+
 // HID touch/keyboard/vibration — straightforward marshalling.
 static void js_hid_initialize_touch_screen(
     const FunctionCallbackInfo<Value> &info) {
@@ -959,7 +1046,9 @@ static void build_init_object(Isolate *iso, Local<Context> context,
                               const nx_config_t *cfg) {
 	nx_init_account(iso, init_obj);
 	nx_init_album(iso, init_obj);
+	nx_init_animated_image(iso, init_obj);
 	nx_init_applet(iso, init_obj);
+	nx_init_archive(iso, init_obj);
 	nx_init_audio(iso, init_obj);
 	nx_init_battery(iso, init_obj);
 	nx_init_bluetooth(iso, init_obj);
@@ -1126,6 +1215,9 @@ static void build_init_object(Isolate *iso, Local<Context> context,
 		                    : cfg->renderer == NX_RENDER_GPU ? "gpu"
 		                                                     : "auto";
 		cset("renderer", nx_str(iso, rmode));
+		cset("rasterThreads", Integer::NewFromUnsigned(iso, cfg->raster_threads));
+		cset("videoDecodeThreads",
+		     Integer::NewFromUnsigned(iso, cfg->video_decode_threads));
 		cset("v8Flags",
 		     nx_str_lossy(iso, cfg->v8_flags ? cfg->v8_flags : ""));
 
@@ -1475,6 +1567,8 @@ int main(int argc, char *argv[]) {
 	// port extension. Must happen before any uv_queue_work; doing it here
 	// (pre-V8) is the earliest safe spot after the ini parse.
 	nx_config_apply_threadpool(&nx_ctx->config, tight_memory);
+	// `[video] decode_threads`, for every video opened from now on.
+	nx_media_set_decode_threads((int)nx_ctx->config.video_decode_threads);
 	{
 		char buf[16];
 		snprintf(buf, sizeof(buf), "%u",
@@ -1976,19 +2070,8 @@ int main(int argc, char *argv[]) {
 					// (see nx_skia_gpu_present); double buffering no longer
 					// causes flicker.
 					nx_skia_gpu_present();
-				} else if (framebuffer != NULL && js_framebuffer != NULL) {
-					u32 stride;
-					u8 *fb = (u8 *)framebufferBegin(framebuffer, &stride);
-					// framebufferBegin() can return NULL when the framebuffer
-					// is in a bad state (e.g. a failed init left it unusable —
-					// see nx_framebuffer_init's out-of-memory fallback, which
-					// leaves `framebuffer` NULL). Skip the frame rather than
-					// memcpy() into NULL.
-					if (fb != NULL) {
-						memcpy(fb, js_framebuffer,
-						       js_fb_width * js_fb_height * 4);
-						framebufferEnd(framebuffer);
-					}
+				} else if (framebuffer != NULL && js_screen_canvas != NULL) {
+					nx_present_raster();
 				}
 			}
 		}
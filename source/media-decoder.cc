@@ -13,11 +13,13 @@ extern "C" {
 #include <libswscale/swscale.h>
 }
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <math.h>
 #include <mutex>
+#include <new>
 #include <stdio.h>
 #include <string.h>
 #include <sys/stat.h>
@@ -38,14 +40,47 @@ constexpr int RING_SLOTS = 3;
 constexpr double PRESENT_EPSILON = 0.001;
 // Snap the wall clock to the audio clock when they drift further than this.
 constexpr double AV_RESYNC_THRESHOLD = 0.05;
+// How late (media seconds behind the presentation clock) the decode thread
+// may run before it skips the loop filter on non-reference frames, and then
+// before it skips decoding non-reference frames altogether. Frames more than
+// one frame duration late are discarded before conversion, but never more
+// than MAX_LATE_DROPS in a row, so that a slow decoder still shows progress.
+constexpr double LATE_SKIP_FILTER = 0.05;
+constexpr double LATE_SKIP_FRAMES = 0.1;
+constexpr int MAX_LATE_DROPS = 3;
+// BGRA frames are scaled by a multiple of 1/TARGET_SCALE_STEPS (see
+// output_size()).
+constexpr int TARGET_SCALE_STEPS = 16;
+constexpr int DEFAULT_DECODE_THREADS = 2;
+
+std::atomic<int> decode_threads{0}; // nx_media_set_decode_threads()
 
 struct video_slot {
-	uint8_t *bgra = nullptr;
+	nx_media_frame *frame = nullptr; // the ring's reference
 	double pts = 0;
 };
 
+// A video keyframe seen while demuxing (see index_packet()).
+struct keyframe {
+	double t;    // media seconds (not looped)
+	int64_t ts;  // in the video stream's time base
+	int64_t pos; // byte position in the file, or -1
+	// Demuxing ran uninterrupted from this keyframe up to `covered` (media
+	// seconds) without meeting another keyframe, so a seek to anywhere in
+	// [t, covered] can restart decoding here.
+	double covered;
+};
+
 } // namespace
 
+struct nx_media_frame {
+	std::atomic<int> refs{1};
+	int width = 0;
+	int height = 0;
+	uint8_t *bgra = nullptr; // owned; NULL while `yuv` holds the pixels
+	AVFrame *yuv = nullptr;  // a reference to the decoder's output
+};
+
 struct nx_media {
 	// ---- IO (file or memory) ----
 	FILE *file = nullptr;
@@ -65,6 +100,9 @@ struct nx_media {
 	int vstream = -1;
 	int astream = -1;
 	SwsContext *sws = nullptr;
+	// Colour matrix / range `sws` was last set up for (-1 = never).
+	int sws_colorspace = -1;
+	int sws_range = -1;
 	SwrContext *swr = nullptr;
 
 	// ---- metadata ----
@@ -77,6 +115,7 @@ struct nx_media {
 	video_slot slots[RING_SLOTS];
 	std::atomic<uint64_t> vwrite{0};
 	std::atomic<uint64_t> vread{0};
+	std::atomic<bool> yuv_output{false};
 
 	// ---- audio output ----
 	nx_audio_node *audio_node = nullptr;
@@ -97,6 +136,23 @@ struct nx_media {
 	uint64_t presented_frames = 0;
 	uint64_t dropped_frames = 0;
 
+	// ---- decode pacing ----
+	// The clock as of the last nx_media_present() (NaN while paused or
+	// seeking), which the decode thread compares frame PTS against.
+	std::atomic<double> present_clock{NAN};
+	// nx_media_set_target_size() (0 = native size).
+	std::atomic<int> target_w{0};
+	std::atomic<int> target_h{0};
+	// Frames the decode thread discarded as late (counted as dropped).
+	std::atomic<uint64_t> late_dropped{0};
+	int late_drops_in_row = 0; // decode thread only
+
+	// ---- keyframe index (decode thread only) ----
+	std::vector<keyframe> keyframes; // sorted by `t`
+	// The entry of the last keyframe demuxed since the last container seek,
+	// or -1.
+	int run_key = -1;
+
 	// ---- control ----
 	std::mutex ctl_mutex;
 	std::condition_variable ctl_cv;
@@ -193,8 +249,108 @@ bool decode_wait(nx_media *m) {
 	return true;
 }
 
-// Blocks until a ring slot is free, then converts `frame` to BGRA into it.
-// Returns false if interrupted (quit/seek).
+void frame_free(nx_media_frame *f) {
+	free(f->bgra);
+	av_frame_free(&f->yuv);
+	delete f;
+}
+
+bool is_full_range(const AVFrame *frame) {
+	return frame->color_range == AVCOL_RANGE_JPEG ||
+	       frame->format == AV_PIX_FMT_YUVJ420P;
+}
+
+nx_media_yuv_matrix yuv_matrix(const AVFrame *frame) {
+	switch (frame->colorspace) {
+	case AVCOL_SPC_BT709:
+		return NX_MEDIA_YUV_BT709;
+	case AVCOL_SPC_BT2020_NCL:
+	case AVCOL_SPC_BT2020_CL:
+		return NX_MEDIA_YUV_BT2020;
+	default:
+		return NX_MEDIA_YUV_BT601; // also swscale's default when untagged
+	}
+}
+
+// Match the scaler's YUV -> RGB matrix to the frame's tags (swscale assumes
+// limited-range BT.601 otherwise), so that BGRA frames look the same as YUV
+// frames converted by the renderer. Only re-applied when the tags change.
+void sws_match_colorspace(SwsContext *sws, const AVFrame *frame,
+                          int *colorspace, int *range) {
+	int cs = frame->colorspace;
+	int full = is_full_range(frame);
+	if (cs == *colorspace && full == *range)
+		return;
+	*colorspace = cs;
+	*range = full;
+	int sws_cs = SWS_CS_DEFAULT;
+	switch (yuv_matrix(frame)) {
+	case NX_MEDIA_YUV_BT709:
+		sws_cs = SWS_CS_ITU709;
+		break;
+	case NX_MEDIA_YUV_BT2020:
+		sws_cs = SWS_CS_BT2020;
+		break;
+	default:
+		break;
+	}
+	// Fails (harmlessly) for RGB sources.
+	sws_setColorspaceDetails(sws, sws_getCoefficients(sws_cs), full,
+	                         sws_getCoefficients(SWS_CS_DEFAULT), 1, 0,
+	                         1 << 16, 1 << 16);
+}
+
+// Whether `frame` can be handed to the renderer as-is (see
+// nx_media_set_yuv_output()).
+bool yuv_passthrough(nx_media *m, const AVFrame *frame) {
+	if (!m->yuv_output.load(std::memory_order_relaxed) ||
+	    frame->width != m->width || frame->height != m->height)
+		return false;
+	switch (frame->format) {
+	case AV_PIX_FMT_YUV420P:
+	case AV_PIX_FMT_YUVJ420P:
+	case AV_PIX_FMT_NV12:
+		return true;
+	default:
+		return false;
+	}
+}
+
+// The frame of `slot`, if nothing but the ring references it. Otherwise a
+// renderer still holds it (e.g. an SkImage drawn but not yet flushed), so the
+// slot moves on to a new frame and the old one is freed by its last unref.
+// NULL when out of memory.
+nx_media_frame *writable_frame(video_slot *slot) {
+	nx_media_frame *f = slot->frame;
+	if (f && f->refs.load(std::memory_order_acquire) == 1)
+		return f;
+	nx_media_frame_unref(f);
+	slot->frame = new (std::nothrow) nx_media_frame();
+	return slot->frame;
+}
+
+// The size to convert frames to: the native size, reduced to cover the
+// target size (see nx_media_set_target_size()). The scale is rounded up to
+// a sixteenth, so that a video whose drawn size animates does not rebuild
+// the scaler and reallocate the ring's frames on every frame.
+void output_size(nx_media *m, int *width, int *height) {
+	*width = m->width;
+	*height = m->height;
+	int tw = m->target_w.load(std::memory_order_relaxed);
+	int th = m->target_h.load(std::memory_order_relaxed);
+	if (tw <= 0 || th <= 0)
+		return;
+	double s = fmax((double)tw / m->width, (double)th / m->height);
+	s = ceil(s * TARGET_SCALE_STEPS) / TARGET_SCALE_STEPS;
+	if (s >= 1)
+		return;
+	*width = std::max(1, (int)lround(m->width * s));
+	*height = std::max(1, (int)lround(m->height * s));
+}
+
+// Blocks until a ring slot is free, then stores `frame` into it: converted to
+// BGRA, or as a reference to the decoder's planes (no copy at all) in YUV
+// output mode. Returns false if interrupted (quit/seek).
 bool enqueue_video(nx_media *m, AVFrame *frame, double pts) {
 	while (m->vwrite.load(std::memory_order_relaxed) -
 	           m->vread.load(std::memory_order_acquire) >=
@@ -204,19 +360,60 @@ bool enqueue_video(nx_media *m, AVFrame *frame, double pts) {
 	}
 	uint64_t w = m->vwrite.load(std::memory_order_relaxed);
 	video_slot *slot = &m->slots[w % RING_SLOTS];
-
-	m->sws = sws_getCachedContext(m->sws, frame->width, frame->height,
-	                              (AVPixelFormat)frame->format, m->width,
-	                              m->height, AV_PIX_FMT_BGRA, SWS_BILINEAR,
-	                              NULL, NULL, NULL);
-	if (!m->sws) {
-		set_fatal(m, "failed to create scaler", 0);
+	nx_media_frame *f = writable_frame(slot);
+	if (!f) {
+		set_fatal(m, "out of memory", 0);
 		return false;
 	}
-	uint8_t *dst[4] = {slot->bgra, NULL, NULL, NULL};
-	int dst_stride[4] = {m->width * 4, 0, 0, 0};
-	sws_scale(m->sws, frame->data, frame->linesize, 0, frame->height, dst,
-	          dst_stride);
+
+	if (yuv_passthrough(m, frame)) {
+		free(f->bgra);
+		f->bgra = nullptr;
+		f->width = frame->width;
+		f->height = frame->height;
+		if (!f->yuv && !(f->yuv = av_frame_alloc())) {
+			set_fatal(m, "out of memory", 0);
+			return false;
+		}
+		av_frame_unref(f->yuv);
+		int ret = av_frame_ref(f->yuv, frame);
+		if (ret < 0) {
+			set_fatal(m, "failed to reference frame", ret);
+			return false;
+		}
+	} else {
+		int out_w, out_h;
+		output_size(m, &out_w, &out_h);
+		av_frame_free(&f->yuv);
+		if (f->bgra && (f->width != out_w || f->height != out_h)) {
+			free(f->bgra);
+			f->bgra = nullptr;
+		}
+		f->width = out_w;
+		f->height = out_h;
+		if (!f->bgra &&
+		    !(f->bgra = (uint8_t *)malloc((size_t)out_w * out_h * 4))) {
+			set_fatal(m, "out of memory", 0);
+			return false;
+		}
+		// Scales straight to the output size: one pass, whatever the size.
+		SwsContext *sws = sws_getCachedContext(
+		    m->sws, frame->width, frame->height, (AVPixelFormat)frame->format,
+		    out_w, out_h, AV_PIX_FMT_BGRA, SWS_BILINEAR, NULL, NULL, NULL);
+		if (sws != m->sws)
+			m->sws_colorspace = m->sws_range = -1; // a new scaler
+		m->sws = sws;
+		if (!m->sws) {
+			set_fatal(m, "failed to create scaler", 0);
+			return false;
+		}
+		sws_match_colorspace(m->sws, frame, &m->sws_colorspace,
+		                     &m->sws_range);
+		uint8_t *dst[4] = {f->bgra, NULL, NULL, NULL};
+		int dst_stride[4] = {out_w * 4, 0, 0, 0};
+		sws_scale(m->sws, frame->data, frame->linesize, 0, frame->height,
+		          dst, dst_stride);
+	}
 	slot->pts = pts;
 	m->vwrite.store(w + 1, std::memory_order_release);
 	return true;
@@ -271,6 +468,32 @@ bool enqueue_audio(nx_media *m, AVFrame *frame, double pts) {
 	return true;
 }
 
+// Adapts video decoding to how far it runs behind the presentation clock
+// (while playing; see the LATE_* constants). Returns true if the frame at
+// `pts` is too late to be worth converting.
+bool pace_video(nx_media *m, double pts) {
+	// NaN (paused or seeking) compares false: decode everything.
+	double late = m->present_clock.load(std::memory_order_relaxed) - pts;
+	AVDiscard skip_frame = AVDISCARD_DEFAULT;
+	AVDiscard skip_filter = AVDISCARD_DEFAULT;
+	if (late > LATE_SKIP_FRAMES) {
+		skip_frame = AVDISCARD_NONREF;
+		skip_filter = AVDISCARD_ALL;
+	} else if (late > LATE_SKIP_FILTER) {
+		skip_filter = AVDISCARD_NONREF;
+	}
+	// Read by the decoder from the next packet on.
+	m->vctx->skip_frame = skip_frame;
+	m->vctx->skip_loop_filter = skip_filter;
+	if (late > m->vframe_dur && m->late_drops_in_row < MAX_LATE_DROPS) {
+		m->late_drops_in_row++;
+		m->late_dropped.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+	m->late_drops_in_row = 0;
+	return false;
+}
+
 // Receive all pending frames from a codec. `seek_drop_until` (media seconds,
 // or <0) drops frames decoded while converging on a seek target. Returns
 // false if interrupted.
@@ -297,6 +520,10 @@ bool receive_frames(nx_media *m, AVCodecContext *ctx, int stream_index,
 			av_frame_unref(frame);
 			continue;
 		}
+		if (is_video && seek_drop_until < 0 && pace_video(m, pts)) {
+			av_frame_unref(frame);
+			continue;
+		}
 		bool ok = is_video ? enqueue_video(m, frame, pts)
 		                   : enqueue_audio(m, frame, pts);
 		if (is_video && ok && m->seeking.load(std::memory_order_relaxed) &&
@@ -325,6 +552,60 @@ bool drain_decoders(nx_media *m, AVFrame *frame, double seek_drop_until) {
 	return true;
 }
 
+// Records a demuxed video packet in the keyframe index: a keyframe gets an
+// entry (once), and any packet extends the coverage of the last keyframe
+// demuxed before it.
+void index_packet(nx_media *m, const AVPacket *pkt) {
+	int64_t ts = pkt->pts != AV_NOPTS_VALUE ? pkt->pts : pkt->dts;
+	if (ts == AV_NOPTS_VALUE)
+		return;
+	double t = ts * av_q2d(m->fmt->streams[m->vstream]->time_base);
+	if (m->run_key >= 0) {
+		keyframe *prev = &m->keyframes[m->run_key];
+		prev->covered = std::max(prev->covered, t);
+	}
+	if (!(pkt->flags & AV_PKT_FLAG_KEY))
+		return;
+	// Almost always an append, or a keyframe seen on an earlier pass.
+	auto it = std::lower_bound(
+	    m->keyframes.begin(), m->keyframes.end(), t,
+	    [](const keyframe &k, double v) { return k.t < v; });
+	if (it == m->keyframes.end() || it->ts != ts) {
+		int at = (int)(it - m->keyframes.begin());
+		if (m->run_key >= at)
+			m->run_key++;
+		it = m->keyframes.insert(it, keyframe{t, ts, pkt->pos, t});
+	}
+	m->run_key = (int)(it - m->keyframes.begin());
+}
+
+// The indexed keyframe to restart decoding from to reach `t`, or NULL if no
+// keyframe is known to be the last one before `t`.
+const keyframe *index_lookup(nx_media *m, double t) {
+	auto it = std::upper_bound(
+	    m->keyframes.begin(), m->keyframes.end(), t,
+	    [](double v, const keyframe &k) { return v < k.t; });
+	if (it == m->keyframes.begin())
+		return NULL;
+	--it;
+	return t <= it->covered ? &*it : NULL;
+}
+
+// Seeks the container to an indexed keyframe. Without a container index, a
+// timestamp seek has to search the file, so the recorded byte position goes
+// first there.
+bool index_seek(nx_media *m, const keyframe *k) {
+	bool by_pos = k->pos >= 0 &&
+	              !(m->fmt->iformat->flags & AVFMT_NO_BYTE_SEEK) &&
+	              avformat_index_get_entries_count(
+	                  m->fmt->streams[m->vstream]) == 0;
+	if (by_pos &&
+	    av_seek_frame(m->fmt, m->vstream, k->pos, AVSEEK_FLAG_BYTE) >= 0)
+		return true;
+	return av_seek_frame(m->fmt, m->vstream, k->ts, AVSEEK_FLAG_BACKWARD) >=
+	       0;
+}
+
 // Flush codec + demuxer state and seek the container. Caller is the decode
 // thread. `to_seconds` is in the un-looped media domain.
 bool container_seek(nx_media *m, double to_seconds) {
@@ -335,6 +616,13 @@ bool container_seek(nx_media *m, double to_seconds) {
 	if (m->swr) {
 		swr_free(&m->swr); // drop resampler delay state
 	}
+	m->run_key = -1;
+	m->late_drops_in_row = 0;
+	if (m->vstream >= 0) {
+		const keyframe *k = index_lookup(m, to_seconds);
+		if (k && index_seek(m, k))
+			return true;
+	}
 	int64_t ts = (int64_t)(to_seconds * AV_TIME_BASE);
 	int ret = av_seek_frame(m->fmt, -1, ts, AVSEEK_FLAG_BACKWARD);
 	if (ret < 0) {
@@ -419,6 +707,7 @@ void decode_thread_main(nx_media *m) {
 		}
 
 		if (pkt->stream_index == m->vstream && m->vctx) {
+			index_packet(m, pkt);
 			ret = avcodec_send_packet(m->vctx, pkt);
 			if (ret == 0 || ret == AVERROR(EAGAIN)) {
 				if (receive_frames(m, m->vctx, m->vstream, frame,
@@ -477,6 +766,10 @@ double clock_now(nx_media *m) {
 // Public API
 // ---------------------------------------------------------------------------
 
+void nx_media_set_decode_threads(int threads) {
+	decode_threads.store(threads);
+}
+
 nx_media_t *nx_media_open(const char *path, const uint8_t *mem,
                           size_t mem_size, std::shared_ptr<void> keepalive,
                           char *errbuf, size_t errbuf_size) {
@@ -548,9 +841,10 @@ nx_media_t *nx_media_open(const char *path, const uint8_t *mem,
 			snprintf(errbuf, errbuf_size, "failed to set up video decoder");
 			goto fail;
 		}
-		// Two decode threads: leaves the main JS thread + audio render
-		// thread breathing room on the Switch's three usable cores.
-		m->vctx->thread_count = 2;
+		// See nx_media_set_decode_threads().
+		m->vctx->thread_count = decode_threads.load() > 0
+		                            ? decode_threads.load()
+		                            : DEFAULT_DECODE_THREADS;
 		ret = avcodec_open2(m->vctx, vcodec, NULL);
 		if (ret < 0) {
 			av_strerror(ret, errbuf, errbuf_size);
@@ -567,9 +861,8 @@ nx_media_t *nx_media_open(const char *path, const uint8_t *mem,
 			goto fail;
 		}
 		for (int i = 0; i < RING_SLOTS; i++) {
-			m->slots[i].bgra =
-			    (uint8_t *)malloc((size_t)m->width * m->height * 4);
-			if (!m->slots[i].bgra) {
+			m->slots[i].frame = nx_media_frame_create(m->width, m->height);
+			if (!m->slots[i].frame) {
 				snprintf(errbuf, errbuf_size, "out of memory");
 				goto fail;
 			}
@@ -628,6 +921,7 @@ void nx_media_pause(nx_media_t *m) {
 		return;
 	m->clock_base = clock_now(m);
 	m->clock_running = false;
+	m->present_clock.store(NAN, std::memory_order_relaxed);
 	m->playing.store(false);
 	if (m->audio_node)
 		nx_audio_stream_set_playing(m->audio_node, false);
@@ -640,6 +934,7 @@ void nx_media_seek(nx_media_t *m, double seconds) {
 		seconds = m->duration;
 	// Stop presentation/clock reads of the ring first.
 	m->seeking.store(true, std::memory_order_release);
+	m->present_clock.store(NAN, std::memory_order_relaxed);
 	m->clock_base = seconds;
 	m->clock_anchor = std::chrono::steady_clock::now();
 	m->seek_target.store(seconds);
@@ -652,10 +947,21 @@ void nx_media_set_loop(nx_media_t *m, bool loop) {
 	m->ctl_cv.notify_all();
 }
 
-bool nx_media_present(nx_media_t *m, uint8_t **buffer_inout) {
+void nx_media_set_yuv_output(nx_media_t *m, bool yuv) {
+	m->yuv_output.store(yuv, std::memory_order_relaxed);
+}
+
+void nx_media_set_target_size(nx_media_t *m, int width, int height) {
+	m->target_w.store(width, std::memory_order_relaxed);
+	m->target_h.store(height, std::memory_order_relaxed);
+}
+
+bool nx_media_present(nx_media_t *m, nx_media_frame_t **frame_inout) {
 	if (m->seeking.load(std::memory_order_acquire) || m->fatal.load())
 		return false;
 	double t = clock_now(m);
+	m->present_clock.store(m->clock_running ? t : NAN,
+	                       std::memory_order_relaxed);
 	uint64_t r = m->vread.load(std::memory_order_relaxed);
 	uint64_t w = m->vwrite.load(std::memory_order_acquire);
 	int64_t candidate = -1;
@@ -675,9 +981,9 @@ bool nx_media_present(nx_media_t *m, uint8_t **buffer_inout) {
 		return false;
 	m->present_force.store(false, std::memory_order_relaxed);
 	video_slot *slot = &m->slots[candidate % RING_SLOTS];
-	uint8_t *prev = *buffer_inout;
-	*buffer_inout = slot->bgra;
-	slot->bgra = prev;
+	nx_media_frame *prev = *frame_inout;
+	*frame_inout = slot->frame;
+	slot->frame = prev;
 	m->presented_frames++;
 	m->dropped_frames += (uint64_t)candidate - r;
 	m->vread.store((uint64_t)candidate + 1, std::memory_order_release);
@@ -688,7 +994,10 @@ uint64_t nx_media_presented_frames(nx_media_t *m) {
 	return m->presented_frames;
 }
 
-uint64_t nx_media_dropped_frames(nx_media_t *m) { return m->dropped_frames; }
+uint64_t nx_media_dropped_frames(nx_media_t *m) {
+	return m->dropped_frames +
+	       m->late_dropped.load(std::memory_order_relaxed);
+}
 
 double nx_media_current_time(nx_media_t *m) {
 	if (m->seeking.load())
@@ -769,8 +1078,8 @@ int64_t mem_seek_cb(void *opaque, int64_t offset, int whence) {
 
 } // namespace
 
-bool nx_media_decode_audio(const uint8_t *data, size_t size,
-                           float *channels[NX_MEDIA_MAX_CHANNELS],
+bool nx_media_decode_audio(const uint8_t *data, size_t size, bool s16,
+                           void *channels[NX_MEDIA_MAX_CHANNELS],
                            int *num_channels, uint32_t *length,
                            uint32_t *sample_rate, char *errbuf,
                            size_t errbuf_size) {
@@ -785,10 +1094,19 @@ bool nx_media_decode_audio(const uint8_t *data, size_t size,
 	int stream = -1;
 	int ret = 0;
 	int nch = 0;
+	int src_nch = 0;
 	bool ok = false;
-	// Planar accumulation buffers (resized as frames arrive).
-	std::vector<std::vector<float>> acc;
-	std::vector<float> scratch;
+	// Planar output, converted by swr straight into the channel buffers,
+	// which grow geometrically and are trimmed at the end (no second copy of
+	// the decoded file).
+	const size_t sample_size = s16 ? sizeof(int16_t) : sizeof(float);
+	size_t frames = 0, capacity = 0;
+	// Planes past NX_MEDIA_MAX_CHANNELS are converted into (and dropped from)
+	// this scratch buffer.
+	std::vector<uint8_t> discard;
+	std::vector<uint8_t *> planes;
+	for (int c = 0; c < NX_MEDIA_MAX_CHANNELS; c++)
+		channels[c] = nullptr;
 
 	unsigned char *avio_buf = (unsigned char *)av_malloc(65536);
 	if (!avio_buf) {
@@ -865,19 +1183,19 @@ bool nx_media_decode_audio(const uint8_t *data, size_t size,
 				goto done;
 			}
 			if (nch == 0) {
-				nch = frame->ch_layout.nb_channels;
-				if (nch > NX_MEDIA_MAX_CHANNELS)
-					nch = NX_MEDIA_MAX_CHANNELS;
+				src_nch = frame->ch_layout.nb_channels;
+				nch = src_nch > NX_MEDIA_MAX_CHANNELS ? NX_MEDIA_MAX_CHANNELS
+				                                      : src_nch;
 				if (nch <= 0) {
 					snprintf(errbuf, errbuf_size, "no audio channels");
 					goto done;
 				}
 				*sample_rate = (uint32_t)frame->sample_rate;
-				acc.resize((size_t)nch);
-				// Convert to interleaved f32 at the native rate/layout —
-				// deinterleave below (swr output layout = input layout).
+				planes.resize((size_t)src_nch);
+				// Planar f32 / s16 at the native rate and layout.
 				ret = swr_alloc_set_opts2(
-				    &swr, &frame->ch_layout, AV_SAMPLE_FMT_FLT,
+				    &swr, &frame->ch_layout,
+				    s16 ? AV_SAMPLE_FMT_S16P : AV_SAMPLE_FMT_FLTP,
 				    frame->sample_rate, &frame->ch_layout,
 				    (AVSampleFormat)frame->format, frame->sample_rate, 0,
 				    NULL);
@@ -887,51 +1205,60 @@ bool nx_media_decode_audio(const uint8_t *data, size_t size,
 					goto done;
 				}
 			}
-			int src_nch = frame->ch_layout.nb_channels;
-			scratch.resize((size_t)frame->nb_samples * src_nch);
-			uint8_t *out_ptr = (uint8_t *)scratch.data();
-			int got = swr_convert(swr, &out_ptr, frame->nb_samples,
-			                      (const uint8_t **)frame->extended_data,
-			                      frame->nb_samples);
-			if (got > 0) {
+			size_t want = frames + (size_t)frame->nb_samples;
+			if (want > capacity) {
+				size_t grown = capacity + capacity / 2;
+				size_t cap = want > grown ? want : grown;
+				if (cap < 4096)
+					cap = 4096;
 				for (int c = 0; c < nch; c++) {
-					std::vector<float> &dst = acc[(size_t)c];
-					size_t off = dst.size();
-					dst.resize(off + (size_t)got);
-					for (int i = 0; i < got; i++)
-						dst[off + i] = scratch[(size_t)i * src_nch + c];
+					void *p = realloc(channels[c], cap * sample_size);
+					if (!p) {
+						snprintf(errbuf, errbuf_size, "out of memory");
+						goto done;
+					}
+					channels[c] = p;
 				}
+				capacity = cap;
 			}
+			if (src_nch > nch)
+				discard.resize((size_t)frame->nb_samples * sample_size);
+			for (int c = 0; c < src_nch; c++)
+				planes[(size_t)c] =
+				    c < nch ? (uint8_t *)channels[c] + frames * sample_size
+				            : discard.data();
+			int got = swr_convert(swr, planes.data(), frame->nb_samples,
+			                      (const uint8_t **)frame->extended_data,
+			                      frame->nb_samples);
+			if (got > 0)
+				frames += (size_t)got;
 			av_frame_unref(frame);
 		}
 		if (at_eof)
 			break;
 	}
 
-	if (nch == 0 || acc[0].empty()) {
+	if (nch == 0 || frames == 0) {
 		snprintf(errbuf, errbuf_size, "audio file contains no audio data");
 		goto done;
 	}
-	*num_channels = nch;
-	*length = (uint32_t)acc[0].size();
 	for (int c = 0; c < nch; c++) {
-		channels[c] = (float *)malloc((size_t)*length * sizeof(float));
-		if (!channels[c]) {
-			for (int j = 0; j < c; j++) {
-				free(channels[j]);
-				channels[j] = nullptr;
-			}
-			snprintf(errbuf, errbuf_size, "out of memory");
-			goto done;
-		}
-		size_t have = acc[(size_t)c].size();
-		size_t want = (size_t)*length;
-		memcpy(channels[c], acc[(size_t)c].data(),
-		       (have < want ? have : want) * sizeof(float));
+		// Shrinking never fails in practice; keep the larger block if it does.
+		void *p = realloc(channels[c], frames * sample_size);
+		if (p)
+			channels[c] = p;
 	}
+	*num_channels = nch;
+	*length = (uint32_t)frames;
 	ok = true;
 
 done:
+	if (!ok) {
+		for (int c = 0; c < NX_MEDIA_MAX_CHANNELS; c++) {
+			free(channels[c]);
+			channels[c] = nullptr;
+		}
+	}
 	if (pkt)
 		av_packet_free(&pkt);
 	if (frame)
@@ -971,8 +1298,506 @@ void nx_media_destroy(nx_media_t *m) {
 		avio_context_free(&m->avio);
 	}
 	for (int i = 0; i < RING_SLOTS; i++)
-		free(m->slots[i].bgra);
+		nx_media_frame_unref(m->slots[i].frame);
 	if (m->file)
 		fclose(m->file);
 	delete m;
 }
+
+// ---------------------------------------------------------------------------
+// Video frames
+// ---------------------------------------------------------------------------
+
+nx_media_frame_t *nx_media_frame_create(int width, int height) {
+	nx_media_frame *f = new (std::nothrow) nx_media_frame();
+	if (!f)
+		return NULL;
+	size_t size = (size_t)width * height * 4;
+	f->width = width;
+	f->height = height;
+	f->bgra = (uint8_t *)malloc(size);
+	if (!f->bgra) {
+		delete f;
+		return NULL;
+	}
+	memset(f->bgra, 0, size);
+	for (size_t i = 3; i < size; i += 4)
+		f->bgra[i] = 0xff;
+	return f;
+}
+
+nx_media_frame_t *nx_media_frame_ref(nx_media_frame_t *f) {
+	f->refs.fetch_add(1, std::memory_order_relaxed);
+	return f;
+}
+
+void nx_media_frame_unref(nx_media_frame_t *f) {
+	// acq_rel: the decode thread's `refs == 1` check (acquire) must see
+	// every access made through the reference being dropped.
+	if (f && f->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		frame_free(f);
+}
+
+int nx_media_frame_width(const nx_media_frame_t *f) { return f->width; }
+
+int nx_media_frame_height(const nx_media_frame_t *f) { return f->height; }
+
+const uint8_t *nx_media_frame_bgra(const nx_media_frame_t *f) {
+	return f->bgra;
+}
+
+bool nx_media_frame_yuv(const nx_media_frame_t *f, nx_media_yuv_planes *out) {
+	const AVFrame *y = f->yuv;
+	if (!y)
+		return false;
+	out->num_planes = y->format == AV_PIX_FMT_NV12 ? 2 : 3;
+	for (int i = 0; i < 3; i++) {
+		out->data[i] = i < out->num_planes ? y->data[i] : NULL;
+		out->stride[i] = i < out->num_planes ? y->linesize[i] : 0;
+	}
+	out->matrix = yuv_matrix(y);
+	out->full_range = is_full_range(y);
+	return true;
+}
+
+bool nx_media_frame_to_bgra(const nx_media_frame_t *f, uint8_t *dst,
+                            size_t stride) {
+	const AVFrame *y = f->yuv;
+	if (!y) {
+		for (int row = 0; row < f->height; row++)
+			memcpy(dst + row * stride, f->bgra + (size_t)row * f->width * 4,
+			       (size_t)f->width * 4);
+		return true;
+	}
+	// One scaler per calling thread (this is a fallback path: a YUV frame
+	// drawn somewhere the renderer cannot convert it).
+	thread_local SwsContext *sws = nullptr;
+	thread_local int sws_colorspace = -1, sws_range = -1;
+	SwsContext *next = sws_getCachedContext(
+	    sws, y->width, y->height, (AVPixelFormat)y->format, f->width,
+	    f->height, AV_PIX_FMT_BGRA, SWS_BILINEAR, NULL, NULL, NULL);
+	if (!next)
+		return false;
+	if (next != sws)
+		sws_colorspace = sws_range = -1;
+	sws = next;
+	sws_match_colorspace(sws, y, &sws_colorspace, &sws_range);
+	uint8_t *planes[4] = {dst, NULL, NULL, NULL};
+	int strides[4] = {(int)stride, 0, 0, 0};
+	sws_scale(sws, y->data, y->linesize, 0, y->height, planes, strides);
+	return true;
+}
+
+// ---------------------------------------------------------------------------
+// Streamed audio (AudioStreamSourceNode)
+// ---------------------------------------------------------------------------
+
+struct nx_media_stream {
+	mem_reader reader = {};
+	// Owns the memory buffer until destroy.
+	std::shared_ptr<void> mem_hold;
+	nx_audio_node *node = nullptr;
+	double out_rate = 48000;
+
+	// ---- ffmpeg (decode thread only) ----
+	AVIOContext *avio = nullptr;
+	AVFormatContext *fmt = nullptr;
+	AVCodecContext *ctx = nullptr;
+	SwrContext *swr = nullptr;
+	int stream = -1;
+	int out_channels = 0; // 1 (doubled into the stereo ring) or 2
+	std::vector<float> scratch;
+	std::vector<float> stereo;
+
+	// ---- output position (decode thread only) ----
+	// Output frame (at `out_rate`) of the next resampled frame; < 0 anchors
+	// it at the next decoded frame's PTS, after a restart.
+	int64_t out_pos = -1;
+	// Frames before this output frame are dropped (sample-accurate seeks).
+	int64_t trim_until = 0;
+	bool emitted = false; // anything written since the last restart
+	bool at_end = false;
+
+	// ---- control ----
+	std::mutex ctl_mutex;
+	std::condition_variable ctl_cv;
+	std::thread thread;
+	std::atomic<bool> quit{false};
+	// Seeks requested but not yet serviced; each one holds a
+	// nx_audio_stream_begin_seek() on the node.
+	std::atomic<uint32_t> seeks{0};
+	std::atomic<double> seek_target{0};
+	std::atomic<bool> loop{false};
+	std::atomic<double> loop_start{0};
+	std::atomic<double> loop_end{0};
+	std::atomic<double> duration{NAN};
+	std::atomic<bool> failed{false};
+	char error_buf[256] = {};
+};
+
+namespace {
+
+enum stream_result { STREAM_OK, STREAM_INTERRUPTED, STREAM_LOOP_END };
+
+// Ends the stream with a sticky error (decode thread).
+void stream_fail(nx_media_stream *s, const char *what, int averr) {
+	if (!s->failed.load()) {
+		char detail[128] = {};
+		if (averr != 0)
+			av_strerror(averr, detail, sizeof(detail));
+		snprintf(s->error_buf, sizeof(s->error_buf), "%s%s%s", what,
+		         averr ? ": " : "", detail);
+		s->failed.store(true);
+	}
+	s->at_end = true;
+	nx_audio_stream_set_ended(s->node, true);
+}
+
+bool stream_probe(nx_media_stream *s) {
+	const AVCodec *codec = NULL;
+	unsigned char *avio_buf = (unsigned char *)av_malloc(65536);
+	if (!avio_buf) {
+		stream_fail(s, "out of memory", 0);
+		return false;
+	}
+	s->avio = avio_alloc_context(avio_buf, 65536, 0, &s->reader, mem_read_cb,
+	                             NULL, mem_seek_cb);
+	if (!s->avio) {
+		av_free(avio_buf);
+		stream_fail(s, "out of memory", 0);
+		return false;
+	}
+	s->fmt = avformat_alloc_context();
+	if (!s->fmt) {
+		stream_fail(s, "out of memory", 0);
+		return false;
+	}
+	s->fmt->pb = s->avio;
+	int ret = avformat_open_input(&s->fmt, NULL, NULL, NULL);
+	if (ret < 0) {
+		stream_fail(s, "failed to open audio", ret);
+		return false;
+	}
+	ret = avformat_find_stream_info(s->fmt, NULL);
+	if (ret < 0) {
+		stream_fail(s, "failed to open audio", ret);
+		return false;
+	}
+	s->stream =
+	    av_find_best_stream(s->fmt, AVMEDIA_TYPE_AUDIO, -1, -1, &codec, 0);
+	if (s->stream < 0) {
+		stream_fail(s, "no audio stream found", 0);
+		return false;
+	}
+	s->ctx = avcodec_alloc_context3(codec);
+	if (!s->ctx ||
+	    avcodec_parameters_to_context(
+	        s->ctx, s->fmt->streams[s->stream]->codecpar) < 0 ||
+	    avcodec_open2(s->ctx, codec, NULL) < 0) {
+		stream_fail(s, "failed to open audio decoder", 0);
+		return false;
+	}
+	if (s->fmt->duration != AV_NOPTS_VALUE && s->fmt->duration > 0)
+		s->duration.store((double)s->fmt->duration / AV_TIME_BASE);
+	return true;
+}
+
+// Sleep briefly, returning false if the current write should be abandoned
+// (quit or a pending seek).
+bool stream_wait(nx_media_stream *s) {
+	if (s->quit.load() || s->seeks.load())
+		return false;
+	std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	return true;
+}
+
+// The loop range in output frames: [*start, *end), with *end < 0 for the end
+// of the resource. Mirrors AudioBufferSourceNode's loopStart / loopEnd rules.
+void stream_loop_range(nx_media_stream *s, int64_t *start, int64_t *end) {
+	*start = llround(s->loop_start.load() * s->out_rate);
+	*end = s->loop_end.load() > 0 ? llround(s->loop_end.load() * s->out_rate)
+	                              : -1;
+	if (*start < 0)
+		*start = 0;
+	if (*end >= 0 && *end <= *start) {
+		*start = 0;
+		*end = -1;
+	}
+}
+
+// Repositions the demuxer so that output resumes at `seconds`; the frames
+// decoded before it are trimmed (decode thread).
+bool stream_restart(nx_media_stream *s, double seconds) {
+	avcodec_flush_buffers(s->ctx);
+	if (s->swr)
+		swr_free(&s->swr); // drop resampler delay state
+	int64_t ts = (int64_t)(seconds * AV_TIME_BASE);
+	if (s->fmt->start_time != AV_NOPTS_VALUE)
+		ts += s->fmt->start_time;
+	int ret = av_seek_frame(s->fmt, -1, ts, AVSEEK_FLAG_BACKWARD);
+	if (ret < 0) {
+		// Fall back to a byte-position rewind for streams without an index.
+		ret = av_seek_frame(s->fmt, -1, 0,
+		                    AVSEEK_FLAG_BACKWARD | AVSEEK_FLAG_BYTE);
+	}
+	if (ret < 0)
+		return false;
+	s->out_pos = -1;
+	s->trim_until = llround(seconds * s->out_rate);
+	s->emitted = false;
+	s->at_end = false;
+	return true;
+}
+
+// Writes `count` resampled frames (at `out_pos`) into the node, minus those
+// before the trim point or past the loop end; blocks on backpressure.
+stream_result stream_emit(nx_media_stream *s, const float *src,
+                          uint32_t count) {
+	int64_t pos = s->out_pos;
+	int64_t end = pos + count;
+	s->out_pos = end;
+	stream_result result = STREAM_OK;
+	if (s->loop.load()) {
+		int64_t loop_start, loop_end;
+		stream_loop_range(s, &loop_start, &loop_end);
+		if (loop_end >= 0 && end >= loop_end) {
+			end = loop_end;
+			result = STREAM_LOOP_END;
+		}
+	}
+	int64_t first = pos < s->trim_until ? s->trim_until : pos;
+	if (first >= end)
+		return result;
+	src += (first - pos) * s->out_channels;
+	uint32_t frames = (uint32_t)(end - first);
+	if (s->out_channels == 1) {
+		s->stereo.resize((size_t)frames * 2);
+		for (uint32_t i = 0; i < frames; i++)
+			s->stereo[i * 2] = s->stereo[i * 2 + 1] = src[i];
+		src = s->stereo.data();
+	}
+	s->emitted = true;
+	while (frames > 0) {
+		uint32_t wrote = nx_audio_stream_write(s->node, src, frames);
+		src += (size_t)wrote * 2;
+		frames -= wrote;
+		if (frames > 0 && !stream_wait(s))
+			return STREAM_INTERRUPTED;
+	}
+	return result;
+}
+
+// Resamples `frame` (NULL flushes the resampler) and emits it.
+stream_result stream_convert(nx_media_stream *s, AVFrame *frame) {
+	if (!s->swr)
+		return STREAM_OK; // nothing decoded yet
+	int in_rate = frame ? frame->sample_rate : s->ctx->sample_rate;
+	int in_samples = frame ? frame->nb_samples : 0;
+	int64_t max_out =
+	    av_rescale_rnd(swr_get_delay(s->swr, in_rate) + in_samples,
+	                   (int64_t)s->out_rate, in_rate, AV_ROUND_UP);
+	if (max_out <= 0)
+		return STREAM_OK;
+	s->scratch.resize((size_t)max_out * s->out_channels);
+	uint8_t *out_ptr = (uint8_t *)s->scratch.data();
+	int got = swr_convert(
+	    s->swr, &out_ptr, (int)max_out,
+	    frame ? (const uint8_t **)frame->extended_data : NULL, in_samples);
+	if (got <= 0)
+		return STREAM_OK;
+	return stream_emit(s, s->scratch.data(), (uint32_t)got);
+}
+
+// Receives and emits all pending frames.
+stream_result stream_receive(nx_media_stream *s, AVFrame *frame) {
+	while (true) {
+		int ret = avcodec_receive_frame(s->ctx, frame);
+		if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+			return STREAM_OK;
+		if (ret < 0) {
+			stream_fail(s, "decode error", ret);
+			return STREAM_INTERRUPTED;
+		}
+		if (!s->swr) {
+			// Mono stays mono (doubled when emitted) rather than being
+			// upmixed at -3 dB; everything else is downmixed to stereo.
+			AVChannelLayout mono = AV_CHANNEL_LAYOUT_MONO;
+			AVChannelLayout stereo = AV_CHANNEL_LAYOUT_STEREO;
+			s->out_channels = frame->ch_layout.nb_channels == 1 ? 1 : 2;
+			ret = swr_alloc_set_opts2(
+			    &s->swr, s->out_channels == 1 ? &mono : &stereo,
+			    AV_SAMPLE_FMT_FLT, (int)s->out_rate,
+			    &frame->ch_layout, (AVSampleFormat)frame->format,
+			    frame->sample_rate, 0, NULL);
+			if (ret < 0 || swr_init(s->swr) < 0) {
+				av_frame_unref(frame);
+				stream_fail(s, "failed to create resampler", ret);
+				return STREAM_INTERRUPTED;
+			}
+		}
+		if (s->out_pos < 0) {
+			AVStream *st = s->fmt->streams[s->stream];
+			int64_t ts = frame->best_effort_timestamp;
+			if (ts == AV_NOPTS_VALUE)
+				ts = frame->pts;
+			if (ts != AV_NOPTS_VALUE && st->start_time != AV_NOPTS_VALUE)
+				ts -= st->start_time;
+			double at = ts * av_q2d(st->time_base) * s->out_rate;
+			s->out_pos = ts == AV_NOPTS_VALUE ? s->trim_until : llround(at);
+		}
+		stream_result r = stream_convert(s, frame);
+		av_frame_unref(frame);
+		if (r != STREAM_OK)
+			return r;
+	}
+}
+
+// Loops back to the loop start, gaplessly (no flush).
+void stream_wrap(nx_media_stream *s) {
+	if (!s->emitted) {
+		// Nothing in the loop range: end rather than spin.
+		s->at_end = true;
+		nx_audio_stream_set_ended(s->node, true);
+		return;
+	}
+	int64_t loop_start, loop_end;
+	stream_loop_range(s, &loop_start, &loop_end);
+	if (!stream_restart(s, (double)loop_start / s->out_rate))
+		stream_fail(s, "loop seek failed", 0);
+}
+
+void stream_thread_main(nx_media_stream *s) {
+	AVPacket *pkt = av_packet_alloc();
+	AVFrame *frame = av_frame_alloc();
+	if (!pkt || !frame)
+		stream_fail(s, "out of memory", 0);
+	else
+		stream_probe(s);
+
+	while (!s->quit.load()) {
+		uint32_t seeks = s->seeks.exchange(0);
+		if (seeks) {
+			double target = s->seek_target.load();
+			if (!s->failed.load()) {
+				int64_t loop_start, loop_end;
+				stream_loop_range(s, &loop_start, &loop_end);
+				if (s->loop.load() && loop_end >= 0 &&
+				    llround(target * s->out_rate) >= loop_end)
+					target = (double)loop_start / s->out_rate;
+				if (stream_restart(s, target))
+					nx_audio_stream_set_ended(s->node, false);
+				else
+					stream_fail(s, "seek failed", 0);
+			}
+			// The render thread reads nothing until every seek is flushed.
+			for (; seeks > 0; seeks--)
+				nx_audio_stream_end_seek(s->node);
+			continue;
+		}
+		if (s->at_end) {
+			// Parked: wait for a seek or quit.
+			std::unique_lock<std::mutex> lock(s->ctl_mutex);
+			s->ctl_cv.wait_for(lock, std::chrono::milliseconds(100));
+			continue;
+		}
+
+		int ret = av_read_frame(s->fmt, pkt);
+		stream_result r = STREAM_OK;
+		if (ret == AVERROR_EOF) {
+			avcodec_send_packet(s->ctx, NULL);
+			r = stream_receive(s, frame);
+			if (r == STREAM_OK)
+				r = stream_convert(s, NULL);
+			if (r == STREAM_INTERRUPTED)
+				continue;
+			if (r == STREAM_LOOP_END || s->loop.load()) {
+				stream_wrap(s);
+			} else {
+				s->at_end = true;
+				nx_audio_stream_set_ended(s->node, true);
+			}
+			continue;
+		}
+		if (ret < 0) {
+			stream_fail(s, "demux error", ret);
+			continue;
+		}
+		if (pkt->stream_index == s->stream) {
+			ret = avcodec_send_packet(s->ctx, pkt);
+			if (ret == 0 || ret == AVERROR(EAGAIN))
+				r = stream_receive(s, frame);
+		}
+		av_packet_unref(pkt);
+		if (r == STREAM_LOOP_END)
+			stream_wrap(s);
+	}
+
+	av_packet_free(&pkt);
+	av_frame_free(&frame);
+}
+
+} // namespace
+
+nx_media_stream_t *nx_media_stream_open(const uint8_t *mem, size_t mem_size,
+                                        std::shared_ptr<void> keepalive,
+                                        nx_audio_node *node,
+                                        double sample_rate, bool loop,
+                                        double loop_start, double loop_end) {
+	nx_media_stream *s = new nx_media_stream();
+	s->reader = {mem, mem_size, 0};
+	s->mem_hold = std::move(keepalive);
+	s->node = node;
+	s->out_rate = sample_rate;
+	s->loop_start.store(loop_start);
+	s->loop_end.store(loop_end);
+	s->loop.store(loop);
+	s->thread = std::thread(stream_thread_main, s);
+	return s;
+}
+
+void nx_media_stream_seek(nx_media_stream_t *s, double seconds) {
+	if (!(seconds >= 0))
+		seconds = 0;
+	nx_audio_stream_begin_seek(s->node);
+	s->seek_target.store(seconds);
+	s->seeks.fetch_add(1);
+	s->ctl_cv.notify_all();
+}
+
+void nx_media_stream_set_loop(nx_media_stream_t *s, bool loop,
+                              double loop_start, double loop_end) {
+	s->loop_start.store(loop_start);
+	s->loop_end.store(loop_end);
+	s->loop.store(loop);
+	s->ctl_cv.notify_all();
+}
+
+double nx_media_stream_duration(nx_media_stream_t *s) {
+	return s->duration.load();
+}
+
+const char *nx_media_stream_error(nx_media_stream_t *s) {
+	return s->failed.load() ? s->error_buf : NULL;
+}
+
+void nx_media_stream_destroy(nx_media_stream_t *s) {
+	s->quit.store(true);
+	s->ctl_cv.notify_all();
+	if (s->thread.joinable())
+		s->thread.join();
+	// Never leave the render thread waiting on this stream.
+	for (uint32_t n = s->seeks.exchange(0); n > 0; n--)
+		nx_audio_stream_end_seek(s->node);
+	nx_audio_stream_set_ended(s->node, true);
+	if (s->swr)
+		swr_free(&s->swr);
+	if (s->ctx)
+		avcodec_free_context(&s->ctx);
+	if (s->fmt)
+		avformat_close_input(&s->fmt);
+	if (s->avio) {
+		av_freep(&s->avio->buffer);
+		avio_context_free(&s->avio);
+	}
+	delete s;
+}
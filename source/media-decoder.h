@@ -4,19 +4,21 @@
 // Compiled into BOTH the device runtime (switch-ffmpeg 7.x) and the host
 // nxjs-test binary (distro ffmpeg 5.x+) — no V8, no libnx. Each open media
 // owns a dedicated decode thread which demuxes the container, decodes the
-// video stream into a small ring of presentation-ready BGRA frames (PTS
-// stamped), and decodes/resamples the audio stream into an audio-graph
-// stream-source node (see NX_AUDIO_NODE_STREAM_SOURCE in audio-graph.h).
+// video stream into a small ring of presentation-ready frames (BGRA, or YUV
+// for a GPU renderer; PTS stamped), and decodes/resamples the audio stream
+// into an audio-graph stream-source node (see NX_AUDIO_NODE_STREAM_SOURCE in
+// audio-graph.h).
 //
 // Threading contract:
 //   - All functions below are called from the main (JS loop) thread, except
 //     nx_media_open which may run on a libuv worker.
 //   - The decode thread is internal; commands (play/pause/seek/loop/quit)
 //     are delivered via atomics + a condition variable.
-//   - nx_media_present() swaps the newest due frame into the caller's BGRA
-//     buffer (pointer swap, zero copy) based on the media clock. The clock
-//     is slaved to the audio stream node's consumed-frame counter when an
-//     audio track is playing, and to the monotonic wall clock otherwise.
+//   - nx_media_present() swaps the newest due frame (a refcounted
+//     nx_media_frame, see below) with the caller's (pointer swap, zero copy)
+//     based on the media clock. The clock is slaved to the audio stream
+//     node's consumed-frame counter when an audio track is playing, and to
+//     the monotonic wall clock otherwise.
 #include <memory>
 #include <stddef.h>
 #include <stdint.h>
@@ -25,21 +27,72 @@ struct nx_audio_node;
 
 typedef struct nx_media nx_media_t;
 
+// ---- Video frames ----
+// A decoded, presentation-sized video frame. Frames are refcounted so that a
+// renderer can wrap the pixels without copying them (e.g. canvas.cc's
+// SkImage for drawImage) and keep them alive for as long as it needs: the
+// decode thread only ever writes into a frame that nobody else references,
+// so a referenced frame's pixels never change. Ref/unref are thread-safe.
+//
+// A frame holds either premultiplied (opaque) BGRA pixels, width*4 stride,
+// or (see nx_media_set_yuv_output()) the decoder's own 8-bit 4:2:0 planes.
+typedef struct nx_media_frame nx_media_frame_t;
+
+// Colour matrix of a YUV frame.
+enum nx_media_yuv_matrix {
+	NX_MEDIA_YUV_BT601 = 0,
+	NX_MEDIA_YUV_BT709 = 1,
+	NX_MEDIA_YUV_BT2020 = 2,
+};
+
+struct nx_media_yuv_planes {
+	// 3 planes (Y, U, V) or 2 (Y, interleaved UV); chroma is subsampled
+	// 2x2, i.e. (width + 1) / 2 x (height + 1) / 2.
+	int num_planes;
+	const uint8_t *data[3];
+	int stride[3];
+	nx_media_yuv_matrix matrix;
+	bool full_range;
+};
+
+// A new frame (one reference) of opaque black BGRA pixels, or NULL when out
+// of memory.
+nx_media_frame_t *nx_media_frame_create(int width, int height);
+nx_media_frame_t *nx_media_frame_ref(nx_media_frame_t *f);
+void nx_media_frame_unref(nx_media_frame_t *f); // NULL-safe
+int nx_media_frame_width(const nx_media_frame_t *f);
+int nx_media_frame_height(const nx_media_frame_t *f);
+// The BGRA pixels, or NULL for a YUV frame.
+const uint8_t *nx_media_frame_bgra(const nx_media_frame_t *f);
+// Fills `out` and returns true for a YUV frame.
+bool nx_media_frame_yuv(const nx_media_frame_t *f, nx_media_yuv_planes *out);
+// Converts a YUV frame to BGRA into `dst` on the calling thread (for a
+// renderer which cannot sample YUV). Returns false on failure.
+bool nx_media_frame_to_bgra(const nx_media_frame_t *f, uint8_t *dst,
+                            size_t stride);
+
 // Channel cap for whole-file audio decoding (Web Audio allows 32).
 #define NX_MEDIA_MAX_CHANNELS 32
 
 // Decode an entire audio resource (any ffmpeg-supported container/codec)
-// from memory into planar f32 channel buffers at the file's native sample
-// rate. Backs `decodeAudioData()` and the `Audio` element. On success fills
+// from memory into planar channel buffers at the file's native sample rate:
+// f32, or signed 16-bit with `s16` (half the memory). Backs
+// `decodeAudioData()` and the `Audio` element. On success fills
 // `channels[0..num_channels)` with malloc'd buffers (caller frees), `length`
 // (frames) and `sample_rate`, and returns true. Blocking — call on a worker
 // thread. On failure fills `errbuf` and returns false.
-bool nx_media_decode_audio(const uint8_t *data, size_t size,
-                           float *channels[NX_MEDIA_MAX_CHANNELS],
+bool nx_media_decode_audio(const uint8_t *data, size_t size, bool s16,
+                           void *channels[NX_MEDIA_MAX_CHANNELS],
                            int *num_channels, uint32_t *length,
                            uint32_t *sample_rate, char *errbuf,
                            size_t errbuf_size);
 
+// Frame-threaded decode threads per video decoder (0 = the default, 2: this
+// leaves the main JS thread and the audio render thread room on the Switch's
+// three usable cores). Applies to media opened afterwards. Set from
+// nxjs.ini's `[video] decode_threads` at startup.
+void nx_media_set_decode_threads(int threads);
+
 // Open a media resource and probe its streams. Exactly one of `path` or
 // `mem` must be provided; for `mem`, `keepalive` must own the buffer (e.g. a
 // shared_ptr<v8::BackingStore>) — the media holds it until
@@ -64,17 +117,43 @@ bool nx_media_has_video(nx_media_t *m);
 void nx_media_set_audio_node(nx_media_t *m, nx_audio_node *node,
                              double sample_rate);
 
-// Transport controls (non-blocking; the decode thread reacts).
+// Transport controls (non-blocking; the decode thread reacts). Seeks are
+// frame-accurate: decoding restarts at the keyframe before the target, and
+// frames before it are dropped. The decode thread indexes the keyframes it
+// demuxes, so a seek into a stretch that has already played jumps straight
+// to the right keyframe, even in containers without an index of their own.
 void nx_media_play(nx_media_t *m);
 void nx_media_pause(nx_media_t *m);
 void nx_media_seek(nx_media_t *m, double seconds);
 void nx_media_set_loop(nx_media_t *m, bool loop);
 
 // Presentation: if a video frame is due at the current media clock, swap it
-// into `*buffer_inout` (a caller-owned width*height*4 BGRA buffer; the
-// pointer is exchanged with the ring slot's buffer). Returns true if a new
+// into `*frame_inout` (a reference owned by the caller, which may be NULL;
+// the pointer is exchanged with the ring slot's). Returns true if a new
 // frame was presented. Call from the main thread (e.g. once per host frame).
-bool nx_media_present(nx_media_t *m, uint8_t **buffer_inout);
+// The caller may keep extra references to presented frames: the ring
+// replaces a slot's frame instead of overwriting one that is still in use.
+//
+// The clock seen here also paces the decode thread: when it falls behind
+// the clock, it discards late frames before converting them, and then skips
+// the loop filter and non-reference frames, until it catches up.
+bool nx_media_present(nx_media_t *m, nx_media_frame_t **frame_inout);
+
+// Whether the decode thread may hand out the decoder's YUV planes (for a
+// renderer which converts them to RGB itself, e.g. on the GPU) instead of
+// converting each frame to BGRA. Only 8-bit 4:2:0 video (I420 or NV12) is
+// passed through; anything else is still converted. Off by default; takes
+// effect from the next decoded frame.
+void nx_media_set_yuv_output(nx_media_t *m, bool yuv);
+
+// The device-space size the video is drawn at (0 x 0 = unknown: decode at
+// the native size). BGRA frames are scaled to cover it, keeping the aspect
+// ratio, instead of to the native size, which saves the conversion time and
+// memory when a large video is shown small; they are never scaled up. YUV
+// frames stay at the native size (the renderer scales them anyway). Frames
+// carry their own size (nx_media_frame_width/height), which may differ from
+// nx_media_width/height. Takes effect from the next decoded frame.
+void nx_media_set_target_size(nx_media_t *m, int width, int height);
 
 // Current playback position in media seconds (wraps when looping).
 double nx_media_current_time(nx_media_t *m);
@@ -83,7 +162,9 @@ double nx_media_current_time(nx_media_t *m);
 uint32_t nx_media_buffered_frames(nx_media_t *m);
 
 // Presentation quality counters (getVideoPlaybackQuality): frames actually
-// presented, and frames skipped because a newer frame was already due.
+// presented, and frames skipped, either because a newer frame was already due
+// or because the decode thread discarded them as too late to show (see
+// nx_media_present()).
 uint64_t nx_media_presented_frames(nx_media_t *m);
 uint64_t nx_media_dropped_frames(nx_media_t *m);
 
@@ -100,3 +181,43 @@ const char *nx_media_error(nx_media_t *m);
 // Stop the decode thread (joins it) and free everything. The audio node is
 // NOT freed (caller-owned).
 void nx_media_destroy(nx_media_t *m);
+
+// ---- Streamed audio (AudioStreamSourceNode) ----
+// Decodes an audio resource held in memory ahead of playback, on its own
+// thread, into `node` (from nx_audio_stream_source_create() on a graph
+// running at `sample_rate`), as interleaved stereo f32 at that rate. Only the
+// compressed bytes and the node's one-second ring stay resident. `keepalive`
+// must own `mem` until nx_media_stream_destroy(). Never blocks: the resource
+// is probed on the decode thread, and one that fails to open or decode ends
+// the stream (see nx_media_stream_error()). Decoding starts at 0 right away,
+// so that playback from the start needs no seek; the initial loop settings
+// are taken here (as for nx_media_stream_set_loop()) so that they apply from
+// the first decoded frame.
+typedef struct nx_media_stream nx_media_stream_t;
+
+nx_media_stream_t *nx_media_stream_open(const uint8_t *mem, size_t mem_size,
+                                        std::shared_ptr<void> keepalive,
+                                        nx_audio_node *node,
+                                        double sample_rate, bool loop,
+                                        double loop_start, double loop_end);
+
+// Restart decoding at `seconds`, sample-accurately: the node plays nothing
+// buffered before the seek.
+void nx_media_stream_seek(nx_media_stream_t *s, double seconds);
+
+// Loop [loop_start, loop_end) gaplessly, with AudioBufferSourceNode's rules
+// (loop_end <= 0: to the end of the resource; loop_end <= loop_start: the
+// whole resource). Only affects audio that is not decoded yet — up to a
+// second may already be buffered.
+void nx_media_stream_set_loop(nx_media_stream_t *s, bool loop,
+                              double loop_start, double loop_end);
+
+// Duration in seconds: NaN until probed, or if unknown.
+double nx_media_stream_duration(nx_media_stream_t *s);
+
+// Sticky fatal error message, or NULL.
+const char *nx_media_stream_error(nx_media_stream_t *s);
+
+// Stop the decode thread (joins it) and free everything. The node is NOT
+// freed (caller-owned), but is marked ended.
+void nx_media_stream_destroy(nx_media_stream_t *s);
@@ -1,4 +1,5 @@
 #include "module.h"
+#include "archive.h"
 #include "error.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -38,9 +39,20 @@ std::string utf8_to_string(const String::Utf8Value &v) {
 	return *v ? std::string(*v, v.length()) : std::string();
 }
 
-// Read an entire file at `path` (a mounted devoptab URL, e.g. romfs:/x.js, or a
-// host path). Returns a malloc'd NUL-terminated buffer (caller frees) or NULL.
+// Read an entire file at `path` (a mounted devoptab URL, e.g. romfs:/x.js, a
+// file in a mounted Switch.Archive, or a host path). Returns a malloc'd
+// NUL-terminated buffer (caller frees) or NULL.
 char *read_module_file(const char *path, size_t *out_size) {
+	uint8_t *data;
+	size_t size;
+	int err;
+	if (nx_archive_read_path(path, 0, UINT64_MAX, &data, &size, &err)) {
+		if (err)
+			return NULL;
+		if (out_size)
+			*out_size = size;
+		return (char *)data;
+	}
 	FILE *f = fopen(path, "rb");
 	if (!f)
 		return NULL;
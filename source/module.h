@@ -12,7 +12,8 @@ void nx_console_init(nx_context_t *nx_ctx);
 // (packages/runtime/test/src/main.cc) so the two never drift. Specifiers are
 // resolved as URLs (via `ada`) against the importing module's URL and read
 // synchronously with read_file()/fopen, so only mounted devoptab schemes
-// (romfs:, sdmc:, nxjs:, file:) work; bare specifiers are rejected.
+// (romfs:, sdmc:, nxjs:, file:) and mounted archives (Switch.Archive) work;
+// bare specifiers are rejected.
 // ---------------------------------------------------------------------------
 
 // Register the host module callbacks on the isolate:
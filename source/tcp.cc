@@ -321,18 +321,32 @@ void nx_tcp_connect(const FunctionCallbackInfo<Value> &info) {
 		nx_throw(iso, "invalid input");
 		return;
 	}
-	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	// An IPv4 or IPv6 address (the Switch itself has no IPv6, so connecting
+	// to one fails right away, and happy eyeballs moves on to the next).
+	struct sockaddr_storage addr;
+	socklen_t addr_len;
+	memset(&addr, 0, sizeof(addr));
+	struct sockaddr_in *addr4 = (struct sockaddr_in *)&addr;
+	struct sockaddr_in6 *addr6 = (struct sockaddr_in6 *)&addr;
+	if (inet_pton(AF_INET, *ip, &addr4->sin_addr) == 1) {
+		addr4->sin_family = AF_INET;
+		addr4->sin_port = htons(port);
+		addr_len = sizeof(*addr4);
+	} else if (inet_pton(AF_INET6, *ip, &addr6->sin6_addr) == 1) {
+		addr6->sin6_family = AF_INET6;
+		addr6->sin6_port = htons(port);
+		addr_len = sizeof(*addr6);
+	} else {
+		call_now(iso, cb, make_errno(iso, EINVAL), Undefined(iso));
+		return;
+	}
+	int fd = socket(addr.ss_family, SOCK_STREAM, 0);
 	if (fd < 0) {
 		call_now(iso, cb, make_errno(iso, errno), Undefined(iso));
 		return;
 	}
 	set_nonblocking(fd);
-	struct sockaddr_in addr;
-	memset(&addr, 0, sizeof(addr));
-	addr.sin_family = AF_INET;
-	addr.sin_port = htons(port);
-	inet_pton(AF_INET, *ip, &addr.sin_addr);
-	int r = connect(fd, (struct sockaddr *)&addr, sizeof(addr));
+	int r = connect(fd, (struct sockaddr *)&addr, addr_len);
 	if (r == 0) {
 		// Immediate success (rare).
 		call_now(iso, cb, Undefined(iso), Integer::New(iso, fd));
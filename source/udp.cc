@@ -4,6 +4,7 @@
 #include "util.h"
 #include "wrap.h"
 #include <arpa/inet.h>
+#include <deque>
 #include <errno.h>
 #include <fcntl.h>
 #include <netinet/in.h>
@@ -11,6 +12,7 @@
 #include <string.h>
 #include <sys/socket.h>
 #include <unistd.h>
+#include <vector>
 
 using namespace v8;
 
@@ -22,56 +24,185 @@ void set_nonblocking(int fd) {
 		fcntl(fd, F_SETFL, flags | O_NONBLOCK);
 }
 
-// Persistent datagram socket: a uv_poll_t kept readable for the socket's life.
+// Datagrams received per JS callback, at most.
+#define NX_UDP_BATCH 64
+
+// Larger than any UDP payload over IPv4 (65507 bytes), so that a datagram
+// received into the arena is never truncated.
+#define NX_UDP_MAX_DATAGRAM 65536
+
+// Receive arena. Also larger than the socket receive buffer the Switch is
+// configured with (`udpRxBufSize`), so one readiness event drains it.
+#define NX_UDP_ARENA_SIZE (128 * 1024)
+
+// A send() or sendBatch() waiting for the socket to be writable.
+struct dgram_send_t {
+	Global<Function> callback;
+	Global<Value> buffer; // keeps `data` alive
+	uint8_t *data;
+	std::vector<uint32_t> info; // end offset, IPv4 address, port
+	size_t next;                // index of the next datagram to send
+	size_t offset;              // where the next datagram starts in `data`
+	size_t sent;                // bytes sent so far
+};
+
+// Persistent datagram socket: a uv_poll_t kept readable for the socket's life,
+// and also writable while sends are queued.
 struct dgram_t {
 	uv_poll_t poll;
 	Isolate *iso;
 	int fd;
 	Global<Function> callback;
 	bool active;
-	uint8_t recv_buffer[65536];
+
+	// Reused for every batch: the payloads of the datagrams received, one
+	// after the other, and `NX_UDP_BATCH` (end offset, IPv4 address, port)
+	// triples describing them.
+	Global<ArrayBuffer> arena;
+	Global<Uint32Array> info;
+	uint8_t *arena_data;
+	uint32_t *info_data;
+
+	std::deque<dgram_send_t> sends;
 };
 
 dgram_t *get_dgram(Local<Value> v) { return nx::Unwrap<dgram_t>(v); }
 
-void recv_cb(uv_poll_t *handle, int status, int events) {
-	dgram_t *d = static_cast<dgram_t *>(handle->data);
+void dgram_poll_cb(uv_poll_t *handle, int status, int events);
+
+void dgram_call(dgram_t *d, int argc, Local<Value> *args) {
 	Isolate *iso = d->iso;
-	HandleScope scope(iso);
+	if (d->callback.IsEmpty())
+		return;
 	Local<Context> context = iso->GetCurrentContext();
-	Context::Scope cs(context);
+	Local<Function> cb = d->callback.Get(iso);
+	TryCatch try_catch(iso);
+	Local<Value> ret;
+	if (!cb->Call(context, Null(iso), argc, args).ToLocal(&ret)) {
+		nx_emit_error_event(iso, &try_catch);
+	}
+}
 
-	Local<Value> args[4] = {Undefined(iso), Undefined(iso), Undefined(iso),
-	                        Undefined(iso)};
-	if (status < 0) {
-		args[0] = Exception::Error(nx_str(iso, uv_strerror(status)));
-	} else {
+// Drains the socket into the arena, and hands the whole batch to JS in one
+// call. The Switch's socket API has no recvmmsg(), so this is a recvfrom()
+// per datagram, but a single readiness event and JS call per batch.
+void dgram_recv(dgram_t *d) {
+	Isolate *iso = d->iso;
+	size_t used = 0;
+	uint32_t count = 0;
+	int err = 0;
+	while (count < NX_UDP_BATCH &&
+	       NX_UDP_ARENA_SIZE - used >= NX_UDP_MAX_DATAGRAM) {
 		struct sockaddr_in remote;
 		socklen_t rlen = sizeof(remote);
-		ssize_t n = recvfrom(d->fd, d->recv_buffer, sizeof(d->recv_buffer), 0,
+		ssize_t n = recvfrom(d->fd, d->arena_data + used,
+		                     NX_UDP_ARENA_SIZE - used, 0,
 		                     (struct sockaddr *)&remote, &rlen);
 		if (n < 0) {
-			if (errno == EAGAIN || errno == EWOULDBLOCK)
-				return;
-			args[0] = Exception::Error(nx_str(iso, strerror(errno)));
-		} else {
-			Local<ArrayBuffer> ab = ArrayBuffer::New(iso, (size_t)n);
-			memcpy(ab->Data(), d->recv_buffer, n);
-			args[1] = ab;
-			char ip[INET_ADDRSTRLEN];
-			inet_ntop(AF_INET, &remote.sin_addr, ip, sizeof(ip));
-			args[2] = nx_str(iso, ip);
-			args[3] = Integer::New(iso, ntohs(remote.sin_port));
+			if (errno != EAGAIN && errno != EWOULDBLOCK)
+				err = errno;
+			break;
 		}
+		used += n;
+		uint32_t *info = d->info_data + count * 3;
+		info[0] = (uint32_t)used;
+		info[1] = ntohl(remote.sin_addr.s_addr);
+		info[2] = ntohs(remote.sin_port);
+		count++;
 	}
-	Local<Function> cb = d->callback.Get(iso);
+	if (count > 0) {
+		Local<Value> args[] = {Undefined(iso), d->arena.Get(iso),
+		                       d->info.Get(iso), Integer::New(iso, count)};
+		dgram_call(d, 4, args);
+	}
+	if (err && d->active) {
+		Local<Value> args[] = {Exception::Error(nx_str(iso, strerror(err)))};
+		dgram_call(d, 1, args);
+	}
+}
+
+void dgram_send_finish(Isolate *iso, dgram_send_t &op, Local<Value> err,
+                       Local<Value> value) {
+	Local<Context> context = iso->GetCurrentContext();
+	Local<Function> cb = op.callback.Get(iso);
+	Local<Value> args[] = {err, value};
 	TryCatch try_catch(iso);
 	Local<Value> ret;
-	if (!cb->Call(context, Null(iso), 4, args).ToLocal(&ret)) {
+	if (!cb->Call(context, Null(iso), 2, args).ToLocal(&ret)) {
 		nx_emit_error_event(iso, &try_catch);
 	}
 }
 
+// Fails every queued send with `err`.
+void dgram_fail_sends(dgram_t *d, Local<Value> err) {
+	while (!d->sends.empty()) {
+		dgram_send_t op = std::move(d->sends.front());
+		d->sends.pop_front();
+		dgram_send_finish(d->iso, op, err, Undefined(d->iso));
+	}
+}
+
+// Sends as much of the queue as the socket takes. All the datagrams queued
+// since the last writable event go out together; there is no sendmmsg() on
+// the Switch, so each is a sendto(). Stops watching for writability once the
+// queue is empty.
+void dgram_flush(dgram_t *d) {
+	Isolate *iso = d->iso;
+	while (d->active && !d->sends.empty()) {
+		dgram_send_t &op = d->sends.front();
+		int err = 0;
+		for (; op.next * 3 < op.info.size(); op.next++) {
+			const uint32_t *info = op.info.data() + op.next * 3;
+			struct sockaddr_in dest;
+			memset(&dest, 0, sizeof(dest));
+			dest.sin_family = AF_INET;
+			dest.sin_addr.s_addr = htonl(info[1]);
+			dest.sin_port = htons(info[2]);
+			ssize_t n = sendto(d->fd, op.data + op.offset, info[0] - op.offset,
+			                   0, (struct sockaddr *)&dest, sizeof(dest));
+			if (n < 0) {
+				if (errno == EAGAIN || errno == EWOULDBLOCK)
+					return; // the rest once writable again
+				err = errno;
+				break;
+			}
+			op.sent += n;
+			op.offset = info[0];
+		}
+		// Off the queue before calling into JS, which may send or close.
+		dgram_send_t done = std::move(op);
+		d->sends.pop_front();
+		if (err) {
+			dgram_send_finish(iso, done,
+			                  Exception::Error(nx_str(iso, strerror(err))),
+			                  Undefined(iso));
+		} else {
+			dgram_send_finish(iso, done, Undefined(iso),
+			                  Number::New(iso, (double)done.sent));
+		}
+	}
+	if (d->active)
+		uv_poll_start(&d->poll, UV_READABLE, dgram_poll_cb);
+}
+
+void dgram_poll_cb(uv_poll_t *handle, int status, int events) {
+	dgram_t *d = static_cast<dgram_t *>(handle->data);
+	Isolate *iso = d->iso;
+	HandleScope scope(iso);
+	Context::Scope cs(iso->GetCurrentContext());
+	if (status < 0) {
+		Local<Value> err = Exception::Error(nx_str(iso, uv_strerror(status)));
+		dgram_fail_sends(d, err);
+		Local<Value> args[] = {err};
+		dgram_call(d, 1, args);
+		return;
+	}
+	if (events & UV_READABLE)
+		dgram_recv(d);
+	if ((events & UV_WRITABLE) && d->active)
+		dgram_flush(d);
+}
+
 void nx_udp_new(const FunctionCallbackInfo<Value> &info) {
 	Isolate *iso = info.GetIsolate();
 	Local<Context> context = iso->GetCurrentContext();
@@ -104,9 +235,16 @@ void nx_udp_new(const FunctionCallbackInfo<Value> &info) {
 	d->fd = fd;
 	d->callback.Reset(iso, info[2].As<Function>());
 	d->active = true;
+	Local<ArrayBuffer> arena = ArrayBuffer::New(iso, NX_UDP_ARENA_SIZE);
+	Local<ArrayBuffer> info_buffer =
+	    ArrayBuffer::New(iso, NX_UDP_BATCH * 3 * sizeof(uint32_t));
+	d->arena.Reset(iso, arena);
+	d->info.Reset(iso, Uint32Array::New(info_buffer, 0, NX_UDP_BATCH * 3));
+	d->arena_data = static_cast<uint8_t *>(arena->Data());
+	d->info_data = static_cast<uint32_t *>(info_buffer->Data());
 	uv_poll_init_socket(nx_ctx(iso)->loop, &d->poll, fd);
 	d->poll.data = d;
-	uv_poll_start(&d->poll, UV_READABLE, recv_cb);
+	uv_poll_start(&d->poll, UV_READABLE, dgram_poll_cb);
 	nx::Wrap<dgram_t>(iso, obj, d, [](dgram_t *p) {
 		if (p->active) {
 			uv_poll_stop(&p->poll);
@@ -114,94 +252,49 @@ void nx_udp_new(const FunctionCallbackInfo<Value> &info) {
 			p->active = false;
 		}
 		p->callback.Reset();
+		p->sends.clear();
 		// handle close is async; leak the struct under GC (rare).
 	});
 	info.GetReturnValue().Set(obj);
 }
 
-// One-shot sendto: a transient uv_poll_t for writability.
-struct sendto_t {
-	uv_poll_t poll;
-	Isolate *iso;
-	int fd;
-	Global<Function> callback;
-	Global<Value> buffer;
-	uint8_t *buf;
-	size_t buf_size;
-	struct sockaddr_in dest;
-};
-
-void sendto_finish(sendto_t *op, Local<Value> err, Local<Value> value) {
-	Isolate *iso = op->iso;
-	Local<Context> context = iso->GetCurrentContext();
-	Local<Function> cb = op->callback.Get(iso);
-	Local<Value> args[] = {err, value};
-	uv_poll_stop(&op->poll);
-	TryCatch try_catch(iso);
-	Local<Value> ret;
-	if (!cb->Call(context, Null(iso), 2, args).ToLocal(&ret)) {
-		nx_emit_error_event(iso, &try_catch);
-	}
-	op->callback.Reset();
-	op->buffer.Reset();
-	uv_close((uv_handle_t *)&op->poll,
-	         [](uv_handle_t *h) { delete static_cast<sendto_t *>(h->data); });
-}
-
-void sendto_cb(uv_poll_t *handle, int status, int events) {
-	sendto_t *op = static_cast<sendto_t *>(handle->data);
-	Isolate *iso = op->iso;
-	HandleScope scope(iso);
-	Context::Scope cs(iso->GetCurrentContext());
-	if (status < 0) {
-		sendto_finish(op, Exception::Error(nx_str(iso, uv_strerror(status))),
-		              Undefined(iso));
-		return;
-	}
-	ssize_t n = sendto(op->fd, op->buf, op->buf_size, 0,
-	                   (struct sockaddr *)&op->dest, sizeof(op->dest));
-	if (n < 0) {
-		if (errno == EAGAIN || errno == EWOULDBLOCK)
-			return;
-		sendto_finish(op, Exception::Error(nx_str(iso, strerror(errno))),
-		              Undefined(iso));
-		return;
-	}
-	sendto_finish(op, Undefined(iso), Integer::New(iso, (int)n));
-}
-
+// udpSend(cb, socket, data, info): queues the datagrams packed in `data`,
+// described by the (end offset, IPv4 address, port) triples of `info`. The
+// callback receives the number of bytes sent.
 void nx_udp_send(const FunctionCallbackInfo<Value> &info) {
 	Isolate *iso = info.GetIsolate();
-	Local<Context> context = iso->GetCurrentContext();
-	Local<Function> cb = info[0].As<Function>();
-	int fd = 0, port = 0;
+	dgram_t *d = get_dgram(info[1]);
 	size_t size = 0;
-	uint8_t *buf = NX_GetBufferSource(iso, &size, info[2]);
-	if (!buf || !info[1]->Int32Value(context).To(&fd) ||
-	    !info[4]->Int32Value(context).To(&port)) {
+	uint8_t *data = NX_GetBufferSource(iso, &size, info[2]);
+	if (!d || !data || !info[3]->IsUint32Array()) {
 		nx_throw(iso, "invalid input");
 		return;
 	}
-	String::Utf8Value ip(iso, info[3]);
-	struct sockaddr_in dest;
-	memset(&dest, 0, sizeof(dest));
-	dest.sin_family = AF_INET;
-	dest.sin_port = htons(port);
-	if (!*ip || inet_pton(AF_INET, *ip, &dest.sin_addr) <= 0) {
-		nx_throw(iso, "invalid IP address");
+	if (!d->active) {
+		nx_throw(iso, "Socket is closed");
 		return;
 	}
-	sendto_t *op = new sendto_t();
-	op->iso = iso;
-	op->fd = fd;
-	op->callback.Reset(iso, cb);
-	op->buffer.Reset(iso, info[2]);
-	op->buf = buf;
-	op->buf_size = size;
-	op->dest = dest;
-	uv_poll_init_socket(nx_ctx(iso)->loop, &op->poll, fd);
-	op->poll.data = op;
-	uv_poll_start(&op->poll, UV_WRITABLE, sendto_cb);
+	Local<Uint32Array> triples = info[3].As<Uint32Array>();
+	dgram_send_t op;
+	op.info.resize(triples->Length() / 3 * 3);
+	triples->CopyContents(op.info.data(), op.info.size() * sizeof(uint32_t));
+	uint32_t start = 0;
+	for (size_t i = 0; i < op.info.size(); i += 3) {
+		if (op.info[i] < start || op.info[i] > size || op.info[i + 2] > 65535) {
+			nx_throw(iso, "invalid input");
+			return;
+		}
+		start = op.info[i];
+	}
+	op.callback.Reset(iso, info[0].As<Function>());
+	op.buffer.Reset(iso, info[2]);
+	op.data = data;
+	op.next = 0;
+	op.offset = 0;
+	op.sent = 0;
+	d->sends.push_back(std::move(op));
+	if (d->sends.size() == 1)
+		uv_poll_start(&d->poll, UV_READABLE | UV_WRITABLE, dgram_poll_cb);
 }
 
 void nx_dgram_close(const FunctionCallbackInfo<Value> &info) {
@@ -213,6 +306,8 @@ void nx_dgram_close(const FunctionCallbackInfo<Value> &info) {
 	d->callback.Reset();
 	close(d->fd);
 	d->fd = -1;
+	dgram_fail_sends(
+	    d, Exception::Error(nx_str(info.GetIsolate(), "Socket is closed")));
 }
 
 void nx_dgram_get_fd(const FunctionCallbackInfo<Value> &info) {
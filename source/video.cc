@@ -7,9 +7,12 @@
 //
 // drawImage integration: nx_video_t embeds an nx_image_t as its FIRST member,
 // making a Video JS object directly drawable by canvas.cc (which unwraps any
-// wrapped object as nx_image_t — width/height/premul-BGRA `data` + the
-// SkImage cache slot). Each presented frame pointer-swaps into `image.data`
-// and drops the SkImage memo, exactly like the IR sensor's per-frame path.
+// wrapped object as nx_image_t). The image's `frame` is the presented,
+// refcounted decoder frame, which canvas.cc wraps in an SkImage without
+// copying; each presented frame pointer-swaps into `image.frame` and drops
+// the SkImage memo. canvas.cc also records the size the video is drawn at
+// (`image.drawn_width/height`), which each tick passes to the decoder as its
+// target size.
 #include "video.h"
 #include "async.h"
 #include "audio-graph.h"
@@ -50,9 +53,10 @@ void reset_media(nx_video_t *v) {
 		v->audio_node = nullptr;
 	}
 	nx_image_release_cache(&v->image);
-	free(v->image.data);
-	v->image.data = nullptr;
+	nx_media_frame_unref(v->image.frame);
+	v->image.frame = nullptr;
 	v->image.width = v->image.height = 0;
+	v->image.drawn_width = v->image.drawn_height = 0;
 }
 
 void close_video(nx_video_t *v) {
@@ -140,19 +144,17 @@ MaybeLocal<Value> video_load_after(Isolate *iso, nx_work_t *req) {
 	int width = nx_media_width(data->media);
 	int height = nx_media_height(data->media);
 	if (nx_media_has_video(data->media)) {
-		uint8_t *buf = (uint8_t *)nx_alloc(iso, (size_t)width * height * 4);
-		if (!buf) {
+		// Opaque black until the first frame presents.
+		nx_media_frame_t *frame = nx_media_frame_create(width, height);
+		if (!frame) {
 			nx_media_destroy(v->media);
 			v->media = nullptr;
+			nx_throw_oom(iso, (size_t)width * height * 4);
 			return MaybeLocal<Value>();
 		}
-		memset(buf, 0, (size_t)width * height * 4);
-		// Opaque black until the first frame presents.
-		for (size_t i = 3; i < (size_t)width * height * 4; i += 4)
-			buf[i] = 0xff;
 		v->image.width = (uint32_t)width;
 		v->image.height = (uint32_t)height;
-		v->image.data = buf;
+		v->image.frame = frame; // `data` stays NULL: canvas.cc uses `frame`
 	}
 	Local<Object> result = Object::New(iso);
 	result->Set(context, nx_str(iso, "width"), Integer::New(iso, width))
@@ -244,9 +246,17 @@ void nx_video_set_loop(const FunctionCallbackInfo<Value> &info) {
 void nx_video_tick(const FunctionCallbackInfo<Value> &info) {
 	Isolate *iso = info.GetIsolate();
 	nx_video_t *v = get_video(iso, info[0]);
-	if (!v || !v->media || !v->image.data)
+	if (!v || !v->media || !v->image.frame)
 		return;
-	if (nx_media_present(v->media, &v->image.data)) {
+	nx_media_set_yuv_output(v->media, nx_canvas_wants_yuv_frames());
+	// Decode at the size the video was drawn at since the last tick (kept
+	// as is while it is not drawn).
+	if (v->image.drawn_width && v->image.drawn_height) {
+		nx_media_set_target_size(v->media, (int)v->image.drawn_width,
+		                         (int)v->image.drawn_height);
+		v->image.drawn_width = v->image.drawn_height = 0;
+	}
+	if (nx_media_present(v->media, &v->image.frame)) {
 		nx_image_release_cache(&v->image);
 		info.GetReturnValue().Set(true);
 	} else {